@@ -0,0 +1,91 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 流式 JSON 输出：直接写入调用方提供的缓冲区 (通常在栈上)，缓冲区满时交给 flush 回调
+// (如 httpd_resp_send_chunk) 后继续，不分配内存。逗号由写入器自动处理，字符串按 RFC 8259 转义。
+// 任何一步出错 (缓冲区不够且没有 flush、flush 失败、嵌套过深) 后续写入都被忽略，
+// 由 json_writer_finish() 统一返回结果。不依赖 ESP-IDF，可以在主机上编译
+
+#define JSON_WRITER_MAX_DEPTH   32
+
+/**
+ * @brief 输出回调
+ *
+ * @param ctx 初始化时传入的上下文
+ * @param data 待输出的数据
+ * @param len 数据长度
+ * @return 0 表示成功，其他值表示失败 (之后的写入都被忽略)
+ */
+typedef int (*json_writer_flush_t)(void *ctx, const char *data, size_t len);
+
+typedef struct {
+    char *buf;
+    size_t size;
+    size_t len;                 // 缓冲区中尚未输出的字节数
+    size_t total;               // 已生成的总字节数
+    json_writer_flush_t flush;  // 为 NULL 时整个文档必须放得下缓冲区
+    void *ctx;
+    uint32_t has_items;         // 每层嵌套一位：该层已经有成员 (下一个成员前需要逗号)
+    uint8_t depth;
+    bool error;
+} json_writer_t;
+
+/**
+ * @brief 初始化写入器
+ *
+ * @param w 写入器
+ * @param buf 输出缓冲区
+ * @param size 缓冲区大小
+ * @param flush 缓冲区满时的输出回调，为 NULL 时只写入缓冲区 (结果以 '\0' 结尾)
+ * @param ctx 回调上下文
+ */
+void json_writer_init(json_writer_t *w, char *buf, size_t size, json_writer_flush_t flush, void *ctx);
+
+/**
+ * @brief 结束输出：检查嵌套是否闭合，有 flush 回调时输出剩余内容
+ *
+ * @return true 表示完整生成了文档
+ */
+bool json_writer_finish(json_writer_t *w);
+
+// 以下函数的 key 在对象中为成员名，在数组中或顶层时传 NULL
+
+void json_writer_begin_object(json_writer_t *w, const char *key);
+void json_writer_end_object(json_writer_t *w);
+void json_writer_begin_array(json_writer_t *w, const char *key);
+void json_writer_end_array(json_writer_t *w);
+
+void json_writer_string(json_writer_t *w, const char *key, const char *value);     // value 为 NULL 时输出 null
+void json_writer_string_len(json_writer_t *w, const char *key, const char *value, size_t len);
+void json_writer_int(json_writer_t *w, const char *key, int64_t value);
+void json_writer_uint(json_writer_t *w, const char *key, uint64_t value);
+void json_writer_bool(json_writer_t *w, const char *key, bool value);
+void json_writer_null(json_writer_t *w, const char *key);
+
+/**
+ * @brief 原样输出已经编码好的 JSON (不检查、不转义)
+ *
+ * 用于插入预先编码并保存的片段。在数组中 data 可以是以逗号分隔的多个值。
+ */
+void json_writer_raw(json_writer_t *w, const char *key, const char *data, size_t len);
+
+/**
+ * @brief 输出定点小数 (不使用 printf 的浮点格式化)，末尾的 0 省略，非有限值输出 null
+ *
+ * @param decimals 小数位数 (0~6)
+ */
+void json_writer_double(json_writer_t *w, const char *key, double value, int decimals);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // JSON_WRITER_H
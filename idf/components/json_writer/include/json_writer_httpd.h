@@ -0,0 +1,37 @@
+#ifndef JSON_WRITER_HTTPD_H
+#define JSON_WRITER_HTTPD_H
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include "json_writer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 开始一个 JSON 响应 (设置 Content-Type 为 application/json)
+ *
+ * 文档放得下 buf 时在结束时一次发送 (带 Content-Length)，否则缓冲区每满一次发送一个 chunk。
+ *
+ * @param w 写入器
+ * @param req HTTP 请求
+ * @param buf 缓冲区 (通常在处理函数的栈上，512 字节左右即可)
+ * @param size 缓冲区大小
+ */
+void json_writer_httpd_begin(json_writer_t *w, httpd_req_t *req, char *buf, size_t size);
+
+/**
+ * @brief 结束响应：发送剩余内容
+ *
+ * 生成失败且还没有发送任何内容时回复 500。
+ *
+ * @return ESP_OK 成功，ESP_FAIL 生成或发送失败
+ */
+esp_err_t json_writer_httpd_end(json_writer_t *w);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // JSON_WRITER_HTTPD_H
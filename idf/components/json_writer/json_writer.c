@@ -0,0 +1,284 @@
+#include "json_writer.h"
+#include <math.h>
+#include <string.h>
+
+static void put(json_writer_t *w, const char *data, size_t len)
+{
+    if (w->error || len == 0) {
+        return;
+    }
+    w->total += len;
+
+    while (len > 0) {
+        size_t room = w->size - w->len;
+        if (w->flush == NULL) {
+            room = room > 0 ? room - 1 : 0;     // 留一个字节给结尾的 '\0'
+        }
+        if (room == 0) {
+            if (w->flush == NULL || w->flush(w->ctx, w->buf, w->len) != 0) {
+                w->error = true;
+                return;
+            }
+            w->len = 0;
+            continue;
+        }
+        size_t n = len < room ? len : room;
+        memcpy(w->buf + w->len, data, n);
+        w->len += n;
+        data += n;
+        len -= n;
+    }
+}
+
+static inline void put_char(json_writer_t *w, char c)
+{
+    // 缓冲区有空位时直接写入 (最常见的情况)
+    if (!w->error && w->len + 1 < w->size) {
+        w->buf[w->len++] = c;
+        w->total++;
+        return;
+    }
+    put(w, &c, 1);
+}
+
+// 转义并输出字符串内容 (不含引号)：连续的普通字符一次复制
+static void put_escaped(json_writer_t *w, const char *s, size_t len)
+{
+    static const char hex[] = "0123456789abcdef";
+    size_t run = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        uint8_t c = (uint8_t)s[i];
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+
+        put(w, s + run, i - run);
+        run = i + 1;
+
+        char esc[6] = { '\\', 0 };
+        size_t n = 2;
+        switch (c) {
+            case '"':  esc[1] = '"'; break;
+            case '\\': esc[1] = '\\'; break;
+            case '\b': esc[1] = 'b'; break;
+            case '\f': esc[1] = 'f'; break;
+            case '\n': esc[1] = 'n'; break;
+            case '\r': esc[1] = 'r'; break;
+            case '\t': esc[1] = 't'; break;
+            default:
+                esc[1] = 'u';
+                esc[2] = '0';
+                esc[3] = '0';
+                esc[4] = hex[c >> 4];
+                esc[5] = hex[c & 0xF];
+                n = 6;
+                break;
+        }
+        put(w, esc, n);
+    }
+    put(w, s + run, len - run);
+}
+
+// 成员开头：必要时加逗号，在对象中输出 "key":
+static void begin_value(json_writer_t *w, const char *key)
+{
+    uint32_t bit = 1u << (w->depth & 31);
+    if (w->depth > 0) {
+        if (w->has_items & bit) {
+            put_char(w, ',');
+        }
+        w->has_items |= bit;
+    }
+    if (key != NULL) {
+        put_char(w, '"');
+        put_escaped(w, key, strlen(key));
+        put(w, "\":", 2);
+    }
+}
+
+void json_writer_init(json_writer_t *w, char *buf, size_t size, json_writer_flush_t flush, void *ctx)
+{
+    memset(w, 0, sizeof(*w));
+    w->buf = buf;
+    w->size = size;
+    w->flush = flush;
+    w->ctx = ctx;
+    w->error = (buf == NULL || size < 2);
+}
+
+bool json_writer_finish(json_writer_t *w)
+{
+    if (w->depth != 0) {
+        w->error = true;
+    }
+    if (!w->error) {
+        if (w->flush != NULL) {
+            if (w->len > 0 && w->flush(w->ctx, w->buf, w->len) != 0) {
+                w->error = true;
+            }
+            w->len = 0;
+        } else {
+            w->buf[w->len] = '\0';
+        }
+    }
+    return !w->error;
+}
+
+static void begin_container(json_writer_t *w, const char *key, char open)
+{
+    begin_value(w, key);
+    if (w->depth + 1 >= JSON_WRITER_MAX_DEPTH) {
+        w->error = true;
+        return;
+    }
+    w->depth++;
+    w->has_items &= ~(1u << w->depth);
+    put_char(w, open);
+}
+
+static void end_container(json_writer_t *w, char close)
+{
+    if (w->depth == 0) {
+        w->error = true;
+        return;
+    }
+    w->depth--;
+    put_char(w, close);
+}
+
+void json_writer_begin_object(json_writer_t *w, const char *key)
+{
+    begin_container(w, key, '{');
+}
+
+void json_writer_end_object(json_writer_t *w)
+{
+    end_container(w, '}');
+}
+
+void json_writer_begin_array(json_writer_t *w, const char *key)
+{
+    begin_container(w, key, '[');
+}
+
+void json_writer_end_array(json_writer_t *w)
+{
+    end_container(w, ']');
+}
+
+void json_writer_string_len(json_writer_t *w, const char *key, const char *value, size_t len)
+{
+    begin_value(w, key);
+    put_char(w, '"');
+    put_escaped(w, value, len);
+    put_char(w, '"');
+}
+
+void json_writer_string(json_writer_t *w, const char *key, const char *value)
+{
+    if (value == NULL) {
+        json_writer_null(w, key);
+        return;
+    }
+    json_writer_string_len(w, key, value, strlen(value));
+}
+
+void json_writer_raw(json_writer_t *w, const char *key, const char *data, size_t len)
+{
+    begin_value(w, key);
+    put(w, data, len);
+}
+
+// 无符号整数转十进制，返回起始位置 (从 end 向前写)
+static char *format_u64(char *end, uint64_t v)
+{
+    char *p = end;
+    do {
+        *--p = (char)('0' + v % 10);
+        v /= 10;
+    } while (v != 0);
+    return p;
+}
+
+void json_writer_uint(json_writer_t *w, const char *key, uint64_t value)
+{
+    char tmp[20];
+    char *p = format_u64(tmp + sizeof(tmp), value);
+    begin_value(w, key);
+    put(w, p, tmp + sizeof(tmp) - p);
+}
+
+void json_writer_int(json_writer_t *w, const char *key, int64_t value)
+{
+    char tmp[21];
+    uint64_t mag = value < 0 ? (uint64_t)0 - (uint64_t)value : (uint64_t)value;
+    char *p = format_u64(tmp + sizeof(tmp), mag);
+    if (value < 0) {
+        *--p = '-';
+    }
+    begin_value(w, key);
+    put(w, p, tmp + sizeof(tmp) - p);
+}
+
+void json_writer_bool(json_writer_t *w, const char *key, bool value)
+{
+    begin_value(w, key);
+    if (value) {
+        put(w, "true", 4);
+    } else {
+        put(w, "false", 5);
+    }
+}
+
+void json_writer_null(json_writer_t *w, const char *key)
+{
+    begin_value(w, key);
+    put(w, "null", 4);
+}
+
+void json_writer_double(json_writer_t *w, const char *key, double value, int decimals)
+{
+    static const uint32_t scales[] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+
+    // 超出 int64 定点范围的值 (状态接口中不会出现) 也按 null 处理，保证输出合法
+    if (decimals < 0) {
+        decimals = 0;
+    } else if (decimals > 6) {
+        decimals = 6;
+    }
+    double scaled = value * scales[decimals];
+    if (!isfinite(value) || fabs(scaled) >= 9.0e18) {
+        json_writer_null(w, key);
+        return;
+    }
+
+    int64_t fixed = llround(scaled);
+    uint64_t mag = fixed < 0 ? (uint64_t)0 - (uint64_t)fixed : (uint64_t)fixed;
+    uint64_t ipart = mag / scales[decimals];
+    uint32_t frac = (uint32_t)(mag % scales[decimals]);
+
+    // 去掉小数末尾的 0
+    int digits = decimals;
+    while (digits > 0 && frac % 10 == 0) {
+        frac /= 10;
+        digits--;
+    }
+
+    char tmp[32];
+    char *end = tmp + sizeof(tmp);
+    char *p = end;
+    if (digits > 0) {
+        for (int i = 0; i < digits; i++) {
+            *--p = (char)('0' + frac % 10);
+            frac /= 10;
+        }
+        *--p = '.';
+    }
+    p = format_u64(p, ipart);
+    if (fixed < 0) {
+        *--p = '-';
+    }
+    begin_value(w, key);
+    put(w, p, end - p);
+}
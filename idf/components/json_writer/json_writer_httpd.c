@@ -0,0 +1,38 @@
+#include "json_writer_httpd.h"
+#include "esp_log.h"
+
+static const char *TAG = "JSON_WRITER";
+
+// 缓冲区满: 以 chunk 形式发送 (之后整个响应都使用分块编码)
+static int httpd_flush(void *ctx, const char *data, size_t len)
+{
+    return httpd_resp_send_chunk((httpd_req_t *)ctx, data, len) == ESP_OK ? 0 : -1;
+}
+
+void json_writer_httpd_begin(json_writer_t *w, httpd_req_t *req, char *buf, size_t size)
+{
+    httpd_resp_set_type(req, "application/json");
+    json_writer_init(w, buf, size, httpd_flush, req);
+}
+
+esp_err_t json_writer_httpd_end(json_writer_t *w)
+{
+    httpd_req_t *req = (httpd_req_t *)w->ctx;
+    bool chunked = w->total > w->len;   // 已经发送过 chunk
+
+    if (!chunked && !w->error && w->depth == 0) {
+        // 整个文档都在缓冲区中: 一次发送
+        esp_err_t ret = httpd_resp_send(req, w->buf, w->len);
+        w->len = 0;
+        return ret;
+    }
+
+    if (!json_writer_finish(w)) {
+        ESP_LOGE(TAG, "JSON响应生成失败 (已生成 %u 字节)", (unsigned)w->total);
+        if (!chunked) {
+            httpd_resp_send_500(req);
+        }
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
@@ -0,0 +1,22 @@
+#!/bin/bash
+
+# 下载 cJSON 源码到 tools/cJSON，供 json_writer_bench.c 的主机编译使用 (没有 ESP-IDF 时)
+# 用法: tools/fetch_cjson.sh [版本标签]
+
+set -e
+
+CJSON_VERSION="${1:-v1.7.18}"
+CJSON_URL="https://raw.githubusercontent.com/DaveGamble/cJSON/${CJSON_VERSION}"
+DEST_DIR="$(cd "$(dirname "$0")" && pwd)/cJSON"
+
+mkdir -p "$DEST_DIR"
+for f in cJSON.c cJSON.h LICENSE; do
+    if ! curl -fsSL -o "$DEST_DIR/$f" "$CJSON_URL/$f"; then
+        rm -f "$DEST_DIR/$f"
+        echo "❌ 下载失败: $CJSON_URL/$f" >&2
+        echo "可以改用 ESP-IDF 自带的源码: -I\$IDF_PATH/components/json/cJSON" >&2
+        exit 1
+    fi
+done
+
+echo "✅ cJSON ${CJSON_VERSION} -> $DEST_DIR"
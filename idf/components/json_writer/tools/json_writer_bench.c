@@ -0,0 +1,430 @@
+/*
+ * 流式 JSON 写入器主机基准 (Linux / macOS)
+ *
+ * 生成与 ai_assistant 的 /api/status 结构相同的状态文档 (约 80 个字段、嵌套对象和数组)，比较:
+ * - json_writer: 512 字节缓冲区，满了交给输出回调 (模拟 httpd_resp_send_chunk)
+ * - cJSON: 建树 + cJSON_Print / cJSON_PrintUnformatted + 释放 (各项目原来的写法)
+ * 报告每次响应的分配次数、分配字节数、峰值占用、耗时和输出大小。
+ * 另外检查转义、数字格式、嵌套和缓冲区不足的处理。
+ *
+ * 编译和运行 (cJSON 使用 ESP-IDF 自带的源码，或者 tools/fetch_cjson.sh 下载的固定版本):
+ *     CJSON=$IDF_PATH/components/json/cJSON       # 或 tools/fetch_cjson.sh && CJSON=tools/cJSON
+ *     cc -O2 -Iinclude -DJSON_BENCH_CJSON -I$CJSON \
+ *        -o json_bench tools/json_writer_bench.c json_writer.c $CJSON/cJSON.c -lm
+ *     ./json_bench             # 基准
+ *     ./json_bench --dump      # 输出 json_writer 生成的文档 (可以用 python3 -m json.tool 检查)
+ * 不定义 JSON_BENCH_CJSON 时只测试 json_writer。
+ */
+
+#include "json_writer.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef JSON_BENCH_CJSON
+#include "cJSON.h"
+#endif
+
+#define ITERATIONS  20000
+
+// 状态文档中的数据 (与设备上的统计结构对应)
+typedef struct {
+    const char *name;
+    uint32_t messages, depth_max;
+    double wait_avg_ms, wait_max_ms;
+} queue_stats_t;
+
+static const queue_stats_t queues[] = {
+    { "chat", 1834, 3, 0.412, 12.5 },
+    { "stream", 271, 2, 0.238, 4.75 },
+    { "ws_out", 9402, 7, 1.107, 38.2 },
+};
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// 模拟 httpd_resp_send_chunk: 只统计
+static size_t chunk_bytes = 0;
+static unsigned chunk_count = 0;
+
+static int count_flush(void *ctx, const char *data, size_t len)
+{
+    (void)ctx;
+    (void)data;
+    chunk_bytes += len;
+    chunk_count++;
+    return 0;
+}
+
+static void write_status(json_writer_t *w)
+{
+    json_writer_begin_object(w, NULL);
+    json_writer_string(w, "status", "running");
+    json_writer_string(w, "ai_name", "小智");
+    json_writer_string(w, "version", "1.0.0");
+    json_writer_bool(w, "voice_enabled", true);
+    json_writer_bool(w, "web_enabled", true);
+
+    json_writer_begin_object(w, "llm");
+    json_writer_bool(w, "configured", true);
+    json_writer_uint(w, "requests", 1523);
+    json_writer_uint(w, "errors", 12);
+    json_writer_uint(w, "timeouts", 3);
+    json_writer_uint(w, "connects", 41);
+    json_writer_uint(w, "ttft_ms", 412);
+    json_writer_uint(w, "ttft_avg_ms", 538);
+    json_writer_uint(w, "total_ms", 2210);
+    json_writer_uint(w, "tokens", 87);
+    json_writer_end_object(w);
+
+    json_writer_begin_object(w, "cache");
+    json_writer_uint(w, "entries", 37);
+    json_writer_uint(w, "bytes", 9211);
+    json_writer_uint(w, "budget_bytes", 16384);
+    json_writer_uint(w, "lookups", 1611);
+    json_writer_uint(w, "hits", 402);
+    json_writer_double(w, "hit_ratio", 402.0 / 1611, 3);
+    json_writer_uint(w, "stores", 1108);
+    json_writer_uint(w, "evictions", 301);
+    json_writer_uint(w, "expired", 770);
+    json_writer_uint(w, "saved_ms", 215034);
+    json_writer_double(w, "saved_avg_ms", 215034.0 / 402, 1);
+    json_writer_end_object(w);
+
+    json_writer_begin_object(w, "classifier");
+    json_writer_uint(w, "runs", 640);
+    json_writer_uint(w, "accepted", 212);
+    json_writer_uint(w, "rejected", 98);
+    json_writer_uint(w, "min_confidence", 50);
+    json_writer_uint(w, "avg_us", 41);
+    json_writer_uint(w, "max_us", 190);
+    json_writer_end_object(w);
+
+    json_writer_begin_object(w, "ws");
+    json_writer_uint(w, "clients", 2);
+    json_writer_uint(w, "messages", 9402);
+    json_writer_uint(w, "frames", 9390);
+    json_writer_uint(w, "dropped", 12);
+    json_writer_uint(w, "send_errors", 0);
+    json_writer_double(w, "queue_avg_ms", 1.107, 3);
+    json_writer_double(w, "queue_max_ms", 38.204, 3);
+    json_writer_uint(w, "acks", 9301);
+    json_writer_double(w, "ack_avg_ms", 23.5, 3);
+    json_writer_double(w, "ack_max_ms", 180.02, 3);
+    json_writer_double(w, "ack_last_ms", 19.9, 3);
+    json_writer_end_object(w);
+
+    json_writer_begin_object(w, "pipeline");
+    json_writer_uint(w, "pool_size", 8);
+    json_writer_uint(w, "in_use", 1);
+    json_writer_uint(w, "in_use_max", 5);
+    json_writer_uint(w, "alloc_failures", 0);
+    json_writer_uint(w, "completed", 2105);
+    json_writer_double(w, "total_avg_ms", 612.4, 3);
+    json_writer_double(w, "total_max_ms", 5120.75, 3);
+    json_writer_begin_array(w, "queues");
+    for (size_t i = 0; i < sizeof(queues) / sizeof(queues[0]); i++) {
+        json_writer_begin_object(w, NULL);
+        json_writer_string(w, "name", queues[i].name);
+        json_writer_uint(w, "messages", queues[i].messages);
+        json_writer_uint(w, "depth_max", queues[i].depth_max);
+        json_writer_double(w, "wait_avg_ms", queues[i].wait_avg_ms, 3);
+        json_writer_double(w, "wait_max_ms", queues[i].wait_max_ms, 3);
+        json_writer_end_object(w);
+    }
+    json_writer_end_array(w);
+    json_writer_end_object(w);
+
+    json_writer_end_object(w);
+}
+
+#ifdef JSON_BENCH_CJSON
+// 分配统计 (通过 cJSON_InitHooks 接入)
+static size_t alloc_count = 0;
+static size_t alloc_bytes = 0;
+static size_t live_bytes = 0;
+static size_t peak_bytes = 0;
+
+static void *count_malloc(size_t size)
+{
+    size_t *p = malloc(size + sizeof(size_t));
+    if (p == NULL) {
+        return NULL;
+    }
+    *p = size;
+    alloc_count++;
+    alloc_bytes += size;
+    live_bytes += size;
+    if (live_bytes > peak_bytes) {
+        peak_bytes = live_bytes;
+    }
+    return p + 1;
+}
+
+static void count_free(void *ptr)
+{
+    if (ptr != NULL) {
+        size_t *p = (size_t *)ptr - 1;
+        live_bytes -= *p;
+        free(p);
+    }
+}
+
+static char *cjson_status(bool formatted)
+{
+    cJSON *response = cJSON_CreateObject();
+    cJSON_AddStringToObject(response, "status", "running");
+    cJSON_AddStringToObject(response, "ai_name", "小智");
+    cJSON_AddStringToObject(response, "version", "1.0.0");
+    cJSON_AddBoolToObject(response, "voice_enabled", true);
+    cJSON_AddBoolToObject(response, "web_enabled", true);
+
+    cJSON *llm = cJSON_AddObjectToObject(response, "llm");
+    cJSON_AddBoolToObject(llm, "configured", true);
+    cJSON_AddNumberToObject(llm, "requests", 1523);
+    cJSON_AddNumberToObject(llm, "errors", 12);
+    cJSON_AddNumberToObject(llm, "timeouts", 3);
+    cJSON_AddNumberToObject(llm, "connects", 41);
+    cJSON_AddNumberToObject(llm, "ttft_ms", 412);
+    cJSON_AddNumberToObject(llm, "ttft_avg_ms", 538);
+    cJSON_AddNumberToObject(llm, "total_ms", 2210);
+    cJSON_AddNumberToObject(llm, "tokens", 87);
+
+    cJSON *cache = cJSON_AddObjectToObject(response, "cache");
+    cJSON_AddNumberToObject(cache, "entries", 37);
+    cJSON_AddNumberToObject(cache, "bytes", 9211);
+    cJSON_AddNumberToObject(cache, "budget_bytes", 16384);
+    cJSON_AddNumberToObject(cache, "lookups", 1611);
+    cJSON_AddNumberToObject(cache, "hits", 402);
+    cJSON_AddNumberToObject(cache, "hit_ratio", 402.0 / 1611);
+    cJSON_AddNumberToObject(cache, "stores", 1108);
+    cJSON_AddNumberToObject(cache, "evictions", 301);
+    cJSON_AddNumberToObject(cache, "expired", 770);
+    cJSON_AddNumberToObject(cache, "saved_ms", 215034);
+    cJSON_AddNumberToObject(cache, "saved_avg_ms", 215034.0 / 402);
+
+    cJSON *classifier = cJSON_AddObjectToObject(response, "classifier");
+    cJSON_AddNumberToObject(classifier, "runs", 640);
+    cJSON_AddNumberToObject(classifier, "accepted", 212);
+    cJSON_AddNumberToObject(classifier, "rejected", 98);
+    cJSON_AddNumberToObject(classifier, "min_confidence", 50);
+    cJSON_AddNumberToObject(classifier, "avg_us", 41);
+    cJSON_AddNumberToObject(classifier, "max_us", 190);
+
+    cJSON *ws = cJSON_AddObjectToObject(response, "ws");
+    cJSON_AddNumberToObject(ws, "clients", 2);
+    cJSON_AddNumberToObject(ws, "messages", 9402);
+    cJSON_AddNumberToObject(ws, "frames", 9390);
+    cJSON_AddNumberToObject(ws, "dropped", 12);
+    cJSON_AddNumberToObject(ws, "send_errors", 0);
+    cJSON_AddNumberToObject(ws, "queue_avg_ms", 1.107);
+    cJSON_AddNumberToObject(ws, "queue_max_ms", 38.204);
+    cJSON_AddNumberToObject(ws, "acks", 9301);
+    cJSON_AddNumberToObject(ws, "ack_avg_ms", 23.5);
+    cJSON_AddNumberToObject(ws, "ack_max_ms", 180.02);
+    cJSON_AddNumberToObject(ws, "ack_last_ms", 19.9);
+
+    cJSON *pipeline = cJSON_AddObjectToObject(response, "pipeline");
+    cJSON_AddNumberToObject(pipeline, "pool_size", 8);
+    cJSON_AddNumberToObject(pipeline, "in_use", 1);
+    cJSON_AddNumberToObject(pipeline, "in_use_max", 5);
+    cJSON_AddNumberToObject(pipeline, "alloc_failures", 0);
+    cJSON_AddNumberToObject(pipeline, "completed", 2105);
+    cJSON_AddNumberToObject(pipeline, "total_avg_ms", 612.4);
+    cJSON_AddNumberToObject(pipeline, "total_max_ms", 5120.75);
+    cJSON *array = cJSON_AddArrayToObject(pipeline, "queues");
+    for (size_t i = 0; i < sizeof(queues) / sizeof(queues[0]); i++) {
+        cJSON *queue = cJSON_CreateObject();
+        cJSON_AddStringToObject(queue, "name", queues[i].name);
+        cJSON_AddNumberToObject(queue, "messages", queues[i].messages);
+        cJSON_AddNumberToObject(queue, "depth_max", queues[i].depth_max);
+        cJSON_AddNumberToObject(queue, "wait_avg_ms", queues[i].wait_avg_ms);
+        cJSON_AddNumberToObject(queue, "wait_max_ms", queues[i].wait_max_ms);
+        cJSON_AddItemToArray(array, queue);
+    }
+
+    char *out = formatted ? cJSON_Print(response) : cJSON_PrintUnformatted(response);
+    cJSON_Delete(response);
+    return out;
+}
+
+static void bench_cjson(bool formatted)
+{
+    cJSON_Hooks hooks = { count_malloc, count_free };
+    cJSON_InitHooks(&hooks);
+
+    alloc_count = alloc_bytes = peak_bytes = 0;
+    size_t out_len = 0;
+    double start = now_us();
+    for (int i = 0; i < ITERATIONS; i++) {
+        char *out = cjson_status(formatted);
+        out_len = strlen(out);     // 发送
+        count_free(out);
+    }
+    double us = (now_us() - start) / ITERATIONS;
+    printf("  %-26s %6.2f us  %5zu 次分配  %6zu 字节分配  峰值 %5zu 字节  输出 %zu 字节\n",
+           formatted ? "cJSON_Print" : "cJSON_PrintUnformatted", us,
+           alloc_count / ITERATIONS, alloc_bytes / ITERATIONS, peak_bytes, out_len);
+    cJSON_InitHooks(NULL);
+}
+#endif
+
+static void bench_writer(size_t buf_size)
+{
+    char buf[4096];
+    json_writer_t w;
+    chunk_bytes = 0;
+    chunk_count = 0;
+
+    double start = now_us();
+    for (int i = 0; i < ITERATIONS; i++) {
+        json_writer_init(&w, buf, buf_size, count_flush, NULL);
+        write_status(&w);
+        if (!json_writer_finish(&w)) {
+            fprintf(stderr, "json_writer 失败\n");
+            exit(1);
+        }
+    }
+    double us = (now_us() - start) / ITERATIONS;
+    printf("  json_writer (%4zu 字节缓冲) %6.2f us      0 次分配       0 字节分配  栈上 %4zu 字节  输出 %zu 字节 (%u 块)\n",
+           buf_size, us, buf_size, w.total, chunk_count / ITERATIONS);
+}
+
+// 写入器生成一段文档到固定缓冲区，返回是否成功
+typedef void (*build_fn)(json_writer_t *w);
+
+static bool build_into(char *buf, size_t size, build_fn fn)
+{
+    json_writer_t w;
+    json_writer_init(&w, buf, size, NULL, NULL);
+    fn(&w);
+    return json_writer_finish(&w);
+}
+
+static void build_escapes(json_writer_t *w)
+{
+    json_writer_begin_object(w, NULL);
+    json_writer_string(w, "q\"k", "a\"b\\c/d");
+    json_writer_string(w, "ctl", "\b\f\n\r\t\x01\x1f");
+    json_writer_string(w, "utf8", "你好 é");
+    json_writer_string_len(w, "nul", "a\0b", 3);
+    json_writer_string(w, "none", NULL);
+    json_writer_end_object(w);
+}
+
+static void build_numbers(json_writer_t *w)
+{
+    json_writer_begin_array(w, NULL);
+    json_writer_int(w, NULL, 0);
+    json_writer_int(w, NULL, -42);
+    json_writer_int(w, NULL, INT64_MIN);
+    json_writer_uint(w, NULL, UINT64_MAX);
+    json_writer_double(w, NULL, 0.2496, 3);
+    json_writer_double(w, NULL, -1.5, 3);
+    json_writer_double(w, NULL, 12.0, 3);
+    json_writer_double(w, NULL, -0.0004, 3);
+    json_writer_double(w, NULL, 1.0 / 0.0, 3);
+    json_writer_bool(w, NULL, false);
+    json_writer_null(w, NULL);
+    json_writer_end_array(w);
+}
+
+static void build_nested(json_writer_t *w)
+{
+    json_writer_begin_object(w, NULL);
+    json_writer_begin_array(w, "a");
+    json_writer_begin_array(w, NULL);
+    json_writer_end_array(w);
+    json_writer_begin_object(w, NULL);
+    json_writer_end_object(w);
+    json_writer_uint(w, NULL, 1);
+    json_writer_end_array(w);
+    json_writer_begin_object(w, "o");
+    json_writer_uint(w, "x", 1);
+    json_writer_end_object(w);
+    json_writer_end_object(w);
+}
+
+static void build_unclosed(json_writer_t *w)
+{
+    json_writer_begin_object(w, NULL);
+    json_writer_begin_array(w, "a");
+    json_writer_end_array(w);
+}
+
+// 分块输出收集到 append_out
+static char append_out[4096];
+static size_t append_len = 0;
+
+static int append(void *ctx, const char *data, size_t len)
+{
+    memcpy((char *)ctx + append_len, data, len);
+    append_len += len;
+    return 0;
+}
+
+static void self_test(void)
+{
+    char buf[256];
+
+    assert(build_into(buf, sizeof(buf), build_escapes));
+    assert(strcmp(buf, "{\"q\\\"k\":\"a\\\"b\\\\c/d\",\"ctl\":\"\\b\\f\\n\\r\\t\\u0001\\u001f\","
+                       "\"utf8\":\"你好 é\",\"nul\":\"a\\u0000b\",\"none\":null}") == 0);
+
+    assert(build_into(buf, sizeof(buf), build_numbers));
+    assert(strcmp(buf, "[0,-42,-9223372036854775808,18446744073709551615,0.25,-1.5,12,0,null,false,null]") == 0);
+
+    assert(build_into(buf, sizeof(buf), build_nested));
+    assert(strcmp(buf, "{\"a\":[[],{},1],\"o\":{\"x\":1}}") == 0);
+
+    assert(!build_into(buf, sizeof(buf), build_unclosed));
+    assert(!build_into(buf, 16, build_escapes));        // 缓冲区不够且没有输出回调
+
+    // 最小缓冲区 (每次输出 2 字节) 分块的结果与一次生成的相同
+    char full[4096];
+    json_writer_t w;
+    json_writer_init(&w, full, sizeof(full), NULL, NULL);
+    write_status(&w);
+    assert(json_writer_finish(&w));
+
+    char tiny[2];
+    append_len = 0;
+    json_writer_init(&w, tiny, sizeof(tiny), append, append_out);
+    write_status(&w);
+    assert(json_writer_finish(&w));
+    assert(append_len == strlen(full) && memcmp(append_out, full, append_len) == 0);
+    printf("自检通过: 转义、数字、嵌套、未闭合、缓冲区不足和分块输出\n");
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1 && strcmp(argv[1], "--dump") == 0) {
+        char buf[4096];
+        json_writer_t w;
+        json_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+        write_status(&w);
+        if (!json_writer_finish(&w)) {
+            return 1;
+        }
+        puts(buf);
+        return 0;
+    }
+
+    self_test();
+    printf("状态文档, 每次响应 (%d 次平均):\n", ITERATIONS);
+    bench_writer(512);
+    bench_writer(2048);
+#ifdef JSON_BENCH_CJSON
+    bench_cjson(true);
+    bench_cjson(false);
+#else
+    printf("  (未定义 JSON_BENCH_CJSON，跳过 cJSON 对比)\n");
+#endif
+    return 0;
+}
@@ -0,0 +1,194 @@
+#ifndef LED_COLOR_H
+#define LED_COLOR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// LED 颜色运算：整数 HSV→RGB、正弦/余弦查表、伽马校正、8 位缩放和混合、调色板插值。
+// 全部为整数运算 (表在 flash 中)，不调用 sinf/powf/fmod，适合每帧逐像素调用。
+// 不依赖 ESP-IDF，可以在主机上编译
+
+// 伽马校正表使用的指数 (与 Adafruit NeoPixel 的 gamma8 相同)
+#define LED_COLOR_GAMMA     2.8
+
+typedef struct {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+} led_rgb_t;
+
+// ---- 8 位运算 ----
+
+/**
+ * @brief x / 255 四舍五入 (x 不超过 255 × 255)，用移位代替除法
+ */
+static inline uint8_t led_color_div255(uint32_t x)
+{
+    x += 128;
+    return (uint8_t)((x + (x >> 8)) >> 8);
+}
+
+/**
+ * @brief 按比例缩放：v * scale / 255 (四舍五入)，scale 为 255 时不变、为 0 时为 0
+ */
+static inline uint8_t led_color_scale8(uint8_t v, uint8_t scale)
+{
+    return led_color_div255((uint32_t)v * scale);
+}
+
+/**
+ * @brief 两个值之间插值：amount 为 0 时为 a，255 时为 b
+ */
+static inline uint8_t led_color_blend8(uint8_t a, uint8_t b, uint8_t amount)
+{
+    return led_color_div255((uint32_t)a * (255 - amount) + (uint32_t)b * amount);
+}
+
+/**
+ * @brief 饱和加法和减法 (结果限制在 0-255)
+ */
+static inline uint8_t led_color_qadd8(uint8_t a, uint8_t b)
+{
+    uint32_t sum = (uint32_t)a + b;
+    return sum > 255 ? 255 : (uint8_t)sum;
+}
+
+static inline uint8_t led_color_qsub8(uint8_t a, uint8_t b)
+{
+    return a > b ? (uint8_t)(a - b) : 0;
+}
+
+static inline led_rgb_t led_color_scale(led_rgb_t c, uint8_t scale)
+{
+    return (led_rgb_t){
+        led_color_scale8(c.r, scale),
+        led_color_scale8(c.g, scale),
+        led_color_scale8(c.b, scale)
+    };
+}
+
+static inline led_rgb_t led_color_blend(led_rgb_t a, led_rgb_t b, uint8_t amount)
+{
+    return (led_rgb_t){
+        led_color_blend8(a.r, b.r, amount),
+        led_color_blend8(a.g, b.g, amount),
+        led_color_blend8(a.b, b.b, amount)
+    };
+}
+
+// ---- HSV ----
+
+/**
+ * @brief HSV 转 RGB
+ *
+ * @param hue 色调，16 位一整圈 (0-65535 对应 0-360°)
+ * @param sat 饱和度 (0-255)
+ * @param val 亮度 (0-255)
+ * @return 与浮点公式相比每个通道误差不超过 1
+ */
+led_rgb_t led_color_hsv16(uint16_t hue, uint8_t sat, uint8_t val);
+
+/**
+ * @brief HSV 转 RGB，色调为 8 位一整圈 (0-255)
+ */
+static inline led_rgb_t led_color_hsv(uint8_t hue, uint8_t sat, uint8_t val)
+{
+    return led_color_hsv16((uint16_t)(hue << 8), sat, val);
+}
+
+/**
+ * @brief HSV 转 RGB，色调为角度 (超过 360 时取余)
+ */
+static inline led_rgb_t led_color_hsv_deg(uint32_t hue_deg, uint8_t sat, uint8_t val)
+{
+    hue_deg %= 360;
+    return led_color_hsv16((uint16_t)((hue_deg * 65536 + 180) / 360), sat, val);
+}
+
+// ---- 正弦/余弦 ----
+
+/**
+ * @brief 正弦 (四分之一周期查表加线性插值)
+ *
+ * @param angle 角度，16 位一整圈 (0-65535 对应 0-2π)
+ * @return -32767 到 32767
+ */
+int16_t led_color_sin16(uint16_t angle);
+
+static inline int16_t led_color_cos16(uint16_t angle)
+{
+    return led_color_sin16((uint16_t)(angle + 16384));
+}
+
+/**
+ * @brief 8 位正弦：theta 0-255 一整圈，结果 0-255 (128 对应 0)
+ *
+ * 适合直接用作亮度或混合比例
+ */
+static inline uint8_t led_color_sin8(uint8_t theta)
+{
+    return (uint8_t)((led_color_sin16((uint16_t)(theta << 8)) + 32768) >> 8);
+}
+
+static inline uint8_t led_color_cos8(uint8_t theta)
+{
+    return led_color_sin8((uint8_t)(theta + 64));
+}
+
+/**
+ * @brief 弧度 n / d 换算为 16 位角度 (d 为常数时编译成乘法和移位)
+ *
+ * 每弧度 10430.38 个单位用 22 位小数的定点数表示，周期的相对误差约 1e-6。
+ * 乘法溢出后按 2^32 取模，结果仍按一整圈取模正确，n 可以是一直递增的帧号
+ */
+#define LED_COLOR_RAD16(n, d)   ((uint16_t)(((uint32_t)(n) * (uint32_t)(10680707u / (d))) >> 10))
+
+// ---- 伽马校正 ----
+
+extern const uint8_t led_color_gamma_table[256];
+
+/**
+ * @brief 伽马校正：线性亮度转为 LED 的 PWM 值，使亮度变化在人眼看来均匀
+ */
+static inline uint8_t led_color_gamma8(uint8_t v)
+{
+    return led_color_gamma_table[v];
+}
+
+static inline led_rgb_t led_color_gamma(led_rgb_t c)
+{
+    return (led_rgb_t){
+        led_color_gamma_table[c.r],
+        led_color_gamma_table[c.g],
+        led_color_gamma_table[c.b]
+    };
+}
+
+// ---- 调色板 ----
+
+/**
+ * @brief 调色板插值
+ *
+ * @param colors 颜色 (按顺序)
+ * @param count 颜色数 (至少 1 个)
+ * @param index 位置 (0-255)，在相邻颜色之间线性插值
+ * @param wrap false 时 0 为第一个颜色、255 为最后一个颜色；
+ *             true 时 0-255 均分成 count 段，最后一段从最后一个颜色过渡回第一个 (用于循环的效果)
+ */
+led_rgb_t led_color_palette(const led_rgb_t *colors, uint8_t count, uint8_t index, bool wrap);
+
+/**
+ * @brief 缩放一组像素 (整体调暗)
+ */
+void led_color_scale_buf(led_rgb_t *pixels, size_t count, uint8_t scale);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LED_COLOR_H
@@ -0,0 +1,114 @@
+#include "led_color.h"
+
+// 正弦表：四分之一周期 (0-π/2) 等分 256 段共 257 个点，幅值 32767。
+// 段间线性插值的误差不到 0.2 (远小于取整误差)
+static const int16_t s_sin_quarter[257] = {
+        0,   201,   402,   603,   804,  1005,  1206,  1407,  1608,  1809,  2009,  2210,
+     2410,  2611,  2811,  3012,  3212,  3412,  3612,  3811,  4011,  4210,  4410,  4609,
+     4808,  5007,  5205,  5404,  5602,  5800,  5998,  6195,  6393,  6590,  6786,  6983,
+     7179,  7375,  7571,  7767,  7962,  8157,  8351,  8545,  8739,  8933,  9126,  9319,
+     9512,  9704,  9896, 10087, 10278, 10469, 10659, 10849, 11039, 11228, 11417, 11605,
+    11793, 11980, 12167, 12353, 12539, 12725, 12910, 13094, 13279, 13462, 13645, 13828,
+    14010, 14191, 14372, 14553, 14732, 14912, 15090, 15269, 15446, 15623, 15800, 15976,
+    16151, 16325, 16499, 16673, 16846, 17018, 17189, 17360, 17530, 17700, 17869, 18037,
+    18204, 18371, 18537, 18703, 18868, 19032, 19195, 19357, 19519, 19680, 19841, 20000,
+    20159, 20317, 20475, 20631, 20787, 20942, 21096, 21250, 21403, 21554, 21705, 21856,
+    22005, 22154, 22301, 22448, 22594, 22739, 22884, 23027, 23170, 23311, 23452, 23592,
+    23731, 23870, 24007, 24143, 24279, 24413, 24547, 24680, 24811, 24942, 25072, 25201,
+    25329, 25456, 25582, 25708, 25832, 25955, 26077, 26198, 26319, 26438, 26556, 26674,
+    26790, 26905, 27019, 27133, 27245, 27356, 27466, 27575, 27683, 27790, 27896, 28001,
+    28105, 28208, 28310, 28411, 28510, 28609, 28706, 28803, 28898, 28992, 29085, 29177,
+    29268, 29358, 29447, 29534, 29621, 29706, 29791, 29874, 29956, 30037, 30117, 30195,
+    30273, 30349, 30424, 30498, 30571, 30643, 30714, 30783, 30852, 30919, 30985, 31050,
+    31113, 31176, 31237, 31297, 31356, 31414, 31470, 31526, 31580, 31633, 31685, 31736,
+    31785, 31833, 31880, 31926, 31971, 32014, 32057, 32098, 32137, 32176, 32213, 32250,
+    32285, 32318, 32351, 32382, 32412, 32441, 32469, 32495, 32521, 32545, 32567, 32589,
+    32609, 32628, 32646, 32663, 32678, 32692, 32705, 32717, 32728, 32737, 32745, 32752,
+    32757, 32761, 32765, 32766, 32767,
+};
+
+// 伽马校正表：round(255 * (i / 255)^2.8)
+const uint8_t led_color_gamma_table[256] = {
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,   1,   1,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,
+      2,   3,   3,   3,   3,   3,   3,   3,   4,   4,   4,   4,   4,   5,   5,   5,
+      5,   6,   6,   6,   6,   7,   7,   7,   7,   8,   8,   8,   9,   9,   9,  10,
+     10,  10,  11,  11,  11,  12,  12,  13,  13,  13,  14,  14,  15,  15,  16,  16,
+     17,  17,  18,  18,  19,  19,  20,  20,  21,  21,  22,  22,  23,  24,  24,  25,
+     25,  26,  27,  27,  28,  29,  29,  30,  31,  32,  32,  33,  34,  35,  35,  36,
+     37,  38,  39,  39,  40,  41,  42,  43,  44,  45,  46,  47,  48,  49,  50,  50,
+     51,  52,  54,  55,  56,  57,  58,  59,  60,  61,  62,  63,  64,  66,  67,  68,
+     69,  70,  72,  73,  74,  75,  77,  78,  79,  81,  82,  83,  85,  86,  87,  89,
+     90,  92,  93,  95,  96,  98,  99, 101, 102, 104, 105, 107, 109, 110, 112, 114,
+    115, 117, 119, 120, 122, 124, 126, 127, 129, 131, 133, 135, 137, 138, 140, 142,
+    144, 146, 148, 150, 152, 154, 156, 158, 160, 162, 164, 167, 169, 171, 173, 175,
+    177, 180, 182, 184, 186, 189, 191, 193, 196, 198, 200, 203, 205, 208, 210, 213,
+    215, 218, 220, 223, 225, 228, 231, 233, 236, 239, 241, 244, 247, 249, 252, 255,
+};
+
+led_rgb_t led_color_hsv16(uint16_t hue, uint8_t sat, uint8_t val)
+{
+    // 六个扇区，frac 为扇区内的位置 (16 位小数)
+    uint32_t h6 = (uint32_t)hue * 6;
+    uint32_t sector = h6 >> 16;
+    uint32_t frac = h6 & 0xFFFF;
+
+    // 与浮点公式相同：p = v(1-s)，q = v(1-s·f)，t = v(1-s·(1-f))
+    // vs·frac 最大 65025 × 65536，不超过 32 位；除以常数由编译器换成乘法
+    uint32_t vs = (uint32_t)val * sat;
+    uint8_t p = val - led_color_div255(vs);
+    uint8_t q = val - (uint8_t)((vs * frac + 8355840u) / 16711680u);
+    uint8_t t = val - (uint8_t)((vs * (65536 - frac) + 8355840u) / 16711680u);
+
+    switch (sector) {
+    case 0: return (led_rgb_t){val, t, p};
+    case 1: return (led_rgb_t){q, val, p};
+    case 2: return (led_rgb_t){p, val, t};
+    case 3: return (led_rgb_t){p, q, val};
+    case 4: return (led_rgb_t){t, p, val};
+    default: return (led_rgb_t){val, p, q};
+    }
+}
+
+int16_t led_color_sin16(uint16_t angle)
+{
+    // 按象限折叠到 0-π/2：第二、四象限镜像，第三、四象限取负
+    uint32_t a = angle & 0x3FFF;
+    if (angle & 0x4000) {
+        a = 0x4000 - a;
+    }
+
+    uint32_t idx = a >> 6;
+    int32_t y = s_sin_quarter[idx];
+    uint32_t frac = a & 0x3F;
+    if (frac) {
+        y += ((s_sin_quarter[idx + 1] - y) * (int32_t)frac + 32) >> 6;
+    }
+
+    return (int16_t)((angle & 0x8000) ? -y : y);
+}
+
+led_rgb_t led_color_palette(const led_rgb_t *colors, uint8_t count, uint8_t index, bool wrap)
+{
+    if (count <= 1) {
+        return count ? colors[0] : (led_rgb_t){0, 0, 0};
+    }
+
+    // 乘以段数后高 16 位为段号、接下来 8 位为段内位置。
+    // 不循环时 index 扩展到 16 位 (255 对应 65535)，使 255 正好落在最后一个颜色上
+    uint32_t pos = wrap ? ((uint32_t)index << 8) * count : (uint32_t)index * 257 * (count - 1u);
+    uint32_t seg = pos >> 16;
+    uint8_t amount = (uint8_t)(pos >> 8);
+
+    led_rgb_t a = colors[seg];
+    led_rgb_t b = colors[seg + 1 < count ? seg + 1 : 0];
+    return led_color_blend(a, b, amount);
+}
+
+void led_color_scale_buf(led_rgb_t *pixels, size_t count, uint8_t scale)
+{
+    for (size_t i = 0; i < count; i++) {
+        pixels[i] = led_color_scale(pixels[i], scale);
+    }
+}
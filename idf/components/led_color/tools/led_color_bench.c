@@ -0,0 +1,389 @@
+/*
+ * LED 颜色运算主机测试和基准 (Linux / macOS)
+ *
+ * 精度: 与浮点参考实现逐点比较 (HSV 全色调 × 饱和度 × 亮度网格、正弦全部 65536 个角度、
+ *       伽马表、8 位缩放/混合全部输入组合、调色板)，报告最大误差，超出允许范围时返回非 0。
+ * 速度: 每种运算和原来的写法 (浮点 fmod HSV、各项目的整数 HSV、sinf、powf、浮点插值) 比较每次调用的耗时。
+ *
+ * 编译和运行:
+ *     cc -O2 -Iinclude -o led_color_bench tools/led_color_bench.c led_color.c -lm
+ *     ./led_color_bench
+ */
+
+#include "led_color.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_CALLS 4000000
+
+static int s_failures = 0;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void check(const char *name, double max_err, double limit)
+{
+    bool ok = max_err <= limit;
+    printf("  %-34s max error %-8.3f (limit %.3f) %s\n", name, max_err, limit, ok ? "ok" : "FAIL");
+    if (!ok) {
+        s_failures++;
+    }
+}
+
+// ---- 参考实现 ----
+
+// 浮点 HSV (wifi_led_web_controller 原来的写法，改为四舍五入作为参考)
+static void ref_hsv(float h, float s, float v, float out[3])
+{
+    h = fmodf(h, 360.0f);
+    float c = v * s;
+    float x = c * (1.0f - fabsf(fmodf(h / 60.0f, 2.0f) - 1.0f));
+    float m = v - c;
+    float r, g, b;
+    if (h < 60) {
+        r = c; g = x; b = 0;
+    } else if (h < 120) {
+        r = x; g = c; b = 0;
+    } else if (h < 180) {
+        r = 0; g = c; b = x;
+    } else if (h < 240) {
+        r = 0; g = x; b = c;
+    } else if (h < 300) {
+        r = x; g = 0; b = c;
+    } else {
+        r = c; g = 0; b = x;
+    }
+    out[0] = (r + m) * 255.0f;
+    out[1] = (g + m) * 255.0f;
+    out[2] = (b + m) * 255.0f;
+}
+
+// 原来的写法 (用于速度和误差对比)
+typedef struct {
+    uint8_t r, g, b;
+} rgb8_t;
+
+// neopixel_clock 的 light_show.c / main.c：角度色调
+static rgb8_t old_hsv_deg(int hue, int sat, int val)
+{
+    hue = hue % 360;
+    int h = hue / 60;
+    int f = (hue % 60) * 255 / 60;
+    int p = val * (255 - sat) / 255;
+    int q = val * (255 - (sat * f / 255)) / 255;
+    int t = val * (255 - (sat * (255 - f) / 255)) / 255;
+    switch (h) {
+        case 0: return (rgb8_t){val, t, p};
+        case 1: return (rgb8_t){q, val, p};
+        case 2: return (rgb8_t){p, val, t};
+        case 3: return (rgb8_t){p, q, val};
+        case 4: return (rgb8_t){t, p, val};
+        default: return (rgb8_t){val, p, q};
+    }
+}
+
+// led_blink / joystick_led_controller：8 位色调
+static rgb8_t old_hsv_43(int hue, int saturation, int value)
+{
+    int region, remainder, p, q, t;
+    if (saturation == 0) {
+        return (rgb8_t){value, value, value};
+    }
+    region = hue / 43;
+    remainder = (hue - (region * 43)) * 6;
+    p = (value * (255 - saturation)) >> 8;
+    q = (value * (255 - ((saturation * remainder) >> 8))) >> 8;
+    t = (value * (255 - ((saturation * (255 - remainder)) >> 8))) >> 8;
+    switch (region) {
+        case 0: return (rgb8_t){value, t, p};
+        case 1: return (rgb8_t){q, value, p};
+        case 2: return (rgb8_t){p, value, t};
+        case 3: return (rgb8_t){p, q, value};
+        case 4: return (rgb8_t){t, p, value};
+        default: return (rgb8_t){value, p, q};
+    }
+}
+
+static double channel_err(const float ref[3], uint8_t r, uint8_t g, uint8_t b)
+{
+    double e = fabs(ref[0] - r);
+    if (fabs(ref[1] - g) > e) e = fabs(ref[1] - g);
+    if (fabs(ref[2] - b) > e) e = fabs(ref[2] - b);
+    return e;
+}
+
+// ---- 精度 ----
+
+static void test_hsv(void)
+{
+    double err16 = 0, err_deg = 0, err8 = 0, old_deg = 0, old_43 = 0;
+    float ref[3];
+
+    for (int sat = 0; sat <= 255; sat += 3) {
+        for (int val = 0; val <= 255; val += 3) {
+            for (uint32_t hue = 0; hue < 65536; hue += 7) {
+                ref_hsv(hue * 360.0f / 65536.0f, sat / 255.0f, val / 255.0f, ref);
+                led_rgb_t c = led_color_hsv16((uint16_t)hue, sat, val);
+                double e = channel_err(ref, c.r, c.g, c.b);
+                if (e > err16) err16 = e;
+            }
+            for (int deg = 0; deg < 360; deg++) {
+                ref_hsv((float)deg, sat / 255.0f, val / 255.0f, ref);
+                led_rgb_t c = led_color_hsv_deg(deg, sat, val);
+                double e = channel_err(ref, c.r, c.g, c.b);
+                if (e > err_deg) err_deg = e;
+                rgb8_t o = old_hsv_deg(deg, sat, val);
+                e = channel_err(ref, o.r, o.g, o.b);
+                if (e > old_deg) old_deg = e;
+            }
+            for (int h8 = 0; h8 < 256; h8++) {
+                ref_hsv(h8 * 360.0f / 256.0f, sat / 255.0f, val / 255.0f, ref);
+                led_rgb_t c = led_color_hsv(h8, sat, val);
+                double e = channel_err(ref, c.r, c.g, c.b);
+                if (e > err8) err8 = e;
+                rgb8_t o = old_hsv_43(h8, sat, val);
+                e = channel_err(ref, o.r, o.g, o.b);
+                if (e > old_43) old_43 = e;
+            }
+        }
+    }
+
+    // 结果与四舍五入的浮点值一致 (0.5)；角度色调量化到 16 位后最多偏差 0.003°
+    check("hsv16 vs float", err16, 0.5 + 1e-3);
+    check("hsv_deg vs float", err_deg, 0.5 + 0.02);
+    check("hsv (8-bit hue) vs float", err8, 0.5 + 1e-3);
+    printf("  %-34s max error %.3f\n", "old hsv (degrees) vs float", old_deg);
+    printf("  %-34s max error %.3f\n", "old hsv (hue/43) vs float", old_43);
+}
+
+static void test_sin(void)
+{
+    double err16 = 0, err8 = 0, errc = 0;
+    for (uint32_t a = 0; a < 65536; a++) {
+        double ref = sin(a * 2 * M_PI / 65536.0) * 32767.0;
+        double e = fabs(led_color_sin16((uint16_t)a) - ref);
+        if (e > err16) err16 = e;
+        e = fabs(led_color_cos16((uint16_t)a) - cos(a * 2 * M_PI / 65536.0) * 32767.0);
+        if (e > errc) errc = e;
+    }
+    for (int t = 0; t < 256; t++) {
+        double ref = 127.5 + sin(t * 2 * M_PI / 256.0) * 127.5;
+        double e = fabs(led_color_sin8(t) - ref);
+        if (e > err8) err8 = e;
+    }
+    // 表中取整 0.5 + 插值取整 0.5 + 线性插值本身约 0.15
+    check("sin16 vs sin (LSB of 32767)", err16, 1.2);
+    check("cos16 vs cos (LSB of 32767)", errc, 1.2);
+    check("sin8 vs 127.5 + 127.5 sin", err8, 1.0);
+
+    // 弧度换算：n / d 弧度
+    double errr = 0;
+    const int ds[] = { 8, 10, 12, 15 };
+    for (size_t k = 0; k < sizeof(ds) / sizeof(ds[0]); k++) {
+        for (uint32_t n = 0; n < 20000; n++) {
+            double ref = sin((double)n / ds[k]) * 32767.0;
+            uint16_t a;
+            switch (ds[k]) {
+                case 8: a = LED_COLOR_RAD16(n, 8); break;
+                case 10: a = LED_COLOR_RAD16(n, 10); break;
+                case 12: a = LED_COLOR_RAD16(n, 12); break;
+                default: a = LED_COLOR_RAD16(n, 15); break;
+            }
+            double e = fabs(led_color_sin16(a) - ref);
+            if (e > errr) errr = e;
+        }
+    }
+    // 每弧度的单位数是定点数，相位误差随 n 累积 (n = 20000 时约 0.05°)，换算为 8 位亮度比较
+    check("sin16(RAD16(n,d)) vs sin(n/d), 8-bit", errr / 32767.0 * 255.0, 0.5);
+}
+
+static void test_gamma_scale_blend(void)
+{
+    double errg = 0;
+    for (int i = 0; i < 256; i++) {
+        double e = fabs(led_color_gamma8(i) - 255.0 * pow(i / 255.0, LED_COLOR_GAMMA));
+        if (e > errg) errg = e;
+    }
+    check("gamma8 vs pow", errg, 0.5);
+
+    double errd = 0;
+    for (uint32_t x = 0; x <= 255 * 255; x++) {
+        double e = fabs(led_color_div255(x) - x / 255.0);
+        if (e > errd) errd = e;
+    }
+    check("div255 vs x/255 (0-65025)", errd, 0.5);
+
+    double errs = 0, errb = 0;
+    for (int a = 0; a < 256; a++) {
+        for (int b = 0; b < 256; b++) {
+            double e = fabs(led_color_scale8(a, b) - a * b / 255.0);
+            if (e > errs) errs = e;
+            for (int m = 0; m < 256; m += 5) {
+                e = fabs(led_color_blend8(a, b, m) - (a + (b - a) * m / 255.0));
+                if (e > errb) errb = e;
+            }
+        }
+    }
+    check("scale8 vs v*s/255", errs, 0.5);
+    check("blend8 vs lerp", errb, 0.5);
+    if (led_color_scale8(200, 255) != 200 || led_color_scale8(200, 0) != 0 ||
+        led_color_blend8(10, 240, 0) != 10 || led_color_blend8(10, 240, 255) != 240) {
+        printf("  endpoints FAIL\n");
+        s_failures++;
+    }
+}
+
+static void test_palette(void)
+{
+    static const led_rgb_t pal[] = {
+        {255, 0, 0}, {0, 255, 0}, {0, 0, 255}, {255, 255, 255}, {16, 32, 64},
+    };
+    const int n = sizeof(pal) / sizeof(pal[0]);
+    double err = 0, errw = 0;
+
+    for (int count = 2; count <= n; count++) {
+        for (int i = 0; i < 256; i++) {
+            // 不循环：0-255 对应第一个到最后一个颜色
+            double pos = i / 255.0 * (count - 1);
+            int s = (int)pos;
+            if (s >= count - 1) s = count - 2;
+            double f = pos - s;
+            led_rgb_t c = led_color_palette(pal, count, i, false);
+            double e = fabs(c.r - (pal[s].r + (pal[s + 1].r - pal[s].r) * f));
+            if (e > err) err = e;
+            e = fabs(c.b - (pal[s].b + (pal[s + 1].b - pal[s].b) * f));
+            if (e > err) err = e;
+
+            // 循环：0-256 对应第一个颜色到再次回到第一个颜色
+            pos = i / 256.0 * count;
+            s = (int)pos;
+            f = pos - s;
+            int s1 = (s + 1) % count;
+            c = led_color_palette(pal, count, i, true);
+            e = fabs(c.g - (pal[s].g + (pal[s1].g - pal[s].g) * f));
+            if (e > errw) errw = e;
+        }
+        led_rgb_t last = led_color_palette(pal, count, 255, false);
+        if (memcmp(&last, &pal[count - 1], sizeof(last)) != 0) {
+            printf("  palette end FAIL (count %d)\n", count);
+            s_failures++;
+        }
+    }
+    // 位置量化为 8 位 (每段至少 1/256)，两个颜色差 255 时最多偏差约 1
+    check("palette vs float lerp", err, 1.5);
+    check("palette (wrap) vs float lerp", errw, 1.5);
+}
+
+// ---- 速度 ----
+
+static volatile uint32_t s_sink;
+static uint8_t s_input[1024];
+
+#define BENCH(label, expr) do { \
+        uint32_t acc = 0; \
+        double t0 = now_ns(); \
+        for (uint32_t i = 0; i < BENCH_CALLS; i++) { \
+            uint32_t x = s_input[i & 1023] + i; \
+            (void)x; \
+            acc += (uint32_t)(expr); \
+        } \
+        s_sink = acc; \
+        results[nres].name = label; \
+        results[nres].ns = (now_ns() - t0) / BENCH_CALLS; \
+        nres++; \
+    } while (0)
+
+typedef struct {
+    const char *name;
+    double ns;
+} result_t;
+
+static uint32_t hsv_float_sum(uint32_t x)
+{
+    float c[3];
+    ref_hsv((float)(x % 360), 1.0f, (x & 255) / 255.0f, c);
+    return (uint32_t)c[0] + (uint32_t)c[1] + (uint32_t)c[2];
+}
+
+static uint32_t rgb_sum(led_rgb_t c)
+{
+    return c.r + c.g + c.b;
+}
+
+static uint32_t rgb8_sum(rgb8_t c)
+{
+    return c.r + c.g + c.b;
+}
+
+static uint32_t lerp3_float(uint32_t x)
+{
+    // light_show.c 原来的 interpolate_3colors
+    static const float c1[3] = {0, 255, 255}, c2[3] = {255, 0, 128}, c3[3] = {255, 255, 0};
+    float ratio = (x % 60) / 60.0f;
+    float out = 0;
+    if (ratio < 0.5f) {
+        float r = ratio * 2.0f;
+        for (int k = 0; k < 3; k++) out += (uint8_t)(c1[k] * (1 - r) + c2[k] * r);
+    } else {
+        float r = (ratio - 0.5f) * 2.0f;
+        for (int k = 0; k < 3; k++) out += (uint8_t)(c2[k] * (1 - r) + c3[k] * r);
+    }
+    return (uint32_t)out;
+}
+
+static void bench(void)
+{
+    static const led_rgb_t pal3[] = { {0, 255, 255}, {255, 0, 128}, {255, 255, 0} };
+    result_t results[16];
+    int nres = 0;
+
+    for (int i = 0; i < 1024; i++) {
+        s_input[i] = (uint8_t)rand();
+    }
+
+    BENCH("hsv: float fmod", hsv_float_sum(x));
+    BENCH("hsv: old integer (degrees)", rgb8_sum(old_hsv_deg(x % 360, 255, x & 255)));
+    BENCH("hsv: old integer (hue/43)", rgb8_sum(old_hsv_43(x & 255, 255, x & 255)));
+    BENCH("hsv: led_color_hsv16", rgb_sum(led_color_hsv16((uint16_t)(x * 257), 255, x & 255)));
+    BENCH("hsv: led_color_hsv_deg", rgb_sum(led_color_hsv_deg(x % 360, 255, x & 255)));
+    BENCH("sin: sinf", (uint32_t)(int32_t)(sinf((float)x / 10.0f) * 32767.0f));
+    BENCH("sin: led_color_sin16", (uint32_t)led_color_sin16(LED_COLOR_RAD16(x, 10)));
+    BENCH("sin: led_color_sin8", led_color_sin8((uint8_t)x));
+    BENCH("gamma: powf", (uint32_t)(powf((x & 255) / 255.0f, 2.8f) * 255.0f + 0.5f));
+    BENCH("gamma: led_color_gamma8", led_color_gamma8((uint8_t)x));
+    BENCH("scale: float", (uint32_t)((x & 255) * ((x >> 3) & 255) / 255.0f));
+    BENCH("scale: integer v*s/255", (x & 255) * ((x >> 3) & 255) / 255);
+    BENCH("scale: led_color_scale8", led_color_scale8((uint8_t)x, (uint8_t)(x >> 3)));
+    BENCH("palette: float 3-colour lerp", lerp3_float(x));
+    BENCH("palette: led_color_palette", rgb_sum(led_color_palette(pal3, 3, (uint8_t)x, false)));
+
+    printf("\n%-32s %10s\n", "operation", "ns/call");
+    for (int i = 0; i < nres; i++) {
+        printf("%-32s %10.2f\n", results[i].name, results[i].ns);
+    }
+}
+
+int main(void)
+{
+    printf("accuracy:\n");
+    test_hsv();
+    test_sin();
+    test_gamma_scale_blend();
+    test_palette();
+
+    bench();
+
+    if (s_failures) {
+        printf("\n%d check(s) failed\n", s_failures);
+        return 1;
+    }
+    printf("\nall checks passed\n");
+    return 0;
+}
@@ -0,0 +1,279 @@
+#include "ai_cache.h"
+#include "ai_intent.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <ctype.h>
+#include <string.h>
+#include <stdlib.h>
+
+static const char *TAG = "AI_CACHE";
+
+// 缓存条目 (键为规范化查询的 64 位哈希，不保存原文)
+typedef struct {
+    uint64_t hash;              // 0 为空位
+    int64_t expire_us;
+    uint32_t last_used;         // 最近使用序号 (LRU)
+    uint32_t latency_ms;        // 后端生成该回复的耗时
+    uint16_t size;              // text 占用字节 (含结尾 '\0')
+    int16_t confidence;
+    char action[16];
+    char emotion[16];
+    char *text;
+} cache_entry_t;
+
+static cache_entry_t entries[AI_CACHE_MAX_ENTRIES];
+static uint32_t use_seq = 0;
+static SemaphoreHandle_t cache_lock = NULL;
+static ai_cache_stats_t stats;
+
+// FNV-1a 64 位哈希 (空串哈希非 0，0 留作空位标记)
+static uint64_t cache_hash(const char *data, size_t len)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (uint8_t)data[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h ? h : 1;
+}
+
+// 问题类别决定有效期：天气和实时信息很快过时，创作类 (笑话、随机) 每次应不同
+static uint32_t cache_ttl_s(const char *query)
+{
+    ai_intent_result_t match;
+    ai_intent_match(query, &match);
+
+    if (match.scores[AI_INTENT_CREATIVE] > 0) {
+        return AI_CACHE_TTL_CREATIVE;
+    }
+    if (match.scores[AI_INTENT_REALTIME] > 0) {
+        return AI_CACHE_TTL_REALTIME;
+    }
+    if (match.scores[AI_INTENT_WEATHER] > 0) {
+        return AI_CACHE_TTL_WEATHER;
+    }
+    return AI_CACHE_TTL_GENERAL;
+}
+
+static void cache_remove(cache_entry_t *entry)
+{
+    stats.entries--;
+    stats.bytes -= entry->size;
+    free(entry->text);
+    memset(entry, 0, sizeof(*entry));
+}
+
+static cache_entry_t *cache_find(uint64_t hash)
+{
+    for (int i = 0; i < AI_CACHE_MAX_ENTRIES; i++) {
+        if (entries[i].hash == hash) {
+            return &entries[i];
+        }
+    }
+    return NULL;
+}
+
+// 选出要淘汰的条目：优先已过期的，其次最久未用的
+static cache_entry_t *cache_victim(int64_t now)
+{
+    cache_entry_t *victim = NULL;
+    for (int i = 0; i < AI_CACHE_MAX_ENTRIES; i++) {
+        cache_entry_t *entry = &entries[i];
+        if (entry->hash == 0) {
+            continue;
+        }
+        if (entry->expire_us <= now) {
+            return entry;
+        }
+        if (victim == NULL || (int32_t)(entry->last_used - victim->last_used) < 0) {
+            victim = entry;
+        }
+    }
+    return victim;
+}
+
+size_t ai_cache_normalize(const char *query, char *out, size_t out_size)
+{
+    const uint8_t *p = (const uint8_t *)query;
+    size_t n = 0;
+
+    while (*p != '\0' && n + 4 < out_size) {
+        uint8_t c = *p;
+
+        if (c < 0x80) {
+            p++;
+            if (!isspace(c) && !ispunct(c) && !iscntrl(c)) {
+                out[n++] = (char)tolower(c);
+            }
+            continue;
+        }
+
+        // 三字节 UTF-8 (中文字符和中文标点都在此范围)
+        if ((c & 0xF0) == 0xE0 && (p[1] & 0xC0) == 0x80 && (p[2] & 0xC0) == 0x80) {
+            uint32_t cp = ((uint32_t)(c & 0x0F) << 12) | ((uint32_t)(p[1] & 0x3F) << 6) | (p[2] & 0x3F);
+            if ((cp >= 0x2000 && cp <= 0x206F) ||       // 通用标点 (引号、省略号、破折号等)
+                (cp >= 0x3000 && cp <= 0x303F) ||       // 中文标点和全角空格
+                (cp >= 0xFE10 && cp <= 0xFE6F)) {       // 竖排和小写标点
+                p += 3;
+                continue;
+            }
+            if (cp >= 0xFF01 && cp <= 0xFF5E) {         // 全角 ASCII
+                uint8_t a = (uint8_t)(cp - 0xFEE0);
+                p += 3;
+                if (!ispunct(a)) {
+                    out[n++] = (char)tolower(a);
+                }
+                continue;
+            }
+            memcpy(out + n, p, 3);
+            n += 3;
+            p += 3;
+            continue;
+        }
+
+        // 其他多字节字符按字节原样保留
+        out[n++] = (char)c;
+        p++;
+    }
+    out[n] = '\0';
+    return n;
+}
+
+esp_err_t ai_cache_init(void)
+{
+    if (cache_lock == NULL) {
+        cache_lock = xSemaphoreCreateMutex();
+        if (cache_lock == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    ESP_LOGI(TAG, "回复缓存: %d 条, %d 字节", AI_CACHE_MAX_ENTRIES, AI_CACHE_BUDGET_BYTES);
+    return ESP_OK;
+}
+
+bool ai_cache_lookup(const char *query, ai_response_t *response)
+{
+    if (cache_lock == NULL || query == NULL) {
+        return false;
+    }
+
+    char key[512];
+    size_t len = ai_cache_normalize(query, key, sizeof(key));
+    if (len == 0) {
+        return false;
+    }
+    uint64_t hash = cache_hash(key, len);
+    int64_t now = esp_timer_get_time();
+    bool hit = false;
+
+    xSemaphoreTake(cache_lock, portMAX_DELAY);
+    stats.lookups++;
+    cache_entry_t *entry = cache_find(hash);
+    if (entry != NULL && entry->expire_us <= now) {
+        cache_remove(entry);
+        stats.expired++;
+        entry = NULL;
+    }
+    if (entry != NULL) {
+        strlcpy(response->text, entry->text, sizeof(response->text));
+        strlcpy(response->action, entry->action, sizeof(response->action));
+        strlcpy(response->emotion, entry->emotion, sizeof(response->emotion));
+        response->confidence = entry->confidence;
+        entry->last_used = ++use_seq;
+        stats.hits++;
+        stats.saved_ms += entry->latency_ms;
+        hit = true;
+    }
+    xSemaphoreGive(cache_lock);
+
+    if (hit) {
+        ESP_LOGI(TAG, "命中缓存: %s", key);
+    }
+    return hit;
+}
+
+void ai_cache_store(const char *query, const ai_response_t *response, uint32_t latency_ms)
+{
+    if (cache_lock == NULL || query == NULL || response == NULL) {
+        return;
+    }
+
+    uint32_t ttl_s = cache_ttl_s(query);
+    size_t size = strlen(response->text) + 1;
+    if (ttl_s == 0 || size == 1 || size > AI_CACHE_BUDGET_BYTES / 4) {
+        return;     // 不缓存的类别、空回复或过长的回复
+    }
+
+    char key[512];
+    size_t len = ai_cache_normalize(query, key, sizeof(key));
+    if (len == 0) {
+        return;
+    }
+    uint64_t hash = cache_hash(key, len);
+
+    char *text = malloc(size);
+    if (text == NULL) {
+        return;
+    }
+    memcpy(text, response->text, size);
+
+    int64_t now = esp_timer_get_time();
+    xSemaphoreTake(cache_lock, portMAX_DELAY);
+
+    cache_entry_t *entry = cache_find(hash);
+    if (entry != NULL) {
+        cache_remove(entry);
+    }
+
+    // 腾出空位和内存
+    while (stats.entries >= AI_CACHE_MAX_ENTRIES || stats.bytes + size > AI_CACHE_BUDGET_BYTES) {
+        cache_entry_t *victim = cache_victim(now);
+        if (victim->expire_us > now) {
+            stats.evictions++;
+        }
+        cache_remove(victim);
+    }
+    entry = cache_find(0);
+
+    entry->hash = hash;
+    entry->expire_us = now + (int64_t)ttl_s * 1000000;
+    entry->last_used = ++use_seq;
+    entry->latency_ms = latency_ms;
+    entry->size = size;
+    entry->confidence = response->confidence;
+    strlcpy(entry->action, response->action, sizeof(entry->action));
+    strlcpy(entry->emotion, response->emotion, sizeof(entry->emotion));
+    entry->text = text;
+    stats.entries++;
+    stats.bytes += size;
+    stats.stores++;
+
+    xSemaphoreGive(cache_lock);
+}
+
+void ai_cache_clear(void)
+{
+    if (cache_lock == NULL) {
+        return;
+    }
+    xSemaphoreTake(cache_lock, portMAX_DELAY);
+    for (int i = 0; i < AI_CACHE_MAX_ENTRIES; i++) {
+        if (entries[i].hash != 0) {
+            cache_remove(&entries[i]);
+        }
+    }
+    xSemaphoreGive(cache_lock);
+}
+
+void ai_cache_get_stats(ai_cache_stats_t *out)
+{
+    if (cache_lock == NULL) {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+    xSemaphoreTake(cache_lock, portMAX_DELAY);
+    *out = stats;
+    xSemaphoreGive(cache_lock);
+}
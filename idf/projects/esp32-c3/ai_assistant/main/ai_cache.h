@@ -0,0 +1,43 @@
+#ifndef AI_CACHE_H
+#define AI_CACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "ai_engine.h"
+
+// 最多缓存的回复数
+#define AI_CACHE_MAX_ENTRIES    32
+
+// 回复文本占用的内存上限 (ESP32-C3 可用堆约 200KB)
+#define AI_CACHE_BUDGET_BYTES   (12 * 1024)
+
+// 各类问题的有效期 (秒)，0 为不缓存
+#define AI_CACHE_TTL_WEATHER    (10 * 60)
+#define AI_CACHE_TTL_REALTIME   (5 * 60)
+#define AI_CACHE_TTL_CREATIVE   0
+#define AI_CACHE_TTL_GENERAL    (24 * 60 * 60)
+
+// 缓存统计
+typedef struct {
+    uint32_t entries;
+    uint32_t bytes;             // 回复文本占用
+    uint32_t lookups;
+    uint32_t hits;
+    uint32_t stores;
+    uint32_t evictions;         // 为腾出空间淘汰的最久未用条目
+    uint32_t expired;           // 查找时发现已过期的条目
+    uint64_t saved_ms;          // 命中时省去的后端耗时 (按该回复首次生成的耗时计)
+} ai_cache_stats_t;
+
+// 函数声明
+esp_err_t ai_cache_init(void);
+bool ai_cache_lookup(const char *query, ai_response_t *response);
+void ai_cache_store(const char *query, const ai_response_t *response, uint32_t latency_ms);
+void ai_cache_clear(void);
+void ai_cache_get_stats(ai_cache_stats_t *stats);
+
+// 规范化查询 (去掉空白和标点、ASCII 转小写、全角字母数字转半角)，返回长度
+size_t ai_cache_normalize(const char *query, char *out, size_t out_size);
+
+#endif // AI_CACHE_H
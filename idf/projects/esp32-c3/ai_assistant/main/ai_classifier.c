@@ -0,0 +1,149 @@
+#include "ai_classifier.h"
+#include "ai_cache.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include <stdbool.h>
+#include <string.h>
+
+// 构建时由 tools/ai_classifier_train.py 训练生成 (int8 权重，放在 Flash 中)
+#include "ai_classifier_model.h"
+
+// 首尾标记 (规范化后的文本中不会出现控制字符)
+#define CLASSIFIER_BOS  0x02
+#define CLASSIFIER_EOS  0x03
+
+// 统计
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t runs = 0;
+static uint32_t accepted = 0;
+static uint32_t rejected = 0;
+static uint64_t us_sum = 0;
+static uint32_t us_max = 0;
+
+// UTF-8 字符的字节数 (非法的首字节按单字节处理)
+static inline size_t utf8_len(uint8_t c)
+{
+    if (c >= 0xF0) {
+        return 4;
+    }
+    if (c >= 0xE0) {
+        return 3;
+    }
+    if (c >= 0xC0) {
+        return 2;
+    }
+    return 1;
+}
+
+// n-gram 的哈希桶 (FNV-1a，先混入 n 区分不同长度)
+static inline uint32_t ngram_bucket(int n, const uint8_t *data, size_t len)
+{
+    uint32_t h = (0x811C9DC5u ^ (uint32_t)n) * 0x01000193u;
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ data[i]) * 0x01000193u;
+    }
+    return (h ^ (h >> 15)) & (AI_CLASSIFIER_NUM_BUCKETS - 1);
+}
+
+// 整数推理，返回类别下标，没有特征时返回 -1
+static int classify(const char *text, uint8_t *confidence)
+{
+    // 与回复缓存相同的规范化，前后加标记: [BOS] 文本 [EOS]
+    uint8_t buf[512 + 2];
+    buf[0] = CLASSIFIER_BOS;
+    size_t len = ai_cache_normalize(text, (char *)buf + 1, sizeof(buf) - 2);
+    if (len == 0) {
+        return -1;
+    }
+    size_t total = len + 2;
+    buf[total - 1] = CLASSIFIER_EOS;
+
+    // 每个 1~3 字符的片段查一行权重 (各类别连续存放)，累加到各类别
+    int32_t acc[AI_CLASSIFIER_NUM_CLASSES] = {0};
+    int32_t count = 0;
+    for (size_t i = 0; i < total; i += utf8_len(buf[i])) {
+        size_t end = i;
+        for (int n = 1; n <= AI_CLASSIFIER_MAX_NGRAM && end < total; n++) {
+            end += utf8_len(buf[end]);
+            if (end > total) {
+                end = total;
+            }
+            if (n == 1 && (i == 0 || end == total)) {
+                continue;   // 首尾标记本身不是特征
+            }
+            const int8_t *row = ai_classifier_weights[ngram_bucket(n, buf + i, end - i)];
+            for (int c = 0; c < AI_CLASSIFIER_NUM_CLASSES; c++) {
+                acc[c] += row[c];
+            }
+            count++;
+        }
+    }
+
+    // 权重取平均: 各类别 logit = (累加值 + 特征数 × 偏置) / 特征数，比较时不需要做除法
+    int best = 0;
+    for (int c = 0; c < AI_CLASSIFIER_NUM_CLASSES; c++) {
+        acc[c] += count * ai_classifier_bias[c];
+        if (acc[c] > acc[best]) {
+            best = c;
+        }
+    }
+
+    // softmax 中最高类别的概率: 1 / Σ exp(logit_c - logit_best)，exp 查表
+    uint32_t sum = 0;
+    for (int c = 0; c < AI_CLASSIFIER_NUM_CLASSES; c++) {
+        uint32_t k = (uint32_t)(((int64_t)(acc[best] - acc[c]) * AI_CLASSIFIER_LOGIT_Q16 / count) >> 16);
+        if (k < AI_CLASSIFIER_EXP_SIZE) {
+            sum += ai_classifier_exp[k];
+        }
+    }
+    *confidence = (uint8_t)(ai_classifier_exp[0] * 100u / sum);
+    return best;
+}
+
+int ai_classifier_predict(const char *text, ai_classifier_result_t *result)
+{
+    ai_classifier_result_t local;
+    if (result == NULL) {
+        result = &local;
+    }
+    result->intent = AI_INTENT_NONE;
+    result->confidence = 0;
+    if (text == NULL) {
+        return AI_INTENT_NONE;
+    }
+
+    int64_t start = esp_timer_get_time();
+    int cls = classify(text, &result->confidence);
+    uint32_t us = (uint32_t)(esp_timer_get_time() - start);
+
+    if (cls >= 0) {
+        result->intent = ai_classifier_intents[cls];
+    }
+    bool ok = result->intent != AI_INTENT_NONE && result->confidence >= AI_CLASSIFIER_MIN_CONFIDENCE;
+
+    portENTER_CRITICAL(&stats_lock);
+    runs++;
+    if (ok) {
+        accepted++;
+    } else if (result->intent != AI_INTENT_NONE) {
+        rejected++;
+    }
+    us_sum += us;
+    if (us > us_max) {
+        us_max = us;
+    }
+    portEXIT_CRITICAL(&stats_lock);
+
+    return ok ? result->intent : AI_INTENT_NONE;
+}
+
+void ai_classifier_get_stats(ai_classifier_stats_t *stats)
+{
+    portENTER_CRITICAL(&stats_lock);
+    stats->runs = runs;
+    stats->accepted = accepted;
+    stats->rejected = rejected;
+    stats->avg_us = runs ? (uint32_t)(us_sum / runs) : 0;
+    stats->max_us = us_max;
+    portEXIT_CRITICAL(&stats_lock);
+}
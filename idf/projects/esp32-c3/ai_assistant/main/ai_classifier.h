@@ -0,0 +1,31 @@
+#ifndef AI_CLASSIFIER_H
+#define AI_CLASSIFIER_H
+
+#include <stdint.h>
+#include "ai_intent.h"
+
+// 置信度低于此值 (百分比) 时不在本地处理，交给后端
+#define AI_CLASSIFIER_MIN_CONFIDENCE    50
+
+// 分类结果
+typedef struct {
+    int intent;                 // 得分最高的意图，AI_INTENT_NONE 表示其他 (交给后端) 或文本为空
+    uint8_t confidence;         // 置信度 (百分比)
+} ai_classifier_result_t;
+
+// 分类器统计
+typedef struct {
+    uint32_t runs;
+    uint32_t accepted;          // 置信度达到阈值、在本地处理的次数
+    uint32_t rejected;          // 置信度不够，交给后端的次数
+    uint32_t avg_us;            // 单次推理耗时
+    uint32_t max_us;
+} ai_classifier_stats_t;
+
+// 用字符 n-gram 线性模型判断意图 (关键词规则没有命中时的后备，模型由 ai_classifier_data.txt 训练)；
+// 返回达到置信度阈值的意图，否则返回 AI_INTENT_NONE。result 可以为 NULL
+int ai_classifier_predict(const char *text, ai_classifier_result_t *result);
+
+void ai_classifier_get_stats(ai_classifier_stats_t *stats);
+
+#endif // AI_CLASSIFIER_H
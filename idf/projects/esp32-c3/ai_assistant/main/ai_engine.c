@@ -1,7 +1,11 @@
 #include "ai_engine.h"
+#include "ai_intent.h"
+#include "ai_classifier.h"
+#include "ai_llm.h"
+#include "ai_cache.h"
+#include "ai_memory.h"
+#include "esp_timer.h"
 #include "esp_log.h"
-#include "esp_http_client.h"
-#include "cJSON.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "time.h"
@@ -11,26 +15,6 @@
 static const char *TAG = "AI_ENGINE";
 
 static ai_personality_t current_config;
-static esp_http_client_handle_t http_client = NULL;
-
-// HTTP响应回调
-static esp_err_t http_event_handler(esp_http_client_event_t *evt)
-{
-    switch (evt->event_id) {
-        case HTTP_EVENT_ERROR:
-            ESP_LOGE(TAG, "HTTP错误");
-            break;
-        case HTTP_EVENT_ON_CONNECTED:
-            ESP_LOGI(TAG, "HTTP连接成功");
-            break;
-        case HTTP_EVENT_ON_FINISH:
-            ESP_LOGI(TAG, "HTTP请求完成");
-            break;
-        default:
-            break;
-    }
-    return ESP_OK;
-}
 
 esp_err_t ai_engine_init(ai_personality_t *config)
 {
@@ -40,17 +24,25 @@ esp_err_t ai_engine_init(ai_personality_t *config)
     
     memcpy(&current_config, config, sizeof(ai_personality_t));
     
-    // 初始化HTTP客户端
-    esp_http_client_config_t http_config = {
-        .url = "https://api.openai.com",
-        .event_handler = http_event_handler,
-        .timeout_ms = 10000,
-    };
+    // 大模型后端 (连接在第一次请求时建立，之后保持)
+    esp_err_t ret = ai_llm_init();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "大模型后端初始化失败");
+        return ret;
+    }
     
-    http_client = esp_http_client_init(&http_config);
-    if (http_client == NULL) {
-        ESP_LOGE(TAG, "HTTP客户端初始化失败");
-        return ESP_FAIL;
+    // 后端回复缓存 (相同问题不再请求后端)
+    ret = ai_cache_init();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "回复缓存初始化失败");
+        return ret;
+    }
+    
+    // 对话记忆 (每个会话最近几轮，随请求发给后端)
+    ret = ai_memory_init();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "对话记忆初始化失败");
+        return ret;
     }
     
     ESP_LOGI(TAG, "AI引擎初始化完成");
@@ -60,7 +52,16 @@ esp_err_t ai_engine_init(ai_personality_t *config)
     return ESP_OK;
 }
 
+static esp_err_t ai_respond_api(const ai_memory_context_t *ctx, const char *query, ai_response_t *response,
+                                ai_llm_token_cb_t on_token, void *arg);
+
 esp_err_t ai_process_command(const char *command, ai_response_t *response)
+{
+    return ai_process_command_stream(AI_MEMORY_NO_SESSION, command, response, NULL, NULL);
+}
+
+esp_err_t ai_process_command_stream(uint32_t session, const char *command, ai_response_t *response,
+                                    ai_llm_token_cb_t on_token, void *arg)
 {
     if (command == NULL || response == NULL) {
         return ESP_ERR_INVALID_ARG;
@@ -68,13 +69,70 @@ esp_err_t ai_process_command(const char *command, ai_response_t *response)
     
     ESP_LOGI(TAG, "处理命令: %s", command);
     
-    // 首先尝试本地命令处理
-    if (ai_process_local_command(command, response) == ESP_OK) {
-        return ESP_OK;
+    // 本地回复也记入对话，后端能看到完整的上下文
+    ai_memory_context_t ctx;
+    ai_memory_begin(session, &ctx);
+    
+    // 首先尝试本地命令处理 (完整回复一次给出，不经过 on_token)
+    esp_err_t ret = ai_process_local_command(command, response);
+    if (ret != ESP_OK) {
+        // 如果本地处理失败，尝试API调用
+        ret = ai_respond_api(&ctx, command, response, on_token, arg);
     }
     
-    // 如果本地处理失败，尝试API调用
-    return ai_get_response_from_api(command, response);
+    // 默认回复 (后端不可用) 不记入对话
+    bool record = strcmp(response->action, "api_fallback") != 0;
+    ai_memory_end(&ctx, command, record ? response->text : NULL);
+    return ret;
+}
+
+// 意图的固定回复
+static void ai_reply(ai_response_t *response, const char *text, const char *action,
+                     int confidence, const char *emotion)
+{
+    strlcpy(response->text, text, sizeof(response->text));
+    strlcpy(response->action, action, sizeof(response->action));
+    response->confidence = confidence;
+    strlcpy(response->emotion, emotion, sizeof(response->emotion));
+}
+
+// 按匹配到的意图生成回复 (命令只扫描一次)
+static esp_err_t ai_respond_intent(int intent, const char *command, ai_response_t *response)
+{
+    switch (intent) {
+        case AI_INTENT_TIME:
+            return ai_handle_time_query(command, response);
+        case AI_INTENT_WEATHER:
+            return ai_handle_weather_query(command, response);
+        case AI_INTENT_LIGHT_ON:
+            ai_reply(response, "好的，正在为您开灯", "light_on", 85, "helpful");
+            return ESP_OK;
+        case AI_INTENT_LIGHT_OFF:
+            ai_reply(response, "好的，正在为您关灯", "light_off", 85, "helpful");
+            return ESP_OK;
+        case AI_INTENT_MUSIC_PLAY:
+            ai_reply(response, "好的，正在为您播放音乐", "music_play", 85, "helpful");
+            return ESP_OK;
+        case AI_INTENT_MUSIC_PAUSE:
+            ai_reply(response, "好的，已暂停音乐播放", "music_pause", 85, "helpful");
+            return ESP_OK;
+        case AI_INTENT_GREETING:
+            snprintf(response->text, sizeof(response->text), 
+                    "你好！我是%s，很高兴为您服务。有什么可以帮助您的吗？", current_config.name);
+            strlcpy(response->action, "greeting", sizeof(response->action));
+            response->confidence = 95;
+            strlcpy(response->emotion, "happy", sizeof(response->emotion));
+            return ESP_OK;
+        case AI_INTENT_HELP:
+            ai_reply(response, "我可以帮您：\n1. 查询时间和天气\n2. 控制智能设备\n3. 播放音乐\n4. 聊天对话\n5. 回答问题\n请告诉我您需要什么帮助？",
+                     "help", 90, "helpful");
+            return ESP_OK;
+        case AI_INTENT_REALTIME:
+        case AI_INTENT_CREATIVE:
+            return ESP_FAIL;    // 没有本地回复，交给后端
+        default:
+            return ESP_FAIL;
+    }
 }
 
 esp_err_t ai_process_local_command(const char *command, ai_response_t *response)
@@ -83,58 +141,23 @@ esp_err_t ai_process_local_command(const char *command, ai_response_t *response)
         return ESP_ERR_INVALID_ARG;
     }
     
-    // 转换为小写进行比较
-    char cmd_lower[256];
-    strcpy(cmd_lower, command);
-    for (int i = 0; cmd_lower[i]; i++) {
-        cmd_lower[i] = tolower(cmd_lower[i]);
-    }
-    
-    // 时间查询
-    if (strstr(cmd_lower, "时间") || strstr(cmd_lower, "几点") || strstr(cmd_lower, "time")) {
-        return ai_handle_time_query(command, response);
-    }
-    
-    // 天气查询
-    if (strstr(cmd_lower, "天气") || strstr(cmd_lower, "weather")) {
-        return ai_handle_weather_query(command, response);
-    }
-    
-    // 设备控制
-    if (strstr(cmd_lower, "开灯") || strstr(cmd_lower, "关灯") || 
-        strstr(cmd_lower, "turn on") || strstr(cmd_lower, "turn off")) {
-        return ai_handle_device_control(command, response);
-    }
-    
-    // 音乐控制
-    if (strstr(cmd_lower, "播放") || strstr(cmd_lower, "暂停") || 
-        strstr(cmd_lower, "play") || strstr(cmd_lower, "pause")) {
-        return ai_handle_music_control(command, response);
+    // 关键词自动机一次扫描，按得分选出意图 (注册表见 ai_intents.txt)
+    ai_intent_result_t match;
+    int intent = ai_intent_match(command, &match);
+    if (intent == AI_INTENT_NONE) {
+        // 关键词没有命中时用分类器识别换了说法的命令，置信度不够时交给后端
+        ai_classifier_result_t guess;
+        intent = ai_classifier_predict(command, &guess);
+        if (intent == AI_INTENT_NONE) {
+            return ESP_FAIL; // 本地无法处理
+        }
+        ESP_LOGI(TAG, "分类器意图: %s (置信度 %u%%)", ai_intent_name(intent), guess.confidence);
+        return ai_respond_intent(intent, command, response);
     }
     
-    // 问候语
-    if (strstr(cmd_lower, "你好") || strstr(cmd_lower, "hello") || 
-        strstr(cmd_lower, "hi") || strstr(cmd_lower, "小智")) {
-        snprintf(response->text, sizeof(response->text), 
-                "你好！我是%s，很高兴为您服务。有什么可以帮助您的吗？", current_config.name);
-        strcpy(response->action, "greeting");
-        response->confidence = 95;
-        strcpy(response->emotion, "happy");
-        return ESP_OK;
-    }
-    
-    // 帮助信息
-    if (strstr(cmd_lower, "帮助") || strstr(cmd_lower, "help") || 
-        strstr(cmd_lower, "能做什么")) {
-        snprintf(response->text, sizeof(response->text), 
-                "我可以帮您：\n1. 查询时间和天气\n2. 控制智能设备\n3. 播放音乐\n4. 聊天对话\n5. 回答问题\n请告诉我您需要什么帮助？");
-        strcpy(response->action, "help");
-        response->confidence = 90;
-        strcpy(response->emotion, "helpful");
-        return ESP_OK;
-    }
-    
-    return ESP_FAIL; // 本地无法处理
+    ESP_LOGI(TAG, "本地意图: %s (得分 %u, 命中 %u 个关键词)",
+             ai_intent_name(intent), match.score, match.hits);
+    return ai_respond_intent(intent, command, response);
 }
 
 esp_err_t ai_handle_time_query(const char *query, ai_response_t *response)
@@ -158,6 +181,11 @@ esp_err_t ai_handle_time_query(const char *query, ai_response_t *response)
 
 esp_err_t ai_handle_weather_query(const char *query, ai_response_t *response)
 {
+    // 配置了大模型后端时交给后端回答 (回复按较短的有效期缓存)
+    if (ai_llm_is_configured()) {
+        return ESP_FAIL;
+    }
+    
     // 这里可以集成天气API，暂时返回模拟数据
     snprintf(response->text, sizeof(response->text), 
             "抱歉，天气查询功能正在开发中。目前无法获取实时天气信息。");
@@ -170,57 +198,36 @@ esp_err_t ai_handle_weather_query(const char *query, ai_response_t *response)
 
 esp_err_t ai_handle_device_control(const char *command, ai_response_t *response)
 {
-    char cmd_lower[256];
-    strcpy(cmd_lower, command);
-    for (int i = 0; cmd_lower[i]; i++) {
-        cmd_lower[i] = tolower(cmd_lower[i]);
-    }
+    ai_intent_result_t match;
+    ai_intent_match(command, &match);
     
-    if (strstr(cmd_lower, "开灯") || strstr(cmd_lower, "turn on")) {
-        snprintf(response->text, sizeof(response->text), 
-                "好的，正在为您开灯");
-        strcpy(response->action, "light_on");
-    } else if (strstr(cmd_lower, "关灯") || strstr(cmd_lower, "turn off")) {
-        snprintf(response->text, sizeof(response->text), 
-                "好的，正在为您关灯");
-        strcpy(response->action, "light_off");
-    } else {
-        snprintf(response->text, sizeof(response->text), 
-                "抱歉，我没有理解您的设备控制指令");
-        strcpy(response->action, "unknown");
+    // 开灯和关灯同时出现时取得分高的，相同时开灯优先
+    if (match.scores[AI_INTENT_LIGHT_ON] > 0 &&
+        match.scores[AI_INTENT_LIGHT_ON] >= match.scores[AI_INTENT_LIGHT_OFF]) {
+        return ai_respond_intent(AI_INTENT_LIGHT_ON, command, response);
+    }
+    if (match.scores[AI_INTENT_LIGHT_OFF] > 0) {
+        return ai_respond_intent(AI_INTENT_LIGHT_OFF, command, response);
     }
     
-    response->confidence = 85;
-    strcpy(response->emotion, "helpful");
-    
+    ai_reply(response, "抱歉，我没有理解您的设备控制指令", "unknown", 85, "helpful");
     return ESP_OK;
 }
 
 esp_err_t ai_handle_music_control(const char *command, ai_response_t *response)
 {
-    char cmd_lower[256];
-    strcpy(cmd_lower, command);
-    for (int i = 0; cmd_lower[i]; i++) {
-        cmd_lower[i] = tolower(cmd_lower[i]);
-    }
+    ai_intent_result_t match;
+    ai_intent_match(command, &match);
     
-    if (strstr(cmd_lower, "播放") || strstr(cmd_lower, "play")) {
-        snprintf(response->text, sizeof(response->text), 
-                "好的，正在为您播放音乐");
-        strcpy(response->action, "music_play");
-    } else if (strstr(cmd_lower, "暂停") || strstr(cmd_lower, "pause")) {
-        snprintf(response->text, sizeof(response->text), 
-                "好的，已暂停音乐播放");
-        strcpy(response->action, "music_pause");
-    } else {
-        snprintf(response->text, sizeof(response->text), 
-                "抱歉，我没有理解您的音乐控制指令");
-        strcpy(response->action, "unknown");
+    if (match.scores[AI_INTENT_MUSIC_PLAY] > 0 &&
+        match.scores[AI_INTENT_MUSIC_PLAY] >= match.scores[AI_INTENT_MUSIC_PAUSE]) {
+        return ai_respond_intent(AI_INTENT_MUSIC_PLAY, command, response);
+    }
+    if (match.scores[AI_INTENT_MUSIC_PAUSE] > 0) {
+        return ai_respond_intent(AI_INTENT_MUSIC_PAUSE, command, response);
     }
     
-    response->confidence = 85;
-    strcpy(response->emotion, "helpful");
-    
+    ai_reply(response, "抱歉，我没有理解您的音乐控制指令", "unknown", 85, "helpful");
     return ESP_OK;
 }
 
@@ -249,8 +256,67 @@ esp_err_t ai_handle_chat(const char *message, ai_response_t *response)
 
 esp_err_t ai_get_response_from_api(const char *query, ai_response_t *response)
 {
-    // 这里可以集成OpenAI API或其他AI服务
-    // 暂时返回默认回复
+    return ai_get_response_from_api_stream(AI_MEMORY_NO_SESSION, query, response, NULL, NULL);
+}
+
+esp_err_t ai_get_response_from_api_stream(uint32_t session, const char *query, ai_response_t *response,
+                                          ai_llm_token_cb_t on_token, void *arg)
+{
+    ai_memory_context_t ctx;
+    ai_memory_begin(session, &ctx);
+    esp_err_t ret = ai_respond_api(&ctx, query, response, on_token, arg);
+    bool record = strcmp(response->action, "api_fallback") != 0;
+    ai_memory_end(&ctx, query, record ? response->text : NULL);
+    return ret;
+}
+
+static esp_err_t ai_respond_api(const ai_memory_context_t *ctx, const char *query, ai_response_t *response,
+                                ai_llm_token_cb_t on_token, void *arg)
+{
+    if (ai_llm_is_configured()) {
+        // 带上下文的问题 (如"那明天呢") 的回复依赖之前的对话，不查也不存缓存
+        bool contextual = ctx->turns > 0 || ctx->summary[0] != '\0';
+        
+        // 相同的问题 (忽略空白、标点和大小写) 直接使用缓存的回复，整段作为一个 token 推送
+        if (!contextual && ai_cache_lookup(query, response)) {
+            if (on_token != NULL) {
+                on_token(response->text, strlen(response->text), arg);
+            }
+            return ESP_OK;
+        }
+        
+        // 较早的对话只保留了问题的摘要，附在系统提示后面
+        char system_prompt[320 + AI_MEMORY_SUMMARY_BYTES + 32];
+        int n = snprintf(system_prompt, sizeof(system_prompt), "你是%s。%s请用简短的中文回答。",
+                         current_config.name, current_config.personality);
+        if (ctx->summary[0] != '\0' && n > 0 && n < (int)sizeof(system_prompt)) {
+            snprintf(system_prompt + n, sizeof(system_prompt) - n, "之前用户问过：%s。", ctx->summary);
+        }
+        
+        response->text[0] = '\0';
+        int64_t start_us = esp_timer_get_time();
+        esp_err_t ret = ai_llm_chat(system_prompt, ctx->messages, ctx->messages_len, query, on_token, arg,
+                                    response->text, sizeof(response->text));
+        if (ret == ESP_OK) {
+            strcpy(response->action, "chat");
+            response->confidence = 90;
+            strcpy(response->emotion, "friendly");
+            if (!contextual) {
+                ai_cache_store(query, response, (uint32_t)((esp_timer_get_time() - start_us) / 1000));
+            }
+            return ESP_OK;
+        }
+        // 已经推送过部分 token 时不再改用默认回复
+        if (response->text[0] != '\0') {
+            strcpy(response->action, "chat");
+            response->confidence = 50;
+            strcpy(response->emotion, "thoughtful");
+            return ret;
+        }
+        ESP_LOGW(TAG, "大模型请求失败: %s，使用默认回复", esp_err_to_name(ret));
+    }
+    
+    // 未配置后端或请求失败，返回默认回复
     snprintf(response->text, sizeof(response->text), 
             "我理解您的问题，但需要连接到AI服务来提供更准确的回答。您可以尝试一些本地功能，比如查询时间或控制设备。");
     strcpy(response->action, "api_fallback");
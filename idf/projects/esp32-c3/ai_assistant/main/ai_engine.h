@@ -1,8 +1,9 @@
 #ifndef AI_ENGINE_H
 #define AI_ENGINE_H
 
+#include <stdint.h>
 #include "esp_err.h"
-#include "esp_http_client.h"
+#include "ai_llm.h"
 
 // AI响应结构体
 typedef struct {
@@ -30,8 +31,13 @@ typedef struct {
 // 函数声明
 esp_err_t ai_engine_init(ai_personality_t *config);
 esp_err_t ai_process_command(const char *command, ai_response_t *response);
+// session 为对话会话 (见 ai_memory.h)，同一会话的请求附带之前几轮对话；AI_MEMORY_NO_SESSION (0) 表示不使用
+esp_err_t ai_process_command_stream(uint32_t session, const char *command, ai_response_t *response,
+                                    ai_llm_token_cb_t on_token, void *arg);
 esp_err_t ai_set_personality(ai_personality_t *config);
 esp_err_t ai_get_response_from_api(const char *query, ai_response_t *response);
+esp_err_t ai_get_response_from_api_stream(uint32_t session, const char *query, ai_response_t *response,
+                                          ai_llm_token_cb_t on_token, void *arg);
 esp_err_t ai_process_local_command(const char *command, ai_response_t *response);
 
 // 本地命令处理函数
@@ -0,0 +1,58 @@
+#include "ai_intent.h"
+#include <string.h>
+
+#define AI_INTENT_TABLE_IMPL
+#include "ai_intent_table.h"
+
+// ASCII 字母或数字 (整词匹配的边界判断，UTF-8 多字节字符视为边界)
+static inline int is_word_byte(uint8_t c)
+{
+    return (c >= '0' && c <= '9') || ((c | 0x20) >= 'a' && (c | 0x20) <= 'z');
+}
+
+int ai_intent_match(const char *text, ai_intent_result_t *result)
+{
+    memset(result, 0, sizeof(*result));
+    result->intent = AI_INTENT_NONE;
+    if (text == NULL) {
+        return AI_INTENT_NONE;
+    }
+
+    // 每个字节查一次转移表，命中的关键词已按状态展开，不需要回退
+    const uint8_t *p = (const uint8_t *)text;
+    ai_intent_state_t state = 0;
+    for (size_t i = 0; p[i] != '\0'; i++) {
+        state = ai_intent_delta[state][ai_intent_byte_class[p[i]]];
+
+        for (uint16_t k = ai_intent_out_start[state]; k < ai_intent_out_start[state + 1]; k++) {
+            const ai_intent_kw_t kw = ai_intent_out_list[k];
+            const uint8_t len = ai_intent_keywords[kw].len;
+            if (ai_intent_keywords[kw].whole_word &&
+                ((i + 1 > len && is_word_byte(p[i - len])) || is_word_byte(p[i + 1]))) {
+                continue;
+            }
+
+            uint8_t intent = ai_intent_keywords[kw].intent;
+            uint32_t score = result->scores[intent] + ai_intent_keywords[kw].weight;
+            result->scores[intent] = score > UINT16_MAX ? UINT16_MAX : (uint16_t)score;
+            result->hits++;
+        }
+    }
+
+    // 得分相同时注册顺序靠前的意图优先
+    for (int i = 0; i < AI_INTENT_COUNT; i++) {
+        if (result->scores[i] > result->score) {
+            result->score = result->scores[i];
+            result->intent = i;
+        }
+    }
+    return result->intent;
+}
+
+const char *ai_intent_name(int intent)
+{
+    if (intent < 0 || intent >= AI_INTENT_COUNT) {
+        return "none";
+    }
+    return ai_intent_names[intent];
+}
@@ -0,0 +1,25 @@
+#ifndef AI_INTENT_H
+#define AI_INTENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ai_intent_table.h"    // 构建时由 ai_intents.txt 生成 (AI_INTENT_xxx)
+
+// 没有命中任何关键词
+#define AI_INTENT_NONE  (-1)
+
+// 意图匹配结果
+typedef struct {
+    int intent;                         // 得分最高的意图，AI_INTENT_NONE 表示未命中
+    uint16_t score;                     // 该意图的得分
+    uint16_t hits;                      // 命中的关键词总数
+    uint16_t scores[AI_INTENT_COUNT];   // 各意图得分 (命中关键词权重之和)
+} ai_intent_result_t;
+
+// 一次扫描 UTF-8 文本，找出全部关键词并为各意图计分 (ASCII 字母不区分大小写)
+int ai_intent_match(const char *text, ai_intent_result_t *result);
+
+// 意图名称 (注册表中的名字)
+const char *ai_intent_name(int intent);
+
+#endif // AI_INTENT_H
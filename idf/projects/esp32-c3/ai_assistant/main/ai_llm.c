@@ -0,0 +1,466 @@
+#include "ai_llm.h"
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_http_client.h"
+#include "esp_crt_bundle.h"
+#include "esp_timer.h"
+#include "cJSON.h"
+#include "json_writer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <string.h>
+#include <stdlib.h>
+
+static const char *TAG = "AI_LLM";
+
+// SSE 单行上限 (一个事件的 JSON)，超长的行丢弃
+#define LLM_LINE_MAX    1024
+
+// 每次从连接读取的字节数
+#define LLM_READ_BUF    512
+
+// 后端配置，默认值来自 menuconfig (url 为空时不使用后端)
+static ai_llm_config_t llm_config = {
+    .url = CONFIG_AI_LLM_URL,
+    .api_key = CONFIG_AI_LLM_API_KEY,
+    .model = CONFIG_AI_LLM_MODEL,
+    .max_tokens = CONFIG_AI_LLM_MAX_TOKENS,
+    .timeout_ms = CONFIG_AI_LLM_TIMEOUT_MS,
+    .idle_timeout_ms = CONFIG_AI_LLM_IDLE_TIMEOUT_MS,
+};
+
+// 保持的 HTTP(S) 连接，请求之间不关闭
+static esp_http_client_handle_t client = NULL;
+static SemaphoreHandle_t llm_lock = NULL;
+
+// 统计 (单独的锁，读取统计不必等待正在进行的请求)
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static ai_llm_stats_t stats;
+static uint64_t ttft_sum_ms = 0;
+static uint32_t ttft_count = 0;
+
+// 本次请求新建了连接
+static bool connected_now = false;
+
+// 流式响应解析状态 (请求串行执行，放在静态区避免占用任务栈)
+static struct {
+    char line[LLM_LINE_MAX];
+    size_t len;
+    bool overflow;
+    bool done;
+    esp_err_t cb_err;
+    ai_llm_token_cb_t on_token;
+    void *arg;
+    char *text;
+    size_t text_size;
+    size_t text_len;
+    uint32_t tokens;
+    int64_t start_us;
+    int64_t first_token_us;
+} stream;
+
+// HTTP事件回调
+static esp_err_t llm_http_event_handler(esp_http_client_event_t *evt)
+{
+    switch (evt->event_id) {
+        case HTTP_EVENT_ON_CONNECTED:
+            connected_now = true;
+            break;
+        case HTTP_EVENT_DISCONNECTED:
+            ESP_LOGD(TAG, "后端连接已关闭");
+            break;
+        default:
+            break;
+    }
+    return ESP_OK;
+}
+
+// 创建客户端 (首次请求或配置变化后)
+static esp_err_t llm_client_create(void)
+{
+    esp_http_client_config_t http_config = {
+        .url = llm_config.url,
+        .method = HTTP_METHOD_POST,
+        .event_handler = llm_http_event_handler,
+        .timeout_ms = llm_config.idle_timeout_ms,
+        .buffer_size = 1024,
+        .buffer_size_tx = 1024,
+        .keep_alive_enable = true,              // TCP 保活，及早发现失效的空闲连接
+        .crt_bundle_attach = esp_crt_bundle_attach,
+#ifdef CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+        .save_client_session = true,            // 重连时复用 TLS 会话，省去完整握手
+#endif
+    };
+
+    client = esp_http_client_init(&http_config);
+    if (client == NULL) {
+        ESP_LOGE(TAG, "HTTP客户端初始化失败");
+        return ESP_FAIL;
+    }
+
+    esp_http_client_set_header(client, "Content-Type", "application/json");
+    esp_http_client_set_header(client, "Accept", "text/event-stream");
+    if (llm_config.api_key[0] != '\0') {
+        char auth[160];
+        snprintf(auth, sizeof(auth), "Bearer %s", llm_config.api_key);
+        esp_http_client_set_header(client, "Authorization", auth);
+    }
+    return ESP_OK;
+}
+
+// 本次请求的内容 (请求体按需生成，不整体保存)
+typedef struct {
+    const char *system_prompt;
+    const char *history;        // 已编码的历史消息 (逗号分隔)
+    size_t history_len;
+    const char *query;
+} llm_request_t;
+
+// 生成请求体：历史消息原样插入，不重新编码
+static void llm_write_body(json_writer_t *w, const llm_request_t *request)
+{
+    json_writer_begin_object(w, NULL);
+    json_writer_string(w, "model", llm_config.model);
+    json_writer_bool(w, "stream", true);
+    json_writer_int(w, "max_tokens", llm_config.max_tokens);
+
+    json_writer_begin_array(w, "messages");
+    if (request->system_prompt != NULL && request->system_prompt[0] != '\0') {
+        json_writer_begin_object(w, NULL);
+        json_writer_string(w, "role", "system");
+        json_writer_string(w, "content", request->system_prompt);
+        json_writer_end_object(w);
+    }
+    if (request->history != NULL && request->history_len > 0) {
+        json_writer_raw(w, NULL, request->history, request->history_len);
+    }
+    json_writer_begin_object(w, NULL);
+    json_writer_string(w, "role", "user");
+    json_writer_string(w, "content", request->query);
+    json_writer_end_object(w);
+    json_writer_end_array(w);
+
+    json_writer_end_object(w);
+}
+
+static int llm_count_flush(void *ctx, const char *data, size_t len)
+{
+    return 0;
+}
+
+static int llm_write_flush(void *ctx, const char *data, size_t len)
+{
+    return esp_http_client_write((esp_http_client_handle_t)ctx, data, len) == (int)len ? 0 : -1;
+}
+
+// 请求体长度 (Content-Length)：先生成一遍只计数
+static size_t llm_body_length(const llm_request_t *request)
+{
+    char buf[128];
+    json_writer_t w;
+    json_writer_init(&w, buf, sizeof(buf), llm_count_flush, NULL);
+    llm_write_body(&w, request);
+    json_writer_finish(&w);
+    return w.total;
+}
+
+// 发送请求并读取响应头 (请求体经小缓冲区直接写入连接)
+static esp_err_t llm_send_request(const llm_request_t *request, size_t body_len)
+{
+    // 保持的连接可能已被服务器关闭：在复用的连接上失败时关闭后重连一次，
+    // 新建的连接上失败不重试 (请求可能已被处理)
+    for (int attempt = 0; attempt < 2; attempt++) {
+        connected_now = false;
+        esp_err_t err = esp_http_client_open(client, body_len);
+        if (connected_now) {
+            portENTER_CRITICAL(&stats_lock);
+            stats.connects++;
+            portEXIT_CRITICAL(&stats_lock);
+        }
+        if (err == ESP_OK) {
+            char buf[256];
+            json_writer_t w;
+            json_writer_init(&w, buf, sizeof(buf), llm_write_flush, client);
+            llm_write_body(&w, request);
+            if (json_writer_finish(&w) && esp_http_client_fetch_headers(client) >= 0) {
+                return ESP_OK;
+            }
+        }
+
+        esp_http_client_close(client);
+        if (connected_now) {
+            ESP_LOGE(TAG, "请求失败: %s", esp_err_to_name(err));
+            break;
+        }
+        ESP_LOGI(TAG, "保持的连接已失效，重新连接");
+    }
+    return ESP_FAIL;
+}
+
+// 输出一个 token
+static void llm_emit(const char *token, size_t len)
+{
+    if (stream.tokens++ == 0) {
+        stream.first_token_us = esp_timer_get_time();
+    }
+
+    // 累积完整回复，缓冲区满时截断在 UTF-8 字符边界
+    if (stream.text != NULL && stream.text_len + 1 < stream.text_size) {
+        size_t n = len;
+        if (stream.text_len + n + 1 > stream.text_size) {
+            n = stream.text_size - 1 - stream.text_len;
+            while (n > 0 && ((uint8_t)token[n] & 0xC0) == 0x80) {
+                n--;
+            }
+        }
+        memcpy(stream.text + stream.text_len, token, n);
+        stream.text_len += n;
+        stream.text[stream.text_len] = '\0';
+    }
+
+    if (stream.on_token != NULL && stream.cb_err == ESP_OK) {
+        stream.cb_err = stream.on_token(token, len, stream.arg);
+    }
+}
+
+// 处理一行 SSE 数据
+static void llm_handle_line(char *line)
+{
+    if (strncmp(line, "data:", 5) != 0) {
+        return;     // 空行 (事件分隔)、注释和其他字段
+    }
+    const char *data = line + 5;
+    if (*data == ' ') {
+        data++;
+    }
+    if (strcmp(data, "[DONE]") == 0) {
+        stream.done = true;
+        return;
+    }
+
+    cJSON *root = cJSON_Parse(data);
+    if (root == NULL) {
+        ESP_LOGW(TAG, "无法解析的事件: %.64s", data);
+        return;
+    }
+
+    cJSON *choices = cJSON_GetObjectItem(root, "choices");
+    cJSON *choice = cJSON_IsArray(choices) ? cJSON_GetArrayItem(choices, 0) : NULL;
+    cJSON *delta = choice ? cJSON_GetObjectItem(choice, "delta") : NULL;
+    cJSON *content = delta ? cJSON_GetObjectItem(delta, "content") : NULL;
+    if (cJSON_IsString(content) && content->valuestring[0] != '\0') {
+        llm_emit(content->valuestring, strlen(content->valuestring));
+    }
+
+    cJSON *error = cJSON_GetObjectItem(root, "error");
+    if (error != NULL) {
+        cJSON *msg = cJSON_GetObjectItem(error, "message");
+        ESP_LOGE(TAG, "后端错误: %s", cJSON_IsString(msg) ? msg->valuestring : "未知");
+        stream.done = true;
+    }
+    cJSON_Delete(root);
+}
+
+// 增量解析收到的数据 (事件可能跨越多次读取)
+static void llm_feed(const char *buf, int len)
+{
+    for (int i = 0; i < len && !stream.done && stream.cb_err == ESP_OK; i++) {
+        char c = buf[i];
+        if (c != '\n') {
+            if (stream.len + 1 < sizeof(stream.line)) {
+                stream.line[stream.len++] = c;
+            } else {
+                stream.overflow = true;
+            }
+            continue;
+        }
+
+        if (stream.len > 0 && stream.line[stream.len - 1] == '\r') {
+            stream.len--;
+        }
+        stream.line[stream.len] = '\0';
+        if (stream.overflow) {
+            ESP_LOGW(TAG, "事件超过 %d 字节，已丢弃", LLM_LINE_MAX);
+        } else {
+            llm_handle_line(stream.line);
+        }
+        stream.len = 0;
+        stream.overflow = false;
+    }
+}
+
+// 读取流式响应
+static esp_err_t llm_read_stream(void)
+{
+    char buf[LLM_READ_BUF];
+    int64_t deadline = stream.start_us + (int64_t)llm_config.timeout_ms * 1000;
+
+    while (!stream.done && stream.cb_err == ESP_OK) {
+        if (esp_timer_get_time() > deadline) {
+            ESP_LOGW(TAG, "请求超时 (%d ms)", llm_config.timeout_ms);
+            return ESP_ERR_TIMEOUT;
+        }
+
+        int n = esp_http_client_read(client, buf, sizeof(buf));
+        if (n > 0) {
+            llm_feed(buf, n);
+        } else if (n == 0 && esp_http_client_is_complete_data_received(client)) {
+            break;  // 服务器结束了响应 (没有 [DONE])
+        } else if (n == -ESP_ERR_HTTP_EAGAIN) {
+            ESP_LOGW(TAG, "%d ms 内没有收到数据", llm_config.idle_timeout_ms);
+            return ESP_ERR_TIMEOUT;
+        } else {
+            ESP_LOGE(TAG, "读取响应失败 (%d)", n);
+            return ESP_FAIL;
+        }
+    }
+    return stream.cb_err;
+}
+
+esp_err_t ai_llm_init(void)
+{
+    if (llm_lock == NULL) {
+        llm_lock = xSemaphoreCreateMutex();
+        if (llm_lock == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    if (ai_llm_is_configured()) {
+        ESP_LOGI(TAG, "大模型后端: %s (%s)", llm_config.url, llm_config.model);
+    } else {
+        ESP_LOGI(TAG, "未配置大模型后端，只使用本地回复");
+    }
+    return ESP_OK;
+}
+
+esp_err_t ai_llm_set_config(const ai_llm_config_t *config)
+{
+    if (config == NULL || config->timeout_ms <= 0 || config->idle_timeout_ms <= 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (llm_lock == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // 地址或令牌可能变化：关闭保持的连接，下次请求时重建
+    xSemaphoreTake(llm_lock, portMAX_DELAY);
+    memcpy(&llm_config, config, sizeof(llm_config));
+    if (client != NULL) {
+        esp_http_client_cleanup(client);
+        client = NULL;
+    }
+    xSemaphoreGive(llm_lock);
+
+    ESP_LOGI(TAG, "大模型后端配置已更新: %s", llm_config.url[0] ? llm_config.url : "(未使用)");
+    return ESP_OK;
+}
+
+bool ai_llm_is_configured(void)
+{
+    return llm_config.url[0] != '\0';
+}
+
+esp_err_t ai_llm_chat(const char *system_prompt, const char *history, size_t history_len,
+                      const char *query, ai_llm_token_cb_t on_token, void *arg,
+                      char *text, size_t text_size)
+{
+    if (query == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (llm_lock == NULL || !ai_llm_is_configured()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    llm_request_t request = {
+        .system_prompt = system_prompt,
+        .history = history,
+        .history_len = history_len,
+        .query = query,
+    };
+
+    xSemaphoreTake(llm_lock, portMAX_DELAY);
+
+    size_t body_len = llm_body_length(&request);
+
+    memset(&stream, 0, sizeof(stream));
+    stream.on_token = on_token;
+    stream.arg = arg;
+    stream.text = text;
+    stream.text_size = text_size;
+    if (text != NULL && text_size > 0) {
+        text[0] = '\0';
+    }
+    stream.start_us = esp_timer_get_time();
+
+    esp_err_t ret = (client == NULL) ? llm_client_create() : ESP_OK;
+    if (ret == ESP_OK) {
+        ret = llm_send_request(&request, body_len);
+    }
+
+    if (ret == ESP_OK) {
+        int status = esp_http_client_get_status_code(client);
+        if (status != 200) {
+            ESP_LOGE(TAG, "后端返回 HTTP %d", status);
+            ret = ESP_FAIL;
+            esp_http_client_flush_response(client, NULL);
+        } else {
+            ret = llm_read_stream();
+            if (ret == ESP_OK) {
+                // 读完结束块，连接留给下一次请求
+                esp_http_client_flush_response(client, NULL);
+            } else {
+                // 响应读到一半：连接无法复用
+                esp_http_client_close(client);
+            }
+        }
+    }
+
+    int64_t end_us = esp_timer_get_time();
+    // stream 由 llm_lock 保护，释放锁之前取出本次结果
+    uint32_t tokens = stream.tokens;
+    uint32_t ttft_ms = tokens > 0 ? (uint32_t)((stream.first_token_us - stream.start_us) / 1000) : 0;
+
+    portENTER_CRITICAL(&stats_lock);
+    stats.requests++;
+    stats.request_bytes = body_len;
+    stats.history_bytes = history_len;
+    if (ret != ESP_OK) {
+        stats.errors++;
+        if (ret == ESP_ERR_TIMEOUT) {
+            stats.timeouts++;
+        }
+    }
+    if (tokens > 0) {
+        stats.ttft_ms = ttft_ms;
+        ttft_sum_ms += ttft_ms;
+        ttft_count++;
+        stats.ttft_avg_ms = (uint32_t)(ttft_sum_ms / ttft_count);
+    }
+    stats.total_ms = (uint32_t)((end_us - stream.start_us) / 1000);
+    stats.tokens = tokens;
+    portEXIT_CRITICAL(&stats_lock);
+
+    ESP_LOGI(TAG, "回复完成: %lu 个token, 首token %lu ms, 总计 %lu ms, 请求 %u 字节 (历史 %u)%s",
+             (unsigned long)tokens, (unsigned long)ttft_ms,
+             (unsigned long)((end_us - stream.start_us) / 1000),
+             (unsigned)body_len, (unsigned)history_len, connected_now ? " (新连接)" : "");
+
+    xSemaphoreGive(llm_lock);
+
+    // 一个 token 都没收到视为失败
+    if (ret == ESP_OK && tokens == 0) {
+        ret = ESP_FAIL;
+    }
+    return ret;
+}
+
+void ai_llm_get_stats(ai_llm_stats_t *out)
+{
+    if (out == NULL) {
+        return;
+    }
+    portENTER_CRITICAL(&stats_lock);
+    *out = stats;
+    portEXIT_CRITICAL(&stats_lock);
+}
@@ -0,0 +1,46 @@
+#ifndef AI_LLM_H
+#define AI_LLM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+// 大模型后端配置 (OpenAI Chat Completions 兼容的流式接口)
+typedef struct {
+    char url[128];          // 接口地址，为空时不使用后端 (如 https://api.openai.com/v1/chat/completions)
+    char api_key[128];      // Bearer 令牌 (本地模拟服务可以为空)
+    char model[32];
+    int max_tokens;
+    int timeout_ms;         // 单次请求总超时 (从发出请求到收完最后一个 token)
+    int idle_timeout_ms;    // 两次收到数据之间的最长等待
+} ai_llm_config_t;
+
+// 后端统计
+typedef struct {
+    uint32_t requests;          // 请求次数
+    uint32_t errors;            // 失败次数 (含超时)
+    uint32_t timeouts;          // 超时次数
+    uint32_t connects;          // 新建连接次数 (其余请求复用了保持的连接)
+    uint32_t ttft_ms;           // 最近一次首 token 时间 (发出请求到收到第一个 token)
+    uint32_t ttft_avg_ms;       // 首 token 时间平均值
+    uint32_t total_ms;          // 最近一次完整回复耗时
+    uint32_t tokens;            // 最近一次回复的 token 数
+    uint32_t request_bytes;     // 最近一次请求体大小
+    uint32_t history_bytes;     // 其中附带的对话历史
+} ai_llm_stats_t;
+
+// 收到 token 时调用 (token 不以 '\0' 结尾)，返回非 ESP_OK 时取消本次请求
+typedef esp_err_t (*ai_llm_token_cb_t)(const char *token, size_t len, void *arg);
+
+// 函数声明
+esp_err_t ai_llm_init(void);
+esp_err_t ai_llm_set_config(const ai_llm_config_t *config);
+bool ai_llm_is_configured(void);
+// history 为已编码的历史消息 (逗号分隔的 {"role","content"} 对象，见 ai_memory)，可以为 NULL
+esp_err_t ai_llm_chat(const char *system_prompt, const char *history, size_t history_len,
+                      const char *query, ai_llm_token_cb_t on_token, void *arg,
+                      char *text, size_t text_size);
+void ai_llm_get_stats(ai_llm_stats_t *stats);
+
+#endif // AI_LLM_H
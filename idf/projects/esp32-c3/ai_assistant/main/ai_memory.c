@@ -0,0 +1,432 @@
+#include "ai_memory.h"
+#include "sdkconfig.h"
+#include "json_writer.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <stdbool.h>
+#include <string.h>
+
+static const char *TAG = "AI_MEMORY";
+
+// 编码后的消息中内容之前的部分 (取出摘要时跳过)
+#define USER_PREFIX_LEN         (sizeof("{\"role\":\"user\",\"content\":\"") - 1)
+
+// 中文分号，摘要中各个问题之间的分隔
+#define SUMMARY_SEP             "\xEF\xBC\x9B"
+#define SUMMARY_SEP_LEN         3
+
+// 每条消息的固定开销 (角色、格式) 按 token 计
+#define TURN_OVERHEAD_TOKENS    4
+
+// 一轮对话：arena 中 [offset, offset + len) 为编码后的消息对象加一个逗号
+typedef struct {
+    uint16_t offset;
+    uint16_t len;
+    uint16_t tokens;
+    bool user;
+} memory_turn_t;
+
+// 会话：各轮按时间顺序连续存放，丢弃最早的轮次时整体前移 (最多一个 arena 的复制)
+typedef struct {
+    uint32_t id;                // 0 为空位
+    bool busy;                  // 请求进行中 (不会被淘汰)
+    bool forget;                // 进行中被要求释放，请求结束时释放
+    uint8_t count;
+    uint16_t used;
+    uint16_t summary_len;
+    int64_t last_used_us;
+    memory_turn_t turns[AI_MEMORY_MAX_TURNS];
+    char summary[AI_MEMORY_SUMMARY_BYTES];
+    char arena[CONFIG_AI_MEMORY_SESSION_BYTES];
+} memory_session_t;
+
+static memory_session_t sessions[CONFIG_AI_MEMORY_SESSIONS];
+static SemaphoreHandle_t memory_lock = NULL;
+static ai_memory_stats_t stats;
+
+uint32_t ai_memory_estimate_tokens(const char *text, size_t len)
+{
+    uint32_t ascii = 0;
+    uint32_t chars = 0;
+    for (size_t i = 0; i < len; i++) {
+        uint8_t c = (uint8_t)text[i];
+        if (c < 0x80) {
+            ascii++;
+        } else if ((c & 0xC0) != 0x80) {
+            chars++;    // 多字节字符的首字节
+        }
+    }
+    return chars + (ascii + 3) / 4;
+}
+
+// 不超过 max 字节的最长前缀 (不截断 UTF-8 字符)
+static size_t utf8_clip(const char *text, size_t len, size_t max)
+{
+    if (len <= max) {
+        return len;
+    }
+    size_t n = max;
+    while (n > 0 && ((uint8_t)text[n] & 0xC0) == 0x80) {
+        n--;
+    }
+    return n;
+}
+
+static void session_free(memory_session_t *s)
+{
+    stats.sessions--;
+    stats.turns -= s->count;
+    memset(s, 0, sizeof(*s));
+}
+
+// 取出编码后的问题开头 (去掉转义) 并入摘要，摘要满时丢弃最早的问题
+static void summary_add(memory_session_t *s, const char *encoded, size_t len)
+{
+    char frag[AI_MEMORY_SUMMARY_CLIP];
+    size_t n = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        uint8_t c = (uint8_t)encoded[i];
+        if (c == '"') {
+            break;      // 内容结束
+        }
+        if (c == '\\' && i + 1 < len) {
+            char e = encoded[++i];
+            if (e == 'u') {
+                i += 4;     // 控制字符 (\u00XX)
+                c = ' ';
+            } else {
+                c = (e == '"' || e == '\\' || e == '/') ? (uint8_t)e : ' ';
+            }
+        }
+        size_t clen = c < 0x80 ? 1 : (c & 0xE0) == 0xC0 ? 2 : (c & 0xF0) == 0xE0 ? 3 : 4;
+        if (n + clen > sizeof(frag) || i + clen > len) {
+            break;
+        }
+        if (clen == 1) {
+            frag[n++] = (char)c;
+        } else {
+            memcpy(frag + n, encoded + i, clen);
+            n += clen;
+            i += clen - 1;
+        }
+    }
+    while (n > 0 && frag[n - 1] == ' ') {
+        n--;
+    }
+    if (n == 0) {
+        return;
+    }
+
+    // 结尾的 '\0' 占一个字节
+    while (s->summary_len > 0 && s->summary_len + SUMMARY_SEP_LEN + n + 1 > sizeof(s->summary)) {
+        char *sep = strstr(s->summary, SUMMARY_SEP);
+        if (sep == NULL) {
+            s->summary_len = 0;
+            break;
+        }
+        size_t skip = sep - s->summary + SUMMARY_SEP_LEN;
+        memmove(s->summary, s->summary + skip, s->summary_len - skip);
+        s->summary_len -= skip;
+    }
+    if (s->summary_len > 0) {
+        memcpy(s->summary + s->summary_len, SUMMARY_SEP, SUMMARY_SEP_LEN);
+        s->summary_len += SUMMARY_SEP_LEN;
+    }
+    memcpy(s->summary + s->summary_len, frag, n);
+    s->summary_len += n;
+    s->summary[s->summary_len] = '\0';
+    stats.turns_summarized++;
+}
+
+// 丢弃最早的一轮
+static void turn_evict_oldest(memory_session_t *s)
+{
+    memory_turn_t oldest = s->turns[0];
+#if CONFIG_AI_MEMORY_SUMMARY
+    if (oldest.user) {
+        summary_add(s, s->arena + oldest.offset + USER_PREFIX_LEN, oldest.len - USER_PREFIX_LEN);
+    }
+#endif
+
+    memmove(s->arena, s->arena + oldest.len, s->used - oldest.len);
+    s->used -= oldest.len;
+    s->count--;
+    for (int i = 0; i < s->count; i++) {
+        s->turns[i] = s->turns[i + 1];
+        s->turns[i].offset -= oldest.len;
+    }
+    stats.turns--;
+    stats.turns_evicted++;
+}
+
+// 编码并保存一轮 (只在保存时转义一次)，空间不够时丢弃最早的轮次
+static void turn_append(memory_session_t *s, bool user, const char *text)
+{
+    size_t len = strlen(text);
+    size_t clipped = utf8_clip(text, len, AI_MEMORY_TURN_MAX);
+    if (clipped < len) {
+        stats.turns_truncated++;
+    }
+    uint32_t tokens = ai_memory_estimate_tokens(text, clipped) + TURN_OVERHEAD_TOKENS;
+
+    while (1) {
+        if (s->count == AI_MEMORY_MAX_TURNS) {
+            turn_evict_oldest(s);
+            continue;
+        }
+
+        // 写入 arena 的空闲部分 (写入器留出的结尾字节正好放逗号)
+        json_writer_t w;
+        json_writer_init(&w, s->arena + s->used, sizeof(s->arena) - s->used, NULL, NULL);
+        json_writer_begin_object(&w, NULL);
+        json_writer_string(&w, "role", user ? "user" : "assistant");
+        json_writer_string_len(&w, "content", text, clipped);
+        json_writer_end_object(&w);
+        if (json_writer_finish(&w)) {
+            s->arena[s->used + w.len] = ',';
+            memory_turn_t *turn = &s->turns[s->count++];
+            turn->offset = s->used;
+            turn->len = (uint16_t)(w.len + 1);
+            turn->tokens = (uint16_t)tokens;
+            turn->user = user;
+            s->used += turn->len;
+            stats.turns++;
+            return;
+        }
+
+        if (s->count == 0) {
+            stats.turns_evicted++;      // 整个 arena 都放不下 (几乎全是需要转义的字符)
+            return;
+        }
+        turn_evict_oldest(s);
+    }
+}
+
+// 查找或新建会话，顺便释放空闲超时的会话；表满时淘汰最久未用的 (进行中的除外)
+static memory_session_t *session_get(uint32_t id, int64_t now)
+{
+    memory_session_t *found = NULL;
+    memory_session_t *empty = NULL;
+    memory_session_t *victim = NULL;
+
+    for (int i = 0; i < CONFIG_AI_MEMORY_SESSIONS; i++) {
+        memory_session_t *s = &sessions[i];
+        if (s->id != 0 && !s->busy &&
+            now - s->last_used_us > (int64_t)CONFIG_AI_MEMORY_IDLE_TIMEOUT_S * 1000000) {
+            ESP_LOGD(TAG, "会话 %08lx 空闲超时", (unsigned long)s->id);
+            session_free(s);
+            stats.sessions_expired++;
+        }
+        if (s->id == id) {
+            found = s;
+        } else if (s->id == 0) {
+            if (empty == NULL) {
+                empty = s;
+            }
+        } else if (!s->busy && (victim == NULL || s->last_used_us < victim->last_used_us)) {
+            victim = s;
+        }
+    }
+    if (found != NULL) {
+        return found;
+    }
+
+    if (empty == NULL) {
+        if (victim == NULL) {
+            return NULL;
+        }
+        ESP_LOGD(TAG, "会话表已满，淘汰会话 %08lx", (unsigned long)victim->id);
+        session_free(victim);
+        stats.sessions_evicted++;
+        empty = victim;
+    }
+    empty->id = id;
+    empty->last_used_us = now;
+    stats.sessions++;
+    return empty;
+}
+
+esp_err_t ai_memory_init(void)
+{
+    if (memory_lock == NULL) {
+        memory_lock = xSemaphoreCreateMutex();
+        if (memory_lock == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    ESP_LOGI(TAG, "对话记忆: %d 个会话 × %u 字节, 每次请求最多附带约 %d token 的历史",
+             CONFIG_AI_MEMORY_SESSIONS, (unsigned)sizeof(memory_session_t),
+             CONFIG_AI_MEMORY_CONTEXT_TOKENS);
+    return ESP_OK;
+}
+
+void ai_memory_begin(uint32_t session, ai_memory_context_t *ctx)
+{
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->session = session;
+    ctx->slot = -1;
+    ctx->summary = "";
+
+    if (session == AI_MEMORY_NO_SESSION || CONFIG_AI_MEMORY_CONTEXT_TOKENS == 0 || memory_lock == NULL) {
+        return;
+    }
+
+    xSemaphoreTake(memory_lock, portMAX_DELAY);
+    memory_session_t *s = session_get(session, esp_timer_get_time());
+    if (s == NULL || s->busy) {
+        xSemaphoreGive(memory_lock);
+        ESP_LOGW(TAG, "会话 %08lx 不可用，本次不使用对话记忆", (unsigned long)session);
+        return;
+    }
+    s->busy = true;
+    ctx->slot = s - sessions;
+
+    // 从最近一轮往前取，直到用完 token 预算；从用户的问题开始
+    uint32_t budget = CONFIG_AI_MEMORY_CONTEXT_TOKENS;
+    uint32_t tokens = 0;
+    int first = s->count;
+    while (first > 0 && tokens + s->turns[first - 1].tokens <= budget) {
+        tokens += s->turns[--first].tokens;
+    }
+    while (first < s->count && !s->turns[first].user) {
+        tokens -= s->turns[first++].tokens;
+    }
+
+    if (first < s->count) {
+        ctx->messages = s->arena + s->turns[first].offset;
+        ctx->messages_len = s->used - s->turns[first].offset - 1;     // 去掉最后的逗号
+        ctx->turns = s->count - first;
+    }
+    if (s->summary_len > 0) {
+        uint32_t summary_tokens = ai_memory_estimate_tokens(s->summary, s->summary_len);
+        if (tokens + summary_tokens <= budget) {
+            ctx->summary = s->summary;
+            tokens += summary_tokens;
+        }
+    }
+    ctx->tokens = tokens;
+
+    if (ctx->turns > 0 || ctx->summary[0] != '\0') {
+        stats.requests++;
+        stats.context_bytes = ctx->messages_len;
+        if (ctx->messages_len > stats.context_bytes_max) {
+            stats.context_bytes_max = ctx->messages_len;
+        }
+        stats.context_tokens = tokens;
+        stats.turns_skipped = first;
+    }
+    xSemaphoreGive(memory_lock);
+}
+
+void ai_memory_end(ai_memory_context_t *ctx, const char *query, const char *reply)
+{
+    if (ctx->slot < 0) {
+        return;
+    }
+
+    xSemaphoreTake(memory_lock, portMAX_DELAY);
+    memory_session_t *s = &sessions[ctx->slot];
+    if (s->id == ctx->session) {
+        if (s->forget) {
+            session_free(s);
+        } else {
+            if (query != NULL && reply != NULL && reply[0] != '\0') {
+                turn_append(s, true, query);
+                turn_append(s, false, reply);
+            }
+            s->busy = false;
+            s->last_used_us = esp_timer_get_time();
+        }
+    }
+    xSemaphoreGive(memory_lock);
+
+    ctx->slot = -1;
+    ctx->messages = NULL;
+    ctx->messages_len = 0;
+    ctx->summary = "";
+}
+
+void ai_memory_forget(uint32_t session)
+{
+    if (session == AI_MEMORY_NO_SESSION || memory_lock == NULL) {
+        return;
+    }
+
+    xSemaphoreTake(memory_lock, portMAX_DELAY);
+    for (int i = 0; i < CONFIG_AI_MEMORY_SESSIONS; i++) {
+        memory_session_t *s = &sessions[i];
+        if (s->id == session) {
+            if (s->busy) {
+                s->forget = true;
+            } else {
+                session_free(s);
+            }
+            break;
+        }
+    }
+    xSemaphoreGive(memory_lock);
+}
+
+void ai_memory_get_stats(ai_memory_stats_t *out)
+{
+    if (out == NULL) {
+        return;
+    }
+    if (memory_lock == NULL) {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+
+    xSemaphoreTake(memory_lock, portMAX_DELAY);
+    *out = stats;
+    out->bytes_used = 0;
+    for (int i = 0; i < CONFIG_AI_MEMORY_SESSIONS; i++) {
+        out->bytes_used += sessions[i].used + sessions[i].summary_len;
+    }
+    out->bytes_reserved = sizeof(sessions);
+    xSemaphoreGive(memory_lock);
+}
+
+int ai_memory_get_sessions(ai_memory_session_info_t *info, int max)
+{
+    if (info == NULL || memory_lock == NULL) {
+        return 0;
+    }
+
+    int64_t now = esp_timer_get_time();
+    int n = 0;
+    xSemaphoreTake(memory_lock, portMAX_DELAY);
+    for (int i = 0; i < CONFIG_AI_MEMORY_SESSIONS && n < max; i++) {
+        const memory_session_t *s = &sessions[i];
+        if (s->id == 0) {
+            continue;
+        }
+        info[n].session = s->id;
+        info[n].turns = s->count;
+        info[n].bytes = s->used;
+        info[n].summary_bytes = s->summary_len;
+        info[n].idle_s = s->busy ? 0 : (uint32_t)((now - s->last_used_us) / 1000000);
+        n++;
+    }
+    xSemaphoreGive(memory_lock);
+    return n;
+}
+
+uint32_t ai_memory_session_from_key(const char *key)
+{
+    if (key == NULL || key[0] == '\0') {
+        return AI_MEMORY_NO_SESSION;
+    }
+
+    // FNV-1a，最高位置 1 (WebSocket 客户端编号从 1 递增，不会用到最高位)
+    uint32_t h = 0x811c9dc5;
+    for (const uint8_t *p = (const uint8_t *)key; *p != '\0'; p++) {
+        h ^= *p;
+        h *= 0x01000193;
+    }
+    return h | 0x80000000u;
+}
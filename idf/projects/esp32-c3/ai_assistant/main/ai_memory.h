@@ -0,0 +1,85 @@
+#ifndef AI_MEMORY_H
+#define AI_MEMORY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+// 对话记忆：每个会话 (WebSocket 客户端或带 session 的 HTTP 请求) 保存最近几轮对话，
+// 请求后端时附带在 token 预算内的最近几轮，后续追问不丢失上下文。
+// 每轮在保存时就编码成请求体中的消息对象 ({"role":..,"content":..})，按时间顺序连续存放在
+// 会话的固定大小内存区中，请求时直接取出一段，不重新编码整个历史。
+// 空间或轮数不够时丢弃最早的轮次，丢弃的问题截取开头并入会话摘要 (随系统提示发送)
+
+#define AI_MEMORY_NO_SESSION    0
+
+// 每个会话最多保存的轮数 (用户和助手各算一轮)
+#define AI_MEMORY_MAX_TURNS     12
+
+// 单轮保存的原文上限 (字节)，较长的回复截断后保存
+#define AI_MEMORY_TURN_MAX      256
+
+// 会话摘要上限 (字节) 和每个丢弃的问题截取的长度
+#define AI_MEMORY_SUMMARY_BYTES 160
+#define AI_MEMORY_SUMMARY_CLIP  36
+
+// 本次请求附带的上下文 (在 ai_memory_end 之前有效)
+typedef struct {
+    uint32_t session;
+    int slot;                   // 会话位置，-1 表示没有会话 (不记录)
+    const char *messages;       // 已编码的历史消息 (逗号分隔的 JSON 对象)，没有历史时为 NULL
+    size_t messages_len;
+    uint32_t turns;             // 包含的轮数
+    uint32_t tokens;            // 估计的 token 数 (含摘要)
+    const char *summary;        // 较早话题的摘要 (纯文本)，没有时为空串
+} ai_memory_context_t;
+
+// 统计
+typedef struct {
+    uint32_t sessions;          // 当前会话数
+    uint32_t bytes_used;        // 各会话已编码历史和摘要占用的字节
+    uint32_t bytes_reserved;    // 静态分配的总字节 (会话数上限 × 每会话大小)
+    uint32_t turns;             // 当前保存的轮数
+    uint32_t turns_evicted;     // 因空间或轮数上限丢弃的最早轮次
+    uint32_t turns_summarized;  // 丢弃时并入摘要的问题
+    uint32_t turns_truncated;   // 保存时截断的长消息
+    uint32_t sessions_expired;  // 空闲超时释放的会话
+    uint32_t sessions_evicted;  // 会话表满时淘汰的最久未用会话
+    uint32_t requests;          // 附带了历史的请求数
+    uint32_t context_bytes;     // 最近一次请求附带的历史字节数
+    uint32_t context_bytes_max;
+    uint32_t context_tokens;    // 最近一次请求附带的历史 token 估计
+    uint32_t turns_skipped;     // 最近一次请求中超出 token 预算未发送的轮次
+} ai_memory_stats_t;
+
+// 单个会话的占用
+typedef struct {
+    uint32_t session;
+    uint32_t turns;
+    uint32_t bytes;             // 已编码历史
+    uint32_t summary_bytes;
+    uint32_t idle_s;
+} ai_memory_session_info_t;
+
+// 函数声明
+esp_err_t ai_memory_init(void);
+
+// 取出会话的上下文并锁定会话 (不会被淘汰)，会话不存在时新建。必须与 ai_memory_end 成对调用
+void ai_memory_begin(uint32_t session, ai_memory_context_t *ctx);
+
+// 保存本轮问答 (reply 为 NULL 时不保存) 并解除锁定
+void ai_memory_end(ai_memory_context_t *ctx, const char *query, const char *reply);
+
+// 释放会话 (客户端断开时调用)
+void ai_memory_forget(uint32_t session);
+
+void ai_memory_get_stats(ai_memory_stats_t *stats);
+int ai_memory_get_sessions(ai_memory_session_info_t *info, int max);
+
+// HTTP 客户端提供的会话标识转换为会话号 (与 WebSocket 客户端编号不重叠)
+uint32_t ai_memory_session_from_key(const char *key);
+
+// 估计文本的 token 数 (非 ASCII 字符各算一个，ASCII 约四个字节一个)
+uint32_t ai_memory_estimate_tokens(const char *text, size_t len);
+
+#endif // AI_MEMORY_H
@@ -0,0 +1,172 @@
+#include "ai_msg.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <string.h>
+
+static const char *TAG = "AI_MSG";
+
+// 消息池 (静态分配，运行中不再申请内存)
+static ai_msg_t msg_pool[AI_MSG_POOL_SIZE];
+static ai_msg_t *free_list[AI_MSG_POOL_SIZE];
+static int free_count = 0;
+static portMUX_TYPE pool_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// 消息池统计
+static uint32_t in_use_max = 0;
+static uint32_t alloc_failures = 0;
+static uint32_t completed = 0;
+static uint64_t total_us_sum = 0;
+static uint32_t total_us_max = 0;
+
+// 已创建的队列 (用于统计)
+static ai_msg_queue_t *queues[AI_MSG_MAX_QUEUES];
+static int num_queues = 0;
+
+esp_err_t ai_msg_init(void)
+{
+    portENTER_CRITICAL(&pool_lock);
+    for (int i = 0; i < AI_MSG_POOL_SIZE; i++) {
+        free_list[i] = &msg_pool[i];
+    }
+    free_count = AI_MSG_POOL_SIZE;
+    portEXIT_CRITICAL(&pool_lock);
+
+    ESP_LOGI(TAG, "消息池: %d x %u 字节", AI_MSG_POOL_SIZE, (unsigned)sizeof(ai_msg_t));
+    return ESP_OK;
+}
+
+ai_msg_t *ai_msg_alloc(uint32_t client)
+{
+    ai_msg_t *msg = NULL;
+
+    portENTER_CRITICAL(&pool_lock);
+    if (free_count > 0) {
+        msg = free_list[--free_count];
+        uint32_t in_use = AI_MSG_POOL_SIZE - free_count;
+        if (in_use > in_use_max) {
+            in_use_max = in_use;
+        }
+    } else {
+        alloc_failures++;
+    }
+    portEXIT_CRITICAL(&pool_lock);
+
+    if (msg != NULL) {
+        // 只清理头部，文本和回复由使用者写入
+        msg->client = client;
+        msg->created_us = esp_timer_get_time();
+        msg->sent_us = msg->created_us;
+        msg->text[0] = '\0';
+        msg->response.text[0] = '\0';
+    }
+    return msg;
+}
+
+void ai_msg_free(ai_msg_t *msg)
+{
+    if (msg == NULL) {
+        return;
+    }
+    uint32_t total_us = (uint32_t)(esp_timer_get_time() - msg->created_us);
+
+    portENTER_CRITICAL(&pool_lock);
+    free_list[free_count++] = msg;
+    completed++;
+    total_us_sum += total_us;
+    if (total_us > total_us_max) {
+        total_us_max = total_us;
+    }
+    portEXIT_CRITICAL(&pool_lock);
+}
+
+esp_err_t ai_msg_queue_init(ai_msg_queue_t *queue, const char *name)
+{
+    if (queue == NULL || num_queues >= AI_MSG_MAX_QUEUES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(queue, 0, sizeof(*queue));
+    queue->name = name;
+    portMUX_INITIALIZE(&queue->lock);
+    queues[num_queues++] = queue;
+    return ESP_OK;
+}
+
+void ai_msg_send(ai_msg_queue_t *queue, ai_msg_t *msg)
+{
+    msg->sent_us = esp_timer_get_time();
+
+    portENTER_CRITICAL(&queue->lock);
+    queue->ring[(queue->head + queue->count) % AI_MSG_POOL_SIZE] = msg;
+    queue->count++;
+    if (queue->count > queue->depth_max) {
+        queue->depth_max = queue->count;
+    }
+    TaskHandle_t receiver = queue->receiver;
+    portEXIT_CRITICAL(&queue->lock);
+
+    // 接收任务还未开始等待时不需要通知，它取消息前会先检查队列
+    if (receiver != NULL) {
+        xTaskNotifyGive(receiver);
+    }
+}
+
+ai_msg_t *ai_msg_receive(ai_msg_queue_t *queue, TickType_t timeout)
+{
+    while (1) {
+        ai_msg_t *msg = NULL;
+
+        portENTER_CRITICAL(&queue->lock);
+        queue->receiver = xTaskGetCurrentTaskHandle();
+        if (queue->count > 0) {
+            msg = queue->ring[queue->head];
+            queue->head = (queue->head + 1) % AI_MSG_POOL_SIZE;
+            queue->count--;
+        }
+        portEXIT_CRITICAL(&queue->lock);
+
+        if (msg != NULL) {
+            uint32_t wait_us = (uint32_t)(esp_timer_get_time() - msg->sent_us);
+            portENTER_CRITICAL(&queue->lock);
+            queue->messages++;
+            queue->wait_us_sum += wait_us;
+            if (wait_us > queue->wait_us_max) {
+                queue->wait_us_max = wait_us;
+            }
+            portEXIT_CRITICAL(&queue->lock);
+            return msg;
+        }
+
+        // 队列空：等待发送方的通知 (通知在取消息前已到达时立即返回)
+        if (ulTaskNotifyTake(pdTRUE, timeout) == 0) {
+            return NULL;
+        }
+    }
+}
+
+void ai_msg_get_stats(ai_msg_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+
+    portENTER_CRITICAL(&pool_lock);
+    stats->in_use = AI_MSG_POOL_SIZE - free_count;
+    stats->in_use_max = in_use_max;
+    stats->alloc_failures = alloc_failures;
+    stats->completed = completed;
+    stats->total_avg_us = completed ? (uint32_t)(total_us_sum / completed) : 0;
+    stats->total_max_us = total_us_max;
+    portEXIT_CRITICAL(&pool_lock);
+
+    stats->num_queues = num_queues;
+    for (int i = 0; i < num_queues; i++) {
+        ai_msg_queue_t *queue = queues[i];
+        ai_msg_queue_stats_t *out = &stats->queues[i];
+        portENTER_CRITICAL(&queue->lock);
+        out->name = queue->name;
+        out->messages = queue->messages;
+        out->depth_max = queue->depth_max;
+        out->wait_avg_us = queue->messages ? (uint32_t)(queue->wait_us_sum / queue->messages) : 0;
+        out->wait_max_us = queue->wait_us_max;
+        portEXIT_CRITICAL(&queue->lock);
+    }
+}
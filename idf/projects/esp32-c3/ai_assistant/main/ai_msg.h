@@ -0,0 +1,73 @@
+#ifndef AI_MSG_H
+#define AI_MSG_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "ai_engine.h"
+
+// 消息池大小 (同时在处理中的请求数上限)
+#define AI_MSG_POOL_SIZE    8
+
+// 统计的队列数上限
+#define AI_MSG_MAX_QUEUES   4
+
+// 一条请求从接收到回复使用同一个消息块：
+// Web → web_request_queue → AI 处理 (写入 response) → ai_response_queue → 推送，然后归还
+typedef struct {
+    uint32_t client;            // 发出请求的 WebSocket 客户端
+    int64_t created_us;         // 分配时间 (端到端延迟)
+    int64_t sent_us;            // 最近一次入队时间 (队列等待)
+    char text[512];             // 请求文本
+    ai_response_t response;     // 回复
+} ai_msg_t;
+
+// 消息队列：只传递指针，入队即把消息的所有权交给接收任务。
+// 每个队列只有一个接收任务，通过任务通知唤醒；
+// 容量等于消息池大小，所有消息都在同一个队列中也不会满，入队从不阻塞或失败
+typedef struct {
+    const char *name;
+    ai_msg_t *ring[AI_MSG_POOL_SIZE];
+    uint8_t head;
+    uint8_t count;
+    TaskHandle_t receiver;
+    portMUX_TYPE lock;
+    // 统计
+    uint8_t depth_max;
+    uint32_t messages;
+    uint64_t wait_us_sum;
+    uint32_t wait_us_max;
+} ai_msg_queue_t;
+
+// 队列统计
+typedef struct {
+    const char *name;
+    uint32_t messages;
+    uint32_t depth_max;         // 最大积压
+    uint32_t wait_avg_us;       // 入队到被接收任务取出
+    uint32_t wait_max_us;
+} ai_msg_queue_stats_t;
+
+// 消息池统计
+typedef struct {
+    uint32_t in_use;
+    uint32_t in_use_max;
+    uint32_t alloc_failures;    // 池空时的分配次数 (请求被拒绝)
+    uint32_t completed;         // 已归还的消息
+    uint32_t total_avg_us;      // 分配到归还 (端到端)
+    uint32_t total_max_us;
+    int num_queues;
+    ai_msg_queue_stats_t queues[AI_MSG_MAX_QUEUES];
+} ai_msg_stats_t;
+
+// 函数声明
+esp_err_t ai_msg_init(void);
+ai_msg_t *ai_msg_alloc(uint32_t client);
+void ai_msg_free(ai_msg_t *msg);
+esp_err_t ai_msg_queue_init(ai_msg_queue_t *queue, const char *name);
+void ai_msg_send(ai_msg_queue_t *queue, ai_msg_t *msg);
+ai_msg_t *ai_msg_receive(ai_msg_queue_t *queue, TickType_t timeout);
+void ai_msg_get_stats(ai_msg_stats_t *stats);
+
+#endif // AI_MSG_H
@@ -8,53 +8,132 @@
 #include "esp_wifi.h"
 #include "esp_event.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "nvs_flash.h"
 #include "esp_http_client.h"
 #include "cJSON.h"
 
+#include "sdkconfig.h"
 #include "ai_engine.h"
-// #include "voice_processor.h"  // ESP32-C3不支持音频处理
+#include "ai_msg.h"
+// ESP32-C3不支持音频处理，语音只在 ESP32-S3 上编译
+#if CONFIG_IDF_TARGET_ESP32S3
+#include "voice_processor.h"
+#include "voice_asr.h"
+#include "voice_tts.h"
+#include "ai_cache.h"
+#endif
 #include "web_interface.h"
 #include "wifi_manager.h"
 
 static const char *TAG = "AI_ASSISTANT_C3";
 
-// 全局队列用于任务间通信 (仅保留Web交互队列)
-QueueHandle_t web_request_queue;
-QueueHandle_t ai_response_queue;
-
-// AI小智的个性化设置 (ESP32-C3版本)
-typedef struct {
-    char name[32];
-    char personality[256];
-    char interface_type[16];
-    int response_speed;
-} ai_personality_t;
+// 任务间通信 (仅保留Web交互队列)：队列只传递消息池中的消息指针
+static ai_msg_queue_t web_request_queue;
+static ai_msg_queue_t ai_response_queue;
 
+// AI小智的个性化设置 (ESP32-C3版本，无语音)
 static ai_personality_t ai_config = {
     .name = "小智C3",
     .personality = "我是一个基于ESP32-C3的AI助手，可以通过Web界面帮助你回答问题、控制设备等。",
-    .interface_type = "web",
+    .voice_type = "none",
     .response_speed = 1
 };
 
-// Web请求处理任务
+#if CONFIG_IDF_TARGET_ESP32S3
+static bool voice_ready = false;
+
+// 最近朗读的回复 (规范化后)。没有回声消除，麦克风会录到扬声器的声音，朗读期间识别结果包含在其中时
+// 当作回声，不算用户插话。回复最后一段的识别结果往往在播放结束后才返回，所以播放结束后
+// 再保留 VOICE_ECHO_TAIL_MS；之后同样的话 (如回复 "已为您开灯" 后说 "开灯") 按用户输入处理。
+// 太短的识别结果很可能是用户的指令，不当作回声
+#define VOICE_ECHO_TAIL_MS      1500
+#define VOICE_ECHO_MIN_CHARS    4
+static char speaking_text[512];
+static portMUX_TYPE speaking_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static void voice_speak_response(const char *text)
+{
+    static char normalized[sizeof(speaking_text)];
+    ai_cache_normalize(text, normalized, sizeof(normalized));
+    portENTER_CRITICAL(&speaking_lock);
+    strlcpy(speaking_text, normalized, sizeof(speaking_text));
+    portEXIT_CRITICAL(&speaking_lock);
+    voice_synthesize(text, NULL);   // 立即返回，新的回复打断正在播放的语句
+}
+
+// UTF-8 字符数
+static size_t voice_utf8_chars(const char *s)
+{
+    size_t n = 0;
+    for (; *s != '\0'; s++) {
+        if (((uint8_t)*s & 0xC0) != 0x80) {
+            n++;
+        }
+    }
+    return n;
+}
+
+static bool voice_is_echo(const char *text)
+{
+    static char normalized[sizeof(speaking_text)];
+    if (ai_cache_normalize(text, normalized, sizeof(normalized)) == 0) {
+        return true;    // 只有标点或空白
+    }
+    int64_t last_active_us = voice_tts_last_active_us();
+    if (last_active_us == 0 || esp_timer_get_time() - last_active_us > VOICE_ECHO_TAIL_MS * 1000LL) {
+        return false;
+    }
+    if (voice_utf8_chars(normalized) < VOICE_ECHO_MIN_CHARS) {
+        return false;
+    }
+    portENTER_CRITICAL(&speaking_lock);
+    bool echo = strstr(speaking_text, normalized) != NULL;
+    portEXIT_CRITICAL(&speaking_lock);
+    return echo;
+}
+
+// 用户开始新的一轮 (语音插话或Web请求)：停止朗读上一条回复
+static void voice_interrupt(void)
+{
+    voice_tts_cancel();
+    portENTER_CRITICAL(&speaking_lock);
+    speaking_text[0] = '\0';
+    portEXIT_CRITICAL(&speaking_lock);
+}
+#endif
+
+// 大模型逐 token 推送给发出请求的客户端，客户端断开时取消请求
+static esp_err_t web_token_handler(const char *token, size_t len, void *arg)
+{
+    uint32_t client = (uint32_t)(uintptr_t)arg;
+    if (client == WEB_CLIENT_ALL) {
+        return ESP_OK;
+    }
+    esp_err_t ret = web_send_token(client, token, len);
+    return ret == ESP_ERR_NOT_FOUND ? ret : ESP_OK;   // 队列满时只丢弃该 token
+}
+
+// Web请求处理任务：回复直接写入请求所在的消息，再把消息交给响应任务
 void web_request_task(void *pvParameters)
 {
-    char request_text[512];
-    
     ESP_LOGI(TAG, "Web请求处理任务启动");
     
     while (1) {
-        if (xQueueReceive(web_request_queue, request_text, portMAX_DELAY) == pdTRUE) {
-            ESP_LOGI(TAG, "收到Web请求: %s", request_text);
-            
-            // 处理AI命令
-            ai_response_t response;
-            if (ai_process_command(request_text, &response) == ESP_OK) {
-                // 发送响应到Web界面
-                xQueueSend(ai_response_queue, &response, 0);
-            }
+        ai_msg_t *msg = ai_msg_receive(&web_request_queue, portMAX_DELAY);
+        if (msg == NULL) {
+            continue;
+        }
+        ESP_LOGI(TAG, "收到Web请求: %s", msg->text);
+        
+        // 处理AI命令
+        // 每个 WebSocket 客户端是一个对话会话
+        if (ai_process_command_stream(msg->client, msg->text, &msg->response, web_token_handler,
+                                      (void *)(uintptr_t)msg->client) == ESP_OK) {
+            // 发送响应到Web界面
+            ai_msg_send(&ai_response_queue, msg);
+        } else {
+            ai_msg_free(msg);
         }
     }
 }
@@ -62,18 +141,66 @@ void web_request_task(void *pvParameters)
 // AI响应处理任务 (ESP32-C3版本 - 仅Web输出)
 void ai_response_task(void *pvParameters)
 {
-    ai_response_t response;
-    
     ESP_LOGI(TAG, "AI响应处理任务启动");
     
     while (1) {
-        if (xQueueReceive(ai_response_queue, &response, 0) == pdTRUE) {
-            ESP_LOGI(TAG, "AI响应: %s", response.text);
-            
-            // 发送到Web界面 (ESP32-C3主要交互方式)
-            web_send_response(&response);
+        ai_msg_t *msg = ai_msg_receive(&ai_response_queue, portMAX_DELAY);
+        if (msg == NULL) {
+            continue;
+        }
+        ESP_LOGI(TAG, "AI响应: %s", msg->response.text);
+        
+        // 发送到Web界面 (ESP32-C3主要交互方式)，只入推送队列，不等待浏览器
+        web_send_response_to(msg->client, &msg->response);
+#if CONFIG_IDF_TARGET_ESP32S3
+        if (voice_ready && msg->response.text[0] != '\0') {
+            voice_speak_response(msg->response.text);
         }
-        vTaskDelay(pdMS_TO_TICKS(100));
+#endif
+        ai_msg_free(msg);
+    }
+}
+
+// 提交一条Web请求 (消息池满时返回 ESP_ERR_NO_MEM)
+static esp_err_t web_submit_request(uint32_t client, const char *text)
+{
+    ai_msg_t *msg = ai_msg_alloc(client);
+    if (msg == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    strlcpy(msg->text, text, sizeof(msg->text));
+    ai_msg_send(&web_request_queue, msg);
+    return ESP_OK;
+}
+
+#if CONFIG_IDF_TARGET_ESP32S3
+// 语音识别回调 (在识别任务中调用)：识别出的文字和Web请求走同一条处理路径，回复广播给所有客户端
+static void voice_text_handler(const char *text, float confidence)
+{
+    if (voice_is_echo(text)) {
+        ESP_LOGD(TAG, "忽略回声: %s", text);
+        return;
+    }
+    ESP_LOGI(TAG, "语音输入: %s", text);
+    voice_interrupt();
+    if (web_submit_request(WEB_CLIENT_ALL, text) != ESP_OK) {
+        ESP_LOGW(TAG, "请求过多，丢弃语音输入");
+    }
+}
+#endif
+
+// WebSocket消息回调 (在HTTP服务器任务中调用，不能阻塞)
+static void web_ws_message_handler(ws_message_t *message)
+{
+    if (message->type != WS_MSG_CHAT) {
+        return;
+    }
+    
+#if CONFIG_IDF_TARGET_ESP32S3
+    voice_interrupt();
+#endif
+    if (web_submit_request(message->client, message->data) != ESP_OK) {
+        web_send_status_to(message->client, "请求过多，请稍后再试");
     }
 }
 
@@ -103,12 +230,10 @@ void system_monitor_task(void *pvParameters)
 // ESP32-C3专用的Web交互接口
 esp_err_t esp32c3_web_command_handler(const char *command)
 {
-    if (web_request_queue != NULL) {
-        if (xQueueSend(web_request_queue, command, pdMS_TO_TICKS(1000)) == pdTRUE) {
-            return ESP_OK;
-        }
+    if (command == NULL) {
+        return ESP_ERR_INVALID_ARG;
     }
-    return ESP_FAIL;
+    return web_submit_request(WEB_CLIENT_ALL, command);
 }
 
 void app_main(void)
@@ -126,11 +251,10 @@ void app_main(void)
     }
     ESP_ERROR_CHECK(ret);
     
-    // 创建队列 (仅Web交互队列)
-    web_request_queue = xQueueCreate(10, 512);  // 支持较长的Web请求
-    ai_response_queue = xQueueCreate(10, sizeof(ai_response_t));
-    
-    if (web_request_queue == NULL || ai_response_queue == NULL) {
+    // 创建消息池和队列 (仅Web交互队列)
+    ai_msg_init();
+    if (ai_msg_queue_init(&web_request_queue, "web_request") != ESP_OK ||
+        ai_msg_queue_init(&ai_response_queue, "ai_response") != ESP_OK) {
         ESP_LOGE(TAG, "队列创建失败");
         return;
     }
@@ -143,15 +267,37 @@ void app_main(void)
     ESP_LOGI(TAG, "初始化AI引擎...");
     ai_engine_init(&ai_config);
     
+#if CONFIG_IDF_TARGET_ESP32S3
+    // 语音: I2S 麦克风采集，VAD 检出的语音段交给识别后端
+    ESP_LOGI(TAG, "初始化语音处理器...");
+    if (voice_processor_init() == ESP_OK) {
+        // 语音合成通过语音处理器的 I2S 发送通道播放，要在它之后初始化
+        voice_ready = voice_tts_init() == ESP_OK;
+        if (!voice_ready) {
+            ESP_LOGE(TAG, "语音合成初始化失败，回复不朗读");
+        }
+        voice_set_segment_callback(voice_asr_recognize);
+        voice_set_recognize_callback(voice_text_handler);
+        if (voice_asr_is_configured()) {
+            voice_recognize_start();
+        } else {
+            ESP_LOGW(TAG, "未配置语音识别后端 (menuconfig: AI Assistant ASR Backend)，不启动麦克风");
+        }
+    } else {
+        ESP_LOGE(TAG, "语音处理器初始化失败，只使用Web界面");
+    }
+#else
     // 跳过语音处理器初始化 (ESP32-C3不支持)
     ESP_LOGI(TAG, "跳过音频初始化 (ESP32-C3不支持)");
+#endif
     
     // 初始化Web界面
     ESP_LOGI(TAG, "初始化Web界面...");
     web_interface_init();
+    web_set_ws_callback(web_ws_message_handler);
     
     // 创建任务 (仅非音频任务)
-    xTaskCreate(web_request_task, "web_req", 4096, NULL, 5, NULL);
+    xTaskCreate(web_request_task, "web_req", 8192, NULL, 5, NULL);  // 可能调用大模型后端 (TLS)
     xTaskCreate(ai_response_task, "ai_response", 4096, NULL, 5, NULL);
     xTaskCreate(system_monitor_task, "sys_monitor", 2048, NULL, 3, NULL);
     
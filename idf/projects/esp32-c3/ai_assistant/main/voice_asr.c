@@ -0,0 +1,200 @@
+#include "voice_asr.h"
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_http_client.h"
+#include "esp_crt_bundle.h"
+#include "esp_timer.h"
+#include "cJSON.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "VOICE_ASR";
+
+#define ASR_BOUNDARY        "----ai-assistant-voice-segment"
+#define ASR_RESPONSE_MAX    2048
+#define ASR_WAV_HEADER      44
+
+// 只在识别任务中使用，连接在语音段之间保持
+static esp_http_client_handle_t client = NULL;
+static bool connected_now = false;
+
+static esp_err_t asr_http_event_handler(esp_http_client_event_t *evt)
+{
+    if (evt->event_id == HTTP_EVENT_ON_CONNECTED) {
+        connected_now = true;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t asr_client_create(void)
+{
+    esp_http_client_config_t http_config = {
+        .url = CONFIG_AI_ASR_URL,
+        .method = HTTP_METHOD_POST,
+        .event_handler = asr_http_event_handler,
+        .timeout_ms = CONFIG_AI_ASR_TIMEOUT_MS,
+        .buffer_size = 1024,
+        .buffer_size_tx = 1024,
+        .keep_alive_enable = true,
+        .crt_bundle_attach = esp_crt_bundle_attach,
+    };
+
+    client = esp_http_client_init(&http_config);
+    if (client == NULL) {
+        ESP_LOGE(TAG, "HTTP客户端初始化失败");
+        return ESP_FAIL;
+    }
+
+    esp_http_client_set_header(client, "Content-Type", "multipart/form-data; boundary=" ASR_BOUNDARY);
+    if (CONFIG_AI_ASR_API_KEY[0] != '\0') {
+        esp_http_client_set_header(client, "Authorization", "Bearer " CONFIG_AI_ASR_API_KEY);
+    }
+    return ESP_OK;
+}
+
+static inline void put_le32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static inline void put_le16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+// 16kHz 16 位单声道 PCM 的 WAV 头
+static void asr_wav_header(uint8_t *h, uint32_t pcm_bytes)
+{
+    memcpy(h, "RIFF", 4);
+    put_le32(h + 4, 36 + pcm_bytes);
+    memcpy(h + 8, "WAVEfmt ", 8);
+    put_le32(h + 16, 16);
+    put_le16(h + 20, 1);                            // PCM
+    put_le16(h + 22, 1);                            // 单声道
+    put_le32(h + 24, VOICE_FE_SAMPLE_RATE);
+    put_le32(h + 28, VOICE_FE_SAMPLE_RATE * 2);     // 每秒字节数
+    put_le16(h + 32, 2);                            // 每帧字节数
+    put_le16(h + 34, 16);
+    memcpy(h + 36, "data", 4);
+    put_le32(h + 40, pcm_bytes);
+}
+
+// 写完整个缓冲 (esp_http_client_write 可能只写出一部分)
+static bool asr_write(const void *data, size_t len)
+{
+    const char *p = data;
+    while (len > 0) {
+        int n = esp_http_client_write(client, p, len);
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+// 上传语音段: 表单字段和 WAV 头之后，PCM 直接从语音段缓冲写出，不复制
+static esp_err_t asr_upload(const voice_segment_t *segment)
+{
+    char head[448];
+    int head_len = snprintf(head, sizeof(head),
+                            "--" ASR_BOUNDARY "\r\n"
+                            "Content-Disposition: form-data; name=\"model\"\r\n\r\n%s\r\n"
+                            "--" ASR_BOUNDARY "\r\n"
+                            "Content-Disposition: form-data; name=\"language\"\r\n\r\n%s\r\n"
+                            "--" ASR_BOUNDARY "\r\n"
+                            "Content-Disposition: form-data; name=\"response_format\"\r\n\r\njson\r\n"
+                            "--" ASR_BOUNDARY "\r\n"
+                            "Content-Disposition: form-data; name=\"file\"; filename=\"segment.wav\"\r\n"
+                            "Content-Type: audio/wav\r\n\r\n",
+                            CONFIG_AI_ASR_MODEL, CONFIG_AI_ASR_LANGUAGE);
+    if (head_len <= 0 || head_len >= (int)sizeof(head)) {
+        ESP_LOGE(TAG, "模型名或语言过长");
+        return ESP_ERR_INVALID_SIZE;
+    }
+    static const char tail[] = "\r\n--" ASR_BOUNDARY "--\r\n";
+    const uint32_t pcm_bytes = segment->samples * sizeof(int16_t);
+    uint8_t wav[ASR_WAV_HEADER];
+    asr_wav_header(wav, pcm_bytes);
+    const int total = head_len + ASR_WAV_HEADER + pcm_bytes + (int)(sizeof(tail) - 1);
+
+    // 保持的连接可能已被服务器关闭：在复用的连接上失败时重连一次
+    for (int attempt = 0; attempt < 2; attempt++) {
+        connected_now = false;
+        if (esp_http_client_open(client, total) == ESP_OK &&
+            asr_write(head, head_len) && asr_write(wav, sizeof(wav)) &&
+            asr_write(segment->pcm, pcm_bytes) && asr_write(tail, sizeof(tail) - 1) &&
+            esp_http_client_fetch_headers(client) >= 0) {
+            return ESP_OK;
+        }
+        esp_http_client_close(client);
+        if (connected_now) {
+            break;
+        }
+    }
+    return ESP_FAIL;
+}
+
+bool voice_asr_is_configured(void)
+{
+    return CONFIG_AI_ASR_URL[0] != '\0';
+}
+
+bool voice_asr_recognize(const voice_segment_t *segment, char *text, size_t text_size, float *confidence)
+{
+    if (!voice_asr_is_configured() || segment->samples == 0) {
+        return false;
+    }
+    if (client == NULL && asr_client_create() != ESP_OK) {
+        return false;
+    }
+
+    int64_t start = esp_timer_get_time();
+    if (asr_upload(segment) != ESP_OK) {
+        ESP_LOGE(TAG, "识别请求失败");
+        return false;
+    }
+
+    int status = esp_http_client_get_status_code(client);
+    if (status != 200) {
+        ESP_LOGE(TAG, "识别接口返回 HTTP %d", status);
+        esp_http_client_flush_response(client, NULL);
+        return false;
+    }
+
+    // 响应是一个小 JSON 对象
+    static char resp[ASR_RESPONSE_MAX];
+    int len = 0;
+    int n;
+    while (len < ASR_RESPONSE_MAX - 1 &&
+           (n = esp_http_client_read(client, resp + len, ASR_RESPONSE_MAX - 1 - len)) > 0) {
+        len += n;
+    }
+    resp[len] = '\0';
+    if (esp_http_client_is_complete_data_received(client)) {
+        esp_http_client_flush_response(client, NULL);   // 连接留给下一个语音段
+    } else {
+        esp_http_client_close(client);
+    }
+
+    bool ok = false;
+    cJSON *root = cJSON_Parse(resp);
+    const cJSON *field = cJSON_GetObjectItem(root, "text");
+    if (cJSON_IsString(field)) {
+        strlcpy(text, field->valuestring, text_size);
+        *confidence = 1.0f;
+        ok = text[0] != '\0';
+    } else {
+        ESP_LOGE(TAG, "识别结果格式错误: %.64s", resp);
+    }
+    cJSON_Delete(root);
+
+    ESP_LOGI(TAG, "语音段 %lu ms，识别耗时 %lu ms: %s", (unsigned long)(segment->frames * 10),
+             (unsigned long)((esp_timer_get_time() - start) / 1000), ok ? text : "(无)");
+    return ok;
+}
@@ -0,0 +1,19 @@
+#ifndef VOICE_ASR_H
+#define VOICE_ASR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "voice_processor.h"
+
+// 语音识别后端: 把 VAD 检出的语音段作为 16kHz 单声道 WAV 上传到 OpenAI 兼容的转写接口
+// (POST multipart/form-data: file, model, language, response_format=json)，响应 {"text": "..."}
+
+// menuconfig 中配置了识别接口
+bool voice_asr_is_configured(void);
+
+// 语音段回调 (交给 voice_set_segment_callback)，在识别任务中阻塞到收到结果；
+// 接口不返回置信度，识别出文字时 confidence 为 1.0
+bool voice_asr_recognize(const voice_segment_t *segment, char *text, size_t text_size, float *confidence);
+
+#endif // VOICE_ASR_H
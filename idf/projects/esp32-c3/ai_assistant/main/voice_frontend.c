@@ -0,0 +1,397 @@
+#include "voice_frontend.h"
+#include <math.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+// ESP32-S3 上用 esp-dsp 的 int16 复数 FFT (PIE SIMD 实现)，其他平台用下面的定点实现；
+// 两者每级蝶形都右移 1 位，结果同为 DFT / N
+#if CONFIG_IDF_TARGET_ESP32S3
+#define VOICE_FE_USE_ESP_DSP    1
+#include "dsps_fft2r.h"
+#else
+#define VOICE_FE_USE_ESP_DSP    0
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// VAD 阈值 (log2 能量 Q8: 256 = 3dB)
+#define VAD_SNR_ON          (3 * 256)       // 高出噪声底 9dB
+#define VAD_MIN_ENERGY      (19 * 256)      // 帧能量下限 (有效值约 -59dBFS，接近 MEMS 麦克风本底噪声)
+#define VAD_SPEECH_BAND     50              // 300~3400Hz 能量占比下限 (百分比)
+#define VAD_MAX_ZCR         (VOICE_FE_WIN * 45 / 100)   // 过零率上限 (白噪声约 50%)
+#define NOISE_INIT_FRAMES   10              // 开始 100ms 直接取最小能量作为噪声底
+#define NOISE_RISE          2               // 无声时噪声底每帧上升 (约 2dB/s)
+
+#define SPEECH_BIN_LO       (300 * VOICE_FE_FFT / VOICE_FE_SAMPLE_RATE)
+#define SPEECH_BIN_HI       (3400 * VOICE_FE_FFT / VOICE_FE_SAMPLE_RATE)
+#define MEL_F_MIN           20.0f
+#define MEL_F_MAX           7600.0f
+
+// 共享表 (第一次初始化时生成)
+static bool tables_ready = false;
+static int16_t hamming_q15[VOICE_FE_WIN];
+static uint8_t log2_frac[256];                  // log2(1 + i/256)，Q8
+static int16_t dct_q15[VOICE_FE_NUM_CEPS][VOICE_FE_NUM_MELS];
+static uint16_t mel_start[VOICE_FE_NUM_MELS];   // 每个滤波器的起始频点和宽度
+static uint16_t mel_len[VOICE_FE_NUM_MELS];
+static uint16_t mel_offset[VOICE_FE_NUM_MELS];  // 在 mel_weights 中的起始下标
+static int16_t mel_weights[2 * VOICE_FE_BINS];  // 三角滤波器权重，Q15
+#if !VOICE_FE_USE_ESP_DSP
+static int16_t fft_twiddle[VOICE_FE_FFT];       // cos / sin 交错，Q15
+static uint16_t fft_bitrev[VOICE_FE_FFT];
+#endif
+
+// FFT 工作区 (复数交错，只在前端任务中使用)
+static int16_t fft_buf[2 * VOICE_FE_FFT] __attribute__((aligned(16)));
+static uint32_t power[VOICE_FE_BINS];
+
+static float hz_to_mel(float hz)
+{
+    return 2595.0f * log10f(1.0f + hz / 700.0f);
+}
+
+static float mel_to_hz(float mel)
+{
+    return 700.0f * (powf(10.0f, mel / 2595.0f) - 1.0f);
+}
+
+static int16_t to_q15(float v)
+{
+    float q = roundf(v * 32768.0f);
+    return (int16_t)(q > 32767.0f ? 32767.0f : (q < -32768.0f ? -32768.0f : q));
+}
+
+static void tables_init(void)
+{
+    if (tables_ready) {
+        return;
+    }
+
+    for (int n = 0; n < VOICE_FE_WIN; n++) {
+        hamming_q15[n] = to_q15(0.54f - 0.46f * cosf(2.0f * (float)M_PI * n / (VOICE_FE_WIN - 1)));
+    }
+    for (int i = 0; i < 256; i++) {
+        log2_frac[i] = (uint8_t)lroundf(log2f(1.0f + i / 256.0f) * 256.0f);
+    }
+    for (int i = 0; i < VOICE_FE_NUM_CEPS; i++) {
+        float scale = sqrtf((i == 0 ? 1.0f : 2.0f) / VOICE_FE_NUM_MELS);
+        for (int m = 0; m < VOICE_FE_NUM_MELS; m++) {
+            dct_q15[i][m] = to_q15(scale * cosf((float)M_PI * i * (m + 0.5f) / VOICE_FE_NUM_MELS));
+        }
+    }
+
+    // 梅尔刻度上等距的三角滤波器 (HTK 公式)，权重按频点存放
+    float mel_lo = hz_to_mel(MEL_F_MIN);
+    float mel_hi = hz_to_mel(MEL_F_MAX);
+    float edges[VOICE_FE_NUM_MELS + 2];
+    for (int i = 0; i < VOICE_FE_NUM_MELS + 2; i++) {
+        float hz = mel_to_hz(mel_lo + (mel_hi - mel_lo) * i / (VOICE_FE_NUM_MELS + 1));
+        edges[i] = hz * VOICE_FE_FFT / VOICE_FE_SAMPLE_RATE;
+    }
+    uint16_t offset = 0;
+    for (int m = 0; m < VOICE_FE_NUM_MELS; m++) {
+        int lo = (int)ceilf(edges[m]);
+        int hi = (int)floorf(edges[m + 2]);
+        if (hi < lo) {
+            hi = lo;    // 低频滤波器窄于一个频点时至少覆盖中心附近的一个
+        }
+        mel_start[m] = (uint16_t)lo;
+        mel_len[m] = (uint16_t)(hi - lo + 1);
+        mel_offset[m] = offset;
+        for (int k = lo; k <= hi; k++) {
+            float w;
+            if (k <= edges[m + 1]) {
+                w = (k - edges[m]) / (edges[m + 1] - edges[m]);
+            } else {
+                w = (edges[m + 2] - k) / (edges[m + 2] - edges[m + 1]);
+            }
+            mel_weights[offset++] = to_q15(w < 0.0f ? 0.0f : (w > 0.9999f ? 0.9999f : w));
+        }
+    }
+
+#if VOICE_FE_USE_ESP_DSP
+    dsps_fft2r_init_sc16(NULL, VOICE_FE_FFT);
+#else
+    for (int k = 0; k < VOICE_FE_FFT / 2; k++) {
+        fft_twiddle[2 * k] = to_q15(cosf(2.0f * (float)M_PI * k / VOICE_FE_FFT));
+        fft_twiddle[2 * k + 1] = to_q15(sinf(2.0f * (float)M_PI * k / VOICE_FE_FFT));
+    }
+    int bits = 0;
+    while ((1 << bits) < VOICE_FE_FFT) {
+        bits++;
+    }
+    for (int i = 0; i < VOICE_FE_FFT; i++) {
+        uint16_t r = 0;
+        for (int b = 0; b < bits; b++) {
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        fft_bitrev[i] = r;
+    }
+#endif
+
+    tables_ready = true;
+}
+
+#if !VOICE_FE_USE_ESP_DSP
+// 原地 int16 复数 FFT (基 2 时间抽取)，每级右移 1 位防止溢出，结果为 DFT / N
+static void fft_sc16(int16_t *data)
+{
+    for (int i = 0; i < VOICE_FE_FFT; i++) {
+        int j = fft_bitrev[i];
+        if (j > i) {
+            int16_t re = data[2 * i], im = data[2 * i + 1];
+            data[2 * i] = data[2 * j];
+            data[2 * i + 1] = data[2 * j + 1];
+            data[2 * j] = re;
+            data[2 * j + 1] = im;
+        }
+    }
+
+    for (int len = 2; len <= VOICE_FE_FFT; len <<= 1) {
+        int half = len >> 1;
+        int step = VOICE_FE_FFT / len;
+        for (int base = 0; base < VOICE_FE_FFT; base += len) {
+            for (int j = 0; j < half; j++) {
+                int32_t wr = fft_twiddle[2 * j * step];
+                int32_t wi = fft_twiddle[2 * j * step + 1];
+                int16_t *a = &data[2 * (base + j)];
+                int16_t *b = &data[2 * (base + j + half)];
+                // b * e^(-jθ)
+                int32_t tr = (b[0] * wr + b[1] * wi + 0x4000) >> 15;
+                int32_t ti = (b[1] * wr - b[0] * wi + 0x4000) >> 15;
+                int32_t ar = a[0], ai = a[1];
+                a[0] = (int16_t)((ar + tr) >> 1);
+                a[1] = (int16_t)((ai + ti) >> 1);
+                b[0] = (int16_t)((ar - tr) >> 1);
+                b[1] = (int16_t)((ai - ti) >> 1);
+            }
+        }
+    }
+}
+#endif
+
+// log2(x)，Q8 (x 为 0 时按 1 计)
+static int32_t log2_q8(uint64_t x)
+{
+    if (x == 0) {
+        return 0;
+    }
+    int msb = 63 - __builtin_clzll(x);
+    uint32_t frac = msb >= 8 ? (uint32_t)(x >> (msb - 8)) & 0xFF : (uint32_t)(x << (8 - msb)) & 0xFF;
+    return (msb << 8) + log2_frac[frac];
+}
+
+static int16_t sat16(int32_t v)
+{
+    return (int16_t)(v > INT16_MAX ? INT16_MAX : (v < INT16_MIN ? INT16_MIN : v));
+}
+
+// 计算一帧的特征 (fe->window 为当前帧)
+static void analyze(voice_fe_t *fe, voice_fe_frame_t *frame)
+{
+    const int16_t *x = fe->window;
+
+    // 时域: 去直流后的能量和过零次数
+    int32_t sum = 0;
+    for (int n = 0; n < VOICE_FE_WIN; n++) {
+        sum += x[n];
+    }
+    int32_t mean = sum / VOICE_FE_WIN;
+    uint64_t energy = 0;
+    uint16_t zcr = 0;
+    int32_t prev = x[0] - mean;
+    for (int n = 0; n < VOICE_FE_WIN; n++) {
+        int32_t v = x[n] - mean;
+        energy += (uint64_t)((int64_t)v * v);
+        zcr += (v ^ prev) < 0;
+        prev = v;
+    }
+    frame->log_energy = sat16(log2_q8(energy));
+    frame->zcr = zcr;
+
+    // 块浮点: 先把整帧缩放到接近半幅 (小信号也保留足够的有效位)，再预加重 (系数 0.97) 并加窗
+    int32_t peak = 0;
+    for (int n = 0; n < VOICE_FE_WIN; n++) {
+        int32_t a = x[n] < 0 ? -x[n] : x[n];
+        if (a > peak) {
+            peak = a;
+        }
+    }
+    int shift = peak >= 16384 ? -1 : 0;     // 预加重最多放大到 2 倍，超过半幅时先缩小
+    while (peak != 0 && (peak << (shift + 1)) < 16384) {
+        shift++;
+    }
+    int32_t last = shift >= 0 ? x[0] << shift : x[0] >> 1;
+    for (int n = 0; n < VOICE_FE_WIN; n++) {
+        int32_t cur = shift >= 0 ? x[n] << shift : x[n] >> 1;
+        int32_t y = (cur * 32768 - last * 31785) >> 15;
+        last = cur;
+        fft_buf[2 * n] = (int16_t)((y * hamming_q15[n]) >> 15);
+        fft_buf[2 * n + 1] = 0;
+    }
+    memset(&fft_buf[2 * VOICE_FE_WIN], 0, sizeof(int16_t) * 2 * (VOICE_FE_FFT - VOICE_FE_WIN));
+
+#if VOICE_FE_USE_ESP_DSP
+    dsps_fft2r_sc16(fft_buf, VOICE_FE_FFT);
+    dsps_bit_rev_sc16_ansi(fft_buf, VOICE_FE_FFT);
+#else
+    fft_sc16(fft_buf);
+#endif
+
+    // 功率谱和语音频带占比
+    uint64_t total = 0, band = 0;
+    for (int k = 0; k < VOICE_FE_BINS; k++) {
+        int32_t re = fft_buf[2 * k], im = fft_buf[2 * k + 1];
+        power[k] = (uint32_t)(re * re) + (uint32_t)(im * im);
+        if (k > 0) {
+            total += power[k];
+            if (k >= SPEECH_BIN_LO && k <= SPEECH_BIN_HI) {
+                band += power[k];
+            }
+        }
+    }
+    frame->speech_band = total ? (uint8_t)(band * 100 / total) : 0;
+
+    // log2 梅尔能量: 还原 FFT 缩放 (×N) 和块浮点缩放 (÷2^shift)，功率为其平方；权重为 Q15 再减去 15
+    int32_t gain_q8 = (2 * (9 - shift) - 15) * 256;
+    for (int m = 0; m < VOICE_FE_NUM_MELS; m++) {
+        uint64_t e = 0;
+        const int16_t *w = &mel_weights[mel_offset[m]];
+        const uint32_t *p = &power[mel_start[m]];
+        for (int i = 0; i < mel_len[m]; i++) {
+            e += (uint64_t)p[i] * (uint16_t)w[i];
+        }
+        frame->log_mel[m] = sat16(log2_q8(e + 1) + gain_q8);
+    }
+
+    // MFCC: DCT-II，Q8 × Q15 → Q6
+    for (int i = 0; i < VOICE_FE_NUM_CEPS; i++) {
+        int64_t acc = 0;
+        for (int m = 0; m < VOICE_FE_NUM_MELS; m++) {
+            acc += (int32_t)dct_q15[i][m] * frame->log_mel[m];
+        }
+        frame->mfcc[i] = sat16((int32_t)(acc >> 17));
+    }
+}
+
+// 有声判决，同时更新噪声底
+static bool vad_decide(voice_fe_t *fe, voice_fe_frame_t *frame)
+{
+    int32_t e = frame->log_energy;
+    if (fe->frames < NOISE_INIT_FRAMES) {
+        if (fe->frames == 0 || e < fe->noise_floor) {
+            fe->noise_floor = e;
+        }
+    }
+
+    int32_t floor = fe->noise_floor > VAD_MIN_ENERGY ? fe->noise_floor : VAD_MIN_ENERGY;
+    frame->snr = sat16(e - floor);
+    bool voiced = fe->frames >= NOISE_INIT_FRAMES &&
+                  e - floor >= VAD_SNR_ON &&
+                  frame->speech_band >= VAD_SPEECH_BAND &&
+                  frame->zcr <= VAD_MAX_ZCR;
+
+    // 噪声底: 能量更低时较快跟随，无声时缓慢上升 (适应背景噪声变大)
+    if (fe->frames >= NOISE_INIT_FRAMES) {
+        if (e < fe->noise_floor) {
+            fe->noise_floor += (e - fe->noise_floor) >> 2;
+        } else if (!voiced && !fe->in_speech) {
+            fe->noise_floor += NOISE_RISE;
+        }
+    }
+    return voiced;
+}
+
+static void segment_end(voice_fe_t *fe)
+{
+    if (fe->sink.on_end != NULL) {
+        fe->sink.on_end(fe->segment_frames, fe->sink.arg);
+    }
+    fe->in_speech = false;
+    fe->segment_frames = 0;
+    fe->silence_run = 0;
+    fe->voiced_run = 0;
+    fe->history_count = 0;
+}
+
+static void emit(voice_fe_t *fe, const int16_t *pcm, const voice_fe_frame_t *frame)
+{
+    fe->segment_frames++;
+    if (fe->sink.on_frame != NULL) {
+        fe->sink.on_frame(pcm, frame, fe->sink.arg);
+    }
+}
+
+void voice_fe_init(voice_fe_t *fe, const voice_fe_sink_t *sink)
+{
+    tables_init();
+    memset(fe, 0, sizeof(*fe));
+    if (sink != NULL) {
+        fe->sink = *sink;
+    }
+}
+
+bool voice_fe_process(voice_fe_t *fe, const int16_t *hop, voice_fe_frame_t *frame)
+{
+    voice_fe_frame_t local;
+    if (frame == NULL) {
+        frame = &local;
+    }
+
+    memmove(fe->window, fe->window + VOICE_FE_HOP, sizeof(int16_t) * (VOICE_FE_WIN - VOICE_FE_HOP));
+    memcpy(fe->window + VOICE_FE_WIN - VOICE_FE_HOP, hop, sizeof(int16_t) * VOICE_FE_HOP);
+
+    analyze(fe, frame);
+    frame->voiced = vad_decide(fe, frame);
+    fe->frames++;
+
+    if (fe->in_speech) {
+        emit(fe, hop, frame);
+        fe->silence_run = frame->voiced ? 0 : fe->silence_run + 1;
+        if (fe->silence_run >= VOICE_FE_HANGOVER || fe->segment_frames >= VOICE_FE_MAX_SEGMENT) {
+            segment_end(fe);
+        }
+        return true;
+    }
+
+    // 语音开始之前的帧先放入预滚缓冲
+    int slot = (fe->history_head + fe->history_count) % VOICE_FE_PREROLL;
+    if (fe->history_count == VOICE_FE_PREROLL) {
+        fe->history_head = (fe->history_head + 1) % VOICE_FE_PREROLL;
+    } else {
+        fe->history_count++;
+    }
+    memcpy(fe->history_pcm[slot], hop, sizeof(fe->history_pcm[slot]));
+    fe->history[slot] = *frame;
+
+    fe->voiced_run = frame->voiced ? fe->voiced_run + 1 : 0;
+    if (fe->voiced_run < VOICE_FE_START_FRAMES) {
+        return false;
+    }
+
+    // 语音开始: 先补发预滚缓冲中的帧 (含本帧)
+    fe->in_speech = true;
+    fe->silence_run = 0;
+    if (fe->sink.on_start != NULL) {
+        fe->sink.on_start(fe->sink.arg);
+    }
+    for (int i = 0; i < fe->history_count; i++) {
+        int idx = (fe->history_head + i) % VOICE_FE_PREROLL;
+        emit(fe, fe->history_pcm[idx], &fe->history[idx]);
+    }
+    fe->history_head = 0;
+    fe->history_count = 0;
+    return true;
+}
+
+void voice_fe_flush(voice_fe_t *fe)
+{
+    if (fe->in_speech) {
+        segment_end(fe);
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef VOICE_FRONTEND_H
+#define VOICE_FRONTEND_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// 语音前端：定点 VAD (能量、过零率、语音频带占比) 和 log-mel / MFCC 特征。
+// 不依赖 ESP-IDF 驱动，可以在主机上编译 (见 tools/voice_frontend_bench.c)；
+// ESP32-S3 上 FFT 使用 esp-dsp 的 SIMD 实现，其他平台使用本文件中的定点实现
+
+// 帧参数 (16kHz 单声道)
+#define VOICE_FE_SAMPLE_RATE    16000
+#define VOICE_FE_HOP            160     // 帧移 10ms，每次输入的采样数
+#define VOICE_FE_WIN            400     // 帧长 25ms
+#define VOICE_FE_FFT            512
+#define VOICE_FE_BINS           (VOICE_FE_FFT / 2 + 1)
+#define VOICE_FE_NUM_MELS       40
+#define VOICE_FE_NUM_CEPS       13
+
+// 语音段判定 (单位: 帧)
+#define VOICE_FE_START_FRAMES   4       // 连续 4 帧有声判为语音开始 (滤掉按键声等短促噪声)
+#define VOICE_FE_HANGOVER       30      // 连续 300ms 无声判为语音结束
+#define VOICE_FE_PREROLL        20      // 语音段向前多保留 200ms (开头的辅音能量低，常在判定之前)
+#define VOICE_FE_MAX_SEGMENT    800     // 语音段最长 8s，超过时强制结束
+
+// 一帧的特征
+typedef struct {
+    int16_t log_mel[VOICE_FE_NUM_MELS];     // log2 梅尔能量，Q8
+    int16_t mfcc[VOICE_FE_NUM_CEPS];        // 倒谱系数 (log2 梅尔能量的 DCT-II)，Q6
+    int16_t log_energy;                     // log2 帧能量 (去直流)，Q8
+    int16_t snr;                            // 高出噪声底的 log2 能量，Q8
+    uint16_t zcr;                           // 帧内过零次数
+    uint8_t speech_band;                    // 300~3400Hz 能量占比 (百分比)
+    bool voiced;                            // 本帧是否判为有声
+} voice_fe_frame_t;
+
+// 语音段输出：只有判为语音的部分 (含预滚和结尾的静音保持) 经过这些回调
+typedef struct {
+    void (*on_start)(void *arg);
+    void (*on_frame)(const int16_t *pcm, const voice_fe_frame_t *frame, void *arg);  // pcm 为该帧移的 VOICE_FE_HOP 个采样
+    void (*on_end)(uint32_t frames, void *arg);
+    void *arg;
+} voice_fe_sink_t;
+
+// 前端状态 (由调用方分配，约 10KB)
+typedef struct {
+    voice_fe_sink_t sink;
+    int16_t window[VOICE_FE_WIN];           // 最近一个帧长的采样
+    int32_t noise_floor;                    // 噪声底 (log2 能量，Q8)
+    uint32_t frames;
+    uint16_t voiced_run;                    // 连续有声帧数
+    uint16_t silence_run;                   // 语音段中连续无声帧数
+    uint32_t segment_frames;
+    bool in_speech;
+    // 预滚缓冲 (环形)：语音开始判定前的帧
+    uint8_t history_head;
+    uint8_t history_count;
+    int16_t history_pcm[VOICE_FE_PREROLL][VOICE_FE_HOP];
+    voice_fe_frame_t history[VOICE_FE_PREROLL];
+} voice_fe_t;
+
+// 初始化 (第一次调用时生成窗函数、梅尔滤波器等共享表)
+void voice_fe_init(voice_fe_t *fe, const voice_fe_sink_t *sink);
+
+// 处理一个帧移 (VOICE_FE_HOP 个采样)，frame 可以为 NULL；返回本帧是否处于语音段中
+bool voice_fe_process(voice_fe_t *fe, const int16_t *hop, voice_fe_frame_t *frame);
+
+// 结束当前语音段 (停止采集时调用)
+void voice_fe_flush(voice_fe_t *fe);
+
+#endif // VOICE_FRONTEND_H
@@ -1,11 +1,17 @@
 #include "voice_processor.h"
+#include "voice_tts.h"
 #include "esp_log.h"
 #include "esp_system.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
-#include "driver/i2s.h"
+#include "driver/i2s_std.h"
 #include "driver/gpio.h"
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include <math.h>
+#include <stdlib.h>
 #include <string.h>
 
 static const char *TAG = "VOICE_PROCESSOR";
@@ -28,35 +34,191 @@ static tts_config_t tts_config = {
 // 语音识别回调
 static voice_recognize_callback_t recognize_callback = NULL;
 
-// 语音识别任务句柄
+static voice_segment_callback_t segment_callback = NULL;
+
+// 采集任务句柄
 static TaskHandle_t voice_task_handle = NULL;
-static bool voice_recognition_running = false;
+static volatile bool voice_recognition_running = false;
 
-// I2S配置
+// I2S配置 (引脚在 menuconfig 的 AI Assistant Voice I/O 中设置)
 #define I2S_NUM I2S_NUM_0
-#define I2S_BCK_IO 26
-#define I2S_WS_IO 25
-#define I2S_DO_IO 22
-#define I2S_DI_IO 21
+#define I2S_BCK_IO CONFIG_AI_I2S_BCK_GPIO
+#define I2S_WS_IO CONFIG_AI_I2S_WS_GPIO
+#define I2S_DO_IO CONFIG_AI_I2S_DO_GPIO
+#define I2S_DI_IO CONFIG_AI_I2S_DI_GPIO
+
+// I2S 全双工通道，每个 DMA 缓冲正好一个帧移 (10ms)，最多缓冲 80ms
+#define I2S_DMA_DESC_NUM        8
+static i2s_chan_handle_t tx_handle = NULL;
+static i2s_chan_handle_t rx_handle = NULL;
+
+// 采集任务独占一个核 (双核时为核 1，网络协议栈在核 0)，优先级高于识别和网络任务
+#if CONFIG_FREERTOS_UNICORE
+#define VOICE_CAPTURE_CORE      0
+#else
+#define VOICE_CAPTURE_CORE      1
+#endif
+#define VOICE_CAPTURE_PRIORITY  (configMAX_PRIORITIES - 2)
+#define VOICE_RECOGNIZE_PRIORITY 5
+
+// 语音段缓冲: 两个轮流使用 (识别上一段时可以继续采集下一段)，优先放在 PSRAM
+#define SEGMENT_SLOTS           2
+#define SEGMENT_MAX_SAMPLES     (VOICE_FE_MAX_SEGMENT * VOICE_FE_HOP)
+
+typedef struct {
+    int16_t *pcm;
+    int16_t (*mfcc)[VOICE_FE_NUM_CEPS];
+    uint32_t frames;
+    uint32_t start_ms;
+} segment_slot_t;
+
+static segment_slot_t segment_slots[SEGMENT_SLOTS];
+static QueueHandle_t free_slots = NULL;         // 空闲缓冲下标
+static QueueHandle_t ready_slots = NULL;        // 待识别的缓冲下标
+static int current_slot = -1;                   // 采集任务正在写入的缓冲，-1 表示本段已丢弃
+static int64_t capture_start_us = 0;
+
+// 采集统计 (采集任务写入，其他任务读取)
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static voice_stats_t stats;
+static uint64_t process_us_sum = 0;
 
-// 语音识别任务
-static void voice_recognition_task(void *pvParameters)
+static void *segment_alloc(size_t size)
 {
-    ESP_LOGI(TAG, "语音识别任务启动");
-    
-    // 模拟语音识别过程
+    void *ptr = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (ptr == NULL) {
+        ptr = heap_caps_malloc(size, MALLOC_CAP_8BIT);
+    }
+    return ptr;
+}
+
+// DMA 接收队列溢出 (中断上下文)
+static bool IRAM_ATTR voice_on_recv_overflow(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx)
+{
+    portENTER_CRITICAL_ISR(&stats_lock);
+    stats.overruns++;
+    portEXIT_CRITICAL_ISR(&stats_lock);
+    return false;
+}
+
+// 以下三个回调在采集任务中由语音前端调用
+static void segment_on_start(void *arg)
+{
+    uint8_t idx;
+    if (xQueueReceive(free_slots, &idx, 0) != pdTRUE) {
+        current_slot = -1;
+        portENTER_CRITICAL(&stats_lock);
+        stats.dropped++;
+        portEXIT_CRITICAL(&stats_lock);
+        return;
+    }
+    current_slot = idx;
+    segment_slots[idx].frames = 0;
+    segment_slots[idx].start_ms = (uint32_t)((esp_timer_get_time() - capture_start_us) / 1000);
+}
+
+static void segment_on_frame(const int16_t *pcm, const voice_fe_frame_t *frame, void *arg)
+{
+    if (current_slot < 0) {
+        return;
+    }
+    segment_slot_t *slot = &segment_slots[current_slot];
+    if (slot->frames >= VOICE_FE_MAX_SEGMENT) {
+        return;
+    }
+    memcpy(slot->pcm + slot->frames * VOICE_FE_HOP, pcm, VOICE_FE_HOP * sizeof(int16_t));
+    memcpy(slot->mfcc[slot->frames], frame->mfcc, sizeof(frame->mfcc));
+    slot->frames++;
+}
+
+static void segment_on_end(uint32_t frames, void *arg)
+{
+    if (current_slot < 0) {
+        return;
+    }
+    uint8_t idx = (uint8_t)current_slot;
+    current_slot = -1;
+    xQueueSend(ready_slots, &idx, 0);   // 队列长度等于缓冲数，不会满
+    portENTER_CRITICAL(&stats_lock);
+    stats.segments++;
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+// 采集任务: 每次读取一个帧移，经过 VAD 和特征提取，只有语音段进入缓冲
+static void voice_capture_task(void *pvParameters)
+{
+    static voice_fe_t fe;           // 约 10KB，不放在任务栈上
+    static int16_t hop[VOICE_FE_HOP];
+    const voice_fe_sink_t sink = {
+        .on_start = segment_on_start,
+        .on_frame = segment_on_frame,
+        .on_end = segment_on_end,
+        .arg = NULL,
+    };
+    voice_fe_init(&fe, &sink);
+    capture_start_us = esp_timer_get_time();
+
+    ESP_LOGI(TAG, "语音采集任务启动 (核 %d)", xPortGetCoreID());
+
     while (voice_recognition_running) {
-        // 这里应该实现真正的语音识别
-        // 暂时模拟识别结果
-        vTaskDelay(pdMS_TO_TICKS(5000)); // 5秒模拟一次识别
-        
-        if (recognize_callback != NULL) {
-            // 模拟识别到"你好小智"
-            recognize_callback("你好小智", 0.85);
+        size_t bytes_read = 0;
+        esp_err_t ret = i2s_channel_read(rx_handle, hop, sizeof(hop), &bytes_read, pdMS_TO_TICKS(100));
+        if (ret != ESP_OK || bytes_read != sizeof(hop)) {
+            portENTER_CRITICAL(&stats_lock);
+            stats.read_errors++;
+            portEXIT_CRITICAL(&stats_lock);
+            continue;
         }
+
+        int64_t start = esp_timer_get_time();
+        voice_fe_process(&fe, hop, NULL);
+        uint32_t us = (uint32_t)(esp_timer_get_time() - start);
+
+        portENTER_CRITICAL(&stats_lock);
+        stats.hops++;
+        process_us_sum += us;
+        if (us > stats.max_us) {
+            stats.max_us = us;
+        }
+        portEXIT_CRITICAL(&stats_lock);
+    }
+
+    voice_fe_flush(&fe);    // 正在进行的语音段也交给识别
+    i2s_channel_disable(rx_handle);
+
+    ESP_LOGI(TAG, "语音采集任务结束");
+    voice_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+// 识别任务: 把语音段交给识别器，识别出的文字交给语音识别回调
+static void voice_recognize_task(void *pvParameters)
+{
+    static char text[256];
+    uint8_t idx;
+
+    while (xQueueReceive(ready_slots, &idx, portMAX_DELAY) == pdTRUE) {
+        segment_slot_t *slot = &segment_slots[idx];
+        voice_segment_t segment = {
+            .pcm = slot->pcm,
+            .samples = slot->frames * VOICE_FE_HOP,
+            .mfcc = (const int16_t (*)[VOICE_FE_NUM_CEPS])slot->mfcc,
+            .frames = slot->frames,
+            .start_ms = slot->start_ms,
+        };
+        ESP_LOGD(TAG, "语音段 %lu ms 起，时长 %lu ms", (unsigned long)segment.start_ms,
+                 (unsigned long)(segment.frames * 10));
+
+        voice_segment_callback_t recognizer = segment_callback;
+        float confidence = 0.0f;
+        text[0] = '\0';
+        if (recognizer != NULL && recognizer(&segment, text, sizeof(text), &confidence) &&
+            text[0] != '\0' && recognize_callback != NULL) {
+            recognize_callback(text, confidence);
+        }
+
+        xQueueSend(free_slots, &idx, 0);
     }
-    
-    ESP_LOGI(TAG, "语音识别任务结束");
     vTaskDelete(NULL);
 }
 
@@ -64,42 +226,98 @@ esp_err_t voice_processor_init(void)
 {
     ESP_LOGI(TAG, "初始化语音处理器");
     
-    // 配置I2S
-    i2s_config_t i2s_config = {
-        .mode = I2S_MODE_MASTER | I2S_MODE_TX | I2S_MODE_RX,
-        .sample_rate = voice_config.sample_rate,
-        .bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT,
-        .channel_format = I2S_CHANNEL_FMT_ONLY_LEFT,
-        .communication_format = I2S_COMM_FORMAT_STAND_I2S,
-        .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
-        .dma_buf_count = 8,
-        .dma_buf_len = 64,
-        .use_apll = false,
-        .tx_desc_auto_clear = true,
-        .fixed_mclk = 0
-    };
-    
-    i2s_pin_config_t pin_config = {
-        .bck_io_num = I2S_BCK_IO,
-        .ws_io_num = I2S_WS_IO,
-        .data_out_num = I2S_DO_IO,
-        .data_in_num = I2S_DI_IO
-    };
-    
-    esp_err_t ret = i2s_driver_install(I2S_NUM, &i2s_config, 0, NULL);
+    if (voice_config.sample_rate != VOICE_FE_SAMPLE_RATE) {
+        ESP_LOGW(TAG, "语音前端只支持 %d Hz，忽略配置的采样率 %d Hz", VOICE_FE_SAMPLE_RATE, voice_config.sample_rate);
+        voice_config.sample_rate = VOICE_FE_SAMPLE_RATE;
+    }
+
+    // menuconfig 只能检查范围 (ESP32-S3 没有 GPIO22~25)
+    if (!GPIO_IS_VALID_OUTPUT_GPIO(I2S_BCK_IO) || !GPIO_IS_VALID_OUTPUT_GPIO(I2S_WS_IO) ||
+        !GPIO_IS_VALID_OUTPUT_GPIO(I2S_DO_IO) || !GPIO_IS_VALID_GPIO(I2S_DI_IO)) {
+        ESP_LOGE(TAG, "I2S引脚无效: BCK %d, WS %d, DO %d, DI %d", I2S_BCK_IO, I2S_WS_IO, I2S_DO_IO, I2S_DI_IO);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // 配置I2S (全双工: 扬声器和麦克风共用 BCK/WS)
+    i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM, I2S_ROLE_MASTER);
+    chan_cfg.dma_desc_num = I2S_DMA_DESC_NUM;
+    chan_cfg.dma_frame_num = VOICE_FE_HOP;
+    chan_cfg.auto_clear = true;
+
+    esp_err_t ret = i2s_new_channel(&chan_cfg, &tx_handle, &rx_handle);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "I2S驱动安装失败: %s", esp_err_to_name(ret));
+        ESP_LOGE(TAG, "I2S通道创建失败: %s", esp_err_to_name(ret));
         return ret;
     }
-    
-    ret = i2s_set_pin(I2S_NUM, &pin_config);
+
+    i2s_std_config_t std_cfg = {
+        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(VOICE_FE_SAMPLE_RATE),
+        .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_MONO),
+        .gpio_cfg = {
+            .mclk = I2S_GPIO_UNUSED,
+            .bclk = I2S_BCK_IO,
+            .ws = I2S_WS_IO,
+            .dout = I2S_DO_IO,
+            .din = I2S_DI_IO,
+            .invert_flags = {
+                .mclk_inv = false,
+                .bclk_inv = false,
+                .ws_inv = false,
+            },
+        },
+    };
+
+    ret = i2s_channel_init_std_mode(tx_handle, &std_cfg);
+    if (ret == ESP_OK) {
+        ret = i2s_channel_init_std_mode(rx_handle, &std_cfg);
+    }
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "I2S引脚配置失败: %s", esp_err_to_name(ret));
+        i2s_del_channel(tx_handle);
+        i2s_del_channel(rx_handle);
+        tx_handle = NULL;
+        rx_handle = NULL;
         return ret;
     }
-    
+
+    const i2s_event_callbacks_t cbs = {
+        .on_recv_q_ovf = voice_on_recv_overflow,
+    };
+    i2s_channel_register_event_callback(rx_handle, &cbs, NULL);
+
+    // 播放通道一直打开；采集通道在开始识别时打开
+    ret = i2s_channel_enable(tx_handle);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "I2S播放通道启动失败: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    // 语音段缓冲和识别任务
+    free_slots = xQueueCreate(SEGMENT_SLOTS, sizeof(uint8_t));
+    ready_slots = xQueueCreate(SEGMENT_SLOTS, sizeof(uint8_t));
+    if (free_slots == NULL || ready_slots == NULL) {
+        ESP_LOGE(TAG, "语音段队列创建失败");
+        return ESP_ERR_NO_MEM;
+    }
+    for (uint8_t i = 0; i < SEGMENT_SLOTS; i++) {
+        segment_slots[i].pcm = segment_alloc(SEGMENT_MAX_SAMPLES * sizeof(int16_t));
+        segment_slots[i].mfcc = segment_alloc(VOICE_FE_MAX_SEGMENT * sizeof(*segment_slots[i].mfcc));
+        if (segment_slots[i].pcm == NULL || segment_slots[i].mfcc == NULL) {
+            ESP_LOGE(TAG, "语音段缓冲分配失败");
+            return ESP_ERR_NO_MEM;
+        }
+        xQueueSend(free_slots, &i, 0);
+    }
+
+    if (xTaskCreate(voice_recognize_task, "voice_recognize", 4096, NULL,
+                    VOICE_RECOGNIZE_PRIORITY, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "语音识别任务创建失败");
+        return ESP_FAIL;
+    }
+
     ESP_LOGI(TAG, "语音处理器初始化完成");
     ESP_LOGI(TAG, "采样率: %d Hz", voice_config.sample_rate);
+    ESP_LOGI(TAG, "I2S引脚: BCK %d, WS %d, DO %d, DI %d", I2S_BCK_IO, I2S_WS_IO, I2S_DO_IO, I2S_DI_IO);
     ESP_LOGI(TAG, "语言: %s", voice_config.language);
     
     return ESP_OK;
@@ -112,18 +330,34 @@ esp_err_t voice_recognize_start(void)
         return ESP_OK;
     }
     
+    if (rx_handle == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (voice_task_handle != NULL) {
+        ESP_LOGW(TAG, "上一次采集尚未结束");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t err = i2s_channel_enable(rx_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "I2S采集通道启动失败: %s", esp_err_to_name(err));
+        return err;
+    }
+
     voice_recognition_running = true;
     
-    BaseType_t ret = xTaskCreate(voice_recognition_task, 
-                                "voice_recognition", 
-                                4096, 
-                                NULL, 
-                                5, 
-                                &voice_task_handle);
+    BaseType_t ret = xTaskCreatePinnedToCore(voice_capture_task,
+                                             "voice_capture",
+                                             4096,
+                                             NULL,
+                                             VOICE_CAPTURE_PRIORITY,
+                                             &voice_task_handle,
+                                             VOICE_CAPTURE_CORE);
     
     if (ret != pdPASS) {
-        ESP_LOGE(TAG, "语音识别任务创建失败");
+        ESP_LOGE(TAG, "语音采集任务创建失败");
         voice_recognition_running = false;
+        i2s_channel_disable(rx_handle);
         return ESP_FAIL;
     }
     
@@ -138,11 +372,10 @@ esp_err_t voice_recognize_stop(void)
         return ESP_OK;
     }
     
+    // 采集任务在下一次读取返回后 (最多 100ms) 自行结束，并把未结束的语音段交给识别
     voice_recognition_running = false;
-    
-    if (voice_task_handle != NULL) {
-        vTaskDelete(voice_task_handle);
-        voice_task_handle = NULL;
+    for (int i = 0; i < 20 && voice_task_handle != NULL; i++) {
+        vTaskDelay(pdMS_TO_TICKS(10));
     }
     
     ESP_LOGI(TAG, "语音识别已停止");
@@ -157,39 +390,36 @@ esp_err_t voice_synthesize(const char *text, const char *voice_type)
     
     ESP_LOGI(TAG, "语音合成: %s", text);
     
-    // 这里应该实现真正的TTS
-    // 暂时模拟语音合成过程
-    
-    // 生成简单的音频数据（正弦波）
-    const int sample_rate = 16000;
-    const int duration_ms = 1000; // 1秒
-    const int samples = sample_rate * duration_ms / 1000;
-    const float frequency = 440.0; // A4音符
-    
-    int16_t *audio_buffer = malloc(samples * sizeof(int16_t));
-    if (audio_buffer == NULL) {
-        ESP_LOGE(TAG, "音频缓冲区分配失败");
-        return ESP_ERR_NO_MEM;
-    }
-    
-    // 生成正弦波
-    for (int i = 0; i < samples; i++) {
-        float t = (float)i / sample_rate;
-        audio_buffer[i] = (int16_t)(32767.0 * sin(2.0 * M_PI * frequency * t));
+    // 配置了 TTS 后端时流式下载并播放 (立即返回，新的语句会打断正在播放的语句)
+    if (voice_tts_is_configured()) {
+        return voice_tts_speak(text, voice_type ? voice_type : tts_config.voice_type, tts_config.speed);
     }
     
-    // 播放音频
-    size_t bytes_written = 0;
-    esp_err_t ret = i2s_write(I2S_NUM, audio_buffer, samples * sizeof(int16_t), &bytes_written, portMAX_DELAY);
-    
-    free(audio_buffer);
-    
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "音频播放失败: %s", esp_err_to_name(ret));
-        return ret;
+    // 没有后端时播放提示音 (440Hz，200ms)：按帧移生成，振荡器递推代替逐点 sin()
+    static int16_t chunk[VOICE_FE_HOP];
+    const float w = 2.0f * (float)M_PI * 440.0f / VOICE_FE_SAMPLE_RATE;
+    float y1 = -16384.0f * sinf(w);         // 半幅正弦的前两个采样 y[-1]、y[-2]
+    float y2 = -16384.0f * sinf(2.0f * w);
+    const float k = 2.0f * cosf(w);
+    size_t total = 0;
+    
+    for (int hop = 0; hop < 20; hop++) {
+        for (int i = 0; i < VOICE_FE_HOP; i++) {
+            float y = k * y1 - y2;
+            y2 = y1;
+            y1 = y;
+            chunk[i] = (int16_t)y;
+        }
+        size_t bytes_written = 0;
+        esp_err_t ret = i2s_channel_write(tx_handle, chunk, sizeof(chunk), &bytes_written, portMAX_DELAY);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "音频播放失败: %s", esp_err_to_name(ret));
+            return ret;
+        }
+        total += bytes_written;
     }
     
-    ESP_LOGI(TAG, "语音合成完成，播放了 %zu 字节", bytes_written);
+    ESP_LOGI(TAG, "未配置TTS后端，播放了提示音 %zu 字节", total);
     return ESP_OK;
 }
 
@@ -224,14 +454,14 @@ esp_err_t voice_play_audio(const char *audio_data, size_t length)
     }
     
     size_t bytes_written = 0;
-    esp_err_t ret = i2s_write(I2S_NUM, audio_data, length, &bytes_written, portMAX_DELAY);
+    esp_err_t ret = i2s_channel_write(tx_handle, audio_data, length, &bytes_written, portMAX_DELAY);
     
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "音频播放失败: %s", esp_err_to_name(ret));
         return ret;
     }
     
-    ESP_LOGI(TAG, "音频播放完成，播放了 %zu 字节", bytes_written);
+    ESP_LOGD(TAG, "音频播放完成，播放了 %zu 字节", bytes_written);
     return ESP_OK;
 }
 
@@ -240,9 +470,17 @@ esp_err_t voice_record_audio(char *audio_buffer, size_t buffer_size)
     if (audio_buffer == NULL || buffer_size == 0) {
         return ESP_ERR_INVALID_ARG;
     }
+    if (voice_recognition_running) {
+        return ESP_ERR_INVALID_STATE;     // 采集任务正在读取
+    }
     
     size_t bytes_read = 0;
-    esp_err_t ret = i2s_read(I2S_NUM, audio_buffer, buffer_size, &bytes_read, portMAX_DELAY);
+    esp_err_t ret = i2s_channel_enable(rx_handle);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    ret = i2s_channel_read(rx_handle, audio_buffer, buffer_size, &bytes_read, portMAX_DELAY);
+    i2s_channel_disable(rx_handle);
     
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "音频录制失败: %s", esp_err_to_name(ret));
@@ -259,3 +497,17 @@ esp_err_t voice_set_recognize_callback(voice_recognize_callback_t callback)
     ESP_LOGI(TAG, "语音识别回调已设置");
     return ESP_OK;
 }
+
+esp_err_t voice_set_segment_callback(voice_segment_callback_t callback)
+{
+    segment_callback = callback;
+    return ESP_OK;
+}
+
+void voice_get_stats(voice_stats_t *out)
+{
+    portENTER_CRITICAL(&stats_lock);
+    *out = stats;
+    out->avg_us = stats.hops ? (uint32_t)(process_us_sum / stats.hops) : 0;
+    portEXIT_CRITICAL(&stats_lock);
+}
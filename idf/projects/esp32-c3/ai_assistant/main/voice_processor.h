@@ -3,6 +3,7 @@
 
 #include "esp_err.h"
 #include "ai_engine.h"
+#include "voice_frontend.h"
 
 // 语音识别配置
 typedef struct {
@@ -24,6 +25,7 @@ typedef struct {
 esp_err_t voice_processor_init(void);
 esp_err_t voice_recognize_start(void);
 esp_err_t voice_recognize_stop(void);
+// 配置了 TTS 后端时流式播放并立即返回 (见 voice_tts.h)，否则播放提示音
 esp_err_t voice_synthesize(const char *text, const char *voice_type);
 esp_err_t voice_set_config(voice_config_t *config);
 esp_err_t voice_set_tts_config(tts_config_t *config);
@@ -36,4 +38,33 @@ typedef void (*voice_recognize_callback_t)(const char *text, float confidence);
 // 设置语音识别回调
 esp_err_t voice_set_recognize_callback(voice_recognize_callback_t callback);
 
+// 语音段：采集任务由 VAD 检出的一段语音 (含预滚和结尾的静音保持)
+typedef struct {
+    const int16_t *pcm;                             // 16kHz 单声道 PCM
+    size_t samples;
+    const int16_t (*mfcc)[VOICE_FE_NUM_CEPS];       // 每个帧移一组 MFCC (Q6)
+    uint32_t frames;
+    uint32_t start_ms;                              // 语音段开始时间 (从启动采集算起)
+} voice_segment_t;
+
+// 识别器回调: 在识别任务中调用 (不占用采集核)，识别出文字时写入 text 并返回 true，
+// 之后会以该文字调用语音识别回调。segment 中的数据只在回调期间有效
+typedef bool (*voice_segment_callback_t)(const voice_segment_t *segment, char *text, size_t text_size,
+                                         float *confidence);
+
+esp_err_t voice_set_segment_callback(voice_segment_callback_t callback);
+
+// 采集统计
+typedef struct {
+    uint32_t hops;              // 已处理的帧移数 (每个 10ms)
+    uint32_t read_errors;       // I2S 读取超时或不完整
+    uint32_t overruns;          // DMA 接收队列溢出 (采集任务没有及时读取)
+    uint32_t avg_us;            // 每个帧移的前端处理耗时
+    uint32_t max_us;
+    uint32_t segments;          // 交给识别的语音段
+    uint32_t dropped;           // 识别跟不上 (两个缓冲都在使用) 而丢弃的语音段
+} voice_stats_t;
+
+void voice_get_stats(voice_stats_t *stats);
+
 #endif // VOICE_PROCESSOR_H
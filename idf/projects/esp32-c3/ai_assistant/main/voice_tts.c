@@ -0,0 +1,561 @@
+#include "voice_tts.h"
+#include "voice_processor.h"
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_http_client.h"
+#include "esp_crt_bundle.h"
+#include "esp_timer.h"
+#include "cJSON.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/stream_buffer.h"
+#include <string.h>
+#include <stdlib.h>
+
+static const char *TAG = "VOICE_TTS";
+
+// 16kHz 16 位单声道: 每毫秒 32 字节
+#define TTS_BYTES_PER_MS    (VOICE_FE_SAMPLE_RATE * 2 / 1000)
+
+// 环形缓冲 (下载和播放之间)，满时暂停读取连接，由 TCP 流控让服务器等待
+#define TTS_RING_BYTES      (CONFIG_AI_TTS_BUFFER_MS * TTS_BYTES_PER_MS)
+
+// 每次写入 I2S 一个帧移 (10ms)
+#define TTS_CHUNK_BYTES     (VOICE_FE_HOP * sizeof(int16_t))
+
+#define TTS_READ_BUF        1024
+#define TTS_TEXT_MAX        512
+#define TTS_HEADER_MAX      256     // WAV 头 (含可选的附加块) 的上限
+
+// 后端配置，默认值来自 menuconfig (url 为空时不使用)
+static voice_tts_config_t tts_backend = {
+    .url = CONFIG_AI_TTS_URL,
+    .api_key = CONFIG_AI_TTS_API_KEY,
+    .model = CONFIG_AI_TTS_MODEL,
+    .timeout_ms = CONFIG_AI_TTS_TIMEOUT_MS,
+};
+
+static StreamBufferHandle_t ring = NULL;
+static TaskHandle_t fetch_task = NULL;
+static TaskHandle_t play_task = NULL;
+static esp_http_client_handle_t client = NULL;
+static SemaphoreHandle_t client_lock = NULL;    // 下载期间持有，修改配置时等待
+
+// 待合成的语句 (新的请求覆盖还没开始的旧请求)
+static SemaphoreHandle_t request_lock = NULL;
+static char pending_text[TTS_TEXT_MAX];
+static char pending_voice[16];
+static int pending_speed = 1;
+
+// 每次 speak / cancel 加一，下载和播放发现与自己的编号不同时立即停止
+static volatile uint32_t generation = 0;
+static volatile uint32_t play_generation = 0;   // 下载任务交给播放任务的语句编号
+static volatile int64_t request_us = 0;         // 当前语句发出请求的时间
+static volatile bool fetching = false;
+static volatile bool fetch_done = false;
+static volatile bool playing = false;
+static volatile int64_t idle_since_us = 0;      // 最近一次下载或播放结束的时间 (0 表示从未播放)
+
+// 统计
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static voice_tts_stats_t stats;
+static uint64_t ttfa_sum_ms = 0;
+static uint32_t ttfa_count = 0;
+
+// 响应解析状态 (只在下载任务中使用)
+static struct {
+    uint32_t gen;
+    bool started;               // 已经通知播放任务
+    bool raw;                   // 格式已确定，后续数据直接是 PCM
+    bool bad_format;
+    uint8_t header[TTS_HEADER_MAX];
+    size_t header_len;
+    bool has_carry;             // 上一块末尾多出的半个采样
+    uint8_t carry;
+} rx;
+
+// 把 PCM 写入环形缓冲 (只写整数个采样，缓冲满时等待播放，语句被打断时放弃)
+static void tts_push_even(const uint8_t *data, size_t len)
+{
+    while (len > 0 && rx.gen == generation) {
+        size_t n = xStreamBufferSend(ring, data, len, pdMS_TO_TICKS(50));
+        data += n;
+        len -= n;
+        if (n > 0 && !rx.started) {
+            // 第一块音频到达即开始播放
+            rx.started = true;
+            play_generation = rx.gen;
+            xTaskNotifyGive(play_task);
+        }
+    }
+}
+
+static void tts_push(const uint8_t *data, size_t len)
+{
+    if (len == 0) {
+        return;
+    }
+    if (rx.has_carry) {
+        uint8_t sample[2] = { rx.carry, data[0] };
+        rx.has_carry = false;
+        tts_push_even(sample, sizeof(sample));
+        data++;
+        len--;
+    }
+    tts_push_even(data, len & ~(size_t)1);
+    if (len & 1) {
+        rx.carry = data[len - 1];
+        rx.has_carry = true;
+    }
+}
+
+static inline uint32_t read_le32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint16_t read_le16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+// 在已收到的头部中查找 WAV 的 data 块，返回 PCM 起始偏移，头部不完整时返回 0
+static size_t tts_parse_wav(void)
+{
+    size_t pos = 12;    // "RIFF" size "WAVE"
+    while (pos + 8 <= rx.header_len) {
+        const uint8_t *chunk = rx.header + pos;
+        uint32_t size = read_le32(chunk + 4);
+        if (memcmp(chunk, "data", 4) == 0) {
+            return pos + 8;
+        }
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            if (pos + 8 + 16 > rx.header_len) {
+                return 0;
+            }
+            const uint8_t *fmt = chunk + 8;
+            if (read_le16(fmt) != 1 || read_le16(fmt + 2) != 1 ||
+                read_le32(fmt + 4) != VOICE_FE_SAMPLE_RATE || read_le16(fmt + 14) != 16) {
+                ESP_LOGE(TAG, "不支持的 WAV 格式: 编码 %u, %u 声道, %lu Hz, %u 位",
+                         read_le16(fmt), read_le16(fmt + 2), (unsigned long)read_le32(fmt + 4),
+                         read_le16(fmt + 14));
+                rx.bad_format = true;
+                return 0;
+            }
+        }
+        pos += 8 + size + (size & 1);
+    }
+    return 0;
+}
+
+// 处理收到的响应数据: 开头是 WAV 头时先跳过，否则直接当作 PCM
+static void tts_feed(const uint8_t *data, size_t len)
+{
+    if (rx.bad_format) {
+        return;
+    }
+    if (rx.raw) {
+        tts_push(data, len);
+        return;
+    }
+
+    size_t n = len;
+    if (n > sizeof(rx.header) - rx.header_len) {
+        n = sizeof(rx.header) - rx.header_len;
+    }
+    memcpy(rx.header + rx.header_len, data, n);
+    rx.header_len += n;
+    if (rx.header_len < 12) {
+        return;
+    }
+
+    size_t pcm_start = 0;
+    if (memcmp(rx.header, "RIFF", 4) == 0 && memcmp(rx.header + 8, "WAVE", 4) == 0) {
+        pcm_start = tts_parse_wav();
+        if (pcm_start == 0) {
+            if (!rx.bad_format && rx.header_len == sizeof(rx.header)) {
+                ESP_LOGE(TAG, "WAV 头超过 %d 字节", TTS_HEADER_MAX);
+                rx.bad_format = true;
+            }
+            return;
+        }
+    }
+
+    rx.raw = true;
+    if (pcm_start < rx.header_len) {
+        tts_push(rx.header + pcm_start, rx.header_len - pcm_start);
+    }
+    tts_push(data + n, len - n);
+}
+
+// 本次请求新建了连接
+static bool connected_now = false;
+
+static esp_err_t tts_http_event_handler(esp_http_client_event_t *evt)
+{
+    if (evt->event_id == HTTP_EVENT_ON_CONNECTED) {
+        connected_now = true;
+    }
+    return ESP_OK;
+}
+
+// 创建客户端 (首次请求或配置变化后)，连接在语句之间保持
+static esp_err_t tts_client_create(void)
+{
+    esp_http_client_config_t http_config = {
+        .url = tts_backend.url,
+        .method = HTTP_METHOD_POST,
+        .event_handler = tts_http_event_handler,
+        .timeout_ms = tts_backend.timeout_ms,
+        .buffer_size = TTS_READ_BUF,
+        .buffer_size_tx = 1024,
+        .keep_alive_enable = true,
+        .crt_bundle_attach = esp_crt_bundle_attach,
+    };
+
+    client = esp_http_client_init(&http_config);
+    if (client == NULL) {
+        ESP_LOGE(TAG, "HTTP客户端初始化失败");
+        return ESP_FAIL;
+    }
+
+    esp_http_client_set_header(client, "Content-Type", "application/json");
+    if (tts_backend.api_key[0] != '\0') {
+        char auth[160];
+        snprintf(auth, sizeof(auth), "Bearer %s", tts_backend.api_key);
+        esp_http_client_set_header(client, "Authorization", auth);
+    }
+    return ESP_OK;
+}
+
+static char *tts_build_body(const char *text, const char *voice, int speed)
+{
+    cJSON *root = cJSON_CreateObject();
+    if (root == NULL) {
+        return NULL;
+    }
+    cJSON_AddStringToObject(root, "model", tts_backend.model);
+    cJSON_AddStringToObject(root, "input", text);
+    cJSON_AddStringToObject(root, "voice", voice);
+    cJSON_AddNumberToObject(root, "speed", speed);
+    cJSON_AddStringToObject(root, "response_format", "pcm");
+    cJSON_AddNumberToObject(root, "sample_rate", VOICE_FE_SAMPLE_RATE);
+    char *body = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    return body;
+}
+
+// 下载一条语句的音频并写入环形缓冲，直到结束、出错或被打断
+static esp_err_t tts_fetch(const char *text, const char *voice, int speed)
+{
+    char *body = tts_build_body(text, voice, speed);
+    if (body == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t ret = (client == NULL) ? tts_client_create() : ESP_OK;
+    int body_len = strlen(body);
+    if (ret == ESP_OK) {
+        // 保持的连接可能已被服务器关闭：在复用的连接上失败时重连一次
+        ret = ESP_FAIL;
+        for (int attempt = 0; attempt < 2 && ret != ESP_OK; attempt++) {
+            connected_now = false;
+            if (esp_http_client_open(client, body_len) == ESP_OK &&
+                esp_http_client_write(client, body, body_len) == body_len &&
+                esp_http_client_fetch_headers(client) >= 0) {
+                ret = ESP_OK;
+            } else {
+                esp_http_client_close(client);
+                if (connected_now) {
+                    break;
+                }
+            }
+        }
+    }
+    free(body);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "TTS请求失败");
+        return ret;
+    }
+
+    int status = esp_http_client_get_status_code(client);
+    if (status != 200) {
+        ESP_LOGE(TAG, "TTS接口返回 HTTP %d", status);
+        esp_http_client_flush_response(client, NULL);
+        return ESP_FAIL;
+    }
+
+    static uint8_t buf[TTS_READ_BUF];
+    ret = ESP_OK;
+    while (!rx.bad_format) {
+        if (rx.gen != generation) {
+            ret = ESP_ERR_INVALID_STATE;    // 被打断
+            break;
+        }
+        int n = esp_http_client_read(client, (char *)buf, sizeof(buf));
+        if (n > 0) {
+            tts_feed(buf, n);
+        } else if (n == 0 && esp_http_client_is_complete_data_received(client)) {
+            break;
+        } else if (n == -ESP_ERR_HTTP_EAGAIN) {
+            ESP_LOGW(TAG, "%d ms 内没有收到音频", tts_backend.timeout_ms);
+            ret = ESP_ERR_TIMEOUT;
+            break;
+        } else {
+            ESP_LOGE(TAG, "读取音频失败 (%d)", n);
+            ret = ESP_FAIL;
+            break;
+        }
+    }
+    if (rx.bad_format) {
+        ret = ESP_ERR_NOT_SUPPORTED;
+    } else if (ret == ESP_OK && !rx.raw && rx.header_len > 0) {
+        tts_push(rx.header, rx.header_len);     // 不到一个 WAV 头长度的短响应
+    }
+
+    if (ret == ESP_OK) {
+        esp_http_client_flush_response(client, NULL);   // 连接留给下一条语句
+    } else {
+        esp_http_client_close(client);                  // 响应读到一半：连接无法复用
+    }
+    return ret;
+}
+
+// 下载任务: 每次取最新的请求，边下载边写入环形缓冲
+static void tts_fetch_task(void *pvParameters)
+{
+    static char text[TTS_TEXT_MAX];
+    char voice[sizeof(pending_voice)];
+
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        xSemaphoreTake(request_lock, portMAX_DELAY);
+        uint32_t gen = generation;
+        bool has_request = pending_text[0] != '\0';
+        strlcpy(text, pending_text, sizeof(text));
+        strlcpy(voice, pending_voice, sizeof(voice));
+        int speed = pending_speed;
+        pending_text[0] = '\0';
+        xSemaphoreGive(request_lock);
+        if (!has_request) {
+            continue;
+        }
+
+        // 等上一条语句的播放结束 (被打断时最多一个读取周期)，丢弃缓冲中剩余的音频
+        while (playing || xStreamBufferReset(ring) != pdPASS) {
+            vTaskDelay(pdMS_TO_TICKS(5));
+        }
+
+        memset(&rx, 0, sizeof(rx));
+        rx.gen = gen;
+        fetch_done = false;
+        fetching = true;
+
+        xSemaphoreTake(client_lock, portMAX_DELAY);
+        esp_err_t ret = tts_fetch(text, voice, speed);
+        xSemaphoreGive(client_lock);
+
+        fetch_done = true;
+        fetching = false;
+        idle_since_us = esp_timer_get_time();
+
+        // 开始播放之后的打断由播放任务统计
+        portENTER_CRITICAL(&stats_lock);
+        if (ret == ESP_ERR_INVALID_STATE || gen != generation) {
+            if (!rx.started) {
+                stats.cancelled++;
+            }
+        } else if (ret != ESP_OK) {
+            stats.errors++;
+        }
+        portEXIT_CRITICAL(&stats_lock);
+
+        if (rx.started) {
+            xTaskNotifyGive(play_task);     // 播放任务可能在等数据，唤醒它检查结束
+        }
+    }
+}
+
+// 播放任务: 从环形缓冲取音频写入 I2S
+static void tts_play_task(void *pvParameters)
+{
+    static uint8_t chunk[TTS_CHUNK_BYTES];
+    uint32_t last_gen = 0;
+
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        uint32_t gen = play_generation;
+        if (gen == last_gen || gen != generation) {
+            continue;   // 已经播放过或已被打断
+        }
+        last_gen = gen;
+        playing = true;
+
+        bool first = true;
+        bool starved = false;
+        bool cancelled = false;
+        uint32_t underruns = 0;
+        uint32_t bytes = 0;
+        uint32_t ttfa_ms = 0;
+
+        for (;;) {
+            if (gen != generation) {
+                cancelled = true;
+                break;
+            }
+            size_t n = xStreamBufferReceive(ring, chunk, sizeof(chunk), pdMS_TO_TICKS(20));
+            if (n == 0) {
+                if (fetch_done && xStreamBufferIsEmpty(ring)) {
+                    break;
+                }
+                // 下载跟不上播放 (I2S DMA 中还有约 80ms 的音频，持续更久就会断音)
+                if (!starved) {
+                    starved = true;
+                    underruns++;
+                }
+                continue;
+            }
+            starved = false;
+            if (first) {
+                first = false;
+                ttfa_ms = (uint32_t)((esp_timer_get_time() - request_us) / 1000);
+                ESP_LOGI(TAG, "首音 %lu ms", (unsigned long)ttfa_ms);
+            }
+            voice_play_audio((const char *)chunk, n);
+            bytes += n;
+        }
+
+        playing = false;
+        idle_since_us = esp_timer_get_time();
+
+        portENTER_CRITICAL(&stats_lock);
+        stats.utterances++;
+        if (cancelled) {
+            stats.cancelled++;
+        } else {
+            stats.completed++;
+        }
+        if (!first) {
+            stats.ttfa_ms = ttfa_ms;
+            ttfa_sum_ms += ttfa_ms;
+            ttfa_count++;
+            stats.ttfa_avg_ms = (uint32_t)(ttfa_sum_ms / ttfa_count);
+        }
+        stats.underruns += underruns;
+        stats.played_ms = bytes / TTS_BYTES_PER_MS;
+        portEXIT_CRITICAL(&stats_lock);
+
+        ESP_LOGI(TAG, "播放%s: %lu ms, 缓冲取空 %lu 次", cancelled ? "被打断" : "完成",
+                 (unsigned long)(bytes / TTS_BYTES_PER_MS), (unsigned long)underruns);
+    }
+}
+
+esp_err_t voice_tts_init(void)
+{
+    if (ring != NULL) {
+        return ESP_OK;
+    }
+
+    request_lock = xSemaphoreCreateMutex();
+    client_lock = xSemaphoreCreateMutex();
+    ring = xStreamBufferCreate(TTS_RING_BYTES, 1);
+    if (request_lock == NULL || client_lock == NULL || ring == NULL) {
+        ESP_LOGE(TAG, "TTS缓冲创建失败");
+        return ESP_ERR_NO_MEM;
+    }
+
+    // 播放任务优先级高于网络和识别，保证 I2S 不断流
+    if (xTaskCreate(tts_play_task, "tts_play", 3072, NULL, configMAX_PRIORITIES - 3, &play_task) != pdPASS ||
+        xTaskCreate(tts_fetch_task, "tts_fetch", 6144, NULL, 5, &fetch_task) != pdPASS) {
+        ESP_LOGE(TAG, "TTS任务创建失败");
+        return ESP_FAIL;
+    }
+
+    if (voice_tts_is_configured()) {
+        ESP_LOGI(TAG, "TTS后端: %s (缓冲 %d ms)", tts_backend.url, CONFIG_AI_TTS_BUFFER_MS);
+    } else {
+        ESP_LOGI(TAG, "未配置TTS后端，语音合成使用提示音");
+    }
+    return ESP_OK;
+}
+
+esp_err_t voice_tts_set_config(const voice_tts_config_t *config)
+{
+    if (config == NULL || config->timeout_ms <= 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (client_lock == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    voice_tts_cancel();
+    xSemaphoreTake(client_lock, portMAX_DELAY);
+    memcpy(&tts_backend, config, sizeof(tts_backend));
+    if (client != NULL) {
+        esp_http_client_cleanup(client);
+        client = NULL;
+    }
+    xSemaphoreGive(client_lock);
+
+    ESP_LOGI(TAG, "TTS后端配置已更新: %s", tts_backend.url[0] ? tts_backend.url : "(未使用)");
+    return ESP_OK;
+}
+
+bool voice_tts_is_configured(void)
+{
+    return tts_backend.url[0] != '\0';
+}
+
+esp_err_t voice_tts_speak(const char *text, const char *voice_type, int speed)
+{
+    if (text == NULL || text[0] == '\0') {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (fetch_task == NULL || !voice_tts_is_configured()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(request_lock, portMAX_DELAY);
+    generation++;   // 打断正在播放的语句
+    strlcpy(pending_text, text, sizeof(pending_text));
+    strlcpy(pending_voice, voice_type ? voice_type : "", sizeof(pending_voice));
+    pending_speed = speed;
+    request_us = esp_timer_get_time();
+    xSemaphoreGive(request_lock);
+
+    xTaskNotifyGive(fetch_task);
+    return ESP_OK;
+}
+
+void voice_tts_cancel(void)
+{
+    if (request_lock == NULL) {
+        return;
+    }
+    xSemaphoreTake(request_lock, portMAX_DELAY);
+    generation++;
+    pending_text[0] = '\0';
+    xSemaphoreGive(request_lock);
+}
+
+bool voice_tts_is_busy(void)
+{
+    return fetching || playing || pending_text[0] != '\0';
+}
+
+int64_t voice_tts_last_active_us(void)
+{
+    return voice_tts_is_busy() ? esp_timer_get_time() : idle_since_us;
+}
+
+void voice_tts_get_stats(voice_tts_stats_t *out)
+{
+    if (out == NULL) {
+        return;
+    }
+    portENTER_CRITICAL(&stats_lock);
+    *out = stats;
+    portEXIT_CRITICAL(&stats_lock);
+}
@@ -0,0 +1,48 @@
+#ifndef VOICE_TTS_H
+#define VOICE_TTS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+// 流式语音合成: 从 TTS 接口边下载边播放。
+// 接口收到 JSON 请求 {"model", "input", "voice", "speed", "response_format": "pcm", "sample_rate": 16000}，
+// 响应体为 16kHz 16 位单声道 PCM (也接受同格式的 WAV)，可以分块逐步返回
+
+// TTS 后端配置
+typedef struct {
+    char url[128];          // 接口地址，为空时不使用 (如 http://192.168.1.10:8000/v1/audio/speech)
+    char api_key[128];      // Bearer 令牌 (可以为空)
+    char model[32];
+    int timeout_ms;         // 两次收到数据之间的最长等待
+} voice_tts_config_t;
+
+// 播放统计
+typedef struct {
+    uint32_t utterances;        // 开始播放的语句数
+    uint32_t completed;         // 完整播放的语句数
+    uint32_t cancelled;         // 被打断的语句数
+    uint32_t errors;            // 请求失败或格式不支持
+    uint32_t ttfa_ms;           // 最近一次首音时间 (发出请求到第一块音频写入 I2S)
+    uint32_t ttfa_avg_ms;
+    uint32_t underruns;         // 播放中缓冲被取空的次数 (下载跟不上播放)
+    uint32_t played_ms;         // 最近一次播放的音频时长
+} voice_tts_stats_t;
+
+// 在 voice_processor_init() 之后调用 (通过语音处理器的 I2S 发送通道播放)
+esp_err_t voice_tts_init(void);
+esp_err_t voice_tts_set_config(const voice_tts_config_t *config);
+bool voice_tts_is_configured(void);
+
+// 开始合成并播放 (立即返回)，正在播放的语句会被打断
+esp_err_t voice_tts_speak(const char *text, const char *voice_type, int speed);
+
+// 打断正在下载或播放的语句 (用户插话时调用)，缓冲中的音频直接丢弃
+void voice_tts_cancel(void);
+
+bool voice_tts_is_busy(void);
+// 最近一次下载或播放结束的时间 (esp_timer 微秒)，正在下载或播放时返回当前时间，从未播放返回 0
+int64_t voice_tts_last_active_us(void);
+void voice_tts_get_stats(voice_tts_stats_t *stats);
+
+#endif // VOICE_TTS_H
@@ -1,11 +1,22 @@
 #include "web_interface.h"
+#include "sdkconfig.h"
+#include "ai_msg.h"
+#include "ai_cache.h"
+#include "ai_classifier.h"
+#include "ai_memory.h"
 #include "esp_log.h"
 #include "esp_http_server.h"
 #include "esp_system.h"
 #include "cJSON.h"
+#include "json_writer_httpd.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
 #include <string.h>
+#include <stdlib.h>
 
 static const char *TAG = "WEB_INTERFACE";
 
@@ -24,6 +35,63 @@ static httpd_handle_t server = NULL;
 // WebSocket回调
 static ws_message_callback_t ws_callback = NULL;
 
+// 聊天请求：HTTP 处理函数只登记请求，由 chat_stream 任务生成回复
+// (流式请求边生成边推送)，不占用 HTTP 服务器任务 (其他页面和接口照常响应)
+typedef struct {
+    httpd_req_t *req;
+    bool stream;
+    uint32_t session;       // 请求中的 "session" (可选)，同一会话的请求带上之前的对话
+    char message[512];
+} chat_stream_job_t;
+
+#define CHAT_STREAM_QUEUE_LEN   2
+
+static QueueHandle_t chat_stream_queue = NULL;
+
+// WebSocket 客户端表
+#define WS_MAX_CLIENTS      4
+#define WS_SEND_QUEUE_LEN   32
+#define WS_RECV_MAX         600
+
+typedef struct {
+    int fd;             // -1 为空位
+    uint32_t id;        // 客户端编号 (递增，套接字复用时不会混淆)
+} ws_client_t;
+
+// 待推送的消息 (JSON 文本紧跟在结构体后)
+typedef struct {
+    uint32_t client;    // WEB_CLIENT_ALL 为所有客户端
+    int64_t enqueue_us;
+    size_t len;
+    char data[];
+} ws_out_t;
+
+static ws_client_t ws_clients[WS_MAX_CLIENTS];
+static uint32_t ws_next_id = 1;
+static SemaphoreHandle_t ws_lock = NULL;
+
+// 推送队列：调用方只入队，由 ws_send 任务写套接字，慢的浏览器不会阻塞调用方
+static QueueHandle_t ws_send_queue = NULL;
+
+// 推送统计
+typedef struct {
+    uint32_t messages;      // 已推送的消息
+    uint32_t frames;        // 已发送的帧 (广播时每个客户端一帧)
+    uint32_t dropped;       // 队列满或目标已断开而丢弃的消息
+    uint32_t send_errors;
+    uint64_t queue_us_sum;  // 入队到写入套接字
+    uint32_t queue_us_max;
+    uint32_t acks;
+    uint64_t ack_us_sum;    // 入队到收到浏览器确认 (含确认的回程)
+    uint32_t ack_us_max;
+    uint32_t ack_us_last;
+} ws_stats_t;
+
+static portMUX_TYPE ws_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static ws_stats_t ws_stats;
+
+static int ws_client_count(void);
+
 // 简单的HTML页面
 static const char *html_page = R"(
 <!DOCTYPE html>
@@ -185,6 +253,7 @@ static const char *html_page = R"(
 
     <script>
         let ws = null;
+        let streamDiv = null;   // 正在逐 token 显示的回复
         
         function connectWebSocket() {
             const protocol = window.location.protocol === 'https:' ? 'wss:' : 'ws:';
@@ -198,10 +267,26 @@ static const char *html_page = R"(
             
             ws.onmessage = function(event) {
                 const data = JSON.parse(event.data);
-                if (data.type === 'response') {
-                    addMessage(data.text, 'ai');
+                // 收到即确认，设备据此统计推送延迟
+                if (data.t !== undefined) {
+                    ws.send(JSON.stringify({type: 'ack', t: data.t}));
+                }
+                if (data.type === 'token') {
+                    if (!streamDiv) {
+                        streamDiv = addMessage('', 'ai');
+                    }
+                    streamDiv.textContent += data.text;
+                } else if (data.type === 'response') {
+                    if (streamDiv) {
+                        streamDiv.textContent = data.text;
+                        streamDiv = null;
+                    } else {
+                        addMessage(data.text, 'ai');
+                    }
                 } else if (data.type === 'status') {
                     updateStatus(data.message);
+                } else if (data.type === 'broadcast') {
+                    addMessage(data.message, 'ai');
                 }
             };
             
@@ -229,21 +314,71 @@ static const char *html_page = R"(
                         message: message
                     }));
                 } else {
-                    // 如果WebSocket未连接，发送HTTP请求
-                    fetch('/api/chat', {
-                        method: 'POST',
-                        headers: {
-                            'Content-Type': 'application/json'
-                        },
-                        body: JSON.stringify({message: message})
-                    })
-                    .then(response => response.json())
-                    .then(data => {
-                        addMessage(data.response, 'ai');
-                    })
-                    .catch(error => {
-                        addMessage('抱歉，连接出现问题', 'ai');
-                    });
+                    // 如果WebSocket未连接，发送HTTP请求 (回复按 token 流式显示)
+                    streamChat(message);
+                }
+            }
+        }
+        
+        // 读取 /api/chat/stream 的事件流: 每个 data 为一个 token，done 事件为完整回复
+        async function streamChat(message) {
+            let div = null;
+            let text = '';
+            try {
+                const response = await fetch('/api/chat/stream', {
+                    method: 'POST',
+                    headers: {
+                        'Content-Type': 'application/json'
+                    },
+                    body: JSON.stringify({message: message})
+                });
+                if (!response.ok || !response.body) {
+                    throw new Error('HTTP ' + response.status);
+                }
+                const reader = response.body.getReader();
+                const decoder = new TextDecoder();
+                let buffer = '';
+                while (true) {
+                    const {value, done} = await reader.read();
+                    if (done) {
+                        break;
+                    }
+                    buffer += decoder.decode(value, {stream: true});
+                    let end;
+                    while ((end = buffer.indexOf('\n\n')) >= 0) {
+                        const event = buffer.slice(0, end);
+                        buffer = buffer.slice(end + 2);
+                        let name = 'message';
+                        let data = '';
+                        for (const line of event.split('\n')) {
+                            if (line.startsWith('event:')) {
+                                name = line.slice(6).trim();
+                            } else if (line.startsWith('data:')) {
+                                data += line.slice(5).trim();
+                            }
+                        }
+                        if (!data) {
+                            continue;
+                        }
+                        const payload = JSON.parse(data);
+                        if (name === 'done') {
+                            text = payload.response;
+                        } else {
+                            text += payload;
+                        }
+                        if (!div) {
+                            div = addMessage(text, 'ai');
+                        } else {
+                            div.textContent = text;
+                        }
+                    }
+                }
+                if (!div) {
+                    throw new Error('empty response');
+                }
+            } catch (error) {
+                if (!div) {
+                    addMessage('抱歉，连接出现问题', 'ai');
                 }
             }
         }
@@ -255,6 +390,7 @@ static const char *html_page = R"(
             messageDiv.textContent = text;
             container.appendChild(messageDiv);
             container.scrollTop = container.scrollHeight;
+            return messageDiv;
         }
         
         function updateStatus(status) {
@@ -312,8 +448,264 @@ static esp_err_t root_get_handler(httpd_req_t *req)
     return ESP_OK;
 }
 
-// API聊天处理函数
-static esp_err_t api_chat_post_handler(httpd_req_t *req)
+// API状态处理函数 (流式生成：栈上缓冲区满了就以 chunk 发出，不分配内存)
+static esp_err_t api_status_get_handler(httpd_req_t *req)
+{
+    char buf[512];
+    json_writer_t w;
+    json_writer_httpd_begin(&w, req, buf, sizeof(buf));
+    
+    json_writer_begin_object(&w, NULL);
+    json_writer_string(&w, "status", "running");
+    json_writer_string(&w, "ai_name", "小智");
+    json_writer_string(&w, "version", "1.0.0");
+    json_writer_bool(&w, "voice_enabled", true);
+    json_writer_bool(&w, "web_enabled", true);
+    
+    // 大模型后端统计 (首 token 时间、连接复用)
+    ai_llm_stats_t llm_stats;
+    ai_llm_get_stats(&llm_stats);
+    json_writer_begin_object(&w, "llm");
+    json_writer_bool(&w, "configured", ai_llm_is_configured());
+    json_writer_uint(&w, "requests", llm_stats.requests);
+    json_writer_uint(&w, "errors", llm_stats.errors);
+    json_writer_uint(&w, "timeouts", llm_stats.timeouts);
+    json_writer_uint(&w, "connects", llm_stats.connects);
+    json_writer_uint(&w, "ttft_ms", llm_stats.ttft_ms);
+    json_writer_uint(&w, "ttft_avg_ms", llm_stats.ttft_avg_ms);
+    json_writer_uint(&w, "total_ms", llm_stats.total_ms);
+    json_writer_uint(&w, "tokens", llm_stats.tokens);
+    json_writer_uint(&w, "request_bytes", llm_stats.request_bytes);
+    json_writer_uint(&w, "history_bytes", llm_stats.history_bytes);
+    json_writer_end_object(&w);
+    
+    // 对话记忆 (各会话占用、上次请求附带的历史)
+    ai_memory_stats_t memory_stats;
+    ai_memory_get_stats(&memory_stats);
+    json_writer_begin_object(&w, "memory");
+    json_writer_uint(&w, "sessions", memory_stats.sessions);
+    json_writer_uint(&w, "bytes_used", memory_stats.bytes_used);
+    json_writer_uint(&w, "bytes_reserved", memory_stats.bytes_reserved);
+    json_writer_uint(&w, "turns", memory_stats.turns);
+    json_writer_uint(&w, "turns_evicted", memory_stats.turns_evicted);
+    json_writer_uint(&w, "turns_summarized", memory_stats.turns_summarized);
+    json_writer_uint(&w, "turns_truncated", memory_stats.turns_truncated);
+    json_writer_uint(&w, "sessions_expired", memory_stats.sessions_expired);
+    json_writer_uint(&w, "sessions_evicted", memory_stats.sessions_evicted);
+    json_writer_uint(&w, "requests", memory_stats.requests);
+    json_writer_uint(&w, "context_bytes", memory_stats.context_bytes);
+    json_writer_uint(&w, "context_bytes_max", memory_stats.context_bytes_max);
+    json_writer_uint(&w, "context_tokens", memory_stats.context_tokens);
+    json_writer_uint(&w, "turns_skipped", memory_stats.turns_skipped);
+    ai_memory_session_info_t sessions[CONFIG_AI_MEMORY_SESSIONS];
+    int session_count = ai_memory_get_sessions(sessions, CONFIG_AI_MEMORY_SESSIONS);
+    json_writer_begin_array(&w, "session_list");
+    for (int i = 0; i < session_count; i++) {
+        json_writer_begin_object(&w, NULL);
+        json_writer_uint(&w, "id", sessions[i].session);
+        json_writer_uint(&w, "turns", sessions[i].turns);
+        json_writer_uint(&w, "bytes", sessions[i].bytes);
+        json_writer_uint(&w, "summary_bytes", sessions[i].summary_bytes);
+        json_writer_uint(&w, "idle_s", sessions[i].idle_s);
+        json_writer_end_object(&w);
+    }
+    json_writer_end_array(&w);
+    json_writer_end_object(&w);
+    
+    // 后端回复缓存 (命中率、省去的后端耗时)
+    ai_cache_stats_t cache_stats;
+    ai_cache_get_stats(&cache_stats);
+    json_writer_begin_object(&w, "cache");
+    json_writer_uint(&w, "entries", cache_stats.entries);
+    json_writer_uint(&w, "bytes", cache_stats.bytes);
+    json_writer_uint(&w, "budget_bytes", AI_CACHE_BUDGET_BYTES);
+    json_writer_uint(&w, "lookups", cache_stats.lookups);
+    json_writer_uint(&w, "hits", cache_stats.hits);
+    json_writer_double(&w, "hit_ratio", cache_stats.lookups ? (double)cache_stats.hits / cache_stats.lookups : 0, 3);
+    json_writer_uint(&w, "stores", cache_stats.stores);
+    json_writer_uint(&w, "evictions", cache_stats.evictions);
+    json_writer_uint(&w, "expired", cache_stats.expired);
+    json_writer_uint(&w, "saved_ms", cache_stats.saved_ms);
+    json_writer_double(&w, "saved_avg_ms", cache_stats.hits ? (double)cache_stats.saved_ms / cache_stats.hits : 0, 1);
+    json_writer_end_object(&w);
+    
+    // 本地意图分类器 (关键词未命中时的后备)
+    ai_classifier_stats_t classifier_stats;
+    ai_classifier_get_stats(&classifier_stats);
+    json_writer_begin_object(&w, "classifier");
+    json_writer_uint(&w, "runs", classifier_stats.runs);
+    json_writer_uint(&w, "accepted", classifier_stats.accepted);
+    json_writer_uint(&w, "rejected", classifier_stats.rejected);
+    json_writer_uint(&w, "min_confidence", AI_CLASSIFIER_MIN_CONFIDENCE);
+    json_writer_uint(&w, "avg_us", classifier_stats.avg_us);
+    json_writer_uint(&w, "max_us", classifier_stats.max_us);
+    json_writer_end_object(&w);
+    
+    // WebSocket推送统计 (入队到写入套接字、入队到浏览器确认)
+    portENTER_CRITICAL(&ws_stats_lock);
+    ws_stats_t stats = ws_stats;
+    portEXIT_CRITICAL(&ws_stats_lock);
+    json_writer_begin_object(&w, "ws");
+    json_writer_uint(&w, "clients", ws_client_count());
+    json_writer_uint(&w, "messages", stats.messages);
+    json_writer_uint(&w, "frames", stats.frames);
+    json_writer_uint(&w, "dropped", stats.dropped);
+    json_writer_uint(&w, "send_errors", stats.send_errors);
+    json_writer_double(&w, "queue_avg_ms", stats.messages ? stats.queue_us_sum / 1000.0 / stats.messages : 0, 3);
+    json_writer_double(&w, "queue_max_ms", stats.queue_us_max / 1000.0, 3);
+    json_writer_uint(&w, "acks", stats.acks);
+    json_writer_double(&w, "ack_avg_ms", stats.acks ? stats.ack_us_sum / 1000.0 / stats.acks : 0, 3);
+    json_writer_double(&w, "ack_max_ms", stats.ack_us_max / 1000.0, 3);
+    json_writer_double(&w, "ack_last_ms", stats.ack_us_last / 1000.0, 3);
+    json_writer_end_object(&w);
+    
+    // 请求处理流水线 (消息池占用、各队列等待时间、端到端耗时)
+    ai_msg_stats_t msg_stats;
+    ai_msg_get_stats(&msg_stats);
+    json_writer_begin_object(&w, "pipeline");
+    json_writer_uint(&w, "pool_size", AI_MSG_POOL_SIZE);
+    json_writer_uint(&w, "in_use", msg_stats.in_use);
+    json_writer_uint(&w, "in_use_max", msg_stats.in_use_max);
+    json_writer_uint(&w, "alloc_failures", msg_stats.alloc_failures);
+    json_writer_uint(&w, "completed", msg_stats.completed);
+    json_writer_double(&w, "total_avg_ms", msg_stats.total_avg_us / 1000.0, 3);
+    json_writer_double(&w, "total_max_ms", msg_stats.total_max_us / 1000.0, 3);
+    json_writer_begin_array(&w, "queues");
+    for (int i = 0; i < msg_stats.num_queues; i++) {
+        json_writer_begin_object(&w, NULL);
+        json_writer_string(&w, "name", msg_stats.queues[i].name);
+        json_writer_uint(&w, "messages", msg_stats.queues[i].messages);
+        json_writer_uint(&w, "depth_max", msg_stats.queues[i].depth_max);
+        json_writer_double(&w, "wait_avg_ms", msg_stats.queues[i].wait_avg_us / 1000.0, 3);
+        json_writer_double(&w, "wait_max_ms", msg_stats.queues[i].wait_max_us / 1000.0, 3);
+        json_writer_end_object(&w);
+    }
+    json_writer_end_array(&w);
+    json_writer_end_object(&w);
+    
+    json_writer_end_object(&w);
+    return json_writer_httpd_end(&w);
+}
+
+// 以 JSON 字符串形式发送一段文本 (SSE 的 data 字段)，转义后分块发送
+static esp_err_t sse_send_json_string(httpd_req_t *req, const char *text, size_t len)
+{
+    char buf[256];
+    size_t n = 0;
+    buf[n++] = '"';
+    for (size_t i = 0; i < len; i++) {
+        // 预留最长转义 (\u00XX) 的位置
+        if (n + 6 > sizeof(buf)) {
+            esp_err_t ret = httpd_resp_send_chunk(req, buf, n);
+            if (ret != ESP_OK) {
+                return ret;
+            }
+            n = 0;
+        }
+        uint8_t c = (uint8_t)text[i];
+        if (c == '"' || c == '\\') {
+            buf[n++] = '\\';
+            buf[n++] = c;
+        } else if (c == '\n') {
+            buf[n++] = '\\';
+            buf[n++] = 'n';
+        } else if (c == '\r') {
+            buf[n++] = '\\';
+            buf[n++] = 'r';
+        } else if (c == '\t') {
+            buf[n++] = '\\';
+            buf[n++] = 't';
+        } else if (c < 0x20) {
+            n += snprintf(buf + n, sizeof(buf) - n, "\\u%04x", c);
+        } else {
+            buf[n++] = c;
+        }
+    }
+    buf[n++] = '"';
+    return httpd_resp_send_chunk(req, buf, n);
+}
+
+// 收到 token 立即推送给浏览器；浏览器已断开时返回错误，取消后端请求
+static esp_err_t chat_stream_on_token(const char *token, size_t len, void *arg)
+{
+    httpd_req_t *req = (httpd_req_t *)arg;
+    esp_err_t ret = httpd_resp_send_chunk(req, "data: ", 6);
+    if (ret == ESP_OK) {
+        ret = sse_send_json_string(req, token, len);
+    }
+    if (ret == ESP_OK) {
+        ret = httpd_resp_send_chunk(req, "\n\n", 2);
+    }
+    return ret;
+}
+
+// 发送完整回复 (done 事件)
+static void chat_stream_send_done(httpd_req_t *req, const ai_response_t *response)
+{
+    cJSON *json = cJSON_CreateObject();
+    cJSON_AddStringToObject(json, "response", response->text);
+    cJSON_AddStringToObject(json, "action", response->action);
+    cJSON_AddStringToObject(json, "emotion", response->emotion);
+    cJSON_AddNumberToObject(json, "confidence", response->confidence);
+
+    char *json_str = cJSON_PrintUnformatted(json);
+    if (json_str != NULL) {
+        httpd_resp_send_chunk(req, "event: done\ndata: ", HTTPD_RESP_USE_STRLEN);
+        httpd_resp_send_chunk(req, json_str, HTTPD_RESP_USE_STRLEN);
+        httpd_resp_send_chunk(req, "\n\n", 2);
+        free(json_str);
+    }
+    cJSON_Delete(json);
+}
+
+// 流式聊天任务
+static void chat_stream_task(void *pvParameters)
+{
+    chat_stream_job_t *job;
+    ai_response_t response;
+
+    while (1) {
+        if (xQueueReceive(chat_stream_queue, &job, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        httpd_req_t *req = job->req;
+        memset(&response, 0, sizeof(response));
+
+        if (job->stream) {
+            httpd_resp_set_type(req, "text/event-stream");
+            httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+
+            esp_err_t ret = ai_process_command_stream(job->session, job->message, &response,
+                                                      chat_stream_on_token, req);
+            if (ret == ESP_OK || response.text[0] != '\0') {
+                chat_stream_send_done(req, &response);
+            }
+            httpd_resp_send_chunk(req, NULL, 0);
+        } else {
+            ai_process_command_stream(job->session, job->message, &response, NULL, NULL);
+
+            cJSON *json = cJSON_CreateObject();
+            cJSON_AddStringToObject(json, "response", response.text);
+            cJSON_AddStringToObject(json, "action", response.action);
+            cJSON_AddStringToObject(json, "emotion", response.emotion);
+            cJSON_AddNumberToObject(json, "confidence", response.confidence);
+            cJSON_AddStringToObject(json, "status", "success");
+
+            char *json_str = cJSON_Print(json);
+            httpd_resp_set_type(req, "application/json");
+            httpd_resp_send(req, json_str, strlen(json_str));
+            free(json_str);
+            cJSON_Delete(json);
+        }
+
+        httpd_req_async_handler_complete(req);
+        free(job);
+    }
+}
+
+// 登记聊天请求，交给 chat_stream 任务处理，处理函数立即返回
+static esp_err_t chat_job_submit(httpd_req_t *req, bool stream)
 {
     char content[512];
     int recv_len = httpd_req_recv(req, content, sizeof(content) - 1);
@@ -321,70 +713,347 @@ static esp_err_t api_chat_post_handler(httpd_req_t *req)
         return ESP_FAIL;
     }
     content[recv_len] = '\0';
-    
-    ESP_LOGI(TAG, "收到聊天消息: %s", content);
-    
-    // 解析JSON
+
     cJSON *json = cJSON_Parse(content);
     if (json == NULL) {
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid JSON");
         return ESP_FAIL;
     }
-    
     cJSON *message = cJSON_GetObjectItem(json, "message");
-    if (message == NULL || !cJSON_IsString(message)) {
+    if (message == NULL || !cJSON_IsString(message) || message->valuestring[0] == '\0') {
         cJSON_Delete(json);
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing message");
         return ESP_FAIL;
     }
-    
-    // 处理消息
-    if (ws_callback != NULL) {
-        ws_message_t ws_msg = {
-            .type = WS_MSG_CHAT,
-            .length = strlen(message->valuestring)
-        };
-        strcpy(ws_msg.data, message->valuestring);
-        ws_callback(&ws_msg);
+
+    chat_stream_job_t *job = calloc(1, sizeof(chat_stream_job_t));
+    if (job == NULL) {
+        cJSON_Delete(json);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "No memory");
+        return ESP_FAIL;
+    }
+    job->stream = stream;
+    strlcpy(job->message, message->valuestring, sizeof(job->message));
+    cJSON *session = cJSON_GetObjectItem(json, "session");
+    if (cJSON_IsString(session)) {
+        job->session = ai_memory_session_from_key(session->valuestring);
     }
-    
     cJSON_Delete(json);
-    
-    // 返回响应
-    cJSON *response = cJSON_CreateObject();
-    cJSON_AddStringToObject(response, "response", "消息已收到，正在处理...");
-    cJSON_AddStringToObject(response, "status", "success");
-    
-    char *response_str = cJSON_Print(response);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, response_str, strlen(response_str));
-    
-    free(response_str);
-    cJSON_Delete(response);
-    
+
+    ESP_LOGI(TAG, "收到%s聊天消息: %s", stream ? "流式" : "", job->message);
+
+    if (httpd_req_async_handler_begin(req, &job->req) != ESP_OK) {
+        free(job);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Async failed");
+        return ESP_FAIL;
+    }
+    if (xQueueSend(chat_stream_queue, &job, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "聊天请求过多");
+        httpd_resp_set_status(job->req, "503 Service Unavailable");
+        httpd_resp_sendstr(job->req, "Busy");
+        httpd_req_async_handler_complete(job->req);
+        free(job);
+    }
     return ESP_OK;
 }
 
-// API状态处理函数
-static esp_err_t api_status_get_handler(httpd_req_t *req)
+// API聊天处理函数 (生成完整回复后一次返回)
+static esp_err_t api_chat_post_handler(httpd_req_t *req)
 {
-    cJSON *response = cJSON_CreateObject();
-    cJSON_AddStringToObject(response, "status", "running");
-    cJSON_AddStringToObject(response, "ai_name", "小智");
-    cJSON_AddStringToObject(response, "version", "1.0.0");
-    cJSON_AddBoolToObject(response, "voice_enabled", true);
-    cJSON_AddBoolToObject(response, "web_enabled", true);
-    
-    char *response_str = cJSON_Print(response);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, response_str, strlen(response_str));
-    
-    free(response_str);
-    cJSON_Delete(response);
+    return chat_job_submit(req, false);
+}
+
+// API流式聊天处理函数
+static esp_err_t api_chat_stream_post_handler(httpd_req_t *req)
+{
+    return chat_job_submit(req, true);
+}
+
+// 登记新的 WebSocket 客户端，返回编号 (表满时返回 0)
+static uint32_t ws_client_add(int fd)
+{
+    uint32_t id = 0;
+    xSemaphoreTake(ws_lock, portMAX_DELAY);
+    for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+        if (ws_clients[i].fd < 0) {
+            ws_clients[i].fd = fd;
+            ws_clients[i].id = id = ws_next_id++;
+            break;
+        }
+    }
+    xSemaphoreGive(ws_lock);
+    return id;
+}
+
+static void ws_client_remove(int fd)
+{
+    uint32_t id = 0;
+    xSemaphoreTake(ws_lock, portMAX_DELAY);
+    for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+        if (ws_clients[i].fd == fd) {
+            ESP_LOGI(TAG, "WebSocket客户端 #%lu 已断开", (unsigned long)ws_clients[i].id);
+            id = ws_clients[i].id;
+            ws_clients[i].fd = -1;
+            ws_clients[i].id = 0;
+        }
+    }
+    xSemaphoreGive(ws_lock);
     
+    // 客户端编号不再使用，对话记忆随之释放
+    ai_memory_forget(id);
+}
+
+static uint32_t ws_client_id(int fd)
+{
+    uint32_t id = 0;
+    xSemaphoreTake(ws_lock, portMAX_DELAY);
+    for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+        if (ws_clients[i].fd == fd) {
+            id = ws_clients[i].id;
+            break;
+        }
+    }
+    xSemaphoreGive(ws_lock);
+    return id;
+}
+
+// 客户端是否在线 (WEB_CLIENT_ALL 时为是否有任何客户端)
+static bool ws_client_online(uint32_t client)
+{
+    bool online = false;
+    xSemaphoreTake(ws_lock, portMAX_DELAY);
+    for (int i = 0; i < WS_MAX_CLIENTS && !online; i++) {
+        online = ws_clients[i].fd >= 0 && (client == WEB_CLIENT_ALL || ws_clients[i].id == client);
+    }
+    xSemaphoreGive(ws_lock);
+    return online;
+}
+
+static int ws_client_count(void)
+{
+    int count = 0;
+    xSemaphoreTake(ws_lock, portMAX_DELAY);
+    for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+        if (ws_clients[i].fd >= 0) {
+            count++;
+        }
+    }
+    xSemaphoreGive(ws_lock);
+    return count;
+}
+
+// 消息入队 (不阻塞)，json 由本函数释放
+static esp_err_t ws_enqueue(uint32_t client, cJSON *json)
+{
+    if (ws_send_queue == NULL || !ws_client_online(client)) {
+        cJSON_Delete(json);
+        return client == WEB_CLIENT_ALL ? ESP_OK : ESP_ERR_NOT_FOUND;
+    }
+
+    int64_t now = esp_timer_get_time();
+    cJSON_AddNumberToObject(json, "t", (double)now);    // 浏览器确认时原样带回
+    char *json_str = cJSON_PrintUnformatted(json);
+    cJSON_Delete(json);
+    if (json_str == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    size_t len = strlen(json_str);
+    ws_out_t *out = malloc(sizeof(ws_out_t) + len + 1);
+    if (out == NULL) {
+        free(json_str);
+        return ESP_ERR_NO_MEM;
+    }
+    out->client = client;
+    out->enqueue_us = now;
+    out->len = len;
+    memcpy(out->data, json_str, len + 1);
+    free(json_str);
+
+    if (xQueueSend(ws_send_queue, &out, 0) != pdTRUE) {
+        free(out);
+        portENTER_CRITICAL(&ws_stats_lock);
+        ws_stats.dropped++;
+        portEXIT_CRITICAL(&ws_stats_lock);
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
+
+// 推送任务：发送失败的连接关闭，不影响其他客户端
+static void ws_send_task(void *pvParameters)
+{
+    ws_out_t *out;
+    int fds[WS_MAX_CLIENTS];
+
+    while (1) {
+        if (xQueueReceive(ws_send_queue, &out, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+
+        int count = 0;
+        xSemaphoreTake(ws_lock, portMAX_DELAY);
+        for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+            if (ws_clients[i].fd >= 0 && (out->client == WEB_CLIENT_ALL || ws_clients[i].id == out->client)) {
+                fds[count++] = ws_clients[i].fd;
+            }
+        }
+        xSemaphoreGive(ws_lock);
+
+        uint32_t frames = 0;
+        uint32_t errors = 0;
+        httpd_handle_t hd = server;
+        for (int i = 0; i < count && hd != NULL; i++) {
+            httpd_ws_frame_t frame = {
+                .final = true,
+                .type = HTTPD_WS_TYPE_TEXT,
+                .payload = (uint8_t *)out->data,
+                .len = out->len,
+            };
+            esp_err_t ret = httpd_ws_send_frame_async(hd, fds[i], &frame);
+            if (ret == ESP_OK) {
+                frames++;
+            } else {
+                ESP_LOGW(TAG, "WebSocket发送失败 (fd=%d): %s", fds[i], esp_err_to_name(ret));
+                httpd_sess_trigger_close(hd, fds[i]);
+                errors++;
+            }
+        }
+
+        uint32_t queue_us = (uint32_t)(esp_timer_get_time() - out->enqueue_us);
+        portENTER_CRITICAL(&ws_stats_lock);
+        ws_stats.frames += frames;
+        ws_stats.send_errors += errors;
+        if (frames == 0) {
+            ws_stats.dropped++;
+        } else {
+            ws_stats.messages++;
+            ws_stats.queue_us_sum += queue_us;
+            if (queue_us > ws_stats.queue_us_max) {
+                ws_stats.queue_us_max = queue_us;
+            }
+        }
+        portEXIT_CRITICAL(&ws_stats_lock);
+        free(out);
+    }
+}
+
+// 浏览器确认：入队时间由消息中的 t 带回
+static void ws_record_ack(double t)
+{
+    int64_t ack_us = esp_timer_get_time() - (int64_t)t;
+    if (t <= 0 || ack_us < 0 || ack_us > 60 * 1000000LL) {
+        return;
+    }
+    portENTER_CRITICAL(&ws_stats_lock);
+    ws_stats.acks++;
+    ws_stats.ack_us_sum += ack_us;
+    ws_stats.ack_us_last = (uint32_t)ack_us;
+    if (ack_us > ws_stats.ack_us_max) {
+        ws_stats.ack_us_max = (uint32_t)ack_us;
+    }
+    portEXIT_CRITICAL(&ws_stats_lock);
+}
+
+// 处理浏览器发来的文本消息
+static void ws_handle_text(uint32_t client, const char *text)
+{
+    cJSON *json = cJSON_Parse(text);
+    if (json == NULL) {
+        ESP_LOGW(TAG, "无效的WebSocket消息");
+        return;
+    }
+    cJSON *type = cJSON_GetObjectItem(json, "type");
+    if (!cJSON_IsString(type)) {
+        cJSON_Delete(json);
+        return;
+    }
+
+    if (strcmp(type->valuestring, "ack") == 0) {
+        cJSON *t = cJSON_GetObjectItem(json, "t");
+        if (cJSON_IsNumber(t)) {
+            ws_record_ack(t->valuedouble);
+        }
+    } else if (strcmp(type->valuestring, "chat") == 0) {
+        cJSON *message = cJSON_GetObjectItem(json, "message");
+        if (cJSON_IsString(message) && message->valuestring[0] != '\0') {
+            if (ws_callback != NULL) {
+                ws_message_t ws_msg = {
+                    .type = WS_MSG_CHAT,
+                    .client = client
+                };
+                strlcpy(ws_msg.data, message->valuestring, sizeof(ws_msg.data));
+                ws_msg.length = strlen(ws_msg.data);
+                ws_callback(&ws_msg);
+            } else {
+                web_send_status_to(client, "AI服务未就绪");
+            }
+        }
+    } else if (strcmp(type->valuestring, "status") == 0) {
+        char status[96];
+        portENTER_CRITICAL(&ws_stats_lock);
+        uint32_t ack_avg_ms = ws_stats.acks ? (uint32_t)(ws_stats.ack_us_sum / ws_stats.acks / 1000) : 0;
+        portEXIT_CRITICAL(&ws_stats_lock);
+        snprintf(status, sizeof(status), "运行中, %d 个客户端在线, 推送延迟 %lu ms",
+                 ws_client_count(), (unsigned long)ack_avg_ms);
+        web_send_status_to(client, status);
+    } else if (strcmp(type->valuestring, "voice") == 0) {
+        web_send_status_to(client, "ESP32-C3版本不支持语音功能");
+    }
+    cJSON_Delete(json);
+}
+
+// WebSocket处理函数
+static esp_err_t ws_handler(httpd_req_t *req)
+{
+    int fd = httpd_req_to_sockfd(req);
+
+    // 握手
+    if (req->method == HTTP_GET) {
+        uint32_t id = ws_client_add(fd);
+        if (id == 0) {
+            ESP_LOGW(TAG, "WebSocket客户端已满 (%d)", WS_MAX_CLIENTS);
+            return ESP_FAIL;
+        }
+        ESP_LOGI(TAG, "WebSocket客户端 #%lu 已连接 (fd=%d)", (unsigned long)id, fd);
+        web_send_status_to(id, "WebSocket已连接");
+        return ESP_OK;
+    }
+
+    httpd_ws_frame_t frame = { 0 };
+    esp_err_t ret = httpd_ws_recv_frame(req, &frame, 0);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    if (frame.len == 0) {
+        return ESP_OK;
+    }
+
+    char buf[WS_RECV_MAX];
+    if (frame.len >= sizeof(buf)) {
+        ESP_LOGW(TAG, "WebSocket消息过长 (%u 字节)", (unsigned)frame.len);
+        return ESP_FAIL;
+    }
+    frame.payload = (uint8_t *)buf;
+    ret = httpd_ws_recv_frame(req, &frame, frame.len);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    buf[frame.len] = '\0';
+
+    if (frame.type == HTTPD_WS_TYPE_TEXT) {
+        ws_handle_text(ws_client_id(fd), buf);
+    }
     return ESP_OK;
 }
 
+// 连接关闭 (含 WebSocket 客户端断开)
+static void ws_session_close(httpd_handle_t hd, int sockfd)
+{
+    ws_client_remove(sockfd);
+    close(sockfd);
+}
+
 // HTTP URI处理表
 static const httpd_uri_t uri_handlers[] = {
     {
@@ -399,11 +1068,24 @@ static const httpd_uri_t uri_handlers[] = {
         .handler = api_chat_post_handler,
         .user_ctx = NULL
     },
+    {
+        .uri = "/api/chat/stream",
+        .method = HTTP_POST,
+        .handler = api_chat_stream_post_handler,
+        .user_ctx = NULL
+    },
     {
         .uri = "/api/status",
         .method = HTTP_GET,
         .handler = api_status_get_handler,
         .user_ctx = NULL
+    },
+    {
+        .uri = "/ws",
+        .method = HTTP_GET,
+        .handler = ws_handler,
+        .user_ctx = NULL,
+        .is_websocket = true
     }
 };
 
@@ -416,6 +1098,32 @@ esp_err_t web_interface_init(void)
     config.server_port = web_config.port;
     config.max_uri_handlers = 16;
     config.stack_size = 8192;
+    config.close_fn = ws_session_close;
+    config.send_wait_timeout = 3;      // 推送给卡住的浏览器最多等待 3 秒，然后关闭该连接
+    
+    // WebSocket 推送任务
+    if (ws_send_queue == NULL) {
+        ws_lock = xSemaphoreCreateMutex();
+        ws_send_queue = xQueueCreate(WS_SEND_QUEUE_LEN, sizeof(ws_out_t *));
+        if (ws_lock == NULL || ws_send_queue == NULL ||
+            xTaskCreate(ws_send_task, "ws_send", 4096, NULL, 5, NULL) != pdPASS) {
+            ESP_LOGE(TAG, "WebSocket推送任务创建失败");
+            return ESP_ERR_NO_MEM;
+        }
+        for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+            ws_clients[i].fd = -1;
+        }
+    }
+    
+    // 流式聊天任务 (TLS 握手在该任务中进行，需要较大的栈)
+    if (chat_stream_queue == NULL) {
+        chat_stream_queue = xQueueCreate(CHAT_STREAM_QUEUE_LEN, sizeof(chat_stream_job_t *));
+        if (chat_stream_queue == NULL ||
+            xTaskCreate(chat_stream_task, "chat_stream", 8192, NULL, 5, NULL) != pdPASS) {
+            ESP_LOGE(TAG, "流式聊天任务创建失败");
+            return ESP_ERR_NO_MEM;
+        }
+    }
     
     // 启动HTTP服务器
     esp_err_t ret = httpd_start(&server, &config);
@@ -458,20 +1166,53 @@ esp_err_t web_interface_stop(void)
 }
 
 esp_err_t web_send_response(ai_response_t *response)
+{
+    return web_send_response_to(WEB_CLIENT_ALL, response);
+}
+
+esp_err_t web_send_response_to(uint32_t client, const ai_response_t *response)
 {
     if (response == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    ESP_LOGI(TAG, "发送AI响应到Web界面: %s", response->text);
+    ESP_LOGI(TAG, "发送AI响应到Web界面 (客户端 #%lu): %s", (unsigned long)client, response->text);
     
-    // 这里应该通过WebSocket发送响应
-    // 暂时只记录日志
+    cJSON *json = cJSON_CreateObject();
+    cJSON_AddStringToObject(json, "type", "response");
+    cJSON_AddStringToObject(json, "text", response->text);
+    cJSON_AddStringToObject(json, "action", response->action);
+    cJSON_AddStringToObject(json, "emotion", response->emotion);
+    cJSON_AddNumberToObject(json, "confidence", response->confidence);
+    return ws_enqueue(client, json);
+}
+
+esp_err_t web_send_token(uint32_t client, const char *token, size_t len)
+{
+    if (token == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
     
-    return ESP_OK;
+    // token 不以 '\0' 结尾
+    char text[128];
+    if (len >= sizeof(text)) {
+        len = sizeof(text) - 1;
+    }
+    memcpy(text, token, len);
+    text[len] = '\0';
+    
+    cJSON *json = cJSON_CreateObject();
+    cJSON_AddStringToObject(json, "type", "token");
+    cJSON_AddStringToObject(json, "text", text);
+    return ws_enqueue(client, json);
 }
 
 esp_err_t web_send_status(const char *status)
+{
+    return web_send_status_to(WEB_CLIENT_ALL, status);
+}
+
+esp_err_t web_send_status_to(uint32_t client, const char *status)
 {
     if (status == NULL) {
         return ESP_ERR_INVALID_ARG;
@@ -479,7 +1220,10 @@ esp_err_t web_send_status(const char *status)
     
     ESP_LOGI(TAG, "发送状态更新: %s", status);
     
-    return ESP_OK;
+    cJSON *json = cJSON_CreateObject();
+    cJSON_AddStringToObject(json, "type", "status");
+    cJSON_AddStringToObject(json, "message", status);
+    return ws_enqueue(client, json);
 }
 
 esp_err_t web_set_config(web_config_t *config)
@@ -502,7 +1246,10 @@ esp_err_t web_broadcast_message(const char *message)
     
     ESP_LOGI(TAG, "广播消息: %s", message);
     
-    return ESP_OK;
+    cJSON *json = cJSON_CreateObject();
+    cJSON_AddStringToObject(json, "type", "broadcast");
+    cJSON_AddStringToObject(json, "message", message);
+    return ws_enqueue(WEB_CLIENT_ALL, json);
 }
 
 esp_err_t web_handle_chat_message(const char *message)
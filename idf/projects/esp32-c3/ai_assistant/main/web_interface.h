@@ -24,16 +24,23 @@ typedef enum {
 // WebSocket消息结构
 typedef struct {
     ws_msg_type_t type;
+    uint32_t client;        // 来源客户端编号 (回复时使用)
     char data[512];
     int length;
 } ws_message_t;
 
+// 发送给所有 WebSocket 客户端
+#define WEB_CLIENT_ALL  0
+
 // 函数声明
 esp_err_t web_interface_init(void);
 esp_err_t web_interface_start(void);
 esp_err_t web_interface_stop(void);
 esp_err_t web_send_response(ai_response_t *response);
 esp_err_t web_send_status(const char *status);
+esp_err_t web_send_response_to(uint32_t client, const ai_response_t *response);
+esp_err_t web_send_token(uint32_t client, const char *token, size_t len);
+esp_err_t web_send_status_to(uint32_t client, const char *status);
 esp_err_t web_set_config(web_config_t *config);
 esp_err_t web_broadcast_message(const char *message);
 esp_err_t web_handle_chat_message(const char *message);
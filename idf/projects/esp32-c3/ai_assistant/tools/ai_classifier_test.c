@@ -0,0 +1,189 @@
+/*
+ * 本地意图分类器主机测试 (Linux / macOS)
+ *
+ * 用设备上相同的 main/ai_classifier.c (和它用到的 ai_cache_normalize) 及构建时生成的
+ * ai_classifier_model.h，读取 tools/ai_classifier_train.py --predictions 写出的逐条预测，输出:
+ * - C 实现与 Python 整数模型的预测类别和置信度逐位一致
+ * - 训练集和留出集 (每个意图每 5 条留出 1 条) 的准确率，按 AI_CLASSIFIER_MIN_CONFIDENCE
+ *   在本地处理的条数、误判数和命令召回率 (与 --report 的计算相同)
+ * - 每次 ai_classifier_predict() 的平均耗时 (纳秒，含两次 esp_timer_get_time()，单独列出)
+ *
+ * 编译和运行:
+ *     mkdir -p host_build
+ *     python3 tools/ai_intent_compile.py main/ai_intents.txt host_build/ai_intent_table.h
+ *     python3 tools/ai_classifier_train.py main/ai_classifier_data.txt host_build/ai_classifier_model.h \
+ *         --predictions host_build/classifier_predictions.tsv
+ *     cc -O2 -Imain -Itools/host -Ihost_build -o classifier_test tools/ai_classifier_test.c \
+ *        main/ai_classifier.c main/ai_cache.c main/ai_intent.c
+ *     ./classifier_test host_build/classifier_predictions.tsv          # 默认 200 轮
+ */
+
+#include "ai_classifier.h"
+#include "esp_timer.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_SAMPLES     2048
+#define DEFAULT_ROUNDS  200
+#define PASSES          7
+
+typedef struct {
+    bool test;              // 留出集
+    char label[24];         // 标注的类别
+    char expect[24];        // Python 预测的类别 (other 和无特征都记为 none)
+    int confidence;         // Python 预测的置信度
+    char text[256];
+} sample_t;
+
+static sample_t samples[MAX_SAMPLES];
+
+typedef struct {
+    int total;
+    int correct;
+    int commands;           // 标注不是 other 的条数
+    int accepted;           // 置信度达到阈值、在本地处理
+    int accepted_ok;
+    int false_accept;
+} split_stats_t;
+
+static const char *class_name(const char *name)
+{
+    return (strcmp(name, "other") == 0 || strcmp(name, "-") == 0) ? "none" : name;
+}
+
+static int load(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        return -1;
+    }
+    char line[512];
+    int count = 0;
+    while (count < MAX_SAMPLES && fgets(line, sizeof(line), f) != NULL) {
+        sample_t *s = &samples[count];
+        char split[8];
+        char label[24];
+        char expect[24];
+        int n = 0;
+        if (sscanf(line, "%7[^\t]\t%23[^\t]\t%23[^\t]\t%d\t%n", split, label, expect, &s->confidence, &n) != 4) {
+            continue;
+        }
+        line[strcspn(line, "\r\n")] = '\0';
+        snprintf(s->text, sizeof(s->text), "%s", line + n);
+        snprintf(s->label, sizeof(s->label), "%s", class_name(label));
+        snprintf(s->expect, sizeof(s->expect), "%s", class_name(expect));
+        s->test = strcmp(split, "test") == 0;
+        count++;
+    }
+    fclose(f);
+    return count;
+}
+
+static void print_split(const char *name, const split_stats_t *st)
+{
+    printf("%-6s %4d lines, accuracy %5.1f%%; confidence >= %d%%: %d handled locally (%d correct, %d wrong), "
+           "command recall %.1f%%\n", name, st->total, 100.0 * st->correct / (st->total ? st->total : 1),
+           AI_CLASSIFIER_MIN_CONFIDENCE, st->accepted, st->accepted_ok, st->false_accept,
+           100.0 * st->accepted_ok / (st->commands ? st->commands : 1));
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static volatile int64_t sink;
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <predictions.tsv> [rounds]\n", argv[0]);
+        return 2;
+    }
+    int count = load(argv[1]);
+    if (count <= 0) {
+        fprintf(stderr, "%s: no predictions (run ai_classifier_train.py --predictions first)\n", argv[1]);
+        return 2;
+    }
+    int rounds = argc > 2 ? atoi(argv[2]) : DEFAULT_ROUNDS;
+    if (rounds <= 0) {
+        rounds = DEFAULT_ROUNDS;
+    }
+
+    // 与 Python 整数模型逐条比对，同时统计准确率
+    int mismatches = 0;
+    split_stats_t stats[2] = {0};
+    for (int i = 0; i < count; i++) {
+        const sample_t *s = &samples[i];
+        ai_classifier_result_t res;
+        ai_classifier_predict(s->text, &res);
+        const char *got = ai_intent_name(res.intent);
+        if (strcmp(got, s->expect) != 0 || res.confidence != s->confidence) {
+            printf("MISMATCH %-24s python %s %d%%, c %s %u%%\n", s->text, s->expect, s->confidence, got,
+                   res.confidence);
+            mismatches++;
+        }
+
+        split_stats_t *st = &stats[s->test];
+        bool command = strcmp(s->label, "none") != 0;
+        st->total++;
+        st->correct += strcmp(got, s->label) == 0;
+        st->commands += command;
+        if (res.intent != AI_INTENT_NONE && res.confidence >= AI_CLASSIFIER_MIN_CONFIDENCE) {
+            st->accepted++;
+            if (strcmp(got, s->label) == 0) {
+                st->accepted_ok++;
+            } else {
+                st->false_accept++;
+            }
+        }
+    }
+    printf("%d lines, %d differ from the Python integer model (class or confidence)\n", count, mismatches);
+    print_split("train", &stats[0]);
+    print_split("test", &stats[1]);
+
+    // 耗时: 全部例句跑 rounds 轮，取最快的一次
+    size_t bytes = 0;
+    for (int i = 0; i < count; i++) {
+        bytes += strlen(samples[i].text);
+    }
+    double best = 0.0;
+    for (int pass = 0; pass < PASSES; pass++) {
+        int64_t acc = 0;
+        double t0 = now_ns();
+        for (int r = 0; r < rounds; r++) {
+            for (int i = 0; i < count; i++) {
+                ai_classifier_result_t res;
+                acc += ai_classifier_predict(samples[i].text, &res) + res.confidence;
+            }
+        }
+        double ns = now_ns() - t0;
+        sink = acc;
+        if (pass == 0 || ns < best) {
+            best = ns;
+        }
+    }
+    double timer = 0.0;
+    for (int pass = 0; pass < PASSES; pass++) {
+        int64_t acc = 0;
+        double t0 = now_ns();
+        for (int i = 0; i < rounds * count; i++) {
+            acc += esp_timer_get_time();
+        }
+        double ns = now_ns() - t0;
+        sink = acc;
+        if (pass == 0 || ns < timer) {
+            timer = ns;
+        }
+    }
+    double queries = (double)rounds * count;
+    printf("\nfastest of %d passes x %d rounds, avg %.1f bytes per line\n", PASSES, rounds, (double)bytes / count);
+    printf("ai_classifier_predict: %.0f ns per query (of which 2 x esp_timer_get_time %.0f ns)\n",
+           best / queries, 2.0 * timer / queries);
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,319 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+本地意图分类器训练
+
+用 main/ai_classifier_data.txt 训练一个字符 n-gram 线性分类器，量化为 int8 后生成 C 头文件：
+- 文本先按回复缓存的规则规范化 (去空白和标点、ASCII 转小写、全角转半角，见 ai_cache_normalize)
+- 特征为字符 1~3-gram (含首尾标记)，FNV-1a 哈希到固定数量的桶，不需要词表
+- 模型为 softmax 线性分类: 各桶权重取平均加偏置，训练用 AdaGrad，固定随机种子 (结果可重现)
+- 权重统一按最大绝对值量化为 int8，推理只有整数加法；置信度用查表的 exp 计算
+
+每个意图每 5 条例句留出 1 条不参与训练，--report 输出留出集上量化后模型的准确率
+(与设备端的整数推理逐位一致) 和按置信度阈值接受/转交后端的情况；--predictions 写出
+每条例句的预测，tools/ai_classifier_test.c 用它检查 C 实现的结果逐位一致。
+
+构建时由 main/CMakeLists.txt 调用，也可以手动运行:
+    python3 tools/ai_classifier_train.py main/ai_classifier_data.txt build/ai_classifier_model.h --report
+"""
+
+import argparse
+import math
+import random
+import sys
+
+NUM_BUCKETS = 2048          # 哈希桶数 (2 的幂)
+MAX_NGRAM = 3
+BOS = b'\x02'               # 首尾标记 (规范化后的文本中不会出现控制字符)
+EOS = b'\x03'
+EXP_STEPS_PER_LOGIT = 8     # 置信度 exp 表的精度: 每 1/8 个 logit 一项
+EXP_TABLE_SIZE = 64         # 覆盖 logit 差 0~8 (exp(-8) 已可忽略)
+OTHER = 'other'             # 交给后端的类别
+
+
+def load_data(path, holdout):
+    """读取训练数据，返回 (类别列表, 训练集 [(文本, 类别下标)], 留出集)"""
+    classes = []
+    per_class = {}
+    with open(path, encoding='utf-8') as f:
+        for lineno, raw in enumerate(f, 1):
+            line = raw.split('#', 1)[0].strip()
+            if not line:
+                continue
+            cols = [c.strip() for c in line.split('|')]
+            if len(cols) != 2 or not cols[0] or not cols[1]:
+                sys.exit(f'{path}:{lineno}: 需要 2 列 (意图 | 例句)')
+            name, text = cols
+            if name not in classes:
+                classes.append(name)
+                per_class[name] = []
+            per_class[name].append(text)
+    if OTHER not in classes:
+        sys.exit(f'{path}: 缺少 {OTHER} 类别的例句')
+    # other 放在最后，其余按出现顺序
+    classes.remove(OTHER)
+    classes.append(OTHER)
+
+    train, test = [], []
+    for idx, name in enumerate(classes):
+        for i, text in enumerate(per_class[name]):
+            (test if holdout and i % holdout == holdout - 1 else train).append((text, idx))
+    return classes, train, test
+
+
+def is_c_punct(c):
+    """C 库 (C locale) 的 isspace / ispunct / iscntrl"""
+    return c <= 0x20 or c == 0x7F or not (0x30 <= c <= 0x39 or 0x41 <= c <= 0x5A or 0x61 <= c <= 0x7A)
+
+
+def normalize(text):
+    """与 ai_cache_normalize() 相同的规范化，返回字符列表 (每个字符为 UTF-8 字节串)"""
+    chars = []
+    for ch in text:
+        cp = ord(ch)
+        if cp < 0x80:
+            if not is_c_punct(cp):
+                chars.append(ch.lower().encode())
+        elif 0x800 <= cp <= 0xFFFF:
+            if 0x2000 <= cp <= 0x206F or 0x3000 <= cp <= 0x303F or 0xFE10 <= cp <= 0xFE6F:
+                continue
+            if 0xFF01 <= cp <= 0xFF5E:
+                a = cp - 0xFEE0
+                if not is_c_punct(a):
+                    chars.append(chr(a).lower().encode())
+                continue
+            chars.append(ch.encode())
+        else:
+            chars.append(ch.encode())
+    return chars
+
+
+def fnv1a(n, data):
+    h = 0x811C9DC5
+    for b in bytes([n]) + data:
+        h = ((h ^ b) * 0x01000193) & 0xFFFFFFFF
+    return h
+
+
+def features(text):
+    """文本的 n-gram 桶编号列表 (可重复)，与 ai_classifier.c 中的计算一致"""
+    chars = normalize(text)
+    if not chars:
+        return []
+    seq = [BOS] + chars + [EOS]
+    buckets = []
+    for i in range(len(seq)):
+        for n in range(1, MAX_NGRAM + 1):
+            if i + n > len(seq):
+                break
+            if n == 1 and (i == 0 or i == len(seq) - 1):
+                continue    # 首尾标记本身不是特征
+            h = fnv1a(n, b''.join(seq[i:i + n]))
+            buckets.append((h ^ (h >> 15)) & (NUM_BUCKETS - 1))
+    return buckets
+
+
+def softmax(z):
+    m = max(z)
+    e = [math.exp(v - m) for v in z]
+    s = sum(e)
+    return [v / s for v in e]
+
+
+def train_model(samples, num_classes, epochs, lr, l2, seed):
+    """softmax 线性分类 (特征取平均)，AdaGrad 训练，返回 (权重 [桶][类别], 偏置)"""
+    rng = random.Random(seed)
+    weights = [[0.0] * num_classes for _ in range(NUM_BUCKETS)]
+    bias = [0.0] * num_classes
+    g2_w = [[1e-8] * num_classes for _ in range(NUM_BUCKETS)]
+    g2_b = [1e-8] * num_classes
+    data = [(features(text), label) for text, label in samples]
+    data = [(f, label) for f, label in data if f]
+
+    for _ in range(epochs):
+        rng.shuffle(data)
+        for feats, label in data:
+            inv = 1.0 / len(feats)
+            z = list(bias)
+            for b in feats:
+                row = weights[b]
+                for c in range(num_classes):
+                    z[c] += row[c] * inv
+            p = softmax(z)
+            grad = [p[c] - (1.0 if c == label else 0.0) for c in range(num_classes)]
+            for c in range(num_classes):
+                g2_b[c] += grad[c] * grad[c]
+                bias[c] -= lr * grad[c] / math.sqrt(g2_b[c])
+            for b in set(feats):
+                cnt = feats.count(b) * inv
+                row, g2 = weights[b], g2_w[b]
+                for c in range(num_classes):
+                    g = grad[c] * cnt + l2 * row[c]
+                    g2[c] += g * g
+                    row[c] -= lr * g / math.sqrt(g2[c])
+    return weights, bias
+
+
+def quantize(weights, bias):
+    """按最大绝对值量化为 int8，偏置换算到同一刻度 (int32)"""
+    peak = max(max(abs(v) for v in row) for row in weights)
+    scale = peak / 127 if peak > 0 else 1.0
+    wq = [[max(-127, min(127, round(v / scale))) for v in row] for row in weights]
+    bq = [round(v / scale) for v in bias]
+    return wq, bq, scale
+
+
+def exp_table():
+    return [round(32768 * math.exp(-k / EXP_STEPS_PER_LOGIT)) for k in range(EXP_TABLE_SIZE)]
+
+
+def predict_q(model, text):
+    """整数推理 (与 ai_classifier.c 逐位一致)，返回 (类别下标, 置信度百分比)；无特征时返回 (None, 0)"""
+    wq, bq, logit_q16, table = model
+    feats = features(text)
+    if not feats:
+        return None, 0
+    n = len(feats)
+    acc = [n * b for b in bq]
+    for b in feats:
+        row = wq[b]
+        for c in range(len(acc)):
+            acc[c] += row[c]
+    best = max(range(len(acc)), key=lambda c: (acc[c], -c))
+    total = 0
+    for c in range(len(acc)):
+        k = ((acc[best] - acc[c]) * logit_q16 // n) >> 16
+        if k < EXP_TABLE_SIZE:
+            total += table[k]
+    return best, table[0] * 100 // total
+
+
+def evaluate(classes, model, samples, threshold):
+    """量化模型在样本上的表现，返回 (准确率, 报告文本行)"""
+    other = classes.index(OTHER)
+    correct = accepted = accepted_ok = false_accept = commands = 0
+    confusion = {}
+    for text, label in samples:
+        pred, conf = predict_q(model, text)
+        if pred == label:
+            correct += 1
+        else:
+            confusion.setdefault((classes[label], classes[pred] if pred is not None else '-'), []).append(text)
+        if label != other:
+            commands += 1
+        if pred is not None and pred != other and conf >= threshold:
+            accepted += 1
+            if pred == label:
+                accepted_ok += 1
+            else:
+                false_accept += 1
+    total = max(len(samples), 1)
+    lines = [f'{len(samples)} 条, 准确率 {100 * correct / total:.1f}%',
+             f'  置信度 >= {threshold}% 本地处理 {accepted} 条 (正确 {accepted_ok}, 误判 {false_accept}), '
+             f'命令召回 {100 * accepted_ok / max(commands, 1):.1f}%']
+    for (want, got), texts in sorted(confusion.items()):
+        lines.append(f'  {want} -> {got}: {", ".join(texts)}')
+    return correct / total, lines
+
+
+def write_predictions(path, classes, model, train, test):
+    """逐条写出量化模型的预测 (集合、标注、预测、置信度、例句)，供 tools/ai_classifier_test.c 逐位比对"""
+    with open(path, 'w', encoding='utf-8') as f:
+        for split, samples in (('train', train), ('test', test)):
+            for text, label in samples:
+                pred, conf = predict_q(model, text)
+                name = classes[pred] if pred is not None else '-'
+                f.write(f'{split}\t{classes[label]}\t{name}\t{conf}\t{text}\n')
+
+
+def generate(args):
+    classes, train, test = load_data(args.data, args.holdout)
+    weights, bias = train_model(train, len(classes), args.epochs, args.lr, args.l2, args.seed)
+    wq, bq, scale = quantize(weights, bias)
+    logit_q16 = round(scale * EXP_STEPS_PER_LOGIT * 65536)
+    table = exp_table()
+    model = (wq, bq, logit_q16, table)
+
+    _, train_lines = evaluate(classes, model, train, args.threshold)
+    accuracy, test_lines = evaluate(classes, model, test, args.threshold)
+    if args.report:
+        print('训练集:', '\n'.join(train_lines))
+        print('留出集:', '\n'.join(test_lines))
+    if args.predictions:
+        write_predictions(args.predictions, classes, model, train, test)
+
+    g = []
+    g.append('// 由 tools/ai_classifier_train.py 根据 ai_classifier_data.txt 训练生成，请勿手动修改')
+    g.append(f'// {len(classes)} 个类别, 训练 {len(train)} 条, 留出 {len(test)} 条 '
+             f'(量化后准确率 {100 * accuracy:.1f}%), 权重 {NUM_BUCKETS * len(classes)} 字节')
+    g.append('')
+    g.append('#ifndef AI_CLASSIFIER_MODEL_H')
+    g.append('#define AI_CLASSIFIER_MODEL_H')
+    g.append('')
+    g.append('#include <stdint.h>')
+    g.append('')
+    g.append(f'#define AI_CLASSIFIER_NUM_BUCKETS   {NUM_BUCKETS}')
+    g.append(f'#define AI_CLASSIFIER_NUM_CLASSES   {len(classes)}')
+    g.append(f'#define AI_CLASSIFIER_MAX_NGRAM     {MAX_NGRAM}')
+    g.append('')
+    g.append('// logit 差 (整数累加值之差 / 特征数) 换算为 exp 表下标的系数 (Q16)')
+    g.append(f'#define AI_CLASSIFIER_LOGIT_Q16     {logit_q16}')
+    g.append(f'#define AI_CLASSIFIER_EXP_SIZE      {EXP_TABLE_SIZE}')
+    g.append('')
+    g.append(f'// 类别对应的意图 ({OTHER} 为 AI_INTENT_NONE，交给后端)')
+    g.append('static const int8_t ai_classifier_intents[AI_CLASSIFIER_NUM_CLASSES] = {')
+    for name in classes:
+        g.append('    AI_INTENT_NONE,' if name == OTHER else f'    AI_INTENT_{name.upper()},')
+    g.append('};')
+    g.append('')
+    g.append('// 偏置 (与权重同一刻度)')
+    g.append('static const int32_t ai_classifier_bias[AI_CLASSIFIER_NUM_CLASSES] = {')
+    g.append('    ' + ', '.join(str(v) for v in bq) + ',')
+    g.append('};')
+    g.append('')
+    g.append('// exp(-k / 8)，Q15')
+    g.append('static const uint16_t ai_classifier_exp[AI_CLASSIFIER_EXP_SIZE] = {')
+    for i in range(0, EXP_TABLE_SIZE, 16):
+        g.append('    ' + ', '.join(str(v) for v in table[i:i + 16]) + ',')
+    g.append('};')
+    g.append('')
+    g.append('// 权重 [哈希桶][类别]，int8')
+    g.append('static const int8_t ai_classifier_weights[AI_CLASSIFIER_NUM_BUCKETS][AI_CLASSIFIER_NUM_CLASSES] = {')
+    for row in wq:
+        g.append('    { ' + ', '.join(str(v) for v in row) + ' },')
+    g.append('};')
+    g.append('')
+    g.append('#endif // AI_CLASSIFIER_MODEL_H')
+    g.append('')
+
+    text = '\n'.join(g)
+    # 内容不变时不改写文件，避免触发无谓的重新编译
+    try:
+        with open(args.output, encoding='utf-8') as f:
+            if f.read() == text:
+                return
+    except OSError:
+        pass
+    with open(args.output, 'w', encoding='utf-8') as f:
+        f.write(text)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='训练本地意图分类器')
+    parser.add_argument('data', help='训练数据 (ai_classifier_data.txt)')
+    parser.add_argument('output', help='生成的头文件 (ai_classifier_model.h)')
+    parser.add_argument('--report', action='store_true', help='输出训练集和留出集上的准确率')
+    parser.add_argument('--predictions', metavar='PATH',
+                        help='写出每条例句的预测结果 (tools/ai_classifier_test.c 的输入)')
+    parser.add_argument('--threshold', type=int, default=50,
+                        help='报告中使用的置信度阈值 (与 AI_CLASSIFIER_MIN_CONFIDENCE 一致)')
+    parser.add_argument('--holdout', type=int, default=5, help='每 N 条留出 1 条 (0 为全部用于训练)')
+    parser.add_argument('--epochs', type=int, default=30)
+    parser.add_argument('--lr', type=float, default=1.0)
+    parser.add_argument('--l2', type=float, default=1e-5)
+    parser.add_argument('--seed', type=int, default=1)
+    generate(parser.parse_args())
+
+
+if __name__ == '__main__':
+    main()
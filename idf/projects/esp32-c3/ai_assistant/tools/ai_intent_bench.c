@@ -0,0 +1,251 @@
+/*
+ * 本地意图匹配主机基准 (Linux / macOS)
+ *
+ * 用设备上相同的 main/ai_intent.c 和构建时生成的 ai_intent_table.h，对中英文混合的命令语料:
+ * - 检查关键词自动机的本地决策 (回复哪个意图，或交给后端) 与期望一致
+ * - 与改动前 ai_process_local_command() 的写法 (复制到 256 字节缓冲区、逐字节转小写、
+ *   按固定顺序 strstr，设备/音乐命令在处理函数里再复制、转换、查找一次) 逐条比较；
+ *   只允许有意改变的条目不同 ("hi" 改为整词匹配、同一意图多个关键词累加得分)
+ * - 输出两种写法每条命令的平均耗时 (纳秒) 和每字节耗时
+ *
+ * 编译和运行:
+ *     mkdir -p host_build
+ *     python3 tools/ai_intent_compile.py main/ai_intents.txt host_build/ai_intent_table.h
+ *     cc -O2 -Imain -Ihost_build -o intent_bench tools/ai_intent_bench.c main/ai_intent.c
+ *     ./intent_bench                   # 默认 20000 轮
+ *     ./intent_bench 100000
+ */
+
+#include "ai_intent.h"
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_ROUNDS  20000
+#define PASSES          7
+
+typedef struct {
+    const char *text;
+    const char *expect;     // 本地决策: 意图名，"none" 表示交给后端
+    bool changed;           // 旧写法的结果有意不同
+} sample_t;
+
+static const sample_t corpus[] = {
+    { "现在几点了", "time", false },
+    { "What time is it?", "time", false },
+    { "今天天气怎么样", "weather", false },
+    { "What's the WEATHER like in Shanghai tomorrow", "weather", false },
+    { "请帮我开灯", "light_on", false },
+    { "Turn on the living room light", "light_on", false },
+    { "关灯", "light_off", false },
+    { "please TURN OFF the lights", "light_off", false },
+    { "播放一首周杰伦的歌", "music_play", false },
+    { "play some jazz", "music_play", false },
+    { "暂停", "music_pause", false },
+    { "Pause the music", "music_pause", false },
+    { "你好", "greeting", false },
+    { "Hello there", "greeting", false },
+    { "hi", "greeting", false },
+    { "Hi, 小智", "greeting", false },
+    { "小智你好，现在几点", "time", false },
+    { "你能做什么", "help", false },
+    { "help", "help", false },
+    { "Can you help me play music", "music_play", false },
+    { "关灯然后播放音乐", "light_off", false },
+    { "播放明天的天气预报", "weather", false },
+    { "暂停播放", "music_play", false },
+    { "turn on the music and play it loud", "light_on", false },
+    { "HELLO, WHAT TIME IS IT", "time", false },
+    { "Thinking about 天气", "weather", false },
+    { "Display the history", "music_play", false },     // "play" 仍是子串匹配
+    { "小智，帮我查一下明天上海的天气，如果下雨的话提醒我带伞，顺便把客厅的灯打开", "weather", false },
+    { "给我讲个笑话", "none", false },
+    { "最新的股票新闻", "none", false },
+    { "Tell me a random joke", "none", false },
+    { "明天会下雨吗", "none", false },
+    { "解释一下量子纠缠", "none", false },
+    { "How does a transformer model work?", "none", false },
+    { "Ping", "none", false },
+    { "", "none", false },
+    // "hi" 改为整词匹配：旧写法把 this / which / chip / whisper / shipping 当作问候
+    { "This is which chip?", "none", true },
+    { "Whisper something to me", "none", true },
+    { "Shipping status of my order", "none", true },
+    // 得分累加：两个天气关键词胜过一个时间关键词，旧写法总是先查时间
+    { "What's the weather? 天气 and time", "weather", true },
+};
+
+#define CORPUS_SIZE (sizeof(corpus) / sizeof(corpus[0]))
+
+// ---------------------------------------------------------------------------
+// 改动前的写法 (ai_engine.c 中的 ai_process_local_command 及设备/音乐处理函数)
+// ---------------------------------------------------------------------------
+
+static void legacy_lower(char *dst, const char *src)
+{
+    // 原来是 strcpy；语料都短于 256 字节，这里限制长度只为避免越界
+    snprintf(dst, 256, "%s", src);
+    for (int i = 0; dst[i]; i++) {
+        dst[i] = (char)tolower((unsigned char)dst[i]);
+    }
+}
+
+static const char *legacy_device_control(const char *command)
+{
+    char cmd_lower[256];
+    legacy_lower(cmd_lower, command);
+    if (strstr(cmd_lower, "开灯") || strstr(cmd_lower, "turn on")) {
+        return "light_on";
+    } else if (strstr(cmd_lower, "关灯") || strstr(cmd_lower, "turn off")) {
+        return "light_off";
+    }
+    return "unknown";
+}
+
+static const char *legacy_music_control(const char *command)
+{
+    char cmd_lower[256];
+    legacy_lower(cmd_lower, command);
+    if (strstr(cmd_lower, "播放") || strstr(cmd_lower, "play")) {
+        return "music_play";
+    } else if (strstr(cmd_lower, "暂停") || strstr(cmd_lower, "pause")) {
+        return "music_pause";
+    }
+    return "unknown";
+}
+
+static const char *legacy_local_command(const char *command)
+{
+    char cmd_lower[256];
+    legacy_lower(cmd_lower, command);
+
+    if (strstr(cmd_lower, "时间") || strstr(cmd_lower, "几点") || strstr(cmd_lower, "time")) {
+        return "time";
+    }
+    if (strstr(cmd_lower, "天气") || strstr(cmd_lower, "weather")) {
+        return "weather";
+    }
+    if (strstr(cmd_lower, "开灯") || strstr(cmd_lower, "关灯") ||
+        strstr(cmd_lower, "turn on") || strstr(cmd_lower, "turn off")) {
+        return legacy_device_control(command);
+    }
+    if (strstr(cmd_lower, "播放") || strstr(cmd_lower, "暂停") ||
+        strstr(cmd_lower, "play") || strstr(cmd_lower, "pause")) {
+        return legacy_music_control(command);
+    }
+    if (strstr(cmd_lower, "你好") || strstr(cmd_lower, "hello") ||
+        strstr(cmd_lower, "hi") || strstr(cmd_lower, "小智")) {
+        return "greeting";
+    }
+    if (strstr(cmd_lower, "帮助") || strstr(cmd_lower, "help") ||
+        strstr(cmd_lower, "能做什么")) {
+        return "help";
+    }
+    return "none";
+}
+
+// ---------------------------------------------------------------------------
+// 现在的写法：ai_process_local_command() 的本地决策
+// ---------------------------------------------------------------------------
+
+static const char *automaton_local_command(const char *command)
+{
+    ai_intent_result_t match;
+    int intent = ai_intent_match(command, &match);
+    // 实时类和创作类没有本地回复，只用于缓存分类
+    if (intent == AI_INTENT_NONE || intent == AI_INTENT_REALTIME || intent == AI_INTENT_CREATIVE) {
+        return "none";
+    }
+    return ai_intent_name(intent);
+}
+
+/**
+ * 截断到 max 字节以内，不拆开 UTF-8 多字节字符
+ */
+static const char *clip(const char *text, char *buf, size_t max)
+{
+    size_t n = strlen(text);
+    if (n > max) {
+        n = max;
+        while (n > 0 && ((uint8_t)text[n] & 0xC0) == 0x80) {
+            n--;
+        }
+    }
+    memcpy(buf, text, n);
+    buf[n] = '\0';
+    return buf;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static volatile size_t sink;
+
+/**
+ * 整个语料跑 rounds 轮，取 PASSES 次中最快的一次，返回每条命令的纳秒数
+ */
+static double bench(const char *(*fn)(const char *), int rounds)
+{
+    double best = 0.0;
+    for (int pass = 0; pass < PASSES; pass++) {
+        size_t acc = 0;
+        double t0 = now_ns();
+        for (int r = 0; r < rounds; r++) {
+            for (size_t i = 0; i < CORPUS_SIZE; i++) {
+                acc += (size_t)fn(corpus[i].text)[0];
+            }
+        }
+        double ns = now_ns() - t0;
+        sink = acc;
+        if (pass == 0 || ns < best) {
+            best = ns;
+        }
+    }
+    return best / ((double)rounds * CORPUS_SIZE);
+}
+
+int main(int argc, char **argv)
+{
+    int rounds = argc > 1 ? atoi(argv[1]) : DEFAULT_ROUNDS;
+    if (rounds <= 0) {
+        rounds = DEFAULT_ROUNDS;
+    }
+
+    int failures = 0;
+    int changed = 0;
+    size_t bytes = 0;
+    printf("%-44s %-12s %-12s %-12s\n", "command", "expect", "automaton", "old chain");
+    for (size_t i = 0; i < CORPUS_SIZE; i++) {
+        const sample_t *s = &corpus[i];
+        const char *now = automaton_local_command(s->text);
+        const char *old = legacy_local_command(s->text);
+        bool ok = strcmp(now, s->expect) == 0;
+        // 旧写法应与期望一致，标记为有意改变的条目应不同
+        bool old_ok = (strcmp(old, s->expect) == 0) != s->changed;
+        const char *note = !ok ? "FAIL" : !old_ok ? "FAIL (old chain)" : s->changed ? "changed" : "ok";
+        char buf[48];
+        printf("%-44s %-12s %-12s %-12s %s\n", clip(s->text, buf, 44), s->expect, now, old, note);
+        failures += !(ok && old_ok);
+        changed += s->changed;
+        bytes += strlen(s->text);
+    }
+    printf("%zu commands (%zu bytes, mixed Chinese/English), %d intended differences, %d failures\n\n",
+           CORPUS_SIZE, bytes, changed, failures);
+
+    double ns_old = bench(legacy_local_command, rounds);
+    double ns_new = bench(automaton_local_command, rounds);
+    double per_cmd = (double)bytes / CORPUS_SIZE;
+    printf("fastest of %d passes x %d rounds, CPU time per command (avg %.1f bytes)\n", PASSES, rounds, per_cmd);
+    printf("%-30s %10s %10s\n", "matcher", "ns/cmd", "ns/byte");
+    printf("%-30s %10.1f %10.2f\n", "old tolower + strstr chain", ns_old, ns_old / per_cmd);
+    printf("%-30s %10.1f %10.2f\n", "keyword automaton", ns_new, ns_new / per_cmd);
+    printf("speedup %.2fx\n", ns_old / ns_new);
+    return failures == 0 ? 0 : 1;
+}
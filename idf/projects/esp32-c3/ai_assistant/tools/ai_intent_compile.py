@@ -0,0 +1,229 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+本地意图注册表编译器
+
+把 main/ai_intents.txt 编译为 Aho-Corasick 自动机，生成 C 头文件 (只读表，放在 Flash 中)：
+- 关键词按 UTF-8 字节建字典树，求失败链接后展开为完整的转移表 (DFA)，
+  匹配时每个输入字节只查一次表，不需要回退
+- 输入字节先映射为字节类：关键词中出现的字节各占一类，大写 ASCII 字母与小写同类
+  (大小写折叠不需要额外处理)，其余字节归为第 0 类，转移表宽度为字节类数
+- 每个状态命中的关键词 (含失败链上的后缀) 预先展开为列表
+
+构建时由 main/CMakeLists.txt 调用，也可以手动运行:
+    python3 tools/ai_intent_compile.py main/ai_intents.txt build/ai_intent_table.h
+"""
+
+import argparse
+import re
+import sys
+from collections import deque
+
+
+def parse_registry(path):
+    """解析注册表，返回 (意图名列表, 关键词列表 [(字节串, 意图下标, 权重, 整词)])"""
+    intents = []
+    keywords = []
+    seen = {}
+    with open(path, encoding='utf-8') as f:
+        for lineno, raw in enumerate(f, 1):
+            line = raw.split('#', 1)[0].strip()
+            if not line:
+                continue
+            cols = [c.strip() for c in line.split('|')]
+            if len(cols) != 3:
+                sys.exit(f'{path}:{lineno}: 需要 3 列 (意图 | 权重 | 关键词)')
+            name, weight, words = cols
+            if not re.fullmatch(r'[a-z][a-z0-9_]*', name):
+                sys.exit(f'{path}:{lineno}: 意图名只能包含小写字母、数字和下划线: {name}')
+            if not weight.isdigit() or not 1 <= int(weight) <= 255:
+                sys.exit(f'{path}:{lineno}: 权重应为 1~255: {weight}')
+            if name not in intents:
+                intents.append(name)
+            for word in (w.strip() for w in words.split(',')):
+                whole = word.startswith('=')
+                if whole:
+                    word = word[1:]
+                data = fold_ascii(word.encode('utf-8'))
+                if not data or len(data) > 255:
+                    sys.exit(f'{path}:{lineno}: 关键词为空或过长: {word!r}')
+                key = (data, whole)
+                if key in seen:
+                    sys.exit(f'{path}:{lineno}: 关键词重复: {word!r} (第 {seen[key]} 行)')
+                seen[key] = lineno
+                keywords.append((data, intents.index(name), int(weight), whole))
+    if not keywords:
+        sys.exit(f'{path}: 没有关键词')
+    if len(intents) > 255:
+        sys.exit(f'{path}: 意图过多')
+    return intents, keywords
+
+
+def fold_ascii(data):
+    """只折叠 ASCII 大写字母，UTF-8 多字节序列保持不变"""
+    return bytes(b + 32 if 0x41 <= b <= 0x5A else b for b in data)
+
+
+def build_automaton(keywords):
+    """构建字典树 + 失败链接，返回 (转移表, 字节类映射, 类数, 每个状态的输出列表)"""
+    goto = [{}]
+    out = [[]]
+    for idx, (data, _, _, _) in enumerate(keywords):
+        s = 0
+        for b in data:
+            if b not in goto[s]:
+                goto.append({})
+                out.append([])
+                goto[s][b] = len(goto) - 1
+            s = goto[s][b]
+        out[s].append(idx)
+
+    # 字节类：第 0 类为不出现在任何关键词中的字节
+    used = sorted({b for data, _, _, _ in keywords for b in data})
+    byte_class = [0] * 256
+    for i, b in enumerate(used, 1):
+        byte_class[b] = i
+    for b in range(0x41, 0x5B):
+        byte_class[b] = byte_class[b + 32]
+    num_classes = len(used) + 1
+
+    # 按层次遍历求失败链接，同时展开完整转移 (delta)：
+    # 深度 1 的状态失败链接为根，更深的状态在处理父状态时求出 (失败目标层次更浅，已展开)
+    fail = [0] * len(goto)
+    delta = [[0] * num_classes for _ in goto]
+    for b, t in goto[0].items():
+        delta[0][byte_class[b]] = t
+    queue = deque(goto[0].values())
+    while queue:
+        s = queue.popleft()
+        out[s] = out[s] + out[fail[s]]
+        delta[s] = list(delta[fail[s]])
+        for b, t in goto[s].items():
+            fail[t] = delta[fail[s]][byte_class[b]]
+            delta[s][byte_class[b]] = t
+            queue.append(t)
+    return delta, byte_class, num_classes, out
+
+
+def c_array(values, per_line=16, indent='    '):
+    lines = []
+    for i in range(0, len(values), per_line):
+        lines.append(indent + ', '.join(str(v) for v in values[i:i + per_line]) + ',')
+    return '\n'.join(lines)
+
+
+def c_string(data):
+    """关键词原文 (用于生成代码中的注释)"""
+    return data.decode('utf-8', errors='replace').replace('*/', '* /')
+
+
+def generate(path_in, path_out):
+    intents, keywords = parse_registry(path_in)
+    delta, byte_class, num_classes, out = build_automaton(keywords)
+    num_states = len(delta)
+    state_type = 'uint8_t' if num_states <= 256 else 'uint16_t'
+
+    out_start = [0]
+    out_list = []
+    for s in range(num_states):
+        out_list.extend(out[s])
+        out_start.append(len(out_list))
+
+    kw_type = 'uint8_t' if len(keywords) <= 256 else 'uint16_t'
+    table_bytes = num_states * num_classes * (1 if state_type == 'uint8_t' else 2)
+
+    g = []
+    g.append('// 由 tools/ai_intent_compile.py 根据 ai_intents.txt 生成，请勿手动修改')
+    g.append(f'// {len(intents)} 个意图, {len(keywords)} 个关键词, {num_states} 个状态, '
+             f'{num_classes} 个字节类, 转移表 {table_bytes} 字节')
+    g.append('')
+    g.append('#ifndef AI_INTENT_TABLE_H')
+    g.append('#define AI_INTENT_TABLE_H')
+    g.append('')
+    g.append('#include <stdint.h>')
+    g.append('')
+    g.append('// 意图编号 (注册顺序，得分相同时编号小的优先)')
+    g.append('typedef enum {')
+    for i, name in enumerate(intents):
+        g.append(f'    AI_INTENT_{name.upper()} = {i},')
+    g.append(f'    AI_INTENT_COUNT = {len(intents)},')
+    g.append('} ai_intent_t;')
+    g.append('')
+    g.append('#endif // AI_INTENT_TABLE_H')
+    g.append('')
+    g.append('// 自动机表只由 ai_intent.c 引用 (包含前定义 AI_INTENT_TABLE_IMPL)')
+    g.append('#if defined(AI_INTENT_TABLE_IMPL) && !defined(AI_INTENT_TABLE_IMPL_DONE)')
+    g.append('#define AI_INTENT_TABLE_IMPL_DONE')
+    g.append('')
+    g.append(f'#define AI_INTENT_NUM_STATES     {num_states}')
+    g.append(f'#define AI_INTENT_NUM_CLASSES    {num_classes}')
+    g.append(f'#define AI_INTENT_NUM_KEYWORDS   {len(keywords)}')
+    g.append('')
+    g.append(f'typedef {state_type} ai_intent_state_t;')
+    g.append(f'typedef {kw_type} ai_intent_kw_t;')
+    g.append('')
+    g.append('// 意图名称')
+    g.append('static const char *const ai_intent_names[AI_INTENT_COUNT] = {')
+    for name in intents:
+        g.append(f'    "{name}",')
+    g.append('};')
+    g.append('')
+    g.append('// 关键词: 意图、权重、字节长度、是否整词匹配')
+    g.append('static const struct {')
+    g.append('    uint8_t intent;')
+    g.append('    uint8_t weight;')
+    g.append('    uint8_t len;')
+    g.append('    uint8_t whole_word;')
+    g.append('} ai_intent_keywords[AI_INTENT_NUM_KEYWORDS] = {')
+    for data, intent, weight, whole in keywords:
+        g.append(f'    {{ {intent}, {weight}, {len(data)}, {int(whole)} }},  '
+                 f'// {intents[intent]}: {"=" if whole else ""}{c_string(data)}')
+    g.append('};')
+    g.append('')
+    g.append('// 输入字节 -> 字节类 (大写 ASCII 字母与小写同类)')
+    g.append('static const uint8_t ai_intent_byte_class[256] = {')
+    g.append(c_array(byte_class))
+    g.append('};')
+    g.append('')
+    g.append('// 转移表 [状态][字节类]')
+    g.append('static const ai_intent_state_t ai_intent_delta[AI_INTENT_NUM_STATES][AI_INTENT_NUM_CLASSES] = {')
+    for row in delta:
+        g.append('    {')
+        g.append(c_array(row, 24, '        '))
+        g.append('    },')
+    g.append('};')
+    g.append('')
+    g.append('// 每个状态命中的关键词: ai_intent_out_list[ai_intent_out_start[s] .. ai_intent_out_start[s + 1])')
+    g.append('static const uint16_t ai_intent_out_start[AI_INTENT_NUM_STATES + 1] = {')
+    g.append(c_array(out_start))
+    g.append('};')
+    g.append('')
+    g.append(f'static const ai_intent_kw_t ai_intent_out_list[{max(len(out_list), 1)}] = {{')
+    g.append(c_array(out_list if out_list else [0]))
+    g.append('};')
+    g.append('')
+    g.append('#endif // AI_INTENT_TABLE_IMPL')
+    g.append('')
+
+    text = '\n'.join(g)
+    # 内容不变时不改写文件，避免触发无谓的重新编译
+    try:
+        with open(path_out, encoding='utf-8') as f:
+            if f.read() == text:
+                return
+    except OSError:
+        pass
+    with open(path_out, 'w', encoding='utf-8') as f:
+        f.write(text)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='编译本地意图注册表')
+    parser.add_argument('registry', help='意图注册表 (ai_intents.txt)')
+    parser.add_argument('output', help='生成的头文件 (ai_intent_table.h)')
+    args = parser.parse_args()
+    generate(args.registry, args.output)
+
+
+if __name__ == '__main__':
+    main()
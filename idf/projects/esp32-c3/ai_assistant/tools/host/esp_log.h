@@ -0,0 +1,7 @@
+// 主机测试用的 ESP-IDF 替身：日志不输出
+#pragma once
+
+#define ESP_LOGE(tag, ...)  ((void)(tag))
+#define ESP_LOGW(tag, ...)  ((void)(tag))
+#define ESP_LOGI(tag, ...)  ((void)(tag))
+#define ESP_LOGD(tag, ...)  ((void)(tag))
@@ -0,0 +1,20 @@
+// 主机测试用的 FreeRTOS 替身：只提供被测模块用到的类型和临界区宏 (单线程，临界区为空)
+#pragma once
+
+#include <stdint.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE                          1
+#define pdFALSE                         0
+#define portMAX_DELAY                   0xFFFFFFFFu
+
+typedef struct {
+    int unused;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED    { 0 }
+#define portENTER_CRITICAL(mux)         ((void)(mux))
+#define portEXIT_CRITICAL(mux)          ((void)(mux))
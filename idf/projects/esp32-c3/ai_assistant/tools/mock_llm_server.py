@@ -0,0 +1,360 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+本地大模型后端模拟服务 (Linux)
+
+实现 OpenAI Chat Completions 兼容的流式接口 (POST /v1/chat/completions, stream=true)：
+- HTTP/1.1 保持连接，响应为 chunked 编码的 server-sent events，每个 token 一个事件，以 [DONE] 结束
+- 可设置首 token 延迟和 token 间隔，模拟模型生成速度
+- 可选 TLS (--cert/--key)，用于观察设备端连接复用和 TLS 会话复用的效果
+- 可为新建的连接附加握手延迟 (--handshake-ms)，在本机上模拟广域网往返
+- 每个请求输出所在连接的序号和该连接上的请求数 (设备端连接被复用时请求数递增)
+
+bench 子命令作为客户端测量首 token 时间 (TTFT)，对比复用连接和每次新建连接。
+
+另有流式语音合成接口 (POST /v1/audio/speech)：按输入文字每个字生成一段音调，
+以 16kHz 16 位单声道 PCM 分块返回，可设置首块延迟、发送速度和中途停顿，
+用来观察设备端的首音时间、缓冲取空 (断音) 和打断。设备端在 menuconfig 中把
+"AI Assistant TTS Backend -> Speech synthesis URL" 设为 http://<电脑IP>:8000/v1/audio/speech。
+
+语音识别接口 (POST /v1/audio/transcriptions)：检查 multipart 表单中的 WAV 文件，
+延迟 --asr-ms 后返回 {"text": --asr-text}，用来观察设备端的语音段上传和整条语音链路。
+设备端把 "AI Assistant ASR Backend -> Speech recognition URL" 设为
+http://<电脑IP>:8000/v1/audio/transcriptions。
+
+设备端在 menuconfig 中把 "AI Assistant LLM Backend -> Chat completions URL"
+设为 http://<电脑IP>:8000/v1/chat/completions (TLS 时为 https)。
+
+用法:
+    python3 tools/mock_llm_server.py serve
+    python3 tools/mock_llm_server.py serve --first-token-ms 400 --token-ms 40
+    python3 tools/mock_llm_server.py serve --cert cert.pem --key key.pem --port 8443
+    python3 tools/mock_llm_server.py serve --tts-first-ms 300 --tts-stall-ms 400
+    python3 tools/mock_llm_server.py serve --asr-text '帮我开灯' --asr-ms 500
+    python3 tools/mock_llm_server.py bench --url http://127.0.0.1:8000/v1/chat/completions -n 20
+"""
+
+import argparse
+import http.client
+import itertools
+import json
+import math
+import re
+import ssl
+import statistics
+import struct
+import sys
+import threading
+import time
+import urllib.parse
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+REPLY = ('你好，我是模拟的大模型服务。这段回复按 token 逐个发送，'
+         '用来测量设备从发出请求到收到第一个 token 的时间，以及连接复用的效果。')
+
+connection_ids = itertools.count(1)
+log_lock = threading.Lock()
+
+
+def log(msg):
+    with log_lock:
+        print(time.strftime('%H:%M:%S'), msg, flush=True)
+
+
+TTS_SAMPLE_RATE = 16000
+TTS_CHAR_MS = 180       # 每个字的时长
+
+
+def synthesize(text):
+    """每个字一段带包络的音调 (音高由字符决定)，返回 16 位单声道 PCM"""
+    samples = []
+    n = TTS_SAMPLE_RATE * TTS_CHAR_MS // 1000
+    for ch in text:
+        if ch.isspace() or ch in '，。,.!?！？':
+            samples.extend([0] * (n // 2))
+            continue
+        freq = 180 + (ord(ch) % 24) * 15
+        for i in range(n):
+            env = math.sin(math.pi * i / n)
+            samples.append(int(8000 * env * math.sin(2 * math.pi * freq * i / TTS_SAMPLE_RATE)))
+    return struct.pack(f'<{len(samples)}h', *samples)
+
+
+def split_tokens(text, size):
+    """按字符切分为 token (中文一个字符约为一个 token)"""
+    return [text[i:i + size] for i in range(0, len(text), size)]
+
+
+class MockHandler(BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'   # 默认保持连接
+
+    def setup(self):
+        super().setup()
+        self.conn_id = next(connection_ids)
+        self.conn_requests = 0
+        log(f'连接 #{self.conn_id} 建立: {self.client_address[0]}:{self.client_address[1]}')
+        # 模拟广域网上新建连接的握手耗时 (TCP + TLS 约 2~3 个往返)，复用的连接没有这部分
+        time.sleep(self.server.opts.handshake_ms / 1000)
+
+    def finish(self):
+        super().finish()
+        log(f'连接 #{self.conn_id} 关闭 (共 {self.conn_requests} 个请求)')
+
+    def log_message(self, fmt, *args):
+        pass
+
+    def send_chunk(self, data):
+        self.wfile.write(f'{len(data):x}\r\n'.encode() + data + b'\r\n')
+        self.wfile.flush()
+
+    def send_event(self, payload):
+        self.send_chunk(f'data: {payload}\n\n'.encode('utf-8'))
+
+    def do_POST(self):
+        opts = self.server.opts
+        self.conn_requests += 1
+        length = int(self.headers.get('Content-Length', 0))
+        raw = self.rfile.read(length)
+        if opts.api_key and self.headers.get('Authorization') != f'Bearer {opts.api_key}':
+            self.send_error(401, 'Unauthorized')
+            return
+        if self.path.startswith('/v1/audio/transcriptions'):
+            self.serve_transcription(raw)
+            return
+        try:
+            body = json.loads(raw or b'{}')
+        except json.JSONDecodeError:
+            self.send_error(400, 'Invalid JSON')
+            return
+
+        if self.path.startswith('/v1/audio/speech'):
+            self.serve_speech(body)
+            return
+
+        messages = body.get('messages') or [{}]
+        query = messages[-1].get('content', '')
+        tokens = split_tokens(REPLY, opts.token_chars)
+        max_tokens = int(body.get('max_tokens') or len(tokens))
+        tokens = tokens[:max_tokens]
+        log(f'连接 #{self.conn_id} 第 {self.conn_requests} 个请求: {query[:40]!r} '
+            f'(stream={body.get("stream")}, {len(messages)} 条消息, 请求 {length} 字节, {len(tokens)} 个 token)')
+
+        self.send_response(200)
+        self.send_header('Content-Type', 'text/event-stream')
+        self.send_header('Cache-Control', 'no-cache')
+        self.send_header('Transfer-Encoding', 'chunked')
+        self.end_headers()
+
+        time.sleep(opts.first_token_ms / 1000)
+        try:
+            for i, token in enumerate(tokens):
+                if i:
+                    time.sleep(opts.token_ms / 1000)
+                chunk = {
+                    'id': 'chatcmpl-mock',
+                    'object': 'chat.completion.chunk',
+                    'model': body.get('model', 'mock'),
+                    'choices': [{'index': 0, 'delta': {'content': token}, 'finish_reason': None}],
+                }
+                self.send_event(json.dumps(chunk, ensure_ascii=False))
+            self.send_event('[DONE]')
+            self.send_chunk(b'')
+        except (BrokenPipeError, ConnectionResetError):
+            log(f'连接 #{self.conn_id}: 客户端提前断开 (请求已取消)')
+            self.close_connection = True
+
+    def serve_speech(self, body):
+        opts = self.server.opts
+        text = str(body.get('input', ''))
+        if body.get('sample_rate', TTS_SAMPLE_RATE) != TTS_SAMPLE_RATE:
+            self.send_error(400, 'Only 16000 Hz is supported')
+            return
+        pcm = synthesize(text)
+        duration_ms = len(pcm) // 32
+        log(f'连接 #{self.conn_id} 第 {self.conn_requests} 个请求: 合成 {text[:40]!r} '
+            f'({duration_ms} ms 音频, 语音 {body.get("voice")!r})')
+
+        self.send_response(200)
+        self.send_header('Content-Type', 'audio/pcm')
+        self.send_header('Transfer-Encoding', 'chunked')
+        self.end_headers()
+
+        # 按设定的倍速发送 (1.0 为实时)，首块之前模拟合成延迟，发送到一半时可以停顿一次
+        chunk_bytes = opts.tts_chunk_ms * 32
+        interval = opts.tts_chunk_ms / 1000 / opts.tts_speed
+        stall_at = len(pcm) // 2 if opts.tts_stall_ms > 0 else -1
+        time.sleep(opts.tts_first_ms / 1000)
+        try:
+            for pos in range(0, len(pcm), chunk_bytes):
+                if pos:
+                    time.sleep(interval)
+                if stall_at >= 0 and pos >= stall_at:
+                    stall_at = -1
+                    time.sleep(opts.tts_stall_ms / 1000)
+                self.send_chunk(pcm[pos:pos + chunk_bytes])
+            self.send_chunk(b'')
+        except (BrokenPipeError, ConnectionResetError):
+            log(f'连接 #{self.conn_id}: 客户端提前断开 (播放被打断)')
+            self.close_connection = True
+
+
+    def serve_transcription(self, raw):
+        opts = self.server.opts
+        ctype = self.headers.get('Content-Type', '')
+        if 'boundary=' not in ctype:
+            self.send_error(400, 'Expected multipart/form-data')
+            return
+        boundary = b'--' + ctype.split('boundary=', 1)[1].strip('"').encode()
+        fields, wav = {}, b''
+        for part in raw.split(boundary):
+            head, _, data = part.partition(b'\r\n\r\n')
+            m = re.search(rb'name="([^"]+)"', head)
+            if m is None:
+                continue
+            data = data[:-2] if data.endswith(b'\r\n') else data
+            if m.group(1) == b'file':
+                wav = data
+            else:
+                fields[m.group(1).decode()] = data.decode('utf-8', 'replace')
+        if len(wav) < 44 or wav[:4] != b'RIFF' or wav[8:12] != b'WAVE':
+            self.send_error(400, 'Expected a WAV file')
+            return
+        channels, rate = struct.unpack('<HI', wav[22:28])
+        duration_ms = (len(wav) - 44) * 1000 // max(rate * 2 * channels, 1)
+        log(f'连接 #{self.conn_id} 第 {self.conn_requests} 个请求: 识别 {duration_ms} ms 音频 '
+            f'({rate} Hz {channels} 声道, 模型 {fields.get("model")!r}, 语言 {fields.get("language")!r})')
+
+        time.sleep(opts.asr_ms / 1000)
+        reply = json.dumps({'text': opts.asr_text}, ensure_ascii=False).encode('utf-8')
+        self.send_response(200)
+        self.send_header('Content-Type', 'application/json')
+        self.send_header('Content-Length', str(len(reply)))
+        self.end_headers()
+        self.wfile.write(reply)
+
+
+def serve(args):
+    server = ThreadingHTTPServer((args.host, args.port), MockHandler)
+    server.opts = args
+    scheme = 'http'
+    if args.cert:
+        ctx = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        ctx.load_cert_chain(args.cert, args.key)
+        server.socket = ctx.wrap_socket(server.socket, server_side=True)
+        scheme = 'https'
+    log(f'模拟服务: {scheme}://{args.host}:{args.port}/v1/chat/completions '
+        f'(首 token {args.first_token_ms} ms, 间隔 {args.token_ms} ms)')
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+def open_connection(url, tls_ctx, timeout):
+    if url.scheme == 'https':
+        return http.client.HTTPSConnection(url.hostname, url.port or 443, timeout=timeout, context=tls_ctx)
+    return http.client.HTTPConnection(url.hostname, url.port or 80, timeout=timeout)
+
+
+def request_once(conn, path, body, headers):
+    """发出一次流式请求，返回 (首 token 秒数, 总秒数, token 数)"""
+    start = time.perf_counter()
+    conn.request('POST', path, body=body, headers=headers)
+    resp = conn.getresponse()
+    if resp.status != 200:
+        raise RuntimeError(f'HTTP {resp.status}')
+    ttft = None
+    tokens = 0
+    while True:
+        line = resp.readline()
+        if not line:
+            break
+        line = line.strip()
+        if not line.startswith(b'data:'):
+            continue
+        data = line[5:].strip()
+        if data == b'[DONE]':
+            break
+        delta = json.loads(data)['choices'][0]['delta']
+        if delta.get('content'):
+            tokens += 1
+            if ttft is None:
+                ttft = time.perf_counter() - start
+    resp.read()     # 读完结束块，连接才能复用
+    return ttft or 0.0, time.perf_counter() - start, tokens
+
+
+def bench(args):
+    url = urllib.parse.urlsplit(args.url)
+    tls_ctx = ssl.create_default_context()
+    if args.insecure:
+        tls_ctx.check_hostname = False
+        tls_ctx.verify_mode = ssl.CERT_NONE
+    body = json.dumps({
+        'model': 'mock',
+        'stream': True,
+        'max_tokens': args.max_tokens,
+        'messages': [{'role': 'user', 'content': '测试'}],
+    }).encode('utf-8')
+    headers = {'Content-Type': 'application/json', 'Accept': 'text/event-stream'}
+    if args.api_key:
+        headers['Authorization'] = f'Bearer {args.api_key}'
+
+    for mode in ('keep-alive', 'new-connection'):
+        ttfts, totals = [], []
+        conn = None
+        for _ in range(args.n):
+            if conn is None or mode == 'new-connection':
+                if conn is not None:
+                    conn.close()
+                conn = open_connection(url, tls_ctx, args.timeout)
+            ttft, total, tokens = request_once(conn, url.path or '/', body, headers)
+            ttfts.append(ttft * 1000)
+            totals.append(total * 1000)
+        conn.close()
+        ttfts.sort()
+        print(f'{mode:15s} TTFT 中位数 {statistics.median(ttfts):7.1f} ms  '
+              f'p90 {ttfts[min(len(ttfts) - 1, int(len(ttfts) * 0.9))]:7.1f} ms  '
+              f'总计中位数 {statistics.median(totals):7.1f} ms  ({tokens} 个 token, {args.n} 次)')
+
+
+def main():
+    parser = argparse.ArgumentParser(description='本地大模型后端模拟服务')
+    sub = parser.add_subparsers(dest='command', required=True)
+
+    p = sub.add_parser('serve', help='运行模拟服务')
+    p.add_argument('--host', default='0.0.0.0', help='监听地址')
+    p.add_argument('--port', type=int, default=8000, help='监听端口')
+    p.add_argument('--first-token-ms', type=float, default=300, help='首 token 延迟 (模拟模型处理提示词)')
+    p.add_argument('--token-ms', type=float, default=30, help='token 间隔')
+    p.add_argument('--handshake-ms', type=float, default=0, help='新建连接的额外延迟 (模拟握手往返)')
+    p.add_argument('--token-chars', type=int, default=2, help='每个 token 的字符数')
+    p.add_argument('--api-key', default='', help='要求的 Bearer 令牌 (为空时不检查)')
+    p.add_argument('--tts-first-ms', type=float, default=200, help='语音合成首块延迟')
+    p.add_argument('--tts-chunk-ms', type=int, default=100, help='语音合成每块的音频时长')
+    p.add_argument('--tts-speed', type=float, default=2.0, help='语音合成发送速度 (相对实时)')
+    p.add_argument('--tts-stall-ms', type=float, default=0, help='语音合成发送到一半时停顿 (制造缓冲取空)')
+    p.add_argument('--asr-text', default='现在几点了', help='语音识别返回的文字')
+    p.add_argument('--asr-ms', type=float, default=300, help='语音识别延迟')
+    p.add_argument('--cert', help='TLS 证书 (PEM)')
+    p.add_argument('--key', help='TLS 私钥 (PEM)')
+
+    b = sub.add_parser('bench', help='测量首 token 时间')
+    b.add_argument('--url', default='http://127.0.0.1:8000/v1/chat/completions', help='接口地址')
+    b.add_argument('-n', type=int, default=10, help='每种模式的请求次数')
+    b.add_argument('--max-tokens', type=int, default=16, help='每次请求的 token 数')
+    b.add_argument('--api-key', default='', help='Bearer 令牌')
+    b.add_argument('--insecure', action='store_true', help='不校验服务器证书 (自签名证书)')
+    b.add_argument('--timeout', type=float, default=30, help='请求超时秒数')
+
+    args = parser.parse_args()
+    if args.command == 'serve':
+        if bool(args.cert) != bool(args.key):
+            sys.exit('--cert 和 --key 需要同时指定')
+        serve(args)
+    else:
+        bench(args)
+
+
+if __name__ == '__main__':
+    main()
@@ -13,6 +13,7 @@
 #include "driver/gpio.h"
 #include "esp_log.h"
 #include "led_strip.h"
+#include "led_color.h"
 #include "sdkconfig.h"
 
 static const char *TAG = "LED_RAINBOW";
@@ -33,45 +34,6 @@ static const char *TAG = "LED_RAINBOW";
 
 static led_strip_handle_t led_strip;
 
-/* Function to convert HSV to RGB */
-static void hsv_to_rgb(int hue, int saturation, int value, uint8_t *red, uint8_t *green, uint8_t *blue)
-{
-    int region, remainder, p, q, t;
-
-    if (saturation == 0) {
-        *red = *green = *blue = value;
-        return;
-    }
-
-    region = hue / 43;
-    remainder = (hue - (region * 43)) * 6;
-
-    p = (value * (255 - saturation)) >> 8;
-    q = (value * (255 - ((saturation * remainder) >> 8))) >> 8;
-    t = (value * (255 - ((saturation * (255 - remainder)) >> 8))) >> 8;
-
-    switch (region) {
-        case 0:
-            *red = value; *green = t; *blue = p;
-            break;
-        case 1:
-            *red = q; *green = value; *blue = p;
-            break;
-        case 2:
-            *red = p; *green = value; *blue = t;
-            break;
-        case 3:
-            *red = p; *green = q; *blue = value;
-            break;
-        case 4:
-            *red = t; *green = p; *blue = value;
-            break;
-        default:
-            *red = value; *green = p; *blue = q;
-            break;
-    }
-}
-
 static void configure_led(void)
 {
     ESP_LOGI(TAG, "Configuring WS2812 RGB LED on GPIO%d", LED_STRIP_BLINK_GPIO);
@@ -98,7 +60,6 @@ void app_main(void)
     int brightness = MIN_BRIGHTNESS;
     int brightness_direction = 1; // 1 for increasing, -1 for decreasing
     int hue = 0;  // Color hue (0-255)
-    uint8_t red, green, blue;
     
     ESP_LOGI(TAG, "Starting LED Rainbow Effect for ESP32-C3-DevKitM-1");
     ESP_LOGI(TAG, "LED will cycle through rainbow colors with brightness changes");
@@ -108,17 +69,17 @@ void app_main(void)
     
     while (1) {
         /* Convert HSV to RGB */
-        hsv_to_rgb(hue, 255, brightness, &red, &green, &blue);
+        led_rgb_t color = led_color_hsv(hue, 255, brightness);
         
         /* Set the LED pixel with current color and brightness */
-        led_strip_set_pixel(led_strip, 0, red, green, blue);
+        led_strip_set_pixel(led_strip, 0, color.r, color.g, color.b);
         led_strip_refresh(led_strip);
         
         /* Log color and brightness info periodically */
         static int log_counter = 0;
         if (log_counter % 50 == 0) {
             ESP_LOGI(TAG, "Hue: %d, Brightness: %d, RGB: (%d,%d,%d)", 
-                     hue, brightness, red, green, blue);
+                     hue, brightness, color.r, color.g, color.b);
         }
         log_counter++;
         
@@ -5,6 +5,7 @@
 
 #include "captive_portal.h"
 #include "light_show.h"
+#include "frame_scheduler.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
 #include "esp_log.h"
@@ -745,11 +746,36 @@ static esp_err_t light_api_handler(httpd_req_t *req) {
         }
     }
     
-    // 返回当前状态
-    char json[128];
-    snprintf(json, sizeof(json), "{\"mode\":%d,\"active\":%s}",
-             light_show_get_mode(),
-             light_show_is_active() ? "true" : "false");
+    // 返回当前状态、帧调度统计和各模式的渲染耗时 (只列出运行过的模式)
+    frame_scheduler_stats_t fs;
+    frame_scheduler_get_stats(&fs);
+    
+    char json[1536];
+    int len = snprintf(json, sizeof(json),
+                       "{\"mode\":%d,\"active\":%s,"
+                       "\"frame\":{\"target_fps\":%lu,\"fps\":%lu.%lu,\"frame_us_p99\":%lu,\"frame_us_max\":%lu,"
+                       "\"frames\":%lu,\"missed\":%lu},\"render\":[",
+                       light_show_get_mode(),
+                       light_show_is_active() ? "true" : "false",
+                       (unsigned long)fs.target_fps, (unsigned long)(fs.fps_x10 / 10), (unsigned long)(fs.fps_x10 % 10),
+                       (unsigned long)fs.frame_us_p99, (unsigned long)fs.frame_us_max,
+                       (unsigned long)fs.frames, (unsigned long)fs.missed);
+    bool first = true;
+    for (int m = LIGHT_SHOW_OFF + 1; m < LIGHT_SHOW_MAX && len < (int)sizeof(json); m++) {
+        light_show_render_stats_t rs;
+        light_show_get_render_stats((light_show_mode_t)m, &rs);
+        if (rs.frames == 0) {
+            continue;
+        }
+        len += snprintf(json + len, sizeof(json) - len,
+                        "%s{\"mode\":%d,\"frames\":%lu,\"render_us_avg\":%lu,\"render_us_max\":%lu,\"refresh_us_avg\":%lu}",
+                        first ? "" : ",", m, (unsigned long)rs.frames, (unsigned long)rs.render_us_avg,
+                        (unsigned long)rs.render_us_max, (unsigned long)rs.refresh_us_avg);
+        first = false;
+    }
+    if (len < (int)sizeof(json)) {
+        snprintf(json + len, sizeof(json) - len, "]}");
+    }
     
     httpd_resp_set_type(req, "application/json");
     httpd_resp_send(req, json, HTTPD_RESP_USE_STRLEN);
@@ -8,8 +8,9 @@
 #include <math.h>
 
 static const char *TAG = "clock_display";
-static int animation_brightness = 0;
-static int animation_direction = 5;
+
+// 连接中动画：亮度 0→255→0 的周期 (毫秒)
+#define CONNECTING_PERIOD_MS    5100
 
 esp_err_t clock_display_init(void)
 {
@@ -79,16 +80,14 @@ esp_err_t clock_display_update(int hours, int minutes, int seconds)
     return ESP_OK;
 }
 
-esp_err_t clock_display_connecting_animation(void)
+esp_err_t clock_display_connecting_animation(uint32_t time_ms)
 {
     esp_err_t ret;
 
-    // Update brightness
-    animation_brightness += animation_direction;
-    if (animation_brightness <= 0 || animation_brightness >= 255) {
-        animation_direction = -animation_direction;
-        animation_brightness += animation_direction; // Correct overshoot
-    }
+    // Brightness follows a triangle wave over time
+    uint32_t phase = time_ms % CONNECTING_PERIOD_MS;
+    uint32_t half = CONNECTING_PERIOD_MS / 2;
+    uint32_t animation_brightness = (phase < half ? phase : CONNECTING_PERIOD_MS - phase) * 255 / half;
 
     // Clear all LEDs
     ret = neopixel_clear();
@@ -0,0 +1,153 @@
+/**
+ * @file frame_scheduler.c
+ * @brief Fixed-rate frame scheduler implementation
+ */
+
+#include "frame_scheduler.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <string.h>
+
+static const char *TAG = "frame_sched";
+
+// 帧耗时直方图：100us 一格，共 20ms，最后一格收纳更长的帧
+#define FRAME_HIST_BIN_US       100
+#define FRAME_HIST_BINS         200
+
+// 每 5 秒计算一次帧率和 p99
+#define FRAME_STATS_WINDOW_US   5000000
+
+static TickType_t s_period_ticks = 1;
+static TickType_t s_last_wake = 0;
+static int64_t s_frame_start_us = 0;    // 本帧开始时间
+static uint32_t s_last_frame_ms = 0;    // 上一帧开始时间 (毫秒，用于计算经过的时间)
+
+// 当前统计窗口
+static uint16_t s_hist[FRAME_HIST_BINS + 1];
+static uint32_t s_win_frames = 0;
+static uint32_t s_win_max_us = 0;
+static int64_t s_win_start_us = 0;
+
+// 累计
+static uint32_t s_frames = 0;
+static uint32_t s_missed = 0;
+
+// 对外的统计 (HTTP 任务读取)
+static portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static frame_scheduler_stats_t s_stats;
+
+esp_err_t frame_scheduler_init(uint32_t fps)
+{
+    if (fps == 0 || fps > 1000) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    s_period_ticks = pdMS_TO_TICKS(1000 / fps);
+    if (s_period_ticks == 0) {
+        s_period_ticks = 1;
+    }
+    s_last_wake = xTaskGetTickCount();
+
+    int64_t now = esp_timer_get_time();
+    s_frame_start_us = now;
+    s_last_frame_ms = (uint32_t)(now / 1000);
+    s_win_start_us = now;
+    s_win_frames = 0;
+    s_win_max_us = 0;
+    memset(s_hist, 0, sizeof(s_hist));
+
+    s_frames = 0;
+    s_missed = 0;
+    portENTER_CRITICAL(&s_stats_lock);
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_stats.target_fps = fps;
+    portEXIT_CRITICAL(&s_stats_lock);
+
+    ESP_LOGI(TAG, "Frame scheduler: %lu fps (%lu ticks per frame)",
+             (unsigned long)fps, (unsigned long)s_period_ticks);
+    return ESP_OK;
+}
+
+uint32_t frame_scheduler_wait(void)
+{
+    if (xTaskDelayUntil(&s_last_wake, s_period_ticks) == pdFALSE) {
+        // 截止时间已过：不连续补帧，从现在重新对齐
+        TickType_t now = xTaskGetTickCount();
+        if (now != s_last_wake) {
+            s_missed++;
+        }
+        s_last_wake = now;
+    }
+
+    // 毫秒取整后再相减，误差不会随帧数累积
+    s_frame_start_us = esp_timer_get_time();
+    uint32_t now_ms = (uint32_t)(s_frame_start_us / 1000);
+    uint32_t elapsed_ms = now_ms - s_last_frame_ms;
+    s_last_frame_ms = now_ms;
+    return elapsed_ms;
+}
+
+// 统计窗口结束：计算帧率和 p99，开始下一个窗口
+static void publish_window(int64_t now)
+{
+    uint32_t window_us = (uint32_t)(now - s_win_start_us);
+
+    // p99：从小到大累计到 99% 的帧所在的格子，取格子上界 (不超过最大值)
+    uint32_t p99_us = s_win_max_us;
+    uint32_t rank = s_win_frames - s_win_frames / 100;
+    uint32_t count = 0;
+    for (int i = 0; i < FRAME_HIST_BINS; i++) {
+        count += s_hist[i];
+        if (count >= rank) {
+            uint32_t upper = (uint32_t)(i + 1) * FRAME_HIST_BIN_US;
+            p99_us = upper < s_win_max_us ? upper : s_win_max_us;
+            break;
+        }
+    }
+
+    portENTER_CRITICAL(&s_stats_lock);
+    s_stats.fps_x10 = (uint32_t)((uint64_t)s_win_frames * 10000000 / window_us);
+    s_stats.frame_us_p99 = p99_us;
+    s_stats.frame_us_max = s_win_max_us;
+    s_stats.frames = s_frames;
+    s_stats.missed = s_missed;
+    portEXIT_CRITICAL(&s_stats_lock);
+
+    s_win_start_us = now;
+    s_win_frames = 0;
+    s_win_max_us = 0;
+    memset(s_hist, 0, sizeof(s_hist));
+}
+
+void frame_scheduler_frame_done(void)
+{
+    int64_t now = esp_timer_get_time();
+    uint32_t frame_us = (uint32_t)(now - s_frame_start_us);
+
+    uint32_t bin = frame_us / FRAME_HIST_BIN_US;
+    if (bin > FRAME_HIST_BINS) {
+        bin = FRAME_HIST_BINS;
+    }
+    s_hist[bin]++;
+    s_win_frames++;
+    if (frame_us > s_win_max_us) {
+        s_win_max_us = frame_us;
+    }
+    s_frames++;
+
+    if (now - s_win_start_us >= FRAME_STATS_WINDOW_US) {
+        publish_window(now);
+    }
+}
+
+void frame_scheduler_get_stats(frame_scheduler_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    portENTER_CRITICAL(&s_stats_lock);
+    *stats = s_stats;
+    portEXIT_CRITICAL(&s_stats_lock);
+}
@@ -49,9 +49,10 @@ esp_err_t clock_display_update(int hours, int minutes, int seconds);
 /**
  * @brief Show connecting animation (pulsing blue)
  * 
+ * @param time_ms Animation time in milliseconds (the pulse is computed from it)
  * @return ESP_OK on success
  */
-esp_err_t clock_display_connecting_animation(void);
+esp_err_t clock_display_connecting_animation(uint32_t time_ms);
 
 /**
  * @brief Show error state (red at 6 o'clock)
@@ -0,0 +1,53 @@
+/**
+ * @file frame_scheduler.h
+ * @brief Fixed-rate frame scheduler for the LED ring
+ */
+
+#ifndef FRAME_SCHEDULER_H
+#define FRAME_SCHEDULER_H
+
+#include "esp_err.h"
+#include <stdint.h>
+
+// 目标帧率 (FreeRTOS tick 为 1kHz 时每帧 20ms)
+#define FRAME_SCHEDULER_FPS     50
+
+// 帧调度统计
+typedef struct {
+    uint32_t target_fps;
+    uint32_t fps_x10;           // 最近一个统计窗口 (5 秒) 的实际帧率 ×10
+    uint32_t frame_us_p99;      // 最近一个统计窗口每帧耗时 (渲染 + 刷新) 的 p99
+    uint32_t frame_us_max;      // 最近一个统计窗口每帧耗时的最大值
+    uint32_t frames;            // 累计帧数
+    uint32_t missed;            // 累计错过截止时间的次数 (上一帧超时，本帧没有按时开始)
+} frame_scheduler_stats_t;
+
+/**
+ * @brief 初始化帧调度，从调用时刻开始按固定周期计时
+ * @param fps 目标帧率
+ */
+esp_err_t frame_scheduler_init(uint32_t fps);
+
+/**
+ * @brief 等到下一帧的开始时间 (在渲染任务中调用)
+ *
+ * 按固定周期唤醒 (vTaskDelayUntil)，渲染耗时不会累加到周期上。
+ * 已经错过截止时间时不补帧，从当前时刻重新对齐并计入 missed。
+ *
+ * @return 距离上一帧开始经过的时间 (毫秒)，用于按时间推进动画
+ */
+uint32_t frame_scheduler_wait(void);
+
+/**
+ * @brief 本帧渲染和刷新完成，记录帧耗时
+ *
+ * 跳过的帧 (例如正在播放开机动画) 不调用，不计入统计
+ */
+void frame_scheduler_frame_done(void);
+
+/**
+ * @brief 获取帧调度统计
+ */
+void frame_scheduler_get_stats(frame_scheduler_stats_t *stats);
+
+#endif // FRAME_SCHEDULER_H
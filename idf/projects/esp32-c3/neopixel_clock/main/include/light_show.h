@@ -7,6 +7,7 @@
 #define LIGHT_SHOW_H
 
 #include "esp_err.h"
+#include "led_color.h"
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -28,12 +29,8 @@ typedef enum {
     LIGHT_SHOW_MAX
 } light_show_mode_t;
 
-// 自定义颜色结构
-typedef struct {
-    uint8_t r;
-    uint8_t g;
-    uint8_t b;
-} custom_color_t;
+// 自定义颜色结构 (r, g, b)
+typedef led_rgb_t custom_color_t;
 
 // 自定义模式参数
 typedef struct {
@@ -47,6 +44,14 @@ typedef struct {
     uint8_t direction;          // 方向 (0=顺时针, 1=逆时针, 2=双向扩散, 3=双向收缩)
 } custom_params_t;
 
+// 渲染耗时统计 (单个模式)
+typedef struct {
+    uint32_t frames;            // 已渲染的帧数
+    uint32_t render_us_avg;     // 效果写入帧缓冲区的平均耗时
+    uint32_t render_us_max;
+    uint32_t refresh_us_avg;    // 帧缓冲区编码并启动发送的平均耗时
+} light_show_render_stats_t;
+
 /**
  * @brief 初始化灯光秀模块
  */
@@ -74,16 +79,25 @@ void light_show_set_custom_params(const custom_params_t *params);
 void light_show_get_custom_params(custom_params_t *params);
 
 /**
- * @brief 灯光秀更新（在主循环中调用）
+ * @brief 灯光秀更新（每帧调用一次）
+ *
+ * 动画按经过的时间推进，快慢与调用频率无关
+ *
+ * @param elapsed_ms 距离上一帧的时间 (毫秒)
  * @return true 如果灯光秀正在运行，false 如果应该显示时钟
  */
-bool light_show_update(void);
+bool light_show_update(uint32_t elapsed_ms);
 
 /**
  * @brief 检查灯光秀是否激活
  */
 bool light_show_is_active(void);
 
+/**
+ * @brief 获取某个模式的渲染耗时统计
+ */
+void light_show_get_render_stats(light_show_mode_t mode, light_show_render_stats_t *stats);
+
 /**
  * @brief 获取模式名称
  */
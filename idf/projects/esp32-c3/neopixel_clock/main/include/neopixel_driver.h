@@ -8,18 +8,16 @@
 
 #include <stdint.h>
 #include "esp_err.h"
+#include "led_color.h"
 
 // LED configuration
 #define LED_STRIP_GPIO      10      // GPIO pin for LED data
 #define LED_STRIP_NUM_LEDS  60      // Number of LEDs in the strip
 #define LED_STRIP_RMT_RES_HZ (10 * 1000 * 1000)  // 10MHz resolution
 
-// Color structure
-typedef struct {
-    uint8_t r;
-    uint8_t g;
-    uint8_t b;
-} rgb_color_t;
+// Color structure (same layout as the shared led_color type, so effects
+// can use the led_color helpers on frame buffer pixels directly)
+typedef led_rgb_t rgb_color_t;
 
 /**
  * @brief Initialize the NeoPixel LED strip
@@ -28,6 +26,16 @@ typedef struct {
  */
 esp_err_t neopixel_init(void);
 
+/**
+ * @brief Get the frame buffer (LED_STRIP_NUM_LEDS pixels in RGB order)
+ *
+ * Effects render into this buffer directly; neopixel_refresh() encodes
+ * the whole frame in one pass and sends it.
+ *
+ * @return Pointer to the frame buffer (valid before neopixel_init)
+ */
+rgb_color_t *neopixel_get_framebuffer(void);
+
 /**
  * @brief Set a single LED color
  * 
@@ -47,7 +55,7 @@ esp_err_t neopixel_set_pixel(uint32_t index, rgb_color_t color);
 esp_err_t neopixel_get_pixel(uint32_t index, rgb_color_t *color);
 
 /**
- * @brief Clear all LEDs (set to black)
+ * @brief Clear all LEDs (set to black), takes effect on the next refresh
  * 
  * @return ESP_OK on success
  */
@@ -55,6 +63,9 @@ esp_err_t neopixel_clear(void);
 
 /**
  * @brief Refresh the LED strip to show the current buffer
+ *
+ * Encodes the frame buffer to GRB and starts the RMT transfer. The
+ * transfer runs in the background; the next refresh waits for it.
  * 
  * @return ESP_OK on success
  */
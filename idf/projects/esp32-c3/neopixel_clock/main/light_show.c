@@ -7,8 +7,8 @@
 #include "neopixel_driver.h"
 #include "esp_log.h"
 #include "esp_random.h"
+#include "esp_timer.h"
 #include <string.h>
-#include <math.h>
 
 static const char *TAG = "light_show";
 
@@ -25,36 +25,85 @@ static custom_params_t s_custom_params = {
     .direction = 0
 };
 
-// 动画状态
-static uint32_t s_frame = 0;
+// 动画时钟 (毫秒)：按每帧经过的时间推进，自定义模式再乘以速度。
+// 效果都由动画时间计算，动画快慢与帧率无关
+static uint32_t s_time_ms = 0;
+static uint32_t s_prev_time_ms = 0;     // 上一帧的动画时间
+static uint32_t s_speed_acc = 0;        // 速度换算的余数
+static uint32_t s_fade_acc = 0;         // 渐暗量的余数
 
-// HSV to RGB
-static rgb_color_t hsv_to_rgb(int hue, int sat, int val)
+// 效果原先按每帧 50ms 设计，逐格移动的效果 (流水、流星等) 仍按这个步长前进
+#define LIGHT_SHOW_STEP_MS  50
+
+// 帧缓冲区 (驱动提供)，效果直接写入，每帧刷新时一次性编码发送
+static rgb_color_t *s_fb = NULL;
+
+// 每个模式的渲染耗时统计
+typedef struct {
+    uint32_t frames;
+    uint64_t render_us_total;
+    uint32_t render_us_max;
+    uint64_t refresh_us_total;
+} render_stats_t;
+
+static render_stats_t s_render_stats[LIGHT_SHOW_MAX];
+
+// 整条灯带填充同一颜色
+static void fb_fill(rgb_color_t color)
 {
-    hue = hue % 360;
-    int h = hue / 60;
-    int f = (hue % 60) * 255 / 60;
-    int p = val * (255 - sat) / 255;
-    int q = val * (255 - (sat * f / 255)) / 255;
-    int t = val * (255 - (sat * (255 - f) / 255)) / 255;
-    
-    switch (h) {
-        case 0: return (rgb_color_t){val, t, p};
-        case 1: return (rgb_color_t){q, val, p};
-        case 2: return (rgb_color_t){p, val, t};
-        case 3: return (rgb_color_t){p, q, val};
-        case 4: return (rgb_color_t){t, p, val};
-        default: return (rgb_color_t){val, p, q};
+    for (int i = 0; i < LED_STRIP_NUM_LEDS; i++) {
+        s_fb[i] = color;
+    }
+}
+
+_Static_assert(sizeof(rgb_color_t) == 3, "framebuffer is packed RGB");
+
+// 所有像素每个通道减去 amount (不低于 0)，用于拖尾和闪烁的渐暗
+static void fb_fade(uint8_t amount)
+{
+    uint8_t *p = (uint8_t *)s_fb;
+    for (int i = 0; i < LED_STRIP_NUM_LEDS * 3; i++) {
+        p[i] = p[i] > amount ? p[i] - amount : 0;
+    }
+}
+
+// 按本帧经过的时间渐暗：每 50ms 减去 per_step，帧率越高每帧减得越少 (余数留到下一帧)
+static void fb_fade_elapsed(uint8_t per_step)
+{
+    s_fade_acc += (uint32_t)per_step * (s_time_ms - s_prev_time_ms);
+    uint32_t amount = s_fade_acc / LIGHT_SHOW_STEP_MS;
+    s_fade_acc %= LIGHT_SHOW_STEP_MS;
+    if (amount > 0) {
+        fb_fade(amount > 255 ? 255 : (uint8_t)amount);
     }
 }
 
+// 动画时间在周期内的相位 (16 位一整圈)，period_ms 不超过 65536
+static uint16_t anim_phase16(uint32_t period_ms)
+{
+    return (uint16_t)((s_time_ms % period_ms) * 65536 / period_ms);
+}
+
+// 动画步数 (每 50ms 一步)
+static uint32_t anim_step(void)
+{
+    return s_time_ms / LIGHT_SHOW_STEP_MS;
+}
+
+// 本帧是否跨过了 interval_ms 的整数倍，用于按固定间隔触发的事件 (点亮新的星光等)
+static bool anim_crossed(uint32_t interval_ms)
+{
+    return s_time_ms / interval_ms != s_prev_time_ms / interval_ms;
+}
+
 // 彩虹旋转效果
 static void effect_rainbow(void)
 {
+    // 每颗灯相差 6°，整圈 6 秒转一周
+    uint16_t phase = anim_phase16(6000);
     for (int i = 0; i < 60; i++) {
-        int hue = ((i * 6) + s_frame * 3) % 360;
-        rgb_color_t color = hsv_to_rgb(hue, 255, 150);
-        neopixel_set_pixel(i, color);
+        uint16_t hue = (uint16_t)(i * 65536 / 60 + phase);
+        s_fb[i] = led_color_hsv16(hue, 255, 150);
     }
 }
 
@@ -73,10 +122,9 @@ static void effect_breathing(void)
     static int color_index = 0;
     static int last_direction = 1;
     
-    // 使用正弦波计算亮度
-    float phase = (float)(s_frame % 120) / 120.0f * 3.14159f * 2;
-    float sin_val = sinf(phase);
-    int brightness = (int)((sin_val + 1.0f) * 0.5f * 200);
+    // 使用正弦波计算亮度 (6 秒一个周期)
+    int16_t sin_val = led_color_sin16(anim_phase16(6000));
+    int brightness = (sin_val + 32767) * 200 / 65534;
     
     // 检测呼吸周期切换（从暗到亮的瞬间换颜色）
     int current_direction = sin_val > 0 ? 1 : -1;
@@ -92,9 +140,7 @@ static void effect_breathing(void)
         base.b * brightness / 255
     };
     
-    for (int i = 0; i < 60; i++) {
-        neopixel_set_pixel(i, color);
-    }
+    fb_fill(color);
 }
 
 // 流水追逐效果
@@ -102,7 +148,7 @@ static void effect_chase(void)
 {
     neopixel_clear();
     
-    int head = s_frame % 60;
+    int head = anim_step() % 60;
     for (int i = 0; i < 10; i++) {
         int pos = (head - i + 60) % 60;
         int brightness = 200 - i * 20;
@@ -113,7 +159,7 @@ static void effect_chase(void)
             s_custom_params.color1.g * brightness / 255,
             s_custom_params.color1.b * brightness / 255
         };
-        neopixel_set_pixel(pos, color);
+        s_fb[pos] = color;
     }
 }
 
@@ -121,26 +167,24 @@ static void effect_chase(void)
 static void effect_sparkle(void)
 {
     // 渐暗所有像素
-    for (int i = 0; i < 60; i++) {
-        rgb_color_t color;
-        neopixel_get_pixel(i, &color);
-        color.r = color.r > 10 ? color.r - 10 : 0;
-        color.g = color.g > 10 ? color.g - 10 : 0;
-        color.b = color.b > 10 ? color.b - 10 : 0;
-        neopixel_set_pixel(i, color);
-    }
+    fb_fade_elapsed(10);
     
-    // 随机点亮几个像素
-    if (s_frame % 3 == 0) {
+    // 随机点亮几个像素 (每 150ms 一颗)
+    if (anim_crossed(150)) {
         int pos = esp_random() % 60;
         rgb_color_t white = {200, 200, 200};
-        neopixel_set_pixel(pos, white);
+        s_fb[pos] = white;
     }
 }
 
 // 火焰效果
 static void effect_fire(void)
 {
+    // 每 50ms 换一次火苗，帧率更高时保持上一次的画面
+    if (s_prev_time_ms != 0 && !anim_crossed(LIGHT_SHOW_STEP_MS)) {
+        return;
+    }
+    
     for (int i = 0; i < 60; i++) {
         int flicker = esp_random() % 80;
         int r = 200 + (esp_random() % 55) - flicker;
@@ -153,23 +197,24 @@ static void effect_fire(void)
         if (g > 255) g = 255;
         
         rgb_color_t color = {r, g, b};
-        neopixel_set_pixel(i, color);
+        s_fb[i] = color;
     }
 }
 
 // 海洋波浪效果
 static void effect_ocean(void)
 {
+    uint16_t t = LED_COLOR_RAD16(s_time_ms, 500);
     for (int i = 0; i < 60; i++) {
-        float phase = (float)(i + s_frame) / 10.0f;
-        int brightness = (int)((sinf(phase) + 1.0f) * 0.5f * 150) + 50;
+        int16_t wave = led_color_sin16(LED_COLOR_RAD16(i, 10) + t);
+        int brightness = (wave + 32767) * 150 / 65534 + 50;
         
         rgb_color_t color = {
             0,
             brightness / 3,
             brightness
         };
-        neopixel_set_pixel(i, color);
+        s_fb[i] = color;
     }
 }
 
@@ -177,24 +222,18 @@ static void effect_ocean(void)
 static void effect_meteor(void)
 {
     // 渐暗背景
-    for (int i = 0; i < 60; i++) {
-        rgb_color_t color;
-        neopixel_get_pixel(i, &color);
-        color.r = color.r > 20 ? color.r - 20 : 0;
-        color.g = color.g > 20 ? color.g - 20 : 0;
-        color.b = color.b > 20 ? color.b - 20 : 0;
-        neopixel_set_pixel(i, color);
-    }
+    fb_fade_elapsed(20);
     
     // 多条流星
+    uint32_t step = anim_step();
     for (int m = 0; m < 3; m++) {
-        int head = (s_frame + m * 20) % 60;
+        int head = (step + m * 20) % 60;
         for (int i = 0; i < 8; i++) {
             int pos = (head - i + 60) % 60;
             int brightness = 255 - i * 30;
             if (brightness > 0) {
                 rgb_color_t color = {brightness, brightness, brightness};
-                neopixel_set_pixel(pos, color);
+                s_fb[pos] = color;
             }
         }
     }
@@ -203,8 +242,7 @@ static void effect_meteor(void)
 // 警灯效果
 static void effect_police(void)
 {
-    int phase = (s_frame / 10) % 4;
-    neopixel_clear();
+    int phase = (s_time_ms / 500) % 4;
     
     for (int i = 0; i < 60; i++) {
         rgb_color_t color = {0, 0, 0};
@@ -220,7 +258,7 @@ static void effect_police(void)
                 color = (rgb_color_t){0, 0, phase == 2 ? 255 : 100};
             }
         }
-        neopixel_set_pixel(i, color);
+        s_fb[i] = color;
     }
 }
 
@@ -237,53 +275,58 @@ static void effect_candy(void)
     };
     
     for (int i = 0; i < 60; i++) {
-        int color_idx = ((i + s_frame / 5) / 12) % 5;
+        int color_idx = ((i + s_time_ms / 250) / 12) % 5;
         rgb_color_t color = candy_colors[color_idx];
         // 稍微降低亮度
         color.r = color.r * 3 / 4;
         color.g = color.g * 3 / 4;
         color.b = color.b * 3 / 4;
-        neopixel_set_pixel(i, color);
+        s_fb[i] = color;
     }
 }
 
 // 极光效果
 static void effect_aurora(void)
 {
+    // 三层波形的移动速度不同
+    uint16_t t1 = LED_COLOR_RAD16(s_time_ms, 400);
+    uint16_t t2 = LED_COLOR_RAD16(s_time_ms, 600);
+    uint16_t t3 = LED_COLOR_RAD16(s_time_ms, 375);
     for (int i = 0; i < 60; i++) {
         // 多层波形叠加
-        float wave1 = sinf((float)(i + s_frame) / 8.0f);
-        float wave2 = sinf((float)(i * 2 + s_frame) / 12.0f);
-        float wave3 = sinf((float)(i + s_frame * 2) / 15.0f);
+        int32_t wave1 = led_color_sin16(LED_COLOR_RAD16(i, 8) + t1);
+        int32_t wave2 = led_color_sin16(LED_COLOR_RAD16(i * 2, 12) + t2);
+        int32_t wave3 = led_color_sin16(LED_COLOR_RAD16(i, 15) + t3);
         
-        float combined = (wave1 + wave2 + wave3) / 3.0f;
-        int brightness = (int)((combined + 1.0f) * 0.5f * 180);
+        // 三个波形之和 (-3×32767 到 3×32767) 映射到 0-180
+        int32_t combined = wave1 + wave2 + wave3;
+        int brightness = (combined + 98301) * 180 / 196602;
         
         // 绿色为主，带蓝紫色调
         int g = brightness;
         int b = brightness * 2 / 3;
-        int r = (int)(brightness * fabsf(wave2) / 3);
+        int r = brightness * (wave2 < 0 ? -wave2 : wave2) / (32767 * 3);
         
         rgb_color_t color = {r, g, b};
-        neopixel_set_pixel(i, color);
+        s_fb[i] = color;
     }
 }
 
 // 心跳效果
 static void effect_heartbeat(void)
 {
-    int cycle = s_frame % 100;
+    int cycle = s_time_ms % 5000;  // 5 秒一次
     int brightness = 0;
     
     // 双峰心跳波形
-    if (cycle < 10) {
-        brightness = cycle * 25;  // 快速上升
-    } else if (cycle < 20) {
-        brightness = 250 - (cycle - 10) * 20;  // 快速下降
-    } else if (cycle < 30) {
-        brightness = 50 + (cycle - 20) * 15;  // 第二次上升
-    } else if (cycle < 45) {
-        brightness = 200 - (cycle - 30) * 13;  // 缓慢下降
+    if (cycle < 500) {
+        brightness = cycle / 2;  // 快速上升
+    } else if (cycle < 1000) {
+        brightness = 250 - (cycle - 500) * 2 / 5;  // 快速下降
+    } else if (cycle < 1500) {
+        brightness = 50 + (cycle - 1000) * 3 / 10;  // 第二次上升
+    } else if (cycle < 2250) {
+        brightness = 200 - (cycle - 1500) * 13 / 50;  // 缓慢下降
     } else {
         brightness = 0;  // 休息
     }
@@ -292,34 +335,13 @@ static void effect_heartbeat(void)
     if (brightness > 255) brightness = 255;
     
     rgb_color_t color = {brightness, 0, brightness / 4};
-    for (int i = 0; i < 60; i++) {
-        neopixel_set_pixel(i, color);
-    }
+    fb_fill(color);
 }
 
-// 辅助函数：根据方向计算位置
-static int get_position(int base_pos, int direction) {
-    switch (direction) {
-        case 1: return (60 - base_pos) % 60;  // 逆时针
-        default: return base_pos % 60;         // 顺时针
-    }
-}
-
-// 辅助函数：三色插值
-static rgb_color_t interpolate_3colors(float ratio, custom_color_t c1, custom_color_t c2, custom_color_t c3) {
-    rgb_color_t result;
-    if (ratio < 0.5f) {
-        float r = ratio * 2.0f;
-        result.r = (uint8_t)(c1.r * (1 - r) + c2.r * r);
-        result.g = (uint8_t)(c1.g * (1 - r) + c2.g * r);
-        result.b = (uint8_t)(c1.b * (1 - r) + c2.b * r);
-    } else {
-        float r = (ratio - 0.5f) * 2.0f;
-        result.r = (uint8_t)(c2.r * (1 - r) + c3.r * r);
-        result.g = (uint8_t)(c2.g * (1 - r) + c3.g * r);
-        result.b = (uint8_t)(c2.b * (1 - r) + c3.b * r);
-    }
-    return result;
+// 辅助函数：三色渐变，ratio 为 0-255 (0 为主色，255 为第三色)
+static rgb_color_t interpolate_3colors(uint8_t ratio, custom_color_t c1, custom_color_t c2, custom_color_t c3) {
+    const led_rgb_t colors[3] = {c1, c2, c3};
+    return led_color_palette(colors, 3, ratio, false);
 }
 
 // 自定义效果
@@ -337,22 +359,15 @@ static void effect_custom(void)
                     s_custom_params.color1.g * brightness / 255,
                     s_custom_params.color1.b * brightness / 255
                 };
-                for (int i = 0; i < 60; i++) {
-                    neopixel_set_pixel(i, color);
-                }
+                fb_fill(color);
             }
             break;
             
         case 1: // 双色渐变
             {
                 for (int i = 0; i < 60; i++) {
-                    float ratio = (float)i / 60.0f;
-                    rgb_color_t color = {
-                        (uint8_t)((s_custom_params.color1.r * (1 - ratio) + s_custom_params.color2.r * ratio) * brightness / 255),
-                        (uint8_t)((s_custom_params.color1.g * (1 - ratio) + s_custom_params.color2.g * ratio) * brightness / 255),
-                        (uint8_t)((s_custom_params.color1.b * (1 - ratio) + s_custom_params.color2.b * ratio) * brightness / 255)
-                    };
-                    neopixel_set_pixel(i, color);
+                    rgb_color_t base = led_color_blend(s_custom_params.color1, s_custom_params.color2, i * 255 / 60);
+                    s_fb[i] = led_color_scale(base, brightness);
                 }
             }
             break;
@@ -360,61 +375,50 @@ static void effect_custom(void)
         case 2: // 三色渐变
             {
                 for (int i = 0; i < 60; i++) {
-                    float ratio = (float)i / 60.0f;
-                    rgb_color_t base = interpolate_3colors(ratio, s_custom_params.color1, s_custom_params.color2, s_custom_params.color3);
-                    rgb_color_t color = {
-                        base.r * brightness / 255,
-                        base.g * brightness / 255,
-                        base.b * brightness / 255
-                    };
-                    neopixel_set_pixel(i, color);
+                    rgb_color_t base = interpolate_3colors(i * 255 / 60, s_custom_params.color1, s_custom_params.color2, s_custom_params.color3);
+                    s_fb[i] = led_color_scale(base, brightness);
                 }
             }
             break;
             
         case 3: // 彩虹渐变（旋转）
             {
+                // 3 秒转一周，逆时针时色调反向
+                uint16_t phase = anim_phase16(3000);
                 for (int i = 0; i < 60; i++) {
-                    int pos = get_position(i + s_frame, dir);
-                    int hue = (pos * 6) % 360;
-                    rgb_color_t color = hsv_to_rgb(hue, 255, brightness);
-                    neopixel_set_pixel(i, color);
+                    uint16_t hue = (uint16_t)(i * 65536 / 60 + phase);
+                    if (dir == 1) {
+                        hue = (uint16_t)(0 - hue);
+                    }
+                    s_fb[i] = led_color_hsv16(hue, 255, brightness);
                 }
             }
             break;
             
         case 4: // 呼吸闪烁
             {
-                float phase = (float)(s_frame % 100) / 100.0f * 3.14159f * 2;
-                int breath = (int)((sinf(phase) + 1.0f) * 0.5f * brightness);
+                int16_t wave = led_color_sin16(anim_phase16(5000));
+                int breath = (wave + 32767) * brightness / 65534;
                 rgb_color_t color = {
                     s_custom_params.color1.r * breath / 255,
                     s_custom_params.color1.g * breath / 255,
                     s_custom_params.color1.b * breath / 255
                 };
-                for (int i = 0; i < 60; i++) {
-                    neopixel_set_pixel(i, color);
-                }
+                fb_fill(color);
             }
             break;
             
         case 5: // 双色流水
             {
                 neopixel_clear();
-                int head = s_frame % 60;
+                int head = anim_step() % 60;
                 if (dir == 1) head = 59 - head;
                 
                 for (int i = 0; i < tail; i++) {
                     int pos = (head - i + 60) % 60;
-                    float ratio = (float)i / (float)tail;
                     int fade = brightness * (tail - i) / tail;
-                    
-                    rgb_color_t color = {
-                        (uint8_t)((s_custom_params.color1.r * (1 - ratio) + s_custom_params.color2.r * ratio) * fade / 255),
-                        (uint8_t)((s_custom_params.color1.g * (1 - ratio) + s_custom_params.color2.g * ratio) * fade / 255),
-                        (uint8_t)((s_custom_params.color1.b * (1 - ratio) + s_custom_params.color2.b * ratio) * fade / 255)
-                    };
-                    neopixel_set_pixel(pos, color);
+                    rgb_color_t base = led_color_blend(s_custom_params.color1, s_custom_params.color2, i * 255 / tail);
+                    s_fb[pos] = led_color_scale(base, fade);
                 }
             }
             break;
@@ -422,16 +426,9 @@ static void effect_custom(void)
         case 6: // 彗星拖尾
             {
                 // 渐暗背景
-                for (int i = 0; i < 60; i++) {
-                    rgb_color_t color;
-                    neopixel_get_pixel(i, &color);
-                    color.r = color.r > 15 ? color.r - 15 : 0;
-                    color.g = color.g > 15 ? color.g - 15 : 0;
-                    color.b = color.b > 15 ? color.b - 15 : 0;
-                    neopixel_set_pixel(i, color);
-                }
+                fb_fade_elapsed(15);
                 
-                int head = s_frame % 60;
+                int head = anim_step() % 60;
                 if (dir == 1) head = 59 - head;
                 
                 // 彗星头部
@@ -440,7 +437,7 @@ static void effect_custom(void)
                     s_custom_params.color1.g * brightness / 255,
                     s_custom_params.color1.b * brightness / 255
                 };
-                neopixel_set_pixel(head, head_color);
+                s_fb[head] = head_color;
                 
                 // 尾迹
                 for (int i = 1; i < tail / 2; i++) {
@@ -451,25 +448,22 @@ static void effect_custom(void)
                         s_custom_params.color2.g * fade / 255,
                         s_custom_params.color2.b * fade / 255
                     };
-                    neopixel_set_pixel(pos, color);
+                    s_fb[pos] = color;
                 }
             }
             break;
             
         case 7: // 波浪起伏
             {
+                uint16_t t = LED_COLOR_RAD16(s_time_ms, 500);
                 for (int i = 0; i < 60; i++) {
-                    float phase = (float)(i + s_frame) / 10.0f;
-                    if (dir == 1) phase = (float)(60 - i + s_frame) / 10.0f;
-                    float wave = (sinf(phase) + 1.0f) * 0.5f;
-                    int b = (int)(wave * brightness);
+                    int n = (dir == 1) ? 60 - i : i;
+                    // 波形 0-255：决定亮度和两色之间的比例
+                    uint8_t wave = (led_color_sin16(LED_COLOR_RAD16(n, 10) + t) + 32767) * 255 / 65534;
+                    uint8_t b = led_color_scale8(brightness, wave);
                     
-                    rgb_color_t color = {
-                        (uint8_t)(s_custom_params.color1.r * b / 255 * (1 - wave) + s_custom_params.color2.r * b / 255 * wave),
-                        (uint8_t)(s_custom_params.color1.g * b / 255 * (1 - wave) + s_custom_params.color2.g * b / 255 * wave),
-                        (uint8_t)(s_custom_params.color1.b * b / 255 * (1 - wave) + s_custom_params.color2.b * b / 255 * wave)
-                    };
-                    neopixel_set_pixel(i, color);
+                    rgb_color_t base = led_color_blend(s_custom_params.color1, s_custom_params.color2, wave);
+                    s_fb[i] = led_color_scale(base, b);
                 }
             }
             break;
@@ -477,17 +471,10 @@ static void effect_custom(void)
         case 8: // 随机闪烁
             {
                 // 渐暗
-                for (int i = 0; i < 60; i++) {
-                    rgb_color_t color;
-                    neopixel_get_pixel(i, &color);
-                    color.r = color.r > 8 ? color.r - 8 : 0;
-                    color.g = color.g > 8 ? color.g - 8 : 0;
-                    color.b = color.b > 8 ? color.b - 8 : 0;
-                    neopixel_set_pixel(i, color);
-                }
+                fb_fade_elapsed(8);
                 
-                // 随机点亮
-                if (s_frame % 2 == 0) {
+                // 随机点亮 (每 100ms 一颗)
+                if (anim_crossed(100)) {
                     int pos = esp_random() % 60;
                     int color_choice = esp_random() % 3;
                     custom_color_t *chosen = color_choice == 0 ? &s_custom_params.color1 : 
@@ -497,25 +484,19 @@ static void effect_custom(void)
                         chosen->g * brightness / 255,
                         chosen->b * brightness / 255
                     };
-                    neopixel_set_pixel(pos, color);
+                    s_fb[pos] = color;
                 }
             }
             break;
             
         case 9: // 渐变呼吸
             {
-                float phase = (float)(s_frame % 200) / 200.0f * 3.14159f * 2;
-                int breath = (int)((sinf(phase) + 1.0f) * 0.5f * brightness);
+                int16_t wave = led_color_sin16(anim_phase16(10000));
+                int breath = (wave + 32767) * brightness / 65534;
                 
                 for (int i = 0; i < 60; i++) {
-                    float ratio = (float)i / 60.0f;
-                    rgb_color_t base = interpolate_3colors(ratio, s_custom_params.color1, s_custom_params.color2, s_custom_params.color3);
-                    rgb_color_t color = {
-                        base.r * breath / 255,
-                        base.g * breath / 255,
-                        base.b * breath / 255
-                    };
-                    neopixel_set_pixel(i, color);
+                    rgb_color_t base = interpolate_3colors(i * 255 / 60, s_custom_params.color1, s_custom_params.color2, s_custom_params.color3);
+                    s_fb[i] = led_color_scale(base, breath);
                 }
             }
             break;
@@ -527,6 +508,8 @@ static void effect_custom(void)
 
 esp_err_t light_show_init(void)
 {
+    s_fb = neopixel_get_framebuffer();
+    memset(s_render_stats, 0, sizeof(s_render_stats));
     ESP_LOGI(TAG, "Light show initialized");
     return ESP_OK;
 }
@@ -540,7 +523,10 @@ void light_show_set_mode(light_show_mode_t mode)
     if (s_current_mode != mode) {
         ESP_LOGI(TAG, "Light show mode changed to: %s", light_show_get_mode_name(mode));
         s_current_mode = mode;
-        s_frame = 0;
+        s_time_ms = 0;
+        s_prev_time_ms = 0;
+        s_speed_acc = 0;
+        s_fade_acc = 0;
         
         if (mode == LIGHT_SHOW_OFF) {
             neopixel_clear();
@@ -572,17 +558,26 @@ void light_show_get_custom_params(custom_params_t *params)
     }
 }
 
-bool light_show_update(void)
+bool light_show_update(uint32_t elapsed_ms)
 {
     if (s_current_mode == LIGHT_SHOW_OFF) {
         return false;
     }
     
-    // 根据速度控制更新频率
-    int delay_factor = 11 - s_custom_params.speed; // speed 1-10 -> delay 10-1
-    if (delay_factor < 1) delay_factor = 1;
+    // 推进动画时钟；自定义模式按速度缩放 (speed 1-10，5 为原速)
+    uint32_t dt = elapsed_ms;
+    if (s_current_mode == LIGHT_SHOW_CUSTOM) {
+        uint32_t speed = s_custom_params.speed;
+        if (speed < 1) speed = 1;
+        if (speed > 10) speed = 10;
+        s_speed_acc += elapsed_ms * speed;
+        dt = s_speed_acc / 5;
+        s_speed_acc %= 5;
+    }
+    s_prev_time_ms = s_time_ms;
+    s_time_ms += dt;
     
-    s_frame++;
+    int64_t start = esp_timer_get_time();
     
     switch (s_current_mode) {
         case LIGHT_SHOW_RAINBOW:
@@ -625,10 +620,40 @@ bool light_show_update(void)
             return false;
     }
     
+    int64_t rendered = esp_timer_get_time();
     neopixel_refresh();
+    int64_t refreshed = esp_timer_get_time();
+    
+    render_stats_t *st = &s_render_stats[s_current_mode];
+    uint32_t render_us = (uint32_t)(rendered - start);
+    st->frames++;
+    st->render_us_total += render_us;
+    if (render_us > st->render_us_max) {
+        st->render_us_max = render_us;
+    }
+    st->refresh_us_total += (uint32_t)(refreshed - rendered);
     return true;
 }
 
+void light_show_get_render_stats(light_show_mode_t mode, light_show_render_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    memset(stats, 0, sizeof(*stats));
+    if (mode >= LIGHT_SHOW_MAX) {
+        return;
+    }
+    
+    const render_stats_t *st = &s_render_stats[mode];
+    stats->frames = st->frames;
+    if (st->frames > 0) {
+        stats->render_us_avg = (uint32_t)(st->render_us_total / st->frames);
+        stats->refresh_us_avg = (uint32_t)(st->refresh_us_total / st->frames);
+    }
+    stats->render_us_max = st->render_us_max;
+}
+
 bool light_show_is_active(void)
 {
     return s_current_mode != LIGHT_SHOW_OFF;
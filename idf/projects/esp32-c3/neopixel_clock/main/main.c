@@ -28,6 +28,7 @@
 #include "clock_display.h"
 #include "captive_portal.h"
 #include "light_show.h"
+#include "frame_scheduler.h"
 
 static const char *TAG = "main";
 
@@ -46,29 +47,27 @@ typedef enum {
 static app_state_t s_app_state = APP_STATE_INIT;
 static bool s_time_synced = false;
 static bool s_animation_playing = false;  // 防止 clock_task 干扰动画
+static TickType_t s_anim_wake = 0;        // 开机动画上一帧的开始时间
 
 /**
- * @brief HSV to RGB conversion
+ * @brief 等到距离上一帧开始 ms 毫秒 (而不是渲染完成后再延时 ms)，动画时长不受渲染耗时影响
  */
-static rgb_color_t hsv_to_rgb(int hue, int sat, int val)
+static void animation_wait(uint32_t ms)
 {
-    hue = hue % 360;
-    int h = hue / 60;
-    int f = (hue % 60) * 255 / 60;
-    int p = val * (255 - sat) / 255;
-    int q = val * (255 - (sat * f / 255)) / 255;
-    int t = val * (255 - (sat * (255 - f) / 255)) / 255;
-    
-    switch (h) {
-        case 0: return (rgb_color_t){val, t, p};
-        case 1: return (rgb_color_t){q, val, p};
-        case 2: return (rgb_color_t){p, val, t};
-        case 3: return (rgb_color_t){p, q, val};
-        case 4: return (rgb_color_t){t, p, val};
-        default: return (rgb_color_t){val, p, q};
+    if (xTaskDelayUntil(&s_anim_wake, pdMS_TO_TICKS(ms)) == pdFALSE) {
+        s_anim_wake = xTaskGetTickCount();
     }
 }
 
+/**
+ * @brief 刷新当前帧并保持 ms 毫秒
+ */
+static void animation_show(uint32_t ms)
+{
+    neopixel_refresh();
+    animation_wait(ms);
+}
+
 /**
  * @brief 动画1: 时钟指针归位
  * 模拟时钟指针从12点开始旋转，暗示"时间同步完成"
@@ -89,8 +88,7 @@ static void animation_clock_hands(void)
                 neopixel_set_pixel(p, green);
             }
         }
-        neopixel_refresh();
-        vTaskDelay(pdMS_TO_TICKS(20));
+        animation_show(20);
     }
     
     // 分针(蓝色)转半圈
@@ -105,8 +103,7 @@ static void animation_clock_hands(void)
                 neopixel_set_pixel(p, blue);
             }
         }
-        neopixel_refresh();
-        vTaskDelay(pdMS_TO_TICKS(30));
+        animation_show(30);
     }
     
     // 时针(红色)移动到当前位置
@@ -121,15 +118,13 @@ static void animation_clock_hands(void)
                 neopixel_set_pixel(p, red);
             }
         }
-        neopixel_refresh();
-        vTaskDelay(pdMS_TO_TICKS(60));
+        animation_show(60);
     }
     
     // 最终：三针同时显示并闪烁
     for (int flash = 0; flash < 3; flash++) {
         neopixel_clear();
-        neopixel_refresh();
-        vTaskDelay(pdMS_TO_TICKS(100));
+        animation_show(100);
         
         // 显示12点、3点、6点位置
         rgb_color_t red = {180, 40, 0};
@@ -138,8 +133,7 @@ static void animation_clock_hands(void)
         neopixel_set_pixel(0, red);    // 12点 - 时针
         neopixel_set_pixel(15, blue);  // 3点 - 分针
         neopixel_set_pixel(30, green); // 6点 - 秒针
-        neopixel_refresh();
-        vTaskDelay(pdMS_TO_TICKS(200));
+        animation_show(200);
     }
 }
 
@@ -171,7 +165,7 @@ static void animation_ripple(void)
                     int brightness = 180 - tail * 30;
                     if (brightness <= 0) continue;
                     
-                    rgb_color_t color = hsv_to_rgb(hue, 255, brightness);
+                    rgb_color_t color = led_color_hsv_deg(hue, 255, brightness);
                     
                     // 顺时针
                     int pos_cw = (wave_spread - tail) % 60;
@@ -185,8 +179,7 @@ static void animation_ripple(void)
                 }
             }
             
-            neopixel_refresh();
-            vTaskDelay(pdMS_TO_TICKS(25));
+            animation_show(25);
         }
     }
     
@@ -194,24 +187,22 @@ static void animation_ripple(void)
     for (int brightness = 0; brightness <= 150; brightness += 10) {
         for (int i = 0; i < 60; i++) {
             int hue = (i * 6) % 360;
-            rgb_color_t color = hsv_to_rgb(hue, 255, brightness);
+            rgb_color_t color = led_color_hsv_deg(hue, 255, brightness);
             neopixel_set_pixel(i, color);
         }
-        neopixel_refresh();
-        vTaskDelay(pdMS_TO_TICKS(20));
+        animation_show(20);
     }
     
-    vTaskDelay(pdMS_TO_TICKS(500));
+    animation_wait(500);
     
     // 渐暗
     for (int brightness = 150; brightness >= 0; brightness -= 10) {
         for (int i = 0; i < 60; i++) {
             int hue = (i * 6) % 360;
-            rgb_color_t color = hsv_to_rgb(hue, 255, brightness);
+            rgb_color_t color = led_color_hsv_deg(hue, 255, brightness);
             neopixel_set_pixel(i, color);
         }
-        neopixel_refresh();
-        vTaskDelay(pdMS_TO_TICKS(15));
+        animation_show(15);
     }
 }
 
@@ -228,11 +219,10 @@ static void animation_rainbow_clock(void)
         for (int offset = 0; offset < 60; offset++) {
             for (int i = 0; i < 60; i++) {
                 int hue = ((i + offset) * 6) % 360;
-                rgb_color_t color = hsv_to_rgb(hue, 255, 120);
+                rgb_color_t color = led_color_hsv_deg(hue, 255, 120);
                 neopixel_set_pixel(i, color);
             }
-            neopixel_refresh();
-            vTaskDelay(pdMS_TO_TICKS(15));
+            animation_show(15);
         }
     }
     
@@ -244,7 +234,7 @@ static void animation_rainbow_clock(void)
     for (int step = 0; step < 30; step++) {
         neopixel_clear();
         
-        float progress = (float)step / 30.0f;
+        uint8_t progress = step * 255 / 30;
         
         for (int i = 0; i < 60; i++) {
             // 找到最近的目标
@@ -260,39 +250,31 @@ static void animation_rainbow_clock(void)
             }
             
             // 根据进度计算是否应该显示
-            int threshold = (int)(30 * (1.0f - progress));
+            int threshold = 30 - step;
             if (min_dist <= threshold) {
                 // 颜色从彩虹渐变到目标颜色
                 int hue = (i * 6) % 360;
-                rgb_color_t rainbow = hsv_to_rgb(hue, 255, 120);
+                rgb_color_t rainbow = led_color_hsv_deg(hue, 255, 120);
                 rgb_color_t target = target_colors[nearest_target];
                 
-                rgb_color_t color = {
-                    (uint8_t)(rainbow.r * (1 - progress) + target.r * progress),
-                    (uint8_t)(rainbow.g * (1 - progress) + target.g * progress),
-                    (uint8_t)(rainbow.b * (1 - progress) + target.b * progress)
-                };
+                rgb_color_t color = led_color_blend(rainbow, target, progress);
                 
                 // 越靠近中心越亮
                 int brightness_factor = 255 - min_dist * 8;
                 if (brightness_factor < 50) brightness_factor = 50;
-                color.r = color.r * brightness_factor / 255;
-                color.g = color.g * brightness_factor / 255;
-                color.b = color.b * brightness_factor / 255;
+                color = led_color_scale(color, brightness_factor);
                 
                 neopixel_set_pixel(i, color);
             }
         }
         
-        neopixel_refresh();
-        vTaskDelay(pdMS_TO_TICKS(50));
+        animation_show(50);
     }
     
     // 最终只剩三个点闪烁
     for (int flash = 0; flash < 4; flash++) {
         neopixel_clear();
-        neopixel_refresh();
-        vTaskDelay(pdMS_TO_TICKS(100));
+        animation_show(100);
         
         for (int t = 0; t < 3; t++) {
             // 每个点带一点光晕
@@ -307,8 +289,7 @@ static void animation_rainbow_clock(void)
                 neopixel_set_pixel(pos, color);
             }
         }
-        neopixel_refresh();
-        vTaskDelay(pdMS_TO_TICKS(200));
+        animation_show(200);
     }
 }
 
@@ -319,6 +300,7 @@ static void animation_rainbow_clock(void)
 static void play_wifi_connected_animation(void)
 {
     s_animation_playing = true;
+    s_anim_wake = xTaskGetTickCount();
     
     // 随机选择动画 (0, 1, 2)
     int animation = esp_random() % 3;
@@ -419,38 +401,42 @@ static void wifi_config_task(void *pvParameters)
 
 /**
  * @brief Main clock task
+ *
+ * 按固定帧率 (FRAME_SCHEDULER_FPS) 运行，每帧把经过的时间交给动画
  */
 static void clock_task(void *pvParameters)
 {
     time_t now;
     struct tm timeinfo;
     static int last_second = -1;  // 记录上一次显示的秒数
+    uint32_t status_ms = 0;       // 状态动画 (连接中、配网、等待同步) 的时间
 
     ESP_LOGI(TAG, "Clock task started");
+    frame_scheduler_init(FRAME_SCHEDULER_FPS);
 
     while (1) {
+        uint32_t elapsed_ms = frame_scheduler_wait();
+        
         // 如果正在播放动画，跳过显示更新
         if (s_animation_playing) {
-            vTaskDelay(pdMS_TO_TICKS(100));
             continue;
         }
+        status_ms += elapsed_ms;
         
         switch (s_app_state) {
             case APP_STATE_INIT:
             case APP_STATE_CONNECTING:
                 // Show connecting animation
-                clock_display_connecting_animation();
+                clock_display_connecting_animation(status_ms);
                 break;
                 
             case APP_STATE_AP_CONFIG:
                 // Show AP mode animation (different from connecting)
                 // Use a slower, pulsing animation to indicate config mode
                 {
-                    static int pulse_dir = 1;
-                    static int pulse_val = 0;
-                    pulse_val += pulse_dir * 5;
-                    if (pulse_val >= 100) pulse_dir = -1;
-                    if (pulse_val <= 0) pulse_dir = 1;
+                    // 2 秒一个来回，亮度 0-100
+                    uint32_t phase = status_ms % 2000;
+                    int pulse_val = (phase < 1000 ? phase : 2000 - phase) / 10;
                     
                     // Show pulsing purple for AP mode
                     neopixel_clear();
@@ -475,7 +461,7 @@ static void clock_task(void *pvParameters)
 
                 // Check if light show is active
                 if (light_show_is_active()) {
-                    light_show_update();
+                    light_show_update(elapsed_ms);
                 } else if (s_time_synced) {
                     // 只在秒数变化时才更新显示，避免频繁刷新导致闪烁
                     localtime_r(&now, &timeinfo);
@@ -485,18 +471,10 @@ static void clock_task(void *pvParameters)
                     }
                 } else {
                     // 时间未同步，显示彩色呼吸灯（每次呼吸换颜色）
-                    static int breath_val = 0;
-                    static int breath_dir = 3;
-                    static int color_index = 0;
-                    
-                    breath_val += breath_dir;
-                    if (breath_val >= 120) {
-                        breath_dir = -3;
-                    }
-                    if (breath_val <= 0) {
-                        breath_dir = 3;
-                        color_index = (color_index + 1) % 6;  // 换下一个颜色
-                    }
+                    // 4 秒一次呼吸，亮度 0-120
+                    uint32_t phase = status_ms % 4000;
+                    int breath_val = (phase < 2000 ? phase : 4000 - phase) * 120 / 2000;
+                    int color_index = (status_ms / 4000) % 6;
                     
                     // 6种颜色循环
                     rgb_color_t color;
@@ -521,7 +499,7 @@ static void clock_task(void *pvParameters)
                 break;
         }
 
-        vTaskDelay(pdMS_TO_TICKS(50)); // Update every 50ms
+        frame_scheduler_frame_done();
     }
 }
 
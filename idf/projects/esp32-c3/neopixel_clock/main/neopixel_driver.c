@@ -4,46 +4,199 @@
  */
 
 #include "neopixel_driver.h"
-#include "led_strip.h"
+#include "driver/rmt_tx.h"
+#include "driver/rmt_encoder.h"
+#include "esp_check.h"
 #include "esp_log.h"
 #include <string.h>
 
 static const char *TAG = "neopixel";
-static led_strip_handle_t led_strip = NULL;
 
-// 颜色缓冲区，用于读取像素颜色
-static rgb_color_t s_color_buffer[LED_STRIP_NUM_LEDS] = {0};
+// WS2812 时序 (10MHz 分辨率下每 tick 0.1us)
+#define WS2812_T0H_TICKS    (LED_STRIP_RMT_RES_HZ / 1000000 * 3 / 10)   // 0.3us
+#define WS2812_T0L_TICKS    (LED_STRIP_RMT_RES_HZ / 1000000 * 9 / 10)   // 0.9us
+#define WS2812_T1H_TICKS    (LED_STRIP_RMT_RES_HZ / 1000000 * 9 / 10)   // 0.9us
+#define WS2812_T1L_TICKS    (LED_STRIP_RMT_RES_HZ / 1000000 * 3 / 10)   // 0.3us
+// 复位 (锁存) 低电平 280us，兼容 WS2812B-V5；一个 RMT 符号有两段，各占一半
+#define WS2812_RESET_TICKS  (LED_STRIP_RMT_RES_HZ / 1000000 * 280 / 2)
 
-esp_err_t neopixel_init(void)
+// 等待上一帧发送完成的最长时间 (60 颗灯一帧约 1.8ms)
+#define NEOPIXEL_TX_WAIT_MS 100
+
+// 帧缓冲区 (RGB)：效果和时钟显示直接写入，neopixel_refresh() 时一次性编码
+static rgb_color_t s_framebuffer[LED_STRIP_NUM_LEDS] = {0};
+
+// 发送缓冲区 (WS2812 的 GRB 顺序)，RMT 发送期间不能修改
+static uint8_t s_tx_buf[LED_STRIP_NUM_LEDS * 3];
+
+static rmt_channel_handle_t s_rmt_chan = NULL;
+static bool s_tx_pending = false;
+
+// RMT 编码器：GRB 字节 + 复位码
+typedef struct {
+    rmt_encoder_t base;
+    rmt_encoder_t *bytes_encoder;
+    rmt_encoder_t *copy_encoder;
+    int state;
+    rmt_symbol_word_t reset_code;
+} neopixel_encoder_t;
+
+static neopixel_encoder_t s_encoder = {0};
+
+static size_t neopixel_encode(rmt_encoder_t *encoder, rmt_channel_handle_t channel,
+                              const void *primary_data, size_t data_size, rmt_encode_state_t *ret_state)
 {
-    ESP_LOGI(TAG, "Initializing NeoPixel LED strip on GPIO %d with %d LEDs", 
-             LED_STRIP_GPIO, LED_STRIP_NUM_LEDS);
+    neopixel_encoder_t *enc = __containerof(encoder, neopixel_encoder_t, base);
+    rmt_encode_state_t session_state = 0;
+    rmt_encode_state_t state = 0;
+    size_t encoded_symbols = 0;
 
-    // LED strip general initialization
-    led_strip_config_t strip_config = {
-        .strip_gpio_num = LED_STRIP_GPIO,
-        .max_leds = LED_STRIP_NUM_LEDS,
-        .led_pixel_format = LED_PIXEL_FORMAT_GRB,
-        .led_model = LED_MODEL_WS2812,
-        .flags.invert_out = false,
+    switch (enc->state) {
+    case 0: // 像素数据
+        encoded_symbols += enc->bytes_encoder->encode(enc->bytes_encoder, channel, primary_data, data_size, &session_state);
+        if (session_state & RMT_ENCODING_COMPLETE) {
+            enc->state = 1;
+        }
+        if (session_state & RMT_ENCODING_MEM_FULL) {
+            state |= RMT_ENCODING_MEM_FULL;
+            goto out;
+        }
+    // fall-through
+    case 1: // 复位码
+        encoded_symbols += enc->copy_encoder->encode(enc->copy_encoder, channel, &enc->reset_code,
+                                                     sizeof(enc->reset_code), &session_state);
+        if (session_state & RMT_ENCODING_COMPLETE) {
+            enc->state = 0;
+            state |= RMT_ENCODING_COMPLETE;
+        }
+        if (session_state & RMT_ENCODING_MEM_FULL) {
+            state |= RMT_ENCODING_MEM_FULL;
+            goto out;
+        }
+    }
+out:
+    *ret_state = state;
+    return encoded_symbols;
+}
+
+static esp_err_t neopixel_encoder_reset(rmt_encoder_t *encoder)
+{
+    neopixel_encoder_t *enc = __containerof(encoder, neopixel_encoder_t, base);
+    rmt_encoder_reset(enc->bytes_encoder);
+    rmt_encoder_reset(enc->copy_encoder);
+    enc->state = 0;
+    return ESP_OK;
+}
+
+static esp_err_t neopixel_encoder_del(rmt_encoder_t *encoder)
+{
+    neopixel_encoder_t *enc = __containerof(encoder, neopixel_encoder_t, base);
+    if (enc->bytes_encoder) {
+        rmt_del_encoder(enc->bytes_encoder);
+        enc->bytes_encoder = NULL;
+    }
+    if (enc->copy_encoder) {
+        rmt_del_encoder(enc->copy_encoder);
+        enc->copy_encoder = NULL;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t neopixel_encoder_init(void)
+{
+    rmt_bytes_encoder_config_t bytes_config = {
+        .bit0 = {
+            .level0 = 1,
+            .duration0 = WS2812_T0H_TICKS,
+            .level1 = 0,
+            .duration1 = WS2812_T0L_TICKS,
+        },
+        .bit1 = {
+            .level0 = 1,
+            .duration0 = WS2812_T1H_TICKS,
+            .level1 = 0,
+            .duration1 = WS2812_T1L_TICKS,
+        },
+        .flags.msb_first = 1,   // G7...G0 R7...R0 B7...B0
+    };
+    rmt_copy_encoder_config_t copy_config = {};
+
+    s_encoder.base.encode = neopixel_encode;
+    s_encoder.base.reset = neopixel_encoder_reset;
+    s_encoder.base.del = neopixel_encoder_del;
+    s_encoder.state = 0;
+    s_encoder.reset_code = (rmt_symbol_word_t) {
+        .level0 = 0,
+        .duration0 = WS2812_RESET_TICKS,
+        .level1 = 0,
+        .duration1 = WS2812_RESET_TICKS,
     };
 
-    // LED strip RMT configuration
-    led_strip_rmt_config_t rmt_config = {
+    esp_err_t ret = rmt_new_bytes_encoder(&bytes_config, &s_encoder.bytes_encoder);
+    if (ret == ESP_OK) {
+        ret = rmt_new_copy_encoder(&copy_config, &s_encoder.copy_encoder);
+    }
+    if (ret != ESP_OK) {
+        neopixel_encoder_del(&s_encoder.base);
+    }
+    return ret;
+}
+
+// 等待上一帧发送完成，之后才能改写发送缓冲区
+static esp_err_t neopixel_wait_tx(void)
+{
+    if (!s_tx_pending) {
+        return ESP_OK;
+    }
+    esp_err_t ret = rmt_tx_wait_all_done(s_rmt_chan, NEOPIXEL_TX_WAIT_MS);
+    if (ret == ESP_OK) {
+        s_tx_pending = false;
+    }
+    return ret;
+}
+
+esp_err_t neopixel_init(void)
+{
+    ESP_LOGI(TAG, "Initializing NeoPixel LED strip on GPIO %d with %d LEDs",
+             LED_STRIP_GPIO, LED_STRIP_NUM_LEDS);
+
+    rmt_tx_channel_config_t chan_config = {
+        .gpio_num = LED_STRIP_GPIO,
         .clk_src = RMT_CLK_SRC_DEFAULT,
         .resolution_hz = LED_STRIP_RMT_RES_HZ,
+        .mem_block_symbols = 48,
+        .trans_queue_depth = 4,
+        .flags.invert_out = false,
         .flags.with_dma = false,
     };
 
-    // Create LED strip object
-    esp_err_t ret = led_strip_new_rmt_device(&strip_config, &rmt_config, &led_strip);
+    esp_err_t ret = rmt_new_tx_channel(&chan_config, &s_rmt_chan);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create RMT TX channel: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ret = neopixel_encoder_init();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create LED encoder: %s", esp_err_to_name(ret));
+        rmt_del_channel(s_rmt_chan);
+        s_rmt_chan = NULL;
+        return ret;
+    }
+
+    // 通道一直保持使能，避免每次刷新都 enable/disable
+    ret = rmt_enable(s_rmt_chan);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to create LED strip: %s", esp_err_to_name(ret));
+        ESP_LOGE(TAG, "Failed to enable RMT channel: %s", esp_err_to_name(ret));
+        neopixel_encoder_del(&s_encoder.base);
+        rmt_del_channel(s_rmt_chan);
+        s_rmt_chan = NULL;
         return ret;
     }
 
-    // Clear all LEDs
-    ret = neopixel_clear();
+    // 上电后灯珠状态不确定，先发送一帧全黑
+    neopixel_clear();
+    ret = neopixel_refresh();
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to clear LED strip: %s", esp_err_to_name(ret));
         return ret;
@@ -53,22 +206,20 @@ esp_err_t neopixel_init(void)
     return ESP_OK;
 }
 
-esp_err_t neopixel_set_pixel(uint32_t index, rgb_color_t color)
+rgb_color_t *neopixel_get_framebuffer(void)
 {
-    if (led_strip == NULL) {
-        ESP_LOGE(TAG, "LED strip not initialized");
-        return ESP_ERR_INVALID_STATE;
-    }
+    return s_framebuffer;
+}
 
+esp_err_t neopixel_set_pixel(uint32_t index, rgb_color_t color)
+{
     if (index >= LED_STRIP_NUM_LEDS) {
         ESP_LOGE(TAG, "LED index %lu out of range (max: %d)", index, LED_STRIP_NUM_LEDS - 1);
         return ESP_ERR_INVALID_ARG;
     }
 
-    // 保存到缓冲区
-    s_color_buffer[index] = color;
-    
-    return led_strip_set_pixel(led_strip, index, color.r, color.g, color.b);
+    s_framebuffer[index] = color;
+    return ESP_OK;
 }
 
 esp_err_t neopixel_get_pixel(uint32_t index, rgb_color_t *color)
@@ -76,53 +227,77 @@ esp_err_t neopixel_get_pixel(uint32_t index, rgb_color_t *color)
     if (color == NULL) {
         return ESP_ERR_INVALID_ARG;
     }
-    
+
     if (index >= LED_STRIP_NUM_LEDS) {
         return ESP_ERR_INVALID_ARG;
     }
-    
-    *color = s_color_buffer[index];
+
+    *color = s_framebuffer[index];
     return ESP_OK;
 }
 
 esp_err_t neopixel_clear(void)
 {
-    if (led_strip == NULL) {
-        ESP_LOGE(TAG, "LED strip not initialized");
-        return ESP_ERR_INVALID_STATE;
-    }
-
-    // 清空颜色缓冲区
-    memset(s_color_buffer, 0, sizeof(s_color_buffer));
-    
-    // 只清除内部缓冲区，不刷新显示
+    // 只清空帧缓冲区，不刷新显示
     // 刷新应在 neopixel_refresh() 中统一完成，避免闪烁
-    return led_strip_clear(led_strip);
+    memset(s_framebuffer, 0, sizeof(s_framebuffer));
+    return ESP_OK;
 }
 
 esp_err_t neopixel_refresh(void)
 {
-    if (led_strip == NULL) {
+    if (s_rmt_chan == NULL) {
         ESP_LOGE(TAG, "LED strip not initialized");
         return ESP_ERR_INVALID_STATE;
     }
 
-    return led_strip_refresh(led_strip);
+    esp_err_t ret = neopixel_wait_tx();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Previous frame not sent: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    // 整帧一次编码成 GRB
+    uint8_t *out = s_tx_buf;
+    for (int i = 0; i < LED_STRIP_NUM_LEDS; i++) {
+        out[0] = s_framebuffer[i].g;
+        out[1] = s_framebuffer[i].r;
+        out[2] = s_framebuffer[i].b;
+        out += 3;
+    }
+
+    // 发送在后台进行，下一次刷新前才等待完成，渲染下一帧和发送重叠
+    rmt_transmit_config_t tx_config = {
+        .loop_count = 0,
+    };
+    ret = rmt_transmit(s_rmt_chan, &s_encoder.base, s_tx_buf, sizeof(s_tx_buf), &tx_config);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to transmit pixels: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    s_tx_pending = true;
+    return ESP_OK;
 }
 
 esp_err_t neopixel_deinit(void)
 {
-    if (led_strip == NULL) {
+    if (s_rmt_chan == NULL) {
         ESP_LOGW(TAG, "LED strip already deinitialized");
         return ESP_OK;
     }
 
-    esp_err_t ret = led_strip_del(led_strip);
+    neopixel_wait_tx();
+    s_tx_pending = false;
+
+    esp_err_t ret = rmt_disable(s_rmt_chan);
     if (ret == ESP_OK) {
-        led_strip = NULL;
+        ret = rmt_del_channel(s_rmt_chan);
+    }
+    if (ret == ESP_OK) {
+        neopixel_encoder_del(&s_encoder.base);
+        s_rmt_chan = NULL;
         ESP_LOGI(TAG, "NeoPixel deinitialized");
     }
 
     return ret;
 }
-
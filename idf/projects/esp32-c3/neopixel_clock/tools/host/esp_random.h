@@ -0,0 +1,13 @@
+// 主机基准用的 ESP-IDF 替身：固定种子的 xorshift32，结果可重复
+#pragma once
+
+#include <stdint.h>
+
+static inline uint32_t esp_random(void)
+{
+    static uint32_t x = 2463534242u;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
@@ -0,0 +1,162 @@
+/*
+ * 灯光秀主机基准 (Linux / macOS)
+ *
+ * 用设备上相同的 main/light_show.c 逐个模式渲染 (自定义模式逐个效果)，输出每帧耗时:
+ * - frame: light_show_update() 整帧 (效果渲染 + 帧缓冲区编码)
+ * - encode: 帧缓冲区编码成 GRB 发送缓冲区 (与 neopixel_driver.c 的 neopixel_refresh 相同，不含 RMT)
+ * - render: frame - encode
+ * 以及最后一帧的校验和 (esp_random 使用固定种子，结果可重复，用于确认改动前后输出一致)。
+ * 每帧按目标帧率推进动画时间 (默认 50fps，即每帧 20ms)。
+ *
+ * 编译和运行:
+ *     cc -O2 -Imain/include -Itools/host -I../../../components/led_color/include -o light_bench \
+ *        tools/light_show_bench.c main/light_show.c ../../../components/led_color/led_color.c
+ *     ./light_bench            # 每个模式 20000 帧
+ *     ./light_bench 1000       # 指定帧数
+ *     ./light_bench 1000 20    # 指定帧数和帧率
+ */
+
+#include "light_show.h"
+#include "neopixel_driver.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_FRAMES  20000
+#define DEFAULT_FPS     50
+#define CUSTOM_EFFECTS  10
+
+// 主机上的驱动：帧缓冲区和 GRB 编码，与 neopixel_driver.c 一致
+static rgb_color_t s_framebuffer[LED_STRIP_NUM_LEDS];
+static uint8_t s_tx_buf[LED_STRIP_NUM_LEDS * 3];
+
+esp_err_t neopixel_init(void)
+{
+    return ESP_OK;
+}
+
+rgb_color_t *neopixel_get_framebuffer(void)
+{
+    return s_framebuffer;
+}
+
+esp_err_t neopixel_set_pixel(uint32_t index, rgb_color_t color)
+{
+    if (index >= LED_STRIP_NUM_LEDS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_framebuffer[index] = color;
+    return ESP_OK;
+}
+
+esp_err_t neopixel_get_pixel(uint32_t index, rgb_color_t *color)
+{
+    if (color == NULL || index >= LED_STRIP_NUM_LEDS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *color = s_framebuffer[index];
+    return ESP_OK;
+}
+
+esp_err_t neopixel_clear(void)
+{
+    memset(s_framebuffer, 0, sizeof(s_framebuffer));
+    return ESP_OK;
+}
+
+esp_err_t neopixel_refresh(void)
+{
+    uint8_t *out = s_tx_buf;
+    for (int i = 0; i < LED_STRIP_NUM_LEDS; i++) {
+        out[0] = s_framebuffer[i].g;
+        out[1] = s_framebuffer[i].r;
+        out[2] = s_framebuffer[i].b;
+        out += 3;
+    }
+    return ESP_OK;
+}
+
+esp_err_t neopixel_deinit(void)
+{
+    return ESP_OK;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// FNV-1a 校验和 (发送缓冲区)
+static uint32_t checksum(void)
+{
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < sizeof(s_tx_buf); i++) {
+        h = (h ^ s_tx_buf[i]) * 16777619u;
+    }
+    return h;
+}
+
+static volatile uint8_t sink;
+
+static void run_mode(light_show_mode_t mode, int effect, int frames, uint32_t frame_ms)
+{
+    if (mode == LIGHT_SHOW_CUSTOM) {
+        custom_params_t params;
+        light_show_get_custom_params(&params);
+        params.effect = (uint8_t)effect;
+        light_show_set_custom_params(&params);
+    }
+    light_show_set_mode(LIGHT_SHOW_OFF);
+    light_show_set_mode(mode);
+
+    double t0 = now_ns();
+    for (int f = 0; f < frames; f++) {
+        light_show_update(frame_ms);
+    }
+    double frame_ns = (now_ns() - t0) / frames;
+    uint32_t sum = checksum();
+
+    t0 = now_ns();
+    for (int f = 0; f < frames; f++) {
+        neopixel_refresh();
+        sink = s_tx_buf[f % sizeof(s_tx_buf)];
+    }
+    double encode_ns = (now_ns() - t0) / frames;
+
+    char name[32];
+    if (mode == LIGHT_SHOW_CUSTOM) {
+        snprintf(name, sizeof(name), "custom/%d", effect);
+    } else {
+        snprintf(name, sizeof(name), "%d", mode);
+    }
+    printf("%-10s %-14s %10.0f %10.0f %10.0f   %08x\n", name, light_show_get_mode_name(mode),
+           frame_ns, frame_ns - encode_ns, encode_ns, sum);
+}
+
+int main(int argc, char **argv)
+{
+    int frames = argc > 1 ? atoi(argv[1]) : DEFAULT_FRAMES;
+    if (frames <= 0) {
+        frames = DEFAULT_FRAMES;
+    }
+    int fps = argc > 2 ? atoi(argv[2]) : DEFAULT_FPS;
+    if (fps <= 0 || fps > 1000) {
+        fps = DEFAULT_FPS;
+    }
+    uint32_t frame_ms = 1000 / fps;
+
+    light_show_init();
+    printf("%d LEDs, %d frames per mode at %d fps (%lu ms per frame), ns per frame\n",
+           LED_STRIP_NUM_LEDS, frames, fps, (unsigned long)frame_ms);
+    printf("%-10s %-14s %10s %10s %10s   %s\n", "mode", "name", "frame", "render", "encode", "checksum");
+    for (int m = LIGHT_SHOW_OFF + 1; m < LIGHT_SHOW_CUSTOM; m++) {
+        run_mode((light_show_mode_t)m, 0, frames, frame_ms);
+    }
+    for (int e = 0; e < CUSTOM_EFFECTS; e++) {
+        run_mode(LIGHT_SHOW_CUSTOM, e, frames, frame_ms);
+    }
+    return 0;
+}
@@ -51,7 +51,7 @@ typedef struct {
     bool initialized;
     bool led_state;                    // LED当前状态
     uint8_t led_brightness;            // LED亮度 (0-255)
-    uint8_t led_hue;                   // LED色调 (0-360)
+    uint16_t led_hue;                  // LED色调 (0-360)
 } joystick_led_handle_t;
 
 /**
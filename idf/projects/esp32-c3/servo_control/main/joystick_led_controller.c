@@ -5,6 +5,7 @@
  */
 
 #include "include/joystick_led_controller.h"
+#include "led_color.h"
 #include "esp_log.h"
 #include "esp_adc/adc_oneshot.h"
 #include "esp_adc/adc_cali.h"
@@ -20,45 +21,6 @@ static const char *TAG = "JOYSTICK_LED";
 /* ADC校准句柄 */
 static adc_cali_handle_t adc_cali_handle = NULL;
 
-/* HSV转RGB函数 */
-static void hsv_to_rgb(int hue, int saturation, int value, uint8_t *red, uint8_t *green, uint8_t *blue)
-{
-    int region, remainder, p, q, t;
-
-    if (saturation == 0) {
-        *red = *green = *blue = value;
-        return;
-    }
-
-    region = hue / 43;
-    remainder = (hue - (region * 43)) * 6;
-
-    p = (value * (255 - saturation)) >> 8;
-    q = (value * (255 - ((saturation * remainder) >> 8))) >> 8;
-    t = (value * (255 - ((saturation * (255 - remainder)) >> 8))) >> 8;
-
-    switch (region) {
-        case 0:
-            *red = value; *green = t; *blue = p;
-            break;
-        case 1:
-            *red = q; *green = value; *blue = p;
-            break;
-        case 2:
-            *red = p; *green = value; *blue = t;
-            break;
-        case 3:
-            *red = p; *green = q; *blue = value;
-            break;
-        case 4:
-            *red = t; *green = p; *blue = value;
-            break;
-        default:
-            *red = value; *green = p; *blue = q;
-            break;
-    }
-}
-
 /* 初始化ADC校准 */
 static esp_err_t init_adc_calibration(void)
 {
@@ -253,9 +215,8 @@ esp_err_t led_set_state(joystick_led_handle_t *handle, bool on)
     
     if (on) {
         // 使用当前色调和亮度
-        uint8_t red, green, blue;
-        hsv_to_rgb(handle->led_hue, 255, handle->led_brightness, &red, &green, &blue);
-        return led_set_color(handle, red, green, blue);
+        led_rgb_t c = led_color_hsv_deg(handle->led_hue, 255, handle->led_brightness);
+        return led_set_color(handle, c.r, c.g, c.b);
     } else {
         return led_set_color(handle, 0, 0, 0);
     }
@@ -284,10 +245,9 @@ esp_err_t led_set_hsv(joystick_led_handle_t *handle, uint16_t hue, uint8_t satur
     handle->led_hue = hue % 360;
     handle->led_brightness = value;
 
-    uint8_t red, green, blue;
-    hsv_to_rgb(hue, saturation, value, &red, &green, &blue);
+    led_rgb_t c = led_color_hsv_deg(hue, saturation, value);
     
-    return led_set_color(handle, red, green, blue);
+    return led_set_color(handle, c.r, c.g, c.b);
 }
 
 esp_err_t led_toggle(joystick_led_handle_t *handle)
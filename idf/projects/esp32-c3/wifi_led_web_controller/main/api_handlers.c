@@ -15,6 +15,7 @@
 #include "esp_wifi.h"
 #include "esp_timer.h"
 #include "cJSON.h"
+#include "json_writer_httpd.h"
 #include "led_controller.h"
 #include "web_files.h"
 #include "web_server.h"
@@ -44,19 +45,20 @@ esp_err_t api_options_handler(httpd_req_t *req)
 // 系统状态API
 esp_err_t api_status_handler(httpd_req_t *req)
 {
-    cJSON *json = cJSON_CreateObject();
-    if (!json) {
-        return ESP_FAIL;
-    }
+    char buf[128];
+    json_writer_t w;
+
+    web_server_set_cors_headers(req);
+    json_writer_httpd_begin(&w, req, buf, sizeof(buf));
 
     // 添加系统信息
-    cJSON_AddStringToObject(json, "status", "ok");
-    cJSON_AddNumberToObject(json, "uptime", esp_timer_get_time() / 1000000);
-    cJSON_AddStringToObject(json, "version", "2.0.0");
+    json_writer_begin_object(&w, NULL);
+    json_writer_string(&w, "status", "ok");
+    json_writer_int(&w, "uptime", esp_timer_get_time() / 1000000);
+    json_writer_string(&w, "version", "2.0.0");
+    json_writer_end_object(&w);
 
-    esp_err_t ret = web_server_send_json_response(req, json);
-    cJSON_Delete(json);
-    return ret;
+    return json_writer_httpd_end(&w);
 }
 
 // LED颜色控制API
@@ -213,31 +215,32 @@ esp_err_t api_ap_mode_handler(httpd_req_t *req)
 // AP状态查询API
 esp_err_t api_ap_status_handler(httpd_req_t *req)
 {
-    cJSON *json = cJSON_CreateObject();
-    if (!json) {
-        return ESP_FAIL;
-    }
+    char buf[256];
+    json_writer_t w;
 
     // 获取当前WiFi模式
     wifi_mode_t current_mode;
     esp_err_t mode_ret = esp_wifi_get_mode(&current_mode);
     
+    web_server_set_cors_headers(req);
+    json_writer_httpd_begin(&w, req, buf, sizeof(buf));
+
     // 添加AP状态信息
-    cJSON_AddStringToObject(json, "status", "ok");
-    cJSON_AddBoolToObject(json, "ap_enabled", wifi_is_ap_mode());
-    cJSON_AddStringToObject(json, "ap_ip", "192.168.4.1"); // AP固定IP
-    cJSON_AddStringToObject(json, "sta_ip", wifi_get_ip_string());
-    cJSON_AddStringToObject(json, "wifi_mode", 
+    json_writer_begin_object(&w, NULL);
+    json_writer_string(&w, "status", "ok");
+    json_writer_bool(&w, "ap_enabled", wifi_is_ap_mode());
+    json_writer_string(&w, "ap_ip", "192.168.4.1"); // AP固定IP
+    json_writer_string(&w, "sta_ip", wifi_get_ip_string());
+    json_writer_string(&w, "wifi_mode", 
         (mode_ret == ESP_OK) ? 
         ((current_mode == WIFI_MODE_STA) ? "STA" : 
          (current_mode == WIFI_MODE_AP) ? "AP" : 
          (current_mode == WIFI_MODE_APSTA) ? "AP+STA" : "UNKNOWN") : "UNKNOWN");
-    cJSON_AddStringToObject(json, "ap_ssid", "ESP32C3-LED-Controller");
-    cJSON_AddStringToObject(json, "ap_password", "12345678");
+    json_writer_string(&w, "ap_ssid", "ESP32C3-LED-Controller");
+    json_writer_string(&w, "ap_password", "12345678");
+    json_writer_end_object(&w);
 
-    esp_err_t ret = web_server_send_json_response(req, json);
-    cJSON_Delete(json);
-    return ret;
+    return json_writer_httpd_end(&w);
 }
 
 // 根路径处理器
@@ -10,7 +10,7 @@
 #include "nvs.h"
 #include "freertos/semphr.h"
 #include "led_strip.h"
-#include <math.h>
+#include "led_color.h"
 #include <string.h>
 
 static const char *TAG = "LED_CONTROLLER";
@@ -195,6 +195,15 @@ const led_state_t* led_get_state(void)
     return &s_led_state;
 }
 
+/* 0.0-1.0 换算为 0-255 (NaN 按 0) */
+static uint8_t led_unit_to_u8(float x)
+{
+    if (!(x > 0.0f)) {
+        return 0;
+    }
+    return (x >= 1.0f) ? 255 : (uint8_t)(x * 255.0f + 0.5f);
+}
+
 /* HSV转RGB */
 void led_hsv_to_rgb(const hsv_color_t* hsv, rgb_color_t* rgb)
 {
@@ -202,33 +211,22 @@ void led_hsv_to_rgb(const hsv_color_t* hsv, rgb_color_t* rgb)
         return;
     }
     
-    float h = fmod(hsv->hue, 360.0f);
-    float s = (hsv->saturation > 1.0f) ? 1.0f : (hsv->saturation < 0.0f) ? 0.0f : hsv->saturation;
-    float v = (hsv->value > 1.0f) ? 1.0f : (hsv->value < 0.0f) ? 0.0f : hsv->value;
-    
-    float c = v * s;
-    float x = c * (1.0f - fabsf((float)fmod(h / 60.0f, 2.0f) - 1.0f));
-    float m = v - c;
-    
-    float r, g, b;
-    
-    if (h >= 0 && h < 60) {
-        r = c; g = x; b = 0;
-    } else if (h >= 60 && h < 120) {
-        r = x; g = c; b = 0;
-    } else if (h >= 120 && h < 180) {
-        r = 0; g = c; b = x;
-    } else if (h >= 180 && h < 240) {
-        r = 0; g = x; b = c;
-    } else if (h >= 240 && h < 300) {
-        r = x; g = 0; b = c;
-    } else {
-        r = c; g = 0; b = x;
+    // 色调四舍五入到整数度后用整数取余，不用 fmodf (负的小数加 360 后可能正好等于 360，
+    // 换算成 16 位色调时越界)；超出 ±36000 度或 NaN 时按 0 度
+    int32_t deg = 0;
+    if (hsv->hue > -36000.0f && hsv->hue < 36000.0f) {
+        deg = (int32_t)(hsv->hue + (hsv->hue < 0.0f ? -0.5f : 0.5f)) % 360;
+        if (deg < 0) {
+            deg += 360;
+        }
     }
     
-    rgb->red = (uint16_t)((r + m) * 255);
-    rgb->green = (uint16_t)((g + m) * 255);
-    rgb->blue = (uint16_t)((b + m) * 255);
+    led_rgb_t c = led_color_hsv_deg((uint32_t)deg, led_unit_to_u8(hsv->saturation),
+                                    led_unit_to_u8(hsv->value));
+    
+    rgb->red = c.r;
+    rgb->green = c.g;
+    rgb->blue = c.b;
 }
 
 /* LED特效任务 */
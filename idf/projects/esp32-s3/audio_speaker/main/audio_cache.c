@@ -0,0 +1,586 @@
+/**
+ * @file audio_cache.c
+ * @brief Flash 音频片段缓存实现
+ */
+
+#include "include/audio_cache.h"
+#include <string.h>
+#include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "mbedtls/sha256.h"
+
+static const char *TAG = "audio_cache";
+
+// Flash 扇区大小 (擦除单位)
+#define CACHE_SECTOR            4096
+
+// 索引 A/B 副本占用的扇区数
+#define CACHE_INDEX_SECTORS     2
+
+#define CACHE_MAGIC             0x50494C43  // "CLIP"
+#define CACHE_VERSION           1
+
+// 索引键长度 (URL 的 SHA-256 前 16 字节)
+#define CACHE_KEY_LEN           16
+
+/**
+ * @brief 索引条目 (Flash 格式)
+ */
+typedef struct {
+    uint8_t  key[CACHE_KEY_LEN];
+    uint32_t bytes;                 // PCM 字节数
+    uint32_t sample_rate;
+    uint16_t first_sector;          // 起始扇区 (分区内)
+    uint16_t sectors;               // 占用扇区数
+    uint8_t  channels;
+    uint8_t  used;
+    uint16_t reserved;
+    uint32_t lru;                   // 最近使用序号，越大越新
+    char     etag[AUDIO_CACHE_ETAG_LEN];
+} cache_entry_t;
+
+/**
+ * @brief 索引 (Flash 格式，每份占一个扇区)
+ */
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t num_entries;
+    uint32_t seq;                   // 写入序号，加载时取有效副本中较新的一份
+    uint32_t crc;                   // 整个索引的 CRC32 (计算时本字段为 0)
+    cache_entry_t entries[AUDIO_CACHE_MAX_ENTRIES];
+} cache_index_t;
+
+_Static_assert(sizeof(cache_index_t) <= CACHE_SECTOR, "缓存索引必须放得进一个扇区");
+
+static const esp_partition_t *part = NULL;
+static audio_cache_config_t cfg;
+static SemaphoreHandle_t lock = NULL;
+static cache_index_t *index_buf = NULL;
+static uint16_t total_sectors = 0;
+static uint16_t budget_sectors = 0;
+static uint32_t lru_clock = 0;
+
+// 仅在 RAM 中的状态：映射计数、最近一次写入/验证时间 (重启后需重新验证)
+static uint8_t refs[AUDIO_CACHE_MAX_ENTRIES];
+static int64_t validated_us[AUDIO_CACHE_MAX_ENTRIES];
+
+// 统计
+static audio_cache_stats_t stats;
+static uint64_t hit_us_sum = 0;
+static uint64_t miss_us_sum = 0;
+
+/**
+ * @brief 计算 URL 的索引键
+ */
+static void cache_key(const char *url, uint8_t key[CACHE_KEY_LEN])
+{
+    uint8_t digest[32];
+    mbedtls_sha256((const unsigned char *)url, strlen(url), digest, 0);
+    memcpy(key, digest, CACHE_KEY_LEN);
+}
+
+/**
+ * @brief 计算索引 CRC
+ */
+static uint32_t cache_index_crc(cache_index_t *idx)
+{
+    uint32_t saved = idx->crc;
+    idx->crc = 0;
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)idx, sizeof(*idx));
+    idx->crc = saved;
+    return crc;
+}
+
+/**
+ * @brief 检查从 Flash 读出的索引，丢弃越界的条目
+ */
+static bool cache_index_valid(cache_index_t *idx)
+{
+    if (idx->magic != CACHE_MAGIC || idx->version != CACHE_VERSION ||
+        idx->num_entries != AUDIO_CACHE_MAX_ENTRIES || idx->crc != cache_index_crc(idx)) {
+        return false;
+    }
+
+    for (int i = 0; i < AUDIO_CACHE_MAX_ENTRIES; i++) {
+        cache_entry_t *e = &idx->entries[i];
+        if (!e->used) {
+            continue;
+        }
+        bool ok = e->first_sector >= CACHE_INDEX_SECTORS &&
+                  (uint32_t)e->first_sector + e->sectors <= total_sectors &&
+                  e->bytes > 0 && e->bytes <= (uint32_t)e->sectors * CACHE_SECTOR &&
+                  (e->channels == 1 || e->channels == 2) &&
+                  memchr(e->etag, '\0', sizeof(e->etag)) != NULL;
+        if (!ok) {
+            e->used = 0;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 加载索引 (两份副本中取有效且较新的一份)
+ */
+static void cache_load_index(void)
+{
+    cache_index_t *tmp = malloc(sizeof(cache_index_t));
+    bool found = false;
+
+    for (int i = 0; tmp != NULL && i < CACHE_INDEX_SECTORS; i++) {
+        if (esp_partition_read(part, (size_t)i * CACHE_SECTOR, tmp, sizeof(*tmp)) != ESP_OK ||
+            !cache_index_valid(tmp)) {
+            continue;
+        }
+        if (!found || (int32_t)(tmp->seq - index_buf->seq) > 0) {
+            memcpy(index_buf, tmp, sizeof(*tmp));
+            found = true;
+        }
+    }
+    free(tmp);
+
+    if (!found) {
+        memset(index_buf, 0, sizeof(*index_buf));
+        index_buf->magic = CACHE_MAGIC;
+        index_buf->version = CACHE_VERSION;
+        index_buf->num_entries = AUDIO_CACHE_MAX_ENTRIES;
+        ESP_LOGI(TAG, "没有有效的缓存索引，从空缓存开始");
+    }
+
+    lru_clock = 0;
+    for (int i = 0; i < AUDIO_CACHE_MAX_ENTRIES; i++) {
+        if (index_buf->entries[i].used && index_buf->entries[i].lru > lru_clock) {
+            lru_clock = index_buf->entries[i].lru;
+        }
+    }
+}
+
+/**
+ * @brief 保存索引到另一份副本 (写完之前旧副本仍然有效)
+ */
+static esp_err_t cache_save_index(void)
+{
+    index_buf->seq++;
+    index_buf->crc = cache_index_crc(index_buf);
+
+    size_t offset = (size_t)(index_buf->seq % CACHE_INDEX_SECTORS) * CACHE_SECTOR;
+    esp_err_t ret = esp_partition_erase_range(part, offset, CACHE_SECTOR);
+    if (ret == ESP_OK) {
+        ret = esp_partition_write(part, offset, index_buf, sizeof(*index_buf));
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "写入缓存索引失败: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+/**
+ * @brief 按键查找条目
+ */
+static int cache_find(const uint8_t key[CACHE_KEY_LEN])
+{
+    for (int i = 0; i < AUDIO_CACHE_MAX_ENTRIES; i++) {
+        if (index_buf->entries[i].used && memcmp(index_buf->entries[i].key, key, CACHE_KEY_LEN) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief 已占用的扇区数
+ */
+static uint32_t cache_used_sectors(void)
+{
+    uint32_t used = 0;
+    for (int i = 0; i < AUDIO_CACHE_MAX_ENTRIES; i++) {
+        if (index_buf->entries[i].used) {
+            used += index_buf->entries[i].sectors;
+        }
+    }
+    return used;
+}
+
+/**
+ * @brief 查找能放下 need 个扇区的第一个空闲区间
+ *
+ * @return int 起始扇区，-1 表示没有足够大的连续空间
+ */
+static int cache_find_gap(uint16_t need)
+{
+    uint32_t start = CACHE_INDEX_SECTORS;
+    bool moved = true;
+
+    // 与已用区间重叠时跳到该区间之后，直到不再重叠 (每次移动 start 单调增加)
+    while (moved) {
+        moved = false;
+        if (start + need > total_sectors) {
+            return -1;
+        }
+        for (int i = 0; i < AUDIO_CACHE_MAX_ENTRIES; i++) {
+            const cache_entry_t *e = &index_buf->entries[i];
+            if (e->used && start < (uint32_t)e->first_sector + e->sectors && e->first_sector < start + need) {
+                start = (uint32_t)e->first_sector + e->sectors;
+                moved = true;
+            }
+        }
+    }
+    return (int)start;
+}
+
+/**
+ * @brief 淘汰最近最少使用且未被映射的条目
+ *
+ * @return bool 是否淘汰了条目
+ */
+static bool cache_evict_lru(void)
+{
+    int victim = -1;
+    for (int i = 0; i < AUDIO_CACHE_MAX_ENTRIES; i++) {
+        const cache_entry_t *e = &index_buf->entries[i];
+        if (e->used && refs[i] == 0 && (victim < 0 || e->lru < index_buf->entries[victim].lru)) {
+            victim = i;
+        }
+    }
+    if (victim < 0) {
+        return false;
+    }
+
+    ESP_LOGI(TAG, "淘汰片段 %d (%lu 字节)", victim, (unsigned long)index_buf->entries[victim].bytes);
+    index_buf->entries[victim].used = 0;
+    stats.evictions++;
+    return true;
+}
+
+/**
+ * @brief 初始化缓存
+ */
+esp_err_t audio_cache_init(const audio_cache_config_t *config)
+{
+    if (part != NULL) {
+        return ESP_OK;
+    }
+
+    if (config != NULL) {
+        cfg = *config;
+    } else {
+        audio_cache_config_t def = AUDIO_CACHE_DEFAULT_CONFIG();
+        cfg = def;
+    }
+
+    const esp_partition_t *p = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                        (esp_partition_subtype_t)AUDIO_CACHE_PARTITION_SUBTYPE,
+                                                        cfg.partition_label);
+    if (p == NULL) {
+        ESP_LOGW(TAG, "未找到缓存分区 \"%s\"，不使用片段缓存", cfg.partition_label);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    size_t sectors = p->size / CACHE_SECTOR;
+    if (sectors <= CACHE_INDEX_SECTORS || sectors > UINT16_MAX) {
+        ESP_LOGE(TAG, "缓存分区大小无效: %lu 字节", (unsigned long)p->size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    total_sectors = (uint16_t)sectors;
+
+    size_t data_sectors = sectors - CACHE_INDEX_SECTORS;
+    budget_sectors = (uint16_t)data_sectors;
+    if (cfg.budget_bytes > 0 && cfg.budget_bytes / CACHE_SECTOR < data_sectors) {
+        budget_sectors = (uint16_t)(cfg.budget_bytes / CACHE_SECTOR);
+    }
+
+    lock = xSemaphoreCreateMutex();
+    index_buf = malloc(sizeof(cache_index_t));
+    if (lock == NULL || index_buf == NULL) {
+        if (lock != NULL) {
+            vSemaphoreDelete(lock);
+            lock = NULL;
+        }
+        free(index_buf);
+        index_buf = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    part = p;
+    memset(refs, 0, sizeof(refs));
+    memset(validated_us, 0, sizeof(validated_us));
+    memset(&stats, 0, sizeof(stats));
+    cache_load_index();
+
+    uint32_t entries = 0;
+    for (int i = 0; i < AUDIO_CACHE_MAX_ENTRIES; i++) {
+        entries += index_buf->entries[i].used;
+    }
+    ESP_LOGI(TAG, "片段缓存: 分区 %s (%lu KB), 预算 %lu KB, 已有 %lu 个片段 (%lu KB)",
+             p->label, (unsigned long)(p->size / 1024),
+             (unsigned long)(budget_sectors * CACHE_SECTOR / 1024), (unsigned long)entries,
+             (unsigned long)(cache_used_sectors() * CACHE_SECTOR / 1024));
+    return ESP_OK;
+}
+
+/**
+ * @brief 单个片段的大小上限
+ */
+size_t audio_cache_clip_limit(void)
+{
+    return part != NULL ? cfg.max_clip_bytes : 0;
+}
+
+/**
+ * @brief 查找并映射片段
+ */
+esp_err_t audio_cache_open(const char *url, audio_cache_clip_t *clip)
+{
+    if (part == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (url == NULL || clip == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint8_t key[CACHE_KEY_LEN];
+    cache_key(url, key);
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    int slot = cache_find(key);
+    if (slot < 0) {
+        xSemaphoreGive(lock);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    cache_entry_t *e = &index_buf->entries[slot];
+    const void *ptr = NULL;
+    esp_err_t ret = esp_partition_mmap(part, (size_t)e->first_sector * CACHE_SECTOR, e->bytes,
+                                       ESP_PARTITION_MMAP_DATA, &ptr, &clip->handle);
+    if (ret != ESP_OK) {
+        xSemaphoreGive(lock);
+        ESP_LOGE(TAG, "映射片段失败: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    int64_t now = esp_timer_get_time();
+    clip->pcm = (const int16_t *)ptr;
+    clip->bytes = e->bytes;
+    clip->sample_rate = e->sample_rate;
+    clip->channels = e->channels;
+    clip->fresh = validated_us[slot] != 0 && now - validated_us[slot] < (int64_t)cfg.fresh_s * 1000000;
+    strlcpy(clip->etag, e->etag, sizeof(clip->etag));
+    clip->slot = slot;
+
+    refs[slot]++;
+    e->lru = ++lru_clock;
+    xSemaphoreGive(lock);
+    return ESP_OK;
+}
+
+/**
+ * @brief 释放片段映射
+ */
+void audio_cache_close(audio_cache_clip_t *clip)
+{
+    if (part == NULL || clip == NULL || clip->pcm == NULL) {
+        return;
+    }
+
+    esp_partition_munmap(clip->handle);
+    clip->pcm = NULL;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (refs[clip->slot] > 0) {
+        refs[clip->slot]--;
+    }
+    xSemaphoreGive(lock);
+}
+
+/**
+ * @brief 服务器确认片段未变化
+ */
+void audio_cache_revalidated(const audio_cache_clip_t *clip)
+{
+    if (part == NULL || clip == NULL || clip->slot < 0 || clip->slot >= AUDIO_CACHE_MAX_ENTRIES) {
+        return;
+    }
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (index_buf->entries[clip->slot].used) {
+        validated_us[clip->slot] = esp_timer_get_time();
+    }
+    stats.revalidations++;
+    xSemaphoreGive(lock);
+}
+
+/**
+ * @brief 删除 URL 对应的片段
+ */
+void audio_cache_remove(const char *url)
+{
+    if (part == NULL || url == NULL) {
+        return;
+    }
+
+    uint8_t key[CACHE_KEY_LEN];
+    cache_key(url, key);
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    int slot = cache_find(key);
+    if (slot >= 0 && refs[slot] == 0) {
+        index_buf->entries[slot].used = 0;
+        cache_save_index();
+        ESP_LOGI(TAG, "删除已失效的片段 %d", slot);
+    }
+    xSemaphoreGive(lock);
+}
+
+/**
+ * @brief 写入片段
+ */
+esp_err_t audio_cache_store(const char *url, const char *etag, uint32_t sample_rate, uint8_t channels,
+                            const void *pcm, size_t bytes)
+{
+    if (part == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (url == NULL || etag == NULL || pcm == NULL || bytes == 0 || (channels != 1 && channels != 2)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    size_t need = (bytes + CACHE_SECTOR - 1) / CACHE_SECTOR;
+    if (bytes > cfg.max_clip_bytes || need > budget_sectors || strlen(etag) >= AUDIO_CACHE_ETAG_LEN) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    uint8_t key[CACHE_KEY_LEN];
+    cache_key(url, key);
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+
+    // 同一 URL 的旧片段先删除；仍在映射中时放弃本次写入
+    bool dirty = false;
+    int old = cache_find(key);
+    if (old >= 0) {
+        if (refs[old] > 0) {
+            xSemaphoreGive(lock);
+            return ESP_ERR_INVALID_STATE;
+        }
+        index_buf->entries[old].used = 0;
+        dirty = true;
+    }
+
+    // 需要空闲条目、足够大的连续区间且不超过预算，否则按 LRU 淘汰后重试
+    int slot = -1;
+    int first = -1;
+    while (1) {
+        slot = -1;
+        for (int i = 0; i < AUDIO_CACHE_MAX_ENTRIES; i++) {
+            if (!index_buf->entries[i].used) {
+                slot = i;
+                break;
+            }
+        }
+        first = cache_find_gap((uint16_t)need);
+        if (slot >= 0 && first >= 0 && cache_used_sectors() + need <= budget_sectors) {
+            break;
+        }
+        if (!cache_evict_lru()) {
+            if (dirty) {
+                cache_save_index();
+            }
+            xSemaphoreGive(lock);
+            ESP_LOGW(TAG, "缓存空间不足，片段 (%u 字节) 不写入", (unsigned)bytes);
+            return ESP_ERR_NO_MEM;
+        }
+        dirty = true;
+    }
+
+    // 先保存删除/淘汰结果，再覆盖数据：掉电时索引不会指向写了一半的扇区
+    esp_err_t ret = dirty ? cache_save_index() : ESP_OK;
+    if (ret == ESP_OK) {
+        ret = esp_partition_erase_range(part, (size_t)first * CACHE_SECTOR, need * CACHE_SECTOR);
+    }
+    if (ret == ESP_OK) {
+        ret = esp_partition_write(part, (size_t)first * CACHE_SECTOR, pcm, bytes);
+    }
+    if (ret != ESP_OK) {
+        xSemaphoreGive(lock);
+        ESP_LOGE(TAG, "写入片段失败: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    cache_entry_t *e = &index_buf->entries[slot];
+    memset(e, 0, sizeof(*e));
+    memcpy(e->key, key, CACHE_KEY_LEN);
+    e->bytes = (uint32_t)bytes;
+    e->sample_rate = sample_rate;
+    e->first_sector = (uint16_t)first;
+    e->sectors = (uint16_t)need;
+    e->channels = channels;
+    e->lru = ++lru_clock;
+    strlcpy(e->etag, etag, sizeof(e->etag));
+    e->used = 1;
+
+    ret = cache_save_index();
+    if (ret != ESP_OK) {
+        e->used = 0;
+    } else {
+        validated_us[slot] = esp_timer_get_time();
+        stats.stores++;
+        ESP_LOGI(TAG, "片段已缓存: %u 字节, 扇区 %d-%d, ETag %s",
+                 (unsigned)bytes, first, first + (int)need - 1, etag);
+    }
+    xSemaphoreGive(lock);
+    return ret;
+}
+
+/**
+ * @brief 记录一次播放的首样本时间
+ */
+void audio_cache_record_play(bool hit, uint32_t first_sample_us)
+{
+    if (lock == NULL) {
+        return;
+    }
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (hit) {
+        stats.hits++;
+        stats.hit_first_sample_us = first_sample_us;
+        hit_us_sum += first_sample_us;
+    } else {
+        stats.misses++;
+        stats.miss_first_sample_us = first_sample_us;
+        miss_us_sum += first_sample_us;
+    }
+    xSemaphoreGive(lock);
+}
+
+/**
+ * @brief 获取缓存统计
+ */
+void audio_cache_get_stats(audio_cache_stats_t *out)
+{
+    if (out == NULL) {
+        return;
+    }
+    if (lock == NULL) {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    *out = stats;
+    out->entries = 0;
+    for (int i = 0; i < AUDIO_CACHE_MAX_ENTRIES; i++) {
+        out->entries += index_buf->entries[i].used;
+    }
+    out->used_bytes = cache_used_sectors() * CACHE_SECTOR;
+    out->budget_bytes = (size_t)budget_sectors * CACHE_SECTOR;
+    out->hit_first_sample_avg_us = stats.hits > 0 ? (uint32_t)(hit_us_sum / stats.hits) : 0;
+    out->miss_first_sample_avg_us = stats.misses > 0 ? (uint32_t)(miss_us_sum / stats.misses) : 0;
+    xSemaphoreGive(lock);
+
+    uint32_t plays = out->hits + out->misses;
+    out->hit_pct = plays > 0 ? (uint8_t)((uint64_t)out->hits * 100 / plays) : 0;
+}
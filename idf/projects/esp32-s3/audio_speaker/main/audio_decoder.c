@@ -0,0 +1,266 @@
+/**
+ * @file audio_decoder.c
+ * @brief 可插拔音频解码级实现
+ *
+ * 网络数据先追加到输入缓冲区，再交给当前解码器逐帧解码；未消耗的尾部
+ * 移到缓冲区开头等待下一次 feed。解码输出写入同一个 PCM 块后立即交给输出回调，
+ * 解码过程不分配内存。
+ */
+
+#include "include/audio_decoder.h"
+#include "include/audio_dsp.h"
+#include <string.h>
+#include <strings.h>
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+static const char *TAG = "audio_decoder";
+
+// 格式与解码器对应表
+static const audio_decoder_ops_t *const s_decoders[] = {
+    [AUDIO_FORMAT_WAV] = &audio_decoder_wav_ops,
+    [AUDIO_FORMAT_MP3] = &audio_decoder_mp3_ops,
+};
+
+// 缓冲区 (初始化时分配，所有数据流复用)
+static uint8_t *in_buf = NULL;
+static size_t in_len = 0;
+static int16_t *pcm_block = NULL;
+
+// 当前数据流
+static const audio_decoder_ops_t *decoder = NULL;
+static audio_decoder_sink_t out_sink;
+static audio_decoder_info_t cur_info;
+static audio_decoder_info_t reported_info;
+
+// 统计
+static audio_decoder_stats_t stats;
+static int64_t decode_us = 0;
+
+/**
+ * @brief 初始化解码级
+ */
+esp_err_t audio_decoder_init(void)
+{
+    if (in_buf != NULL) {
+        return ESP_OK;
+    }
+
+    in_buf = heap_caps_malloc(AUDIO_DECODER_IN_BUF_SIZE, MALLOC_CAP_INTERNAL);
+    pcm_block = heap_caps_aligned_alloc(AUDIO_DSP_ALIGN, AUDIO_DECODER_PCM_BLOCK_SIZE, MALLOC_CAP_INTERNAL);
+    if (in_buf == NULL || pcm_block == NULL) {
+        ESP_LOGE(TAG, "解码缓冲区分配失败");
+        heap_caps_free(in_buf);
+        heap_caps_free(pcm_block);
+        in_buf = NULL;
+        pcm_block = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "解码级初始化完成 (输入 %d 字节, PCM 块 %d 字节)",
+             AUDIO_DECODER_IN_BUF_SIZE, AUDIO_DECODER_PCM_BLOCK_SIZE);
+    return ESP_OK;
+}
+
+/**
+ * @brief 判断数据格式
+ */
+audio_format_t audio_decoder_detect(const char *content_type, const uint8_t *head, size_t len)
+{
+    if (len >= 12 && memcmp(head, "RIFF", 4) == 0 && memcmp(head + 8, "WAVE", 4) == 0) {
+        return AUDIO_FORMAT_WAV;
+    }
+    if (len >= 3 && memcmp(head, "ID3", 3) == 0) {
+        return AUDIO_FORMAT_MP3;
+    }
+    if (len >= 2 && head[0] == 0xFF && (head[1] & 0xE6) == 0xE2) {
+        // MPEG 帧同步 + Layer III
+        return AUDIO_FORMAT_MP3;
+    }
+
+    if (content_type != NULL) {
+        if (strncasecmp(content_type, "audio/mpeg", 10) == 0 ||
+            strncasecmp(content_type, "audio/mp3", 9) == 0) {
+            return AUDIO_FORMAT_MP3;
+        }
+        if (strncasecmp(content_type, "audio/wav", 9) == 0 ||
+            strncasecmp(content_type, "audio/x-wav", 11) == 0 ||
+            strncasecmp(content_type, "audio/wave", 10) == 0 ||
+            strncasecmp(content_type, "audio/vnd.wave", 14) == 0) {
+            return AUDIO_FORMAT_WAV;
+        }
+    }
+
+    return AUDIO_FORMAT_UNKNOWN;
+}
+
+/**
+ * @brief 开始一个数据流
+ */
+esp_err_t audio_decoder_open(audio_format_t format, const audio_decoder_sink_t *sink)
+{
+    if (in_buf == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (format <= AUDIO_FORMAT_UNKNOWN || format >= sizeof(s_decoders) / sizeof(s_decoders[0]) ||
+        s_decoders[format] == NULL) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    if (decoder != NULL) {
+        audio_decoder_close();
+    }
+
+    esp_err_t ret = s_decoders[format]->open();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "打开 %s 解码器失败: %s", s_decoders[format]->name, esp_err_to_name(ret));
+        return ret;
+    }
+
+    decoder = s_decoders[format];
+    out_sink = *sink;
+    in_len = 0;
+    memset(&cur_info, 0, sizeof(cur_info));
+    memset(&reported_info, 0, sizeof(reported_info));
+    memset(&stats, 0, sizeof(stats));
+    stats.decoder = decoder->name;
+    decode_us = 0;
+
+    ESP_LOGI(TAG, "使用 %s 解码器", decoder->name);
+    return ESP_OK;
+}
+
+/**
+ * @brief 解码输入缓冲区中所有完整的帧
+ */
+static esp_err_t audio_decoder_run(void)
+{
+    size_t pos = 0;
+    esp_err_t ret = ESP_OK;
+
+    while (pos < in_len) {
+        size_t consumed = 0;
+        size_t out_bytes = 0;
+
+        int64_t t0 = esp_timer_get_time();
+        esp_err_t err = decoder->decode(in_buf + pos, in_len - pos, &consumed,
+                                        pcm_block, AUDIO_DECODER_PCM_BLOCK_SIZE, &out_bytes, &cur_info);
+        decode_us += esp_timer_get_time() - t0;
+
+        if (err == ESP_ERR_NOT_SUPPORTED) {
+            ret = err;
+            break;
+        }
+        if (err != ESP_OK) {
+            // 跳过已消耗的数据 (至少 1 字节) 重新同步
+            stats.errors++;
+            pos += (consumed > 0) ? consumed : 1;
+            continue;
+        }
+        if (consumed == 0 && out_bytes == 0) {
+            break;
+        }
+        pos += consumed;
+
+        if (out_bytes == 0 || cur_info.sample_rate == 0 || cur_info.channels == 0) {
+            continue;
+        }
+
+        // 格式确定或变化时先通知输出端
+        if (cur_info.sample_rate != reported_info.sample_rate || cur_info.channels != reported_info.channels) {
+            ret = out_sink.on_format(&cur_info, out_sink.arg);
+            if (ret != ESP_OK) {
+                break;
+            }
+            reported_info = cur_info;
+            stats.sample_rate = cur_info.sample_rate;
+            stats.channels = cur_info.channels;
+        }
+
+        ret = out_sink.on_pcm(pcm_block, out_bytes, out_sink.arg);
+        if (ret != ESP_OK) {
+            break;
+        }
+        stats.frames_out += out_bytes / (cur_info.channels * sizeof(int16_t));
+    }
+
+    // 未消耗的尾部移到缓冲区开头
+    in_len -= pos;
+    if (in_len > 0 && pos > 0) {
+        memmove(in_buf, in_buf + pos, in_len);
+    }
+    return ret;
+}
+
+/**
+ * @brief 喂入压缩数据
+ */
+esp_err_t audio_decoder_feed(const uint8_t *data, size_t len)
+{
+    if (decoder == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    stats.bytes_in += len;
+
+    while (len > 0) {
+        size_t n = AUDIO_DECODER_IN_BUF_SIZE - in_len;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(in_buf + in_len, data, n);
+        in_len += n;
+        data += n;
+        len -= n;
+
+        size_t before = in_len;
+        esp_err_t ret = audio_decoder_run();
+        if (ret != ESP_OK) {
+            return ret;
+        }
+
+        // 缓冲区已满仍无法解码：数据损坏或帧超过缓冲区，丢弃后继续
+        if (in_len == AUDIO_DECODER_IN_BUF_SIZE && in_len == before) {
+            ESP_LOGW(TAG, "输入缓冲区已满但无法解码，丢弃 %d 字节", AUDIO_DECODER_IN_BUF_SIZE);
+            stats.errors++;
+            in_len = 0;
+        }
+    }
+
+    return ESP_OK;
+}
+
+/**
+ * @brief 结束数据流
+ */
+void audio_decoder_close(void)
+{
+    if (decoder == NULL) {
+        return;
+    }
+
+    decoder->close();
+    decoder = NULL;
+
+    if (in_len > 0) {
+        ESP_LOGD(TAG, "丢弃 %u 字节不完整的尾部数据", (unsigned)in_len);
+        in_len = 0;
+    }
+
+    audio_decoder_stats_t s;
+    audio_decoder_get_stats(&s);
+    ESP_LOGI(TAG, "%s 解码结束: 输入 %llu 字节, 输出 %llu 帧, 错误 %lu, CPU %lu us/s",
+             s.decoder, (unsigned long long)s.bytes_in, (unsigned long long)s.frames_out,
+             (unsigned long)s.errors, (unsigned long)s.decode_us_per_s);
+}
+
+/**
+ * @brief 获取解码统计
+ */
+void audio_decoder_get_stats(audio_decoder_stats_t *out)
+{
+    *out = stats;
+    out->decode_us_per_s = (stats.frames_out > 0) ?
+        (uint32_t)((uint64_t)decode_us * stats.sample_rate / stats.frames_out) : 0;
+}
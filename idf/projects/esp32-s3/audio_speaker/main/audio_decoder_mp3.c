@@ -0,0 +1,122 @@
+/**
+ * @file audio_decoder_mp3.c
+ * @brief MP3 解码器 (封装 espressif/esp_audio_codec)
+ *
+ * 跳过 ID3v2 标签后按帧交给 esp_audio_dec 解码，每次输出一帧 PCM。
+ * 数据不足一帧时返回“需要更多数据”，由解码级缓存到下一次 feed。
+ */
+
+#include "include/audio_decoder.h"
+#include <string.h>
+#include "esp_audio_dec.h"
+#include "esp_audio_dec_default.h"
+#include "esp_log.h"
+
+static const char *TAG = "audio_dec_mp3";
+
+// ID3v2 标签头长度
+#define ID3V2_HEADER_SIZE   10
+
+static esp_audio_dec_handle_t dec_handle = NULL;
+static bool codec_registered = false;
+static bool header_checked = false;     // 已检查开头的 ID3v2 标签
+static uint32_t id3_remaining = 0;      // ID3v2 标签剩余字节
+
+static esp_err_t mp3_open(void)
+{
+    if (!codec_registered) {
+        if (esp_audio_dec_register_default() != ESP_AUDIO_ERR_OK) {
+            return ESP_FAIL;
+        }
+        codec_registered = true;
+    }
+
+    esp_audio_dec_cfg_t cfg = {
+        .type = ESP_AUDIO_TYPE_MP3,
+    };
+    if (esp_audio_dec_open(&cfg, &dec_handle) != ESP_AUDIO_ERR_OK) {
+        dec_handle = NULL;
+        return ESP_FAIL;
+    }
+
+    header_checked = false;
+    id3_remaining = 0;
+    return ESP_OK;
+}
+
+static esp_err_t mp3_decode(const uint8_t *in, size_t len, size_t *consumed,
+                            int16_t *out, size_t out_size, size_t *out_bytes,
+                            audio_decoder_info_t *info)
+{
+    *consumed = 0;
+    *out_bytes = 0;
+
+    // 开头的 ID3v2 标签 (大小为 4 个 7 位字节)
+    if (!header_checked) {
+        if (len < ID3V2_HEADER_SIZE) {
+            return ESP_OK;
+        }
+        header_checked = true;
+        if (memcmp(in, "ID3", 3) == 0) {
+            id3_remaining = ID3V2_HEADER_SIZE +
+                (((uint32_t)(in[6] & 0x7F) << 21) | ((uint32_t)(in[7] & 0x7F) << 14) |
+                 ((uint32_t)(in[8] & 0x7F) << 7) | (uint32_t)(in[9] & 0x7F));
+            if (in[5] & 0x10) {
+                id3_remaining += ID3V2_HEADER_SIZE;     // 标签尾
+            }
+            ESP_LOGI(TAG, "跳过 ID3v2 标签 (%lu 字节)", (unsigned long)id3_remaining);
+        }
+    }
+    if (id3_remaining > 0) {
+        size_t n = (len < id3_remaining) ? len : id3_remaining;
+        *consumed = n;
+        id3_remaining -= n;
+        return ESP_OK;
+    }
+
+    esp_audio_dec_in_raw_t raw = {
+        .buffer = (uint8_t *)in,
+        .len = len,
+    };
+    esp_audio_dec_out_frame_t frame = {
+        .buffer = (uint8_t *)out,
+        .len = out_size,
+    };
+    esp_audio_dec_info_t dec_info = { 0 };
+
+    esp_audio_err_t err = esp_audio_dec_process(dec_handle, &raw, &frame, &dec_info);
+    if (err == ESP_AUDIO_ERR_DATA_LACK) {
+        *consumed = raw.consumed;
+        return ESP_OK;
+    }
+    if (err != ESP_AUDIO_ERR_OK) {
+        *consumed = raw.consumed;
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    *consumed = raw.consumed;
+    if (dec_info.bits_per_sample != 16) {
+        ESP_LOGE(TAG, "不支持的输出位深: %u", dec_info.bits_per_sample);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    info->sample_rate = dec_info.sample_rate;
+    info->channels = dec_info.channel;
+    *out_bytes = frame.decoded_size;
+    return ESP_OK;
+}
+
+static void mp3_close(void)
+{
+    if (dec_handle != NULL) {
+        esp_audio_dec_close(dec_handle);
+        dec_handle = NULL;
+    }
+}
+
+const audio_decoder_ops_t audio_decoder_mp3_ops = {
+    .name = "MP3",
+    .open = mp3_open,
+    .decode = mp3_decode,
+    .close = mp3_close,
+};
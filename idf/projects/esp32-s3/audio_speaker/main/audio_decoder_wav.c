@@ -0,0 +1,412 @@
+/**
+ * @file audio_decoder_wav.c
+ * @brief RIFF/WAV 解码器 (8/16/24/32 位 PCM, 32 位浮点, IMA-ADPCM)
+ *
+ * 增量解析 RIFF 块：fmt 块确定编码，未知块跳过 (可跨多次 decode)，
+ * data 块按编码逐块输出。任何位置被读取边界截断时都只是等待更多数据。
+ * WAVE_FORMAT_EXTENSIBLE 按 SubFormat GUID 取实际编码 (PCM 或浮点)。
+ * 非 16 位 PCM 由 audio_dsp 的转换内核转为 int16 (截断多余位)。
+ *
+ * IMA-ADPCM 按 WAV (Microsoft) 块格式解码：
+ * 每声道 4 字节块头 (初始采样 + 步长索引)，其后每声道交替 4 字节 (8 个采样)。
+ */
+
+#include "include/audio_decoder.h"
+#include "include/audio_dsp.h"
+#include <string.h>
+#include "esp_log.h"
+
+static const char *TAG = "audio_dec_wav";
+
+// WAV 编码标识
+#define WAV_FORMAT_PCM          0x0001
+#define WAV_FORMAT_IEEE_FLOAT   0x0003
+#define WAV_FORMAT_IMA_ADPCM    0x0011
+#define WAV_FORMAT_EXTENSIBLE   0xFFFE
+
+// KSDATAFORMAT_SUBTYPE_xxx GUID 中编码标识之后的 14 字节
+static const uint8_t s_guid_tail[14] = {
+    0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71,
+};
+
+// fmt 块最大长度
+#define WAV_FMT_MAX_SIZE        64
+
+// 解析状态
+typedef enum {
+    WAV_STATE_RIFF = 0,     // 等待 RIFF 头
+    WAV_STATE_CHUNK,        // 等待块头
+    WAV_STATE_FMT,          // 等待完整 fmt 块
+    WAV_STATE_SKIP,         // 跳过未知块
+    WAV_STATE_DATA,         // 音频数据
+} wav_state_t;
+
+// IMA-ADPCM 步长表
+static const int16_t s_ima_step[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+};
+
+// IMA-ADPCM 步长索引调整表
+static const int8_t s_ima_index[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8,
+};
+
+// 解析状态
+static wav_state_t state;
+static uint32_t chunk_remaining;    // 当前块 (跳过/data) 剩余字节
+static bool chunk_pad;              // 块长度为奇数，需跳过 1 字节填充
+static uint16_t format_tag;
+static uint16_t channels;
+static uint32_t sample_rate;
+static uint16_t block_align;
+static uint16_t bits_per_sample;    // 容器位深 (每采样 block_align / channels 字节)
+static uint16_t samples_per_block;
+
+static uint16_t rd16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t rd32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * @brief 解码一个 IMA-ADPCM 半字节
+ */
+static inline int16_t ima_decode_nibble(uint8_t nibble, int32_t *predictor, int32_t *index)
+{
+    int32_t step = s_ima_step[*index];
+    int32_t diff = step >> 3;
+
+    if (nibble & 1) {
+        diff += step >> 2;
+    }
+    if (nibble & 2) {
+        diff += step >> 1;
+    }
+    if (nibble & 4) {
+        diff += step;
+    }
+    *predictor += (nibble & 8) ? -diff : diff;
+    if (*predictor > INT16_MAX) {
+        *predictor = INT16_MAX;
+    } else if (*predictor < INT16_MIN) {
+        *predictor = INT16_MIN;
+    }
+
+    *index += s_ima_index[nibble];
+    if (*index < 0) {
+        *index = 0;
+    } else if (*index > 88) {
+        *index = 88;
+    }
+    return (int16_t)*predictor;
+}
+
+/**
+ * @brief 解码一个 IMA-ADPCM 块，输出 samples_per_block 帧交织 PCM
+ */
+static esp_err_t ima_decode_block(const uint8_t *in, int16_t *out)
+{
+    int32_t predictor[2];
+    int32_t index[2];
+
+    for (uint16_t ch = 0; ch < channels; ch++) {
+        const uint8_t *hdr = in + ch * 4;
+        predictor[ch] = (int16_t)rd16(hdr);
+        index[ch] = hdr[2];
+        if (index[ch] > 88) {
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+        out[ch] = (int16_t)predictor[ch];
+    }
+
+    const uint8_t *p = in + channels * 4;
+    uint32_t groups = (samples_per_block - 1) / 8;
+
+    for (uint32_t g = 0; g < groups; g++) {
+        for (uint16_t ch = 0; ch < channels; ch++) {
+            int16_t *dst = out + (1 + g * 8) * channels + ch;
+            for (int i = 0; i < 4; i++) {
+                uint8_t b = *p++;
+                dst[(i * 2) * channels] = ima_decode_nibble(b & 0x0F, &predictor[ch], &index[ch]);
+                dst[(i * 2 + 1) * channels] = ima_decode_nibble(b >> 4, &predictor[ch], &index[ch]);
+            }
+        }
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief 解析 fmt 块
+ */
+static esp_err_t wav_parse_fmt(const uint8_t *p, uint32_t size)
+{
+    if (size < 16) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    format_tag = rd16(p);
+    channels = rd16(p + 2);
+    sample_rate = rd32(p + 4);
+    block_align = rd16(p + 12);
+    uint16_t bits = rd16(p + 14);
+
+    // EXTENSIBLE: cbSize(2) 有效位数(2) 声道掩码(4) SubFormat(16)，GUID 前两字节为实际编码
+    if (format_tag == WAV_FORMAT_EXTENSIBLE) {
+        if (size < 40 || rd16(p + 16) < 22 || memcmp(p + 26, s_guid_tail, sizeof(s_guid_tail)) != 0) {
+            ESP_LOGE(TAG, "无效的 WAVE_FORMAT_EXTENSIBLE 头");
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+        format_tag = rd16(p + 24);
+        ESP_LOGI(TAG, "EXTENSIBLE: 有效位数 %u, 声道掩码 0x%lx",
+                 rd16(p + 18), (unsigned long)rd32(p + 20));
+    }
+
+    ESP_LOGI(TAG, "WAV 信息: 编码 0x%04x, %lu Hz, %u 声道, %u 位, 块 %u 字节",
+             format_tag, (unsigned long)sample_rate, channels, bits, block_align);
+
+    if (channels != 1 && channels != 2) {
+        ESP_LOGE(TAG, "不支持的声道数: %u", channels);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (sample_rate == 0) {
+        ESP_LOGE(TAG, "无效的采样率");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    if (format_tag == WAV_FORMAT_PCM || format_tag == WAV_FORMAT_IEEE_FLOAT) {
+        // 容器位深按 block_align 计算 (有效位数可以小于容器，如 20 位放在 24 位容器中)
+        uint32_t container = (block_align > 0 && block_align % channels == 0) ?
+                             (uint32_t)(block_align / channels) * 8 : 0;
+        if (container == 0 || container < bits) {
+            container = (bits + 7) / 8 * 8;
+        }
+        bool ok = (format_tag == WAV_FORMAT_PCM) ?
+                  (container == 8 || container == 16 || container == 24 || container == 32) :
+                  (container == 32);
+        if (!ok) {
+            ESP_LOGE(TAG, "不支持的%s位深: %u", (format_tag == WAV_FORMAT_PCM) ? " PCM " : "浮点", bits);
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+        bits_per_sample = (uint16_t)container;
+        block_align = channels * (container / 8);
+        return ESP_OK;
+    }
+
+    if (format_tag == WAV_FORMAT_IMA_ADPCM) {
+        if (bits != 4 || block_align < channels * 4 || (block_align % (channels * 4)) != 0) {
+            ESP_LOGE(TAG, "无效的 IMA-ADPCM 参数");
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+        samples_per_block = (size >= 20) ? rd16(p + 18) : 0;
+        uint32_t expected = (block_align - channels * 4) * 2 / channels + 1;
+        if (samples_per_block == 0) {
+            samples_per_block = expected;
+        }
+        if (samples_per_block != expected ||
+            block_align > AUDIO_DECODER_IN_BUF_SIZE ||
+            (size_t)samples_per_block * channels * sizeof(int16_t) > AUDIO_DECODER_PCM_BLOCK_SIZE) {
+            ESP_LOGE(TAG, "IMA-ADPCM 块过大或参数不一致 (%u 字节, %u 帧)", block_align, samples_per_block);
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+        return ESP_OK;
+    }
+
+    ESP_LOGE(TAG, "不支持的 WAV 编码: 0x%04x", format_tag);
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+/**
+ * @brief 解码 data 块中的数据
+ */
+static esp_err_t wav_decode_data(const uint8_t *in, size_t len, size_t *consumed,
+                                 int16_t *out, size_t out_size, size_t *out_bytes)
+{
+    if (len > chunk_remaining) {
+        len = chunk_remaining;
+    }
+
+    if (format_tag != WAV_FORMAT_IMA_ADPCM) {
+        size_t frames = len / block_align;
+        size_t max_frames = out_size / (channels * sizeof(int16_t));
+        if (frames > max_frames) {
+            frames = max_frames;
+        }
+        if (frames == 0) {
+            // data 块末尾不足一帧的部分丢弃
+            if (chunk_remaining < block_align && len == chunk_remaining) {
+                *consumed = len;
+                chunk_remaining = 0;
+            }
+            return ESP_OK;
+        }
+
+        // 32 位采样需要按 4 字节对齐读取：输入不对齐时先复制到输出块，再原地转换
+        // (输出每采样 2 字节，从前向后转换不会覆盖尚未读取的输入)
+        const uint8_t *src = in;
+        if (bits_per_sample == 32 && ((uintptr_t)in & 3) != 0) {
+            if (frames * block_align > out_size) {
+                frames = out_size / block_align;
+            }
+            memcpy(out, in, frames * block_align);
+            src = (const uint8_t *)out;
+        }
+
+        size_t samples = frames * channels;
+        if (format_tag == WAV_FORMAT_IEEE_FLOAT) {
+            audio_dsp_f32_to_s16(out, (const float *)src, samples);
+        } else if (bits_per_sample == 16) {
+            memcpy(out, in, samples * sizeof(int16_t));
+        } else if (bits_per_sample == 8) {
+            audio_dsp_u8_to_s16(out, in, samples);
+        } else if (bits_per_sample == 24) {
+            audio_dsp_s24_to_s16(out, in, samples);
+        } else {
+            audio_dsp_s32_to_s16(out, (const int32_t *)src, samples);
+        }
+        *consumed = frames * block_align;
+        *out_bytes = samples * sizeof(int16_t);
+        chunk_remaining -= *consumed;
+        return ESP_OK;
+    }
+
+    // IMA-ADPCM：一次一个完整块 (数据末尾不足一块的部分丢弃)
+    if (len < block_align) {
+        if (chunk_remaining < block_align && len == chunk_remaining) {
+            *consumed = len;
+            chunk_remaining = 0;
+        }
+        return ESP_OK;
+    }
+
+    esp_err_t ret = ima_decode_block(in, out);
+    *consumed = block_align;
+    chunk_remaining -= block_align;
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    *out_bytes = (size_t)samples_per_block * channels * sizeof(int16_t);
+    return ESP_OK;
+}
+
+static esp_err_t wav_open(void)
+{
+    state = WAV_STATE_RIFF;
+    chunk_remaining = 0;
+    chunk_pad = false;
+    format_tag = 0;
+    channels = 0;
+    sample_rate = 0;
+    bits_per_sample = 0;
+    return ESP_OK;
+}
+
+static esp_err_t wav_decode(const uint8_t *in, size_t len, size_t *consumed,
+                            int16_t *out, size_t out_size, size_t *out_bytes,
+                            audio_decoder_info_t *info)
+{
+    *consumed = 0;
+    *out_bytes = 0;
+
+    switch (state) {
+        case WAV_STATE_RIFF:
+            if (len < 12) {
+                return ESP_OK;
+            }
+            if (memcmp(in, "RIFF", 4) != 0 || memcmp(in + 8, "WAVE", 4) != 0) {
+                ESP_LOGE(TAG, "不是有效的 WAV 文件");
+                return ESP_ERR_NOT_SUPPORTED;
+            }
+            *consumed = 12;
+            state = WAV_STATE_CHUNK;
+            return ESP_OK;
+
+        case WAV_STATE_CHUNK: {
+            size_t pad = chunk_pad ? 1 : 0;
+            if (len < 8 + pad) {
+                return ESP_OK;
+            }
+            const uint8_t *hdr = in + pad;
+            uint32_t size = rd32(hdr + 4);
+            chunk_pad = (size & 1) != 0;
+            *consumed = 8 + pad;
+
+            if (memcmp(hdr, "fmt ", 4) == 0) {
+                if (size > WAV_FMT_MAX_SIZE) {
+                    ESP_LOGE(TAG, "fmt 块过大: %lu", (unsigned long)size);
+                    return ESP_ERR_NOT_SUPPORTED;
+                }
+                chunk_remaining = size;
+                state = WAV_STATE_FMT;
+            } else if (memcmp(hdr, "data", 4) == 0) {
+                if (format_tag == 0) {
+                    ESP_LOGE(TAG, "data 块出现在 fmt 块之前");
+                    return ESP_ERR_NOT_SUPPORTED;
+                }
+                // 流式生成的 WAV 常把长度写为 0 或 0xFFFFFFFF
+                chunk_remaining = (size == 0) ? UINT32_MAX : size;
+                ESP_LOGI(TAG, "音频数据大小: %lu 字节", (unsigned long)size);
+                state = WAV_STATE_DATA;
+            } else {
+                // 空块 (如长度为 0 的 LIST) 不进入跳过状态：跳过状态消耗 0 字节会被核心当作需要更多数据
+                chunk_remaining = size;
+                state = (size > 0) ? WAV_STATE_SKIP : WAV_STATE_CHUNK;
+            }
+            return ESP_OK;
+        }
+
+        case WAV_STATE_FMT: {
+            if (len < chunk_remaining) {
+                return ESP_OK;
+            }
+            esp_err_t ret = wav_parse_fmt(in, chunk_remaining);
+            if (ret != ESP_OK) {
+                return ESP_ERR_NOT_SUPPORTED;
+            }
+            *consumed = chunk_remaining;
+            state = WAV_STATE_CHUNK;
+            info->sample_rate = sample_rate;
+            info->channels = (uint8_t)channels;
+            return ESP_OK;
+        }
+
+        case WAV_STATE_SKIP: {
+            size_t n = (len < chunk_remaining) ? len : chunk_remaining;
+            *consumed = n;
+            chunk_remaining -= n;
+            if (chunk_remaining == 0) {
+                state = WAV_STATE_CHUNK;
+            }
+            return ESP_OK;
+        }
+
+        case WAV_STATE_DATA: {
+            esp_err_t ret = wav_decode_data(in, len, consumed, out, out_size, out_bytes);
+            if (chunk_remaining == 0) {
+                state = WAV_STATE_CHUNK;
+            }
+            return ret;
+        }
+    }
+
+    return ESP_ERR_INVALID_STATE;
+}
+
+static void wav_close(void)
+{
+    state = WAV_STATE_RIFF;
+}
+
+const audio_decoder_ops_t audio_decoder_wav_ops = {
+    .name = "WAV",
+    .open = wav_open,
+    .decode = wav_decode,
+    .close = wav_close,
+};
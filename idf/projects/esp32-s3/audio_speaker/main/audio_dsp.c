@@ -0,0 +1,191 @@
+/**
+ * @file audio_dsp.c
+ * @brief 音频定点运算内核实现
+ *
+ * SIMD 内核处理 16 字节对齐、8 采样整数倍的部分，其余由标量代码完成，
+ * 两条路径结果逐位一致 (截断右移 + 饱和)。
+ */
+
+#include "include/audio_dsp.h"
+#include <stdbool.h>
+
+#if AUDIO_DSP_USE_SIMD
+// audio_dsp_s3.S
+extern void audio_dsp_mono_to_stereo_q15_s3(int16_t *dst, const int16_t *src, int samples, int16_t gain_q15);
+extern void audio_dsp_scale_q15_s3(int16_t *dst, const int16_t *src, int samples, int16_t gain_q15);
+extern int32_t audio_dsp_dot_q15_s3(const int16_t *x, const int16_t *h, int taps);
+extern void audio_dsp_s32_to_s16_s3(int16_t *dst, const int32_t *src, int samples);
+
+static inline bool audio_dsp_aligned(const void *p)
+{
+    return ((uintptr_t)p & (AUDIO_DSP_ALIGN - 1)) == 0;
+}
+#endif
+
+/**
+ * @brief 音量 (0-100) 转换为 Q15 增益
+ */
+int16_t audio_dsp_volume_to_q15(uint8_t volume)
+{
+    if (volume >= 100) {
+        return AUDIO_DSP_Q15_ONE;
+    }
+    return (int16_t)(((uint32_t)volume * AUDIO_DSP_Q15_ONE + 50) / 100);
+}
+
+static void audio_dsp_mono_to_stereo_q15_scalar(int16_t *dst, const int16_t *src, size_t samples, int16_t gain_q15)
+{
+    for (size_t i = 0; i < samples; i++) {
+        int16_t sample = audio_dsp_sat16(((int32_t)src[i] * gain_q15) >> 15);
+        dst[i * 2] = sample;      // 左声道
+        dst[i * 2 + 1] = sample;  // 右声道
+    }
+}
+
+static void audio_dsp_scale_q15_scalar(int16_t *dst, const int16_t *src, size_t samples, int16_t gain_q15)
+{
+    for (size_t i = 0; i < samples; i++) {
+        dst[i] = audio_dsp_sat16(((int32_t)src[i] * gain_q15) >> 15);
+    }
+}
+
+/**
+ * @brief 单声道转立体声并应用 Q15 增益
+ */
+void audio_dsp_mono_to_stereo_q15(int16_t *dst, const int16_t *src, size_t samples, int16_t gain_q15)
+{
+    size_t done = 0;
+
+#if AUDIO_DSP_USE_SIMD
+    if (audio_dsp_aligned(dst) && audio_dsp_aligned(src)) {
+        done = samples & ~(size_t)7;
+        if (done > 0) {
+            audio_dsp_mono_to_stereo_q15_s3(dst, src, (int)done, gain_q15);
+        }
+    }
+#endif
+
+    audio_dsp_mono_to_stereo_q15_scalar(dst + done * 2, src + done, samples - done, gain_q15);
+}
+
+/**
+ * @brief 应用 Q15 增益
+ */
+void audio_dsp_scale_q15(int16_t *dst, const int16_t *src, size_t samples, int16_t gain_q15)
+{
+    size_t done = 0;
+
+#if AUDIO_DSP_USE_SIMD
+    if (audio_dsp_aligned(dst) && audio_dsp_aligned(src)) {
+        done = samples & ~(size_t)7;
+        if (done > 0) {
+            audio_dsp_scale_q15_s3(dst, src, (int)done, gain_q15);
+        }
+    }
+#endif
+
+    audio_dsp_scale_q15_scalar(dst + done, src + done, samples - done, gain_q15);
+}
+
+/**
+ * @brief 原地应用线性增益斜坡
+ */
+void audio_dsp_ramp_q15(int16_t *buf, size_t frames, uint8_t channels, int16_t gain_from, int16_t gain_to)
+{
+    if (frames == 0) {
+        return;
+    }
+
+    // 增益以 Q15 × 65536 精度累加，避免长斜坡的步进误差
+    // (用乘法而不是左移：淡出时差值为负，负数左移是未定义行为)
+    int64_t gain = (int64_t)gain_from * 65536;
+    int64_t step = ((int64_t)gain_to - gain_from) * 65536 / (int64_t)frames;
+
+    for (size_t i = 0; i < frames; i++) {
+        int32_t g = (int32_t)(gain >> 16);
+        for (uint8_t ch = 0; ch < channels; ch++) {
+            int16_t *s = &buf[i * channels + ch];
+            *s = audio_dsp_sat16(((int32_t)*s * g) >> 15);
+        }
+        gain += step;
+    }
+}
+
+/**
+ * @brief Q15 点积
+ */
+int32_t audio_dsp_dot_q15(const int16_t *x, const int16_t *h, size_t taps)
+{
+#if AUDIO_DSP_USE_SIMD
+    if (audio_dsp_aligned(h) && (taps & 7) == 0) {
+        return audio_dsp_dot_q15_s3(x, h, (int)taps);
+    }
+#endif
+
+    int32_t acc = 0;
+    for (size_t i = 0; i < taps; i++) {
+        acc += (int32_t)x[i] * h[i];
+    }
+    return acc;
+}
+
+/**
+ * @brief 8 位无符号 PCM 转换为 int16
+ */
+void audio_dsp_u8_to_s16(int16_t *dst, const uint8_t *src, size_t samples)
+{
+    for (size_t i = 0; i < samples; i++) {
+        dst[i] = (int16_t)(((int32_t)src[i] - 128) * 256);
+    }
+}
+
+/**
+ * @brief 24 位打包 PCM 转换为 int16
+ */
+void audio_dsp_s24_to_s16(int16_t *dst, const uint8_t *src, size_t samples)
+{
+    // 小端 24 位采样的高两个字节即截断后的 int16
+    for (size_t i = 0; i < samples; i++, src += 3) {
+        dst[i] = (int16_t)(src[1] | (src[2] << 8));
+    }
+}
+
+/**
+ * @brief 32 位 PCM 转换为 int16
+ */
+void audio_dsp_s32_to_s16(int16_t *dst, const int32_t *src, size_t samples)
+{
+    size_t done = 0;
+
+#if AUDIO_DSP_USE_SIMD
+    // SIMD 内核按 16 字节块读取输入，最后一块可能超出处理范围最多 16 字节：
+    // 留出至少 4 个采样给标量代码，保证只读取 src[0, samples) 内的数据
+    if (audio_dsp_aligned(dst) && samples >= 12) {
+        done = (samples - 4) & ~(size_t)7;
+        audio_dsp_s32_to_s16_s3(dst, src, (int)done);
+    }
+#endif
+
+    for (size_t i = done; i < samples; i++) {
+        dst[i] = (int16_t)(src[i] >> 16);
+    }
+}
+
+/**
+ * @brief 32 位浮点 PCM 转换为 int16
+ */
+void audio_dsp_f32_to_s16(int16_t *dst, const float *src, size_t samples)
+{
+    for (size_t i = 0; i < samples; i++) {
+        float v = src[i] * 32768.0f;
+        if (v >= 32767.0f) {
+            dst[i] = INT16_MAX;
+        } else if (v <= -32768.0f) {
+            dst[i] = INT16_MIN;
+        } else if (v == v) {
+            dst[i] = (int16_t)v;
+        } else {
+            dst[i] = 0;
+        }
+    }
+}
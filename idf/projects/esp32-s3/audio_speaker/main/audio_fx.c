@@ -0,0 +1,610 @@
+/**
+ * @file audio_fx.c
+ * @brief 输出效果链实现
+ *
+ * 采样格式 Q4.27 (int16 刻度左移 12 位)，滤波器系数 Q28 (范围 ±8，+12 dB 架式滤波器的 b 系数可达 ±8)。
+ * 双二阶滤波器用直接 I 型，五项乘积以 64 位累加后一次舍入，低频滤波器
+ * (极点靠近单位圆) 也不会积累截断噪声。
+ *
+ * 64 位累加的余量：采样满幅 ±2^31 时五项乘积之和可达 5 × 2^31 × 2^31 > 2^63。
+ * 因此输入和每一级 (滤波器、压缩器) 的输出都限制在 ±FX_CLAMP (2^30，即 ±8.0，满幅以上 18 dB)，
+ * 并且只接受稳定的滤波器 (|a1| < 2, |a2| < 1)：
+ *   (|b0| + |b1| + |b2|) × 2^28 × 2^30 + (|a1| + |a2|) × 2^28 × 2^30 < (24 + 3) × 2^58 < 2^63
+ *
+ * 压缩器每 AUDIO_FX_DRC_BLOCK_FRAMES 帧计算一次增益，在 log2 域 (Q16) 运算：
+ *   目标增益 = -(电平 - 阈值) × (1 - 1/压缩比)
+ * 取前瞻窗口内 (即将输出到刚输入的各子块) 目标增益的最小值，按起效/恢复时间平滑，
+ * 再不高于正在输出子块自身的目标值，保证峰值不超过阈值所允许的电平；
+ * 转换为线性增益后在子块内线性插值，避免增益阶跃。
+ *
+ * 配置修改在调用者任务中计算系数，放入待生效区，由混音任务在下一块开始时取用。
+ */
+
+#include "include/audio_fx.h"
+#include <string.h>
+#include <math.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+static const char *TAG = "audio_fx";
+
+// 采样小数位 (int16 刻度左移 FX_SHIFT 位)
+#define FX_SHIFT            12
+#define FX_FRAC             (15 + FX_SHIFT)
+
+// 各级输出的限幅 (Q4.27 的 ±8.0)，保证滤波器 64 位累加不溢出
+#define FX_CLAMP            (1 << 30)
+#define FX_IN_CLAMP         (FX_CLAMP >> FX_SHIFT)
+
+// 滤波器系数小数位
+#define FX_COEF_FRAC        28
+
+// 线性增益小数位 (范围 ±8，容纳 +12 dB 补偿)
+#define FX_GAIN_FRAC        28
+
+// log2 域小数位
+#define FX_LOG_FRAC         16
+#define FX_LOG_ONE          (1 << FX_LOG_FRAC)
+
+// 平滑系数小数位
+#define FX_COEF_Q15         15
+
+// log2/exp2 查找表
+#define FX_LUT_BITS         6
+#define FX_LUT_SIZE         (1 << FX_LUT_BITS)
+
+// 前瞻子块数上限
+#define FX_MAX_LOOKAHEAD_BLOCKS     (AUDIO_FX_DRC_MAX_LOOKAHEAD / AUDIO_FX_DRC_BLOCK_FRAMES)
+
+/**
+ * @brief 单级双二阶滤波器系数 (Q28, a0 已归一化)
+ */
+typedef struct {
+    int32_t b0, b1, b2, a1, a2;
+} fx_biquad_t;
+
+/**
+ * @brief 混音任务使用的定点参数
+ */
+typedef struct {
+    bool enabled;
+    uint8_t num_biquads;
+    fx_biquad_t biquads[AUDIO_FX_MAX_FILTERS];
+
+    bool drc_enabled;
+    int32_t threshold_log;          // 阈值 (log2, Q16)
+    int32_t slope_q16;              // 1 - 1/压缩比 (Q16)
+    int32_t makeup_log;             // 补偿增益 (log2, Q16)
+    int32_t attack_q15;             // 每子块平滑系数
+    int32_t release_q15;
+    uint32_t lookahead_blocks;      // 前瞻子块数
+} fx_params_t;
+
+// 配置 (受 cfg_lock 保护)
+static portMUX_TYPE cfg_lock = portMUX_INITIALIZER_UNLOCKED;
+static audio_fx_config_t cfg = AUDIO_FX_DEFAULT_CONFIG();
+static fx_params_t pending;
+static volatile bool pending_ready = false;
+static uint32_t fx_rate = 0;
+
+// 混音任务状态
+static fx_params_t params;
+static int32_t biquad_state[AUDIO_FX_MAX_FILTERS][2][4];    // 每声道 x1, x2, y1, y2
+
+static int32_t delay_buf[AUDIO_FX_DRC_MAX_LOOKAHEAD * 2];
+static uint32_t delay_pos = 0;
+static int32_t target_ring[FX_MAX_LOOKAHEAD_BLOCKS + 1];
+static uint32_t target_pos = 0;
+static int32_t gain_log = 0;                // 平滑后的增益 (log2, Q16, ≤0)
+static int32_t gain_lin = 1 << FX_GAIN_FRAC;
+
+// 查找表
+static int32_t log2_lut[FX_LUT_SIZE + 1];   // log2(1 + i/64), Q16
+static uint32_t exp2_lut[FX_LUT_SIZE + 1];  // 2^(i/64), Q30
+
+// 统计
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static int64_t fx_us = 0;
+static uint64_t fx_frames = 0;
+static int32_t cur_reduction_log = 0;
+static int32_t max_reduction_log = 0;
+
+/**
+ * @brief log2(x / 2^FX_FRAC)，Q16 (x > 0)
+ */
+static inline int32_t fx_log2(uint32_t x)
+{
+    int n = 31 - __builtin_clz(x);
+    // 尾数归一化到 [1, 2)，取高 FX_LUT_BITS 位查表，其余位线性插值
+    uint32_t m = (n >= 31) ? x : (x << (31 - n));
+    uint32_t idx = (m >> (31 - FX_LUT_BITS)) & (FX_LUT_SIZE - 1);
+    uint32_t frac = (m >> (31 - FX_LUT_BITS - 16)) & 0xFFFF;
+    int32_t l = log2_lut[idx] + (int32_t)(((int64_t)(log2_lut[idx + 1] - log2_lut[idx]) * frac) >> 16);
+    return (n - FX_FRAC) * FX_LOG_ONE + l;             // n < FX_FRAC 时为负，不能左移
+}
+
+/**
+ * @brief 2^(x / 2^16)，Q28 线性增益 (x < 2.0，即增益低于 +12 dB)
+ */
+static inline int32_t fx_exp2(int32_t x)
+{
+    int32_t i = x >> FX_LOG_FRAC;                       // 向下取整
+    uint32_t f = (uint32_t)x & (FX_LOG_ONE - 1);
+    uint32_t idx = f >> (FX_LOG_FRAC - FX_LUT_BITS);
+    uint32_t frac = (f << FX_LUT_BITS) & (FX_LOG_ONE - 1);
+    uint32_t m = exp2_lut[idx] + (uint32_t)(((uint64_t)(exp2_lut[idx + 1] - exp2_lut[idx]) * frac) >> FX_LOG_FRAC);
+
+    // m 为 Q30 的 [1, 2)，转换为 Q28 并乘以 2^i
+    int32_t shift = (30 - FX_GAIN_FRAC) - i;
+    if (shift >= 32) {
+        return 0;
+    }
+    if (shift < 1) {
+        return INT32_MAX;
+    }
+    return (int32_t)(m >> shift);
+}
+
+/**
+ * @brief dB 转换为 log2 (Q16)
+ */
+static inline int32_t fx_db_to_log(float db)
+{
+    return (int32_t)lrintf(db / 6.0206f * FX_LOG_ONE);
+}
+
+/**
+ * @brief 按 RBJ 公式计算滤波器系数
+ *
+ * 用双精度计算：只在更新配置时执行一次。单精度的尾数只有 24 位，|系数| 接近 2 时
+ * 误差约为 Q28 的 64 LSB，低频高 Q 的极点离单位圆很近，会让中心频率和增益偏移零点几 dB
+ */
+static esp_err_t fx_design_biquad(const audio_fx_filter_t *f, uint32_t rate, fx_biquad_t *out)
+{
+    const double w0 = 2.0 * M_PI * f->freq_hz / (double)rate;
+    const double cw = cos(w0);
+    const double alpha = sin(w0) / (2.0 * f->q);
+    const double A = pow(10.0, f->gain_db / 40.0);
+    const double sa = 2.0 * sqrt(A) * alpha;
+    double b0, b1, b2, a0, a1, a2;
+
+    switch (f->type) {
+    case AUDIO_FX_FILTER_PEAK:
+        b0 = 1.0 + alpha * A;
+        b1 = -2.0 * cw;
+        b2 = 1.0 - alpha * A;
+        a0 = 1.0 + alpha / A;
+        a1 = -2.0 * cw;
+        a2 = 1.0 - alpha / A;
+        break;
+    case AUDIO_FX_FILTER_LOW_SHELF:
+        b0 = A * ((A + 1.0) - (A - 1.0) * cw + sa);
+        b1 = 2.0 * A * ((A - 1.0) - (A + 1.0) * cw);
+        b2 = A * ((A + 1.0) - (A - 1.0) * cw - sa);
+        a0 = (A + 1.0) + (A - 1.0) * cw + sa;
+        a1 = -2.0 * ((A - 1.0) + (A + 1.0) * cw);
+        a2 = (A + 1.0) + (A - 1.0) * cw - sa;
+        break;
+    case AUDIO_FX_FILTER_HIGH_SHELF:
+        b0 = A * ((A + 1.0) + (A - 1.0) * cw + sa);
+        b1 = -2.0 * A * ((A - 1.0) + (A + 1.0) * cw);
+        b2 = A * ((A + 1.0) + (A - 1.0) * cw - sa);
+        a0 = (A + 1.0) - (A - 1.0) * cw + sa;
+        a1 = 2.0 * ((A - 1.0) - (A + 1.0) * cw);
+        a2 = (A + 1.0) - (A - 1.0) * cw - sa;
+        break;
+    case AUDIO_FX_FILTER_HIGHPASS:
+        b0 = (1.0 + cw) / 2.0;
+        b1 = -(1.0 + cw);
+        b2 = (1.0 + cw) / 2.0;
+        a0 = 1.0 + alpha;
+        a1 = -2.0 * cw;
+        a2 = 1.0 - alpha;
+        break;
+    case AUDIO_FX_FILTER_LOWPASS:
+        b0 = (1.0 - cw) / 2.0;
+        b1 = 1.0 - cw;
+        b2 = (1.0 - cw) / 2.0;
+        a0 = 1.0 + alpha;
+        a1 = -2.0 * cw;
+        a2 = 1.0 - alpha;
+        break;
+    default:
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const double c[5] = { b0 / a0, b1 / a0, b2 / a0, a1 / a0, a2 / a0 };
+    // 只接受稳定的滤波器，64 位累加的余量依赖 |a1| < 2, |a2| < 1
+    if (!(fabs(c[3]) < 2.0 && fabs(c[4]) < 1.0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    int32_t q[5];
+    for (int i = 0; i < 5; i++) {
+        if (fabs(c[i]) >= 7.99) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        q[i] = (int32_t)lrint(c[i] * (double)(1 << FX_COEF_FRAC));
+    }
+    out->b0 = q[0];
+    out->b1 = q[1];
+    out->b2 = q[2];
+    out->a1 = q[3];
+    out->a2 = q[4];
+    return ESP_OK;
+}
+
+/**
+ * @brief 时间常数换算为每子块的一阶平滑系数 (Q15)
+ */
+static int32_t fx_smooth_coef(float ms, uint32_t rate)
+{
+    float block_ms = 1000.0f * AUDIO_FX_DRC_BLOCK_FRAMES / (float)rate;
+    float c = 1.0f - expf(-block_ms / ms);
+    int32_t q = (int32_t)lrintf(c * (1 << FX_COEF_Q15));
+    return (q < 1) ? 1 : q;
+}
+
+/**
+ * @brief 检查参数范围
+ */
+static bool fx_config_valid(const audio_fx_config_t *c, uint32_t rate)
+{
+    const float max_freq = (rate > 0) ? 0.45f * (float)rate : 20000.0f;
+    for (int i = 0; i < AUDIO_FX_MAX_FILTERS; i++) {
+        const audio_fx_filter_t *f = &c->filters[i];
+        if (f->type == AUDIO_FX_FILTER_OFF) {
+            continue;
+        }
+        if (f->type > AUDIO_FX_FILTER_LOWPASS || !(f->freq_hz >= 20.0f && f->freq_hz <= max_freq) ||
+            !(f->gain_db >= -24.0f && f->gain_db <= 12.0f) || !(f->q >= 0.3f && f->q <= 10.0f)) {
+            return false;
+        }
+    }
+
+    const audio_fx_drc_t *d = &c->drc;
+    return d->threshold_db >= -40.0f && d->threshold_db <= 0.0f &&
+           d->ratio >= 1.0f && d->ratio <= AUDIO_FX_DRC_LIMIT_RATIO &&
+           d->attack_ms >= 0.1f && d->attack_ms <= 100.0f &&
+           d->release_ms >= 10.0f && d->release_ms <= 2000.0f &&
+           d->lookahead_ms >= 0.0f && d->lookahead_ms <= 5.0f &&
+           d->makeup_db >= 0.0f && d->makeup_db <= 12.0f;
+}
+
+/**
+ * @brief 配置转换为定点参数
+ */
+static esp_err_t fx_compute_params(const audio_fx_config_t *c, uint32_t rate, fx_params_t *p)
+{
+    memset(p, 0, sizeof(*p));
+    p->enabled = c->enabled;
+
+    for (int i = 0; i < AUDIO_FX_MAX_FILTERS; i++) {
+        if (c->filters[i].type == AUDIO_FX_FILTER_OFF) {
+            continue;
+        }
+        esp_err_t ret = fx_design_biquad(&c->filters[i], rate, &p->biquads[p->num_biquads]);
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "滤波器 %d 系数超出范围", i);
+            return ret;
+        }
+        p->num_biquads++;
+    }
+
+    const audio_fx_drc_t *d = &c->drc;
+    p->drc_enabled = d->enabled;
+    p->threshold_log = fx_db_to_log(d->threshold_db);
+    p->slope_q16 = (d->ratio >= AUDIO_FX_DRC_LIMIT_RATIO) ? FX_LOG_ONE :
+                   (int32_t)lrintf((1.0f - 1.0f / d->ratio) * FX_LOG_ONE);
+    p->makeup_log = fx_db_to_log(d->makeup_db);
+    p->attack_q15 = fx_smooth_coef(d->attack_ms, rate);
+    p->release_q15 = fx_smooth_coef(d->release_ms, rate);
+
+    uint32_t frames = (uint32_t)lrintf(d->lookahead_ms * (float)rate / 1000.0f);
+    uint32_t blocks = (frames + AUDIO_FX_DRC_BLOCK_FRAMES / 2) / AUDIO_FX_DRC_BLOCK_FRAMES;
+    p->lookahead_blocks = (blocks > FX_MAX_LOOKAHEAD_BLOCKS) ? FX_MAX_LOOKAHEAD_BLOCKS : blocks;
+    return ESP_OK;
+}
+
+/**
+ * @brief 初始化效果链
+ */
+esp_err_t audio_fx_init(uint32_t sample_rate)
+{
+    if (sample_rate == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    for (int i = 0; i <= FX_LUT_SIZE; i++) {
+        log2_lut[i] = (int32_t)lrintf(log2f(1.0f + (float)i / FX_LUT_SIZE) * FX_LOG_ONE);
+        exp2_lut[i] = (uint32_t)lrint(exp2((double)i / FX_LUT_SIZE) * (double)(1 << 30));
+    }
+
+    audio_fx_config_t c;
+    portENTER_CRITICAL(&cfg_lock);
+    c = cfg;
+    portEXIT_CRITICAL(&cfg_lock);
+
+    fx_params_t p;
+    if (!fx_config_valid(&c, sample_rate) || fx_compute_params(&c, sample_rate, &p) != ESP_OK) {
+        ESP_LOGW(TAG, "配置无效，使用默认配置");
+        audio_fx_config_t def = AUDIO_FX_DEFAULT_CONFIG();
+        c = def;
+        fx_compute_params(&c, sample_rate, &p);
+    }
+
+    portENTER_CRITICAL(&cfg_lock);
+    cfg = c;
+    fx_rate = sample_rate;
+    params = p;
+    pending_ready = false;
+    portEXIT_CRITICAL(&cfg_lock);
+    audio_fx_reset();
+
+    ESP_LOGI(TAG, "效果链: %s, 滤波器 %d 级, 压缩 %s (阈值 %.1f dBFS, %.1f:1, 前瞻 %lu 帧)",
+             c.enabled ? "开" : "关", p.num_biquads, c.drc.enabled ? "开" : "关",
+             c.drc.threshold_db, c.drc.ratio,
+             (unsigned long)(p.lookahead_blocks * AUDIO_FX_DRC_BLOCK_FRAMES));
+    return ESP_OK;
+}
+
+/**
+ * @brief 设置配置
+ */
+esp_err_t audio_fx_set_config(const audio_fx_config_t *config)
+{
+    if (config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&cfg_lock);
+    uint32_t rate = fx_rate;
+    portEXIT_CRITICAL(&cfg_lock);
+
+    if (!fx_config_valid(config, rate)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // 未初始化时只保存配置，audio_fx_init() 再计算
+    fx_params_t p;
+    if (rate > 0 && fx_compute_params(config, rate, &p) != ESP_OK) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&cfg_lock);
+    cfg = *config;
+    if (rate > 0) {
+        pending = p;
+        pending_ready = true;
+    }
+    portEXIT_CRITICAL(&cfg_lock);
+    return ESP_OK;
+}
+
+/**
+ * @brief 获取配置
+ */
+void audio_fx_get_config(audio_fx_config_t *config)
+{
+    portENTER_CRITICAL(&cfg_lock);
+    *config = cfg;
+    portEXIT_CRITICAL(&cfg_lock);
+}
+
+/**
+ * @brief 清空内部状态
+ */
+void audio_fx_reset(void)
+{
+    memset(biquad_state, 0, sizeof(biquad_state));
+    memset(delay_buf, 0, sizeof(delay_buf));
+    memset(target_ring, 0, sizeof(target_ring));
+    delay_pos = 0;
+    target_pos = 0;
+    gain_log = 0;
+    gain_lin = fx_exp2(params.makeup_log);
+}
+
+/**
+ * @brief 双二阶滤波 (直接 I 型，交织立体声，原地处理)
+ *
+ * 输入需在 ±FX_CLAMP 内，输出同样限制在 ±FX_CLAMP，作为下一级的输入
+ */
+static void fx_biquad_process(int32_t *buf, size_t frames, const fx_biquad_t *c, int32_t st[2][4])
+{
+    const int64_t round = 1LL << (FX_COEF_FRAC - 1);
+
+    for (int ch = 0; ch < 2; ch++) {
+        int32_t x1 = st[ch][0], x2 = st[ch][1], y1 = st[ch][2], y2 = st[ch][3];
+        int32_t *p = buf + ch;
+        for (size_t i = 0; i < frames; i++, p += 2) {
+            int32_t x0 = *p;
+            int64_t acc = round + (int64_t)c->b0 * x0 + (int64_t)c->b1 * x1 + (int64_t)c->b2 * x2
+                          - (int64_t)c->a1 * y1 - (int64_t)c->a2 * y2;
+            acc >>= FX_COEF_FRAC;
+            if (acc > FX_CLAMP) {
+                acc = FX_CLAMP;
+            } else if (acc < -FX_CLAMP) {
+                acc = -FX_CLAMP;
+            }
+            int32_t y0 = (int32_t)acc;
+            x2 = x1;
+            x1 = x0;
+            y2 = y1;
+            y1 = y0;
+            *p = y0;
+        }
+        st[ch][0] = x1;
+        st[ch][1] = x2;
+        st[ch][2] = y1;
+        st[ch][3] = y2;
+    }
+}
+
+/**
+ * @brief 前瞻压缩 (交织立体声，原地处理，输出延迟 lookahead_blocks 个子块)
+ *
+ * @return int32_t 本次处理的最大压缩量 (log2, Q16)
+ */
+static int32_t fx_drc_process(int32_t *buf, size_t frames)
+{
+    int32_t max_reduction = 0;
+
+    const uint32_t delay_frames = params.lookahead_blocks * AUDIO_FX_DRC_BLOCK_FRAMES;
+    const uint32_t window = params.lookahead_blocks + 1;
+
+    for (size_t b = 0; b < frames; b += AUDIO_FX_DRC_BLOCK_FRAMES) {
+        int32_t *blk = buf + b * 2;
+
+        // 输入子块峰值 -> 目标增益
+        uint32_t peak = 0;
+        for (int i = 0; i < AUDIO_FX_DRC_BLOCK_FRAMES * 2; i++) {
+            int32_t v = blk[i];
+            uint32_t a = (v < 0) ? (uint32_t)0 - (uint32_t)v : (uint32_t)v;
+            if (a > peak) {
+                peak = a;
+            }
+        }
+        int32_t target = 0;
+        if (peak > 0) {
+            int32_t over = fx_log2(peak) - params.threshold_log;
+            if (over > 0) {
+                target = -(int32_t)(((int64_t)over * params.slope_q16) >> FX_LOG_FRAC);
+            }
+        }
+
+        // 目标增益环: target_ring[target_pos] 为即将输出的最早子块
+        target_ring[(target_pos + params.lookahead_blocks) % window] = target;
+        int32_t wmin = 0;
+        for (uint32_t i = 0; i < window; i++) {
+            if (target_ring[i] < wmin) {
+                wmin = target_ring[i];
+            }
+        }
+        // 增益从上一子块插值到本子块，两端都不高于本子块目标，整个子块内即不超限；
+        // 因此本子块结束增益同时不高于下一个输出子块的目标
+        int32_t out_target = target_ring[target_pos];
+        target_pos = (target_pos + 1) % window;
+        const int32_t next_target = target_ring[target_pos];
+        if (next_target < out_target) {
+            out_target = next_target;
+        }
+
+        // 平滑，且不高于上述目标
+        int32_t coef = (wmin < gain_log) ? params.attack_q15 : params.release_q15;
+        gain_log += (int32_t)(((int64_t)(wmin - gain_log) * coef) >> FX_COEF_Q15);
+        int32_t g = (gain_log < out_target) ? gain_log : out_target;
+
+        // 线性增益在子块内插值
+        const int32_t g0 = gain_lin;
+        const int32_t g1 = fx_exp2(g + params.makeup_log);
+        const int32_t dg = (g1 - g0) / AUDIO_FX_DRC_BLOCK_FRAMES;
+        int32_t gl = g0;
+        for (int i = 0; i < AUDIO_FX_DRC_BLOCK_FRAMES; i++) {
+            gl += dg;
+            for (int ch = 0; ch < 2; ch++) {
+                int32_t in = blk[i * 2 + ch];
+                int32_t out = in;
+                if (delay_frames > 0) {
+                    int32_t *slot = &delay_buf[delay_pos * 2 + ch];
+                    out = *slot;
+                    *slot = in;
+                }
+                // 补偿增益最高 +12 dB，结果可能超出 int32，限制在 ±FX_CLAMP
+                int64_t y = ((int64_t)out * gl) >> FX_GAIN_FRAC;
+                if (y > FX_CLAMP) {
+                    y = FX_CLAMP;
+                } else if (y < -FX_CLAMP) {
+                    y = -FX_CLAMP;
+                }
+                blk[i * 2 + ch] = (int32_t)y;
+            }
+            if (delay_frames > 0 && ++delay_pos >= delay_frames) {
+                delay_pos = 0;
+            }
+        }
+        gain_lin = g1;
+
+        if (-g > max_reduction) {
+            max_reduction = -g;
+        }
+    }
+    return max_reduction;
+}
+
+/**
+ * @brief 处理一块混音结果
+ */
+bool audio_fx_process(int32_t *buf, size_t frames)
+{
+    // 取用新配置 (前瞻长度变化时清空延迟线)
+    if (pending_ready) {
+        portENTER_CRITICAL(&cfg_lock);
+        bool relayout = (pending.lookahead_blocks != params.lookahead_blocks ||
+                         pending.enabled != params.enabled || pending.drc_enabled != params.drc_enabled);
+        params = pending;
+        pending_ready = false;
+        portEXIT_CRITICAL(&cfg_lock);
+        if (relayout) {
+            audio_fx_reset();
+        }
+    }
+
+    if (!params.enabled || (params.num_biquads == 0 && !params.drc_enabled)) {
+        return false;
+    }
+
+    int64_t t0 = esp_timer_get_time();
+
+    // 混音结果未饱和：先限制在 ±FX_IN_CLAMP (满幅的 8 倍) 再转换为 Q4.27
+    for (size_t i = 0; i < frames * 2; i++) {
+        int32_t v = buf[i];
+        if (v > FX_IN_CLAMP) {
+            v = FX_IN_CLAMP;
+        } else if (v < -FX_IN_CLAMP) {
+            v = -FX_IN_CLAMP;
+        }
+        buf[i] = v * (1 << FX_SHIFT);
+    }
+    for (int s = 0; s < params.num_biquads; s++) {
+        fx_biquad_process(buf, frames, &params.biquads[s], biquad_state[s]);
+    }
+    int32_t reduction = 0;
+    if (params.drc_enabled) {
+        reduction = fx_drc_process(buf, frames);
+    }
+    const int32_t round = 1 << (FX_SHIFT - 1);
+    for (size_t i = 0; i < frames * 2; i++) {
+        buf[i] = (buf[i] + round) >> FX_SHIFT;
+    }
+
+    int64_t elapsed = esp_timer_get_time() - t0;
+    portENTER_CRITICAL(&stats_lock);
+    fx_us += elapsed;
+    fx_frames += frames;
+    cur_reduction_log = -gain_log;
+    if (reduction > max_reduction_log) {
+        max_reduction_log = reduction;
+    }
+    portEXIT_CRITICAL(&stats_lock);
+
+    return params.drc_enabled && params.lookahead_blocks > 0;
+}
+
+/**
+ * @brief 获取统计
+ */
+void audio_fx_get_stats(audio_fx_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+
+    portENTER_CRITICAL(&stats_lock);
+    stats->fx_us_per_s = (fx_frames > 0 && fx_rate > 0) ?
+        (uint32_t)((uint64_t)fx_us * fx_rate / fx_frames) : 0;
+    stats->gain_reduction_db = cur_reduction_log * 6.0206f / FX_LOG_ONE;
+    stats->max_reduction_db = max_reduction_log * 6.0206f / FX_LOG_ONE;
+    max_reduction_log = 0;
+    portEXIT_CRITICAL(&stats_lock);
+
+    stats->active_filters = params.enabled ? params.num_biquads : 0;
+}
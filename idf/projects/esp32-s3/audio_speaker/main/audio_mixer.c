@@ -0,0 +1,558 @@
+/**
+ * @file audio_mixer.c
+ * @brief 多路音频混音器实现
+ *
+ * 环形缓冲区以采样为单位，读写位置为自由递增的 32 位计数 (按 2 的幂掩码取下标)，
+ * 生产者只写 head、混音任务只写 tail，用 acquire/release 原子操作同步，无需加锁。
+ * 缓冲区满时生产者在音源的信号量上等待，混音任务消耗数据后释放。
+ *
+ * 每路音源在缓冲满一个混音块后才开始参与混音 (预缓冲)，数据流进行中不足一块
+ * 计为一次欠载并重新预缓冲，drain 之后的尾部数据直接输出。
+ *
+ * 输出链: 累加 -> 总增益 -> 效果链 (均衡/压缩, audio_fx) -> 软限幅 -> I2S。
+ * 效果链的前瞻延迟在数据流结束后再输出一个静音块冲出。
+ */
+
+#include "include/audio_mixer.h"
+#include "include/audio_player.h"
+#include "include/audio_dsp.h"
+#include "include/audio_fx.h"
+#include <string.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+static const char *TAG = "audio_mixer";
+
+// 混音任务栈大小
+#define MIXER_TASK_STACK    4096
+
+// I2S 写入失败后的重试间隔
+#define MIXER_RETRY_MS      10
+
+/**
+ * @brief 音源
+ */
+struct audio_mixer_source {
+    atomic_bool used;                // 已注册 (最后置位，混音任务据此访问)
+    const char *name;
+    uint8_t channels;
+    volatile int16_t gain_q15;
+    bool duckable;
+    bool ducks_others;
+
+    // 无锁环形缓冲区 (采样)
+    int16_t *buf;
+    uint32_t size;                   // 容量 (采样，2 的幂)
+    uint32_t mask;
+    atomic_uint_fast32_t head;       // 生产者写入位置
+    atomic_uint_fast32_t tail;       // 混音任务读取位置
+
+    // 生产者等待
+    SemaphoreHandle_t space_sem;
+    atomic_bool waiting;
+
+    // 数据流状态
+    atomic_bool open;                // 生产者写入后置位，drain 时清除
+    bool playing;                    // 已预缓冲，参与混音 (混音任务)
+    bool active;                     // 上一块是否有数据 (统计)
+    uint32_t underruns;
+};
+
+static struct audio_mixer_source s_sources[AUDIO_MIXER_MAX_SOURCES];
+
+// 配置与任务
+static audio_mixer_config_t cfg;
+static TaskHandle_t mixer_task = NULL;
+static volatile int16_t master_gain_q15 = AUDIO_DSP_Q15_ONE;
+
+// 混音缓冲区
+static int32_t acc_buf[AUDIO_MIXER_BLOCK_FRAMES * 2];
+static int16_t *out_buf = NULL;
+
+// 闪避
+static int32_t duck_gain = AUDIO_DSP_Q15_ONE;
+static int32_t duck_attack_step = 0;
+static int32_t duck_release_step = 0;
+
+// 效果链延迟中是否还有数据
+static bool fx_tail = false;
+
+// 统计
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static int64_t mix_us = 0;
+static uint64_t mixed_frames = 0;
+static uint32_t limited_samples = 0;
+
+/**
+ * @brief 缓冲区中可读采样数
+ */
+static inline uint32_t mixer_ring_avail(struct audio_mixer_source *src)
+{
+    uint32_t head = atomic_load_explicit(&src->head, memory_order_acquire);
+    uint32_t tail = atomic_load_explicit(&src->tail, memory_order_relaxed);
+    return head - tail;
+}
+
+/**
+ * @brief 软限幅：阈值以下线性，以上平滑压缩并渐近满幅
+ */
+static inline int16_t mixer_soft_limit(int32_t x, int32_t threshold, bool *limited)
+{
+    int32_t a = (x < 0) ? -x : x;
+    if (a <= threshold) {
+        return (int16_t)x;
+    }
+
+    const int32_t range = INT16_MAX - threshold;
+    int32_t excess = a - threshold;
+    int32_t y = threshold + (int32_t)(((int64_t)excess * range) / (excess + range));
+    *limited = true;
+    return (int16_t)((x < 0) ? -y : y);
+}
+
+/**
+ * @brief 将一路音源的 frames 帧累加到 acc_buf (增益从 g0 线性过渡到 g1)
+ */
+static void mixer_accumulate(struct audio_mixer_source *src, uint32_t frames, int32_t g0, int32_t g1)
+{
+    uint32_t tail = atomic_load_explicit(&src->tail, memory_order_relaxed);
+    const uint32_t mask = src->mask;
+    const int16_t *buf = src->buf;
+
+    // 增益按帧线性插值 (Q8 小数)
+    int32_t g_q8 = g0 * 256;
+    const int32_t dg_q8 = (g1 - g0) * 256 / AUDIO_MIXER_BLOCK_FRAMES;
+
+    if (src->channels == 1) {
+        for (uint32_t i = 0; i < frames; i++) {
+            int32_t v = (buf[(tail + i) & mask] * (g_q8 >> 8)) >> 15;
+            acc_buf[i * 2] += v;
+            acc_buf[i * 2 + 1] += v;
+            g_q8 += dg_q8;
+        }
+    } else {
+        for (uint32_t i = 0; i < frames; i++) {
+            int32_t g = g_q8 >> 8;
+            acc_buf[i * 2] += (buf[(tail + i * 2) & mask] * g) >> 15;
+            acc_buf[i * 2 + 1] += (buf[(tail + i * 2 + 1) & mask] * g) >> 15;
+            g_q8 += dg_q8;
+        }
+    }
+
+    atomic_store_explicit(&src->tail, tail + frames * src->channels, memory_order_release);
+    if (atomic_load(&src->waiting)) {
+        xSemaphoreGive(src->space_sem);
+    }
+}
+
+/**
+ * @brief 混音任务
+ */
+static void mixer_task_fn(void *pvParameters)
+{
+    const uint32_t block = AUDIO_MIXER_BLOCK_FRAMES;
+    uint32_t frames_of[AUDIO_MIXER_MAX_SOURCES];
+
+    while (1) {
+        int64_t t0 = esp_timer_get_time();
+        bool any = false;
+        bool alert = false;
+
+        // 第一遍：决定本块参与混音的音源和帧数
+        for (int s = 0; s < AUDIO_MIXER_MAX_SOURCES; s++) {
+            struct audio_mixer_source *src = &s_sources[s];
+            frames_of[s] = 0;
+            if (!atomic_load(&src->used)) {
+                continue;
+            }
+
+            uint32_t avail = mixer_ring_avail(src) / src->channels;
+            bool open = atomic_load(&src->open);
+
+            if (!src->playing) {
+                // 预缓冲：满一个块，或数据流已结束 (尾部数据)
+                if (avail >= block || (!open && avail > 0)) {
+                    src->playing = true;
+                } else {
+                    src->active = false;
+                    continue;
+                }
+            }
+
+            if (avail < block && open) {
+                // 数据流进行中缓冲不足：欠载，重新预缓冲
+                portENTER_CRITICAL(&stats_lock);
+                src->underruns++;
+                portEXIT_CRITICAL(&stats_lock);
+                ESP_LOGD(TAG, "音源 %s 欠载 (%lu 帧)", src->name, (unsigned long)avail);
+                src->playing = false;
+            }
+            if (avail == 0) {
+                src->playing = false;
+                src->active = false;
+                continue;
+            }
+
+            frames_of[s] = (avail < block) ? avail : block;
+            src->active = true;
+            any = true;
+            if (src->ducks_others) {
+                alert = true;
+            }
+        }
+
+        if (!any && !fx_tail) {
+            // 没有可混音的数据：等待生产者写入 (I2S 自动输出静音)
+            duck_gain = AUDIO_DSP_Q15_ONE;
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+
+        // 闪避增益向目标移动一个块的步长
+        int32_t duck_prev = duck_gain;
+        if (alert) {
+            duck_gain -= duck_attack_step;
+            if (duck_gain < cfg.duck_gain_q15) {
+                duck_gain = cfg.duck_gain_q15;
+            }
+        } else {
+            duck_gain += duck_release_step;
+            if (duck_gain > AUDIO_DSP_Q15_ONE) {
+                duck_gain = AUDIO_DSP_Q15_ONE;
+            }
+        }
+
+        // 第二遍：32 位累加
+        memset(acc_buf, 0, sizeof(acc_buf));
+        for (int s = 0; s < AUDIO_MIXER_MAX_SOURCES; s++) {
+            if (frames_of[s] == 0) {
+                continue;
+            }
+            struct audio_mixer_source *src = &s_sources[s];
+            int32_t g = src->gain_q15;
+            int32_t g0 = g;
+            int32_t g1 = g;
+            if (src->duckable) {
+                g0 = (g * duck_prev) >> 15;
+                g1 = (g * duck_gain) >> 15;
+            }
+            mixer_accumulate(src, frames_of[s], g0, g1);
+        }
+
+        // 总增益
+        const int32_t master = master_gain_q15;
+        if (master < AUDIO_DSP_Q15_ONE) {
+            for (uint32_t i = 0; i < block * 2; i++) {
+                acc_buf[i] = (int32_t)(((int64_t)acc_buf[i] * master) >> 15);
+            }
+        }
+
+        // 效果链 (没有音源时这一块为静音，用于冲出前瞻延迟)
+        bool tail = audio_fx_process(acc_buf, block);
+        fx_tail = any && tail;
+
+        // 软限幅
+        const int32_t threshold = cfg.limiter_threshold;
+        uint32_t limited = 0;
+        for (uint32_t i = 0; i < block * 2; i++) {
+            bool hit = false;
+            out_buf[i] = mixer_soft_limit(acc_buf[i], threshold, &hit);
+            limited += hit;
+        }
+
+        int64_t elapsed = esp_timer_get_time() - t0;
+        portENTER_CRITICAL(&stats_lock);
+        mix_us += elapsed;
+        mixed_frames += block;
+        limited_samples += limited;
+        portEXIT_CRITICAL(&stats_lock);
+
+        // 写入 I2S (DMA 缓冲区满时阻塞，以此控制混音节奏)
+        if (audio_player_write_i2s(out_buf, block * 2 * sizeof(int16_t), portMAX_DELAY) != ESP_OK) {
+            vTaskDelay(pdMS_TO_TICKS(MIXER_RETRY_MS));
+        }
+    }
+}
+
+/**
+ * @brief 初始化混音器
+ */
+esp_err_t audio_mixer_init(const audio_mixer_config_t *config)
+{
+    if (mixer_task != NULL) {
+        return ESP_OK;
+    }
+
+    if (config != NULL) {
+        cfg = *config;
+    } else {
+        audio_mixer_config_t def = AUDIO_MIXER_DEFAULT_CONFIG();
+        cfg = def;
+    }
+    if (cfg.limiter_threshold <= 0) {
+        cfg.limiter_threshold = INT16_MAX;
+    }
+
+    out_buf = heap_caps_aligned_alloc(AUDIO_DSP_ALIGN, AUDIO_MIXER_BLOCK_FRAMES * 2 * sizeof(int16_t),
+                                      MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    if (out_buf == NULL) {
+        ESP_LOGE(TAG, "混音缓冲区分配失败");
+        return ESP_ERR_NO_MEM;
+    }
+
+    // 闪避步长 (每块)
+    uint32_t rate = audio_player_get_sample_rate();
+    uint32_t attack_blocks = (uint32_t)((uint64_t)cfg.duck_attack_ms * rate / 1000 / AUDIO_MIXER_BLOCK_FRAMES);
+    uint32_t release_blocks = (uint32_t)((uint64_t)cfg.duck_release_ms * rate / 1000 / AUDIO_MIXER_BLOCK_FRAMES);
+    int32_t range = AUDIO_DSP_Q15_ONE - cfg.duck_gain_q15;
+    duck_attack_step = range / (int32_t)(attack_blocks > 0 ? attack_blocks : 1);
+    duck_release_step = range / (int32_t)(release_blocks > 0 ? release_blocks : 1);
+    duck_gain = AUDIO_DSP_Q15_ONE;
+
+    esp_err_t ret = audio_fx_init(rate);
+    if (ret != ESP_OK) {
+        heap_caps_free(out_buf);
+        out_buf = NULL;
+        return ret;
+    }
+
+    BaseType_t ok = xTaskCreatePinnedToCore(mixer_task_fn, "audio_mixer", MIXER_TASK_STACK, NULL,
+                                            cfg.task_priority, &mixer_task, cfg.task_core);
+    if (ok != pdPASS) {
+        heap_caps_free(out_buf);
+        out_buf = NULL;
+        mixer_task = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "混音器初始化完成 (块 %d 帧, 闪避 %d/32767, 限幅阈值 %d)",
+             AUDIO_MIXER_BLOCK_FRAMES, cfg.duck_gain_q15, cfg.limiter_threshold);
+    return ESP_OK;
+}
+
+/**
+ * @brief 注册音源
+ */
+esp_err_t audio_mixer_add_source(const audio_mixer_source_config_t *config, audio_mixer_source_t *out)
+{
+    if (config == NULL || out == NULL || (config->channels != 1 && config->channels != 2) ||
+        config->ring_frames < AUDIO_MIXER_BLOCK_FRAMES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (mixer_task == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    struct audio_mixer_source *src = NULL;
+    for (int s = 0; s < AUDIO_MIXER_MAX_SOURCES; s++) {
+        if (!atomic_load(&s_sources[s].used) && s_sources[s].buf == NULL) {
+            src = &s_sources[s];
+            break;
+        }
+    }
+    if (src == NULL) {
+        ESP_LOGE(TAG, "音源数量已达上限");
+        return ESP_ERR_NO_MEM;
+    }
+
+    uint32_t size = 1;
+    while (size < config->ring_frames * config->channels) {
+        size <<= 1;
+    }
+
+    src->buf = heap_caps_malloc(size * sizeof(int16_t), MALLOC_CAP_INTERNAL);
+    src->space_sem = xSemaphoreCreateBinary();
+    if (src->buf == NULL || src->space_sem == NULL) {
+        ESP_LOGE(TAG, "音源 %s 内存分配失败", config->name);
+        heap_caps_free(src->buf);
+        if (src->space_sem != NULL) {
+            vSemaphoreDelete(src->space_sem);
+        }
+        src->buf = NULL;
+        src->space_sem = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    src->name = config->name;
+    src->channels = config->channels;
+    src->gain_q15 = config->gain_q15;
+    src->duckable = config->duckable;
+    src->ducks_others = config->ducks_others;
+    src->size = size;
+    src->mask = size - 1;
+    atomic_init(&src->head, 0);
+    atomic_init(&src->tail, 0);
+    atomic_init(&src->waiting, false);
+    atomic_init(&src->open, false);
+    src->playing = false;
+    src->active = false;
+    src->underruns = 0;
+    atomic_store(&src->used, true);
+
+    ESP_LOGI(TAG, "注册音源 %s (%u 声道, 缓冲 %lu 帧)",
+             src->name, src->channels, (unsigned long)(size / src->channels));
+    *out = src;
+    return ESP_OK;
+}
+
+/**
+ * @brief 等待音源缓冲区状态变化 (混音任务消耗数据后唤醒)
+ *
+ * @return false 超时
+ */
+static bool mixer_wait_space(struct audio_mixer_source *src, TickType_t start, TickType_t timeout,
+                             bool (*ready)(struct audio_mixer_source *))
+{
+    atomic_store(&src->waiting, true);
+    // 置位后再检查一次，避免错过混音任务的唤醒
+    if (ready(src)) {
+        atomic_store(&src->waiting, false);
+        return true;
+    }
+
+    TickType_t elapsed = xTaskGetTickCount() - start;
+    bool ok = (elapsed < timeout) && xSemaphoreTake(src->space_sem, timeout - elapsed) == pdTRUE;
+    atomic_store(&src->waiting, false);
+    return ok || ready(src);
+}
+
+static bool mixer_has_space(struct audio_mixer_source *src)
+{
+    return src->size - mixer_ring_avail(src) >= src->channels;
+}
+
+static bool mixer_is_empty(struct audio_mixer_source *src)
+{
+    return mixer_ring_avail(src) == 0;
+}
+
+/**
+ * @brief 写入 PCM
+ */
+size_t audio_mixer_write(audio_mixer_source_t src, const int16_t *pcm, size_t bytes, uint32_t wait_ms)
+{
+    if (src == NULL || pcm == NULL) {
+        return 0;
+    }
+
+    const uint32_t ch = src->channels;
+    size_t remaining = bytes / (ch * sizeof(int16_t)) * ch;    // 只写完整的帧
+    size_t written = 0;
+    TickType_t start = xTaskGetTickCount();
+    TickType_t timeout = pdMS_TO_TICKS(wait_ms);
+
+    atomic_store(&src->open, true);
+
+    while (remaining > 0) {
+        uint32_t head = atomic_load_explicit(&src->head, memory_order_relaxed);
+        uint32_t space = src->size - mixer_ring_avail(src);
+        space -= space % ch;
+
+        if (space == 0) {
+            if (!mixer_wait_space(src, start, timeout, mixer_has_space)) {
+                break;
+            }
+            continue;
+        }
+
+        uint32_t n = (remaining < space) ? remaining : space;
+        uint32_t idx = head & src->mask;
+        uint32_t first = src->size - idx;
+        if (first > n) {
+            first = n;
+        }
+        memcpy(src->buf + idx, pcm, first * sizeof(int16_t));
+        memcpy(src->buf, pcm + first, (n - first) * sizeof(int16_t));
+        atomic_store_explicit(&src->head, head + n, memory_order_release);
+
+        pcm += n;
+        remaining -= n;
+        written += n;
+
+        xTaskNotifyGive(mixer_task);
+    }
+
+    return written * sizeof(int16_t);
+}
+
+/**
+ * @brief 结束数据流并等待输出完毕
+ */
+esp_err_t audio_mixer_drain(audio_mixer_source_t src, uint32_t wait_ms)
+{
+    if (src == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    atomic_store(&src->open, false);
+    xTaskNotifyGive(mixer_task);
+
+    TickType_t start = xTaskGetTickCount();
+    while (!mixer_is_empty(src)) {
+        if (!mixer_wait_space(src, start, pdMS_TO_TICKS(wait_ms), mixer_is_empty)) {
+            return ESP_ERR_TIMEOUT;
+        }
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief 获取音源缓冲帧数
+ */
+size_t audio_mixer_get_fill(audio_mixer_source_t src)
+{
+    if (src == NULL) {
+        return 0;
+    }
+    return mixer_ring_avail(src) / src->channels;
+}
+
+/**
+ * @brief 设置音源增益
+ */
+void audio_mixer_set_gain(audio_mixer_source_t src, int16_t gain_q15)
+{
+    if (src != NULL) {
+        src->gain_q15 = gain_q15;
+    }
+}
+
+/**
+ * @brief 设置总增益
+ */
+void audio_mixer_set_master_gain(int16_t gain_q15)
+{
+    master_gain_q15 = gain_q15;
+}
+
+/**
+ * @brief 获取混音器统计
+ */
+void audio_mixer_get_stats(audio_mixer_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+
+    portENTER_CRITICAL(&stats_lock);
+    stats->mix_us_per_s = (mixed_frames > 0) ?
+        (uint32_t)((uint64_t)mix_us * audio_player_get_sample_rate() / mixed_frames) : 0;
+    stats->limited_samples = limited_samples;
+    stats->duck_gain_q15 = (int16_t)duck_gain;
+    for (int s = 0; s < AUDIO_MIXER_MAX_SOURCES; s++) {
+        struct audio_mixer_source *src = &s_sources[s];
+        if (!atomic_load(&src->used)) {
+            continue;
+        }
+        audio_mixer_source_stats_t *out = &stats->sources[stats->num_sources++];
+        out->name = src->name;
+        out->capacity_frames = src->size / src->channels;
+        out->fill_frames = mixer_ring_avail(src) / src->channels;
+        out->underruns = src->underruns;
+        out->active = src->active;
+    }
+    portEXIT_CRITICAL(&stats_lock);
+}
@@ -0,0 +1,535 @@
+/**
+ * @file audio_pipeline.c
+ * @brief 网络下载与 I2S 播放解耦的音频管道实现
+ *
+ * 单生产者/单消费者：生产者通过 audio_pipeline_write() 阻塞写入流缓冲区，
+ * 播放任务以非阻塞方式读取，等待统一使用任务通知，因此可以安全地复位缓冲区。
+ */
+
+#include "include/audio_pipeline.h"
+#include "include/audio_player.h"
+#include "include/audio_dsp.h"
+#include "include/audio_resampler.h"
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "freertos/stream_buffer.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+static const char *TAG = "audio_pipeline";
+
+// 事件位
+#define PIPELINE_RESUME_BIT   BIT0    // 缓冲区低于低水位，生产者可继续写入
+#define PIPELINE_DONE_BIT     BIT1    // 数据流已播放完毕或已中止
+
+// 未播放时的轮询间隔
+#define PIPELINE_WAIT_MS      20
+
+// 数据流结束时等待混音器输出的最长时间
+#define PIPELINE_DRAIN_MS     500
+
+// 采样率转换输出块大小 (帧)
+#define PIPELINE_RESAMPLE_FRAMES  1024
+
+// 环形缓冲区
+static StreamBufferHandle_t ring = NULL;
+static StaticStreamBuffer_t ring_struct;
+static uint8_t *ring_storage = NULL;
+static size_t ring_size = 0;
+static bool ring_in_psram = false;
+
+// 播放任务与同步
+static TaskHandle_t playback_task = NULL;
+static EventGroupHandle_t events = NULL;
+static uint8_t *chunk_buf = NULL;
+
+// 采样率转换
+static audio_resampler_t resampler;
+static int16_t *resample_buf = NULL;
+static int64_t resample_us = 0;
+static uint64_t resample_out_frames = 0;
+
+// 配置
+static audio_pipeline_config_t cfg;
+
+// 当前数据流
+static volatile audio_pipeline_state_t state = AUDIO_PIPELINE_STATE_IDLE;
+static volatile bool active = false;
+static volatile bool eof = false;
+static volatile bool aborting = false;
+static uint8_t stream_channels = 2;
+static size_t frame_bytes = 4;
+static uint32_t byte_rate = AUDIO_SAMPLE_RATE * 4;
+static size_t prebuffer_bytes = 0;
+static size_t high_bytes = 0;
+static size_t low_bytes = 0;
+static uint32_t fade_frames = 0;
+static int64_t begin_time_us = 0;
+static bool first_output = false;
+
+// 遥测
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static audio_pipeline_stats_t stats;
+
+/**
+ * @brief 结束当前数据流 (播放任务调用)
+ */
+static void pipeline_finish_stream(void)
+{
+    // 等待混音器主音源输出完毕，之后缓冲为空不再计为欠载
+    if (audio_player_drain(PIPELINE_DRAIN_MS) != ESP_OK) {
+        ESP_LOGW(TAG, "等待混音器输出超时");
+    }
+    state = AUDIO_PIPELINE_STATE_IDLE;
+    active = false;
+    aborting = false;
+    xEventGroupSetBits(events, PIPELINE_DONE_BIT | PIPELINE_RESUME_BIT);
+}
+
+/**
+ * @brief 更新最低缓冲统计
+ */
+static void pipeline_track_fill(size_t fill)
+{
+    portENTER_CRITICAL(&stats_lock);
+    if (fill < stats.min_fill_bytes) {
+        stats.min_fill_bytes = fill;
+    }
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+/**
+ * @brief 写入播放器 (固定输出采样率)
+ */
+static void pipeline_play(int16_t *pcm, size_t bytes)
+{
+    if (stream_channels == 1) {
+        audio_player_play(pcm, bytes, 1000);
+    } else {
+        audio_player_play_stereo(pcm, bytes, 1000);
+    }
+}
+
+/**
+ * @brief 输出一块 PCM 数据 (必要时先转换采样率)
+ */
+static void pipeline_output(int16_t *pcm, size_t bytes)
+{
+    if (resampler.passthrough) {
+        pipeline_play(pcm, bytes);
+    } else {
+        size_t frames = bytes / frame_bytes;
+        const int16_t *in = pcm;
+
+        while (frames > 0) {
+            size_t used = 0;
+            int64_t t0 = esp_timer_get_time();
+            size_t out = audio_resampler_process(&resampler, in, frames, &used, resample_buf, PIPELINE_RESAMPLE_FRAMES);
+            resample_us += esp_timer_get_time() - t0;
+            resample_out_frames += out;
+
+            if (out > 0) {
+                pipeline_play(resample_buf, out * frame_bytes);
+            }
+            if (out == 0 && used == 0) {
+                // 转换器没有进展：丢弃本块剩余数据并计入遥测，避免死循环
+                ESP_LOGE(TAG, "采样率转换无进展，丢弃 %u 帧", (unsigned)frames);
+                portENTER_CRITICAL(&stats_lock);
+                stats.resample_dropped_frames += frames;
+                portEXIT_CRITICAL(&stats_lock);
+                bytes -= frames * frame_bytes;
+                break;
+            }
+            in += used * stream_channels;
+            frames -= used;
+        }
+    }
+
+    portENTER_CRITICAL(&stats_lock);
+    stats.bytes_played += bytes;
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+/**
+ * @brief 记录本次播放首个 PCM 的输出时间
+ */
+static void pipeline_mark_start(void)
+{
+    if (!first_output) {
+        return;
+    }
+    first_output = false;
+
+    uint32_t elapsed = (uint32_t)(esp_timer_get_time() - begin_time_us);
+    portENTER_CRITICAL(&stats_lock);
+    stats.start_us = elapsed > 0 ? elapsed : 1;
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+/**
+ * @brief 播放任务：从环形缓冲区取数据写入 I2S
+ */
+static void pipeline_playback_task(void *pvParameters)
+{
+    size_t carry = 0;           // 上一块中不足一帧的残余字节
+    uint32_t fade_in_pos = 0;   // 已淡入帧数
+
+    while (1) {
+        if (!active) {
+            carry = 0;
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+
+        // 中止：丢弃全部缓冲数据
+        if (aborting) {
+            while (xStreamBufferReceive(ring, chunk_buf, AUDIO_PIPELINE_CHUNK_BYTES, 0) > 0) {
+            }
+            carry = 0;
+            pipeline_finish_stream();
+            ESP_LOGI(TAG, "数据流已中止");
+            continue;
+        }
+
+        size_t avail = xStreamBufferBytesAvailable(ring);
+
+        // 预缓冲 / 欠载恢复
+        if (state == AUDIO_PIPELINE_STATE_PREBUFFERING || state == AUDIO_PIPELINE_STATE_UNDERRUN) {
+            if (avail < prebuffer_bytes && !eof) {
+                ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(PIPELINE_WAIT_MS));
+                continue;
+            }
+            if (state == AUDIO_PIPELINE_STATE_UNDERRUN) {
+                ESP_LOGI(TAG, "缓冲恢复 (%u 字节)，继续播放", (unsigned)avail);
+            }
+            state = eof ? AUDIO_PIPELINE_STATE_DRAINING : AUDIO_PIPELINE_STATE_PLAYING;
+            fade_in_pos = 0;
+        }
+
+        if (eof && state == AUDIO_PIPELINE_STATE_PLAYING) {
+            state = AUDIO_PIPELINE_STATE_DRAINING;
+        }
+
+        // 数据不足一整块且生产者未结束：即将欠载
+        bool starving = (state == AUDIO_PIPELINE_STATE_PLAYING && avail < AUDIO_PIPELINE_CHUNK_BYTES);
+
+        size_t got = xStreamBufferReceive(ring, chunk_buf + carry, AUDIO_PIPELINE_CHUNK_BYTES - carry, 0);
+        size_t total = carry + got;
+        size_t frames = total / frame_bytes;
+        size_t play_bytes = frames * frame_bytes;
+
+        if (state == AUDIO_PIPELINE_STATE_DRAINING && got == 0) {
+            // 数据全部播放完毕 (不足一帧的残余直接丢弃)
+            carry = 0;
+            pipeline_finish_stream();
+            continue;
+        }
+
+        int16_t *pcm = (int16_t *)chunk_buf;
+
+        // 开始或恢复播放时淡入
+        if (fade_in_pos < fade_frames && frames > 0) {
+            size_t n = frames < (fade_frames - fade_in_pos) ? frames : (fade_frames - fade_in_pos);
+            int16_t gain_from = (int16_t)((int32_t)fade_in_pos * AUDIO_DSP_Q15_ONE / fade_frames);
+            int16_t gain_to = (int16_t)((int32_t)(fade_in_pos + n) * AUDIO_DSP_Q15_ONE / fade_frames);
+            audio_dsp_ramp_q15(pcm, n, stream_channels, gain_from, gain_to);
+            fade_in_pos += n;
+        }
+
+        // 欠载：淡出剩余数据的末尾，进入等待重新缓冲状态
+        if (starving) {
+            size_t n = frames < fade_frames ? frames : fade_frames;
+            audio_dsp_ramp_q15(pcm + (frames - n) * stream_channels, n, stream_channels, AUDIO_DSP_Q15_ONE, 0);
+            state = AUDIO_PIPELINE_STATE_UNDERRUN;
+
+            portENTER_CRITICAL(&stats_lock);
+            stats.underruns++;
+            stats.total_underruns++;
+            portEXIT_CRITICAL(&stats_lock);
+            ESP_LOGW(TAG, "缓冲欠载 (剩余 %u 字节)，暂停播放", (unsigned)total);
+        }
+
+        if (play_bytes > 0) {
+            pipeline_mark_start();
+            pipeline_output(pcm, play_bytes);
+        }
+
+        carry = total - play_bytes;
+        if (carry > 0) {
+            memmove(chunk_buf, chunk_buf + play_bytes, carry);
+        }
+
+        // 低于低水位时唤醒生产者
+        size_t fill = xStreamBufferBytesAvailable(ring);
+        if (fill <= low_bytes) {
+            xEventGroupSetBits(events, PIPELINE_RESUME_BIT);
+        }
+        if (state == AUDIO_PIPELINE_STATE_PLAYING) {
+            pipeline_track_fill(fill);
+        }
+    }
+}
+
+/**
+ * @brief 初始化音频管道
+ */
+esp_err_t audio_pipeline_init(const audio_pipeline_config_t *config)
+{
+    if (ring != NULL) {
+        return ESP_OK;
+    }
+
+    if (config != NULL) {
+        cfg = *config;
+    } else {
+        audio_pipeline_config_t def = AUDIO_PIPELINE_DEFAULT_CONFIG();
+        cfg = def;
+    }
+
+    if (cfg.low_watermark_pct >= cfg.high_watermark_pct || cfg.high_watermark_pct > 100) {
+        ESP_LOGE(TAG, "水位配置无效: 低 %u%%, 高 %u%%", cfg.low_watermark_pct, cfg.high_watermark_pct);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // 环形缓冲区优先放在 PSRAM，流缓冲区需要额外 1 字节
+    ring_size = cfg.ring_size;
+    ring_storage = heap_caps_malloc(ring_size + 1, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    ring_in_psram = (ring_storage != NULL);
+    if (ring_storage == NULL) {
+        ring_size = AUDIO_PIPELINE_RING_SIZE_INTERNAL;
+        ring_storage = heap_caps_malloc(ring_size + 1, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (ring_storage == NULL) {
+            ESP_LOGE(TAG, "环形缓冲区分配失败");
+            return ESP_ERR_NO_MEM;
+        }
+        ESP_LOGW(TAG, "PSRAM 不可用，使用 %u 字节内部 RAM 缓冲区", (unsigned)ring_size);
+    }
+
+    chunk_buf = heap_caps_aligned_alloc(AUDIO_DSP_ALIGN, AUDIO_PIPELINE_CHUNK_BYTES, MALLOC_CAP_INTERNAL);
+    resample_buf = heap_caps_aligned_alloc(AUDIO_DSP_ALIGN,
+                                           PIPELINE_RESAMPLE_FRAMES * AUDIO_RESAMPLER_MAX_CHANNELS * sizeof(int16_t),
+                                           MALLOC_CAP_INTERNAL);
+    events = xEventGroupCreate();
+    if (chunk_buf == NULL || resample_buf == NULL || events == NULL) {
+        ESP_LOGE(TAG, "管道资源分配失败");
+        goto err;
+    }
+
+    ring = xStreamBufferCreateStatic(ring_size, 1, ring_storage, &ring_struct);
+    if (ring == NULL) {
+        ESP_LOGE(TAG, "创建流缓冲区失败");
+        goto err;
+    }
+
+    xEventGroupSetBits(events, PIPELINE_DONE_BIT | PIPELINE_RESUME_BIT);
+
+    if (xTaskCreatePinnedToCore(pipeline_playback_task, "audio_playback", 4096, NULL,
+                                cfg.playback_priority, &playback_task, cfg.playback_core) != pdPASS) {
+        ESP_LOGE(TAG, "创建播放任务失败");
+        goto err;
+    }
+
+    memset(&stats, 0, sizeof(stats));
+    ESP_LOGI(TAG, "音频管道已初始化: 缓冲区 %u 字节 (%s), 预缓冲 %lu ms, 水位 %u%%/%u%%",
+             (unsigned)ring_size, ring_in_psram ? "PSRAM" : "内部 RAM",
+             (unsigned long)cfg.prebuffer_ms, cfg.low_watermark_pct, cfg.high_watermark_pct);
+    return ESP_OK;
+
+err:
+    if (events != NULL) {
+        vEventGroupDelete(events);
+        events = NULL;
+    }
+    heap_caps_free(chunk_buf);
+    heap_caps_free(resample_buf);
+    heap_caps_free(ring_storage);
+    chunk_buf = NULL;
+    resample_buf = NULL;
+    ring_storage = NULL;
+    ring = NULL;
+    return ESP_ERR_NO_MEM;
+}
+
+/**
+ * @brief 开始一个新的 PCM 数据流
+ */
+esp_err_t audio_pipeline_begin(uint32_t sample_rate, uint8_t channels)
+{
+    return audio_pipeline_begin_with_prebuffer(sample_rate, channels, cfg.prebuffer_ms);
+}
+
+/**
+ * @brief 开始一个新的 PCM 数据流 (指定预缓冲时长)
+ */
+esp_err_t audio_pipeline_begin_with_prebuffer(uint32_t sample_rate, uint8_t channels, uint32_t prebuffer_ms)
+{
+    if (ring == NULL || active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (channels != 1 && channels != 2) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // I2S 采样率固定，按需重建转换器 (采样率和声道数不变时只清空历史)
+    uint32_t out_rate = audio_player_get_sample_rate();
+    if (resampler.in_rate == sample_rate && resampler.out_rate == out_rate && resampler.channels == channels) {
+        audio_resampler_reset(&resampler);
+    } else {
+        audio_resampler_deinit(&resampler);
+        esp_err_t ret = audio_resampler_init(&resampler, sample_rate, out_rate, channels, cfg.resampler_quality);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+    resample_us = 0;
+    resample_out_frames = 0;
+
+    // 播放任务空闲且没有任务阻塞在缓冲区上，可以复位
+    xStreamBufferReset(ring);
+
+    stream_channels = channels;
+    frame_bytes = channels * sizeof(int16_t);
+    byte_rate = sample_rate * frame_bytes;
+    fade_frames = (sample_rate * cfg.fade_ms) / 1000;
+    high_bytes = ring_size * cfg.high_watermark_pct / 100;
+    low_bytes = ring_size * cfg.low_watermark_pct / 100;
+
+    // 预缓冲至少一整块，且不超过高水位
+    prebuffer_bytes = (size_t)((uint64_t)byte_rate * prebuffer_ms / 1000);
+    if (prebuffer_bytes < AUDIO_PIPELINE_CHUNK_BYTES) {
+        prebuffer_bytes = AUDIO_PIPELINE_CHUNK_BYTES;
+    }
+    if (prebuffer_bytes > high_bytes) {
+        prebuffer_bytes = high_bytes;
+    }
+
+    portENTER_CRITICAL(&stats_lock);
+    stats.underruns = 0;
+    stats.producer_pauses = 0;
+    stats.bytes_written = 0;
+    stats.bytes_played = 0;
+    stats.resample_dropped_frames = 0;
+    stats.min_fill_bytes = ring_size;
+    stats.start_us = 0;
+    portEXIT_CRITICAL(&stats_lock);
+
+    begin_time_us = esp_timer_get_time();
+    first_output = true;
+    eof = false;
+    aborting = false;
+    state = AUDIO_PIPELINE_STATE_PREBUFFERING;
+    xEventGroupClearBits(events, PIPELINE_DONE_BIT);
+    xEventGroupSetBits(events, PIPELINE_RESUME_BIT);
+    active = true;
+    xTaskNotifyGive(playback_task);
+
+    ESP_LOGI(TAG, "开始数据流: %lu Hz, %u 声道, 预缓冲 %u 字节",
+             (unsigned long)sample_rate, channels, (unsigned)prebuffer_bytes);
+    return ESP_OK;
+}
+
+/**
+ * @brief 写入 PCM 数据
+ */
+size_t audio_pipeline_write(const void *data, size_t len, uint32_t wait_ms)
+{
+    if (!active || eof || data == NULL) {
+        return 0;
+    }
+
+    const uint8_t *p = (const uint8_t *)data;
+    size_t written = 0;
+    TickType_t start = xTaskGetTickCount();
+    TickType_t timeout = pdMS_TO_TICKS(wait_ms);
+
+    while (written < len && !aborting) {
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= timeout) {
+            break;
+        }
+        TickType_t remaining = timeout - elapsed;
+
+        // 高水位：暂停写入，直到播放任务消耗到低水位
+        if (xStreamBufferBytesAvailable(ring) >= high_bytes) {
+            xEventGroupClearBits(events, PIPELINE_RESUME_BIT);
+            // 清除后再确认一次，避免错过播放任务的唤醒
+            if (xStreamBufferBytesAvailable(ring) >= high_bytes) {
+                portENTER_CRITICAL(&stats_lock);
+                stats.producer_pauses++;
+                portEXIT_CRITICAL(&stats_lock);
+                xEventGroupWaitBits(events, PIPELINE_RESUME_BIT, pdFALSE, pdFALSE, remaining);
+                continue;
+            }
+        }
+
+        size_t n = xStreamBufferSend(ring, p + written, len - written, remaining);
+        written += n;
+
+        portENTER_CRITICAL(&stats_lock);
+        stats.bytes_written += n;
+        portEXIT_CRITICAL(&stats_lock);
+
+        xTaskNotifyGive(playback_task);
+    }
+
+    return written;
+}
+
+/**
+ * @brief 结束数据流并等待播放完毕
+ */
+esp_err_t audio_pipeline_end(uint32_t wait_ms)
+{
+    if (!active) {
+        return ESP_OK;
+    }
+
+    eof = true;
+    xTaskNotifyGive(playback_task);
+
+    EventBits_t bits = xEventGroupWaitBits(events, PIPELINE_DONE_BIT, pdFALSE, pdFALSE, pdMS_TO_TICKS(wait_ms));
+    return (bits & PIPELINE_DONE_BIT) ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+/**
+ * @brief 中止当前数据流
+ */
+void audio_pipeline_abort(void)
+{
+    if (!active) {
+        return;
+    }
+
+    aborting = true;
+    xEventGroupSetBits(events, PIPELINE_RESUME_BIT);
+    xTaskNotifyGive(playback_task);
+    xEventGroupWaitBits(events, PIPELINE_DONE_BIT, pdFALSE, pdFALSE, pdMS_TO_TICKS(1000));
+}
+
+/**
+ * @brief 获取管道遥测数据
+ */
+void audio_pipeline_get_stats(audio_pipeline_stats_t *out)
+{
+    if (out == NULL) {
+        return;
+    }
+
+    size_t fill = (ring != NULL) ? xStreamBufferBytesAvailable(ring) : 0;
+
+    portENTER_CRITICAL(&stats_lock);
+    *out = stats;
+    portEXIT_CRITICAL(&stats_lock);
+
+    out->state = state;
+    out->ring_size = ring_size;
+    out->fill_bytes = fill;
+    out->fill_pct = ring_size > 0 ? (uint8_t)(fill * 100 / ring_size) : 0;
+    out->buffered_ms = byte_rate > 0 ? (uint32_t)((uint64_t)fill * 1000 / byte_rate) : 0;
+    out->in_psram = ring_in_psram;
+    out->resample_us_per_s = resample_out_frames > 0 ?
+        (uint32_t)((uint64_t)resample_us * resampler.out_rate / resample_out_frames) : 0;
+}
@@ -6,11 +6,18 @@
  */
 
 #include "include/audio_player.h"
+#include "include/audio_dsp.h"
+#include "include/audio_synth.h"
+#include "include/audio_mixer.h"
 #include <string.h>
-#include <math.h>
+#include <stdatomic.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "driver/i2s_std.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "esp_attr.h"
 #include "esp_log.h"
 
 static const char *TAG = "audio_player";
@@ -18,26 +25,173 @@ static const char *TAG = "audio_player";
 // I2S 通道句柄
 static i2s_chan_handle_t tx_handle = NULL;
 
-// 当前采样率
+// 保护 tx_handle：混音任务写入与延迟档位切换 (重建通道) 互斥
+static SemaphoreHandle_t i2s_mutex = NULL;
+
+/**
+ * @brief 延迟档位对应的 DMA 配置
+ * 
+ * dma_frame_num 取混音块 (AUDIO_MIXER_BLOCK_FRAMES) 的约数，每次写入都结束在
+ * DMA 缓冲区边界上，空闲后重新开始时数据从下一个 DMA 缓冲区开始播放
+ */
+typedef struct {
+    uint32_t desc_num;
+    uint32_t frame_num;
+} latency_profile_cfg_t;
+
+static const latency_profile_cfg_t latency_profiles[] = {
+    [AUDIO_PLAYER_LATENCY_LOW]      = { .desc_num = 4,  .frame_num = 128 },
+    [AUDIO_PLAYER_LATENCY_BALANCED] = { .desc_num = 6,  .frame_num = 256 },
+    [AUDIO_PLAYER_LATENCY_ROBUST]   = { .desc_num = 16, .frame_num = 256 },
+};
+
+_Static_assert(AUDIO_MIXER_BLOCK_FRAMES % 256 == 0, "DMA 缓冲区帧数必须整除混音块");
+
+static audio_player_latency_profile_t current_profile = AUDIO_PLAYER_DEFAULT_LATENCY;
+
+/*
+ * 延迟测量
+ * 
+ * DMA 按描述符顺序循环发送，on_sent 回调每发送完一个缓冲区把 dma_sent_pos
+ * (自通道启用以来发送的字节数) 前移一个缓冲区。写入 I2S 时记录本块数据在
+ * 这一坐标下的起始位置和入队时间，回调发现 DMA 已越过该位置时，
+ * 由越过的字节数倒推出这一采样开始播放的时刻，两者之差即入队到出声的延迟。
+ */
+#define LATENCY_RECORDS     32      // 未播放的写入记录 (2 的幂，大于 DMA 深度 / 混音块)
+
+typedef struct {
+    uint32_t pos;           // 起始字节位置
+    int64_t  queued_us;     // 入队时间
+} latency_record_t;
+
+static latency_record_t latency_records[LATENCY_RECORDS];
+static atomic_uint lat_head;                // 写入方 (混音任务)
+static atomic_uint lat_tail;                // on_sent 回调
+static atomic_uint dma_sent_pos;            // DMA 已发送字节数 (on_sent 回调)
+static uint32_t dma_write_pos = 0;          // 下一次写入的字节位置 (混音任务)
+static uint32_t dma_buf_bytes = 0;          // 单个 DMA 缓冲区字节数
+static uint32_t dma_ring_bytes = 0;         // 全部 DMA 缓冲区字节数
+static uint32_t us_per_byte_q16 = 0;        // 每字节时长 (Q16 微秒)
+
+static portMUX_TYPE latency_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t lat_last_us = 0;
+static uint32_t lat_min_us = UINT32_MAX;
+static uint32_t lat_max_us = 0;
+static uint64_t lat_sum_us = 0;
+static uint32_t lat_count = 0;
+
+// 输出采样率 (固定，其他采样率由 audio_resampler 转换)
 static uint32_t current_sample_rate = AUDIO_SAMPLE_RATE;
 
 // 音量 (0-100)
 static uint8_t current_volume = 80;
 
-// PI常量
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
+// 音量对应的 Q15 增益
+static int16_t current_gain_q15 = 0;
+
+// 立体声暂存缓冲区 (AUDIO_SCRATCH_FRAMES 帧, 16 字节对齐)
+static int16_t *stereo_scratch = NULL;
+
+// 混音器中的主音源 (audio_player_play/play_stereo 写入，可被提示音闪避)
+static audio_mixer_source_t main_source = NULL;
+
+/**
+ * @brief DMA 发送完一个缓冲区 (中断上下文)
+ */
+static bool IRAM_ATTR audio_player_on_sent(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx)
+{
+    int64_t now = esp_timer_get_time();
+    uint32_t sent = atomic_load_explicit(&dma_sent_pos, memory_order_relaxed) + event->size;
+    atomic_store_explicit(&dma_sent_pos, sent, memory_order_release);
+    
+    unsigned tail = atomic_load_explicit(&lat_tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&lat_head, memory_order_acquire);
+    while (tail != head) {
+        const latency_record_t *rec = &latency_records[tail & (LATENCY_RECORDS - 1)];
+        int32_t ahead = (int32_t)(sent - rec->pos);
+        if (ahead <= 0) {
+            break;      // 尚未播放到
+        }
+        
+        // rec->pos 处的采样在 ahead 字节之前开始播放
+        int64_t start_us = now - (int64_t)(((uint64_t)ahead * us_per_byte_q16) >> 16);
+        int64_t latency = start_us - rec->queued_us;
+        uint32_t lat_us = (latency > 0) ? (uint32_t)latency : 0;
+        
+        portENTER_CRITICAL_ISR(&latency_lock);
+        lat_last_us = lat_us;
+        if (lat_us < lat_min_us) {
+            lat_min_us = lat_us;
+        }
+        if (lat_us > lat_max_us) {
+            lat_max_us = lat_us;
+        }
+        lat_sum_us += lat_us;
+        lat_count++;
+        portEXIT_CRITICAL_ISR(&latency_lock);
+        
+        tail++;
+    }
+    atomic_store_explicit(&lat_tail, tail, memory_order_release);
+    
+    return false;
+}
+
+/**
+ * @brief 记录即将写入 I2S 的数据块 (持有 i2s_mutex 时调用)
+ */
+static void audio_player_latency_mark(size_t len)
+{
+    uint32_t sent = atomic_load_explicit(&dma_sent_pos, memory_order_acquire);
+    
+    // 启用后的第一轮 DMA 缓冲区播放顺序与稳态不同，不做测量
+    if (sent < dma_ring_bytes) {
+        dma_write_pos = sent + dma_buf_bytes;
+        return;
+    }
+    
+    // DMA 已播放到写入位置 (空闲或欠载)：驱动把数据写入正在播放的缓冲区之后的那一个
+    if ((int32_t)(dma_write_pos - (sent + dma_buf_bytes)) < 0) {
+        dma_write_pos = sent + dma_buf_bytes;
+    }
+    
+    unsigned head = atomic_load_explicit(&lat_head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&lat_tail, memory_order_acquire);
+    if (head - tail < LATENCY_RECORDS) {
+        latency_record_t *rec = &latency_records[head & (LATENCY_RECORDS - 1)];
+        rec->pos = dma_write_pos;
+        rec->queued_us = esp_timer_get_time();
+        atomic_store_explicit(&lat_head, head + 1, memory_order_release);
+    }
+    dma_write_pos += len;
+}
+
+/**
+ * @brief 清除延迟测量状态 (通道重建后 DMA 位置从 0 开始)
+ */
+static void audio_player_latency_reset(void)
+{
+    atomic_store(&dma_sent_pos, 0);
+    atomic_store(&lat_head, 0);
+    atomic_store(&lat_tail, 0);
+    dma_write_pos = 0;
+    audio_player_reset_latency_stats();
+}
 
 /**
- * @brief 内部函数：用指定采样率初始化 I2S
+ * @brief 内部函数：用指定采样率和延迟档位初始化 I2S
  */
-static esp_err_t audio_player_init_i2s(uint32_t sample_rate)
+static esp_err_t audio_player_init_i2s(uint32_t sample_rate, audio_player_latency_profile_t profile)
 {
-    ESP_LOGI(TAG, "初始化 I2S (采样率: %lu Hz)...", (unsigned long)sample_rate);
+    const latency_profile_cfg_t *prof = &latency_profiles[profile];
+    
+    ESP_LOGI(TAG, "初始化 I2S (采样率: %lu Hz, DMA: %lu × %lu 帧)...", (unsigned long)sample_rate,
+             (unsigned long)prof->desc_num, (unsigned long)prof->frame_num);
     
     // I2S 通道配置
     i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_0, I2S_ROLE_MASTER);
+    chan_cfg.dma_desc_num = prof->desc_num;
+    chan_cfg.dma_frame_num = prof->frame_num;
     chan_cfg.auto_clear = true;
     
     esp_err_t ret = i2s_new_channel(&chan_cfg, &tx_handle, NULL);
@@ -72,6 +226,23 @@ static esp_err_t audio_player_init_i2s(uint32_t sample_rate)
         return ret;
     }
     
+    // 延迟测量：跟踪 DMA 发送位置
+    dma_buf_bytes = prof->frame_num * 2 * sizeof(int16_t);
+    dma_ring_bytes = dma_buf_bytes * prof->desc_num;
+    us_per_byte_q16 = (uint32_t)((1000000ULL << 16) / ((uint64_t)sample_rate * 2 * sizeof(int16_t)));
+    audio_player_latency_reset();
+    
+    const i2s_event_callbacks_t cbs = {
+        .on_sent = audio_player_on_sent,
+    };
+    ret = i2s_channel_register_event_callback(tx_handle, &cbs, NULL);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "注册 I2S 回调失败: %s", esp_err_to_name(ret));
+        i2s_del_channel(tx_handle);
+        tx_handle = NULL;
+        return ret;
+    }
+    
     ret = i2s_channel_enable(tx_handle);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "启用 I2S 通道失败: %s", esp_err_to_name(ret));
@@ -81,7 +252,9 @@ static esp_err_t audio_player_init_i2s(uint32_t sample_rate)
     }
     
     current_sample_rate = sample_rate;
-    ESP_LOGI(TAG, "I2S 初始化完成 (采样率: %lu Hz)", (unsigned long)sample_rate);
+    current_profile = profile;
+    ESP_LOGI(TAG, "I2S 初始化完成 (采样率: %lu Hz, DMA 深度 %lu us)", (unsigned long)sample_rate,
+             (unsigned long)((uint64_t)dma_ring_bytes * us_per_byte_q16 >> 16));
     
     return ESP_OK;
 }
@@ -92,34 +265,64 @@ static esp_err_t audio_player_init_i2s(uint32_t sample_rate)
 esp_err_t audio_player_init(void)
 {
     ESP_LOGI(TAG, "初始化 I2S 音频播放器 (MAX98357)...");
-    esp_err_t ret = audio_player_init_i2s(AUDIO_SAMPLE_RATE);
-    if (ret == ESP_OK) {
-        ESP_LOGI(TAG, "引脚配置: BCLK=%d, WS=%d, DOUT=%d", I2S_BCLK_PIN, I2S_WS_PIN, I2S_DOUT_PIN);
+    
+    // 预分配立体声暂存缓冲区，播放路径不再 malloc/free
+    if (stereo_scratch == NULL) {
+        stereo_scratch = (int16_t *)heap_caps_aligned_alloc(AUDIO_DSP_ALIGN,
+                                                            AUDIO_SCRATCH_FRAMES * 2 * sizeof(int16_t),
+                                                            MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+        if (stereo_scratch == NULL) {
+            ESP_LOGE(TAG, "暂存缓冲区分配失败");
+            return ESP_ERR_NO_MEM;
+        }
     }
-    return ret;
-}
-
-/**
- * @brief 设置采样率并重新初始化 I2S
- */
-esp_err_t audio_player_set_sample_rate(uint32_t sample_rate)
-{
-    if (sample_rate == current_sample_rate && tx_handle != NULL) {
-        return ESP_OK;  // 采样率相同，无需重新初始化
+    current_gain_q15 = audio_dsp_volume_to_q15(current_volume);
+    
+    if (i2s_mutex == NULL) {
+        i2s_mutex = xSemaphoreCreateMutex();
+        if (i2s_mutex == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
     }
     
-    ESP_LOGI(TAG, "切换采样率: %lu -> %lu Hz", 
-             (unsigned long)current_sample_rate, (unsigned long)sample_rate);
+    esp_err_t ret = audio_player_init_i2s(AUDIO_SAMPLE_RATE, current_profile);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    ESP_LOGI(TAG, "引脚配置: BCLK=%d, WS=%d, DOUT=%d", I2S_BCLK_PIN, I2S_WS_PIN, I2S_DOUT_PIN);
     
-    // 先释放现有资源
-    if (tx_handle != NULL) {
-        i2s_channel_disable(tx_handle);
-        i2s_del_channel(tx_handle);
-        tx_handle = NULL;
+    // 混音任务独占 I2S，所有播放接口都通过混音器音源输出
+    ret = audio_mixer_init(NULL);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    audio_mixer_set_master_gain(current_gain_q15);
+    
+    if (main_source == NULL) {
+        const audio_mixer_source_config_t src_cfg = {
+            .name = "main",
+            .channels = 2,
+            .ring_frames = AUDIO_PLAYER_MAIN_RING_FRAMES,
+            .gain_q15 = AUDIO_DSP_Q15_ONE,
+            .duckable = true,
+            .ducks_others = false,
+        };
+        ret = audio_mixer_add_source(&src_cfg, &main_source);
+        if (ret != ESP_OK) {
+            return ret;
+        }
     }
     
-    // 重新初始化
-    return audio_player_init_i2s(sample_rate);
+    // 测试音和示例旋律使用的 DDS 音源
+    return audio_synth_init(current_sample_rate);
+}
+
+/**
+ * @brief 获取 I2S 输出采样率 (固定)
+ */
+uint32_t audio_player_get_sample_rate(void)
+{
+    return current_sample_rate;
 }
 
 /**
@@ -127,12 +330,22 @@ esp_err_t audio_player_set_sample_rate(uint32_t sample_rate)
  */
 esp_err_t audio_player_deinit(void)
 {
+    if (i2s_mutex != NULL) {
+        xSemaphoreTake(i2s_mutex, portMAX_DELAY);
+    }
     if (tx_handle != NULL) {
         i2s_channel_disable(tx_handle);
         i2s_del_channel(tx_handle);
         tx_handle = NULL;
         ESP_LOGI(TAG, "I2S 音频播放器已释放");
     }
+    if (i2s_mutex != NULL) {
+        xSemaphoreGive(i2s_mutex);
+    }
+    if (stereo_scratch != NULL) {
+        heap_caps_free(stereo_scratch);
+        stereo_scratch = NULL;
+    }
     return ESP_OK;
 }
 
@@ -145,7 +358,7 @@ esp_err_t audio_player_deinit(void)
  */
 esp_err_t audio_player_play(const int16_t *data, size_t len, uint32_t wait_ms)
 {
-    if (tx_handle == NULL) {
+    if (main_source == NULL) {
         ESP_LOGE(TAG, "音频播放器未初始化");
         return ESP_ERR_INVALID_STATE;
     }
@@ -157,30 +370,20 @@ esp_err_t audio_player_play(const int16_t *data, size_t len, uint32_t wait_ms)
     // 单声道采样数
     size_t sample_count = len / sizeof(int16_t);
     
-    // 分配立体声缓冲区 (大小翻倍)
-    int16_t *stereo_data = (int16_t *)malloc(sample_count * 2 * sizeof(int16_t));
-    if (stereo_data == NULL) {
-        ESP_LOGE(TAG, "内存分配失败");
-        return ESP_ERR_NO_MEM;
-    }
-    
-    // 转换为立体声并应用音量
-    float volume_factor = current_volume / 100.0f;
-    for (size_t i = 0; i < sample_count; i++) {
-        int16_t sample = (int16_t)(data[i] * volume_factor);
-        stereo_data[i * 2] = sample;      // 左声道
-        stereo_data[i * 2 + 1] = sample;  // 右声道
-    }
-    
-    size_t bytes_written = 0;
-    esp_err_t ret = i2s_channel_write(tx_handle, stereo_data, sample_count * 2 * sizeof(int16_t), 
-                                      &bytes_written, pdMS_TO_TICKS(wait_ms));
-    
-    free(stereo_data);
-    
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "I2S 写入失败: %s", esp_err_to_name(ret));
-        return ret;
+    // 按暂存缓冲区大小分块转换为立体声 (音量由混音器统一应用)
+    while (sample_count > 0) {
+        size_t chunk = (sample_count > AUDIO_SCRATCH_FRAMES) ? AUDIO_SCRATCH_FRAMES : sample_count;
+        size_t bytes = chunk * 2 * sizeof(int16_t);
+        
+        audio_dsp_mono_to_stereo_q15(stereo_scratch, data, chunk, AUDIO_DSP_Q15_ONE);
+        
+        if (audio_mixer_write(main_source, stereo_scratch, bytes, wait_ms) != bytes) {
+            ESP_LOGE(TAG, "写入混音器超时");
+            return ESP_ERR_TIMEOUT;
+        }
+        
+        data += chunk;
+        sample_count -= chunk;
     }
     
     return ESP_OK;
@@ -189,7 +392,7 @@ esp_err_t audio_player_play(const int16_t *data, size_t len, uint32_t wait_ms)
 /**
  * @brief 播放正弦波测试音
  * 
- * 生成立体声格式数据 (左右声道相同) 发送到 MAX98357
+ * 由 DDS 音源生成 (查表 + 线性插值)，首尾各 5ms 淡入淡出避免咔嗒声
  */
 esp_err_t audio_player_play_tone(uint32_t frequency, uint32_t duration_ms)
 {
@@ -201,53 +404,25 @@ esp_err_t audio_player_play_tone(uint32_t frequency, uint32_t duration_ms)
     ESP_LOGI(TAG, "播放 %lu Hz 正弦波, 持续 %lu ms (采样率: %lu Hz)", 
              (unsigned long)frequency, (unsigned long)duration_ms, (unsigned long)current_sample_rate);
     
-    // 计算需要的采样数 (使用当前采样率)
-    uint32_t total_samples = (current_sample_rate * duration_ms) / 1000;
-    
-    // 分块生成和播放，避免占用太多内存
-    // 立体声格式：每个采样点需要 2 个 int16_t (左声道 + 右声道)
-    const uint32_t chunk_samples = 512;  // 每块采样数
-    int16_t *buffer = (int16_t *)malloc(chunk_samples * 2 * sizeof(int16_t));  // 立体声缓冲区
-    if (buffer == NULL) {
-        ESP_LOGE(TAG, "内存分配失败");
-        return ESP_ERR_NO_MEM;
-    }
-    
-    float volume_factor = current_volume / 100.0f;
-    float amplitude = 32767.0f * 0.8f * volume_factor;  // 80% 最大振幅，避免削波
-    float phase_increment = 2.0f * M_PI * frequency / current_sample_rate;
-    float phase = 0.0f;
-    
-    uint32_t samples_remaining = total_samples;
+    const audio_synth_adsr_t adsr = {
+        .attack_ms = 5,
+        .decay_ms = 0,
+        .sustain = AUDIO_DSP_Q15_ONE,
+        .release_ms = 5,
+    };
+    const audio_synth_note_t note = {
+        .start_ms = 0,
+        .duration_ms = (duration_ms > adsr.release_ms) ? duration_ms - adsr.release_ms : duration_ms,
+        .freq_hz = (float)frequency,
+        .velocity = 26214,          // 80% 最大振幅，避免削波
+    };
     
-    while (samples_remaining > 0) {
-        uint32_t samples_to_generate = (samples_remaining > chunk_samples) ? chunk_samples : samples_remaining;
-        
-        // 生成立体声数据：左声道、右声道交替
-        for (uint32_t i = 0; i < samples_to_generate; i++) {
-            int16_t sample = (int16_t)(amplitude * sinf(phase));
-            buffer[i * 2] = sample;      // 左声道
-            buffer[i * 2 + 1] = sample;  // 右声道 (相同数据)
-            phase += phase_increment;
-            if (phase >= 2.0f * M_PI) {
-                phase -= 2.0f * M_PI;
-            }
-        }
-        
-        size_t bytes_written = 0;
-        // 写入立体声数据 (字节数 = 采样数 * 2通道 * 2字节)
-        esp_err_t ret = i2s_channel_write(tx_handle, buffer, samples_to_generate * 2 * sizeof(int16_t), 
-                                          &bytes_written, pdMS_TO_TICKS(1000));
-        if (ret != ESP_OK) {
-            ESP_LOGE(TAG, "I2S 写入失败: %s", esp_err_to_name(ret));
-            free(buffer);
-            return ret;
-        }
-        
-        samples_remaining -= samples_to_generate;
+    esp_err_t ret = audio_synth_play_sequence(&note, 1, &adsr);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "正弦波播放失败: %s", esp_err_to_name(ret));
+        return ret;
     }
     
-    free(buffer);
     ESP_LOGI(TAG, "正弦波播放完成");
     
     return ESP_OK;
@@ -255,28 +430,30 @@ esp_err_t audio_player_play_tone(uint32_t frequency, uint32_t duration_ms)
 
 /**
  * @brief 播放内置示例音频 - 播放一段简单的旋律
+ * 
+ * 整段旋律由音序器渲染为一个连续的数据流，音符之间没有 I2S 停顿
  */
 esp_err_t audio_player_play_sample(void)
 {
     ESP_LOGI(TAG, "播放示例音频 - 《小星星》旋律");
     
-    // 音符频率定义 (Hz)
+    // 音符定义
     typedef struct {
-        uint32_t freq;      // 频率
+        float freq;         // 频率 (Hz)
         uint32_t duration;  // 持续时间 (ms)
     } note_t;
     
-    // C4 = 262 Hz, D4 = 294 Hz, E4 = 330 Hz, F4 = 349 Hz, G4 = 392 Hz, A4 = 440 Hz
-    #define C4  262
-    #define D4  294
-    #define E4  330
-    #define F4  349
-    #define G4  392
-    #define A4  440
-    #define REST 0
+    // C4 = 261.63 Hz, D4 = 293.66 Hz, E4 = 329.63 Hz, F4 = 349.23 Hz, G4 = 392 Hz, A4 = 440 Hz
+    #define C4  261.63f
+    #define D4  293.66f
+    #define E4  329.63f
+    #define F4  349.23f
+    #define G4  392.00f
+    #define A4  440.00f
+    #define REST 0.0f
     
     // 《小星星》旋律 (Twinkle Twinkle Little Star)
-    const note_t melody[] = {
+    static const note_t melody[] = {
         // 一闪一闪亮晶晶
         {C4, 400}, {C4, 400}, {G4, 400}, {G4, 400},
         {A4, 400}, {A4, 400}, {G4, 800},
@@ -297,24 +474,35 @@ esp_err_t audio_player_play_sample(void)
         {D4, 400}, {D4, 400}, {C4, 800},
     };
     
+    // 音符之间的间隔 (松开后的释音在间隔内完成)
+    const uint32_t gap_ms = 50;
     const int melody_length = sizeof(melody) / sizeof(melody[0]);
     
+    static audio_synth_note_t notes[sizeof(melody) / sizeof(melody[0])];
+    size_t count = 0;
+    uint32_t t = 0;
+    
     for (int i = 0; i < melody_length; i++) {
-        if (melody[i].freq == REST) {
-            // 休止符 - 播放静音
-            vTaskDelay(pdMS_TO_TICKS(melody[i].duration));
-        } else {
-            // 播放音符
-            esp_err_t ret = audio_player_play_tone(melody[i].freq, melody[i].duration);
-            if (ret != ESP_OK) {
-                return ret;
-            }
+        if (melody[i].freq != REST) {
+            notes[count].start_ms = t;
+            notes[count].duration_ms = melody[i].duration;
+            notes[count].freq_hz = melody[i].freq;
+            notes[count].velocity = 26214;
+            count++;
         }
-        // 音符之间的短暂间隔
-        vTaskDelay(pdMS_TO_TICKS(50));
+        t += melody[i].duration + gap_ms;
+    }
+    
+    const audio_synth_adsr_t adsr = AUDIO_SYNTH_DEFAULT_ADSR();
+    esp_err_t ret = audio_synth_play_sequence(notes, count, &adsr);
+    if (ret != ESP_OK) {
+        return ret;
     }
     
-    ESP_LOGI(TAG, "示例音频播放完成");
+    audio_synth_stats_t stats;
+    audio_synth_get_stats(&stats);
+    ESP_LOGI(TAG, "示例音频播放完成 (渲染 %lu us/s, 每发音 %lu us/s)",
+             (unsigned long)stats.render_us_per_s, (unsigned long)stats.us_per_voice_s);
     return ESP_OK;
 }
 
@@ -327,6 +515,8 @@ void audio_player_set_volume(uint8_t volume)
         volume = 100;
     }
     current_volume = volume;
+    current_gain_q15 = audio_dsp_volume_to_q15(volume);
+    audio_mixer_set_master_gain(current_gain_q15);
     ESP_LOGI(TAG, "音量设置为: %d%%", volume);
 }
 
@@ -347,7 +537,7 @@ uint8_t audio_player_get_volume(void)
  */
 esp_err_t audio_player_play_stereo(const int16_t *data, size_t len, uint32_t wait_ms)
 {
-    if (tx_handle == NULL) {
+    if (main_source == NULL) {
         ESP_LOGE(TAG, "音频播放器未初始化");
         return ESP_ERR_INVALID_STATE;
     }
@@ -356,14 +546,129 @@ esp_err_t audio_player_play_stereo(const int16_t *data, size_t len, uint32_t wai
         return ESP_ERR_INVALID_ARG;
     }
     
+    size_t bytes = len & ~(size_t)3;
+    if (audio_mixer_write(main_source, data, bytes, wait_ms) != bytes) {
+        ESP_LOGE(TAG, "写入混音器超时");
+        return ESP_ERR_TIMEOUT;
+    }
+    
+    return ESP_OK;
+}
+
+/**
+ * @brief 等待已提交的 PCM 全部进入 I2S
+ */
+esp_err_t audio_player_drain(uint32_t wait_ms)
+{
+    if (main_source == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return audio_mixer_drain(main_source, wait_ms);
+}
+
+/**
+ * @brief 写入 I2S (混音任务调用)
+ */
+esp_err_t audio_player_write_i2s(const int16_t *data, size_t len, uint32_t wait_ms)
+{
+    if (i2s_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    xSemaphoreTake(i2s_mutex, portMAX_DELAY);
+    if (tx_handle == NULL) {
+        xSemaphoreGive(i2s_mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    audio_player_latency_mark(len);
+    
     size_t bytes_written = 0;
-    esp_err_t ret = i2s_channel_write(tx_handle, data, len, &bytes_written, pdMS_TO_TICKS(wait_ms));
+    esp_err_t ret = i2s_channel_write(tx_handle, data, len, &bytes_written,
+                                      (wait_ms == portMAX_DELAY) ? portMAX_DELAY : pdMS_TO_TICKS(wait_ms));
+    xSemaphoreGive(i2s_mutex);
     
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "I2S 写入失败: %s", esp_err_to_name(ret));
-        return ret;
+    }
+    return ret;
+}
+
+/**
+ * @brief 切换延迟档位
+ */
+esp_err_t audio_player_set_latency_profile(audio_player_latency_profile_t profile)
+{
+    if ((unsigned)profile >= sizeof(latency_profiles) / sizeof(latency_profiles[0])) {
+        return ESP_ERR_INVALID_ARG;
     }
     
-    return ESP_OK;
+    // 尚未初始化：只记录档位，audio_player_init() 时生效
+    if (i2s_mutex == NULL) {
+        current_profile = profile;
+        return ESP_OK;
+    }
+    
+    xSemaphoreTake(i2s_mutex, portMAX_DELAY);
+    if (tx_handle == NULL || profile == current_profile) {
+        current_profile = profile;
+        xSemaphoreGive(i2s_mutex);
+        return ESP_OK;
+    }
+    
+    // DMA 描述符数量只能在创建通道时指定，重建通道 (期间短暂静音)
+    i2s_channel_disable(tx_handle);
+    i2s_del_channel(tx_handle);
+    tx_handle = NULL;
+    esp_err_t ret = audio_player_init_i2s(current_sample_rate, profile);
+    xSemaphoreGive(i2s_mutex);
+    
+    return ret;
+}
+
+/**
+ * @brief 获取当前延迟档位
+ */
+audio_player_latency_profile_t audio_player_get_latency_profile(void)
+{
+    return current_profile;
 }
 
+/**
+ * @brief 获取延迟统计
+ */
+void audio_player_get_latency(audio_player_latency_t *latency)
+{
+    const latency_profile_cfg_t *prof = &latency_profiles[current_profile];
+    
+    memset(latency, 0, sizeof(*latency));
+    latency->profile = current_profile;
+    latency->dma_desc_num = prof->desc_num;
+    latency->dma_frame_num = prof->frame_num;
+    latency->dma_depth_us = (uint32_t)((uint64_t)prof->desc_num * prof->frame_num * 1000000ULL /
+                                       current_sample_rate);
+    
+    portENTER_CRITICAL(&latency_lock);
+    if (lat_count > 0) {
+        latency->last_us = lat_last_us;
+        latency->min_us = lat_min_us;
+        latency->max_us = lat_max_us;
+        latency->avg_us = (uint32_t)(lat_sum_us / lat_count);
+    }
+    latency->samples = lat_count;
+    portEXIT_CRITICAL(&latency_lock);
+}
+
+/**
+ * @brief 清零延迟统计
+ */
+void audio_player_reset_latency_stats(void)
+{
+    portENTER_CRITICAL(&latency_lock);
+    lat_last_us = 0;
+    lat_min_us = UINT32_MAX;
+    lat_max_us = 0;
+    lat_sum_us = 0;
+    lat_count = 0;
+    portEXIT_CRITICAL(&latency_lock);
+}
@@ -0,0 +1,334 @@
+/**
+ * @file audio_resampler.c
+ * @brief 流式多相加窗 sinc 采样率转换器实现
+ *
+ * 输出位置用 32.32 定点表示，小数部分高位选择相位，其余位在相邻两个相位的
+ * 输出之间线性插值 (相位表多存一行，最后一行是第 0 相位右移一个采样)。
+ * 每个相位的系数在初始化时用 Kaiser 窗 sinc 计算并归一化 (直流增益为 1)，
+ * 再量化为 Q15。降采样时截止频率按输出奈奎斯特频率缩放以抑制混叠。
+ */
+
+#include "include/audio_resampler.h"
+#include "include/audio_dsp.h"
+#include <string.h>
+#include <math.h>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+static const char *TAG = "audio_resampler";
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// 历史缓冲区末尾的填充 (SIMD 内核可能越界读取 16 字节)
+#define RESAMPLER_HISTORY_PAD   8
+
+// 档位参数 (cutoff 为 -6dB 点相对较低奈奎斯特频率的比例，beta 为 Kaiser 窗参数)
+typedef struct {
+    uint16_t taps;
+    uint16_t phase_bits;
+    float cutoff;
+    float beta;
+} resampler_tier_t;
+
+static const resampler_tier_t s_tiers[] = {
+    [AUDIO_RESAMPLER_QUALITY_LOW]    = { .taps = 16, .phase_bits = 5, .cutoff = 0.92f, .beta = 4.5f },
+    [AUDIO_RESAMPLER_QUALITY_MEDIUM] = { .taps = 32, .phase_bits = 6, .cutoff = 0.90f, .beta = 6.0f },
+    [AUDIO_RESAMPLER_QUALITY_HIGH]   = { .taps = 64, .phase_bits = 7, .cutoff = 0.92f, .beta = 8.0f },
+};
+
+/**
+ * @brief 第一类零阶修正贝塞尔函数 (级数展开)
+ */
+static double resampler_bessel_i0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 32; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12) {
+            break;
+        }
+    }
+    return sum;
+}
+
+/**
+ * @brief Kaiser 窗, u ∈ [-1, 1]
+ */
+static double resampler_window(double u, double beta)
+{
+    if (u <= -1.0 || u >= 1.0) {
+        return 0.0;
+    }
+    return resampler_bessel_i0(beta * sqrt(1.0 - u * u)) / resampler_bessel_i0(beta);
+}
+
+/**
+ * @brief 生成 Q15 多相系数表 (phases + 1 行)
+ */
+static void resampler_build_coeffs(audio_resampler_t *rs, double fc, double beta)
+{
+    const uint16_t taps = rs->taps;
+    const uint32_t phases = 1u << rs->phase_bits;
+    const double half = taps / 2;
+    double h[AUDIO_RESAMPLER_MAX_TAPS];
+
+    for (uint32_t p = 0; p <= phases; p++) {
+        double frac = (double)p / phases;
+        double sum = 0.0;
+
+        // 抽头 k 对应输入位置与输出位置的距离 d
+        for (uint16_t k = 0; k < taps; k++) {
+            double d = half - 1.0 + frac - k;
+            double x = M_PI * fc * d;
+            double sinc = (fabs(x) < 1e-9) ? 1.0 : sin(x) / x;
+            h[k] = fc * sinc * resampler_window(d / half, beta);
+            sum += h[k];
+        }
+
+        int16_t *row = rs->coeffs + p * taps;
+        for (uint16_t k = 0; k < taps; k++) {
+            long q = lrint(h[k] / sum * 32768.0);
+            row[k] = audio_dsp_sat16((int32_t)q);
+        }
+    }
+}
+
+/**
+ * @brief 按输入/输出采样率和漂移修正设置步进 (32.32 定点)
+ */
+static void resampler_update_step(audio_resampler_t *rs)
+{
+    int64_t step = (int64_t)((((uint64_t)rs->in_rate) << 32) / rs->out_rate);
+    step += step * rs->drift_ppb / 1000000000LL;
+    rs->step_int = (uint32_t)(step >> 32);
+    rs->step_frac = (uint32_t)step;
+}
+
+/**
+ * @brief 初始化转换器 (variable 为 true 时即使采样率相同也不走直通)
+ */
+static esp_err_t resampler_setup(audio_resampler_t *rs, uint32_t in_rate, uint32_t out_rate,
+                                 uint8_t channels, audio_resampler_quality_t quality, bool variable)
+{
+    if (rs == NULL || in_rate == 0 || out_rate == 0 ||
+        channels == 0 || channels > AUDIO_RESAMPLER_MAX_CHANNELS ||
+        quality > AUDIO_RESAMPLER_QUALITY_HIGH) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(rs, 0, sizeof(*rs));
+    rs->in_rate = in_rate;
+    rs->out_rate = out_rate;
+    rs->channels = channels;
+    rs->variable = variable;
+
+    if (in_rate == out_rate && !variable) {
+        rs->passthrough = true;
+        return ESP_OK;
+    }
+
+    const resampler_tier_t *tier = &s_tiers[quality];
+    rs->taps = tier->taps;
+    rs->phase_bits = tier->phase_bits;
+    rs->hist_cap = rs->taps + AUDIO_RESAMPLER_BLOCK_FRAMES;
+
+    size_t coeff_bytes = (((size_t)1 << rs->phase_bits) + 1) * rs->taps * sizeof(int16_t);
+    rs->coeffs = heap_caps_aligned_alloc(AUDIO_DSP_ALIGN, coeff_bytes, MALLOC_CAP_INTERNAL);
+    if (rs->coeffs == NULL) {
+        goto err;
+    }
+
+    for (uint8_t ch = 0; ch < channels; ch++) {
+        rs->history[ch] = heap_caps_aligned_alloc(AUDIO_DSP_ALIGN,
+                                                  (rs->hist_cap + RESAMPLER_HISTORY_PAD) * sizeof(int16_t),
+                                                  MALLOC_CAP_INTERNAL);
+        if (rs->history[ch] == NULL) {
+            goto err;
+        }
+    }
+
+    // 降采样时截止频率跟随输出奈奎斯特频率
+    double fc = tier->cutoff;
+    if (out_rate < in_rate) {
+        fc *= (double)out_rate / in_rate;
+    }
+    resampler_build_coeffs(rs, fc, tier->beta);
+
+    // 步进 = in_rate / out_rate (32.32 定点)
+    resampler_update_step(rs);
+
+    audio_resampler_reset(rs);
+
+    ESP_LOGI(TAG, "采样率转换: %lu -> %lu Hz, %u 抽头, %u 相位",
+             (unsigned long)in_rate, (unsigned long)out_rate, rs->taps, 1u << rs->phase_bits);
+    return ESP_OK;
+
+err:
+    ESP_LOGE(TAG, "内存分配失败");
+    audio_resampler_deinit(rs);
+    return ESP_ERR_NO_MEM;
+}
+
+/**
+ * @brief 初始化转换器
+ */
+esp_err_t audio_resampler_init(audio_resampler_t *rs, uint32_t in_rate, uint32_t out_rate,
+                               uint8_t channels, audio_resampler_quality_t quality)
+{
+    return resampler_setup(rs, in_rate, out_rate, channels, quality, false);
+}
+
+/**
+ * @brief 初始化可微调比例的转换器
+ */
+esp_err_t audio_resampler_init_variable(audio_resampler_t *rs, uint32_t in_rate, uint32_t out_rate,
+                                        uint8_t channels, audio_resampler_quality_t quality)
+{
+    return resampler_setup(rs, in_rate, out_rate, channels, quality, true);
+}
+
+/**
+ * @brief 设置漂移修正
+ */
+esp_err_t audio_resampler_set_drift(audio_resampler_t *rs, int32_t drift_ppb)
+{
+    if (rs == NULL || !rs->variable) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (drift_ppb > AUDIO_RESAMPLER_MAX_DRIFT_PPB) {
+        drift_ppb = AUDIO_RESAMPLER_MAX_DRIFT_PPB;
+    } else if (drift_ppb < -AUDIO_RESAMPLER_MAX_DRIFT_PPB) {
+        drift_ppb = -AUDIO_RESAMPLER_MAX_DRIFT_PPB;
+    }
+    rs->drift_ppb = drift_ppb;
+    resampler_update_step(rs);
+    return ESP_OK;
+}
+
+/**
+ * @brief 释放转换器内存
+ */
+void audio_resampler_deinit(audio_resampler_t *rs)
+{
+    if (rs == NULL) {
+        return;
+    }
+    heap_caps_free(rs->coeffs);
+    for (int ch = 0; ch < AUDIO_RESAMPLER_MAX_CHANNELS; ch++) {
+        heap_caps_free(rs->history[ch]);
+    }
+    memset(rs, 0, sizeof(*rs));
+}
+
+/**
+ * @brief 清空历史数据
+ */
+void audio_resampler_reset(audio_resampler_t *rs)
+{
+    if (rs == NULL || rs->passthrough) {
+        return;
+    }
+
+    // 预填 taps/2 - 1 个零，使第一个输入采样位于首个输出的滤波器中心
+    for (uint8_t ch = 0; ch < rs->channels; ch++) {
+        memset(rs->history[ch], 0, (rs->hist_cap + RESAMPLER_HISTORY_PAD) * sizeof(int16_t));
+    }
+    rs->hist_len = rs->taps / 2 - 1;
+    rs->pos_int = 0;
+    rs->pos_frac = 0;
+}
+
+/**
+ * @brief 流式转换
+ */
+size_t audio_resampler_process(audio_resampler_t *rs, const int16_t *in, size_t in_frames, size_t *in_used,
+                               int16_t *out, size_t out_frames)
+{
+    const uint8_t channels = rs->channels;
+    size_t used = 0;
+    size_t produced = 0;
+
+    if (rs->passthrough) {
+        size_t n = (in_frames < out_frames) ? in_frames : out_frames;
+        memcpy(out, in, n * channels * sizeof(int16_t));
+        *in_used = n;
+        return n;
+    }
+
+    const uint32_t phase_shift = 32 - rs->phase_bits;
+    const uint32_t interp_shift = phase_shift - 15;
+    const uint16_t taps = rs->taps;
+
+    while (produced < out_frames) {
+        if (rs->pos_int + taps > rs->hist_len) {
+            // 丢弃已不再需要的历史采样
+            size_t drop = (rs->pos_int < rs->hist_len) ? rs->pos_int : rs->hist_len;
+            if (drop > 0) {
+                size_t keep = rs->hist_len - drop;
+                for (uint8_t ch = 0; ch < channels; ch++) {
+                    memmove(rs->history[ch], rs->history[ch] + drop, keep * sizeof(int16_t));
+                }
+                rs->hist_len = keep;
+                rs->pos_int -= drop;
+            }
+
+            if (used >= in_frames) {
+                break;
+            }
+
+            // 从输入搬入并解交织
+            size_t n = rs->hist_cap - rs->hist_len;
+            if (n > in_frames - used) {
+                n = in_frames - used;
+            }
+            const int16_t *src = in + used * channels;
+            for (uint8_t ch = 0; ch < channels; ch++) {
+                int16_t *dst = rs->history[ch] + rs->hist_len;
+                for (size_t i = 0; i < n; i++) {
+                    dst[i] = src[i * channels + ch];
+                }
+            }
+            rs->hist_len += n;
+            used += n;
+            continue;
+        }
+
+        // 相邻两个相位的输出按相位间的小数位置 (Q15) 线性插值
+        const int16_t *h0 = rs->coeffs + (rs->pos_frac >> phase_shift) * taps;
+        const int16_t *h1 = h0 + taps;
+        const int32_t mu = (int32_t)((rs->pos_frac >> interp_shift) & 0x7FFF);
+        for (uint8_t ch = 0; ch < channels; ch++) {
+            const int16_t *x = rs->history[ch] + rs->pos_int;
+            int32_t y0 = audio_dsp_dot_q15(x, h0, taps);
+            int32_t y1 = audio_dsp_dot_q15(x, h1, taps);
+            int64_t acc = (int64_t)y0 * 32768 + (int64_t)(y1 - y0) * mu;
+            out[produced * channels + ch] = audio_dsp_sat16((int32_t)((acc + (1LL << 29)) >> 30));
+        }
+        produced++;
+
+        // 前进一个输出采样
+        uint32_t frac = rs->pos_frac + rs->step_frac;
+        rs->pos_int += rs->step_int + (frac < rs->pos_frac ? 1 : 0);
+        rs->pos_frac = frac;
+    }
+
+    *in_used = used;
+    return produced;
+}
+
+/**
+ * @brief 估算最大输出帧数
+ */
+size_t audio_resampler_max_output(const audio_resampler_t *rs, size_t in_frames)
+{
+    if (rs->passthrough) {
+        return in_frames;
+    }
+    // 漂移修正最多使输出多出 in_frames × 2000ppm 帧
+    size_t extra = rs->variable ? 1 + in_frames / 500 : 0;
+    return (size_t)(((uint64_t)in_frames * rs->out_rate + rs->in_rate - 1) / rs->in_rate) + 1 + extra;
+}
@@ -0,0 +1,1006 @@
+/**
+ * @file audio_sync.c
+ * @brief 多房间同步播放实现
+ *
+ * 接收任务：select() 同时等待组播数据和时钟同步应答，按 RTP 时间戳把 PCM
+ * 写入抖动缓冲区 (下标 = 时间戳 & 掩码)，定期向发送端发送时钟同步请求。
+ *
+ * 播放任务：每次从抖动缓冲区取一块 (读过的位置清零，丢失的包自然成为静音)，
+ * 估算这一块第一个采样的出声时刻：
+ *   本地出声时刻 = 现在 + 混音器音源缓冲帧数 / 采样率 + I2S 实测延迟
+ *   计划出声时刻 = 包内出声时刻 (按时间戳线性推算) - 时钟偏移
+ * 时钟偏移按两端时钟的频差外推 (频差由相隔 4 秒以上的两个时钟样本估计)，
+ * 否则晶振偏差 80ppm 时，取最近 8 次中最好的样本和平滑会让偏移滞后约 0.5ms。
+ * 两者之差经平滑后送入 PI 控制器得到采样率修正 (十亿分之一)，交给可微调的
+ * 采样率转换器；差值超过 SYNC_RESYNC_US 时直接跳过数据或补静音。
+ * I2S 与 esp_timer 来自同一晶振，估计出的两端时钟频差直接作为采样率修正的前馈，
+ * PI 只需修正剩余的部分 (I2S 分频误差等)。
+ */
+
+#include "include/audio_sync.h"
+#include "include/audio_player.h"
+#include "include/audio_mixer.h"
+#include "include/audio_dsp.h"
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "lwip/sockets.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "esp_mac.h"
+#include "esp_log.h"
+
+static const char *TAG = "audio_sync";
+
+// 每次播放处理的帧数
+#define SYNC_BLOCK_FRAMES       256
+
+// 混音器音源缓冲 (越小出声时刻估算越准，约 23ms)
+#define SYNC_SOURCE_FRAMES      1024
+
+// 写入混音器的最长等待时间
+#define SYNC_WRITE_TIMEOUT_MS   1000
+
+// 最大 UDP 包长
+#define SYNC_MAX_PACKET         1500
+
+// RTP 头长度
+#define RTP_HEADER_SIZE         12
+
+// 多长时间收不到数据视为数据流结束
+#define SYNC_STREAM_TIMEOUT_US  1000000
+
+// 时钟同步：前 SYNC_CLOCK_FAST_COUNT 次快速请求，之后每秒一次
+#define SYNC_CLOCK_FAST_COUNT   8
+#define SYNC_CLOCK_FAST_US      100000
+#define SYNC_CLOCK_SLOW_US      1000000
+#define SYNC_CLOCK_WINDOW       8       // 时钟滤波窗口 (取往返时间最短的样本)
+#define SYNC_CLOCK_AGE_PPM      100     // 样本老化按此频差计入误差 (与往返时间的一半比较)
+
+// 时钟频差估计：两个样本相隔至少 4 秒才计算 (基线变长后逐渐准确)，超过 64 秒后以新样本为基准
+#define SYNC_RATE_MIN_BASE_US   4000000
+#define SYNC_RATE_MAX_BASE_US   64000000
+#define SYNC_RATE_MAX_PPB       500000
+
+// 出声误差超过此值时跳过/补静音重新对齐
+#define SYNC_RESYNC_US          20000
+
+// 开始播放约 0.74 秒后平均误差超过此值时一次对齐 (以内由 PI 修正)
+#define SYNC_START_ALIGN_US     1000
+
+// 出声误差平滑系数 (1/N，约 0.37 秒)：估算值含混音块粒度的锯齿误差 (±3ms)
+#define SYNC_ERR_FILTER         64
+
+// PI 控制器：1ms 误差对应 100ppm (约 10 秒收敛)，积分时间常数 60 秒
+#define SYNC_KP_PPB_PER_US      100
+#define SYNC_TI_S               60
+#define SYNC_MAX_DRIFT_PPB      500000
+
+/**
+ * @brief 时钟同步样本
+ */
+typedef struct {
+    int64_t  offset_us;
+    int64_t  local_us;          // 样本对应的本地时刻 (请求和应答的中点)
+    uint32_t rtt_us;
+} clock_sample_t;
+
+// 配置与任务
+static audio_sync_config_t cfg;
+static volatile bool running = false;
+static SemaphoreHandle_t exit_sem = NULL;
+static int data_sock = -1;
+static int clock_sock = -1;
+static audio_mixer_source_t sync_source = NULL;
+static uint8_t device_id[6];
+
+// 抖动缓冲区 (交织立体声，下标 = RTP 时间戳 & jb_mask)
+static SemaphoreHandle_t jb_lock = NULL;
+static int16_t *jb_buf = NULL;
+static uint32_t jb_mask = 0;
+static uint32_t jb_read_ts = 0;         // 播放位置 (播放前为保留的最早位置)
+static uint32_t jb_high_ts = 0;         // 已到达数据的末尾
+static bool jb_has_data = false;
+
+// 数据流 (接收任务写，持 jb_lock)
+static audio_sync_state_t state = AUDIO_SYNC_STATE_IDLE;
+static uint32_t stream_ssrc = 0;
+static uint16_t last_seq = 0;
+static int64_t last_packet_us = 0;
+static uint32_t anchor_ts = 0;          // 最近一个包的时间戳
+static int64_t anchor_pres_us = 0;      // 及其出声时刻 (发送端时钟)
+static int64_t last_transit_us = 0;
+static bool transit_valid = false;
+static struct sockaddr_in sender_addr;
+static bool sender_known = false;
+
+// 时钟同步 (接收任务)
+static clock_sample_t clock_samples[SYNC_CLOCK_WINDOW];
+static uint32_t clock_replies = 0;
+static uint32_t clock_seq = 0;
+static int64_t next_clock_req_us = 0;
+static volatile bool clock_valid = false;
+static clock_sample_t rate_ref;         // 频差估计的基准样本
+static bool rate_ref_valid = false;
+
+// 漂移修正 (播放任务)
+static audio_resampler_t resampler;
+static int16_t in_block[SYNC_BLOCK_FRAMES * AUDIO_SYNC_CHANNELS] __attribute__((aligned(16)));
+static int16_t *out_block = NULL;
+static size_t out_block_frames = 0;
+static int64_t err_filt_us = 0;
+static int64_t err_integ_us_s = 0;      // 积分项 (微秒·毫秒)
+static int64_t ff_rate_ppb = 0;         // 积分项对应的前馈频差
+static uint32_t settle_blocks = 0;      // 开始播放后等待 I2S 延迟稳定的剩余块数
+static int64_t settle_err_sum_us = 0;
+static int64_t i2s_latency_us = 0;      // 平滑后的 I2S 实测延迟
+
+// 统计
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static audio_sync_stats_t stats;
+static int64_t clock_offset_at_us = 0;  // stats.clock_offset_us 对应的本地时刻
+static int64_t resample_us = 0;
+static uint64_t resample_frames = 0;
+
+/**
+ * @brief 大端读取
+ */
+static inline uint16_t sync_be16(const uint8_t *p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static inline uint32_t sync_be32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+/**
+ * @brief 当前时钟偏移 (发送端时钟 - 本地时钟，按频差外推到现在)
+ */
+static int64_t sync_clock_offset(void)
+{
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&stats_lock);
+    int64_t offset = stats.clock_offset_us + stats.clock_rate_ppb * (now - clock_offset_at_us) / 1000000000;
+    portEXIT_CRITICAL(&stats_lock);
+    return offset;
+}
+
+/**
+ * @brief 发送端时钟相对本地时钟的频差 (采样率修正的前馈)
+ */
+static int64_t sync_clock_rate(void)
+{
+    portENTER_CRITICAL(&stats_lock);
+    int64_t rate = stats.clock_rate_ppb;
+    portEXIT_CRITICAL(&stats_lock);
+    return rate;
+}
+
+/**
+ * @brief 时间戳 ts 的计划出声时刻 (发送端时钟，持 jb_lock 时调用)
+ */
+static int64_t sync_pres_time(uint32_t ts)
+{
+    int32_t d = (int32_t)(ts - anchor_ts);
+    return anchor_pres_us + (int64_t)d * 1000000 / AUDIO_SYNC_SAMPLE_RATE;
+}
+
+/**
+ * @brief 清零 [jb_read_ts, ts) 并把读位置移到 ts (持 jb_lock 时调用)
+ */
+static void jb_discard_until(uint32_t ts)
+{
+    uint32_t n = ts - jb_read_ts;
+    if (n > jb_mask + 1) {
+        n = jb_mask + 1;
+    }
+    uint32_t idx = jb_read_ts & jb_mask;
+    uint32_t first = jb_mask + 1 - idx;
+    if (first > n) {
+        first = n;
+    }
+    memset(jb_buf + idx * AUDIO_SYNC_CHANNELS, 0, first * AUDIO_SYNC_CHANNELS * sizeof(int16_t));
+    memset(jb_buf, 0, (n - first) * AUDIO_SYNC_CHANNELS * sizeof(int16_t));
+    jb_read_ts = ts;
+}
+
+/**
+ * @brief 清空数据流状态 (持 jb_lock 时调用)
+ */
+static void sync_reset_stream(void)
+{
+    memset(jb_buf, 0, (jb_mask + 1) * AUDIO_SYNC_CHANNELS * sizeof(int16_t));
+    jb_has_data = false;
+    state = AUDIO_SYNC_STATE_IDLE;
+    transit_valid = false;
+}
+
+/**
+ * @brief 处理一个 RTP 包
+ */
+static void sync_handle_rtp(const uint8_t *pkt, size_t len, const struct sockaddr_in *from, int64_t now)
+{
+    if (len < RTP_HEADER_SIZE || (pkt[0] >> 6) != 2 || (pkt[1] & 0x7F) != AUDIO_SYNC_RTP_PT) {
+        return;
+    }
+    bool has_ext = (pkt[0] & 0x10) != 0;
+    size_t off = RTP_HEADER_SIZE + (pkt[0] & 0x0F) * 4;
+    if (!has_ext || len < off + 12 || sync_be16(pkt + off) != AUDIO_SYNC_EXT_PROFILE ||
+        sync_be16(pkt + off + 2) < 2) {
+        return;
+    }
+
+    uint16_t seq = sync_be16(pkt + 2);
+    uint32_t ts = sync_be32(pkt + 4);
+    uint32_t ssrc = sync_be32(pkt + 8);
+    int64_t pres = (int64_t)(((uint64_t)sync_be32(pkt + off + 4) << 32) | sync_be32(pkt + off + 8));
+    size_t payload_off = off + 4 + sync_be16(pkt + off + 2) * 4;
+    if (payload_off > len) {
+        return;
+    }
+    const uint8_t *payload = pkt + payload_off;
+    uint32_t frames = (len - payload_off) / (AUDIO_SYNC_CHANNELS * sizeof(int16_t));
+
+    xSemaphoreTake(jb_lock, portMAX_DELAY);
+
+    // 新的数据流
+    if (state == AUDIO_SYNC_STATE_IDLE || ssrc != stream_ssrc) {
+        if (state != AUDIO_SYNC_STATE_IDLE) {
+            ESP_LOGW(TAG, "数据流切换 (SSRC %08lx -> %08lx)", (unsigned long)stream_ssrc, (unsigned long)ssrc);
+        }
+        sync_reset_stream();
+        stream_ssrc = ssrc;
+        last_seq = seq - 1;
+        jb_read_ts = ts;
+        jb_high_ts = ts;
+        state = AUDIO_SYNC_STATE_SYNCING;
+        ESP_LOGI(TAG, "收到数据流 (SSRC %08lx)", (unsigned long)ssrc);
+    }
+
+    // 发送端地址 (时钟同步请求发往此地址)
+    if (!sender_known || sender_addr.sin_addr.s_addr != from->sin_addr.s_addr) {
+        sender_addr = *from;
+        sender_addr.sin_port = htons(cfg.clock_port);
+        sender_known = true;
+        clock_valid = false;
+        clock_replies = 0;
+        rate_ref_valid = false;
+        portENTER_CRITICAL(&stats_lock);
+        stats.clock_rate_ppb = 0;
+        portEXIT_CRITICAL(&stats_lock);
+        next_clock_req_us = now;
+    }
+
+    last_packet_us = now;
+
+    // 序号：缺口计为丢包，落后的包计为乱序
+    int16_t gap = (int16_t)(seq - (uint16_t)(last_seq + 1));
+    portENTER_CRITICAL(&stats_lock);
+    stats.packets++;
+    if (gap > 0) {
+        stats.lost += gap;
+    } else if (gap < 0) {
+        stats.reordered++;
+        if (stats.lost > 0) {
+            stats.lost--;
+        }
+    }
+    portEXIT_CRITICAL(&stats_lock);
+    if (gap >= 0) {
+        last_seq = seq;
+        anchor_ts = ts;
+        anchor_pres_us = pres;
+    }
+
+    // 到达抖动：到达时刻 (换算为发送端时钟) 与出声时刻之差的变化
+    if (clock_valid) {
+        int64_t transit = now + sync_clock_offset() - pres;
+        if (transit_valid) {
+            int64_t d = transit - last_transit_us;
+            if (d < 0) {
+                d = -d;
+            }
+            if (d > 1000000) {
+                d = 1000000;
+            }
+            portENTER_CRITICAL(&stats_lock);
+            stats.jitter_us += ((int32_t)d - (int32_t)stats.jitter_us) / 16;
+            portEXIT_CRITICAL(&stats_lock);
+        }
+        last_transit_us = transit;
+        transit_valid = true;
+    }
+
+    // 已经播放过的部分丢弃
+    int32_t ahead = (int32_t)(ts - jb_read_ts);
+    if (ahead < 0) {
+        if ((int32_t)(ahead + frames) <= 0) {
+            portENTER_CRITICAL(&stats_lock);
+            stats.late++;
+            portEXIT_CRITICAL(&stats_lock);
+            xSemaphoreGive(jb_lock);
+            return;
+        }
+        payload += (uint32_t)(-ahead) * AUDIO_SYNC_CHANNELS * sizeof(int16_t);
+        frames -= (uint32_t)(-ahead);
+        ts = jb_read_ts;
+    }
+
+    // 超出缓冲区容量：播放前丢弃最早的数据，播放中说明播放延迟大于缓冲区
+    uint32_t end = ts + frames;
+    if ((uint32_t)(end - jb_read_ts) > jb_mask + 1) {
+        if (state == AUDIO_SYNC_STATE_PLAYING) {
+            ESP_LOGW(TAG, "抖动缓冲区溢出，请减小发送端播放延迟或增大 buffer_frames");
+        }
+        jb_discard_until(end - (jb_mask + 1));
+    }
+
+    // 大端 L16 写入缓冲区
+    for (uint32_t i = 0; i < frames; i++) {
+        int16_t *dst = jb_buf + ((ts + i) & jb_mask) * AUDIO_SYNC_CHANNELS;
+        const uint8_t *src = payload + i * AUDIO_SYNC_CHANNELS * sizeof(int16_t);
+        dst[0] = (int16_t)sync_be16(src);
+        dst[1] = (int16_t)sync_be16(src + 2);
+    }
+    if (!jb_has_data || (int32_t)(end - jb_high_ts) > 0) {
+        jb_high_ts = end;
+    }
+    jb_has_data = true;
+
+    xSemaphoreGive(jb_lock);
+}
+
+/**
+ * @brief 发送时钟同步请求 (附带本机状态)
+ */
+static void sync_send_clock_request(int64_t now)
+{
+    audio_sync_clock_msg_t msg = { 0 };
+    msg.magic = AUDIO_SYNC_CLOCK_MAGIC;
+    msg.type = 0;
+    msg.seq = ++clock_seq;
+    msg.t1_us = now;
+
+    portENTER_CRITICAL(&stats_lock);
+    msg.playout_error_us = stats.playout_error_us;
+    msg.jitter_us = stats.jitter_us;
+    msg.late = stats.late;
+    msg.lost = stats.lost;
+    portEXIT_CRITICAL(&stats_lock);
+    memcpy(msg.device_id, device_id, sizeof(device_id));
+
+    sendto(clock_sock, &msg, sizeof(msg), 0, (const struct sockaddr *)&sender_addr, sizeof(sender_addr));
+}
+
+/**
+ * @brief 处理时钟同步应答
+ */
+static void sync_handle_clock_reply(const audio_sync_clock_msg_t *msg, int64_t t4)
+{
+    if (msg->magic != AUDIO_SYNC_CLOCK_MAGIC || msg->type != 1 || msg->seq != clock_seq) {
+        return;     // 过期或无关的应答
+    }
+
+    int64_t rtt = (t4 - msg->t1_us) - (msg->t3_us - msg->t2_us);
+    if (rtt < 0) {
+        rtt = 0;
+    }
+    clock_sample_t *sample = &clock_samples[clock_replies % SYNC_CLOCK_WINDOW];
+    sample->offset_us = ((msg->t2_us - msg->t1_us) + (msg->t3_us - t4)) / 2;
+    sample->local_us = msg->t1_us + (t4 - msg->t1_us) / 2;
+    sample->rtt_us = (uint32_t)rtt;
+    clock_replies++;
+
+    // 往返时间最短的样本受排队影响最小；旧样本按 SYNC_CLOCK_AGE_PPM 折算老化误差，
+    // 避免快速同步阶段的样本在窗口内一直被选中 (偏移停在几秒前，频差基线也不前进)
+    uint32_t n = (clock_replies < SYNC_CLOCK_WINDOW) ? clock_replies : SYNC_CLOCK_WINDOW;
+    const clock_sample_t *best = NULL;
+    int64_t best_score = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        int64_t score = clock_samples[i].rtt_us +
+                        2 * (t4 - clock_samples[i].local_us) * SYNC_CLOCK_AGE_PPM / 1000000;
+        if (best == NULL || score < best_score) {
+            best = &clock_samples[i];
+            best_score = score;
+        }
+    }
+
+    // 频差：与足够早的基准样本比较 (基线越长，单个样本的误差影响越小)
+    int64_t rate_ppb = stats.clock_rate_ppb;
+    if (!rate_ref_valid) {
+        rate_ref = *best;
+        rate_ref_valid = true;
+    } else if (best->local_us - rate_ref.local_us >= SYNC_RATE_MIN_BASE_US) {
+        int64_t base = best->local_us - rate_ref.local_us;
+        rate_ppb = (best->offset_us - rate_ref.offset_us) * 1000000000 / base;
+        if (rate_ppb > SYNC_RATE_MAX_PPB) {
+            rate_ppb = SYNC_RATE_MAX_PPB;
+        } else if (rate_ppb < -SYNC_RATE_MAX_PPB) {
+            rate_ppb = -SYNC_RATE_MAX_PPB;
+        }
+        if (base >= SYNC_RATE_MAX_BASE_US) {
+            rate_ref = *best;
+        }
+    }
+
+    // 最好的样本可能是几秒前的，按频差外推到现在
+    int64_t offset = best->offset_us + rate_ppb * (t4 - best->local_us) / 1000000000;
+
+    portENTER_CRITICAL(&stats_lock);
+    if (!clock_valid) {
+        stats.clock_offset_us = offset;
+    } else {
+        // 平滑过渡，避免出声时刻跳变 (先按频差推进上次的估计，平滑不引入滞后)
+        stats.clock_offset_us += stats.clock_rate_ppb * (t4 - clock_offset_at_us) / 1000000000;
+        stats.clock_offset_us += (offset - stats.clock_offset_us) / 4;
+    }
+    clock_offset_at_us = t4;
+    stats.clock_rate_ppb = (int32_t)rate_ppb;
+    stats.clock_rtt_us = best->rtt_us;
+    portEXIT_CRITICAL(&stats_lock);
+
+    if (!clock_valid && clock_replies >= 2) {
+        clock_valid = true;
+        ESP_LOGI(TAG, "时钟已同步: 偏移 %lld us, 往返 %lu us",
+                 (long long)best->offset_us, (unsigned long)best->rtt_us);
+    }
+}
+
+/**
+ * @brief 接收任务
+ */
+static void sync_rx_task(void *pvParameters)
+{
+    static uint8_t pkt[SYNC_MAX_PACKET];
+
+    while (running) {
+        fd_set rfds;
+        FD_ZERO(&rfds);
+        FD_SET(data_sock, &rfds);
+        FD_SET(clock_sock, &rfds);
+        struct timeval tv = { .tv_sec = 0, .tv_usec = 20000 };
+        int maxfd = (data_sock > clock_sock) ? data_sock : clock_sock;
+
+        int ready = select(maxfd + 1, &rfds, NULL, NULL, &tv);
+        int64_t now = esp_timer_get_time();
+
+        if (ready > 0 && FD_ISSET(data_sock, &rfds)) {
+            struct sockaddr_in from;
+            socklen_t from_len = sizeof(from);
+            int n = recvfrom(data_sock, pkt, sizeof(pkt), 0, (struct sockaddr *)&from, &from_len);
+            if (n > 0) {
+                sync_handle_rtp(pkt, (size_t)n, &from, now);
+            }
+        }
+        if (ready > 0 && FD_ISSET(clock_sock, &rfds)) {
+            audio_sync_clock_msg_t msg;
+            int n = recv(clock_sock, &msg, sizeof(msg), 0);
+            if (n == sizeof(msg)) {
+                sync_handle_clock_reply(&msg, esp_timer_get_time());
+            }
+        }
+
+        // 定期时钟同步
+        if (sender_known && now >= next_clock_req_us) {
+            sync_send_clock_request(esp_timer_get_time());
+            next_clock_req_us = now + ((clock_replies < SYNC_CLOCK_FAST_COUNT) ?
+                                       SYNC_CLOCK_FAST_US : SYNC_CLOCK_SLOW_US);
+        }
+
+        // 数据流超时
+        if (state != AUDIO_SYNC_STATE_IDLE && now - last_packet_us > SYNC_STREAM_TIMEOUT_US) {
+            xSemaphoreTake(jb_lock, portMAX_DELAY);
+            if (state == AUDIO_SYNC_STATE_SYNCING) {
+                sync_reset_stream();
+            }
+            xSemaphoreGive(jb_lock);
+        }
+    }
+
+    xSemaphoreGive(exit_sem);
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief 估算现在写入混音器的采样何时出声 (本地时钟)
+ */
+static int64_t sync_output_time(int64_t now)
+{
+    audio_player_latency_t lat;
+    audio_player_get_latency(&lat);
+    int64_t measured = (lat.samples > 0) ? lat.last_us : lat.dma_depth_us;
+    i2s_latency_us = (i2s_latency_us == 0) ? measured : i2s_latency_us + (measured - i2s_latency_us) / 8;
+
+    // 采样率转换器的群延迟约为半个滤波器长度
+    int64_t fill = (int64_t)audio_mixer_get_fill(sync_source);
+    int64_t rs_delay = (int64_t)(resampler.taps / 2) * 1000000 / AUDIO_SYNC_SAMPLE_RATE;
+    return now + fill * 1000000 / audio_player_get_sample_rate() + i2s_latency_us + rs_delay;
+}
+
+/**
+ * @brief 混音器的音源是否都没有数据 (此时 I2S DMA 队列已经取空)
+ */
+static bool sync_output_idle(void)
+{
+    audio_mixer_stats_t mix;
+    audio_mixer_get_stats(&mix);
+    for (uint8_t i = 0; i < mix.num_sources; i++) {
+        if (mix.sources[i].active) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 开始播放：把读位置对齐到现在写入时应当出声的位置 (持 jb_lock 时调用)
+ *
+ * @param now 当前时刻
+ * @param pad_frames 输出：开始前需要补的静音帧数 (最早的数据略晚于现在可输出的时刻)
+ * @return 可以开始
+ */
+static bool sync_try_start(int64_t now, uint32_t *pad_frames)
+{
+    int64_t target = sync_output_time(now) + sync_clock_offset();
+    int32_t d = (int32_t)((target - anchor_pres_us) * AUDIO_SYNC_SAMPLE_RATE / 1000000);
+    uint32_t start_ts = anchor_ts + d;
+
+    *pad_frames = 0;
+    int32_t early = (int32_t)(jb_read_ts - start_ts);
+    if (early > SYNC_BLOCK_FRAMES) {
+        return false;       // 最早的数据还不该播放：等待
+    }
+    if (early > 0) {
+        *pad_frames = (uint32_t)early;
+    } else {
+        // 对应的数据还没到：等待
+        if ((int32_t)(jb_high_ts - (start_ts + SYNC_BLOCK_FRAMES)) < 0) {
+            return false;
+        }
+        jb_discard_until(start_ts);
+    }
+
+    // 其他音源都没有在播放时混音任务空闲、I2S DMA 已取空：先补 DMA 深度的静音，
+    // 否则开头几千帧立即被取走，读位置越过还没到达的数据 (之后到达的包都算迟到)
+    if (sync_output_idle()) {
+        audio_player_latency_t lat;
+        audio_player_get_latency(&lat);
+        *pad_frames += lat.dma_desc_num * lat.dma_frame_num;
+    }
+
+    audio_resampler_reset(&resampler);
+    ff_rate_ppb = sync_clock_rate();
+    audio_resampler_set_drift(&resampler, (int32_t)ff_rate_ppb);
+    err_filt_us = 0;
+    err_integ_us_s = 0;
+    settle_blocks = 2 * SYNC_ERR_FILTER;
+    settle_err_sum_us = 0;
+    state = AUDIO_SYNC_STATE_PLAYING;
+    ESP_LOGI(TAG, "开始同步播放 (缓冲 %lu 帧)", (unsigned long)(jb_high_ts - jb_read_ts));
+    return true;
+}
+
+/**
+ * @brief 写入混音器 (漂移修正后)
+ */
+static void sync_output(const int16_t *pcm, size_t frames)
+{
+    int64_t t0 = esp_timer_get_time();
+    size_t used_total = 0;
+    size_t produced_total = 0;
+
+    while (used_total < frames) {
+        size_t used = 0;
+        size_t produced = audio_resampler_process(&resampler, pcm + used_total * AUDIO_SYNC_CHANNELS,
+                                                  frames - used_total, &used, out_block, out_block_frames);
+        used_total += used;
+        produced_total += produced;
+        if (produced > 0) {
+            audio_mixer_write(sync_source, out_block, produced * AUDIO_SYNC_CHANNELS * sizeof(int16_t),
+                              SYNC_WRITE_TIMEOUT_MS);
+        }
+        if (used == 0 && produced == 0) {
+            break;
+        }
+    }
+
+    int64_t elapsed = esp_timer_get_time() - t0;
+    portENTER_CRITICAL(&stats_lock);
+    resample_us += elapsed;
+    resample_frames += frames;
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+/**
+ * @brief 写入静音 (推迟出声)
+ */
+static void sync_output_silence(uint32_t frames)
+{
+    memset(in_block, 0, sizeof(in_block));
+    while (frames > 0) {
+        uint32_t n = (frames > SYNC_BLOCK_FRAMES) ? SYNC_BLOCK_FRAMES : frames;
+        audio_mixer_write(sync_source, in_block, n * AUDIO_SYNC_CHANNELS * sizeof(int16_t), SYNC_WRITE_TIMEOUT_MS);
+        frames -= n;
+    }
+}
+
+/**
+ * @brief 按误差跳过数据或补静音重新对齐，清零控制器状态
+ *
+ * @param jump_us 出声误差 (正值表示落后)
+ */
+static void sync_realign(int64_t jump_us)
+{
+    uint32_t frames = (uint32_t)((jump_us < 0 ? -jump_us : jump_us) * AUDIO_SYNC_SAMPLE_RATE / 1000000);
+    if (jump_us > 0) {
+        // 落后：跳过数据
+        xSemaphoreTake(jb_lock, portMAX_DELAY);
+        jb_discard_until(jb_read_ts + frames);
+        xSemaphoreGive(jb_lock);
+    } else {
+        // 超前：补静音
+        sync_output_silence(frames);
+    }
+    ESP_LOGW(TAG, "出声误差 %lld us，%s %lu 帧重新对齐", (long long)jump_us,
+             jump_us > 0 ? "跳过" : "补静音", (unsigned long)frames);
+    err_filt_us = 0;
+    err_integ_us_s = 0;
+    int64_t rate = sync_clock_rate();
+    ff_rate_ppb = rate;
+    audio_resampler_set_drift(&resampler, (int32_t)rate);
+    portENTER_CRITICAL(&stats_lock);
+    stats.resyncs++;
+    stats.drift_ppb = (int32_t)rate;
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+/**
+ * @brief 根据出声误差更新采样率修正，误差过大时重新对齐
+ *
+ * @param err_us 本块实际出声 - 计划出声 (正值表示落后)
+ */
+static void sync_control(int64_t err_us)
+{
+    // 开始播放后 I2S 队列从空逐渐填满，实测延迟还在变化：先等待，再取一段平均误差一次对齐
+    if (settle_blocks > 0) {
+        settle_blocks--;
+        if (settle_blocks < SYNC_ERR_FILTER) {
+            settle_err_sum_us += err_us;
+        }
+        if (settle_blocks == 0) {
+            int64_t mean = settle_err_sum_us / SYNC_ERR_FILTER;
+            if (mean > SYNC_START_ALIGN_US || mean < -SYNC_START_ALIGN_US) {
+                sync_realign(mean);
+            } else {
+                err_filt_us = mean;
+            }
+        }
+        return;
+    }
+
+    err_filt_us += (err_us - err_filt_us) / SYNC_ERR_FILTER;
+
+    if (err_filt_us > SYNC_RESYNC_US || err_filt_us < -SYNC_RESYNC_US) {
+        // 平滑值越过阈值时还落后于实际误差：本块误差同号且不超过平滑值两倍时按本块误差对齐
+        int64_t jump = err_filt_us;
+        int64_t err_abs = (err_us < 0) ? -err_us : err_us;
+        int64_t filt_abs = (err_filt_us < 0) ? -err_filt_us : err_filt_us;
+        if ((err_us > 0) == (err_filt_us > 0) && err_abs > filt_abs && err_abs <= 2 * filt_abs) {
+            jump = err_us;
+        }
+        sync_realign(jump);
+        return;
+    }
+
+    // 前馈频差变化时，积分项中已经累积的同向部分移交给前馈，积分项不会在前馈生效后过冲
+    int64_t rate = sync_clock_rate();
+    int64_t delta = rate - ff_rate_ppb;
+    int64_t integ_ppb = SYNC_KP_PPB_PER_US * err_integ_us_s / (SYNC_TI_S * 1000);
+    if ((delta > 0 && integ_ppb > 0) || (delta < 0 && integ_ppb < 0)) {
+        int64_t moved = (delta > 0) ? (delta < integ_ppb ? delta : integ_ppb)
+                                    : (delta > integ_ppb ? delta : integ_ppb);
+        err_integ_us_s -= moved * SYNC_TI_S * 1000 / SYNC_KP_PPB_PER_US;
+    }
+    ff_rate_ppb = rate;
+
+    // PI 控制 (积分项以 微秒·毫秒 为单位累加，避免整数截断)
+    err_integ_us_s += err_filt_us * SYNC_BLOCK_FRAMES * 1000 / AUDIO_SYNC_SAMPLE_RATE;
+    int64_t integ_limit = (int64_t)SYNC_MAX_DRIFT_PPB * SYNC_TI_S * 1000 / SYNC_KP_PPB_PER_US;
+    if (err_integ_us_s > integ_limit) {
+        err_integ_us_s = integ_limit;
+    } else if (err_integ_us_s < -integ_limit) {
+        err_integ_us_s = -integ_limit;
+    }
+
+    int64_t ppb = rate + SYNC_KP_PPB_PER_US * (err_filt_us + err_integ_us_s / (SYNC_TI_S * 1000));
+    if (ppb > SYNC_MAX_DRIFT_PPB) {
+        ppb = SYNC_MAX_DRIFT_PPB;
+    } else if (ppb < -SYNC_MAX_DRIFT_PPB) {
+        ppb = -SYNC_MAX_DRIFT_PPB;
+    }
+    audio_resampler_set_drift(&resampler, (int32_t)ppb);
+
+    portENTER_CRITICAL(&stats_lock);
+    stats.playout_error_us = (int32_t)err_filt_us;
+    stats.drift_ppb = (int32_t)ppb;
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+/**
+ * @brief 播放任务
+ */
+static void sync_play_task(void *pvParameters)
+{
+    while (running) {
+        int64_t now = esp_timer_get_time();
+
+        xSemaphoreTake(jb_lock, portMAX_DELAY);
+
+        if (state == AUDIO_SYNC_STATE_SYNCING) {
+            uint32_t pad = 0;
+            bool started = clock_valid && jb_has_data && sync_try_start(now, &pad);
+            xSemaphoreGive(jb_lock);
+            if (!started) {
+                vTaskDelay(pdMS_TO_TICKS(2));
+            } else if (pad > 0) {
+                sync_output_silence(pad);
+            }
+            continue;
+        }
+
+        if (state != AUDIO_SYNC_STATE_PLAYING) {
+            xSemaphoreGive(jb_lock);
+            vTaskDelay(pdMS_TO_TICKS(20));
+            continue;
+        }
+
+        // 数据流结束且缓冲已播放完
+        bool stream_gone = (now - last_packet_us > SYNC_STREAM_TIMEOUT_US);
+        if (stream_gone && (int32_t)(jb_high_ts - jb_read_ts) <= 0) {
+            sync_reset_stream();
+            xSemaphoreGive(jb_lock);
+            audio_mixer_drain(sync_source, 1000);
+            ESP_LOGI(TAG, "数据流结束");
+            continue;
+        }
+
+        // 取一块数据 (未到达的部分为静音)，读过的位置清零
+        uint32_t ts = jb_read_ts;
+        int64_t pres = sync_pres_time(ts);
+        int64_t offset = sync_clock_offset();
+        uint32_t idx = ts & jb_mask;
+        uint32_t first = jb_mask + 1 - idx;
+        if (first > SYNC_BLOCK_FRAMES) {
+            first = SYNC_BLOCK_FRAMES;
+        }
+        memcpy(in_block, jb_buf + idx * AUDIO_SYNC_CHANNELS, first * AUDIO_SYNC_CHANNELS * sizeof(int16_t));
+        memcpy(in_block + first * AUDIO_SYNC_CHANNELS, jb_buf,
+               (SYNC_BLOCK_FRAMES - first) * AUDIO_SYNC_CHANNELS * sizeof(int16_t));
+        jb_discard_until(ts + SYNC_BLOCK_FRAMES);
+
+        int32_t buffered = (int32_t)(jb_high_ts - jb_read_ts);
+        xSemaphoreGive(jb_lock);
+
+        portENTER_CRITICAL(&stats_lock);
+        stats.buffered_ms = (buffered > 0) ? (uint32_t)buffered * 1000 / AUDIO_SYNC_SAMPLE_RATE : 0;
+        portEXIT_CRITICAL(&stats_lock);
+
+        // 本块实际出声时刻与计划时刻之差
+        int64_t err = sync_output_time(esp_timer_get_time()) - (pres - offset);
+        sync_control(err);
+
+        sync_output(in_block, SYNC_BLOCK_FRAMES);
+    }
+
+    xSemaphoreGive(exit_sem);
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief 创建组播接收和时钟同步套接字
+ */
+static esp_err_t sync_open_sockets(void)
+{
+    data_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    clock_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (data_sock < 0 || clock_sock < 0) {
+        ESP_LOGE(TAG, "创建套接字失败");
+        return ESP_FAIL;
+    }
+
+    int reuse = 1;
+    setsockopt(data_sock, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(cfg.port),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+    if (bind(data_sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        ESP_LOGE(TAG, "绑定端口 %u 失败", cfg.port);
+        return ESP_FAIL;
+    }
+
+    struct ip_mreq mreq = { 0 };
+    if (inet_aton(cfg.group, &mreq.imr_multiaddr) == 0) {
+        ESP_LOGE(TAG, "组播地址无效: %s", cfg.group);
+        return ESP_ERR_INVALID_ARG;
+    }
+    mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+    if (setsockopt(data_sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+        ESP_LOGE(TAG, "加入组播组 %s 失败", cfg.group);
+        return ESP_FAIL;
+    }
+
+    // 时钟同步套接字绑定任意端口，应答发回同一端口
+    struct sockaddr_in local = {
+        .sin_family = AF_INET,
+        .sin_port = 0,
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+    if (bind(clock_sock, (struct sockaddr *)&local, sizeof(local)) < 0) {
+        ESP_LOGE(TAG, "绑定时钟同步套接字失败");
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+/**
+ * @brief 关闭套接字并释放缓冲区
+ */
+static void sync_cleanup(void)
+{
+    if (data_sock >= 0) {
+        close(data_sock);
+        data_sock = -1;
+    }
+    if (clock_sock >= 0) {
+        close(clock_sock);
+        clock_sock = -1;
+    }
+    heap_caps_free(jb_buf);
+    jb_buf = NULL;
+    heap_caps_free(out_block);
+    out_block = NULL;
+    audio_resampler_deinit(&resampler);
+}
+
+/**
+ * @brief 开始同步播放
+ */
+esp_err_t audio_sync_start(const audio_sync_config_t *config)
+{
+    if (running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (config != NULL) {
+        cfg = *config;
+    } else {
+        audio_sync_config_t def = AUDIO_SYNC_DEFAULT_CONFIG();
+        cfg = def;
+    }
+    if (cfg.buffer_frames < SYNC_BLOCK_FRAMES * 4 || (cfg.buffer_frames & (cfg.buffer_frames - 1)) != 0) {
+        ESP_LOGE(TAG, "buffer_frames 必须是 2 的幂且不小于 %d", SYNC_BLOCK_FRAMES * 4);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // 混音器音源 (只注册一次，可被提示音闪避)
+    if (sync_source == NULL) {
+        const audio_mixer_source_config_t src_cfg = {
+            .name = "sync",
+            .channels = AUDIO_SYNC_CHANNELS,
+            .ring_frames = SYNC_SOURCE_FRAMES,
+            .gain_q15 = AUDIO_DSP_Q15_ONE,
+            .duckable = true,
+            .ducks_others = false,
+        };
+        esp_err_t ret = audio_mixer_add_source(&src_cfg, &sync_source);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+    if (jb_lock == NULL) {
+        jb_lock = xSemaphoreCreateMutex();
+        exit_sem = xSemaphoreCreateCounting(2, 0);
+        if (jb_lock == NULL || exit_sem == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    // 抖动缓冲区优先放在 PSRAM
+    size_t jb_bytes = cfg.buffer_frames * AUDIO_SYNC_CHANNELS * sizeof(int16_t);
+    jb_buf = heap_caps_malloc(jb_bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (jb_buf == NULL) {
+        jb_buf = heap_caps_malloc(jb_bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    jb_mask = cfg.buffer_frames - 1;
+
+    // 漂移修正：流采样率 -> I2S 采样率，比例可微调
+    esp_err_t ret = audio_resampler_init_variable(&resampler, AUDIO_SYNC_SAMPLE_RATE,
+                                                  audio_player_get_sample_rate(),
+                                                  AUDIO_SYNC_CHANNELS, cfg.quality);
+    if (ret == ESP_OK) {
+        out_block_frames = audio_resampler_max_output(&resampler, SYNC_BLOCK_FRAMES);
+        out_block = heap_caps_aligned_alloc(AUDIO_DSP_ALIGN,
+                                            out_block_frames * AUDIO_SYNC_CHANNELS * sizeof(int16_t),
+                                            MALLOC_CAP_INTERNAL);
+    }
+    if (ret != ESP_OK || jb_buf == NULL || out_block == NULL) {
+        ESP_LOGE(TAG, "内存分配失败");
+        sync_cleanup();
+        return (ret != ESP_OK) ? ret : ESP_ERR_NO_MEM;
+    }
+
+    ret = sync_open_sockets();
+    if (ret != ESP_OK) {
+        sync_cleanup();
+        return ret;
+    }
+
+    esp_read_mac(device_id, ESP_MAC_WIFI_STA);
+    memset(&stats, 0, sizeof(stats));
+    memset(clock_samples, 0, sizeof(clock_samples));
+    clock_replies = 0;
+    clock_valid = false;
+    rate_ref_valid = false;
+    sender_known = false;
+    i2s_latency_us = 0;
+    resample_us = 0;
+    resample_frames = 0;
+    sync_reset_stream();
+
+    running = true;
+    if (xTaskCreate(sync_rx_task, "sync_rx", 4096, NULL, cfg.task_priority, NULL) != pdPASS) {
+        running = false;
+        sync_cleanup();
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTaskCreatePinnedToCore(sync_play_task, "sync_play", 4096, NULL, cfg.task_priority, NULL, 1) != pdPASS) {
+        running = false;
+        xSemaphoreTake(exit_sem, portMAX_DELAY);
+        sync_cleanup();
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "同步播放已启动 (组播 %s:%u, 抖动缓冲 %lu 帧)",
+             cfg.group, cfg.port, (unsigned long)cfg.buffer_frames);
+    return ESP_OK;
+}
+
+/**
+ * @brief 停止同步播放
+ */
+esp_err_t audio_sync_stop(void)
+{
+    if (!running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    running = false;
+    xSemaphoreTake(exit_sem, portMAX_DELAY);
+    xSemaphoreTake(exit_sem, portMAX_DELAY);
+
+    audio_mixer_drain(sync_source, 1000);
+    sync_cleanup();
+    state = AUDIO_SYNC_STATE_IDLE;
+    ESP_LOGI(TAG, "同步播放已停止");
+    return ESP_OK;
+}
+
+/**
+ * @brief 获取统计
+ */
+void audio_sync_get_stats(audio_sync_stats_t *out)
+{
+    portENTER_CRITICAL(&stats_lock);
+    *out = stats;
+    out->state = state;
+    out->resample_us_per_s = (resample_frames > 0) ?
+        (uint32_t)((uint64_t)resample_us * AUDIO_SYNC_SAMPLE_RATE / resample_frames) : 0;
+    portEXIT_CRITICAL(&stats_lock);
+}
@@ -0,0 +1,451 @@
+/**
+ * @file audio_synth.c
+ * @brief 查表 DDS 音源与无缝音序器实现
+ *
+ * 相位累加器高 AUDIO_SYNTH_LUT_BITS 位作为正弦表下标，其后 15 位作为
+ * 线性插值系数。包络电平为 Q30，按采样线性步进；发音输出为
+ * 采样 × 包络 × 力度，在 32 位累加器中混音后饱和到 int16。
+ */
+
+#include "include/audio_synth.h"
+#include "include/audio_mixer.h"
+#include "include/audio_dsp.h"
+#include <string.h>
+#include <math.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+static const char *TAG = "audio_synth";
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define SYNTH_LUT_SIZE      (1 << AUDIO_SYNTH_LUT_BITS)
+#define SYNTH_FRAC_SHIFT    (32 - AUDIO_SYNTH_LUT_BITS - 15)
+#define SYNTH_ENV_ONE       (1 << 30)
+
+// 写入混音器的最长等待时间
+#define SYNTH_WRITE_TIMEOUT_MS  1000
+
+// 包络阶段
+typedef enum {
+    ENV_IDLE = 0,
+    ENV_ATTACK,
+    ENV_DECAY,
+    ENV_SUSTAIN,
+    ENV_RELEASE,
+} env_stage_t;
+
+// 发音
+typedef struct {
+    env_stage_t stage;
+    uint32_t phase;         // 相位累加器
+    uint32_t phase_inc;     // 每采样相位增量
+    uint16_t velocity;      // 力度 (Q15)
+    int32_t  level;         // 包络电平 (Q30)
+    int32_t  attack_step;
+    int32_t  decay_step;
+    int32_t  sustain;       // 持续电平 (Q30)
+    uint32_t release_samples;
+    int32_t  release_step;
+    uint32_t serial;        // 开始序号 (用于抢占最早的发音)
+    uint64_t off_at;        // 音序器: 松开的采样位置
+} synth_voice_t;
+
+// 正弦表 (多 1 项用于插值)
+static int16_t s_sine[SYNTH_LUT_SIZE + 1];
+
+static uint32_t sample_rate = 0;
+static audio_mixer_source_t tone_source = NULL;
+static synth_voice_t voices[AUDIO_SYNTH_MAX_VOICES];
+static uint32_t note_serial = 0;
+
+// 音序播放互斥：发音状态、渲染缓冲区和统计同一时间只属于一个调用者
+static SemaphoreHandle_t sequence_lock = NULL;
+
+// 渲染缓冲区
+static int32_t mix_buf[AUDIO_SYNTH_BLOCK_FRAMES];
+static int16_t out_buf[AUDIO_SYNTH_BLOCK_FRAMES] __attribute__((aligned(AUDIO_DSP_ALIGN)));
+
+// 统计
+static audio_synth_stats_t stats;
+
+/**
+ * @brief 初始化音源
+ */
+esp_err_t audio_synth_init(uint32_t rate)
+{
+    if (rate == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    for (int i = 0; i <= SYNTH_LUT_SIZE; i++) {
+        s_sine[i] = (int16_t)lrintf(32767.0f * sinf(2.0f * (float)M_PI * i / SYNTH_LUT_SIZE));
+    }
+
+    if (sequence_lock == NULL) {
+        sequence_lock = xSemaphoreCreateMutex();
+        if (sequence_lock == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    // 提示音音源：发声时闪避音乐
+    if (tone_source == NULL) {
+        const audio_mixer_source_config_t src_cfg = {
+            .name = "tone",
+            .channels = 1,
+            .ring_frames = AUDIO_SYNTH_RING_FRAMES,
+            .gain_q15 = AUDIO_DSP_Q15_ONE,
+            .duckable = false,
+            .ducks_others = true,
+        };
+        esp_err_t ret = audio_mixer_add_source(&src_cfg, &tone_source);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+
+    sample_rate = rate;
+    memset(voices, 0, sizeof(voices));
+    ESP_LOGI(TAG, "DDS 音源初始化完成 (%lu Hz, %d 发音, 正弦表 %d 点)",
+             (unsigned long)rate, AUDIO_SYNTH_MAX_VOICES, SYNTH_LUT_SIZE);
+    return ESP_OK;
+}
+
+/**
+ * @brief 毫秒换算为采样数 (至少 1)
+ */
+static uint32_t synth_ms_to_samples(uint32_t ms)
+{
+    uint32_t n = (uint32_t)(((uint64_t)ms * sample_rate) / 1000);
+    return n > 0 ? n : 1;
+}
+
+/**
+ * @brief 选择一个发音 (空闲 > 释音中电平最低 > 最早开始)
+ */
+static int synth_alloc_voice(void)
+{
+    int best = -1;
+
+    for (int i = 0; i < AUDIO_SYNTH_MAX_VOICES; i++) {
+        if (voices[i].stage == ENV_IDLE) {
+            return i;
+        }
+        if (voices[i].stage == ENV_RELEASE && (best < 0 || voices[i].level < voices[best].level)) {
+            best = i;
+        }
+    }
+    if (best >= 0) {
+        return best;
+    }
+
+    best = 0;
+    for (int i = 1; i < AUDIO_SYNTH_MAX_VOICES; i++) {
+        if ((int32_t)(voices[i].serial - voices[best].serial) < 0) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief 开始一个发音
+ */
+int audio_synth_note_on(float freq_hz, uint16_t velocity, const audio_synth_adsr_t *adsr)
+{
+    static const audio_synth_adsr_t default_adsr = AUDIO_SYNTH_DEFAULT_ADSR();
+    if (adsr == NULL) {
+        adsr = &default_adsr;
+    }
+
+    // 频率限制在奈奎斯特频率以下
+    float max_freq = sample_rate * 0.5f;
+    if (freq_hz < 0.0f) {
+        freq_hz = 0.0f;
+    } else if (freq_hz >= max_freq) {
+        freq_hz = max_freq - 1.0f;
+    }
+
+    int v = synth_alloc_voice();
+    synth_voice_t *voice = &voices[v];
+
+    // 抢占正在发音的 voice 时保留相位和电平，避免波形跳变
+    if (voice->stage == ENV_IDLE) {
+        voice->phase = 0;
+        voice->level = 0;
+    }
+    voice->phase_inc = (uint32_t)((double)freq_hz * 4294967296.0 / sample_rate);
+    voice->velocity = velocity;
+    voice->sustain = (int32_t)adsr->sustain << 15;
+    voice->attack_step = SYNTH_ENV_ONE / (int32_t)synth_ms_to_samples(adsr->attack_ms);
+    voice->decay_step = (SYNTH_ENV_ONE - voice->sustain) / (int32_t)synth_ms_to_samples(adsr->decay_ms);
+    if (voice->decay_step == 0) {
+        voice->decay_step = 1;
+    }
+    voice->release_samples = synth_ms_to_samples(adsr->release_ms);
+    voice->serial = note_serial++;
+    voice->off_at = UINT64_MAX;
+    voice->stage = ENV_ATTACK;
+    return v;
+}
+
+/**
+ * @brief 结束发音
+ */
+void audio_synth_note_off(int v)
+{
+    if (v < 0 || v >= AUDIO_SYNTH_MAX_VOICES) {
+        return;
+    }
+    synth_voice_t *voice = &voices[v];
+    if (voice->stage == ENV_IDLE || voice->stage == ENV_RELEASE) {
+        return;
+    }
+    voice->release_step = voice->level / (int32_t)voice->release_samples;
+    if (voice->release_step == 0) {
+        voice->release_step = 1;
+    }
+    voice->stage = ENV_RELEASE;
+}
+
+/**
+ * @brief 立即停止所有发音
+ */
+void audio_synth_all_off(void)
+{
+    for (int i = 0; i < AUDIO_SYNTH_MAX_VOICES; i++) {
+        voices[i].stage = ENV_IDLE;
+        voices[i].level = 0;
+    }
+}
+
+/**
+ * @brief 渲染一个发音并累加到混音缓冲区
+ */
+static void synth_render_voice(synth_voice_t *voice, int32_t *mix, size_t frames)
+{
+    uint32_t phase = voice->phase;
+    const uint32_t inc = voice->phase_inc;
+    const int32_t velocity = voice->velocity;
+    int32_t level = voice->level;
+
+    for (size_t i = 0; i < frames; i++) {
+        // 包络
+        switch (voice->stage) {
+            case ENV_ATTACK:
+                level += voice->attack_step;
+                if (level >= SYNTH_ENV_ONE) {
+                    level = SYNTH_ENV_ONE;
+                    voice->stage = ENV_DECAY;
+                }
+                break;
+            case ENV_DECAY:
+                level -= voice->decay_step;
+                if (level <= voice->sustain) {
+                    level = voice->sustain;
+                    voice->stage = ENV_SUSTAIN;
+                }
+                break;
+            case ENV_RELEASE:
+                level -= voice->release_step;
+                if (level <= 0) {
+                    level = 0;
+                    voice->stage = ENV_IDLE;
+                }
+                break;
+            default:
+                break;
+        }
+        if (voice->stage == ENV_IDLE) {
+            break;
+        }
+
+        // 查表 + 线性插值
+        uint32_t idx = phase >> (32 - AUDIO_SYNTH_LUT_BITS);
+        int32_t frac = (phase >> SYNTH_FRAC_SHIFT) & 0x7FFF;
+        int32_t a = s_sine[idx];
+        int32_t s = a + (((s_sine[idx + 1] - a) * frac) >> 15);
+
+        int32_t gain = ((level >> 15) * velocity) >> 15;
+        mix[i] += (s * gain) >> 15;
+        phase += inc;
+    }
+
+    voice->phase = phase;
+    voice->level = level;
+}
+
+/**
+ * @brief 渲染单声道 PCM
+ */
+int audio_synth_render(int16_t *out, size_t frames)
+{
+    int active = 0;
+
+    while (frames > 0) {
+        size_t n = (frames > AUDIO_SYNTH_BLOCK_FRAMES) ? AUDIO_SYNTH_BLOCK_FRAMES : frames;
+        memset(mix_buf, 0, n * sizeof(int32_t));
+
+        active = 0;
+        for (int v = 0; v < AUDIO_SYNTH_MAX_VOICES; v++) {
+            if (voices[v].stage != ENV_IDLE) {
+                synth_render_voice(&voices[v], mix_buf, n);
+                active++;
+            }
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            out[i] = audio_dsp_sat16(mix_buf[i]);
+        }
+        out += n;
+        frames -= n;
+    }
+
+    return active;
+}
+
+/**
+ * @brief 当前活动发音数
+ */
+static int synth_active_voices(void)
+{
+    int active = 0;
+    for (int v = 0; v < AUDIO_SYNTH_MAX_VOICES; v++) {
+        if (voices[v].stage != ENV_IDLE) {
+            active++;
+        }
+    }
+    return active;
+}
+
+/**
+ * @brief 渲染音符列表并连续写入 I2S
+ */
+esp_err_t audio_synth_play_sequence(const audio_synth_note_t *notes, size_t count, const audio_synth_adsr_t *adsr)
+{
+    if (sample_rate == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (notes == NULL && count > 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // 多个任务同时播放提示音时依次进行
+    xSemaphoreTake(sequence_lock, portMAX_DELAY);
+    audio_synth_all_off();
+    memset(&stats, 0, sizeof(stats));
+
+    uint64_t now = 0;           // 当前采样位置
+    size_t next = 0;            // 下一个未开始的音符
+    size_t filled = 0;          // out_buf 中已渲染的帧数
+    int64_t render_us = 0;
+    uint64_t voice_frames = 0;
+    esp_err_t ret = ESP_OK;
+
+    while (1) {
+        // 当前采样位置上的音符开始/松开
+        while (next < count && (uint64_t)notes[next].start_ms * sample_rate / 1000 <= now) {
+            const audio_synth_note_t *note = &notes[next];
+            int v = audio_synth_note_on(note->freq_hz, note->velocity, adsr);
+            voices[v].off_at = now + synth_ms_to_samples(note->duration_ms);
+            next++;
+        }
+        for (int v = 0; v < AUDIO_SYNTH_MAX_VOICES; v++) {
+            if (voices[v].stage != ENV_IDLE && voices[v].stage != ENV_RELEASE && voices[v].off_at <= now) {
+                audio_synth_note_off(v);
+            }
+        }
+
+        int active = synth_active_voices();
+        if (next >= count && active == 0) {
+            break;
+        }
+        if (active > stats.peak_voices) {
+            stats.peak_voices = (uint8_t)active;
+        }
+
+        // 渲染到下一个事件或缓冲区填满
+        uint64_t until = now + (AUDIO_SYNTH_BLOCK_FRAMES - filled);
+        if (next < count) {
+            uint64_t start = (uint64_t)notes[next].start_ms * sample_rate / 1000;
+            if (start < until) {
+                until = start;
+            }
+        }
+        uint64_t tail = now;
+        for (int v = 0; v < AUDIO_SYNTH_MAX_VOICES; v++) {
+            if (voices[v].stage == ENV_IDLE) {
+                continue;
+            }
+            if (voices[v].stage != ENV_RELEASE) {
+                if (voices[v].off_at < until) {
+                    until = voices[v].off_at;
+                }
+                tail = UINT64_MAX;
+            } else if (tail != UINT64_MAX) {
+                uint64_t end = now + (voices[v].level + voices[v].release_step - 1) / voices[v].release_step;
+                tail = (end > tail) ? end : tail;
+            }
+        }
+        // 最后的音符释音结束后不再补静音
+        if (next >= count && tail < until) {
+            until = tail;
+        }
+        size_t n = (size_t)(until - now);
+
+        int64_t t0 = esp_timer_get_time();
+        audio_synth_render(out_buf + filled, n);
+        render_us += esp_timer_get_time() - t0;
+        voice_frames += (uint64_t)n * active;
+
+        filled += n;
+        now += n;
+
+        if (filled == AUDIO_SYNTH_BLOCK_FRAMES) {
+            size_t bytes = filled * sizeof(int16_t);
+            if (audio_mixer_write(tone_source, out_buf, bytes, SYNTH_WRITE_TIMEOUT_MS) != bytes) {
+                ret = ESP_ERR_TIMEOUT;
+                break;
+            }
+            filled = 0;
+        }
+    }
+
+    if (ret == ESP_OK && filled > 0) {
+        size_t bytes = filled * sizeof(int16_t);
+        if (audio_mixer_write(tone_source, out_buf, bytes, SYNTH_WRITE_TIMEOUT_MS) != bytes) {
+            ret = ESP_ERR_TIMEOUT;
+        }
+    }
+    // 等待尾部数据进入 I2S，音序播放保持阻塞语义
+    esp_err_t drain_ret = audio_mixer_drain(tone_source, SYNTH_WRITE_TIMEOUT_MS);
+    if (ret == ESP_OK) {
+        ret = drain_ret;
+    }
+    audio_synth_all_off();
+
+    if (now > 0) {
+        stats.render_us_per_s = (uint32_t)((uint64_t)render_us * sample_rate / now);
+    }
+    if (voice_frames > 0) {
+        stats.us_per_voice_s = (uint32_t)((uint64_t)render_us * sample_rate / voice_frames);
+    }
+    ESP_LOGD(TAG, "音序渲染: %lu 帧, %lu us/s, 每发音 %lu us/s, 最多 %u 发音",
+             (unsigned long)now, (unsigned long)stats.render_us_per_s,
+             (unsigned long)stats.us_per_voice_s, stats.peak_voices);
+    xSemaphoreGive(sequence_lock);
+    return ret;
+}
+
+/**
+ * @brief 获取渲染统计
+ */
+void audio_synth_get_stats(audio_synth_stats_t *out)
+{
+    *out = stats;
+}
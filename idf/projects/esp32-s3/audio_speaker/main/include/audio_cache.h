@@ -0,0 +1,179 @@
+/**
+ * @file audio_cache.h
+ * @brief Flash 音频片段缓存 (提示音等短音频的即时重放)
+ *
+ * 网络下载解码后的 PCM 保存在专用数据分区 "clips" 中，按 URL + ETag 确定内容：
+ * - 索引以 URL 的 SHA-256 (前 16 字节) 查找，条目记录服务器返回的 ETag，
+ *   超过免验证时长后用 If-None-Match 重新验证，304 视为命中
+ * - 每个片段占用连续扇区，命中时经 esp_partition_mmap() 直接映射播放，不经过文件系统拷贝
+ * - 总大小受预算限制，空间不足时按最近最少使用 (LRU) 淘汰
+ *
+ * 分区布局：前两个扇区是索引的 A/B 副本 (序号 + CRC32，写入时交替，掉电不丢失旧索引)，
+ * 之后是片段数据区。LRU 顺序只在写入新片段时随索引保存，命中不写 Flash。
+ */
+
+#ifndef AUDIO_CACHE_H
+#define AUDIO_CACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_partition.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 缓存分区子类型 (partitions.csv 中 data 类型的自定义子类型)
+ */
+#define AUDIO_CACHE_PARTITION_SUBTYPE   0x40
+
+/**
+ * @brief 最大片段数
+ */
+#define AUDIO_CACHE_MAX_ENTRIES         32
+
+/**
+ * @brief ETag 最大长度 (含结尾 '\0'，更长的响应不缓存)
+ */
+#define AUDIO_CACHE_ETAG_LEN            64
+
+/**
+ * @brief 缓存配置
+ */
+typedef struct {
+    const char *partition_label;    // 分区名称
+    size_t      budget_bytes;       // 片段总大小上限 (0 表示整个数据区)
+    size_t      max_clip_bytes;     // 单个片段上限 (PCM 字节，下载时在 PSRAM 中暂存)
+    uint32_t    fresh_s;            // 写入/验证后免验证直接播放的时长 (秒)
+} audio_cache_config_t;
+
+/**
+ * @brief 默认缓存配置 (单个片段约 1.5 秒 44.1kHz 立体声)
+ */
+#define AUDIO_CACHE_DEFAULT_CONFIG() {      \
+    .partition_label = "clips",             \
+    .budget_bytes = 0,                      \
+    .max_clip_bytes = 256 * 1024,           \
+    .fresh_s = 600,                         \
+}
+
+/**
+ * @brief 已映射的缓存片段
+ */
+typedef struct {
+    const int16_t *pcm;             // 映射后的 PCM 数据 (只读)
+    size_t   bytes;                 // 数据长度 (字节)
+    uint32_t sample_rate;           // 采样率 (Hz)
+    uint8_t  channels;              // 声道数
+    bool     fresh;                 // 仍在免验证时长内，可直接播放
+    char     etag[AUDIO_CACHE_ETAG_LEN];    // 写入时服务器返回的 ETag
+    // 内部使用
+    int      slot;
+    esp_partition_mmap_handle_t handle;
+} audio_cache_clip_t;
+
+/**
+ * @brief 缓存统计
+ */
+typedef struct {
+    uint32_t hits;                  // 从缓存播放次数 (含 304 验证后播放)
+    uint32_t misses;                // 从网络播放次数
+    uint32_t revalidations;         // 304 验证次数
+    uint8_t  hit_pct;               // 命中率 (%)
+    uint32_t stores;                // 写入片段次数
+    uint32_t evictions;             // LRU 淘汰次数
+    uint32_t entries;               // 当前片段数
+    size_t   used_bytes;            // 已占用空间 (按扇区计)
+    size_t   budget_bytes;          // 空间预算
+    uint32_t hit_first_sample_us;   // 最近一次命中的首样本时间 (请求到首个 PCM 写入混音器)
+    uint32_t hit_first_sample_avg_us;   // 命中首样本时间平均值
+    uint32_t miss_first_sample_us;  // 最近一次未命中的首样本时间
+    uint32_t miss_first_sample_avg_us;  // 未命中首样本时间平均值
+} audio_cache_stats_t;
+
+/**
+ * @brief 初始化缓存 (查找分区并加载索引)
+ *
+ * @param config 配置，NULL 使用 AUDIO_CACHE_DEFAULT_CONFIG()
+ * @return esp_err_t ESP_OK 成功, ESP_ERR_NOT_FOUND 分区不存在 (缓存不可用，播放不受影响)
+ */
+esp_err_t audio_cache_init(const audio_cache_config_t *config);
+
+/**
+ * @brief 单个片段的大小上限 (缓存不可用时为 0)
+ *
+ * @return size_t 字节数
+ */
+size_t audio_cache_clip_limit(void);
+
+/**
+ * @brief 查找 URL 对应的片段并映射到地址空间
+ *
+ * 成功后需调用 audio_cache_close() 释放映射，映射期间片段不会被淘汰
+ *
+ * @param url 音频 URL
+ * @param clip 输出片段
+ * @return esp_err_t ESP_OK 找到, ESP_ERR_NOT_FOUND 未缓存
+ */
+esp_err_t audio_cache_open(const char *url, audio_cache_clip_t *clip);
+
+/**
+ * @brief 释放片段映射
+ *
+ * @param clip 片段
+ */
+void audio_cache_close(audio_cache_clip_t *clip);
+
+/**
+ * @brief 服务器确认片段未变化 (304)，重新计算免验证时长
+ *
+ * @param clip 片段
+ */
+void audio_cache_revalidated(const audio_cache_clip_t *clip);
+
+/**
+ * @brief 删除 URL 对应的片段 (内容已变化或资源已不存在)
+ *
+ * @param url 音频 URL
+ */
+void audio_cache_remove(const char *url);
+
+/**
+ * @brief 写入片段 (替换同一 URL 的旧片段)
+ *
+ * 擦写 Flash 期间缓存被禁用，应在播放结束后调用
+ *
+ * @param url 音频 URL
+ * @param etag 服务器返回的 ETag
+ * @param sample_rate 采样率 (Hz)
+ * @param channels 声道数 (1 或 2)
+ * @param pcm 16 位 PCM 数据
+ * @param bytes 数据长度 (字节)
+ * @return esp_err_t ESP_OK 成功, ESP_ERR_INVALID_SIZE 超过单个片段上限, ESP_ERR_NO_MEM 淘汰后仍放不下
+ */
+esp_err_t audio_cache_store(const char *url, const char *etag, uint32_t sample_rate, uint8_t channels,
+                            const void *pcm, size_t bytes);
+
+/**
+ * @brief 记录一次播放的首样本时间
+ *
+ * @param hit 是否从缓存播放
+ * @param first_sample_us 从请求到首个 PCM 写入混音器的时间 (微秒)
+ */
+void audio_cache_record_play(bool hit, uint32_t first_sample_us);
+
+/**
+ * @brief 获取缓存统计
+ *
+ * @param stats 输出统计
+ */
+void audio_cache_get_stats(audio_cache_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_CACHE_H
@@ -0,0 +1,153 @@
+/**
+ * @file audio_decoder.h
+ * @brief 可插拔音频解码级
+ *
+ * 下载任务把网络数据原样喂给解码级，解码级根据 Content-Type 或数据头
+ * 选择解码器，将解码得到的 16 位 PCM 交给输出回调 (通常写入 audio_pipeline)。
+ *
+ * - 输入缓冲区和 PCM 输出块在 audio_decoder_init() 中分配一次，所有数据流复用
+ * - 解码器以 audio_decoder_ops_t 描述，新增格式只需实现一组回调并加入注册表
+ * - 统计解码耗时，换算为每秒音频的 CPU 微秒数
+ */
+
+#ifndef AUDIO_DECODER_H
+#define AUDIO_DECODER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 输入缓冲区大小 (字节)，需能容纳一个完整的压缩帧/块
+ */
+#define AUDIO_DECODER_IN_BUF_SIZE       8192
+
+/**
+ * @brief PCM 输出块大小 (字节)，需能容纳一次解码的最大输出
+ *
+ * MP3 每帧最多 1152 帧立体声 (4608 字节)，IMA-ADPCM 立体声 2048 字节块为 2041 帧 (8164 字节)
+ */
+#define AUDIO_DECODER_PCM_BLOCK_SIZE    8192
+
+/**
+ * @brief 数据流格式
+ */
+typedef enum {
+    AUDIO_FORMAT_UNKNOWN = 0,
+    AUDIO_FORMAT_WAV,           // RIFF/WAV 容器 (8/16/24/32 位 PCM, 浮点, IMA-ADPCM)
+    AUDIO_FORMAT_MP3,           // MPEG-1/2 Layer III
+} audio_format_t;
+
+/**
+ * @brief 解码输出的 PCM 格式
+ */
+typedef struct {
+    uint32_t sample_rate;       // 采样率 (Hz)，0 表示尚未确定
+    uint8_t  channels;          // 声道数
+} audio_decoder_info_t;
+
+/**
+ * @brief 解码器回调
+ *
+ * decode 从 in 中消耗 *consumed 字节，向 out 写入 *out_bytes 字节 PCM。
+ * 两者都为 0 表示需要更多数据。返回 ESP_ERR_NOT_SUPPORTED 时数据流中止，
+ * 返回其他错误时核心跳过已消耗的数据 (至少 1 字节) 后重试 (用于重新同步)。
+ */
+typedef struct {
+    const char *name;                   // 解码器名称
+    esp_err_t (*open)(void);            // 开始新的数据流
+    esp_err_t (*decode)(const uint8_t *in, size_t len, size_t *consumed,
+                        int16_t *out, size_t out_size, size_t *out_bytes,
+                        audio_decoder_info_t *info);
+    void (*close)(void);                // 结束数据流
+} audio_decoder_ops_t;
+
+/**
+ * @brief 内置解码器
+ */
+extern const audio_decoder_ops_t audio_decoder_wav_ops;
+extern const audio_decoder_ops_t audio_decoder_mp3_ops;
+
+/**
+ * @brief PCM 输出回调
+ */
+typedef struct {
+    // 格式确定或变化时调用 (在对应 PCM 输出之前)
+    esp_err_t (*on_format)(const audio_decoder_info_t *info, void *arg);
+    // 输出一块交织 PCM，返回错误时解码中止
+    esp_err_t (*on_pcm)(const int16_t *pcm, size_t bytes, void *arg);
+    void *arg;
+} audio_decoder_sink_t;
+
+/**
+ * @brief 解码统计
+ */
+typedef struct {
+    const char *decoder;        // 当前解码器名称
+    uint32_t sample_rate;       // 输出采样率
+    uint8_t  channels;          // 输出声道数
+    uint64_t bytes_in;          // 输入字节数
+    uint64_t frames_out;        // 输出 PCM 帧数
+    uint32_t errors;            // 解码错误 (重新同步) 次数
+    uint32_t decode_us_per_s;   // 解码耗时 (每秒音频的微秒数)
+} audio_decoder_stats_t;
+
+/**
+ * @brief 初始化解码级 (分配输入缓冲区和 PCM 输出块)
+ *
+ * @return esp_err_t ESP_OK 成功
+ */
+esp_err_t audio_decoder_init(void);
+
+/**
+ * @brief 根据 Content-Type 和数据头判断格式
+ *
+ * 优先识别数据头 (RIFF/WAVE, ID3, MPEG 帧同步)，无法识别时使用 Content-Type
+ *
+ * @param content_type HTTP Content-Type，可为 NULL
+ * @param head 数据开头
+ * @param len 数据长度
+ * @return audio_format_t 格式
+ */
+audio_format_t audio_decoder_detect(const char *content_type, const uint8_t *head, size_t len);
+
+/**
+ * @brief 开始一个数据流
+ *
+ * @param format 格式
+ * @param sink 输出回调
+ * @return esp_err_t ESP_OK 成功, ESP_ERR_NOT_SUPPORTED 格式不支持
+ */
+esp_err_t audio_decoder_open(audio_format_t format, const audio_decoder_sink_t *sink);
+
+/**
+ * @brief 喂入压缩数据，解码所有完整的帧并输出
+ *
+ * @param data 数据
+ * @param len 长度
+ * @return esp_err_t ESP_OK 成功, ESP_ERR_NOT_SUPPORTED 编码不支持，其他为输出回调返回的错误
+ */
+esp_err_t audio_decoder_feed(const uint8_t *data, size_t len);
+
+/**
+ * @brief 结束数据流 (丢弃不完整的尾部数据)
+ */
+void audio_decoder_close(void);
+
+/**
+ * @brief 获取当前/上一个数据流的解码统计
+ *
+ * @param stats 输出统计
+ */
+void audio_decoder_get_stats(audio_decoder_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_DECODER_H
@@ -0,0 +1,156 @@
+/**
+ * @file audio_dsp.h
+ * @brief 音频定点运算内核
+ *
+ * Q15 定点音量缩放、单声道转立体声和 PCM 位深转换，ESP32-S3 上使用 PIE SIMD 指令，
+ * 其他平台使用标量实现。所有结果饱和到 int16 范围，不会回绕。
+ */
+
+#ifndef AUDIO_DSP_H
+#define AUDIO_DSP_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 是否启用 ESP32-S3 SIMD 内核
+ */
+#if CONFIG_IDF_TARGET_ESP32S3
+#define AUDIO_DSP_USE_SIMD  1
+#else
+#define AUDIO_DSP_USE_SIMD  0
+#endif
+
+/**
+ * @brief SIMD 内核要求的缓冲区对齐 (字节)
+ */
+#define AUDIO_DSP_ALIGN     16
+
+/**
+ * @brief Q15 格式的 1.0
+ */
+#define AUDIO_DSP_Q15_ONE   32767
+
+/**
+ * @brief 饱和到 int16 范围
+ */
+static inline int16_t audio_dsp_sat16(int32_t x)
+{
+    if (x > INT16_MAX) {
+        return INT16_MAX;
+    }
+    if (x < INT16_MIN) {
+        return INT16_MIN;
+    }
+    return (int16_t)x;
+}
+
+/**
+ * @brief 音量 (0-100) 转换为 Q15 增益
+ *
+ * @param volume 音量值 (0-100)
+ * @return int16_t Q15 增益
+ */
+int16_t audio_dsp_volume_to_q15(uint8_t volume);
+
+/**
+ * @brief 单声道转立体声并应用 Q15 增益
+ *
+ * dst[2i] = dst[2i+1] = sat16((src[i] * gain) >> 15)
+ *
+ * @param dst 立体声输出 (samples * 2 个采样)
+ * @param src 单声道输入
+ * @param samples 单声道采样数
+ * @param gain_q15 Q15 增益
+ */
+void audio_dsp_mono_to_stereo_q15(int16_t *dst, const int16_t *src, size_t samples, int16_t gain_q15);
+
+/**
+ * @brief 应用 Q15 增益 (支持 dst == src 原地处理)
+ *
+ * @param dst 输出
+ * @param src 输入
+ * @param samples 采样数
+ * @param gain_q15 Q15 增益
+ */
+void audio_dsp_scale_q15(int16_t *dst, const int16_t *src, size_t samples, int16_t gain_q15);
+
+/**
+ * @brief 原地应用线性增益斜坡 (淡入/淡出)
+ *
+ * 第一帧使用 gain_from，最后一帧接近 gain_to，同一帧的各声道增益相同
+ *
+ * @param buf 交织 PCM 数据
+ * @param frames 帧数
+ * @param channels 声道数
+ * @param gain_from 起始 Q15 增益
+ * @param gain_to 结束 Q15 增益
+ */
+void audio_dsp_ramp_q15(int16_t *buf, size_t frames, uint8_t channels, int16_t gain_from, int16_t gain_to);
+
+/**
+ * @brief Q15 点积 (FIR 内核)
+ *
+ * 返回 sum(x[i] * h[i]) 的 32 位累加结果，由调用方右移 15 位并饱和。
+ * h 16 字节对齐且 taps 为 8 的整数倍时使用 SIMD 内核，此时 x 只需 2 字节对齐，
+ * 但可能越界读取 x 末尾之后最多 16 字节 (只读，结果不受影响)，调用方需保证可访问。
+ * 系数绝对值之和不超过 Q15 的 2.0 时累加不会溢出。
+ *
+ * @param x 输入采样
+ * @param h Q15 系数
+ * @param taps 长度
+ * @return int32_t 累加结果
+ */
+int32_t audio_dsp_dot_q15(const int16_t *x, const int16_t *h, size_t taps);
+
+/**
+ * @brief 8 位无符号 PCM 转换为 int16 (dst[i] = (src[i] - 128) << 8)
+ *
+ * @param dst 输出
+ * @param src 输入
+ * @param samples 采样数
+ */
+void audio_dsp_u8_to_s16(int16_t *dst, const uint8_t *src, size_t samples);
+
+/**
+ * @brief 24 位小端打包 PCM (每采样 3 字节) 转换为 int16 (截断低 8 位)
+ *
+ * @param dst 输出
+ * @param src 输入 (任意对齐)
+ * @param samples 采样数
+ */
+void audio_dsp_s24_to_s16(int16_t *dst, const uint8_t *src, size_t samples);
+
+/**
+ * @brief 32 位 PCM 转换为 int16 (截断低 16 位)
+ *
+ * dst 16 字节对齐时使用 SIMD 内核，src 只需 4 字节对齐 (不会越界读取)。
+ * 支持 dst == src 原地转换
+ *
+ * @param dst 输出
+ * @param src 输入 (4 字节对齐)
+ * @param samples 采样数
+ */
+void audio_dsp_s32_to_s16(int16_t *dst, const int32_t *src, size_t samples);
+
+/**
+ * @brief 32 位浮点 PCM ([-1.0, 1.0)) 转换为 int16 (向零取整并饱和，NaN 输出 0)
+ *
+ * 支持 dst == src 原地转换
+ *
+ * @param dst 输出
+ * @param src 输入 (4 字节对齐)
+ * @param samples 采样数
+ */
+void audio_dsp_f32_to_s16(int16_t *dst, const float *src, size_t samples);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_DSP_H
@@ -0,0 +1,173 @@
+/**
+ * @file audio_fx.h
+ * @brief 输出效果链 (均衡器 + 前瞻动态压缩)
+ *
+ * 由混音任务在总增益之后、软限幅之前调用，对所有音源的混音结果生效：
+ * - 最多 AUDIO_FX_MAX_FILTERS 级双二阶滤波器 (参数均衡、高/低架、高通、低通)，
+ *   高通用于保护小口径喇叭，系数按 RBJ 公式计算后量化为 Q28
+ * - 前瞻动态压缩/限幅：检测先于输出 lookahead_ms，增益在峰值到达前已经压下
+ *
+ * 内部以 32 位定点处理 (Q4.27，满幅为 1.0)，各级输出限制在 ±8.0 (满幅以上 18 dB 余量，
+ * +12 dB 均衡提升不会在压缩前削顶)，滤波累加使用 64 位。参数可在运行时修改 (如 HTTP 接口)，在下一个混音块生效。
+ */
+
+#ifndef AUDIO_FX_H
+#define AUDIO_FX_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 最大滤波器级数
+ */
+#define AUDIO_FX_MAX_FILTERS        6
+
+/**
+ * @brief 压缩器增益计算的子块帧数 (处理帧数需为其整数倍)
+ */
+#define AUDIO_FX_DRC_BLOCK_FRAMES   16
+
+/**
+ * @brief 最大前瞻帧数
+ */
+#define AUDIO_FX_DRC_MAX_LOOKAHEAD  256
+
+/**
+ * @brief 压缩比达到该值时按限幅器处理 (∞:1)
+ */
+#define AUDIO_FX_DRC_LIMIT_RATIO    20.0f
+
+/**
+ * @brief 滤波器类型
+ */
+typedef enum {
+    AUDIO_FX_FILTER_OFF = 0,        // 不使用
+    AUDIO_FX_FILTER_PEAK,           // 参数均衡 (峰值/陷波)
+    AUDIO_FX_FILTER_LOW_SHELF,      // 低架
+    AUDIO_FX_FILTER_HIGH_SHELF,     // 高架
+    AUDIO_FX_FILTER_HIGHPASS,       // 二阶高通
+    AUDIO_FX_FILTER_LOWPASS,        // 二阶低通
+} audio_fx_filter_type_t;
+
+/**
+ * @brief 单级滤波器参数
+ */
+typedef struct {
+    audio_fx_filter_type_t type;
+    float freq_hz;                  // 中心/转折频率 (20Hz ~ 0.45 × 采样率)
+    float gain_db;                  // 增益 (均衡/架式滤波器, -24 ~ +12 dB)
+    float q;                        // 品质因数 (0.3 ~ 10)
+} audio_fx_filter_t;
+
+/**
+ * @brief 动态压缩参数
+ */
+typedef struct {
+    bool  enabled;
+    float threshold_db;             // 阈值 (dBFS, -40 ~ 0)
+    float ratio;                    // 压缩比 (1 ~ 20, ≥20 为限幅)
+    float attack_ms;                // 起效时间 (0.1 ~ 100)
+    float release_ms;               // 恢复时间 (10 ~ 2000)
+    float lookahead_ms;             // 前瞻时间 (0 ~ 5, 上限 AUDIO_FX_DRC_MAX_LOOKAHEAD 帧)
+    float makeup_db;                // 补偿增益 (0 ~ 12 dB)
+} audio_fx_drc_t;
+
+/**
+ * @brief 效果链配置
+ */
+typedef struct {
+    bool enabled;                   // 总开关
+    audio_fx_filter_t filters[AUDIO_FX_MAX_FILTERS];
+    audio_fx_drc_t drc;
+} audio_fx_config_t;
+
+/**
+ * @brief 默认配置 (120Hz 高通保护小喇叭，-6 dBFS 起 4:1 压缩)
+ */
+#define AUDIO_FX_DEFAULT_CONFIG() {                                     \
+    .enabled = true,                                                    \
+    .filters = {                                                        \
+        { .type = AUDIO_FX_FILTER_HIGHPASS, .freq_hz = 120.0f,          \
+          .gain_db = 0.0f, .q = 0.707f },                               \
+    },                                                                  \
+    .drc = {                                                            \
+        .enabled = true,                                                \
+        .threshold_db = -6.0f,                                          \
+        .ratio = 4.0f,                                                  \
+        .attack_ms = 2.0f,                                              \
+        .release_ms = 200.0f,                                           \
+        .lookahead_ms = 3.0f,                                           \
+        .makeup_db = 0.0f,                                              \
+    },                                                                  \
+}
+
+/**
+ * @brief 效果链统计
+ */
+typedef struct {
+    uint32_t fx_us_per_s;           // 处理耗时 (每秒音频的微秒数)
+    float    gain_reduction_db;     // 当前压缩量 (dB, ≥0)
+    float    max_reduction_db;      // 上次读取统计以来的最大压缩量
+    uint8_t  active_filters;        // 生效的滤波器级数
+} audio_fx_stats_t;
+
+/**
+ * @brief 初始化效果链 (由 audio_mixer_init() 调用)
+ *
+ * 之前通过 audio_fx_set_config() 设置的配置在此按采样率计算系数，
+ * 未设置时使用 AUDIO_FX_DEFAULT_CONFIG()
+ *
+ * @param sample_rate 输出采样率 (Hz)
+ * @return esp_err_t ESP_OK 成功
+ */
+esp_err_t audio_fx_init(uint32_t sample_rate);
+
+/**
+ * @brief 设置效果链配置 (任意任务调用，下一个混音块生效)
+ *
+ * @param config 配置
+ * @return esp_err_t ESP_OK 成功, ESP_ERR_INVALID_ARG 参数超出范围 (配置不变)
+ */
+esp_err_t audio_fx_set_config(const audio_fx_config_t *config);
+
+/**
+ * @brief 获取当前配置
+ *
+ * @param config 输出配置
+ */
+void audio_fx_get_config(audio_fx_config_t *config);
+
+/**
+ * @brief 处理一块混音结果 (仅混音任务调用)
+ *
+ * 输入输出均为 int16 刻度的 32 位采样 (未饱和，输入超出满幅 8 倍的部分被限幅)，输出延迟 lookahead 帧
+ *
+ * @param buf 交织立体声采样 (原地处理)
+ * @param frames 帧数 (AUDIO_FX_DRC_BLOCK_FRAMES 的整数倍)
+ * @return bool 效果链内部仍有未输出的数据 (前瞻延迟)
+ */
+bool audio_fx_process(int32_t *buf, size_t frames);
+
+/**
+ * @brief 清空滤波器状态和前瞻延迟 (仅混音任务调用)
+ */
+void audio_fx_reset(void);
+
+/**
+ * @brief 获取效果链统计 (同时清零最大压缩量)
+ *
+ * @param stats 输出统计
+ */
+void audio_fx_get_stats(audio_fx_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_FX_H
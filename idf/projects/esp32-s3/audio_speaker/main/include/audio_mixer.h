@@ -0,0 +1,173 @@
+/**
+ * @file audio_mixer.h
+ * @brief 多路音频混音器
+ *
+ * 混音任务独占 I2S 输出，各音源 (网络音频、提示音、TTS 等) 通过各自的
+ * 无锁单生产者/单消费者环形缓冲区提交 PCM (输出采样率)：
+ * - 每路音源带 Q15 增益，在 32 位累加器中求和，软限幅后输出
+ * - 带 ducks_others 标志的音源发声时，duckable 音源自动压低 (闪避)
+ * - 统计混音 CPU 耗时和每路音源的欠载次数
+ *
+ * 每路音源只能有一个生产者任务。
+ */
+
+#ifndef AUDIO_MIXER_H
+#define AUDIO_MIXER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 最大音源数
+ */
+#define AUDIO_MIXER_MAX_SOURCES     4
+
+/**
+ * @brief 每次混音的帧数
+ */
+#define AUDIO_MIXER_BLOCK_FRAMES    256
+
+/**
+ * @brief 混音器配置
+ */
+typedef struct {
+    int16_t     duck_gain_q15;        // 闪避时 duckable 音源的增益 (Q15)
+    uint16_t    duck_attack_ms;       // 压低所需时间
+    uint16_t    duck_release_ms;      // 恢复所需时间
+    int16_t     limiter_threshold;    // 软限幅起始电平，超过后平滑压缩到满幅
+    UBaseType_t task_priority;        // 混音任务优先级
+    BaseType_t  task_core;            // 混音任务所在核心
+} audio_mixer_config_t;
+
+/**
+ * @brief 默认混音器配置 (闪避 -12 dB，限幅从 -2.5 dBFS 开始)
+ */
+#define AUDIO_MIXER_DEFAULT_CONFIG() {                  \
+    .duck_gain_q15 = 8192,                              \
+    .duck_attack_ms = 50,                               \
+    .duck_release_ms = 300,                             \
+    .limiter_threshold = 24576,                         \
+    .task_priority = configMAX_PRIORITIES - 2,          \
+    .task_core = 1,                                     \
+}
+
+/**
+ * @brief 音源配置
+ */
+typedef struct {
+    const char *name;           // 名称 (用于统计)
+    uint8_t     channels;       // 声道数 (1 或 2)
+    size_t      ring_frames;    // 环形缓冲区容量 (帧, 向上取整为 2 的幂)
+    int16_t     gain_q15;       // 增益 (Q15)
+    bool        duckable;       // 其他音源提示时被压低 (音乐)
+    bool        ducks_others;   // 发声时压低 duckable 音源 (提示音、TTS)
+} audio_mixer_source_config_t;
+
+/**
+ * @brief 音源句柄
+ */
+typedef struct audio_mixer_source *audio_mixer_source_t;
+
+/**
+ * @brief 单路音源统计
+ */
+typedef struct {
+    const char *name;           // 名称
+    size_t   capacity_frames;   // 缓冲区容量 (帧)
+    size_t   fill_frames;       // 当前缓冲帧数
+    uint32_t underruns;         // 欠载次数 (数据流进行中缓冲区不足一个混音块)
+    bool     active;            // 上一个混音块是否有数据
+} audio_mixer_source_stats_t;
+
+/**
+ * @brief 混音器统计
+ */
+typedef struct {
+    uint32_t mix_us_per_s;      // 混音耗时 (每秒音频的微秒数)
+    uint32_t limited_samples;   // 软限幅作用的采样数
+    int16_t  duck_gain_q15;     // 当前闪避增益
+    uint8_t  num_sources;       // 音源数
+    audio_mixer_source_stats_t sources[AUDIO_MIXER_MAX_SOURCES];
+} audio_mixer_stats_t;
+
+/**
+ * @brief 初始化混音器并创建混音任务
+ *
+ * @param config 配置，NULL 使用 AUDIO_MIXER_DEFAULT_CONFIG()
+ * @return esp_err_t ESP_OK 成功
+ */
+esp_err_t audio_mixer_init(const audio_mixer_config_t *config);
+
+/**
+ * @brief 注册音源
+ *
+ * @param config 音源配置
+ * @param out 输出音源句柄
+ * @return esp_err_t ESP_OK 成功, ESP_ERR_NO_MEM 音源已满或内存不足
+ */
+esp_err_t audio_mixer_add_source(const audio_mixer_source_config_t *config, audio_mixer_source_t *out);
+
+/**
+ * @brief 写入 PCM (生产者调用，缓冲区满时阻塞)
+ *
+ * @param src 音源
+ * @param pcm 交织 PCM (输出采样率，声道数与注册时一致)
+ * @param bytes 字节数
+ * @param wait_ms 最长等待时间 (毫秒)
+ * @return size_t 实际写入字节数
+ */
+size_t audio_mixer_write(audio_mixer_source_t src, const int16_t *pcm, size_t bytes, uint32_t wait_ms);
+
+/**
+ * @brief 结束数据流：等待缓冲数据全部混音输出
+ *
+ * 之后缓冲区为空不再计为欠载，直到下一次写入
+ *
+ * @param src 音源
+ * @param wait_ms 最长等待时间 (毫秒)
+ * @return esp_err_t ESP_OK 已输出完毕, ESP_ERR_TIMEOUT 超时
+ */
+esp_err_t audio_mixer_drain(audio_mixer_source_t src, uint32_t wait_ms);
+
+/**
+ * @brief 获取音源当前缓冲的帧数 (尚未混音)
+ *
+ * @param src 音源
+ * @return size_t 帧数
+ */
+size_t audio_mixer_get_fill(audio_mixer_source_t src);
+
+/**
+ * @brief 设置音源增益
+ *
+ * @param src 音源
+ * @param gain_q15 增益 (Q15)
+ */
+void audio_mixer_set_gain(audio_mixer_source_t src, int16_t gain_q15);
+
+/**
+ * @brief 设置总增益 (音量)
+ *
+ * @param gain_q15 增益 (Q15)
+ */
+void audio_mixer_set_master_gain(int16_t gain_q15);
+
+/**
+ * @brief 获取混音器统计
+ *
+ * @param stats 输出统计
+ */
+void audio_mixer_get_stats(audio_mixer_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_MIXER_H
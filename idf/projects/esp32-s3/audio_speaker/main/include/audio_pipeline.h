@@ -0,0 +1,169 @@
+/**
+ * @file audio_pipeline.h
+ * @brief 网络下载与 I2S 播放解耦的音频管道
+ *
+ * 生产者 (HTTP 读取任务) 将 PCM 写入环形缓冲区 (优先放在 PSRAM)，
+ * 高优先级播放任务从缓冲区取数据写入 I2S。网络抖动由缓冲区吸收：
+ * - 开始播放前预缓冲 prebuffer_ms
+ * - 缓冲区高于高水位时生产者暂停读取，降到低水位后恢复
+ * - 欠载时淡出并暂停播放，重新缓冲到 prebuffer_ms 后淡入恢复
+ */
+
+#ifndef AUDIO_PIPELINE_H
+#define AUDIO_PIPELINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "include/audio_resampler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 默认环形缓冲区大小 (PSRAM, 约 1.5 秒 44.1kHz 立体声)
+ */
+#define AUDIO_PIPELINE_RING_SIZE            (256 * 1024)
+
+/**
+ * @brief 无 PSRAM 时使用的内部 RAM 环形缓冲区大小
+ */
+#define AUDIO_PIPELINE_RING_SIZE_INTERNAL   (32 * 1024)
+
+/**
+ * @brief 播放任务每次从缓冲区取出的最大字节数
+ */
+#define AUDIO_PIPELINE_CHUNK_BYTES          4096
+
+/**
+ * @brief 管道配置
+ */
+typedef struct {
+    size_t      ring_size;            // 环形缓冲区大小 (字节)
+    uint32_t    prebuffer_ms;         // 开始/欠载恢复前的预缓冲时长 (毫秒)
+    uint8_t     high_watermark_pct;   // 高水位 (%)，超过后生产者暂停
+    uint8_t     low_watermark_pct;    // 低水位 (%)，低于后生产者恢复
+    uint32_t    fade_ms;              // 欠载淡出/恢复淡入时长 (毫秒)
+    audio_resampler_quality_t resampler_quality;  // 采样率转换质量档位
+    UBaseType_t playback_priority;    // 播放任务优先级
+    BaseType_t  playback_core;        // 播放任务所在核心
+} audio_pipeline_config_t;
+
+/**
+ * @brief 默认管道配置
+ */
+#define AUDIO_PIPELINE_DEFAULT_CONFIG() {               \
+    .ring_size = AUDIO_PIPELINE_RING_SIZE,              \
+    .prebuffer_ms = 500,                                \
+    .high_watermark_pct = 90,                           \
+    .low_watermark_pct = 50,                            \
+    .fade_ms = 10,                                      \
+    .resampler_quality = AUDIO_RESAMPLER_QUALITY_MEDIUM, \
+    .playback_priority = configMAX_PRIORITIES - 3,      \
+    .playback_core = 1,                                 \
+}
+
+/**
+ * @brief 播放状态
+ */
+typedef enum {
+    AUDIO_PIPELINE_STATE_IDLE = 0,      // 无数据流
+    AUDIO_PIPELINE_STATE_PREBUFFERING,  // 首次预缓冲
+    AUDIO_PIPELINE_STATE_PLAYING,       // 正在播放
+    AUDIO_PIPELINE_STATE_UNDERRUN,      // 欠载，等待重新缓冲
+    AUDIO_PIPELINE_STATE_DRAINING,      // 数据已写完，播放剩余数据
+} audio_pipeline_state_t;
+
+/**
+ * @brief 管道遥测数据
+ */
+typedef struct {
+    audio_pipeline_state_t state;   // 当前状态
+    size_t   ring_size;             // 环形缓冲区大小 (字节)
+    size_t   fill_bytes;            // 当前缓冲字节数
+    uint8_t  fill_pct;              // 当前缓冲百分比
+    size_t   min_fill_bytes;        // 本次播放开始后的最低缓冲字节数 (预缓冲完成后统计)
+    uint32_t buffered_ms;           // 当前缓冲可播放时长 (毫秒)
+    uint32_t underruns;             // 本次播放欠载次数
+    uint32_t total_underruns;       // 累计欠载次数
+    uint32_t producer_pauses;       // 生产者因高水位暂停次数
+    uint64_t bytes_written;         // 本次播放写入字节数
+    uint64_t bytes_played;          // 本次播放输出字节数
+    bool     in_psram;              // 缓冲区是否位于 PSRAM
+    uint32_t resample_us_per_s;     // 采样率转换耗时 (每秒音频的微秒数，0 表示直通)
+    uint32_t resample_dropped_frames; // 本次播放因采样率转换无进展而丢弃的输入帧数 (正常为 0)
+    uint32_t start_us;              // 本次播放从开始数据流到首个 PCM 写入混音器的时间 (0 表示尚未输出)
+} audio_pipeline_stats_t;
+
+/**
+ * @brief 初始化音频管道 (分配缓冲区并创建播放任务)
+ *
+ * @param config 配置，NULL 使用 AUDIO_PIPELINE_DEFAULT_CONFIG()
+ * @return esp_err_t ESP_OK 成功
+ */
+esp_err_t audio_pipeline_init(const audio_pipeline_config_t *config);
+
+/**
+ * @brief 开始一个新的 PCM 数据流
+ *
+ * 等待上一个数据流播放完毕后调用。I2S 采样率固定，采样率不同时经转换器输出
+ *
+ * @param sample_rate 采样率 (Hz)
+ * @param channels 声道数 (1 或 2)，16 位 PCM
+ * @return esp_err_t ESP_OK 成功, ESP_ERR_INVALID_STATE 上一个数据流尚未结束
+ */
+esp_err_t audio_pipeline_begin(uint32_t sample_rate, uint8_t channels);
+
+/**
+ * @brief 开始一个新的 PCM 数据流，并指定本次的预缓冲时长
+ *
+ * 用于本地数据源 (如 Flash 缓存的片段)：数据随时可读，不需要吸收网络抖动，
+ * 预缓冲为 0 时攒够一块 (AUDIO_PIPELINE_CHUNK_BYTES) 即开始播放
+ *
+ * @param sample_rate 采样率 (Hz)
+ * @param channels 声道数 (1 或 2)，16 位 PCM
+ * @param prebuffer_ms 开始/欠载恢复前的预缓冲时长 (毫秒)
+ * @return esp_err_t ESP_OK 成功, ESP_ERR_INVALID_STATE 上一个数据流尚未结束
+ */
+esp_err_t audio_pipeline_begin_with_prebuffer(uint32_t sample_rate, uint8_t channels, uint32_t prebuffer_ms);
+
+/**
+ * @brief 写入 PCM 数据 (生产者调用)
+ *
+ * 缓冲区达到高水位时阻塞，直到播放任务将其消耗到低水位
+ *
+ * @param data PCM 数据
+ * @param len 数据长度 (字节)
+ * @param wait_ms 最长等待时间 (毫秒)
+ * @return size_t 实际写入字节数，小于 len 表示超时或已中止
+ */
+size_t audio_pipeline_write(const void *data, size_t len, uint32_t wait_ms);
+
+/**
+ * @brief 结束数据流并等待剩余数据播放完毕
+ *
+ * @param wait_ms 最长等待时间 (毫秒)
+ * @return esp_err_t ESP_OK 播放完毕, ESP_ERR_TIMEOUT 超时
+ */
+esp_err_t audio_pipeline_end(uint32_t wait_ms);
+
+/**
+ * @brief 中止当前数据流，丢弃缓冲数据
+ */
+void audio_pipeline_abort(void);
+
+/**
+ * @brief 获取管道遥测数据
+ *
+ * @param stats 输出遥测数据
+ */
+void audio_pipeline_get_stats(audio_pipeline_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_PIPELINE_H
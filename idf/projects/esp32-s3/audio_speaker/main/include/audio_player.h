@@ -36,7 +36,9 @@ extern "C" {
 #define I2S_DOUT_PIN    7
 
 /**
- * @brief 默认音频采样率
+ * @brief I2S 输出采样率
+ * 
+ * I2S 固定工作在此采样率，其他采样率的音频由 audio_resampler 转换后输出
  */
 #define AUDIO_SAMPLE_RATE   44100
 
@@ -46,12 +48,59 @@ extern "C" {
 #define AUDIO_BITS_PER_SAMPLE   16
 
 /**
- * @brief 设置采样率并重新初始化 I2S
+ * @brief 立体声暂存缓冲区帧数
  * 
- * @param sample_rate 采样率 (Hz)
- * @return esp_err_t ESP_OK 成功
+ * 在 audio_player_init 中一次性分配，单声道转立体声按此大小分块进行，
+ * 播放过程中不再分配内存
  */
-esp_err_t audio_player_set_sample_rate(uint32_t sample_rate);
+#define AUDIO_SCRATCH_FRAMES    1024
+
+/**
+ * @brief 主音源 (audio_player_play/play_stereo) 在混音器中的缓冲帧数 (约 93ms)
+ */
+#define AUDIO_PLAYER_MAIN_RING_FRAMES   4096
+
+/**
+ * @brief I2S 输出延迟档位
+ * 
+ * 档位决定 DMA 描述符数量 (dma_desc_num) 和每个描述符的帧数 (dma_frame_num)，
+ * 两者之积是 DMA 能排队的音频时长：越短出声越快，越长越能容忍任务调度抖动
+ */
+typedef enum {
+    AUDIO_PLAYER_LATENCY_LOW = 0,       // 4 × 128 帧 (约 12ms)：门铃、闹钟、语音回复
+    AUDIO_PLAYER_LATENCY_BALANCED,      // 6 × 256 帧 (约 35ms)：默认
+    AUDIO_PLAYER_LATENCY_ROBUST,        // 16 × 256 帧 (约 93ms)：网络音乐，WiFi 负载高时不断音
+} audio_player_latency_profile_t;
+
+/**
+ * @brief 默认延迟档位
+ */
+#define AUDIO_PLAYER_DEFAULT_LATENCY    AUDIO_PLAYER_LATENCY_BALANCED
+
+/**
+ * @brief 输出延迟统计
+ * 
+ * 延迟从混音块交给 I2S 开始，到该块第一个采样开始从 DMA 输出为止，
+ * 由 I2S on_sent 回调测得 (启用通道后的第一轮 DMA 缓冲区不计)
+ */
+typedef struct {
+    audio_player_latency_profile_t profile;     // 当前档位
+    uint32_t dma_desc_num;                      // DMA 描述符数量
+    uint32_t dma_frame_num;                     // 每个描述符的帧数
+    uint32_t dma_depth_us;                      // DMA 缓冲总时长 (排队延迟上限)
+    uint32_t last_us;                           // 最近一次测得的延迟
+    uint32_t min_us;                            // 最小延迟
+    uint32_t avg_us;                            // 平均延迟
+    uint32_t max_us;                            // 最大延迟
+    uint32_t samples;                           // 测量次数
+} audio_player_latency_t;
+
+/**
+ * @brief 获取 I2S 输出采样率
+ * 
+ * @return uint32_t 采样率 (Hz)，固定为 AUDIO_SAMPLE_RATE
+ */
+uint32_t audio_player_get_sample_rate(void);
 
 /**
  * @brief 初始化音频播放器
@@ -70,7 +119,10 @@ esp_err_t audio_player_deinit(void);
 /**
  * @brief 播放 PCM 音频数据
  * 
- * @param data PCM 音频数据指针 (16位有符号, 单声道或立体声)
+ * 单声道输入，使用预分配的暂存缓冲区转换为立体声后写入混音器主音源，
+ * 不进行动态内存分配。数据流结束后调用 audio_player_drain()
+ * 
+ * @param data PCM 音频数据指针 (16位有符号, 单声道)
  * @param len 数据长度 (字节)
  * @param wait_ms 等待超时时间 (毫秒)
  * @return esp_err_t ESP_OK 成功
@@ -110,13 +162,65 @@ uint8_t audio_player_get_volume(void);
 /**
  * @brief 直接播放立体声 PCM 数据
  * 
+ * 写入混音器主音源，音量由混音器统一应用 (Q15 定点)
+ * 
  * @param data 立体声 PCM 数据 (左右声道交替)
  * @param len 数据长度 (字节)
  * @param wait_ms 等待超时时间 (毫秒)
- * @return esp_err_t ESP_OK 成功
+ * @return esp_err_t ESP_OK 成功, ESP_ERR_TIMEOUT 混音器缓冲区持续已满
  */
 esp_err_t audio_player_play_stereo(const int16_t *data, size_t len, uint32_t wait_ms);
 
+/**
+ * @brief 结束数据流：等待已提交的 PCM 全部混音输出
+ * 
+ * 主音源在数据流进行中缓冲不足会计为欠载，数据流结束时调用以免误计
+ * 
+ * @param wait_ms 最长等待时间 (毫秒)
+ * @return esp_err_t ESP_OK 成功, ESP_ERR_TIMEOUT 超时
+ */
+esp_err_t audio_player_drain(uint32_t wait_ms);
+
+/**
+ * @brief 写入 I2S 通道 (仅供混音任务调用)
+ * 
+ * @param data 立体声 PCM 数据
+ * @param len 数据长度 (字节)
+ * @param wait_ms 等待超时时间 (毫秒)，portMAX_DELAY 表示一直等待
+ * @return esp_err_t ESP_OK 成功
+ */
+esp_err_t audio_player_write_i2s(const int16_t *data, size_t len, uint32_t wait_ms);
+
+/**
+ * @brief 设置输出延迟档位
+ * 
+ * 在 audio_player_init() 之前调用时只记录档位；之后调用会重建 I2S 通道，
+ * 期间输出短暂静音，并清零延迟统计
+ * 
+ * @param profile 延迟档位
+ * @return esp_err_t ESP_OK 成功, ESP_ERR_INVALID_ARG 档位无效
+ */
+esp_err_t audio_player_set_latency_profile(audio_player_latency_profile_t profile);
+
+/**
+ * @brief 获取当前输出延迟档位
+ * 
+ * @return audio_player_latency_profile_t 延迟档位
+ */
+audio_player_latency_profile_t audio_player_get_latency_profile(void);
+
+/**
+ * @brief 获取输出延迟统计
+ * 
+ * @param latency 输出统计
+ */
+void audio_player_get_latency(audio_player_latency_t *latency);
+
+/**
+ * @brief 清零输出延迟统计
+ */
+void audio_player_reset_latency_stats(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,163 @@
+/**
+ * @file audio_resampler.h
+ * @brief 流式多相 (polyphase) 加窗 sinc 采样率转换器
+ *
+ * I2S 输出固定在 AUDIO_SAMPLE_RATE，任意输入采样率的音频经本模块转换后输出，
+ * 切换曲目时无需重建 I2S 通道。系数为 Q15 定点，内核使用 audio_dsp_dot_q15()
+ * (ESP32-S3 上为 SIMD 实现)。
+ */
+
+#ifndef AUDIO_RESAMPLER_H
+#define AUDIO_RESAMPLER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 最大声道数
+ */
+#define AUDIO_RESAMPLER_MAX_CHANNELS    2
+
+/**
+ * @brief 每次从输入搬入历史缓冲区的最大帧数
+ */
+#define AUDIO_RESAMPLER_BLOCK_FRAMES    256
+
+/**
+ * @brief 最大每相位抽头数
+ */
+#define AUDIO_RESAMPLER_MAX_TAPS        64
+
+/**
+ * @brief 漂移修正上限 (十亿分之一，即 ±2000 ppm)
+ */
+#define AUDIO_RESAMPLER_MAX_DRIFT_PPB   2000000
+
+/**
+ * @brief 质量/CPU 档位
+ *
+ * 相邻相位之间线性插值，每个输出采样每声道计算两次点积。
+ *
+ * - LOW:    16 抽头, 32 相位, 截止 0.92 (约为 MEDIUM 一半的 CPU)
+ * - MEDIUM: 32 抽头, 64 相位, 截止 0.90
+ * - HIGH:   64 抽头, 128 相位, 截止 0.92
+ */
+typedef enum {
+    AUDIO_RESAMPLER_QUALITY_LOW = 0,
+    AUDIO_RESAMPLER_QUALITY_MEDIUM,
+    AUDIO_RESAMPLER_QUALITY_HIGH,
+} audio_resampler_quality_t;
+
+/**
+ * @brief 转换器实例 (由调用方分配，字段只读)
+ */
+typedef struct {
+    uint32_t in_rate;                   // 输入采样率
+    uint32_t out_rate;                  // 输出采样率
+    uint8_t  channels;                  // 声道数
+    bool     passthrough;               // 采样率相同，直接拷贝
+    bool     variable;                  // 可用 audio_resampler_set_drift() 微调比例
+    int32_t  drift_ppb;                 // 当前漂移修正 (十亿分之一)
+    uint16_t taps;                      // 每相位抽头数 (8 的整数倍)
+    uint16_t phase_bits;                // log2(相位数)
+    int16_t *coeffs;                    // 系数表 [相位 + 1][抽头], 16 字节对齐
+    int16_t *history[AUDIO_RESAMPLER_MAX_CHANNELS];  // 各声道历史采样
+    size_t   hist_len;                  // 历史缓冲区有效帧数
+    size_t   hist_cap;                  // 历史缓冲区容量 (帧)
+    uint32_t pos_int;                   // 当前输出位置整数部分 (历史缓冲区下标)
+    uint32_t pos_frac;                  // 当前输出位置小数部分 (Q32)
+    uint32_t step_int;                  // 每个输出采样的输入步进整数部分
+    uint32_t step_frac;                 // 每个输出采样的输入步进小数部分 (Q32)
+} audio_resampler_t;
+
+/**
+ * @brief 初始化转换器并生成系数表
+ *
+ * @param rs 转换器实例
+ * @param in_rate 输入采样率 (Hz)
+ * @param out_rate 输出采样率 (Hz)
+ * @param channels 声道数 (1 或 2)
+ * @param quality 质量档位
+ * @return esp_err_t ESP_OK 成功
+ */
+esp_err_t audio_resampler_init(audio_resampler_t *rs, uint32_t in_rate, uint32_t out_rate,
+                               uint8_t channels, audio_resampler_quality_t quality);
+
+/**
+ * @brief 初始化可微调比例的转换器
+ *
+ * 与 audio_resampler_init() 相同，但采样率相同时也进行滤波，
+ * 供 audio_resampler_set_drift() 修正两端时钟的微小频差
+ *
+ * @param rs 转换器实例
+ * @param in_rate 输入采样率 (Hz)
+ * @param out_rate 输出采样率 (Hz)
+ * @param channels 声道数 (1 或 2)
+ * @param quality 质量档位
+ * @return esp_err_t ESP_OK 成功
+ */
+esp_err_t audio_resampler_init_variable(audio_resampler_t *rs, uint32_t in_rate, uint32_t out_rate,
+                                        uint8_t channels, audio_resampler_quality_t quality);
+
+/**
+ * @brief 设置漂移修正
+ *
+ * 正值使每个输出采样消耗更多输入 (追赶)，负值反之。
+ * 超出 ±AUDIO_RESAMPLER_MAX_DRIFT_PPB 时截断
+ *
+ * @param rs 由 audio_resampler_init_variable() 初始化的转换器
+ * @param drift_ppb 比例修正 (十亿分之一)
+ * @return esp_err_t ESP_OK 成功, ESP_ERR_INVALID_STATE 转换器不可微调
+ */
+esp_err_t audio_resampler_set_drift(audio_resampler_t *rs, int32_t drift_ppb);
+
+/**
+ * @brief 释放转换器内存
+ *
+ * @param rs 转换器实例
+ */
+void audio_resampler_deinit(audio_resampler_t *rs);
+
+/**
+ * @brief 清空历史数据 (开始新的数据流)
+ *
+ * @param rs 转换器实例
+ */
+void audio_resampler_reset(audio_resampler_t *rs);
+
+/**
+ * @brief 流式转换交织 PCM 数据
+ *
+ * 输出缓冲区写满或输入耗尽时返回，未用完的输入由调用方下次继续传入
+ *
+ * @param rs 转换器实例
+ * @param in 输入 (交织)
+ * @param in_frames 输入帧数
+ * @param in_used 输出：已消耗的输入帧数
+ * @param out 输出 (交织)
+ * @param out_frames 输出缓冲区容量 (帧)
+ * @return size_t 输出帧数
+ */
+size_t audio_resampler_process(audio_resampler_t *rs, const int16_t *in, size_t in_frames, size_t *in_used,
+                               int16_t *out, size_t out_frames);
+
+/**
+ * @brief 根据输入帧数估算最大输出帧数
+ *
+ * @param rs 转换器实例
+ * @param in_frames 输入帧数
+ * @return size_t 最大输出帧数
+ */
+size_t audio_resampler_max_output(const audio_resampler_t *rs, size_t in_frames);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_RESAMPLER_H
@@ -0,0 +1,163 @@
+/**
+ * @file audio_sync.h
+ * @brief 多房间同步播放 (UDP 组播接收)
+ *
+ * 发送端 (tools/multiroom_sender.py) 把 PCM 打包成 RTP 组播，每个包的头扩展
+ * 携带该包第一个采样应当出声的时刻 (发送端时钟)。各音箱：
+ * - 按序号统计丢包/乱序，按 RTP 时间戳把 PCM 放入抖动缓冲区，迟到的包丢弃
+ * - 与发送端做 NTP 式时钟同步 (取往返时间最短的样本)，把计划出声时刻换算为本地时间
+ * - 估算每块数据的实际出声时刻 (混音器缓冲 + I2S 实测延迟) 并与计划时刻比较，
+ *   以 ±ppm 级的采样率微调修正时钟漂移，误差过大时跳过或补静音重新对齐
+ *
+ * 发送端根据各音箱上报的到达抖动调整播放延迟 (每秒最多 0.5ms，在微调范围内)，
+ * 并汇总各音箱的出声误差得到设备间偏差。
+ */
+
+#ifndef AUDIO_SYNC_H
+#define AUDIO_SYNC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "include/audio_resampler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 线路格式 (与 tools/multiroom_sender.py 保持一致)
+ *
+ * 数据 (组播 UDP, port):
+ *   RTP 头 12 字节 (V=2, X=1, PT=96, 序号, 时间戳=帧计数, SSRC)
+ *   头扩展: 标识 0x4D52 ("MR"), 长度 2 (32 位字), 出声时刻 (int64 微秒, 发送端时钟, 大端)
+ *   载荷: L16 大端立体声 44.1kHz (RFC 3551)
+ *
+ * 时钟同步 (单播 UDP, 发送端 clock_port): 见 audio_sync_clock_msg_t, 小端
+ */
+
+/**
+ * @brief RTP 载荷类型 (L16/44100/2)
+ */
+#define AUDIO_SYNC_RTP_PT           96
+
+/**
+ * @brief 流采样率和声道数
+ */
+#define AUDIO_SYNC_SAMPLE_RATE      44100
+#define AUDIO_SYNC_CHANNELS         2
+
+/**
+ * @brief RTP 头扩展标识 ("MR")
+ */
+#define AUDIO_SYNC_EXT_PROFILE      0x4D52
+
+/**
+ * @brief 时钟同步消息标识 ("MRCS")
+ */
+#define AUDIO_SYNC_CLOCK_MAGIC      0x4D524353
+
+/**
+ * @brief 时钟同步消息 (请求和应答共用)
+ *
+ * 接收端填写 t1 和自身状态发出请求，发送端填写 t2/t3 后原样返回
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t magic;                 // AUDIO_SYNC_CLOCK_MAGIC
+    uint8_t  type;                  // 0 请求, 1 应答
+    uint8_t  reserved[3];
+    uint32_t seq;                   // 请求序号
+    int64_t  t1_us;                 // 请求发出时刻 (接收端时钟)
+    int64_t  t2_us;                 // 发送端收到时刻 (发送端时钟)
+    int64_t  t3_us;                 // 发送端应答时刻 (发送端时钟)
+    int32_t  playout_error_us;      // 接收端出声误差 (正值表示落后)
+    uint32_t jitter_us;             // 接收端到达抖动
+    uint32_t late;                  // 接收端迟到丢弃的包数
+    uint32_t lost;                  // 接收端丢包数
+    uint8_t  device_id[6];          // 接收端 MAC 地址
+    uint8_t  pad[2];
+} audio_sync_clock_msg_t;
+
+/**
+ * @brief 接收配置
+ */
+typedef struct {
+    const char *group;              // 组播地址
+    uint16_t    port;               // RTP 端口
+    uint16_t    clock_port;         // 发送端时钟同步端口 (发送端地址取自 RTP 包源地址)
+    uint32_t    buffer_frames;      // 抖动缓冲区容量 (帧, 2 的幂)，需大于发送端最大播放延迟
+    audio_resampler_quality_t quality;  // 漂移修正采样率转换质量
+    UBaseType_t task_priority;      // 接收/播放任务优先级
+} audio_sync_config_t;
+
+/**
+ * @brief 默认接收配置 (抖动缓冲约 370ms)
+ */
+#define AUDIO_SYNC_DEFAULT_CONFIG() {                   \
+    .group = "239.255.77.77",                           \
+    .port = 5004,                                       \
+    .clock_port = 5005,                                 \
+    .buffer_frames = 16384,                             \
+    .quality = AUDIO_RESAMPLER_QUALITY_MEDIUM,          \
+    .task_priority = 6,                                 \
+}
+
+/**
+ * @brief 同步播放状态
+ */
+typedef enum {
+    AUDIO_SYNC_STATE_IDLE = 0,      // 没有数据流
+    AUDIO_SYNC_STATE_SYNCING,       // 收到数据，等待时钟同步
+    AUDIO_SYNC_STATE_PLAYING,       // 按计划时刻播放
+} audio_sync_state_t;
+
+/**
+ * @brief 同步播放统计
+ */
+typedef struct {
+    audio_sync_state_t state;       // 当前状态
+    uint32_t packets;               // 收到的 RTP 包
+    uint32_t lost;                  // 序号缺口 (丢包)
+    uint32_t late;                  // 晚于播放位置到达而丢弃的包
+    uint32_t reordered;             // 乱序到达但仍及时的包
+    uint32_t jitter_us;             // 到达抖动 (RFC 3550 估计)
+    int64_t  clock_offset_us;       // 发送端时钟 - 本地时钟
+    uint32_t clock_rtt_us;          // 所选时钟同步样本的往返时间
+    int32_t  clock_rate_ppb;        // 发送端时钟相对本地时钟的频差估计 (十亿分之一)
+    int32_t  playout_error_us;      // 实际出声 - 计划出声 (平滑后, 正值表示落后)
+    int32_t  drift_ppb;             // 当前采样率修正 (十亿分之一)
+    uint32_t buffered_ms;           // 抖动缓冲区中已到达的音频
+    uint32_t resyncs;               // 跳过/补静音重新对齐的次数
+    uint32_t resample_us_per_s;     // 漂移修正耗时 (每秒音频的微秒数)
+} audio_sync_stats_t;
+
+/**
+ * @brief 开始接收组播并同步播放
+ *
+ * 需在 WiFi 连接、audio_player_init() 之后调用
+ *
+ * @param config 配置，NULL 使用 AUDIO_SYNC_DEFAULT_CONFIG()
+ * @return esp_err_t ESP_OK 成功
+ */
+esp_err_t audio_sync_start(const audio_sync_config_t *config);
+
+/**
+ * @brief 停止同步播放 (等待接收/播放任务退出)
+ *
+ * @return esp_err_t ESP_OK 成功
+ */
+esp_err_t audio_sync_stop(void);
+
+/**
+ * @brief 获取同步播放统计
+ *
+ * @param stats 输出统计
+ */
+void audio_sync_get_stats(audio_sync_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_SYNC_H
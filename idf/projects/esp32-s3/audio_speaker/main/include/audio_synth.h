@@ -0,0 +1,152 @@
+/**
+ * @file audio_synth.h
+ * @brief 查表 DDS 音源与无缝音序器
+ *
+ * - 32 位相位累加器 + 正弦查找表 + 线性插值，渲染时不调用 sinf()
+ * - 每个发音 (voice) 带 ADSR 包络，多个发音以 32 位累加混音
+ * - 音序器把音符列表渲染成连续的 PCM 流写入混音器的 "tone" 音源 (发声时闪避音乐)，
+ *   音符起止精确到采样点
+ *
+ * 非线程安全，同一时间只应由一个任务调用。
+ */
+
+#ifndef AUDIO_SYNTH_H
+#define AUDIO_SYNTH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 最大同时发音数
+ */
+#define AUDIO_SYNTH_MAX_VOICES      8
+
+/**
+ * @brief 正弦表长度 (log2)
+ */
+#define AUDIO_SYNTH_LUT_BITS        10
+
+/**
+ * @brief 每次渲染的最大帧数
+ */
+#define AUDIO_SYNTH_BLOCK_FRAMES    256
+
+/**
+ * @brief 提示音音源在混音器中的缓冲帧数
+ */
+#define AUDIO_SYNTH_RING_FRAMES     2048
+
+/**
+ * @brief ADSR 包络
+ */
+typedef struct {
+    uint16_t attack_ms;     // 起音时长
+    uint16_t decay_ms;      // 衰减到持续电平的时长
+    uint16_t sustain;       // 持续电平 (Q15)
+    uint16_t release_ms;    // 释音时长
+} audio_synth_adsr_t;
+
+/**
+ * @brief 默认包络 (短起音/释音，避免咔嗒声)
+ */
+#define AUDIO_SYNTH_DEFAULT_ADSR() {    \
+    .attack_ms = 5,                     \
+    .decay_ms = 60,                     \
+    .sustain = 26000,                   \
+    .release_ms = 40,                   \
+}
+
+/**
+ * @brief 音序器音符
+ *
+ * 起始时间和时长以毫秒给出，渲染时换算为采样点；时间重叠的音符同时发音
+ */
+typedef struct {
+    uint32_t start_ms;      // 起始时间 (相对音序开始)
+    uint32_t duration_ms;   // 按下时长 (不含释音)
+    float    freq_hz;       // 频率 (Hz)
+    uint16_t velocity;      // 力度 (Q15 振幅)
+} audio_synth_note_t;
+
+/**
+ * @brief 渲染统计
+ */
+typedef struct {
+    uint32_t render_us_per_s;   // 渲染耗时 (每秒音频的微秒数)
+    uint32_t us_per_voice_s;    // 单个发音每秒音频的渲染耗时 (微秒)
+    uint8_t  peak_voices;       // 最大同时发音数
+} audio_synth_stats_t;
+
+/**
+ * @brief 初始化音源 (生成正弦表并注册混音器音源)
+ *
+ * 需在 audio_mixer_init() 之后调用
+ *
+ * @param sample_rate 输出采样率 (Hz)
+ * @return esp_err_t ESP_OK 成功
+ */
+esp_err_t audio_synth_init(uint32_t sample_rate);
+
+/**
+ * @brief 开始一个发音
+ *
+ * 没有空闲发音时抢占电平最低的释音中发音，否则抢占最早开始的发音
+ *
+ * @param freq_hz 频率 (Hz)
+ * @param velocity 力度 (Q15 振幅)
+ * @param adsr 包络，NULL 使用默认包络
+ * @return int 发音编号
+ */
+int audio_synth_note_on(float freq_hz, uint16_t velocity, const audio_synth_adsr_t *adsr);
+
+/**
+ * @brief 结束发音 (进入释音阶段)
+ *
+ * @param voice 发音编号
+ */
+void audio_synth_note_off(int voice);
+
+/**
+ * @brief 立即停止所有发音
+ */
+void audio_synth_all_off(void);
+
+/**
+ * @brief 渲染单声道 PCM (所有发音混音)
+ *
+ * @param out 输出
+ * @param frames 帧数
+ * @return int 当前活动发音数
+ */
+int audio_synth_render(int16_t *out, size_t frames);
+
+/**
+ * @brief 渲染音符列表并连续写入混音器 (阻塞直到全部数据进入 I2S)
+ *
+ * 可从多个任务调用，同时到达的音序按获得互斥量的顺序依次播放。
+ * audio_synth_note_on() / note_off() / render() 不加锁，不要与本函数并发调用
+ *
+ * @param notes 音符列表 (按 start_ms 升序)
+ * @param count 音符数
+ * @param adsr 包络，NULL 使用默认包络
+ * @return esp_err_t ESP_OK 成功
+ */
+esp_err_t audio_synth_play_sequence(const audio_synth_note_t *notes, size_t count, const audio_synth_adsr_t *adsr);
+
+/**
+ * @brief 获取上一次音序播放的渲染统计
+ *
+ * @param stats 输出统计
+ */
+void audio_synth_get_stats(audio_synth_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUDIO_SYNTH_H
@@ -0,0 +1,45 @@
+/**
+ * @file web_server.h
+ * @brief HTTP 控制接口
+ *
+ * - GET  /api/fx   读取效果链配置和统计
+ * - POST /api/fx   修改效果链配置 (JSON，只需给出要修改的字段)
+ * - GET  /api/cache 片段缓存统计 (命中率、首样本时间)
+ * - GET  /api/pipeline 音频管道遥测 (状态、缓冲占用、欠载次数)
+ *
+ * JSON 格式:
+ *   {
+ *     "enabled": true,
+ *     "filters": [ {"type": "highpass", "freq": 120, "gain": 0, "q": 0.707}, ... ],
+ *     "drc": {"enabled": true, "threshold": -6, "ratio": 4, "attack": 2,
+ *             "release": 200, "lookahead": 3, "makeup": 0}
+ *   }
+ * filters 按下标对应各级滤波器，type 可取 off/peak/lowshelf/highshelf/highpass/lowpass。
+ */
+
+#ifndef WEB_SERVER_H
+#define WEB_SERVER_H
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 启动 HTTP 服务 (需在 WiFi 连接后调用)
+ *
+ * @return esp_err_t ESP_OK 成功
+ */
+esp_err_t web_server_start(void);
+
+/**
+ * @brief 停止 HTTP 服务
+ */
+void web_server_stop(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WEB_SERVER_H
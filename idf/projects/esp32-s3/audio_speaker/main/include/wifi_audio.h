@@ -2,7 +2,7 @@
  * @file wifi_audio.h
  * @brief WiFi 网络音频播放器
  * 
- * 从网络下载 WAV 音频文件并播放
+ * 从网络下载音频文件 (WAV/MP3) 并播放
  */
 
 #ifndef WIFI_AUDIO_H
@@ -20,6 +20,13 @@ extern "C" {
 #define WIFI_SSID       "mem2"
 #define WIFI_PASSWORD   "md11180829"
 
+/**
+ * @brief 网络模式循环播放的测试音频
+ *
+ * 用 tools/throttled_server.py 测试音频管道时改为 "http://<主机IP>:8000/test.wav"
+ */
+#define WIFI_AUDIO_TEST_URL "http://soundbible.com/grab.php?id=1817&type=wav"
+
 /**
  * @brief 初始化 WiFi 连接
  * 
@@ -36,9 +43,11 @@ esp_err_t wifi_audio_init_wifi(void);
 esp_err_t wifi_audio_wait_connected(uint32_t timeout_ms);
 
 /**
- * @brief 从网络下载并播放 WAV 音频
+ * @brief 从网络下载并播放音频
+ * 
+ * 根据数据头或 Content-Type 选择解码器 (WAV PCM/浮点/IMA-ADPCM, MP3)
  * 
- * @param url WAV 文件的 URL
+ * @param url 音频文件的 URL
  * @return esp_err_t ESP_OK 成功
  */
 esp_err_t wifi_audio_play_url(const char *url);
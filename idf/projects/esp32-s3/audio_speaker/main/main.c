@@ -5,6 +5,8 @@
  * 支持:
  * - 本地测试音 (正弦波、《小星星》)
  * - 网络音频流播放
+ * - 多房间同步播放 (UDP 组播)
+ * - 输出均衡/动态压缩 (HTTP 接口调整)
  */
 
 #include <stdio.h>
@@ -16,12 +18,18 @@
 #include "esp_chip_info.h"
 #include "include/audio_player.h"
 #include "include/wifi_audio.h"
+#include "include/audio_pipeline.h"
+#include "include/audio_decoder.h"
+#include "include/audio_sync.h"
+#include "include/web_server.h"
+#include "include/audio_cache.h"
 
 static const char *TAG = "main";
 
 // 选择播放模式
 #define PLAY_MODE_LOCAL     0   // 本地测试音
 #define PLAY_MODE_NETWORK   1   // 网络音频
+#define PLAY_MODE_MULTIROOM 2   // 多房间同步播放 (配合 tools/multiroom_sender.py)
 
 // 当前播放模式 - 修改这里切换模式
 #define CURRENT_PLAY_MODE   PLAY_MODE_LOCAL
@@ -112,6 +120,9 @@ static void network_audio_task(void *pvParameters)
     
     audio_player_set_volume(80);
     
+    // 均衡/压缩参数可通过 HTTP 调整
+    web_server_start();
+    
     while (1) {
         ESP_LOGI(TAG, "");
         ESP_LOGI(TAG, ">>> 播放网络音频 <<<");
@@ -124,6 +135,44 @@ static void network_audio_task(void *pvParameters)
     }
 }
 
+/**
+ * @brief 多房间同步播放任务
+ */
+static void multiroom_audio_task(void *pvParameters)
+{
+    ESP_LOGI(TAG, "多房间同步播放任务启动");
+    
+    if (wifi_audio_init_wifi() != ESP_OK || wifi_audio_wait_connected(30000) != ESP_OK) {
+        ESP_LOGE(TAG, "WiFi 连接失败");
+        vTaskDelete(NULL);
+        return;
+    }
+    
+    audio_player_set_volume(80);
+    web_server_start();
+    
+    esp_err_t ret = audio_sync_start(NULL);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "同步播放启动失败: %s", esp_err_to_name(ret));
+        vTaskDelete(NULL);
+        return;
+    }
+    
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(5000));
+        
+        audio_sync_stats_t stats;
+        audio_sync_get_stats(&stats);
+        if (stats.state == AUDIO_SYNC_STATE_PLAYING) {
+            ESP_LOGI(TAG, "同步: 误差 %ld us, 修正 %ld ppb, 时钟偏移 %lld us (往返 %lu us, 频差 %ld ppb), "
+                     "抖动 %lu us, 缓冲 %lu ms, 丢包 %lu, 迟到 %lu",
+                     (long)stats.playout_error_us, (long)stats.drift_ppb, (long long)stats.clock_offset_us,
+                     (unsigned long)stats.clock_rtt_us, (long)stats.clock_rate_ppb, (unsigned long)stats.jitter_us,
+                     (unsigned long)stats.buffered_ms, (unsigned long)stats.lost, (unsigned long)stats.late);
+        }
+    }
+}
+
 /**
  * @brief 主函数
  */
@@ -135,8 +184,13 @@ void app_main(void)
     // 打印接线指南
     print_wiring_guide();
     
-    // 初始化音频播放器
+    // 初始化音频播放器 (网络音乐用大 DMA 缓冲抗抖动，本地提示音优先响应速度)
     ESP_LOGI(TAG, "正在初始化音频播放器...");
+#if CURRENT_PLAY_MODE == PLAY_MODE_NETWORK || CURRENT_PLAY_MODE == PLAY_MODE_MULTIROOM
+    audio_player_set_latency_profile(AUDIO_PLAYER_LATENCY_ROBUST);
+#else
+    audio_player_set_latency_profile(AUDIO_PLAYER_LATENCY_LOW);
+#endif
     esp_err_t ret = audio_player_init();
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "音频播放器初始化失败: %s", esp_err_to_name(ret));
@@ -150,9 +204,32 @@ void app_main(void)
     ESP_LOGI(TAG, "模式: 网络音频播放");
     ESP_LOGI(TAG, "请确保已配置 WiFi (wifi_audio.h)");
     ESP_LOGI(TAG, "");
+    
+    // 初始化音频管道 (下载与播放解耦)
+    ret = audio_pipeline_init(NULL);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "音频管道初始化失败: %s", esp_err_to_name(ret));
+        return;
+    }
+    
+    // 初始化解码级 (WAV/MP3)
+    ret = audio_decoder_init();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "解码级初始化失败: %s", esp_err_to_name(ret));
+        return;
+    }
+    
+    // 片段缓存 (没有 clips 分区时直接从网络播放)
+    audio_cache_init(NULL);
+    
     ESP_LOGI(TAG, "3秒后开始...");
     vTaskDelay(pdMS_TO_TICKS(3000));
-    xTaskCreate(network_audio_task, "network_audio", 8192, NULL, 5, NULL);
+    // 下载任务同时运行 MP3 解码，栈需要大一些
+    xTaskCreate(network_audio_task, "network_audio", 12288, NULL, 5, NULL);
+#elif CURRENT_PLAY_MODE == PLAY_MODE_MULTIROOM
+    ESP_LOGI(TAG, "模式: 多房间同步播放");
+    ESP_LOGI(TAG, "");
+    xTaskCreate(multiroom_audio_task, "multiroom", 4096, NULL, 5, NULL);
 #else
     ESP_LOGI(TAG, "模式: 本地音频播放");
     ESP_LOGI(TAG, "");
@@ -0,0 +1,362 @@
+/**
+ * @file web_server.c
+ * @brief HTTP 控制接口实现
+ */
+
+#include "include/web_server.h"
+#include "include/audio_fx.h"
+#include "include/audio_cache.h"
+#include "include/audio_pipeline.h"
+#include <string.h>
+#include <stdlib.h>
+#include "esp_http_server.h"
+#include "esp_log.h"
+#include "cJSON.h"
+
+static const char *TAG = "web_server";
+
+// 请求体上限
+#define WEB_MAX_BODY    1024
+
+static httpd_handle_t server = NULL;
+
+// 滤波器类型名称 (下标与 audio_fx_filter_type_t 一致)
+static const char *const filter_type_names[] = {
+    "off", "peak", "lowshelf", "highshelf", "highpass", "lowpass",
+};
+
+/**
+ * @brief 发送 JSON 并释放
+ */
+static esp_err_t web_send_json(httpd_req_t *req, cJSON *json)
+{
+    char *str = cJSON_PrintUnformatted(json);
+    cJSON_Delete(json);
+    if (str == NULL) {
+        return httpd_resp_send_500(req);
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+    esp_err_t ret = httpd_resp_sendstr(req, str);
+    free(str);
+    return ret;
+}
+
+/**
+ * @brief 效果链配置与统计转换为 JSON
+ */
+static cJSON *web_fx_to_json(void)
+{
+    audio_fx_config_t c;
+    audio_fx_stats_t stats;
+    audio_fx_get_config(&c);
+    audio_fx_get_stats(&stats);
+
+    cJSON *root = cJSON_CreateObject();
+    if (root == NULL) {
+        return NULL;
+    }
+    cJSON_AddBoolToObject(root, "enabled", c.enabled);
+
+    cJSON *filters = cJSON_AddArrayToObject(root, "filters");
+    for (int i = 0; i < AUDIO_FX_MAX_FILTERS; i++) {
+        const audio_fx_filter_t *f = &c.filters[i];
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "type", filter_type_names[f->type]);
+        cJSON_AddNumberToObject(item, "freq", f->freq_hz);
+        cJSON_AddNumberToObject(item, "gain", f->gain_db);
+        cJSON_AddNumberToObject(item, "q", f->q);
+        cJSON_AddItemToArray(filters, item);
+    }
+
+    cJSON *drc = cJSON_AddObjectToObject(root, "drc");
+    cJSON_AddBoolToObject(drc, "enabled", c.drc.enabled);
+    cJSON_AddNumberToObject(drc, "threshold", c.drc.threshold_db);
+    cJSON_AddNumberToObject(drc, "ratio", c.drc.ratio);
+    cJSON_AddNumberToObject(drc, "attack", c.drc.attack_ms);
+    cJSON_AddNumberToObject(drc, "release", c.drc.release_ms);
+    cJSON_AddNumberToObject(drc, "lookahead", c.drc.lookahead_ms);
+    cJSON_AddNumberToObject(drc, "makeup", c.drc.makeup_db);
+
+    cJSON *st = cJSON_AddObjectToObject(root, "stats");
+    cJSON_AddNumberToObject(st, "fx_us_per_s", stats.fx_us_per_s);
+    cJSON_AddNumberToObject(st, "gain_reduction_db", stats.gain_reduction_db);
+    cJSON_AddNumberToObject(st, "max_reduction_db", stats.max_reduction_db);
+    cJSON_AddNumberToObject(st, "active_filters", stats.active_filters);
+    return root;
+}
+
+/**
+ * @brief 读取数值字段 (不存在时保持原值)
+ */
+static bool web_get_float(const cJSON *obj, const char *key, float *out)
+{
+    const cJSON *item = cJSON_GetObjectItem(obj, key);
+    if (item == NULL) {
+        return true;
+    }
+    if (!cJSON_IsNumber(item)) {
+        return false;
+    }
+    *out = (float)item->valuedouble;
+    return true;
+}
+
+/**
+ * @brief 读取布尔字段 (不存在时保持原值)
+ */
+static bool web_get_bool(const cJSON *obj, const char *key, bool *out)
+{
+    const cJSON *item = cJSON_GetObjectItem(obj, key);
+    if (item == NULL) {
+        return true;
+    }
+    if (!cJSON_IsBool(item)) {
+        return false;
+    }
+    *out = cJSON_IsTrue(item);
+    return true;
+}
+
+/**
+ * @brief 把 JSON 中给出的字段合并到配置
+ */
+static bool web_fx_from_json(const cJSON *root, audio_fx_config_t *c)
+{
+    if (!web_get_bool(root, "enabled", &c->enabled)) {
+        return false;
+    }
+
+    const cJSON *filters = cJSON_GetObjectItem(root, "filters");
+    if (filters != NULL) {
+        if (!cJSON_IsArray(filters) || cJSON_GetArraySize(filters) > AUDIO_FX_MAX_FILTERS) {
+            return false;
+        }
+        for (int i = 0; i < cJSON_GetArraySize(filters); i++) {
+            const cJSON *item = cJSON_GetArrayItem(filters, i);
+            audio_fx_filter_t *f = &c->filters[i];
+            if (cJSON_IsNull(item)) {
+                continue;
+            }
+            if (!cJSON_IsObject(item)) {
+                return false;
+            }
+
+            const cJSON *type = cJSON_GetObjectItem(item, "type");
+            if (type != NULL) {
+                if (!cJSON_IsString(type)) {
+                    return false;
+                }
+                int t = -1;
+                for (int k = 0; k < (int)(sizeof(filter_type_names) / sizeof(filter_type_names[0])); k++) {
+                    if (strcmp(type->valuestring, filter_type_names[k]) == 0) {
+                        t = k;
+                        break;
+                    }
+                }
+                if (t < 0) {
+                    return false;
+                }
+                f->type = (audio_fx_filter_type_t)t;
+            }
+            if (!web_get_float(item, "freq", &f->freq_hz) || !web_get_float(item, "gain", &f->gain_db) ||
+                !web_get_float(item, "q", &f->q)) {
+                return false;
+            }
+        }
+    }
+
+    const cJSON *drc = cJSON_GetObjectItem(root, "drc");
+    if (drc != NULL) {
+        if (!cJSON_IsObject(drc)) {
+            return false;
+        }
+        audio_fx_drc_t *d = &c->drc;
+        if (!web_get_bool(drc, "enabled", &d->enabled) ||
+            !web_get_float(drc, "threshold", &d->threshold_db) ||
+            !web_get_float(drc, "ratio", &d->ratio) ||
+            !web_get_float(drc, "attack", &d->attack_ms) ||
+            !web_get_float(drc, "release", &d->release_ms) ||
+            !web_get_float(drc, "lookahead", &d->lookahead_ms) ||
+            !web_get_float(drc, "makeup", &d->makeup_db)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief GET /api/fx
+ */
+static esp_err_t fx_get_handler(httpd_req_t *req)
+{
+    cJSON *json = web_fx_to_json();
+    if (json == NULL) {
+        return httpd_resp_send_500(req);
+    }
+    return web_send_json(req, json);
+}
+
+/**
+ * @brief POST /api/fx
+ */
+static esp_err_t fx_post_handler(httpd_req_t *req)
+{
+    if (req->content_len == 0 || req->content_len > WEB_MAX_BODY) {
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "body size");
+    }
+
+    char *body = malloc(req->content_len + 1);
+    if (body == NULL) {
+        return httpd_resp_send_500(req);
+    }
+    size_t received = 0;
+    while (received < req->content_len) {
+        int n = httpd_req_recv(req, body + received, req->content_len - received);
+        if (n <= 0) {
+            free(body);
+            return ESP_FAIL;
+        }
+        received += n;
+    }
+    body[received] = '\0';
+
+    cJSON *root = cJSON_Parse(body);
+    free(body);
+    if (root == NULL) {
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "invalid JSON");
+    }
+
+    audio_fx_config_t c;
+    audio_fx_get_config(&c);
+    bool ok = web_fx_from_json(root, &c);
+    cJSON_Delete(root);
+    if (!ok || audio_fx_set_config(&c) != ESP_OK) {
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "invalid parameter");
+    }
+
+    ESP_LOGI(TAG, "效果链配置已更新");
+    return fx_get_handler(req);
+}
+
+/**
+ * @brief GET /api/cache
+ */
+static esp_err_t cache_get_handler(httpd_req_t *req)
+{
+    audio_cache_stats_t stats;
+    audio_cache_get_stats(&stats);
+
+    cJSON *root = cJSON_CreateObject();
+    if (root == NULL) {
+        return httpd_resp_send_500(req);
+    }
+    cJSON_AddBoolToObject(root, "enabled", audio_cache_clip_limit() > 0);
+    cJSON_AddNumberToObject(root, "hits", stats.hits);
+    cJSON_AddNumberToObject(root, "misses", stats.misses);
+    cJSON_AddNumberToObject(root, "hit_pct", stats.hit_pct);
+    cJSON_AddNumberToObject(root, "revalidations", stats.revalidations);
+    cJSON_AddNumberToObject(root, "stores", stats.stores);
+    cJSON_AddNumberToObject(root, "evictions", stats.evictions);
+    cJSON_AddNumberToObject(root, "entries", stats.entries);
+    cJSON_AddNumberToObject(root, "used_bytes", stats.used_bytes);
+    cJSON_AddNumberToObject(root, "budget_bytes", stats.budget_bytes);
+    cJSON_AddNumberToObject(root, "hit_first_sample_us", stats.hit_first_sample_us);
+    cJSON_AddNumberToObject(root, "hit_first_sample_avg_us", stats.hit_first_sample_avg_us);
+    cJSON_AddNumberToObject(root, "miss_first_sample_us", stats.miss_first_sample_us);
+    cJSON_AddNumberToObject(root, "miss_first_sample_avg_us", stats.miss_first_sample_avg_us);
+    return web_send_json(req, root);
+}
+
+// 管道状态名称 (下标与 audio_pipeline_state_t 一致)
+static const char *const pipeline_state_names[] = {
+    "idle", "prebuffering", "playing", "underrun", "draining",
+};
+
+/**
+ * @brief GET /api/pipeline
+ */
+static esp_err_t pipeline_get_handler(httpd_req_t *req)
+{
+    audio_pipeline_stats_t stats;
+    audio_pipeline_get_stats(&stats);
+
+    cJSON *root = cJSON_CreateObject();
+    if (root == NULL) {
+        return httpd_resp_send_500(req);
+    }
+    cJSON_AddStringToObject(root, "state", pipeline_state_names[stats.state]);
+    cJSON_AddNumberToObject(root, "ring_size", stats.ring_size);
+    cJSON_AddBoolToObject(root, "in_psram", stats.in_psram);
+    cJSON_AddNumberToObject(root, "fill_bytes", stats.fill_bytes);
+    cJSON_AddNumberToObject(root, "fill_pct", stats.fill_pct);
+    cJSON_AddNumberToObject(root, "min_fill_bytes", stats.min_fill_bytes);
+    cJSON_AddNumberToObject(root, "buffered_ms", stats.buffered_ms);
+    cJSON_AddNumberToObject(root, "underruns", stats.underruns);
+    cJSON_AddNumberToObject(root, "total_underruns", stats.total_underruns);
+    cJSON_AddNumberToObject(root, "producer_pauses", stats.producer_pauses);
+    cJSON_AddNumberToObject(root, "bytes_written", (double)stats.bytes_written);
+    cJSON_AddNumberToObject(root, "bytes_played", (double)stats.bytes_played);
+    cJSON_AddNumberToObject(root, "resample_us_per_s", stats.resample_us_per_s);
+    cJSON_AddNumberToObject(root, "resample_dropped_frames", stats.resample_dropped_frames);
+    cJSON_AddNumberToObject(root, "start_us", stats.start_us);
+    return web_send_json(req, root);
+}
+
+/**
+ * @brief 启动 HTTP 服务
+ */
+esp_err_t web_server_start(void)
+{
+    if (server != NULL) {
+        return ESP_OK;
+    }
+
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    esp_err_t ret = httpd_start(&server, &config);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "HTTP 服务启动失败: %s", esp_err_to_name(ret));
+        server = NULL;
+        return ret;
+    }
+
+    const httpd_uri_t fx_get = {
+        .uri = "/api/fx",
+        .method = HTTP_GET,
+        .handler = fx_get_handler,
+    };
+    const httpd_uri_t fx_post = {
+        .uri = "/api/fx",
+        .method = HTTP_POST,
+        .handler = fx_post_handler,
+    };
+    const httpd_uri_t cache_get = {
+        .uri = "/api/cache",
+        .method = HTTP_GET,
+        .handler = cache_get_handler,
+    };
+    const httpd_uri_t pipeline_get = {
+        .uri = "/api/pipeline",
+        .method = HTTP_GET,
+        .handler = pipeline_get_handler,
+    };
+    httpd_register_uri_handler(server, &fx_get);
+    httpd_register_uri_handler(server, &fx_post);
+    httpd_register_uri_handler(server, &cache_get);
+    httpd_register_uri_handler(server, &pipeline_get);
+
+    ESP_LOGI(TAG, "HTTP 服务已启动 (端口 %d)", config.server_port);
+    return ESP_OK;
+}
+
+/**
+ * @brief 停止 HTTP 服务
+ */
+void web_server_stop(void)
+{
+    if (server != NULL) {
+        httpd_stop(server);
+        server = NULL;
+    }
+}
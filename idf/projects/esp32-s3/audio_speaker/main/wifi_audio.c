@@ -2,12 +2,17 @@
  * @file wifi_audio.c
  * @brief WiFi 网络音频播放器实现
  * 
- * 支持从网络下载 WAV 音频并播放
+ * 支持从网络下载 WAV (PCM/浮点/IMA-ADPCM) 和 MP3 音频并播放
  */
 
 #include "include/wifi_audio.h"
 #include "include/audio_player.h"
+#include "include/audio_pipeline.h"
+#include "include/audio_decoder.h"
+#include "include/audio_mixer.h"
+#include "include/audio_cache.h"
 #include <string.h>
+#include <strings.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/event_groups.h"
@@ -17,6 +22,8 @@
 #include "esp_netif.h"
 #include "nvs_flash.h"
 #include "esp_http_client.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
 
 static const char *TAG = "wifi_audio";
 
@@ -29,6 +36,15 @@ static EventGroupHandle_t s_wifi_event_group;
 static int s_retry_num = 0;
 #define MAX_RETRY 5
 
+// 写入音频管道的最长等待时间 (缓冲区满且播放停滞时放弃)
+#define WIFI_AUDIO_WRITE_TIMEOUT_MS   5000
+
+// 下载结束后等待缓冲数据播放完毕的最长时间
+#define WIFI_AUDIO_DRAIN_TIMEOUT_MS   30000
+
+// 从缓存播放时每次写入音频管道的字节数
+#define WIFI_AUDIO_CLIP_WRITE_BYTES   (16 * 1024)
+
 /**
  * @brief WiFi 事件处理器
  */
@@ -136,26 +152,29 @@ esp_err_t wifi_audio_wait_connected(uint32_t timeout_ms)
     }
 }
 
-// WAV 文件头结构
-typedef struct __attribute__((packed)) {
-    char riff[4];           // "RIFF"
-    uint32_t file_size;     // 文件大小 - 8
-    char wave[4];           // "WAVE"
-    char fmt[4];            // "fmt "
-    uint32_t fmt_size;      // fmt 块大小
-    uint16_t audio_format;  // 音频格式 (1 = PCM)
-    uint16_t num_channels;  // 声道数
-    uint32_t sample_rate;   // 采样率
-    uint32_t byte_rate;     // 字节率
-    uint16_t block_align;   // 块对齐
-    uint16_t bits_per_sample; // 位深度
-} wav_header_t;
+// 播放上下文 (解码输出回调使用)
+typedef struct {
+    char content_type[64];  // 响应的 Content-Type
+    char etag[AUDIO_CACHE_ETAG_LEN];    // 响应的 ETag (为空或过长时不缓存)
+    bool no_store;          // Cache-Control: no-store
+    bool stream_started;    // 管道数据流已开始
+    int64_t begin_us;       // 首次开始数据流的时间
+    // 解码结果暂存 (PSRAM)，播放结束后写入片段缓存
+    int16_t *capture;
+    size_t capture_len;
+    size_t capture_cap;
+    bool capture_ok;
+    uint32_t sample_rate;
+    uint8_t channels;
+} wifi_audio_ctx_t;
 
 /**
  * @brief HTTP 事件处理器
  */
 static esp_err_t http_event_handler(esp_http_client_event_t *evt)
 {
+    wifi_audio_ctx_t *ctx = (wifi_audio_ctx_t *)evt->user_data;
+    
     switch (evt->event_id) {
         case HTTP_EVENT_ERROR:
             ESP_LOGE(TAG, "HTTP 错误");
@@ -163,6 +182,21 @@ static esp_err_t http_event_handler(esp_http_client_event_t *evt)
         case HTTP_EVENT_ON_CONNECTED:
             ESP_LOGI(TAG, "HTTP 已连接");
             break;
+        case HTTP_EVENT_ON_HEADER:
+            if (ctx == NULL) {
+                break;
+            }
+            if (strcasecmp(evt->header_key, "Content-Type") == 0) {
+                strlcpy(ctx->content_type, evt->header_value, sizeof(ctx->content_type));
+            } else if (strcasecmp(evt->header_key, "ETag") == 0) {
+                if (strlcpy(ctx->etag, evt->header_value, sizeof(ctx->etag)) >= sizeof(ctx->etag)) {
+                    ctx->etag[0] = '\0';
+                }
+            } else if (strcasecmp(evt->header_key, "Cache-Control") == 0 &&
+                       strstr(evt->header_value, "no-store") != NULL) {
+                ctx->no_store = true;
+            }
+            break;
         case HTTP_EVENT_ON_DATA:
             // 数据在主函数中处理
             break;
@@ -173,15 +207,169 @@ static esp_err_t http_event_handler(esp_http_client_event_t *evt)
 }
 
 /**
- * @brief 从网络播放 WAV 音频
+ * @brief 解码输出：格式确定时开始管道数据流
+ */
+static esp_err_t wifi_audio_on_format(const audio_decoder_info_t *info, void *arg)
+{
+    wifi_audio_ctx_t *ctx = (wifi_audio_ctx_t *)arg;
+    
+    if (info->channels != 1 && info->channels != 2) {
+        ESP_LOGE(TAG, "不支持的声道数: %d", info->channels);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    
+    // 数据流中途格式变化：播放完已缓冲的数据后重新开始 (这样的数据不缓存)
+    if (ctx->stream_started) {
+        ESP_LOGW(TAG, "音频格式变化，重新开始数据流");
+        ctx->capture_ok = false;
+        if (audio_pipeline_end(WIFI_AUDIO_DRAIN_TIMEOUT_MS) != ESP_OK) {
+            audio_pipeline_abort();
+        }
+        ctx->stream_started = false;
+    }
+    
+    esp_err_t ret = audio_pipeline_begin(info->sample_rate, info->channels);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "音频管道启动失败: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    if (ctx->begin_us == 0) {
+        ctx->begin_us = esp_timer_get_time();
+    }
+    ctx->stream_started = true;
+    ctx->sample_rate = info->sample_rate;
+    ctx->channels = info->channels;
+    ESP_LOGI(TAG, "开始播放音频 (%lu Hz, %d 声道)...", (unsigned long)info->sample_rate, info->channels);
+    return ESP_OK;
+}
+
+/**
+ * @brief 解码输出：PCM 写入环形缓冲区，缓冲区满时自动暂停
+ */
+static esp_err_t wifi_audio_on_pcm(const int16_t *pcm, size_t bytes, void *arg)
+{
+    wifi_audio_ctx_t *ctx = (wifi_audio_ctx_t *)arg;
+
+    // 同时暂存一份，超过单个片段上限后放弃缓存
+    if (ctx->capture_ok) {
+        if (ctx->capture_len + bytes <= ctx->capture_cap) {
+            memcpy((uint8_t *)ctx->capture + ctx->capture_len, pcm, bytes);
+            ctx->capture_len += bytes;
+        } else {
+            ctx->capture_ok = false;
+        }
+    }
+
+    if (audio_pipeline_write(pcm, bytes, WIFI_AUDIO_WRITE_TIMEOUT_MS) != bytes) {
+        ESP_LOGW(TAG, "写入音频管道超时，停止下载");
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief 播放结束后输出统计
+ */
+static void wifi_audio_log_stats(void)
+{
+    audio_mixer_stats_t mix_stats;
+    audio_mixer_get_stats(&mix_stats);
+    for (uint8_t i = 0; i < mix_stats.num_sources; i++) {
+        ESP_LOGI(TAG, "混音音源 %s: 欠载 %lu 次", mix_stats.sources[i].name,
+                 (unsigned long)mix_stats.sources[i].underruns);
+    }
+    ESP_LOGI(TAG, "混音耗时: %lu us/s, 软限幅采样: %lu",
+             (unsigned long)mix_stats.mix_us_per_s, (unsigned long)mix_stats.limited_samples);
+    
+    audio_player_latency_t latency;
+    audio_player_get_latency(&latency);
+    ESP_LOGI(TAG, "I2S 输出延迟: 平均 %lu us, 最小 %lu us, 最大 %lu us (DMA %lu × %lu 帧)",
+             (unsigned long)latency.avg_us, (unsigned long)latency.min_us, (unsigned long)latency.max_us,
+             (unsigned long)latency.dma_desc_num, (unsigned long)latency.dma_frame_num);
+    
+    if (audio_cache_clip_limit() > 0) {
+        audio_cache_stats_t cache_stats;
+        audio_cache_get_stats(&cache_stats);
+        ESP_LOGI(TAG, "片段缓存: 命中率 %u%% (%lu/%lu), 首样本 命中 %lu us / 未命中 %lu us (平均)",
+                 cache_stats.hit_pct, (unsigned long)cache_stats.hits,
+                 (unsigned long)(cache_stats.hits + cache_stats.misses),
+                 (unsigned long)cache_stats.hit_first_sample_avg_us,
+                 (unsigned long)cache_stats.miss_first_sample_avg_us);
+    }
+}
+
+/**
+ * @brief 从映射的缓存片段播放
+ *
+ * 数据已在本地，预缓冲只需一块，首个 PCM 在一个 DMA 周期内送到混音器
+ */
+static esp_err_t wifi_audio_play_clip(const audio_cache_clip_t *clip, int64_t request_us)
+{
+    esp_err_t ret = audio_pipeline_begin_with_prebuffer(clip->sample_rate, clip->channels, 0);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "音频管道启动失败: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    int64_t begin_us = esp_timer_get_time();
+    
+    const uint8_t *p = (const uint8_t *)clip->pcm;
+    size_t remaining = clip->bytes;
+    while (remaining > 0) {
+        size_t n = remaining < WIFI_AUDIO_CLIP_WRITE_BYTES ? remaining : WIFI_AUDIO_CLIP_WRITE_BYTES;
+        if (audio_pipeline_write(p, n, WIFI_AUDIO_WRITE_TIMEOUT_MS) != n) {
+            ESP_LOGW(TAG, "写入音频管道超时，停止播放");
+            audio_pipeline_abort();
+            return ESP_ERR_TIMEOUT;
+        }
+        p += n;
+        remaining -= n;
+    }
+    
+    if (audio_pipeline_end(WIFI_AUDIO_DRAIN_TIMEOUT_MS) != ESP_OK) {
+        ESP_LOGW(TAG, "等待播放结束超时，中止播放");
+        audio_pipeline_abort();
+    }
+    
+    audio_pipeline_stats_t stats;
+    audio_pipeline_get_stats(&stats);
+    if (stats.start_us > 0) {
+        audio_cache_record_play(true, (uint32_t)(begin_us - request_us) + stats.start_us);
+    }
+    ESP_LOGI(TAG, "缓存片段播放完成，%u 字节 (%lu Hz, %d 声道)，首样本 %lu us",
+             (unsigned)clip->bytes, (unsigned long)clip->sample_rate, clip->channels,
+             (unsigned long)((begin_us - request_us) + stats.start_us));
+    
+    wifi_audio_log_stats();
+    return ESP_OK;
+}
+
+/**
+ * @brief 从网络播放音频 (WAV/MP3)
+ *
+ * 片段缓存可用时：免验证期内的缓存片段直接播放，过期的片段带 If-None-Match 请求，
+ * 304 时播放缓存；否则下载播放，并把解码结果写入缓存
  */
 esp_err_t wifi_audio_play_url(const char *url)
 {
+    int64_t request_us = esp_timer_get_time();
+    
+    audio_cache_clip_t clip;
+    bool cached = (audio_cache_open(url, &clip) == ESP_OK);
+    if (cached && clip.fresh) {
+        ESP_LOGI(TAG, "从缓存播放: %s", url);
+        esp_err_t ret = wifi_audio_play_clip(&clip, request_us);
+        audio_cache_close(&clip);
+        return ret;
+    }
+    
     ESP_LOGI(TAG, "开始下载音频: %s", url);
     
+    wifi_audio_ctx_t ctx = { 0 };
+    
     esp_http_client_config_t config = {
         .url = url,
         .event_handler = http_event_handler,
+        .user_data = &ctx,
         .buffer_size = 4096,
         .timeout_ms = 10000,
     };
@@ -189,132 +377,165 @@ esp_err_t wifi_audio_play_url(const char *url)
     esp_http_client_handle_t client = esp_http_client_init(&config);
     if (client == NULL) {
         ESP_LOGE(TAG, "HTTP 客户端初始化失败");
+        if (cached) {
+            audio_cache_close(&clip);
+        }
         return ESP_FAIL;
     }
+    if (cached) {
+        esp_http_client_set_header(client, "If-None-Match", clip.etag);
+    }
     
     esp_err_t err = esp_http_client_open(client, 0);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "HTTP 连接失败: %s", esp_err_to_name(err));
         esp_http_client_cleanup(client);
+        if (cached) {
+            // 服务器不可达时播放缓存中的旧版本
+            ESP_LOGW(TAG, "播放未经验证的缓存片段");
+            err = wifi_audio_play_clip(&clip, request_us);
+            audio_cache_close(&clip);
+        }
         return err;
     }
     
     int content_length = esp_http_client_fetch_headers(client);
-    ESP_LOGI(TAG, "文件大小: %d 字节", content_length);
+    int status = esp_http_client_get_status_code(client);
     
-    // 读取 WAV 头
-    wav_header_t wav_header;
-    int read_len = esp_http_client_read(client, (char *)&wav_header, sizeof(wav_header));
-    if (read_len != sizeof(wav_header)) {
-        ESP_LOGE(TAG, "读取 WAV 头失败");
-        esp_http_client_close(client);
-        esp_http_client_cleanup(client);
-        return ESP_FAIL;
+    if (cached) {
+        if (status == 304) {
+            esp_http_client_close(client);
+            esp_http_client_cleanup(client);
+            ESP_LOGI(TAG, "服务器确认未变化 (304)，从缓存播放");
+            audio_cache_revalidated(&clip);
+            esp_err_t ret = wifi_audio_play_clip(&clip, request_us);
+            audio_cache_close(&clip);
+            return ret;
+        }
     }
     
-    // 验证 WAV 格式
-    if (strncmp(wav_header.riff, "RIFF", 4) != 0 || strncmp(wav_header.wave, "WAVE", 4) != 0) {
-        ESP_LOGE(TAG, "不是有效的 WAV 文件");
+    // 其他状态码的响应体不是音频，不解码也不改动缓存
+    if (status != 200) {
+        ESP_LOGE(TAG, "HTTP 请求失败，状态码: %d", status);
         esp_http_client_close(client);
         esp_http_client_cleanup(client);
-        return ESP_ERR_INVALID_ARG;
+        if (cached) {
+            audio_cache_close(&clip);
+        }
+        return ESP_FAIL;
     }
     
-    ESP_LOGI(TAG, "WAV 信息: %d Hz, %d 声道, %d 位",
-             (int)wav_header.sample_rate,
-             wav_header.num_channels,
-             wav_header.bits_per_sample);
-    
-    // 根据 WAV 采样率重新配置 I2S
-    esp_err_t ret = audio_player_set_sample_rate(wav_header.sample_rate);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "设置采样率失败");
-        esp_http_client_close(client);
-        esp_http_client_cleanup(client);
-        return ret;
+    if (cached) {
+        // 内容已变化：删除旧片段，下载后按新的 ETag 重新缓存
+        audio_cache_close(&clip);
+        audio_cache_remove(url);
     }
     
-    // 跳过可能存在的额外头部数据
-    char chunk_id[4];
-    uint32_t chunk_size;
-    while (1) {
-        read_len = esp_http_client_read(client, chunk_id, 4);
-        if (read_len != 4) break;
-        
-        read_len = esp_http_client_read(client, (char *)&chunk_size, 4);
-        if (read_len != 4) break;
-        
-        if (strncmp(chunk_id, "data", 4) == 0) {
-            ESP_LOGI(TAG, "音频数据大小: %lu 字节", (unsigned long)chunk_size);
-            break;
-        }
-        
-        // 跳过非 data 块
-        char skip_buf[256];
-        uint32_t remaining = chunk_size;
-        while (remaining > 0) {
-            int to_read = (remaining > sizeof(skip_buf)) ? sizeof(skip_buf) : remaining;
-            read_len = esp_http_client_read(client, skip_buf, to_read);
-            if (read_len <= 0) break;
-            remaining -= read_len;
-        }
+    ESP_LOGI(TAG, "文件大小: %d 字节, 类型: %s", content_length,
+             ctx.content_type[0] ? ctx.content_type : "未知");
+    
+    // 有 ETag 的响应同时暂存解码结果，播放结束后写入缓存
+    size_t clip_limit = audio_cache_clip_limit();
+    if (clip_limit > 0 && ctx.etag[0] != '\0' && !ctx.no_store) {
+        ctx.capture = heap_caps_malloc(clip_limit, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        ctx.capture_cap = (ctx.capture != NULL) ? clip_limit : 0;
+        ctx.capture_ok = (ctx.capture != NULL);
     }
     
-    // 分配音频缓冲区
+    // 分配网络读取缓冲区
     const int buffer_size = 4096;
-    int16_t *audio_buffer = (int16_t *)malloc(buffer_size);
+    char *audio_buffer = (char *)malloc(buffer_size);
     if (audio_buffer == NULL) {
         ESP_LOGE(TAG, "内存分配失败");
+        heap_caps_free(ctx.capture);
         esp_http_client_close(client);
         esp_http_client_cleanup(client);
         return ESP_ERR_NO_MEM;
     }
     
-    // 流式播放音频
-    ESP_LOGI(TAG, "开始播放音频...");
+    // 根据第一块数据和 Content-Type 选择解码器
+    int read_len = esp_http_client_read(client, audio_buffer, buffer_size);
+    audio_format_t format = (read_len > 0) ?
+        audio_decoder_detect(ctx.content_type, (const uint8_t *)audio_buffer, read_len) : AUDIO_FORMAT_UNKNOWN;
+    
+    audio_decoder_sink_t sink = {
+        .on_format = wifi_audio_on_format,
+        .on_pcm = wifi_audio_on_pcm,
+        .arg = &ctx,
+    };
+    esp_err_t ret = audio_decoder_open(format, &sink);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "不支持的音频格式");
+        free(audio_buffer);
+        heap_caps_free(ctx.capture);
+        esp_http_client_close(client);
+        esp_http_client_cleanup(client);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    
+    // 本任务只负责下载和解码，播放由管道的播放任务完成
     int total_read = 0;
+    int chunk_count = 0;
     
-    while (1) {
-        read_len = esp_http_client_read(client, (char *)audio_buffer, buffer_size);
-        if (read_len <= 0) {
-            break;
-        }
-        
+    while (read_len > 0) {
         total_read += read_len;
         
-        // 播放音频数据
-        // 如果是单声道，需要转换为立体声
-        if (wav_header.num_channels == 1) {
-            // 单声道数据
-            int16_t *stereo_buf = (int16_t *)malloc(read_len * 2);
-            if (stereo_buf) {
-                int sample_count = read_len / sizeof(int16_t);
-                for (int i = 0; i < sample_count; i++) {
-                    stereo_buf[i * 2] = audio_buffer[i];
-                    stereo_buf[i * 2 + 1] = audio_buffer[i];
-                }
-                audio_player_play(audio_buffer, read_len, 1000);
-                free(stereo_buf);
-            }
-        } else {
-            // 立体声数据，直接发送
-            size_t bytes_written = 0;
-            extern esp_err_t audio_player_play_stereo(const int16_t *data, size_t len, uint32_t wait_ms);
-            audio_player_play_stereo(audio_buffer, read_len, 1000);
+        ret = audio_decoder_feed((const uint8_t *)audio_buffer, read_len);
+        if (ret != ESP_OK) {
+            break;
         }
         
-        // 显示进度
-        if (content_length > 0 && (total_read % (buffer_size * 10)) == 0) {
-            ESP_LOGI(TAG, "播放进度: %d%%", (total_read * 100) / content_length);
+        // 显示进度和缓冲状态
+        if (++chunk_count % 10 == 0) {
+            audio_pipeline_stats_t stats;
+            audio_decoder_stats_t dec_stats;
+            audio_pipeline_get_stats(&stats);
+            audio_decoder_get_stats(&dec_stats);
+            ESP_LOGI(TAG, "下载进度: %d%%, 缓冲: %u%% (%lu ms), 欠载: %lu, 解码: %lu us/s",
+                     content_length > 0 ? (total_read * 100) / content_length : 0,
+                     stats.fill_pct, (unsigned long)stats.buffered_ms,
+                     (unsigned long)stats.underruns, (unsigned long)dec_stats.decode_us_per_s);
         }
+        
+        read_len = esp_http_client_read(client, audio_buffer, buffer_size);
     }
     
-    ESP_LOGI(TAG, "音频播放完成，共播放 %d 字节", total_read);
+    // 只缓存完整下载且解码无误的数据
+    bool complete = (ret == ESP_OK && read_len == 0 && (content_length <= 0 || total_read == content_length));
     
+    audio_decoder_close();
     free(audio_buffer);
     esp_http_client_close(client);
     esp_http_client_cleanup(client);
     
+    if (!ctx.stream_started) {
+        ESP_LOGE(TAG, "没有可播放的音频数据");
+        heap_caps_free(ctx.capture);
+        return (ret != ESP_OK) ? ret : ESP_FAIL;
+    }
+    
+    // 等待缓冲数据播放完毕
+    if (audio_pipeline_end(WIFI_AUDIO_DRAIN_TIMEOUT_MS) != ESP_OK) {
+        ESP_LOGW(TAG, "等待播放结束超时，中止播放");
+        audio_pipeline_abort();
+    }
+    
+    audio_pipeline_stats_t stats;
+    audio_pipeline_get_stats(&stats);
+    ESP_LOGI(TAG, "音频播放完成，共下载 %d 字节，播放 %llu 字节，欠载 %lu 次，最低缓冲 %u 字节",
+             total_read, (unsigned long long)stats.bytes_played,
+             (unsigned long)stats.underruns, (unsigned)stats.min_fill_bytes);
+    if (stats.start_us > 0) {
+        audio_cache_record_play(false, (uint32_t)(ctx.begin_us - request_us) + stats.start_us);
+    }
+    
+    // 播放结束后再擦写 Flash，避免擦除期间 Flash 缓存禁用影响播放
+    if (ctx.capture_ok && complete && ctx.capture_len > 0) {
+        audio_cache_store(url, ctx.etag, ctx.sample_rate, ctx.channels, ctx.capture, ctx.capture_len);
+    }
+    heap_caps_free(ctx.capture);
+    
+    wifi_audio_log_stats();
     return ESP_OK;
 }
 
@@ -323,11 +544,8 @@ esp_err_t wifi_audio_play_url(const char *url)
  */
 esp_err_t wifi_audio_play_test(void)
 {
-    // NASA 公开的音频 - "Houston, we have a problem"
-    // PCM WAV 格式
-    const char *test_url = "http://soundbible.com/grab.php?id=1817&type=wav";
-    
+    // 默认为 NASA 公开的音频 - "Houston, we have a problem" (PCM WAV 格式)
     ESP_LOGI(TAG, "播放网络音频...");
-    return wifi_audio_play_url(test_url);
+    return wifi_audio_play_url(WIFI_AUDIO_TEST_URL);
 }
 
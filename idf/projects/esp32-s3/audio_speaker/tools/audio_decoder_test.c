@@ -0,0 +1,253 @@
+/*
+ * 解码级主机一致性和吞吐量测试 (Linux / macOS)
+ *
+ * 读取 tools/decoder_vectors.py 生成的参考码流，经设备上相同的 main/audio_decoder.c
+ * (格式识别、输入缓冲、解码器表) 和 audio_decoder_wav.c / audio_decoder_mp3.c 解码，检查:
+ * - 输出 PCM 与参考输出逐位一致 (IMA-ADPCM 参考来自 CPython audioop)
+ * - 采样率、声道数、帧数正确；每次 feed 的长度分别为 1、7、255、4096 字节和整个文件，结果相同
+ * 然后按 4096 字节一次 (与 HTTP 读取相同) 重复解码，输出每秒音频的解码耗时 (decode_us_per_s) 和实时倍数。
+ *
+ * MP3 使用 tools/host/esp_audio_dec.h 替身 (只解析帧头，输出静音)：检查的是 audio_decoder_mp3.c 的
+ * ID3v2 跳过、分帧和重新同步，不是 esp_audio_codec 的解码质量；MP3 的解码耗时只能在设备上
+ * 通过 audio_decoder_get_stats() 测量，这里不输出。
+ *
+ * 编译和运行:
+ *     python3 tools/decoder_vectors.py -o decoder_vectors
+ *     cc -O2 -Imain -Itools/host -o decoder_test tools/audio_decoder_test.c \
+ *        main/audio_decoder.c main/audio_decoder_wav.c main/audio_decoder_mp3.c main/audio_dsp.c
+ *     ./decoder_test decoder_vectors          # 一致性 + 吞吐量
+ *     ./decoder_test decoder_vectors 50       # 吞吐量测试每个文件重复 50 次
+ */
+
+#include "include/audio_decoder.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_REPEAT  20
+#define BENCH_FEED      4096
+
+static const size_t feed_sizes[] = { 1, 7, 255, 4096, 0 };     // 0 表示整个文件
+
+// 输出端：记录格式并收集 PCM
+typedef struct {
+    audio_decoder_info_t info;
+    int format_calls;
+    int16_t *pcm;
+    size_t bytes;
+    size_t cap;
+    bool collect;
+} sink_ctx_t;
+
+static esp_err_t on_format(const audio_decoder_info_t *info, void *arg)
+{
+    sink_ctx_t *ctx = arg;
+    ctx->info = *info;
+    ctx->format_calls++;
+    return ESP_OK;
+}
+
+static esp_err_t on_pcm(const int16_t *pcm, size_t bytes, void *arg)
+{
+    sink_ctx_t *ctx = arg;
+    if (ctx->collect) {
+        if (ctx->bytes + bytes > ctx->cap) {
+            ctx->cap = (ctx->bytes + bytes) * 2;
+            ctx->pcm = realloc(ctx->pcm, ctx->cap);
+        }
+        memcpy((uint8_t *)ctx->pcm + ctx->bytes, pcm, bytes);
+    }
+    ctx->bytes += bytes;
+    return ESP_OK;
+}
+
+static uint8_t *read_file(const char *path, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long n = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *buf = malloc(n > 0 ? (size_t)n : 1);
+    if (buf != NULL && fread(buf, 1, (size_t)n, f) != (size_t)n) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(f);
+    *len = (size_t)n;
+    return buf;
+}
+
+/**
+ * 按 feed 字节一次解码整个文件
+ */
+static esp_err_t decode(const uint8_t *data, size_t len, size_t feed, sink_ctx_t *ctx, audio_decoder_stats_t *stats)
+{
+    audio_decoder_sink_t sink = { .on_format = on_format, .on_pcm = on_pcm, .arg = ctx };
+    audio_format_t fmt = audio_decoder_detect(NULL, data, len);
+    esp_err_t ret = audio_decoder_open(fmt, &sink);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    if (feed == 0) {
+        feed = len;
+    }
+    for (size_t pos = 0; pos < len && ret == ESP_OK; pos += feed) {
+        size_t n = (len - pos < feed) ? len - pos : feed;
+        ret = audio_decoder_feed(data + pos, n);
+    }
+    audio_decoder_get_stats(stats);
+    audio_decoder_close();
+    return ret;
+}
+
+typedef struct {
+    char name[64];
+    char file[64];
+    char format[8];
+    unsigned rate;
+    unsigned channels;
+    unsigned long frames;
+} vector_t;
+
+static int check_vector(const char *dir, const vector_t *v)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", dir, v->file);
+    size_t len = 0;
+    uint8_t *data = read_file(path, &len);
+    snprintf(path, sizeof(path), "%s/%s.pcm", dir, v->name);
+    size_t ref_len = 0;
+    uint8_t *ref = read_file(path, &ref_len);
+    if (data == NULL || ref == NULL) {
+        printf("%-32s missing file\n", v->name);
+        free(data);
+        free(ref);
+        return 1;
+    }
+
+    int failures = 0;
+    uint32_t errors_min = UINT32_MAX;
+    uint32_t errors_max = 0;
+    for (size_t i = 0; i < sizeof(feed_sizes) / sizeof(feed_sizes[0]); i++) {
+        sink_ctx_t ctx = { .collect = true };
+        audio_decoder_stats_t stats;
+        esp_err_t ret = decode(data, len, feed_sizes[i], &ctx, &stats);
+
+        const char *why = NULL;
+        size_t mismatch = 0;
+        if (ret != ESP_OK) {
+            why = esp_err_to_name(ret);
+        } else if (ctx.format_calls != 1 || ctx.info.sample_rate != v->rate || ctx.info.channels != v->channels) {
+            why = "format";
+        } else if (ctx.bytes != ref_len) {
+            why = "length";
+        } else {
+            const int16_t *a = ctx.pcm;
+            const int16_t *b = (const int16_t *)ref;
+            for (size_t k = 0; k < ref_len / 2; k++) {
+                if (a[k] != b[k]) {
+                    mismatch++;
+                }
+            }
+            if (mismatch > 0) {
+                why = "samples";
+            }
+        }
+        // 重新同步次数与数据到达的边界有关 (垃圾数据可能分几次跳过)，只统计范围
+        errors_min = stats.errors < errors_min ? stats.errors : errors_min;
+        errors_max = stats.errors > errors_max ? stats.errors : errors_max;
+        if (why != NULL) {
+            printf("%-32s feed %-5zu FAIL: %s (%zu/%zu bytes, %zu samples differ, %u Hz %u ch)\n",
+                   v->name, feed_sizes[i], why, ctx.bytes, ref_len, mismatch,
+                   (unsigned)ctx.info.sample_rate, ctx.info.channels);
+            failures++;
+        }
+        free(ctx.pcm);
+    }
+
+    if (failures == 0) {
+        printf("%-32s %-4s %6u Hz %u ch %8lu frames  resyncs %3u-%-3u ok (feeds 1/7/255/4096/all)\n",
+               v->name, v->format, v->rate, v->channels, v->frames, (unsigned)errors_min, (unsigned)errors_max);
+    }
+    free(data);
+    free(ref);
+    return failures;
+}
+
+static void bench_vector(const char *dir, const vector_t *v, int repeat)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", dir, v->file);
+    size_t len = 0;
+    uint8_t *data = read_file(path, &len);
+    if (data == NULL) {
+        return;
+    }
+
+    uint64_t us_per_s = 0;
+    uint32_t best = UINT32_MAX;
+    for (int r = 0; r < repeat; r++) {
+        sink_ctx_t ctx = { .collect = false };
+        audio_decoder_stats_t stats;
+        decode(data, len, BENCH_FEED, &ctx, &stats);
+        us_per_s += stats.decode_us_per_s;
+        if (stats.decode_us_per_s < best) {
+            best = stats.decode_us_per_s;
+        }
+    }
+    double kbps = len * 8.0 / 1000.0 / ((double)v->frames / v->rate);
+    printf("%-32s %8.0f %10.1f %10u %10.0fx\n", v->name, kbps, (double)us_per_s / repeat, best,
+           best > 0 ? 1e6 / best : 0.0);
+    free(data);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <vector dir> [repeat]\n", argv[0]);
+        return 2;
+    }
+    const char *dir = argv[1];
+    int repeat = argc > 2 ? atoi(argv[2]) : DEFAULT_REPEAT;
+    if (repeat <= 0) {
+        repeat = DEFAULT_REPEAT;
+    }
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s/manifest.txt", dir);
+    FILE *m = fopen(path, "r");
+    if (m == NULL) {
+        fprintf(stderr, "%s not found (run tools/decoder_vectors.py first)\n", path);
+        return 2;
+    }
+    vector_t vectors[32];
+    int count = 0;
+    while (count < 32 && fscanf(m, "%63s %63s %7s %u %u %lu", vectors[count].name, vectors[count].file,
+                                vectors[count].format, &vectors[count].rate, &vectors[count].channels,
+                                &vectors[count].frames) == 6) {
+        count++;
+    }
+    fclose(m);
+
+    if (audio_decoder_init() != ESP_OK) {
+        return 2;
+    }
+
+    int failures = 0;
+    for (int i = 0; i < count; i++) {
+        failures += check_vector(dir, &vectors[i]);
+    }
+    printf("%d vectors, %d failures\n\n", count, failures);
+
+    printf("%d runs per file, %d-byte feeds (MP3 uses the host stub and is not timed)\n", repeat, BENCH_FEED);
+    printf("%-32s %8s %10s %10s %11s\n", "vector", "kbit/s", "avg_us/s", "best_us/s", "realtime");
+    for (int i = 0; i < count; i++) {
+        if (strcmp(vectors[i].format, "wav") == 0) {
+            bench_vector(dir, &vectors[i], repeat);
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
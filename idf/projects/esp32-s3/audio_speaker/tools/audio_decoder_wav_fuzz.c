@@ -0,0 +1,575 @@
+/*
+ * WAV 解码器主机模糊测试和吞吐量测试 (Linux / macOS)
+ *
+ * 经设备上相同的 main/audio_decoder.c 和 audio_decoder_wav.c 解码，分三部分:
+ * 1. 一致性：8/16/24/32 位 PCM、32 位浮点、WAVE_FORMAT_EXTENSIBLE (PCM / 浮点)、奇数长度未知块
+ *    (data 不按 4 字节对齐)、流式长度 (0 / 0xFFFFFFFF)、data 末尾不足一帧，
+ *    按 1~9000 字节的随机长度分段喂入，输出与本文件中独立写的标量参考转换逐位一致
+ * 2. 模糊：随机改写 RIFF/fmt/块头字段 (置 0、0xFFFFFFFF、随机值、翻转位)、插入未知块、截断，
+ *    要求只返回 ESP_OK / ESP_ERR_NOT_SUPPORTED，输出格式合法、PCM 长度按帧对齐且不超过输入的 4 倍，
+ *    并且随机分段与整个文件一次喂入的结果 (返回值、格式、PCM 内容) 相同
+ * 3. 吞吐量：按 4096 字节一次 (与 HTTP 读取相同) 解码，输出每秒音频的解码耗时 (含解码级的缓冲复制) 和 MB/s
+ *
+ * 编译和运行 (模糊测试建议打开 ASan / UBSan):
+ *     cc -O1 -g -fsanitize=address,undefined -Imain -Itools/host -o wav_fuzz tools/audio_decoder_wav_fuzz.c \
+ *        main/audio_decoder.c main/audio_decoder_wav.c main/audio_decoder_mp3.c main/audio_dsp.c -lm
+ *     ./wav_fuzz                   # 默认 20000 个变异文件
+ *     ./wav_fuzz 200000 7          # 变异文件数、随机种子
+ *     cc -O2 ... 同上不加 -fsanitize，测吞吐量
+ */
+
+#include "include/audio_decoder.h"
+#include "esp_timer.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_CASES   20000
+#define MAX_SPLIT       9000
+#define BENCH_FEED      4096
+#define BENCH_REPEAT    50
+
+// ---------------------------------------------------------------------------
+// 随机数 (xorshift64*)
+// ---------------------------------------------------------------------------
+
+static uint64_t rng_state = 1;
+
+static uint32_t rnd(void)
+{
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return (uint32_t)((rng_state * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+static uint32_t rnd_range(uint32_t lo, uint32_t hi)
+{
+    return lo + rnd() % (hi - lo + 1);
+}
+
+// 分段长度：一半在 1~16 字节 (边界落在块头内部)，一半在 1~9000 字节均匀分布
+static size_t rnd_split(void)
+{
+    return (rnd() & 1) ? rnd_range(1, 16) : rnd_range(1, MAX_SPLIT);
+}
+
+// ---------------------------------------------------------------------------
+// WAV 文件构造
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    uint8_t *data;
+    size_t len;
+    size_t cap;
+} buf_t;
+
+static void put(buf_t *b, const void *p, size_t n)
+{
+    if (b->len + n > b->cap) {
+        b->cap = (b->len + n) * 2;
+        b->data = realloc(b->data, b->cap);
+    }
+    memcpy(b->data + b->len, p, n);
+    b->len += n;
+}
+
+static void put16(buf_t *b, uint16_t v)
+{
+    uint8_t p[2] = { (uint8_t)v, (uint8_t)(v >> 8) };
+    put(b, p, 2);
+}
+
+static void put32(buf_t *b, uint32_t v)
+{
+    uint8_t p[4] = { (uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24) };
+    put(b, p, 4);
+}
+
+static void put_chunk(buf_t *b, const char *tag, const void *p, uint32_t n)
+{
+    put(b, tag, 4);
+    put32(b, n);
+    put(b, p, n);
+    if (n & 1) {
+        put(b, "", 1);
+    }
+}
+
+// 编码
+enum { ENC_PCM = 1, ENC_FLOAT = 3, ENC_IMA = 0x11 };
+
+typedef struct {
+    const char *name;
+    int enc;
+    int container;          // 容器位深
+    int valid_bits;         // EXTENSIBLE 有效位数，0 表示不用 EXTENSIBLE
+    uint32_t rate;
+    int channels;
+    int odd_chunk;          // data 之前插入 6 字节未知块 (data 不按 4 字节对齐)
+    int stream_size;        // 0: 正常; 1: data 长度写 0; 2: 写 0xFFFFFFFF
+    int tail_bytes;         // data 末尾不足一帧的字节数 (之后还有一个未知块)
+    int specials;           // 浮点：插入 ±1.5、±Inf、NaN
+} wav_spec_t;
+
+static const wav_spec_t s_specs[] = {
+    { "pcm8_mono_8k",            ENC_PCM,   8,  0,  8000,  1, 0, 0, 0, 0 },
+    { "pcm16_stereo_44k",        ENC_PCM,   16, 0,  44100, 2, 0, 0, 0, 0 },
+    { "pcm24_stereo_48k",        ENC_PCM,   24, 0,  48000, 2, 0, 0, 0, 0 },
+    { "pcm32_stereo_48k_odd",    ENC_PCM,   32, 0,  48000, 2, 1, 0, 0, 0 },
+    { "float_stereo_44k_odd",    ENC_FLOAT, 32, 0,  44100, 2, 1, 0, 0, 1 },
+    { "ext_pcm20in24_stereo_96k", ENC_PCM,  24, 20, 96000, 2, 0, 0, 0, 0 },
+    { "ext_float_mono_16k",      ENC_FLOAT, 32, 32, 16000, 1, 0, 0, 0, 1 },
+    { "pcm16_mono_stream0",      ENC_PCM,   16, 0,  22050, 1, 0, 1, 0, 0 },
+    { "pcm16_stereo_streamff",   ENC_PCM,   16, 0,  32000, 2, 1, 2, 1, 0 },
+    { "pcm24_mono_tail",         ENC_PCM,   24, 0,  24000, 1, 0, 0, 2, 0 },
+    { "ima_stereo_b1024",        ENC_IMA,   4,  0,  22050, 2, 0, 0, 0, 0 },
+};
+
+#define SPEC_COUNT      (sizeof(s_specs) / sizeof(s_specs[0]))
+
+typedef struct {
+    buf_t file;
+    int16_t *expect;        // 参考输出 (IMA 为 NULL，只用于模糊)
+    size_t expect_bytes;
+    size_t frames;
+} wav_vector_t;
+
+// 测试信号：32 位满幅扫频叠加噪声，包含正负满幅
+static int32_t signal_at(size_t i, int ch)
+{
+    if (i % 997 == 0) {
+        return (i / 997) & 1 ? INT32_MIN : INT32_MAX;
+    }
+    double t = (double)i / 800.0;
+    double v = 0.8 * sin(t * (1.0 + t * 0.01) + ch) + 0.15 * ((double)(rnd() & 0xFFFF) / 32768.0 - 1.0);
+    return (int32_t)(v * 2147483647.0);
+}
+
+static float float_special(size_t i)
+{
+    static const float vals[] = { 1.5f, -1.5f, INFINITY, -INFINITY, NAN, 1.0f, -1.0f, 0.99999994f };
+    return vals[(i / 331) % (sizeof(vals) / sizeof(vals[0]))];
+}
+
+// 标量参考转换 (与 audio_dsp.h 中各转换函数的约定相同，独立实现)
+static int16_t ref_sample(const wav_spec_t *s, int32_t v, float f)
+{
+    if (s->enc == ENC_FLOAT) {
+        if (f != f) {
+            return 0;
+        }
+        double x = (double)f * 32768.0;
+        if (x >= 32767.0) {
+            return INT16_MAX;
+        }
+        if (x <= -32768.0) {
+            return INT16_MIN;
+        }
+        return (int16_t)trunc(x);
+    }
+    if (s->container == 8) {
+        return (int16_t)((v >> 24) * 256);  // (u8 - 128) << 8
+    }
+    return (int16_t)(v >> 16);              // 16/24/32 位都取最高 16 位
+}
+
+static void make_vector(const wav_spec_t *s, size_t frames, wav_vector_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    buf_t data = { 0 };
+    int bytes = s->container / 8;
+    size_t samples = frames * s->channels;
+
+    if (s->enc == ENC_IMA) {
+        // 只用于模糊：合法块头 + 随机半字节
+        uint16_t block_align = 1024;
+        size_t blocks = frames / ((block_align - 4 * s->channels) * 2 / s->channels + 1) + 1;
+        for (size_t b = 0; b < blocks * block_align; b++) {
+            uint8_t v = (uint8_t)rnd();
+            if (b % block_align == 2 || b % block_align == 6) {
+                v %= 89;
+            } else if (b % block_align == 3 || b % block_align == 7) {
+                v = 0;
+            }
+            put(&data, &v, 1);
+        }
+    } else {
+        out->expect = malloc(samples * sizeof(int16_t) + 1);
+        for (size_t i = 0; i < samples; i++) {
+            int32_t v = signal_at(i / s->channels, (int)(i % s->channels));
+            float f = (float)v / 2147483648.0f;
+            if (s->specials && i % 331 == 0) {
+                f = float_special(i);
+            }
+            if (s->enc == ENC_FLOAT) {
+                put(&data, &f, 4);
+            } else if (bytes == 1) {
+                uint8_t u = (uint8_t)((v >> 24) + 128);
+                put(&data, &u, 1);
+            } else {
+                // 有效位数以下的低位清零 (EXTENSIBLE 20 位放在 24 位容器中)
+                if (s->valid_bits > 0 && s->valid_bits < 32) {
+                    v &= (int32_t)(0xFFFFFFFFu << (32 - s->valid_bits));
+                }
+                uint32_t u = (uint32_t)v;
+                uint8_t p[4] = { (uint8_t)u, (uint8_t)(u >> 8), (uint8_t)(u >> 16), (uint8_t)(u >> 24) };
+                put(&data, p + (4 - bytes), bytes);
+            }
+            out->expect[i] = ref_sample(s, v, f);
+        }
+        out->expect_bytes = samples * sizeof(int16_t);
+        out->frames = frames;
+        for (int i = 0; i < s->tail_bytes; i++) {
+            put(&data, "\x5A", 1);
+        }
+    }
+
+    // fmt 块
+    buf_t fmt = { 0 };
+    uint16_t block_align = (s->enc == ENC_IMA) ? 1024 : (uint16_t)(bytes * s->channels);
+    put16(&fmt, s->valid_bits ? 0xFFFE : (uint16_t)s->enc);
+    put16(&fmt, (uint16_t)s->channels);
+    put32(&fmt, s->rate);
+    put32(&fmt, s->rate * block_align);
+    put16(&fmt, block_align);
+    put16(&fmt, (uint16_t)s->container);
+    if (s->enc == ENC_IMA) {
+        put16(&fmt, 2);
+        put16(&fmt, (uint16_t)((block_align - 4 * s->channels) * 2 / s->channels + 1));
+    } else if (s->valid_bits) {
+        static const uint8_t guid_tail[14] = {
+            0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71,
+        };
+        put16(&fmt, 22);
+        put16(&fmt, (uint16_t)s->valid_bits);
+        put32(&fmt, s->channels == 2 ? 0x3 : 0x4);
+        put16(&fmt, (uint16_t)s->enc);
+        put(&fmt, guid_tail, sizeof(guid_tail));
+    }
+
+    buf_t body = { 0 };
+    put(&body, "WAVE", 4);
+    put_chunk(&body, "fmt ", fmt.data, (uint32_t)fmt.len);
+    if (s->odd_chunk) {
+        put_chunk(&body, "junk", "\x01\x02\x03\x04\x05\x06", 6);
+    }
+    size_t data_pos = body.len;
+    put_chunk(&body, "data", data.data, (uint32_t)data.len);
+    if (s->stream_size) {
+        uint32_t v = (s->stream_size == 1) ? 0 : 0xFFFFFFFFu;
+        memcpy(body.data + data_pos + 4, &v, 4);
+    } else if (s->tail_bytes) {
+        put_chunk(&body, "id3 ", "TAG", 3);
+    }
+
+    put(&out->file, "RIFF", 4);
+    put32(&out->file, (uint32_t)body.len);
+    put(&out->file, body.data, body.len);
+    free(fmt.data);
+    free(body.data);
+    free(data.data);
+}
+
+// ---------------------------------------------------------------------------
+// 解码
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    audio_decoder_info_t info;
+    int format_calls;
+    int bad_format;         // 格式不合法或 PCM 长度不按帧对齐
+    uint8_t *pcm;
+    size_t bytes;
+    size_t cap;
+    bool collect;
+} sink_ctx_t;
+
+static esp_err_t on_format(const audio_decoder_info_t *info, void *arg)
+{
+    sink_ctx_t *ctx = arg;
+    if (info->sample_rate == 0 || (info->channels != 1 && info->channels != 2)) {
+        ctx->bad_format++;
+    }
+    ctx->info = *info;
+    ctx->format_calls++;
+    return ESP_OK;
+}
+
+static esp_err_t on_pcm(const int16_t *pcm, size_t bytes, void *arg)
+{
+    sink_ctx_t *ctx = arg;
+    if (ctx->format_calls == 0 || ctx->info.channels == 0 || bytes % (ctx->info.channels * sizeof(int16_t)) != 0) {
+        ctx->bad_format++;
+    }
+    if (ctx->collect) {
+        if (ctx->bytes + bytes > ctx->cap) {
+            ctx->cap = (ctx->bytes + bytes) * 2;
+            ctx->pcm = realloc(ctx->pcm, ctx->cap);
+        }
+        memcpy(ctx->pcm + ctx->bytes, pcm, bytes);
+    }
+    ctx->bytes += bytes;
+    return ESP_OK;
+}
+
+/**
+ * 解码整个文件：feed 为 0 时按随机长度分段，SIZE_MAX 时一次喂入
+ */
+static esp_err_t decode(const uint8_t *data, size_t len, size_t feed, sink_ctx_t *ctx, audio_decoder_stats_t *stats)
+{
+    audio_decoder_sink_t sink = { .on_format = on_format, .on_pcm = on_pcm, .arg = ctx };
+    esp_err_t ret = audio_decoder_open(audio_decoder_detect(NULL, data, len), &sink);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    size_t pos = 0;
+    while (pos < len && ret == ESP_OK) {
+        size_t n = (feed == 0) ? rnd_split() : feed;
+        if (n > len - pos) {
+            n = len - pos;
+        }
+        ret = audio_decoder_feed(data + pos, n);
+        pos += n;
+    }
+    if (stats != NULL) {
+        audio_decoder_get_stats(stats);
+    }
+    audio_decoder_close();
+    return ret;
+}
+
+// ---------------------------------------------------------------------------
+// 1. 一致性
+// ---------------------------------------------------------------------------
+
+static int check_vectors(wav_vector_t *vec, int rounds)
+{
+    int failures = 0;
+    for (size_t v = 0; v < SPEC_COUNT; v++) {
+        const wav_spec_t *s = &s_specs[v];
+        if (vec[v].expect == NULL) {
+            continue;
+        }
+        int bad = 0;
+        for (int r = 0; r < rounds && !bad; r++) {
+            sink_ctx_t ctx = { .collect = true };
+            esp_err_t ret = decode(vec[v].file.data, vec[v].file.len, r == 0 ? SIZE_MAX : 0, &ctx, NULL);
+            const char *why = NULL;
+            size_t diff = 0;
+            if (ret != ESP_OK) {
+                why = "error";
+            } else if (ctx.format_calls != 1 || ctx.bad_format || ctx.info.sample_rate != s->rate ||
+                       ctx.info.channels != s->channels) {
+                why = "format";
+            } else if (ctx.bytes != vec[v].expect_bytes) {
+                why = "length";
+            } else {
+                const int16_t *a = (const int16_t *)ctx.pcm;
+                for (size_t k = 0; k < ctx.bytes / 2; k++) {
+                    diff += a[k] != vec[v].expect[k];
+                }
+                why = diff ? "samples" : NULL;
+            }
+            if (why != NULL) {
+                printf("%-28s round %-3d FAIL: %s (ret 0x%x, %zu/%zu bytes, %zu samples differ)\n",
+                       s->name, r, why, ret, ctx.bytes, vec[v].expect_bytes, diff);
+                bad = 1;
+            }
+            free(ctx.pcm);
+        }
+        if (!bad) {
+            printf("%-28s %6u Hz %u ch %2d bit %7zu frames  ok (%d random splits)\n",
+                   s->name, (unsigned)s->rate, s->channels, s->container, vec[v].frames, rounds - 1);
+        }
+        failures += bad;
+    }
+    return failures;
+}
+
+// ---------------------------------------------------------------------------
+// 2. 模糊
+// ---------------------------------------------------------------------------
+
+static const uint32_t s_special32[] = { 0, 1, 2, 3, 4, 0x7F, 0xFF, 0xFFFF, 0x10000, 0x7FFFFFFF, 0x80000000, 0xFFFFFFFF };
+
+static void mutate(buf_t *b)
+{
+    int ops = (int)rnd_range(1, 4);
+    for (int i = 0; i < ops && b->len > 0; i++) {
+        // 变异集中在文件头 (RIFF + fmt + 块头)
+        size_t span = b->len < 96 ? b->len : 96;
+        size_t pos = rnd() % span;
+        switch (rnd() % 6) {
+            case 0:     // 翻转一位
+                b->data[pos] ^= (uint8_t)(1u << (rnd() & 7));
+                break;
+            case 1:     // 随机字节
+                b->data[pos] = (uint8_t)rnd();
+                break;
+            case 2:     // 16 位字段置特殊值
+                pos &= ~(size_t)1;
+                if (pos + 2 <= b->len) {
+                    uint16_t v = (uint16_t)s_special32[rnd() % 12];
+                    memcpy(b->data + pos, &v, 2);
+                }
+                break;
+            case 3:     // 32 位字段置特殊值
+                pos &= ~(size_t)1;
+                if (pos + 4 <= b->len) {
+                    uint32_t v = s_special32[rnd() % 12];
+                    memcpy(b->data + pos, &v, 4);
+                }
+                break;
+            case 4:     // 截断
+                b->len = rnd() % (b->len + 1);
+                break;
+            default: {  // 在第一个块之前插入随机未知块 (可能带奇数长度或错误的长度字段)
+                uint8_t junk[40];
+                uint32_t n = rnd() % sizeof(junk);
+                for (uint32_t k = 0; k < n; k++) {
+                    junk[k] = (uint8_t)rnd();
+                }
+                buf_t nb = { 0 };
+                put(&nb, b->data, b->len < 12 ? b->len : 12);
+                if (b->len >= 12) {
+                    put(&nb, (rnd() & 3) ? "LIST" : "fmt ", 4);
+                    put32(&nb, (rnd() & 3) ? n : rnd());
+                    put(&nb, junk, n);
+                    put(&nb, b->data + 12, b->len - 12);
+                }
+                free(b->data);
+                *b = nb;
+                break;
+            }
+        }
+    }
+}
+
+static uint64_t fnv1a(const uint8_t *p, size_t n)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < n; i++) {
+        h = (h ^ p[i]) * 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static int fuzz(wav_vector_t *vec, long cases)
+{
+    long accepted = 0;
+    long rejected = 0;
+    long with_pcm = 0;
+    int failures = 0;
+
+    for (long c = 0; c < cases && failures < 10; c++) {
+        const wav_vector_t *base = &vec[rnd() % SPEC_COUNT];
+        buf_t b = { 0 };
+        put(&b, base->file.data, base->file.len);
+        mutate(&b);
+        uint64_t seed = rng_state;
+
+        sink_ctx_t whole = { .collect = true };
+        esp_err_t ret_whole = decode(b.data, b.len, SIZE_MAX, &whole, NULL);
+        sink_ctx_t split = { .collect = true };
+        esp_err_t ret_split = decode(b.data, b.len, 0, &split, NULL);
+
+        const char *why = NULL;
+        if ((ret_whole != ESP_OK && ret_whole != ESP_ERR_NOT_SUPPORTED) ||
+            (ret_split != ESP_OK && ret_split != ESP_ERR_NOT_SUPPORTED)) {
+            why = "unexpected error code";
+        } else if (whole.bad_format || split.bad_format) {
+            why = "invalid format or unaligned PCM";
+        } else if (whole.bytes > b.len * 4) {
+            why = "more PCM than 4x input";
+        } else if (ret_whole != ret_split || whole.format_calls != split.format_calls ||
+                   whole.bytes != split.bytes || fnv1a(whole.pcm, whole.bytes) != fnv1a(split.pcm, split.bytes)) {
+            why = "result depends on feed boundaries";
+        }
+        if (why != NULL) {
+            char path[64];
+            snprintf(path, sizeof(path), "wav_fuzz_fail_%ld.wav", c);
+            FILE *f = fopen(path, "wb");
+            if (f != NULL) {
+                fwrite(b.data, 1, b.len, f);
+                fclose(f);
+            }
+            printf("case %ld FAIL: %s (ret 0x%x/0x%x, %zu/%zu bytes, rng %016llx) -> %s\n", c, why,
+                   ret_whole, ret_split, whole.bytes, split.bytes, (unsigned long long)seed, path);
+            failures++;
+        }
+        if (ret_whole == ESP_OK) {
+            accepted++;
+        } else {
+            rejected++;
+        }
+        with_pcm += whole.bytes > 0;
+        free(whole.pcm);
+        free(split.pcm);
+        free(b.data);
+    }
+    printf("%ld mutated files: %ld decoded to the end, %ld rejected, %ld produced PCM, %d failures\n",
+           cases, accepted, rejected, with_pcm, failures);
+    return failures;
+}
+
+// ---------------------------------------------------------------------------
+// 3. 吞吐量
+// ---------------------------------------------------------------------------
+
+static void bench(wav_vector_t *vec)
+{
+    // 解码统计按每次 decode 调用累计微秒，单次调用常不足 1 微秒，这里改用整次解码的墙钟时间
+    printf("%d runs per file, %d-byte feeds, best run\n", BENCH_REPEAT, BENCH_FEED);
+    printf("%-28s %10s %10s %11s\n", "vector", "us/s", "MB/s", "realtime");
+    for (size_t v = 0; v < SPEC_COUNT; v++) {
+        int64_t best = INT64_MAX;
+        audio_decoder_stats_t stats = { 0 };
+        for (int r = 0; r < BENCH_REPEAT; r++) {
+            sink_ctx_t ctx = { .collect = false };
+            int64_t t0 = esp_timer_get_time();
+            decode(vec[v].file.data, vec[v].file.len, BENCH_FEED, &ctx, &stats);
+            int64_t us = esp_timer_get_time() - t0;
+            if (us < best) {
+                best = us;
+            }
+        }
+        double seconds = (double)stats.frames_out / s_specs[v].rate;
+        double us_per_s = seconds > 0 ? best / seconds : 0.0;
+        printf("%-28s %10.1f %10.0f %10.0fx\n", s_specs[v].name, us_per_s,
+               best > 0 ? (double)vec[v].file.len / best : 0.0, us_per_s > 0 ? 1e6 / us_per_s : 0.0);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    long cases = argc > 1 ? atol(argv[1]) : DEFAULT_CASES;
+    rng_state = argc > 2 ? strtoull(argv[2], NULL, 0) * 0x9E3779B97F4A7C15ULL + 1 : 1;
+
+    if (audio_decoder_init() != ESP_OK) {
+        return 2;
+    }
+
+    // 一致性用 1 秒文件，模糊用 2000 帧的小文件 (变异集中在文件头)
+    wav_vector_t full[SPEC_COUNT];
+    wav_vector_t small[SPEC_COUNT];
+    for (size_t v = 0; v < SPEC_COUNT; v++) {
+        make_vector(&s_specs[v], s_specs[v].rate, &full[v]);
+        make_vector(&s_specs[v], 2000, &small[v]);
+    }
+
+    int failures = check_vectors(full, 50);
+    printf("\n");
+    failures += fuzz(small, cases);
+    printf("\n");
+    bench(full);
+
+    for (size_t v = 0; v < SPEC_COUNT; v++) {
+        free(full[v].file.data);
+        free(full[v].expect);
+        free(small[v].file.data);
+        free(small[v].expect);
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,218 @@
+/*
+ * 音量/声道转换内核主机基准 (Linux / macOS)
+ *
+ * 比较单声道转立体声 + 音量的两种实现，输出每秒处理的单声道采样数 (M 采样/秒):
+ * - old: 改动前 audio_player_play() 的做法，每次调用 malloc 立体声缓冲区、浮点乘音量、free
+ * - q15: main/audio_dsp.c 的 Q15 定点实现，写入预先分配的 16 字节对齐暂存缓冲区
+ * 另外测量 audio_dsp_scale_q15() (混音器音源增益) 和 audio_dsp_s32_to_s16() (32 位 WAV)
+ * 与对应浮点/逐个移位写法的吞吐量。
+ *
+ * 主机上 tools/host/sdkconfig.h 不定义 CONFIG_IDF_TARGET_ESP32S3，测到的是标量实现；
+ * audio_dsp_s3.S 的 PIE SIMD 内核只能在 ESP32-S3 上运行，设备上的结果需要在目标板上测量。
+ * 基准同时校验 Q15 输出逐位等于 sat16((x * g) >> 15)，且满幅输入在所有音量下都不会回绕。
+ *
+ * 编译和运行:
+ *     cc -O2 -Imain -Itools/host -o dsp_bench tools/audio_dsp_bench.c main/audio_dsp.c
+ *     ./dsp_bench              # 每次调用 1024 个采样 (与一个 DMA 块相当)，共 2000 万个采样
+ *     ./dsp_bench 256 5000000  # 指定每次调用的采样数和总采样数
+ */
+
+#include "include/audio_dsp.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_BLOCK       1024
+#define DEFAULT_TOTAL       20000000
+#define BENCH_VOLUME        70
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static volatile int16_t sink;
+
+// 改动前的 audio_player_play()：每次调用分配立体声缓冲区，浮点乘音量 (不含 I2S 写入)
+static int old_mono_to_stereo(const int16_t *data, size_t sample_count, uint8_t volume)
+{
+    int16_t *stereo_data = (int16_t *)malloc(sample_count * 2 * sizeof(int16_t));
+    if (stereo_data == NULL) {
+        return -1;
+    }
+
+    float volume_factor = volume / 100.0f;
+    for (size_t i = 0; i < sample_count; i++) {
+        int16_t sample = (int16_t)(data[i] * volume_factor);
+        stereo_data[i * 2] = sample;
+        stereo_data[i * 2 + 1] = sample;
+    }
+
+    sink = stereo_data[sample_count - 1];
+    free(stereo_data);
+    return 0;
+}
+
+static void old_scale(int16_t *dst, const int16_t *src, size_t samples, uint8_t volume)
+{
+    float volume_factor = volume / 100.0f;
+    for (size_t i = 0; i < samples; i++) {
+        dst[i] = (int16_t)(src[i] * volume_factor);
+    }
+}
+
+static void old_s32_to_s16(int16_t *dst, const int32_t *src, size_t samples)
+{
+    for (size_t i = 0; i < samples; i++) {
+        dst[i] = (int16_t)(src[i] >> 16);
+    }
+}
+
+static void *aligned_buf(size_t bytes)
+{
+    void *p = NULL;
+    if (posix_memalign(&p, AUDIO_DSP_ALIGN, bytes) != 0) {
+        return NULL;
+    }
+    return p;
+}
+
+static void print_row(const char *name, const char *impl, double ns, size_t total)
+{
+    printf("%-16s %-6s %10.1f %10.2f\n", name, impl, total * 1e3 / ns, ns / total);
+}
+
+// Q15 输出与参考公式逐位一致；满幅输入 (含 -32768) 在 0-100 音量下不回绕
+static int verify(void)
+{
+    static const int16_t edge[] = { INT16_MIN, INT16_MIN + 1, -1, 0, 1, INT16_MAX - 1, INT16_MAX };
+    int16_t stereo[2 * 7];
+    int16_t mono[7];
+    int errors = 0;
+
+    for (int vol = 0; vol <= 100; vol++) {
+        int16_t g = audio_dsp_volume_to_q15((uint8_t)vol);
+        audio_dsp_mono_to_stereo_q15(stereo, edge, 7, g);
+        audio_dsp_scale_q15(mono, edge, 7, g);
+        for (int i = 0; i < 7; i++) {
+            int32_t ref = ((int32_t)edge[i] * g) >> 15;
+            if (stereo[2 * i] != ref || stereo[2 * i + 1] != ref || mono[i] != ref) {
+                errors++;
+            }
+            // 增益不超过 1.0，输出的符号和幅度不能超过输入
+            if ((edge[i] >= 0 && mono[i] < 0) || (edge[i] < 0 && mono[i] > 0)) {
+                errors++;
+            }
+        }
+    }
+
+    // 旧的浮点写法与 Q15 的差别 (截断方向和增益量化)，只输出不作为错误
+    int max_diff = 0;
+    for (int32_t x = INT16_MIN; x <= INT16_MAX; x++) {
+        int16_t in = (int16_t)x;
+        int16_t a;
+        int16_t b;
+        old_scale(&a, &in, 1, BENCH_VOLUME);
+        audio_dsp_scale_q15(&b, &in, 1, audio_dsp_volume_to_q15(BENCH_VOLUME));
+        int d = abs(a - b);
+        if (d > max_diff) {
+            max_diff = d;
+        }
+    }
+
+    printf("verify: %s, old vs q15 max diff %d LSB at volume %d\n",
+           errors == 0 ? "ok" : "FAILED", max_diff, BENCH_VOLUME);
+    return errors;
+}
+
+int main(int argc, char **argv)
+{
+    size_t block = argc > 1 ? (size_t)atol(argv[1]) : DEFAULT_BLOCK;
+    if (block == 0 || block > 65536) {
+        block = DEFAULT_BLOCK;
+    }
+    size_t total = argc > 2 ? (size_t)atol(argv[2]) : DEFAULT_TOTAL;
+    if (total < block) {
+        total = DEFAULT_TOTAL;
+    }
+    size_t calls = total / block;
+    total = calls * block;
+
+    int16_t *mono = aligned_buf(block * sizeof(int16_t));
+    int16_t *out = aligned_buf(block * sizeof(int16_t));
+    int16_t *stereo = aligned_buf(block * 2 * sizeof(int16_t));
+    int32_t *pcm32 = aligned_buf(block * sizeof(int32_t));
+    if (mono == NULL || out == NULL || stereo == NULL || pcm32 == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    // 固定种子的伪随机满幅信号
+    uint32_t x = 2463534242u;
+    for (size_t i = 0; i < block; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        mono[i] = (int16_t)x;
+        pcm32[i] = (int32_t)x;
+    }
+
+    int errors = verify();
+    int16_t gain = audio_dsp_volume_to_q15(BENCH_VOLUME);
+
+    printf("%zu samples per call, %zu samples, volume %d%s\n", block, total, BENCH_VOLUME,
+           AUDIO_DSP_USE_SIMD ? "" : " (scalar kernels, PIE runs on ESP32-S3 only)");
+    printf("%-16s %-6s %10s %10s\n", "kernel", "impl", "Msample/s", "ns/sample");
+
+    double t0 = now_ns();
+    for (size_t c = 0; c < calls; c++) {
+        if (old_mono_to_stereo(mono, block, BENCH_VOLUME) != 0) {
+            return 1;
+        }
+    }
+    print_row("mono_to_stereo", "old", now_ns() - t0, total);
+
+    t0 = now_ns();
+    for (size_t c = 0; c < calls; c++) {
+        audio_dsp_mono_to_stereo_q15(stereo, mono, block, gain);
+        sink = stereo[c % (block * 2)];
+    }
+    print_row("mono_to_stereo", "q15", now_ns() - t0, total);
+
+    t0 = now_ns();
+    for (size_t c = 0; c < calls; c++) {
+        old_scale(out, mono, block, BENCH_VOLUME);
+        sink = out[c % block];
+    }
+    print_row("scale", "old", now_ns() - t0, total);
+
+    t0 = now_ns();
+    for (size_t c = 0; c < calls; c++) {
+        audio_dsp_scale_q15(out, mono, block, gain);
+        sink = out[c % block];
+    }
+    print_row("scale", "q15", now_ns() - t0, total);
+
+    t0 = now_ns();
+    for (size_t c = 0; c < calls; c++) {
+        old_s32_to_s16(out, pcm32, block);
+        sink = out[c % block];
+    }
+    print_row("s32_to_s16", "old", now_ns() - t0, total);
+
+    t0 = now_ns();
+    for (size_t c = 0; c < calls; c++) {
+        audio_dsp_s32_to_s16(out, pcm32, block);
+        sink = out[c % block];
+    }
+    print_row("s32_to_s16", "q15", now_ns() - t0, total);
+
+    free(mono);
+    free(out);
+    free(stereo);
+    free(pcm32);
+    return errors == 0 ? 0 : 1;
+}
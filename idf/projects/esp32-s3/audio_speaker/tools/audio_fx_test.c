@@ -0,0 +1,485 @@
+/*
+ * 输出效果链主机测试 (Linux / macOS)
+ *
+ * 直接编译 main/audio_fx.c，按混音器的块大小 (AUDIO_MIXER_BLOCK_FRAMES 帧) 调用 audio_fx_process()，输出:
+ * - 频率响应：各类滤波器在 20Hz ~ 0.45 × 采样率的 1/3 倍频程点上测得的增益，与 RBJ 公式
+ *   (双精度) 的理论响应比较，给出最大偏差 (只统计理论增益高于 -60 dB 的点)
+ * - 精度：高通 + 参数均衡级联，-20 dBFS 多音信号与双精度参考滤波器的信噪比，
+ *   与输出取整到 int16 本身的上限相差不超过 1 dB
+ * - 余量：6 级最坏情况级联 (+12 dB 架式/均衡、Q=10 谐振) 输入满幅方波、满幅 8 倍和 ±INT32_MAX，
+ *   输出不超过限幅 (满幅 8 倍)；+12 dB 提升的满幅正弦不触发限幅，与参考一致。
+ *   配合 -fsanitize=undefined 检查 64 位累加和 Q4.27 转换没有有符号溢出
+ * - 压缩器：0 dBFS 突发正弦经 -6 dBFS 限幅器 (前瞻 3ms) 后的峰值，4:1 压缩的稳态电平
+ * - 开销：默认配置、6 级滤波、6 级滤波 + 压缩器每帧 (立体声) 的纳秒数、x86 上的 TSC 周期数
+ *   和每秒音频的微秒数。主机上是标量 C 的开销，设备上的 fx_us_per_s 见 /api/status
+ *
+ * 编译和运行:
+ *     cc -O2 -Imain -Itools/host -o fx_test tools/audio_fx_test.c main/audio_fx.c -lm
+ *     ./fx_test                    # 44100 Hz
+ *     ./fx_test 48000
+ *     cc -O1 -g -fsanitize=undefined -fno-sanitize-recover -Imain -Itools/host -o fx_test_ubsan \
+ *        tools/audio_fx_test.c main/audio_fx.c -lm && ./fx_test_ubsan
+ */
+
+#include "include/audio_fx.h"
+#include "include/audio_mixer.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define BLOCK           AUDIO_MIXER_BLOCK_FRAMES
+#define DEFAULT_RATE    44100
+
+static uint32_t rate = DEFAULT_RATE;
+static int32_t blk[BLOCK * 2];
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * 应用配置并清空状态 (配置在下一次 audio_fx_process() 时生效)
+ */
+static int apply(const audio_fx_config_t *c)
+{
+    if (audio_fx_set_config(c) != ESP_OK) {
+        return -1;
+    }
+    memset(blk, 0, sizeof(blk));
+    audio_fx_process(blk, BLOCK);
+    audio_fx_reset();
+    return 0;
+}
+
+static audio_fx_config_t filters_only(void)
+{
+    audio_fx_config_t c = AUDIO_FX_DEFAULT_CONFIG();
+    memset(c.filters, 0, sizeof(c.filters));
+    c.drc.enabled = false;
+    return c;
+}
+
+// ---------------------------------------------------------------------------
+// 双精度参考 (RBJ 公式)
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    double b0, b1, b2, a1, a2;
+    double x1[2], x2[2], y1[2], y2[2];
+} ref_biquad_t;
+
+static void ref_design(const audio_fx_filter_t *f, ref_biquad_t *r)
+{
+    const double w0 = 2.0 * M_PI * f->freq_hz / rate;
+    const double cw = cos(w0);
+    const double alpha = sin(w0) / (2.0 * f->q);
+    const double A = pow(10.0, f->gain_db / 40.0);
+    const double sa = 2.0 * sqrt(A) * alpha;
+    double b0 = 1, b1 = 0, b2 = 0, a0 = 1, a1 = 0, a2 = 0;
+
+    switch (f->type) {
+    case AUDIO_FX_FILTER_PEAK:
+        b0 = 1 + alpha * A; b1 = -2 * cw; b2 = 1 - alpha * A;
+        a0 = 1 + alpha / A; a1 = -2 * cw; a2 = 1 - alpha / A;
+        break;
+    case AUDIO_FX_FILTER_LOW_SHELF:
+        b0 = A * ((A + 1) - (A - 1) * cw + sa); b1 = 2 * A * ((A - 1) - (A + 1) * cw);
+        b2 = A * ((A + 1) - (A - 1) * cw - sa);
+        a0 = (A + 1) + (A - 1) * cw + sa; a1 = -2 * ((A - 1) + (A + 1) * cw); a2 = (A + 1) + (A - 1) * cw - sa;
+        break;
+    case AUDIO_FX_FILTER_HIGH_SHELF:
+        b0 = A * ((A + 1) + (A - 1) * cw + sa); b1 = -2 * A * ((A - 1) + (A + 1) * cw);
+        b2 = A * ((A + 1) + (A - 1) * cw - sa);
+        a0 = (A + 1) - (A - 1) * cw + sa; a1 = 2 * ((A - 1) - (A + 1) * cw); a2 = (A + 1) - (A - 1) * cw - sa;
+        break;
+    case AUDIO_FX_FILTER_HIGHPASS:
+        b0 = (1 + cw) / 2; b1 = -(1 + cw); b2 = (1 + cw) / 2;
+        a0 = 1 + alpha; a1 = -2 * cw; a2 = 1 - alpha;
+        break;
+    case AUDIO_FX_FILTER_LOWPASS:
+        b0 = (1 - cw) / 2; b1 = 1 - cw; b2 = (1 - cw) / 2;
+        a0 = 1 + alpha; a1 = -2 * cw; a2 = 1 - alpha;
+        break;
+    default:
+        break;
+    }
+    memset(r, 0, sizeof(*r));
+    r->b0 = b0 / a0;
+    r->b1 = b1 / a0;
+    r->b2 = b2 / a0;
+    r->a1 = a1 / a0;
+    r->a2 = a2 / a0;
+}
+
+static double ref_mag_db(const ref_biquad_t *r, double freq)
+{
+    const double w = 2.0 * M_PI * freq / rate;
+    // H(z) 在 z = e^jw 处的幅度
+    double nr = r->b0 + r->b1 * cos(w) + r->b2 * cos(2 * w);
+    double ni = -r->b1 * sin(w) - r->b2 * sin(2 * w);
+    double dr = 1.0 + r->a1 * cos(w) + r->a2 * cos(2 * w);
+    double di = -r->a1 * sin(w) - r->a2 * sin(2 * w);
+    return 10.0 * log10((nr * nr + ni * ni) / (dr * dr + di * di));
+}
+
+static double ref_step(ref_biquad_t *r, int ch, double x)
+{
+    double y = r->b0 * x + r->b1 * r->x1[ch] + r->b2 * r->x2[ch] - r->a1 * r->y1[ch] - r->a2 * r->y2[ch];
+    r->x2[ch] = r->x1[ch];
+    r->x1[ch] = x;
+    r->y2[ch] = r->y1[ch];
+    r->y1[ch] = y;
+    return y;
+}
+
+// ---------------------------------------------------------------------------
+// 频率响应
+// ---------------------------------------------------------------------------
+
+/**
+ * 测量单个频率的增益 (dB)：跳过建立时间后按整数个周期求 RMS
+ */
+static double measure_gain_db(double freq, double amp)
+{
+    const size_t settle = rate / 2;
+    const size_t periods = (size_t)ceil(freq * 0.25);
+    const size_t measure = (size_t)llround(periods * rate / freq);
+    double sum_in = 0.0;
+    double sum_out = 0.0;
+    size_t n = 0;
+
+    audio_fx_reset();
+    for (size_t done = 0; done < settle + measure; done += BLOCK) {
+        double in[BLOCK];
+        for (int i = 0; i < BLOCK; i++) {
+            in[i] = amp * sin(2.0 * M_PI * freq * (double)(done + i) / rate);
+            blk[i * 2] = blk[i * 2 + 1] = (int32_t)lrint(in[i]);
+        }
+        audio_fx_process(blk, BLOCK);
+        for (int i = 0; i < BLOCK; i++) {
+            size_t k = done + i;
+            if (k >= settle && k < settle + measure) {
+                sum_in += in[i] * in[i];
+                sum_out += (double)blk[i * 2] * blk[i * 2];
+                n++;
+            }
+        }
+    }
+    return (n > 0 && sum_out > 0) ? 10.0 * log10(sum_out / sum_in) : -200.0;
+}
+
+static int test_response(void)
+{
+    static const audio_fx_filter_t cases[] = {
+        { AUDIO_FX_FILTER_HIGHPASS,   120.0f,  0.0f,  0.707f },
+        { AUDIO_FX_FILTER_HIGHPASS,   80.0f,   0.0f,  4.0f },
+        { AUDIO_FX_FILTER_LOWPASS,    5000.0f, 0.0f,  0.707f },
+        { AUDIO_FX_FILTER_PEAK,       1000.0f, 6.0f,  1.0f },
+        { AUDIO_FX_FILTER_PEAK,       60.0f,   -24.0f, 10.0f },
+        { AUDIO_FX_FILTER_LOW_SHELF,  100.0f,  12.0f, 0.707f },
+        { AUDIO_FX_FILTER_HIGH_SHELF, 8000.0f, -6.0f, 0.707f },
+    };
+    static const char *names[] = { "", "peak", "lowshelf", "highshelf", "highpass", "lowpass" };
+    const double amp = 32768.0 * 0.125;         // -18 dBFS：+12 dB 提升也不会到满幅
+    int failures = 0;
+
+    printf("frequency response at %lu Hz, 1/3-octave points, -18 dBFS sine, error vs double-precision RBJ\n",
+           (unsigned long)rate);
+    printf("%-10s %8s %7s %6s %12s %14s\n", "type", "freq_hz", "gain_db", "q", "max_err_db", "at_hz");
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        if (cases[c].freq_hz > 0.45f * rate) {
+            printf("%-10s %8.0f  above 0.45 x rate, skipped\n", names[cases[c].type], cases[c].freq_hz);
+            continue;
+        }
+        audio_fx_config_t cfg = filters_only();
+        cfg.filters[0] = cases[c];
+        if (apply(&cfg) != 0) {
+            printf("%-10s config rejected  FAIL\n", names[cases[c].type]);
+            failures++;
+            continue;
+        }
+        ref_biquad_t ref;
+        ref_design(&cases[c], &ref);
+
+        double max_err = 0.0;
+        double at = 0.0;
+        for (double f = 20.0; f <= 0.45 * rate; f *= pow(2.0, 1.0 / 3.0)) {
+            double expect = ref_mag_db(&ref, f);
+            if (expect < -60.0) {
+                continue;
+            }
+            double err = fabs(measure_gain_db(f, amp) - expect);
+            // 衰减较深处允许量化噪声 (输出电平低于 -78 dBFS)
+            if (expect < -40.0) {
+                err = (err > 1.0) ? err - 1.0 : 0.0;
+            }
+            if (err > max_err) {
+                max_err = err;
+                at = f;
+            }
+        }
+        bool ok = max_err < 0.02;
+        printf("%-10s %8.0f %7.1f %6.2f %12.4f %14.0f  %s\n", names[cases[c].type], cases[c].freq_hz,
+               cases[c].gain_db, cases[c].q, max_err, at, ok ? "ok" : "FAIL");
+        failures += !ok;
+    }
+    return failures;
+}
+
+// ---------------------------------------------------------------------------
+// 精度
+// ---------------------------------------------------------------------------
+
+static int test_precision(void)
+{
+    audio_fx_config_t cfg = filters_only();
+    cfg.filters[0] = (audio_fx_filter_t){ AUDIO_FX_FILTER_HIGHPASS, 40.0f, 0.0f, 0.707f };
+    cfg.filters[1] = (audio_fx_filter_t){ AUDIO_FX_FILTER_PEAK, 3000.0f, 4.0f, 2.0f };
+    apply(&cfg);
+    ref_biquad_t ref[2];
+    ref_design(&cfg.filters[0], &ref[0]);
+    ref_design(&cfg.filters[1], &ref[1]);
+
+    // 几个不相关的正弦叠加，-20 dBFS 峰值
+    static const double freqs[] = { 55.0, 261.6, 1234.5, 4567.0, 9876.0 };
+    const double amp = 32768.0 * 0.1 / 5;
+    const size_t total = rate * 5;
+    const size_t skip = rate;
+    double sig = 0.0;
+    double err = 0.0;
+    for (size_t done = 0; done < total; done += BLOCK) {
+        double expect[BLOCK];
+        for (int i = 0; i < BLOCK; i++) {
+            double x = 0.0;
+            for (size_t k = 0; k < sizeof(freqs) / sizeof(freqs[0]); k++) {
+                x += amp * sin(2.0 * M_PI * freqs[k] * (double)(done + i) / rate + k);
+            }
+            int32_t xi = (int32_t)lrint(x);
+            blk[i * 2] = blk[i * 2 + 1] = xi;
+            expect[i] = ref_step(&ref[1], 0, ref_step(&ref[0], 0, xi));
+        }
+        audio_fx_process(blk, BLOCK);
+        for (int i = 0; i < BLOCK; i++) {
+            if (done + i >= skip) {
+                double e = blk[i * 2] - expect[i];
+                sig += expect[i] * expect[i];
+                err += e * e;
+            }
+        }
+    }
+    double snr = 10.0 * log10(sig / err);
+    // 输出取整到 int16 刻度本身的上限: 噪声功率 1/12 LSB^2
+    double limit = 10.0 * log10(sig / ((total - skip) / 12.0));
+    bool ok = snr > limit - 1.0;
+    printf("\nprecision: highpass 40 Hz + peak 3 kHz +4 dB, -20 dBFS multitone: SNR %.1f dB vs double reference "
+           "(int16 rounding alone %.1f dB)  %s\n", snr, limit, ok ? "ok" : "FAIL");
+    return ok ? 0 : 1;
+}
+
+// ---------------------------------------------------------------------------
+// 余量 (最坏情况级联)
+// ---------------------------------------------------------------------------
+
+static int test_headroom(void)
+{
+    audio_fx_config_t cfg = filters_only();
+    cfg.filters[0] = (audio_fx_filter_t){ AUDIO_FX_FILTER_LOW_SHELF, 100.0f, 12.0f, 0.3f };
+    cfg.filters[1] = (audio_fx_filter_t){ AUDIO_FX_FILTER_PEAK, 60.0f, 12.0f, 10.0f };
+    cfg.filters[2] = (audio_fx_filter_t){ AUDIO_FX_FILTER_LOWPASS, 80.0f, 0.0f, 10.0f };
+    cfg.filters[3] = (audio_fx_filter_t){ AUDIO_FX_FILTER_HIGH_SHELF, 20.0f, 12.0f, 0.3f };
+    cfg.filters[4] = (audio_fx_filter_t){ AUDIO_FX_FILTER_PEAK, 70.0f, 12.0f, 10.0f };
+    cfg.filters[5] = (audio_fx_filter_t){ AUDIO_FX_FILTER_HIGHPASS, 20.0f, 0.0f, 10.0f };
+    cfg.drc.enabled = true;
+    cfg.drc.threshold_db = 0.0f;
+    cfg.drc.ratio = 1.0f;
+    cfg.drc.makeup_db = 12.0f;
+    int failures = 0;
+    if (apply(&cfg) != 0) {
+        printf("\nheadroom: worst-case config rejected  FAIL\n");
+        return 1;
+    }
+
+    // 输入: 满幅方波 (60Hz)、满幅 8 倍方波、±INT32_MAX 交替、随机 int32
+    static const char *inputs[] = { "square 0 dBFS", "square +18 dB", "+-INT32_MAX", "random int32" };
+    uint32_t seed = 12345;
+    printf("\nheadroom: 6-stage worst case (+12 dB shelves/peaks, Q=10 resonance, +12 dB makeup)\n");
+    for (int k = 0; k < 4; k++) {
+        audio_fx_reset();
+        int32_t peak = 0;
+        for (size_t done = 0; done < rate * 2; done += BLOCK) {
+            for (int i = 0; i < BLOCK * 2; i++) {
+                int half = ((done + i / 2) / (rate / 120)) & 1;
+                switch (k) {
+                case 0: blk[i] = half ? 32767 : -32768; break;
+                case 1: blk[i] = half ? 32767 * 8 : -32768 * 8; break;
+                case 2: blk[i] = half ? INT32_MAX : -INT32_MAX; break;
+                default:
+                    seed = seed * 1664525u + 1013904223u;
+                    blk[i] = (int32_t)seed;
+                    break;
+                }
+            }
+            audio_fx_process(blk, BLOCK);
+            for (int i = 0; i < BLOCK * 2; i++) {
+                int32_t a = blk[i] < 0 ? -blk[i] : blk[i];
+                peak = a > peak ? a : peak;
+            }
+        }
+        // 限幅在 Q4.27 的 ±8.0，即 int16 刻度的 ±262144
+        bool ok = peak <= 32768 * 8;
+        printf("  %-16s output peak %7d (%+.1f dBFS)  %s\n", inputs[k], peak, 20.0 * log10(peak / 32768.0),
+               ok ? "ok" : "FAIL");
+        failures += !ok;
+    }
+
+    // +12 dB 均衡提升的满幅正弦 (+12 dBFS 输出) 不触发限幅
+    cfg = filters_only();
+    cfg.filters[0] = (audio_fx_filter_t){ AUDIO_FX_FILTER_PEAK, 1000.0f, 12.0f, 1.0f };
+    apply(&cfg);
+    double g = measure_gain_db(1000.0, 32767.0);
+    bool ok = fabs(g - 12.0) < 0.05;
+    printf("  0 dBFS 1 kHz through +12 dB peak: %+.3f dB (no clipping)  %s\n", g, ok ? "ok" : "FAIL");
+    failures += !ok;
+    return failures;
+}
+
+// ---------------------------------------------------------------------------
+// 压缩器
+// ---------------------------------------------------------------------------
+
+static double drc_run(const audio_fx_config_t *cfg, double amp_dbfs, size_t burst_at, double *steady_db)
+{
+    apply(cfg);
+    const double amp = 32767.0 * pow(10.0, amp_dbfs / 20.0);
+    const size_t total = rate * 2;
+    int32_t peak = 0;
+    double sum = 0.0;
+    size_t n = 0;
+    for (size_t done = 0; done < total; done += BLOCK) {
+        for (int i = 0; i < BLOCK; i++) {
+            size_t k = done + i;
+            double x = (k >= burst_at) ? amp * sin(2.0 * M_PI * 997.0 * k / rate) : 0.0;
+            blk[i * 2] = blk[i * 2 + 1] = (int32_t)lrint(x);
+        }
+        audio_fx_process(blk, BLOCK);
+        for (int i = 0; i < BLOCK; i++) {
+            int32_t a = blk[i * 2] < 0 ? -blk[i * 2] : blk[i * 2];
+            peak = a > peak ? a : peak;
+            if (done + i >= total - rate / 2) {
+                sum += (double)blk[i * 2] * blk[i * 2];
+                n++;
+            }
+        }
+    }
+    // 稳态峰值电平 (正弦 RMS + 3 dB)
+    *steady_db = 10.0 * log10(sum / n / (32767.0 * 32767.0)) + 3.01;
+    return 20.0 * log10(peak / 32767.0);
+}
+
+static int test_drc(void)
+{
+    int failures = 0;
+    audio_fx_config_t cfg = filters_only();
+    cfg.drc = (audio_fx_drc_t){ .enabled = true, .threshold_db = -6.0f, .ratio = AUDIO_FX_DRC_LIMIT_RATIO,
+                                .attack_ms = 0.1f, .release_ms = 200.0f, .lookahead_ms = 3.0f, .makeup_db = 0.0f };
+    double steady;
+    double peak = drc_run(&cfg, 0.0, rate / 4, &steady);
+    bool ok = peak < -6.0 + 0.5;
+    printf("\nlimiter -6 dBFS, lookahead 3 ms, 0 dBFS burst: peak %+.2f dBFS, steady %+.2f dBFS  %s\n",
+           peak, steady, ok ? "ok" : "FAIL");
+    failures += !ok;
+
+    cfg.drc.ratio = 4.0f;
+    cfg.drc.attack_ms = 2.0f;
+    drc_run(&cfg, 0.0, rate / 4, &steady);
+    // 超过阈值 6 dB，4:1 压缩后超过 1.5 dB
+    ok = fabs(steady - (-4.5)) < 0.5;
+    printf("compressor -6 dBFS 4:1, 0 dBFS sine: steady %+.2f dBFS (expect -4.50)  %s\n", steady, ok ? "ok" : "FAIL");
+    failures += !ok;
+    return failures;
+}
+
+// ---------------------------------------------------------------------------
+// 开销
+// ---------------------------------------------------------------------------
+
+static void bench(void)
+{
+    audio_fx_config_t configs[3];
+    static const char *names[] = { "default (hp + drc)", "6 biquads", "6 biquads + drc" };
+    configs[0] = (audio_fx_config_t)AUDIO_FX_DEFAULT_CONFIG();
+    configs[1] = filters_only();
+    for (int i = 0; i < AUDIO_FX_MAX_FILTERS; i++) {
+        configs[1].filters[i] = (audio_fx_filter_t){ AUDIO_FX_FILTER_PEAK, 100.0f * (i + 1), 3.0f, 1.0f };
+    }
+    configs[2] = configs[1];
+    configs[2].drc = configs[0].drc;
+
+    const int passes = 20;
+    const size_t frames = rate;             // 每段 1 秒音频
+    printf("\ncost per stereo frame, %d-frame blocks, fastest of %d passes of 1 s\n", BLOCK, passes);
+    printf("%-20s %10s %12s %10s\n", "config", "ns/frame", "tsc/frame", "us/s");
+    for (int c = 0; c < 3; c++) {
+        apply(&configs[c]);
+        double best_ns = 1e30;
+        double best_tsc = 1e30;
+        uint32_t seed = 1;
+        for (int p = 0; p < passes; p++) {
+            double t0 = now_ns();
+#ifdef HAVE_TSC
+            uint64_t c0 = __rdtsc();
+#endif
+            for (size_t done = 0; done < frames; done += BLOCK) {
+                for (int i = 0; i < BLOCK * 2; i++) {
+                    seed = seed * 1664525u + 1013904223u;
+                    blk[i] = (int32_t)(seed >> 17) - 16384;
+                }
+                audio_fx_process(blk, BLOCK);
+            }
+            double ns = now_ns() - t0;
+#ifdef HAVE_TSC
+            double tsc = (double)(__rdtsc() - c0);
+            best_tsc = tsc < best_tsc ? tsc : best_tsc;
+#endif
+            best_ns = ns < best_ns ? ns : best_ns;
+        }
+        // 计时包含生成输入的 LCG (每帧约 1ns)
+        printf("%-20s %10.2f %12.1f %10.1f\n", names[c], best_ns / frames,
+               best_tsc < 1e30 ? best_tsc / frames : 0.0, best_ns / 1000.0);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1) {
+        rate = (uint32_t)atoi(argv[1]);
+    }
+    if (rate < 8000) {
+        fprintf(stderr, "usage: %s [sample_rate]\n", argv[0]);
+        return 2;
+    }
+    if (audio_fx_init(rate) != ESP_OK) {
+        return 2;
+    }
+
+    int failures = test_response();
+    failures += test_precision();
+    failures += test_headroom();
+    failures += test_drc();
+    bench();
+    printf("\n%d failures\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,281 @@
+/*
+ * 采样率转换器主机测试 (Linux / macOS)
+ *
+ * 用设备上相同的 main/audio_resampler.c 把常见采样率 (含 48k 降采样) 转换到 44.1kHz，另测 44.1k -> 48k，
+ * 每个档位输出:
+ * - pass: 通带 (50Hz 到 0.8 × 较低奈奎斯特频率) 内各测试音的增益范围 (dB)
+ * - snr_1k / snr_min: 1kHz 测试音和通带内最差测试音的信噪比 (基波以外的镜像、混叠、相位量化和量化噪声，dB)
+ * - stop: 降采样时高于输出奈奎斯特频率的测试音被抑制的程度 (dB，升采样不适用)
+ * - us/s: 转换每秒立体声音频的主机 CPU 时间 (微秒，3 次取最小值)，以及对应的实时倍数
+ * 测试音为 -6 dBFS 正弦波，跳过开头 100ms 的滤波器暂态后用最小二乘拟合基波。
+ *
+ * 主机上点积使用标量实现；ESP32-S3 上 audio_dsp_dot_q15() 使用 PIE SIMD，
+ * 设备上的耗时见 audio_pipeline_stats_t.resample_us_per_s。
+ *
+ * 编译和运行:
+ *     cc -O2 -Imain -Itools/host -o resampler_test tools/audio_resampler_test.c \
+ *        main/audio_resampler.c main/audio_dsp.c -lm
+ *     ./resampler_test                     # 所有采样率和档位的汇总
+ *     ./resampler_test 16000 44100 1       # 输出一组转换的逐频点响应 (档位 0-2)
+ */
+
+#include "include/audio_resampler.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define TONE_AMPLITUDE      16384.0     // -6 dBFS
+#define TONE_SECONDS        1.0
+#define SKIP_SECONDS        0.1
+#define PASS_POINTS         16
+#define CPU_SECONDS         10
+#define CPU_RUNS            3
+
+static const char *const quality_names[] = { "low", "medium", "high" };
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * 以 256 帧为一块送入转换器 (与播放任务相同)，返回输出帧数
+ */
+static size_t run(audio_resampler_t *rs, const int16_t *in, size_t in_frames, int16_t *out, size_t out_cap)
+{
+    const uint8_t ch = rs->channels;
+    size_t pos = 0;
+    size_t produced = 0;
+    while (pos < in_frames && produced < out_cap) {
+        size_t n = in_frames - pos;
+        if (n > AUDIO_RESAMPLER_BLOCK_FRAMES) {
+            n = AUDIO_RESAMPLER_BLOCK_FRAMES;
+        }
+        size_t used = 0;
+        produced += audio_resampler_process(rs, in + pos * ch, n, &used,
+                                            out + produced * ch, out_cap - produced);
+        pos += used;
+    }
+    return produced;
+}
+
+/**
+ * 转换一个立体声测试音，返回基波增益 (dB) 和基波与残差之比 (dB)
+ */
+static void measure_tone(uint32_t in_rate, uint32_t out_rate, audio_resampler_quality_t q,
+                         double freq, double *gain_db, double *snr_db)
+{
+    size_t in_frames = (size_t)(TONE_SECONDS * in_rate);
+    int16_t *in = malloc(in_frames * 2 * sizeof(int16_t));
+    for (size_t i = 0; i < in_frames; i++) {
+        int16_t s = (int16_t)lrint(TONE_AMPLITUDE * sin(2 * M_PI * freq * i / in_rate));
+        in[i * 2] = s;
+        in[i * 2 + 1] = s;
+    }
+
+    audio_resampler_t rs;
+    audio_resampler_init(&rs, in_rate, out_rate, 2, q);
+    size_t out_cap = audio_resampler_max_output(&rs, in_frames);
+    int16_t *out = malloc(out_cap * 2 * sizeof(int16_t));
+    size_t n = run(&rs, in, in_frames, out, out_cap);
+    audio_resampler_deinit(&rs);
+
+    // 最小二乘拟合 a·sin + b·cos (左声道)，残差为基波以外的全部成分
+    size_t start = (size_t)(SKIP_SECONDS * out_rate);
+    double w = 2 * M_PI * freq / out_rate;
+    double ss = 0, cc = 0, sc = 0, ys = 0, yc = 0;
+    for (size_t i = start; i < n; i++) {
+        double s = sin(w * i);
+        double c = cos(w * i);
+        double y = out[i * 2];
+        ss += s * s;
+        cc += c * c;
+        sc += s * c;
+        ys += y * s;
+        yc += y * c;
+    }
+    double det = ss * cc - sc * sc;
+    double a = (ys * cc - yc * sc) / det;
+    double b = (yc * ss - ys * sc) / det;
+    double amp = sqrt(a * a + b * b);
+
+    double fund = 0;
+    double resid = 0;
+    for (size_t i = start; i < n; i++) {
+        double fit = a * sin(w * i) + b * cos(w * i);
+        double e = out[i * 2] - fit;
+        fund += fit * fit;
+        resid += e * e;
+    }
+
+    *gain_db = 20 * log10(amp / TONE_AMPLITUDE + 1e-12);
+    *snr_db = 10 * log10(fund / (resid + 1e-12));
+
+    free(in);
+    free(out);
+}
+
+/**
+ * 降采样时高于输出奈奎斯特频率的测试音：输出总能量与输入能量之比 (dB)
+ */
+static double measure_stopband(uint32_t in_rate, uint32_t out_rate, audio_resampler_quality_t q, double freq)
+{
+    size_t in_frames = (size_t)(TONE_SECONDS * in_rate);
+    int16_t *in = malloc(in_frames * 2 * sizeof(int16_t));
+    for (size_t i = 0; i < in_frames; i++) {
+        int16_t s = (int16_t)lrint(TONE_AMPLITUDE * sin(2 * M_PI * freq * i / in_rate));
+        in[i * 2] = s;
+        in[i * 2 + 1] = s;
+    }
+
+    audio_resampler_t rs;
+    audio_resampler_init(&rs, in_rate, out_rate, 2, q);
+    size_t out_cap = audio_resampler_max_output(&rs, in_frames);
+    int16_t *out = malloc(out_cap * 2 * sizeof(int16_t));
+    size_t n = run(&rs, in, in_frames, out, out_cap);
+    audio_resampler_deinit(&rs);
+
+    size_t start = (size_t)(SKIP_SECONDS * out_rate);
+    double e = 0;
+    for (size_t i = start; i < n; i++) {
+        e += (double)out[i * 2] * out[i * 2];
+    }
+    e /= (n - start);
+    double ref = TONE_AMPLITUDE * TONE_AMPLITUDE / 2;
+
+    free(in);
+    free(out);
+    return 10 * log10((e + 1e-3) / ref);
+}
+
+/**
+ * 转换 CPU_SECONDS 秒立体声噪声，返回每秒音频的耗时 (微秒)
+ */
+static double measure_cpu(uint32_t in_rate, uint32_t out_rate, audio_resampler_quality_t q)
+{
+    size_t in_frames = (size_t)CPU_SECONDS * in_rate;
+    int16_t *in = malloc(in_frames * 2 * sizeof(int16_t));
+    uint32_t x = 2463534242u;
+    for (size_t i = 0; i < in_frames * 2; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        in[i] = (int16_t)(x >> 18);     // 约 -18 dBFS 的白噪声
+    }
+
+    audio_resampler_t rs;
+    audio_resampler_init(&rs, in_rate, out_rate, 2, q);
+    size_t out_cap = audio_resampler_max_output(&rs, in_frames);
+    int16_t *out = malloc(out_cap * 2 * sizeof(int16_t));
+
+    double us = 1e18;
+    for (int r = 0; r < CPU_RUNS; r++) {
+        audio_resampler_reset(&rs);
+        double t0 = now_ns();
+        run(&rs, in, in_frames, out, out_cap);
+        double t = (now_ns() - t0) / 1e3;
+        us = t < us ? t : us;
+    }
+
+    audio_resampler_deinit(&rs);
+    free(in);
+    free(out);
+    return us / CPU_SECONDS;
+}
+
+static double pass_freq(uint32_t in_rate, uint32_t out_rate, int i)
+{
+    double nyq = (in_rate < out_rate ? in_rate : out_rate) / 2.0;
+    double lo = 50.0;
+    double hi = 0.8 * nyq;
+    return lo * pow(hi / lo, (double)i / (PASS_POINTS - 1));
+}
+
+static void summary(uint32_t in_rate, uint32_t out_rate, audio_resampler_quality_t q)
+{
+    double gmin = 1e9, gmax = -1e9, snr_min = 1e9;
+    for (int i = 0; i < PASS_POINTS; i++) {
+        double g, snr;
+        measure_tone(in_rate, out_rate, q, pass_freq(in_rate, out_rate, i), &g, &snr);
+        gmin = g < gmin ? g : gmin;
+        gmax = g > gmax ? g : gmax;
+        snr_min = snr < snr_min ? snr : snr_min;
+    }
+    double g1k, snr_1k;
+    measure_tone(in_rate, out_rate, q, 1000.0, &g1k, &snr_1k);
+
+    char stop[16] = "-";
+    if (in_rate > out_rate) {
+        // 输出奈奎斯特频率与输入奈奎斯特频率之间，最靠近过渡带的测试音
+        double f = out_rate / 2.0 + (in_rate - out_rate) / 4.0;
+        snprintf(stop, sizeof(stop), "%.1f", measure_stopband(in_rate, out_rate, q, f));
+    }
+
+    double us = measure_cpu(in_rate, out_rate, q);
+    printf("%6lu -> %-6lu %-7s %+7.2f %+7.2f %7.1f %7.1f %8s %8.0f %8.0fx\n",
+           (unsigned long)in_rate, (unsigned long)out_rate, quality_names[q],
+           gmin, gmax, snr_1k, snr_min, stop, us, 1e6 / us);
+}
+
+static void curve(uint32_t in_rate, uint32_t out_rate, audio_resampler_quality_t q)
+{
+    double nyq = (in_rate < out_rate ? in_rate : out_rate) / 2.0;
+    printf("%lu -> %lu Hz, %s, -6 dBFS tones\n", (unsigned long)in_rate, (unsigned long)out_rate, quality_names[q]);
+    printf("%9s %9s %8s\n", "freq_hz", "gain_db", "snr_db");
+    for (int i = 0; i < PASS_POINTS; i++) {
+        double f = pass_freq(in_rate, out_rate, i);
+        double g, snr;
+        measure_tone(in_rate, out_rate, q, f, &g, &snr);
+        printf("%9.0f %+9.3f %8.1f\n", f, g, snr);
+    }
+    // 过渡带
+    for (double r = 0.85; r < 1.0; r += 0.05) {
+        double g, snr;
+        measure_tone(in_rate, out_rate, q, r * nyq, &g, &snr);
+        printf("%9.0f %+9.3f %8.1f\n", r * nyq, g, snr);
+    }
+    if (in_rate > out_rate) {
+        for (double f = out_rate / 2.0 + 250; f < in_rate / 2.0; f += (in_rate - out_rate) / 8.0) {
+            printf("%9.0f %9.1f %8s   (above output Nyquist, total output)\n",
+                   f, measure_stopband(in_rate, out_rate, q, f), "-");
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc >= 3) {
+        uint32_t in_rate = (uint32_t)atol(argv[1]);
+        uint32_t out_rate = (uint32_t)atol(argv[2]);
+        int q = argc > 3 ? atoi(argv[3]) : AUDIO_RESAMPLER_QUALITY_MEDIUM;
+        if (in_rate == 0 || out_rate == 0 || in_rate == out_rate || q < 0 || q > AUDIO_RESAMPLER_QUALITY_HIGH) {
+            fprintf(stderr, "usage: %s [in_rate out_rate [quality 0-2]]\n", argv[0]);
+            return 1;
+        }
+        curve(in_rate, out_rate, (audio_resampler_quality_t)q);
+        return 0;
+    }
+
+    static const uint32_t conversions[][2] = {
+        { 8000, 44100 }, { 16000, 44100 }, { 22050, 44100 }, { 32000, 44100 }, { 48000, 44100 }, { 44100, 48000 },
+    };
+
+    printf("stereo, -6 dBFS tones, pass band 50 Hz - 0.8 x Nyquist, %d s of noise for CPU (scalar dot product)\n",
+           CPU_SECONDS);
+    printf("%-16s %-7s %7s %7s %7s %7s %8s %8s %9s\n",
+           "conversion", "quality", "pass_lo", "pass_hi", "snr_1k", "snr_min", "stop_db", "us/s", "realtime");
+    for (size_t c = 0; c < sizeof(conversions) / sizeof(conversions[0]); c++) {
+        for (int q = AUDIO_RESAMPLER_QUALITY_LOW; q <= AUDIO_RESAMPLER_QUALITY_HIGH; q++) {
+            summary(conversions[c][0], conversions[c][1], (audio_resampler_quality_t)q);
+        }
+    }
+    return 0;
+}
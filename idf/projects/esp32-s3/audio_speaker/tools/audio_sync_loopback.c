@@ -0,0 +1,442 @@
+/*
+ * 多房间同步播放主机接收端 (Linux)
+ *
+ * 直接编译 main/audio_sync.c (接收、时钟同步、PI 漂移修正与 main/ 中完全相同)，用本文件中的替身
+ * 代替混音器和 I2S，在同一台机器上模拟一台音箱:
+ * - 设备时钟：esp_timer_get_time() = 启动偏移 + 单调时钟 × (1 + ppm)，模拟晶振偏差和不同的开机时刻
+ * - I2S：--dma-blocks 个 (默认 6，与 AUDIO_PLAYER_LATENCY_BALANCED 相同) AUDIO_MIXER_BLOCK_FRAMES 帧的
+ *   DMA 块，硬件按设备时钟每块开始输出下一块；
+ *   输出一块后"混音任务"从音源取整块补满队列 (音源不足一块时等待，队列取空时输出静音)。
+ *   audio_player_get_latency() 与设备一样报告从交给 DMA 到开始输出的实测延迟。
+ *   主机线程被延迟唤醒时补上错过的输出时刻，期间只能消耗已排队的块，与设备上任务被阻塞时相同。
+ *   虚拟机上偶尔整个进程停顿几十毫秒，6 块 (35ms) 不够时用 --dma-blocks 16 (AUDIO_PLAYER_LATENCY_ROBUST)
+ * - 出声记录：发送端播放 tools/multiroom_loopback.py 生成的斜坡信号 (左声道 = 帧号低 16 位，
+ *   右声道 = 帧号高位 × 512)，每块解出正在出声的帧号 (小数，含采样率转换的插值)，
+ *   按真实单调时钟写入日志：一行 "出声时刻(微秒) 帧号"
+ *
+ * 多个进程同时运行 (数据端口用 SO_REUSEADDR 共享) 即可比较同一时刻各台"音箱"播放到的位置，
+ * 见 tools/multiroom_loopback.py。测到的是时钟同步、出声时刻估算和 PI 控制的跟踪误差；
+ * 不包含 WiFi 组播的丢包和抖动 (本机回环几乎没有)，也不包含设备上 I2S 时钟与 CPU 时钟不同源的情况。
+ *
+ * 编译和运行:
+ *     cc -O2 -pthread -DHOST_ESP_TIMER_EXTERN -Imain -Itools/host -o sync_loopback \
+ *        tools/audio_sync_loopback.c main/audio_sync.c main/audio_resampler.c main/audio_dsp.c -lm
+ *     ./sync_loopback --id 1 --ppm 80 --offset-ms 5000 --seconds 60 --log r1.txt
+ */
+
+#include "include/audio_sync.h"
+#include "include/audio_player.h"
+#include "include/audio_mixer.h"
+#include "esp_timer.h"
+#include "esp_mac.h"
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SAMPLE_RATE             AUDIO_SYNC_SAMPLE_RATE
+#define BLOCK_FRAMES            AUDIO_MIXER_BLOCK_FRAMES
+#define DMA_DESC_MAX            16              // 与 AUDIO_PLAYER_LATENCY_ROBUST 相同 (16 × 256 帧)
+
+// 斜坡信号：右声道每 65536 帧增加一级
+#define RAMP_HIGH_STEP          512
+
+// ---------------------------------------------------------------------------
+// 设备时钟
+// ---------------------------------------------------------------------------
+
+static double clock_ppm = 0;
+static int64_t clock_offset_us = 0;
+static int64_t real_t0_ns = 0;
+
+static int64_t real_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    double elapsed_ns = (double)(real_now_ns() - real_t0_ns);
+    return clock_offset_us + (int64_t)(elapsed_ns * (1.0 + clock_ppm * 1e-6) / 1000.0);
+}
+
+// 设备时钟 (微秒) -> 真实单调时钟 (纳秒)
+static int64_t device_to_real_ns(double device_us)
+{
+    return real_t0_ns + (int64_t)((device_us - (double)clock_offset_us) * 1000.0 / (1.0 + clock_ppm * 1e-6));
+}
+
+static uint8_t mac_id = 1;
+
+esp_err_t esp_read_mac(uint8_t *mac, esp_mac_type_t type)
+{
+    (void)type;
+    const uint8_t base[6] = { 0x02, 0x00, 0x4D, 0x52, 0x00, mac_id };
+    memcpy(mac, base, sizeof(base));
+    return ESP_OK;
+}
+
+// ---------------------------------------------------------------------------
+// 混音器和播放器替身
+// ---------------------------------------------------------------------------
+
+struct audio_mixer_source {
+    int16_t *buf;
+    uint32_t frames;        // 容量
+    uint32_t head;          // 写入帧数
+    uint32_t tail;          // 读出帧数
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+};
+
+static struct audio_mixer_source sync_src = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+};
+
+static void abs_deadline(struct timespec *ts, uint32_t wait_ms)
+{
+    clock_gettime(CLOCK_REALTIME, ts);
+    ts->tv_sec += wait_ms / 1000;
+    ts->tv_nsec += (long)(wait_ms % 1000) * 1000000;
+    if (ts->tv_nsec >= 1000000000) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000;
+    }
+}
+
+esp_err_t audio_mixer_add_source(const audio_mixer_source_config_t *config, audio_mixer_source_t *out)
+{
+    if (config->channels != AUDIO_SYNC_CHANNELS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    sync_src.buf = calloc(config->ring_frames * AUDIO_SYNC_CHANNELS, sizeof(int16_t));
+    if (sync_src.buf == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    sync_src.frames = config->ring_frames;
+    *out = &sync_src;
+    return ESP_OK;
+}
+
+size_t audio_mixer_write(audio_mixer_source_t src, const int16_t *pcm, size_t bytes, uint32_t wait_ms)
+{
+    size_t frames = bytes / (AUDIO_SYNC_CHANNELS * sizeof(int16_t));
+    size_t written = 0;
+    struct timespec deadline;
+    abs_deadline(&deadline, wait_ms);
+
+    pthread_mutex_lock(&src->lock);
+    while (written < frames) {
+        uint32_t space = src->frames - (src->head - src->tail);
+        if (space == 0) {
+            if (pthread_cond_timedwait(&src->cond, &src->lock, &deadline) == ETIMEDOUT) {
+                break;
+            }
+            continue;
+        }
+        for (; space > 0 && written < frames; space--, written++) {
+            int16_t *dst = src->buf + (src->head % src->frames) * AUDIO_SYNC_CHANNELS;
+            dst[0] = pcm[written * AUDIO_SYNC_CHANNELS];
+            dst[1] = pcm[written * AUDIO_SYNC_CHANNELS + 1];
+            src->head++;
+        }
+    }
+    pthread_mutex_unlock(&src->lock);
+    return written * AUDIO_SYNC_CHANNELS * sizeof(int16_t);
+}
+
+esp_err_t audio_mixer_drain(audio_mixer_source_t src, uint32_t wait_ms)
+{
+    struct timespec deadline;
+    abs_deadline(&deadline, wait_ms);
+    esp_err_t ret = ESP_OK;
+
+    pthread_mutex_lock(&src->lock);
+    while (src->head != src->tail) {
+        if (pthread_cond_timedwait(&src->cond, &src->lock, &deadline) == ETIMEDOUT) {
+            ret = ESP_ERR_TIMEOUT;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&src->lock);
+    return ret;
+}
+
+size_t audio_mixer_get_fill(audio_mixer_source_t src)
+{
+    pthread_mutex_lock(&src->lock);
+    size_t fill = src->head - src->tail;
+    pthread_mutex_unlock(&src->lock);
+    return fill;
+}
+
+uint32_t audio_player_get_sample_rate(void)
+{
+    return SAMPLE_RATE;
+}
+
+// ---------------------------------------------------------------------------
+// I2S DMA 模拟
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    int16_t pcm[BLOCK_FRAMES * AUDIO_SYNC_CHANNELS];
+    double queued_us;           // 交给 DMA 的时刻 (设备时钟)
+} dma_block_t;
+
+static dma_block_t dma_queue[DMA_DESC_MAX];
+static uint32_t dma_desc_num = 6;
+static uint32_t dma_head = 0;   // 已排队块数
+static uint32_t dma_tail = 0;   // 已开始输出的块数
+static pthread_mutex_t latency_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t latency_last_us = 0;
+static uint32_t latency_samples = 0;
+
+void audio_player_get_latency(audio_player_latency_t *latency)
+{
+    memset(latency, 0, sizeof(*latency));
+    latency->dma_desc_num = dma_desc_num;
+    latency->dma_frame_num = BLOCK_FRAMES;
+    latency->dma_depth_us = (uint32_t)((uint64_t)dma_desc_num * BLOCK_FRAMES * 1000000 / SAMPLE_RATE);
+    pthread_mutex_lock(&latency_lock);
+    latency->last_us = latency_last_us;
+    latency->samples = latency_samples;
+    pthread_mutex_unlock(&latency_lock);
+}
+
+// ---------------------------------------------------------------------------
+// DAC 线程
+// ---------------------------------------------------------------------------
+
+static volatile int dac_running = 1;
+static FILE *log_file = NULL;
+static uint64_t dac_blocks = 0;
+static uint64_t dac_underruns = 0;
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * 解出一块中第一个采样对应的帧号：逐采样解码后减去块内偏移，取中位数附近 ±2 帧内的平均值
+ * (跳过斜坡回绕处的振铃)。静音或不成斜坡时返回 -1
+ */
+static double decode_position(const int16_t *pcm)
+{
+    double pos[BLOCK_FRAMES];
+    for (int i = 0; i < BLOCK_FRAMES; i++) {
+        double high = floor((double)pcm[i * 2 + 1] / RAMP_HIGH_STEP + 0.5);
+        pos[i] = high * 65536.0 + (pcm[i * 2] + 32768) - i;
+    }
+
+    double sorted[BLOCK_FRAMES];
+    memcpy(sorted, pos, sizeof(pos));
+    qsort(sorted, BLOCK_FRAMES, sizeof(double), cmp_double);
+    double median = sorted[BLOCK_FRAMES / 2];
+
+    double sum = 0;
+    int n = 0;
+    for (int i = 0; i < BLOCK_FRAMES; i++) {
+        if (fabs(pos[i] - median) <= 2.0) {
+            sum += pos[i];
+            n++;
+        }
+    }
+    if (n < BLOCK_FRAMES / 2 || median < 0) {
+        return -1;
+    }
+    return sum / n;
+}
+
+void audio_mixer_get_stats(audio_mixer_stats_t *stats)
+{
+    // 只有同步播放一个音源：DMA 队列里有块即视为上一个混音块有数据
+    memset(stats, 0, sizeof(*stats));
+    stats->num_sources = 1;
+    stats->sources[0].name = "sync";
+    stats->sources[0].active = (dma_head != dma_tail);
+}
+
+/**
+ * 混音任务：DMA 队列有空位且音源有一整块时取一块 (音源不足时与混音器一样等待生产者，不写静音)
+ */
+static void mixer_fill_dma(double now_us)
+{
+    while (dma_head - dma_tail < dma_desc_num) {
+        dma_block_t *blk = &dma_queue[dma_head % dma_desc_num];
+        pthread_mutex_lock(&sync_src.lock);
+        if (sync_src.head - sync_src.tail < BLOCK_FRAMES) {
+            pthread_mutex_unlock(&sync_src.lock);
+            break;
+        }
+        for (uint32_t i = 0; i < BLOCK_FRAMES; i++) {
+            const int16_t *src = sync_src.buf + (sync_src.tail % sync_src.frames) * AUDIO_SYNC_CHANNELS;
+            blk->pcm[i * 2] = src[0];
+            blk->pcm[i * 2 + 1] = src[1];
+            sync_src.tail++;
+        }
+        pthread_cond_broadcast(&sync_src.cond);
+        pthread_mutex_unlock(&sync_src.lock);
+        blk->queued_us = now_us;
+        dma_head++;
+    }
+}
+
+/**
+ * I2S 硬件：start_us 时刻开始输出队首的块，记录延迟和出声位置
+ */
+static void dma_start_block(double start_us)
+{
+    audio_sync_stats_t st;
+    audio_sync_get_stats(&st);
+    bool playing = (st.state == AUDIO_SYNC_STATE_PLAYING);
+
+    // 队首的块晚于 start_us 才交给 DMA (主机线程被延迟超过 DMA 深度) 时与队列空相同
+    if (dma_head == dma_tail || dma_queue[dma_tail % dma_desc_num].queued_us > start_us) {
+        // DMA 队列空：输出静音，之后的音频整体推迟 (开始播放后第一块到达前不算)
+        if (playing && dac_blocks > 0) {
+            dac_blocks++;
+            dac_underruns++;
+            printf("音箱 %u: %.3f s DMA 欠载\n", mac_id, (device_to_real_ns(start_us) - real_t0_ns) / 1e9);
+        }
+        return;
+    }
+
+    dma_block_t *blk = &dma_queue[dma_tail % dma_desc_num];
+    dma_tail++;
+
+    // 与 audio_player 相同：从交给 I2S 到该块开始输出
+    pthread_mutex_lock(&latency_lock);
+    latency_last_us = (uint32_t)(start_us - blk->queued_us);
+    latency_samples++;
+    pthread_mutex_unlock(&latency_lock);
+
+    if (playing) {
+        dac_blocks++;
+    }
+
+    double pos = decode_position(blk->pcm);
+    if (pos >= 0 && log_file != NULL) {
+        fprintf(log_file, "%lld %.3f\n", (long long)(device_to_real_ns(start_us) / 1000), pos);
+    }
+}
+
+static void *dac_thread(void *arg)
+{
+    (void)arg;
+    const double block_us = (double)BLOCK_FRAMES * 1000000.0 / SAMPLE_RATE;
+    double tick_us = (double)esp_timer_get_time();
+
+    while (dac_running) {
+        // 硬件按设备时钟每块开始输出下一块；主机线程被延迟唤醒时补上错过的时刻
+        // (真实 DMA 不受任务调度影响，期间只能消耗已排队的块)
+        tick_us += block_us;
+        int64_t wake_ns = device_to_real_ns(tick_us);
+        struct timespec ts = { .tv_sec = wake_ns / 1000000000, .tv_nsec = wake_ns % 1000000000 };
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+        }
+
+        dma_start_block(tick_us);
+        mixer_fill_dma((double)esp_timer_get_time());
+    }
+    return NULL;
+}
+
+// ---------------------------------------------------------------------------
+// 主程序
+// ---------------------------------------------------------------------------
+
+static const char *state_name(audio_sync_state_t state)
+{
+    switch (state) {
+    case AUDIO_SYNC_STATE_SYNCING: return "同步中";
+    case AUDIO_SYNC_STATE_PLAYING: return "播放中";
+    default: return "空闲";
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int seconds = 60;
+    double offset_ms = 0;
+    const char *log_path = NULL;
+    audio_sync_config_t cfg = AUDIO_SYNC_DEFAULT_CONFIG();
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--id") == 0) {
+            mac_id = (uint8_t)atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--ppm") == 0) {
+            clock_ppm = atof(argv[i + 1]);
+        } else if (strcmp(argv[i], "--offset-ms") == 0) {
+            offset_ms = atof(argv[i + 1]);
+        } else if (strcmp(argv[i], "--seconds") == 0) {
+            seconds = atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--log") == 0) {
+            log_path = argv[i + 1];
+        } else if (strcmp(argv[i], "--dma-blocks") == 0) {
+            dma_desc_num = (uint32_t)atoi(argv[i + 1]);
+            if (dma_desc_num < 2 || dma_desc_num > DMA_DESC_MAX) {
+                fprintf(stderr, "--dma-blocks 取 2..%d\n", DMA_DESC_MAX);
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--group") == 0) {
+            cfg.group = argv[i + 1];
+        } else if (strcmp(argv[i], "--port") == 0) {
+            cfg.port = (uint16_t)atoi(argv[i + 1]);
+        } else {
+            fprintf(stderr, "未知参数: %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    real_t0_ns = real_now_ns();
+    clock_offset_us = (int64_t)(offset_ms * 1000);
+    if (log_path != NULL && (log_file = fopen(log_path, "w")) == NULL) {
+        perror(log_path);
+        return 1;
+    }
+
+    esp_err_t ret = audio_sync_start(&cfg);
+    if (ret != ESP_OK) {
+        fprintf(stderr, "audio_sync_start 失败: %d\n", ret);
+        return 1;
+    }
+    pthread_t dac;
+    pthread_create(&dac, NULL, dac_thread, NULL);
+
+    printf("音箱 %u: 晶振偏差 %+.1f ppm, 时钟偏移 %.1f ms\n", mac_id, clock_ppm, offset_ms);
+    audio_sync_stats_t st;
+    for (int t = 1; t <= seconds; t++) {
+        sleep(1);
+        audio_sync_get_stats(&st);
+        if (t % 5 == 0 || t == seconds) {
+            // 发送端时钟就是本机单调时钟：真实偏移 = 单调时钟 - 设备时钟
+            int64_t true_offset = real_now_ns() / 1000 - esp_timer_get_time();
+            printf("音箱 %u [%3ds] %s 误差 %+6.2f ms, 修正 %+7.1f ppm, 时钟偏移误差 %+5lld us, 往返 %lu us, "
+                   "重新对齐 %lu, 迟到 %lu, 丢包 %lu\n",
+                   mac_id, t, state_name(st.state), st.playout_error_us / 1000.0, st.drift_ppb / 1000.0,
+                   (long long)(st.clock_offset_us - true_offset), (unsigned long)st.clock_rtt_us,
+                   (unsigned long)st.resyncs, (unsigned long)st.late, (unsigned long)st.lost);
+            fflush(stdout);
+        }
+    }
+
+    audio_sync_stop();
+    dac_running = 0;
+    pthread_join(dac, NULL);
+    if (log_file != NULL) {
+        fclose(log_file);
+    }
+    printf("音箱 %u: 播放 %llu 块, 欠载 %llu 块\n", mac_id,
+           (unsigned long long)dac_blocks, (unsigned long long)dac_underruns);
+    return 0;
+}
@@ -0,0 +1,263 @@
+/*
+ * DDS 音源主机基准 (Linux / macOS)
+ *
+ * 直接编译 main/audio_synth.c，混音器用本文件中的替身 (收集写入的 PCM)，输出:
+ * - 信噪比：单发音在持续电平上与理想正弦比较。理想信号使用与音源相同的 32 位相位累加器，
+ *   测到的是正弦表 + 线性插值 + 包络/力度乘法的误差，不含频率量化；
+ *   同时给出理想信号只做 int16 取整时的信噪比作为上限
+ * - CPU：1/2/4/8 个持续发音按 AUDIO_SYNTH_BLOCK_FRAMES 一次渲染，每秒音频和每发音秒的微秒数
+ * - 音序器：1 秒提示音 (与 audio_player_play_tone() 参数相同) 和《小星星》旋律
+ *   (与 audio_player_play_sample() 相同) 的每个音符是否在 start_ms 对应的采样点开始、
+ *   输出在最后一个音符的释音结束处停止 (之后最多 1 个包络到 0 的静音采样)，
+ *   以及 audio_synth_get_stats() 报告的 render_us_per_s / us_per_voice_s
+ *
+ * CPU 表按线程 CPU 时间取 20 段中最快的一段。audio_synth_get_stats() 按每次渲染调用累计 esp_timer 微秒，
+ * 主机上一次调用只需 1~2 微秒，截断误差很大，只作参考；设备上一次调用数百微秒，该统计是准确的。
+ * 主机的结果只用于比较实现之间的相对开销；设备上的 us_per_voice_s 在 audio_player_play_sample() 结束后打印。
+ *
+ * 编译和运行:
+ *     cc -O2 -Imain -Itools/host -o synth_bench tools/audio_synth_bench.c main/audio_synth.c main/audio_dsp.c -lm
+ *     ./synth_bench                # 44100 Hz, 每种发音数渲染 60 秒
+ *     ./synth_bench 16000 120      # 指定采样率和渲染秒数
+ */
+
+#include "include/audio_synth.h"
+#include "include/audio_mixer.h"
+#include "include/audio_dsp.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define DEFAULT_RATE        44100
+#define DEFAULT_SECONDS     60
+#define CPU_PASSES          20
+
+// ---------------------------------------------------------------------------
+// 混音器替身
+// ---------------------------------------------------------------------------
+
+static int16_t *mixer_pcm = NULL;
+static size_t mixer_frames = 0;
+static size_t mixer_cap = 0;
+
+esp_err_t audio_mixer_add_source(const audio_mixer_source_config_t *config, audio_mixer_source_t *out)
+{
+    (void)config;
+    static int dummy;
+    *out = (audio_mixer_source_t)&dummy;
+    return ESP_OK;
+}
+
+size_t audio_mixer_write(audio_mixer_source_t src, const int16_t *pcm, size_t bytes, uint32_t wait_ms)
+{
+    (void)src;
+    (void)wait_ms;
+    size_t n = bytes / sizeof(int16_t);
+    if (mixer_frames + n > mixer_cap) {
+        mixer_cap = (mixer_frames + n) * 2;
+        mixer_pcm = realloc(mixer_pcm, mixer_cap * sizeof(int16_t));
+    }
+    memcpy(mixer_pcm + mixer_frames, pcm, bytes);
+    mixer_frames += n;
+    return bytes;
+}
+
+esp_err_t audio_mixer_drain(audio_mixer_source_t src, uint32_t wait_ms)
+{
+    (void)src;
+    (void)wait_ms;
+    return ESP_OK;
+}
+
+// 线程 CPU 时间 (不计被调度出去的时间)
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// ---------------------------------------------------------------------------
+// 信噪比
+// ---------------------------------------------------------------------------
+
+static void measure_snr(uint32_t rate)
+{
+    static const float freqs[] = { 100.0f, 440.0f, 1000.0f, 3000.0f, 7000.0f, 12000.0f };
+    const audio_synth_adsr_t adsr = { .attack_ms = 5, .decay_ms = 0, .sustain = AUDIO_DSP_Q15_ONE, .release_ms = 5 };
+    const uint16_t velocity = 26214;            // 与 audio_player_play_tone() 相同
+    const size_t skip = rate / 50;              // 跳过起音 (20ms)
+    const size_t frames = rate;
+    int16_t *out = malloc((skip + frames) * sizeof(int16_t));
+
+    // 持续电平上的增益与 synth_render_voice() 相同: ((level >> 15) * velocity) >> 15
+    const double gain = (double)((AUDIO_DSP_Q15_ONE * (int32_t)velocity) >> 15) / 32768.0;
+
+    printf("SNR vs ideal sine at %lu Hz (velocity %u, sustain 1.0, 1 s after 20 ms attack)\n",
+           (unsigned long)rate, velocity);
+    printf("%10s %10s %14s\n", "freq_hz", "snr_db", "int16_only_db");
+    for (size_t f = 0; f < sizeof(freqs) / sizeof(freqs[0]); f++) {
+        if (freqs[f] >= rate * 0.5f) {
+            continue;
+        }
+        audio_synth_all_off();
+        audio_synth_note_on(freqs[f], velocity, &adsr);
+        audio_synth_render(out, skip + frames);
+
+        uint32_t inc = (uint32_t)((double)freqs[f] * 4294967296.0 / rate);
+        uint32_t phase = (uint32_t)(inc * skip);
+        double sig = 0.0;
+        double err = 0.0;
+        double qerr = 0.0;
+        for (size_t i = 0; i < frames; i++, phase += inc) {
+            double ideal = 32767.0 * gain * sin(2.0 * M_PI * phase / 4294967296.0);
+            double e = out[skip + i] - ideal;
+            double q = round(ideal) - ideal;
+            sig += ideal * ideal;
+            err += e * e;
+            qerr += q * q;
+        }
+        printf("%10.0f %10.1f %14.1f\n", freqs[f], 10.0 * log10(sig / err), 10.0 * log10(sig / qerr));
+    }
+    audio_synth_all_off();
+    free(out);
+}
+
+// ---------------------------------------------------------------------------
+// CPU
+// ---------------------------------------------------------------------------
+
+static void measure_cpu(uint32_t rate, int seconds)
+{
+    static const int counts[] = { 1, 2, 4, 8 };
+    static int16_t out[AUDIO_SYNTH_BLOCK_FRAMES];
+    const audio_synth_adsr_t adsr = AUDIO_SYNTH_DEFAULT_ADSR();
+    const size_t total = (size_t)rate * seconds;
+
+    printf("\nrender cost, %d s of audio per voice count, %d-frame blocks, fastest of %d passes\n",
+           seconds, AUDIO_SYNTH_BLOCK_FRAMES, CPU_PASSES);
+    printf("%7s %12s %14s\n", "voices", "us/s", "us/voice_s");
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        audio_synth_all_off();
+        for (int v = 0; v < counts[c]; v++) {
+            // 和弦 (低音量，避免削波影响饱和分支的走向)
+            audio_synth_note_on(220.0f * (1.0f + 0.25f * v), 3000, &adsr);
+        }
+        // 分 CPU_PASSES 段计时取最快的一段，减小主机调度的干扰
+        double best = 1e30;
+        for (int p = 0; p < CPU_PASSES; p++) {
+            double t0 = now_us();
+            for (size_t done = 0; done < total / CPU_PASSES; done += AUDIO_SYNTH_BLOCK_FRAMES) {
+                audio_synth_render(out, AUDIO_SYNTH_BLOCK_FRAMES);
+            }
+            double us = now_us() - t0;
+            best = (us < best) ? us : best;
+        }
+        double us_per_s = best * CPU_PASSES / seconds;
+        printf("%7d %12.1f %14.2f\n", counts[c], us_per_s, us_per_s / counts[c]);
+    }
+    audio_synth_all_off();
+}
+
+// ---------------------------------------------------------------------------
+// 音序器
+// ---------------------------------------------------------------------------
+
+static uint32_t ms_to_samples(uint32_t ms, uint32_t rate)
+{
+    uint32_t n = (uint32_t)(((uint64_t)ms * rate) / 1000);
+    return n > 0 ? n : 1;
+}
+
+/**
+ * 检查音序输出：每个音符从 start_ms 对应的采样点开始 (该点相位为 0，输出 0；下一个采样非 0；
+ * 前一个采样处于间隔中，为 0)，释音结束后最多再输出 1 个静音采样
+ */
+static int check_notes(const char *name, const audio_synth_note_t *notes, size_t count,
+                       const audio_synth_adsr_t *adsr, uint32_t rate)
+{
+    mixer_frames = 0;
+    audio_synth_play_sequence(notes, count, adsr);
+
+    size_t bad_onsets = 0;
+    for (size_t i = 0; i < count; i++) {
+        size_t p = (size_t)((uint64_t)notes[i].start_ms * rate / 1000);
+        if (p + 1 >= mixer_frames || mixer_pcm[p] != 0 || mixer_pcm[p + 1] == 0 ||
+            (p > 0 && mixer_pcm[p - 1] != 0)) {
+            bad_onsets++;
+        }
+    }
+    const audio_synth_note_t *last = &notes[count - 1];
+    size_t end = (size_t)((uint64_t)last->start_ms * rate / 1000) + ms_to_samples(last->duration_ms, rate) +
+                 ms_to_samples(adsr->release_ms, rate);
+    size_t audible = mixer_frames;
+    while (audible > 0 && mixer_pcm[audible - 1] == 0) {
+        audible--;
+    }
+    bool ok = bad_onsets == 0 && audible <= end && mixer_frames <= end + 1 && mixer_frames + 1 >= end;
+
+    audio_synth_stats_t stats;
+    audio_synth_get_stats(&stats);
+    printf("%-8s %2zu notes, %zu frames (release ends at %zu), %zu onsets off  %s  render %lu us/s, %lu us/voice_s\n",
+           name, count, mixer_frames, end, bad_onsets, ok ? "ok" : "FAIL",
+           (unsigned long)stats.render_us_per_s, (unsigned long)stats.us_per_voice_s);
+    return ok ? 0 : 1;
+}
+
+static int check_sequence(uint32_t rate)
+{
+    int failures = 0;
+    printf("\n");
+
+    // 1 秒提示音：按下 995ms + 释音 5ms
+    const audio_synth_adsr_t tone_adsr = { .attack_ms = 5, .decay_ms = 0, .sustain = AUDIO_DSP_Q15_ONE, .release_ms = 5 };
+    const audio_synth_note_t tone = { .start_ms = 0, .duration_ms = 995, .freq_hz = 1000.0f, .velocity = 26214 };
+    failures += check_notes("tone", &tone, 1, &tone_adsr, rate);
+
+    // 《小星星》：42 个音符，400/800ms，间隔 50ms
+    static const uint32_t durations[] = {
+        400, 400, 400, 400, 400, 400, 800, 400, 400, 400, 400, 400, 400, 800,
+        400, 400, 400, 400, 400, 400, 800, 400, 400, 400, 400, 400, 400, 800,
+        400, 400, 400, 400, 400, 400, 800, 400, 400, 400, 400, 400, 400, 800,
+    };
+    static const float freqs[] = { 261.63f, 293.66f, 329.63f, 349.23f, 392.0f, 440.0f };
+    const size_t count = sizeof(durations) / sizeof(durations[0]);
+    audio_synth_note_t notes[sizeof(durations) / sizeof(durations[0])];
+    uint32_t t = 0;
+    for (size_t i = 0; i < count; i++) {
+        notes[i].start_ms = t;
+        notes[i].duration_ms = durations[i];
+        notes[i].freq_hz = freqs[i % 6];
+        notes[i].velocity = 26214;
+        t += durations[i] + 50;
+    }
+    const audio_synth_adsr_t adsr = AUDIO_SYNTH_DEFAULT_ADSR();
+    failures += check_notes("melody", notes, count, &adsr, rate);
+    return failures;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t rate = argc > 1 ? (uint32_t)atoi(argv[1]) : DEFAULT_RATE;
+    int seconds = argc > 2 ? atoi(argv[2]) : DEFAULT_SECONDS;
+    if (rate == 0 || seconds <= 0) {
+        fprintf(stderr, "usage: %s [sample_rate] [seconds]\n", argv[0]);
+        return 2;
+    }
+
+    if (audio_synth_init(rate) != ESP_OK) {
+        return 2;
+    }
+
+    measure_snr(rate);
+    measure_cpu(rate, seconds);
+    int failures = check_sequence(rate);
+    free(mixer_pcm);
+    return failures == 0 ? 0 : 1;
+}
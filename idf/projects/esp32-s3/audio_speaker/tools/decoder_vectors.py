@@ -0,0 +1,252 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+解码器参考码流生成 (Linux / macOS)
+
+为 tools/audio_decoder_test.c 生成测试文件和期望输出 (16 位小端交织 PCM)，写入输出目录，
+并生成 manifest.txt (每行: 名称 文件 格式 采样率 声道 帧数)。
+
+IMA-ADPCM: 由 CPython 的 audioop (独立于设备代码的 IMA/DVI 实现) 编码和解码，
+按 WAV (Microsoft) 块格式打包：每声道 4 字节块头，其后每声道交替 4 字节 (8 个采样)，
+半字节顺序为先低后高。覆盖单/双声道、不同块大小、满幅方波 (步长索引到顶和预测值饱和)、
+data 之前的奇数长度未知块，以及 data 末尾不足一块的尾部 (解码器应丢弃)。
+audioop 在 Python 3.13 中移除，需要 Python 3.12 及以前的版本。
+
+MP3: 主机上没有设备使用的 esp_audio_codec，生成的是合法的静音帧
+(帧头 + 全零边信息，任何 MP3 解码器输出全零)，用于检查 audio_decoder_mp3.c 的
+ID3v2 标签 (含标签尾) 跳过、分帧、半帧等待和帧间垃圾数据的重新同步。
+
+用法:
+    python3 tools/decoder_vectors.py                  # 写入 decoder_vectors/
+    python3 tools/decoder_vectors.py -o /tmp/vectors
+"""
+
+import argparse
+import math
+import os
+import random
+import struct
+import sys
+
+try:
+    import warnings
+    with warnings.catch_warnings():
+        warnings.simplefilter('ignore', DeprecationWarning)
+        import audioop
+except ImportError:
+    audioop = None
+
+
+# ---------------------------------------------------------------------------
+# 测试信号
+# ---------------------------------------------------------------------------
+
+def sweep(frames, rate, amp=0.7, f0=40.0, f1=None):
+    """对数扫频"""
+    f1 = f1 or rate * 0.45
+    k = math.log(f1 / f0) / frames
+    out = []
+    phase = 0.0
+    for i in range(frames):
+        phase += 2 * math.pi * f0 * math.exp(k * i) / rate
+        out.append(int(32767 * amp * math.sin(phase)))
+    return out
+
+
+def noise(frames, seed, amp=0.5):
+    rnd = random.Random(seed)
+    return [int(rnd.uniform(-1, 1) * 32767 * amp) for _ in range(frames)]
+
+
+def square(frames, period):
+    """满幅方波：步长索引升到 88，预测值在 ±32767 处饱和"""
+    return [32767 if (i // (period // 2)) % 2 == 0 else -32768 for i in range(frames)]
+
+
+def interleave(chans):
+    out = []
+    for frame in zip(*chans):
+        out.extend(frame)
+    return out
+
+
+# ---------------------------------------------------------------------------
+# WAV / IMA-ADPCM
+# ---------------------------------------------------------------------------
+
+def riff(chunks):
+    body = b'WAVE' + b''.join(chunks)
+    return b'RIFF' + struct.pack('<I', len(body)) + body
+
+
+def chunk(tag, data):
+    pad = b'\x00' if len(data) & 1 else b''
+    return tag + struct.pack('<I', len(data)) + data + pad
+
+
+def ima_fmt(rate, channels, block_align):
+    spb = (block_align - 4 * channels) * 2 // channels + 1
+    byte_rate = rate * block_align // spb
+    return chunk(b'fmt ', struct.pack('<HHIIHHHH', 0x0011, channels, rate, byte_rate,
+                                      block_align, 4, 2, spb)), spb
+
+
+def swap_nibbles(data):
+    # audioop 先写高半字节，WAV IMA 先写低半字节
+    return bytes(((b << 4) & 0xF0) | (b >> 4) for b in data)
+
+
+def ima_encode(chans, block_align):
+    """返回 (data 块内容, 期望 PCM 交织采样)"""
+    channels = len(chans)
+    spb = (block_align - 4 * channels) * 2 // channels + 1
+    frames = len(chans[0])
+    index = [0] * channels
+    data = bytearray()
+    expect = []
+
+    for start in range(0, frames - spb + 1, spb):
+        header = bytearray()
+        bodies = []
+        decoded = []
+        for ch in range(channels):
+            block = chans[ch][start:start + spb]
+            first = block[0]
+            header += struct.pack('<hBB', first, index[ch], 0)
+            rest = struct.pack('<%dh' % (spb - 1), *block[1:])
+            adpcm, (_, index[ch]) = audioop.lin2adpcm(rest, 2, (first, header[ch * 4 + 2]))
+            bodies.append(swap_nibbles(adpcm))
+            # 参考解码：从块头状态开始 (与编码器状态相同)
+            pcm, _ = audioop.adpcm2lin(adpcm, 2, (first, header[ch * 4 + 2]))
+            decoded.append([first] + list(struct.unpack('<%dh' % (spb - 1), pcm)))
+        data += header
+        # 每声道交替 4 字节
+        for g in range((spb - 1) // 8):
+            for ch in range(channels):
+                data += bodies[ch][g * 4:(g + 1) * 4]
+        expect.extend(interleave(decoded))
+    return bytes(data), expect
+
+
+def make_ima(name, rate, chans, block_align, extra_chunk=None, tail=0):
+    fmt, _ = ima_fmt(rate, len(chans), block_align)
+    data, expect = ima_encode(chans, block_align)
+    if tail:
+        data += bytes(i & 0xFF for i in range(tail))   # 不足一块，解码器应丢弃
+    chunks = [fmt]
+    if extra_chunk is not None:
+        chunks.append(extra_chunk)
+    chunks.append(chunk(b'data', data))
+    return name + '.wav', riff(chunks), expect, rate, len(chans)
+
+
+# ---------------------------------------------------------------------------
+# MP3 静音帧
+# ---------------------------------------------------------------------------
+
+MP3_BITRATES = {
+    1: [0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320],     # MPEG-1
+    2: [0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160],        # MPEG-2/2.5
+}
+MP3_RATES = {1: [44100, 48000, 32000], 2: [22050, 24000, 16000]}
+
+
+def mp3_frames(version, rate, kbps, channels, count):
+    """MPEG-1/2 Layer III 静音帧 (无 CRC)，按累计误差插入填充字节"""
+    br_idx = MP3_BITRATES[version].index(kbps)
+    sr_idx = MP3_RATES[version].index(rate)
+    spf = 1152 if version == 1 else 576
+    side = (32 if channels == 2 else 17) if version == 1 else (17 if channels == 2 else 9)
+    b1 = 0xFB if version == 1 else 0xF3
+    mode = 0x00 if channels == 2 else 0xC0
+    out = bytearray()
+    rest = 0
+    exact = spf // 8 * kbps * 1000
+    for _ in range(count):
+        size = exact // rate
+        rest += exact % rate
+        pad = 0
+        if rest >= rate:
+            rest -= rate
+            pad = 1
+        hdr = bytes([0xFF, b1, (br_idx << 4) | (sr_idx << 2) | (pad << 1), mode])
+        out += hdr + bytes(size + pad - 4)
+        assert side <= size - 4
+    return bytes(out), spf
+
+
+def id3v2(size, footer):
+    body = bytes((i * 7) & 0x7F for i in range(size))
+    syn = bytes([(size >> 21) & 0x7F, (size >> 14) & 0x7F, (size >> 7) & 0x7F, size & 0x7F])
+    flags = 0x10 if footer else 0x00
+    tag = b'ID3' + bytes([4, 0, flags]) + syn + body
+    if footer:
+        tag += b'3DI' + bytes([4, 0, flags]) + syn
+    return tag
+
+
+def make_mp3(name, version, rate, kbps, channels, count, tag=None, garbage_every=0):
+    frames, spf = mp3_frames(version, rate, kbps, channels, count)
+    frame_len = len(frames) // count
+    if garbage_every:
+        # 每隔若干帧插入不含 0xFF 的垃圾数据 (按帧头重新切分)
+        parts = []
+        pos = 0
+        n = 0
+        while pos < len(frames):
+            nxt = frames.find(b'\xff', pos + frame_len - 2)
+            nxt = len(frames) if nxt < 0 else nxt
+            parts.append(frames[pos:nxt])
+            pos = nxt
+            n += 1
+            if n % garbage_every == 0 and pos < len(frames):
+                parts.append(bytes((i % 0xFE) for i in range(37)))
+        frames = b''.join(parts)
+    data = (tag or b'') + frames
+    expect = [0] * (count * spf * channels)
+    return name + '.mp3', data, expect, rate, channels
+
+
+# ---------------------------------------------------------------------------
+
+def main():
+    parser = argparse.ArgumentParser(description='Generate decoder reference bitstreams')
+    parser.add_argument('-o', '--out', default='decoder_vectors', help='输出目录')
+    args = parser.parse_args()
+
+    if audioop is None:
+        print('需要 audioop 模块 (Python 3.12 及以前) 生成 IMA-ADPCM 参考码流', file=sys.stderr)
+        return 1
+
+    os.makedirs(args.out, exist_ok=True)
+
+    r44 = 44100
+    vectors = [
+        make_ima('ima_mono_22k_b512', 22050, [sweep(22050 * 2, 22050)], 512),
+        make_ima('ima_stereo_44k_b2048', r44,
+                 [sweep(r44 * 3, r44), noise(r44 * 3, 1)], 2048),
+        make_ima('ima_stereo_16k_b1024_list', 16000,
+                 [noise(16000 * 2, 2, 0.9), sweep(16000 * 2, 16000, 0.3)], 1024,
+                 extra_chunk=chunk(b'LIST', b'INFOISFT\x07\x00\x00\x00vectors'), tail=300),
+        make_ima('ima_mono_8k_b256_square', 8000, [square(8000, 40)], 256),
+        make_mp3('mp3_44k_128k_stereo_id3', 1, r44, 128, 2, 200, tag=id3v2(1000, footer=True)),
+        make_mp3('mp3_22k_64k_mono', 2, 22050, 64, 1, 300, tag=id3v2(200, footer=False)),
+        make_mp3('mp3_48k_320k_stereo_garbage', 1, 48000, 320, 2, 120, garbage_every=10),
+    ]
+
+    with open(os.path.join(args.out, 'manifest.txt'), 'w') as m:
+        for fname, data, expect, rate, channels in vectors:
+            with open(os.path.join(args.out, fname), 'wb') as f:
+                f.write(data)
+            base = os.path.splitext(fname)[0]
+            with open(os.path.join(args.out, base + '.pcm'), 'wb') as f:
+                f.write(struct.pack('<%dh' % len(expect), *expect))
+            fmt = 'wav' if fname.endswith('.wav') else 'mp3'
+            frames = len(expect) // channels
+            m.write('%s %s %s %d %d %d\n' % (base, fname, fmt, rate, channels, frames))
+            print('%-32s %8d 字节, %d Hz, %d 声道, %d 帧' % (fname, len(data), rate, channels, frames))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,132 @@
+// 主机测试用的 esp_audio_codec 替身：只解析 MPEG Layer III 帧头，每帧输出静音
+//
+// 设备上的 MP3 解码库只有目标平台的二进制，主机上无法运行。这个替身按帧头计算帧长和
+// 每帧采样数，用于检查 audio_decoder_mp3.c 的 ID3 跳过、分帧和重新同步
+// (配合 tools/decoder_vectors.py 生成的静音帧)，不解码音频内容，也不代表设备上的解码耗时。
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+typedef int esp_audio_err_t;
+
+#define ESP_AUDIO_ERR_OK            0
+#define ESP_AUDIO_ERR_FAIL          -1
+#define ESP_AUDIO_ERR_DATA_LACK     -3
+#define ESP_AUDIO_ERR_BUFF_NOT_ENOUGH -4
+
+typedef enum {
+    ESP_AUDIO_TYPE_MP3 = 1,
+} esp_audio_type_t;
+
+typedef void *esp_audio_dec_handle_t;
+
+typedef struct {
+    esp_audio_type_t type;
+    void *cfg;
+    uint32_t cfg_sz;
+} esp_audio_dec_cfg_t;
+
+typedef struct {
+    uint8_t *buffer;
+    uint32_t len;
+    uint32_t consumed;
+    int frame_recover;
+} esp_audio_dec_in_raw_t;
+
+typedef struct {
+    uint8_t *buffer;
+    uint32_t len;
+    uint32_t needed_size;
+    uint32_t decoded_size;
+} esp_audio_dec_out_frame_t;
+
+typedef struct {
+    uint32_t sample_rate;
+    uint8_t bits_per_sample;
+    uint8_t channel;
+    uint32_t bitrate;
+    uint32_t frame_size;
+} esp_audio_dec_info_t;
+
+static int s_host_mp3_handle;
+
+static inline esp_audio_err_t esp_audio_dec_open(esp_audio_dec_cfg_t *cfg, esp_audio_dec_handle_t *handle)
+{
+    if (cfg == NULL || cfg->type != ESP_AUDIO_TYPE_MP3) {
+        return ESP_AUDIO_ERR_FAIL;
+    }
+    *handle = &s_host_mp3_handle;
+    return ESP_AUDIO_ERR_OK;
+}
+
+static inline void esp_audio_dec_close(esp_audio_dec_handle_t handle)
+{
+    (void)handle;
+}
+
+// 解析帧头，返回帧长 (字节)，无效帧头返回 0
+static inline uint32_t host_mp3_header(const uint8_t *h, esp_audio_dec_info_t *info, uint32_t *samples)
+{
+    static const uint16_t br_v1[16] = { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 0 };
+    static const uint16_t br_v2[16] = { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, 0 };
+    static const uint32_t sr_v1[3] = { 44100, 48000, 32000 };
+
+    if (h[0] != 0xFF || (h[1] & 0xE0) != 0xE0 || ((h[1] >> 1) & 3) != 1) {
+        return 0;   // 不是 Layer III
+    }
+    uint32_t version = (h[1] >> 3) & 3;         // 3 = MPEG-1, 2 = MPEG-2, 0 = MPEG-2.5
+    uint32_t br_idx = h[2] >> 4;
+    uint32_t sr_idx = (h[2] >> 2) & 3;
+    if (version == 1 || br_idx == 0 || br_idx == 15 || sr_idx == 3) {
+        return 0;
+    }
+    uint32_t rate = sr_v1[sr_idx] >> (version == 3 ? 0 : version == 2 ? 1 : 2);
+    uint32_t kbps = (version == 3) ? br_v1[br_idx] : br_v2[br_idx];
+    uint32_t spf = (version == 3) ? 1152 : 576;
+    uint32_t pad = (h[2] >> 1) & 1;
+
+    info->sample_rate = rate;
+    info->channel = ((h[3] >> 6) == 3) ? 1 : 2;
+    info->bits_per_sample = 16;
+    info->bitrate = kbps * 1000;
+    *samples = spf;
+    return spf / 8 * kbps * 1000 / rate + pad;
+}
+
+static inline esp_audio_err_t esp_audio_dec_process(esp_audio_dec_handle_t handle, esp_audio_dec_in_raw_t *raw,
+                                                    esp_audio_dec_out_frame_t *frame, esp_audio_dec_info_t *info)
+{
+    (void)handle;
+    raw->consumed = 0;
+    frame->decoded_size = 0;
+    if (raw->len < 4) {
+        return ESP_AUDIO_ERR_DATA_LACK;
+    }
+
+    uint32_t samples = 0;
+    uint32_t size = host_mp3_header(raw->buffer, info, &samples);
+    if (size == 0) {
+        // 跳到下一个可能的帧同步
+        uint32_t skip = 1;
+        while (skip < raw->len && raw->buffer[skip] != 0xFF) {
+            skip++;
+        }
+        raw->consumed = skip;
+        return ESP_AUDIO_ERR_FAIL;
+    }
+    if (raw->len < size) {
+        return ESP_AUDIO_ERR_DATA_LACK;
+    }
+
+    uint32_t bytes = samples * info->channel * sizeof(int16_t);
+    if (frame->len < bytes) {
+        frame->needed_size = bytes;
+        return ESP_AUDIO_ERR_BUFF_NOT_ENOUGH;
+    }
+    memset(frame->buffer, 0, bytes);
+    frame->decoded_size = bytes;
+    info->frame_size = size;
+    raw->consumed = size;
+    return ESP_AUDIO_ERR_OK;
+}
@@ -0,0 +1,9 @@
+// 主机测试用的 esp_audio_codec 替身 (见 esp_audio_dec.h)
+#pragma once
+
+#include "esp_audio_dec.h"
+
+static inline esp_audio_err_t esp_audio_dec_register_default(void)
+{
+    return ESP_AUDIO_ERR_OK;
+}
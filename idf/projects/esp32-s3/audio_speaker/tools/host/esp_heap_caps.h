@@ -0,0 +1,27 @@
+// 主机基准用的 ESP-IDF 替身：堆分配映射到 C 库
+#pragma once
+
+#include <stdlib.h>
+
+#define MALLOC_CAP_INTERNAL     (1 << 11)
+#define MALLOC_CAP_SPIRAM       (1 << 10)
+#define MALLOC_CAP_DMA          (1 << 3)
+#define MALLOC_CAP_8BIT         (1 << 2)
+
+static inline void *heap_caps_malloc(size_t size, int caps)
+{
+    (void)caps;
+    return malloc(size);
+}
+
+static inline void *heap_caps_aligned_alloc(size_t alignment, size_t size, int caps)
+{
+    (void)caps;
+    void *p = NULL;
+    return posix_memalign(&p, alignment, size) == 0 ? p : NULL;
+}
+
+static inline void heap_caps_free(void *ptr)
+{
+    free(ptr);
+}
@@ -0,0 +1,11 @@
+// 主机基准用的 ESP-IDF 替身：MAC 地址由测试程序提供 (用作设备标识)
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef enum {
+    ESP_MAC_WIFI_STA,
+} esp_mac_type_t;
+
+esp_err_t esp_read_mac(uint8_t *mac, esp_mac_type_t type);
@@ -0,0 +1,18 @@
+// 主机基准用的 ESP-IDF 替身：单调时钟 (微秒)
+//
+// 定义 HOST_ESP_TIMER_EXTERN 时由测试程序提供 esp_timer_get_time()，用于模拟设备晶振偏差
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+
+#ifdef HOST_ESP_TIMER_EXTERN
+int64_t esp_timer_get_time(void);
+#else
+static inline int64_t esp_timer_get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+#endif
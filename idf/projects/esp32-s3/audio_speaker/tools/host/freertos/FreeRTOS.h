@@ -0,0 +1,23 @@
+// 主机基准用的 FreeRTOS 替身：只提供被测模块用到的类型和临界区宏 (临界区映射为 pthread 互斥量)
+#pragma once
+
+#include <stdint.h>
+#include <pthread.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE                          1
+#define pdFALSE                         0
+#define pdPASS                          pdTRUE
+#define portMAX_DELAY                   0xFFFFFFFFu
+#define pdMS_TO_TICKS(ms)               ((TickType_t)(ms))      // 节拍 = 1ms
+
+typedef struct {
+    pthread_mutex_t mutex;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED    { PTHREAD_MUTEX_INITIALIZER }
+#define portENTER_CRITICAL(mux)         pthread_mutex_lock(&(mux)->mutex)
+#define portEXIT_CRITICAL(mux)          pthread_mutex_unlock(&(mux)->mutex)
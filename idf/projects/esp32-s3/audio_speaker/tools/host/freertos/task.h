@@ -0,0 +1,66 @@
+// 主机基准用的 FreeRTOS 替身：任务映射为 pthread 线程 (忽略栈大小、优先级和核心绑定)
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include <stdlib.h>
+#include <time.h>
+
+typedef pthread_t *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+typedef struct {
+    TaskFunction_t fn;
+    void *arg;
+} host_task_start_t;
+
+static inline void *host_task_entry(void *p)
+{
+    host_task_start_t start = *(host_task_start_t *)p;
+    free(p);
+    start.fn(start.arg);
+    return NULL;
+}
+
+static inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack,
+                                                 void *arg, UBaseType_t priority, TaskHandle_t *handle, int core)
+{
+    (void)name;
+    (void)stack;
+    (void)priority;
+    (void)core;
+    host_task_start_t *start = malloc(sizeof(*start));
+    pthread_t thread;
+    if (start == NULL) {
+        return pdFALSE;
+    }
+    start->fn = fn;
+    start->arg = arg;
+    if (pthread_create(&thread, NULL, host_task_entry, start) != 0) {
+        free(start);
+        return pdFALSE;
+    }
+    pthread_detach(thread);
+    if (handle != NULL) {
+        *handle = NULL;
+    }
+    return pdPASS;
+}
+
+static inline BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack,
+                                     void *arg, UBaseType_t priority, TaskHandle_t *handle)
+{
+    return xTaskCreatePinnedToCore(fn, name, stack, arg, priority, handle, -1);
+}
+
+static inline void vTaskDelete(TaskHandle_t task)
+{
+    if (task == NULL) {
+        pthread_exit(NULL);
+    }
+}
+
+static inline void vTaskDelay(TickType_t ticks)
+{
+    struct timespec ts = { .tv_sec = ticks / 1000, .tv_nsec = (long)(ticks % 1000) * 1000000 };
+    nanosleep(&ts, NULL);
+}
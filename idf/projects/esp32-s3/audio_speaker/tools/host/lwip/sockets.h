@@ -0,0 +1,8 @@
+// 主机基准用的 lwIP 替身：BSD 套接字接口直接使用系统实现
+#pragma once
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
@@ -0,0 +1,2 @@
+// 主机基准用的 ESP-IDF 替身：不定义 CONFIG_IDF_TARGET_ESP32S3，audio_dsp.c 使用标量实现
+#pragma once
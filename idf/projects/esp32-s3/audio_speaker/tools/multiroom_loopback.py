@@ -0,0 +1,165 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+多房间同步播放本机回环测试 (Linux)
+
+在同一台机器上启动多个 tools/audio_sync_loopback.c 编译出的接收端 (每个模拟一台音箱，
+各自有晶振偏差和时钟偏移)，再用 tools/multiroom_sender.py 组播一段斜坡信号
+(左声道 = 帧号低 16 位，右声道 = 帧号高位 × 512)。接收端记录每块音频真实的出声时刻和帧号，
+本脚本在同一时刻比较各接收端播放到的位置，得到真实的设备间偏差 (不依赖接收端自己上报的误差)，
+并与发送端按上报误差统计的偏差对照。
+
+用法:
+    cc -O2 -pthread -DHOST_ESP_TIMER_EXTERN -Imain -Itools/host -o sync_loopback \\
+       tools/audio_sync_loopback.c main/audio_sync.c main/audio_resampler.c main/audio_dsp.c -lm
+    python3 tools/multiroom_loopback.py ./sync_loopback
+    python3 tools/multiroom_loopback.py ./sync_loopback --ppm 100,-100,0 --seconds 90 --limit-ms 1
+"""
+
+import argparse
+import bisect
+import os
+import subprocess
+import sys
+import tempfile
+import time
+import wave
+from array import array
+
+SAMPLE_RATE = 44100
+RAMP_HIGH_STEP = 512
+
+# 同一接收端相邻两条记录间隔超过此值 (或帧号不连续) 时不在其间插值
+MAX_GAP_US = 20000
+
+
+def write_ramp_wav(path, seconds):
+    """左声道 = 帧号低 16 位 (偏移到 int16)，右声道 = (帧号 >> 16) × 512"""
+    frames = int(seconds * SAMPLE_RATE)
+    if (frames >> 16) * RAMP_HIGH_STEP > 32767:
+        sys.exit('斜坡信号最长 %d 秒' % ((32767 // RAMP_HIGH_STEP) * 65536 // SAMPLE_RATE))
+    pcm = array('h', bytes(frames * 4))
+    for f in range(frames):
+        pcm[2 * f] = (f & 0xFFFF) - 32768
+        pcm[2 * f + 1] = (f >> 16) * RAMP_HIGH_STEP
+    if sys.byteorder != 'little':
+        pcm.byteswap()
+    with wave.open(path, 'wb') as wf:
+        wf.setnchannels(2)
+        wf.setsampwidth(2)
+        wf.setframerate(SAMPLE_RATE)
+        wf.writeframes(pcm.tobytes())
+
+
+def load_log(path):
+    """读取接收端记录: [(出声时刻 us, 帧号)]"""
+    points = []
+    with open(path) as f:
+        for line in f:
+            t, pos = line.split()
+            points.append((int(t), float(pos)))
+    return points
+
+
+def position_at(points, times, t):
+    """t 时刻正在出声的帧号 (相邻记录线性插值)，无法插值时返回 None"""
+    i = bisect.bisect_right(times, t)
+    if i == 0 or i == len(points):
+        return None
+    (t0, p0), (t1, p1) = points[i - 1], points[i]
+    rate = (p1 - p0) / (t1 - t0) * 1e6
+    if t1 - t0 > MAX_GAP_US or abs(rate - SAMPLE_RATE) > SAMPLE_RATE * 0.01:
+        return None     # 记录缺口或重新对齐
+    return p0 + (p1 - p0) * (t - t0) / (t1 - t0)
+
+
+def percentile(values, q):
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * q))]
+
+
+def main():
+    parser = argparse.ArgumentParser(description='多房间同步播放本机回环测试')
+    parser.add_argument('receiver', help='tools/audio_sync_loopback.c 编译出的接收端')
+    parser.add_argument('--ppm', default='80,-80', help='各接收端的晶振偏差 (逗号分隔，个数即接收端数)')
+    parser.add_argument('--seconds', type=int, default=60, help='发送秒数')
+    parser.add_argument('--settle', type=float, default=15, help='开始出声后不计入统计的秒数 (PI 收敛)')
+    parser.add_argument('--limit-ms', type=float, default=2.0, help='设备间偏差上限 (超过则返回 1)')
+    parser.add_argument('--dma-blocks', type=int, default=16,
+                        help='接收端模拟的 I2S DMA 块数 (默认 16，吸收虚拟机上的进程停顿)')
+    parser.add_argument('--delay-ms', type=float, default=200,
+                        help='发送端播放延迟 (需大于接收端混音缓冲 + DMA 深度，16 块时约 117ms)')
+    parser.add_argument('--group', default='239.255.77.77', help='组播地址')
+    parser.add_argument('--port', type=int, default=5004, help='RTP 端口')
+    args = parser.parse_args()
+
+    ppms = [float(p) for p in args.ppm.split(',')]
+    if len(ppms) < 2:
+        sys.exit('至少需要两个接收端')
+    sender = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'multiroom_sender.py')
+
+    with tempfile.TemporaryDirectory() as tmp:
+        wav = os.path.join(tmp, 'ramp.wav')
+        write_ramp_wav(wav, args.seconds + 2)
+
+        receivers = []
+        logs = []
+        for i, ppm in enumerate(ppms):
+            log = os.path.join(tmp, 'r%d.txt' % (i + 1))
+            logs.append(log)
+            # 各接收端的开机时刻不同：时钟偏移相差数秒到数百秒
+            offset_ms = 3700.0 + i * 127311.0
+            receivers.append(subprocess.Popen(
+                [args.receiver, '--id', str(i + 1), '--ppm', str(ppm), '--offset-ms', str(offset_ms),
+                 '--seconds', str(args.seconds + 4), '--log', log, '--dma-blocks', str(args.dma_blocks),
+                 '--group', args.group, '--port', str(args.port)],
+                stdout=subprocess.PIPE, text=True))
+        time.sleep(1.0)
+
+        sent = subprocess.run([sys.executable, sender, wav, '--group', args.group, '--port', str(args.port),
+                               '--delay-ms', str(args.delay_ms), '--duration', str(args.seconds)],
+                              stdout=subprocess.PIPE, text=True)
+        sender_summary = [line for line in sent.stdout.splitlines() if line.startswith('设备间偏差')]
+
+        for r in receivers:
+            out, _ = r.communicate()
+            lines = out.splitlines()
+            # 发送结束后数据流超时前的欠载不计
+            underruns = [line for line in lines[1:-1]
+                         if '欠载' in line and float(line.split()[2]) < args.seconds + 1.0]
+            print('\n'.join(lines[:1] + underruns + lines[-3:]))
+        series = [load_log(log) for log in logs]
+
+    if any(len(s) < 100 for s in series):
+        sys.exit('接收端没有出声记录 (组播不可达？)')
+
+    # 以第一台为参考，在其每条记录的时刻比较其他接收端的位置
+    ref = series[0]
+    start = max(s[0][0] for s in series) + int(args.settle * 1e6)
+    worst = 0.0
+    print('\n真实设备间偏差 (开始出声 %.0f 秒后，%d 台，晶振偏差 %s ppm):' % (args.settle, len(ppms), args.ppm))
+    for k in range(1, len(series)):
+        times = [t for t, _ in series[k]]
+        skews = []
+        for t, pos in ref:
+            if t < start:
+                continue
+            other = position_at(series[k], times, t)
+            if other is not None:
+                skews.append((pos - other) * 1000.0 / SAMPLE_RATE)     # ms，正值表示参考超前
+        if not skews:
+            sys.exit('接收端 %d 没有可比较的记录' % (k + 1))
+        mags = [abs(s) for s in skews]
+        worst = max(worst, max(mags))
+        print('  音箱 1 - 音箱 %d: 平均 %+.3f ms, |偏差| P95 %.3f ms, 最大 %.3f ms (%d 个比较点)' % (
+            k + 1, sum(skews) / len(skews), percentile(mags, 0.95), max(mags), len(skews)))
+    for line in sender_summary:
+        print('发送端按上报误差统计的' + line)
+
+    ok = worst <= args.limit_ms
+    print('%s: 最大设备间偏差 %.3f ms (上限 %.1f ms)' % ('通过' if ok else '失败', worst, args.limit_ms))
+    return 0 if ok else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,241 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+多房间同步播放发送端 (Linux)
+
+把 WAV 文件 (16 位 PCM, 44.1kHz, 单声道或立体声) 以 RTP 组播发给各 audio_speaker，
+同时作为时钟同步服务端，并根据各音箱上报的状态：
+- 调整播放延迟 (每秒最多变化 0.5ms，接收端用采样率微调跟随，不会断音)
+- 汇总各音箱的出声误差，输出设备间偏差 (最大误差 - 最小误差)
+
+线路格式见 main/include/audio_sync.h。
+
+用法:
+    python3 tools/multiroom_sender.py music.wav
+    python3 tools/multiroom_sender.py music.wav --loop --delay-ms 150
+    python3 tools/multiroom_sender.py music.wav --duration 120    # 运行 120 秒后输出偏差统计
+"""
+
+import argparse
+import socket
+import struct
+import sys
+import threading
+import time
+import wave
+
+SAMPLE_RATE = 44100
+CHANNELS = 2
+RTP_PT = 96
+EXT_PROFILE = 0x4D52            # "MR"
+CLOCK_MAGIC = 0x4D524353        # "MRCS"
+
+# audio_sync_clock_msg_t (小端, 60 字节)
+CLOCK_MSG = struct.Struct('<IB3xIqqqiIII6s2x')
+
+# 播放延迟每秒最多变化 0.5ms (500ppm，在接收端微调范围内)
+DELAY_SLEW_US_PER_S = 500
+
+
+def now_us():
+    """发送端时钟 (单调时钟, 微秒)"""
+    return time.monotonic_ns() // 1000
+
+
+class DeviceTable:
+    """各音箱上报的状态"""
+
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.devices = {}
+        self.skew_history = []
+
+    def update(self, device_id, addr, error_us, jitter_us, late, lost):
+        with self.lock:
+            self.devices[device_id] = {
+                'addr': addr,
+                'seen': time.monotonic(),
+                'error_us': error_us,
+                'jitter_us': jitter_us,
+                'late': late,
+                'lost': lost,
+            }
+
+    def active(self, timeout_s=5.0):
+        now = time.monotonic()
+        with self.lock:
+            return {k: dict(v) for k, v in self.devices.items() if now - v['seen'] < timeout_s}
+
+
+class ClockServer(threading.Thread):
+    """时钟同步服务端：填写 t2/t3 后返回请求，并记录请求中携带的接收端状态"""
+
+    def __init__(self, port, devices):
+        super().__init__(daemon=True)
+        self.devices = devices
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.bind(('0.0.0.0', port))
+
+    def run(self):
+        while True:
+            data, addr = self.sock.recvfrom(256)
+            t2 = now_us()
+            if len(data) != CLOCK_MSG.size:
+                continue
+            (magic, msg_type, seq, t1, _, _, error_us, jitter_us,
+             late, lost, device_id) = CLOCK_MSG.unpack(data)
+            if magic != CLOCK_MAGIC or msg_type != 0:
+                continue
+
+            reply = CLOCK_MSG.pack(magic, 1, seq, t1, t2, now_us(), error_us,
+                                   jitter_us, late, lost, device_id)
+            self.sock.sendto(reply, addr)
+            self.devices.update(device_id.hex(':'), addr[0], error_us, jitter_us, late, lost)
+
+
+def load_wav(path):
+    """读取 WAV 并转换为 L16 大端立体声"""
+    with wave.open(path, 'rb') as wf:
+        if wf.getsampwidth() != 2:
+            sys.exit('只支持 16 位 PCM WAV')
+        if wf.getframerate() != SAMPLE_RATE:
+            sys.exit('采样率必须为 44100 Hz (可先用 sox/ffmpeg 转换)')
+        channels = wf.getnchannels()
+        if channels not in (1, 2):
+            sys.exit('只支持单声道或立体声')
+        raw = wf.readframes(wf.getnframes())
+
+    count = len(raw) // 2
+    samples = struct.unpack('<%dh' % count, raw)
+    if channels == 1:
+        stereo = [s for s in samples for _ in (0, 1)]
+    else:
+        stereo = samples
+    return struct.pack('>%dh' % len(stereo), *stereo)
+
+
+def build_packet(seq, ts, ssrc, pres_us, payload):
+    """RTP 头 + 出声时刻头扩展 + 载荷"""
+    header = struct.pack('>BBHII', 0x90, RTP_PT, seq & 0xFFFF, ts & 0xFFFFFFFF, ssrc)
+    ext = struct.pack('>HHq', EXT_PROFILE, 2, pres_us)
+    return header + ext + payload
+
+
+def target_delay_us(devices, args):
+    """根据各音箱上报的到达抖动计算目标播放延迟"""
+    active = devices.active()
+    target = args.delay_ms * 1000
+    if active:
+        jitter = max(d['jitter_us'] for d in active.values())
+        target = max(target, 4 * jitter + 30000)
+    return min(max(target, args.min_delay_ms * 1000), args.max_delay_ms * 1000)
+
+
+def print_status(devices, delay_us):
+    """打印各音箱状态和设备间偏差"""
+    active = devices.active()
+    if not active:
+        print('[%.1fs] 播放延迟 %.1f ms, 暂无音箱上报' % (time.monotonic(), delay_us / 1000))
+        return
+
+    errors = [d['error_us'] for d in active.values()]
+    skew = max(errors) - min(errors)
+    devices.skew_history.append(skew)
+    print('播放延迟 %.1f ms, %d 台音箱, 设备间偏差 %.2f ms' % (delay_us / 1000, len(active), skew / 1000))
+    for dev_id, d in sorted(active.items()):
+        print('  %s (%s): 误差 %+.2f ms, 抖动 %.2f ms, 迟到 %d, 丢包 %d' % (
+            dev_id, d['addr'], d['error_us'] / 1000, d['jitter_us'] / 1000, d['late'], d['lost']))
+
+
+def print_summary(devices):
+    """输出偏差统计"""
+    hist = sorted(devices.skew_history)
+    if not hist:
+        print('没有收到音箱上报，无法统计偏差')
+        return
+    p95 = hist[min(len(hist) - 1, int(len(hist) * 0.95))]
+    print('设备间偏差: 平均 %.2f ms, P95 %.2f ms, 最大 %.2f ms (%d 次采样)' % (
+        sum(hist) / len(hist) / 1000, p95 / 1000, hist[-1] / 1000, len(hist)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='多房间同步播放发送端')
+    parser.add_argument('wav', help='16 位 PCM WAV 文件 (44.1kHz)')
+    parser.add_argument('--group', default='239.255.77.77', help='组播地址')
+    parser.add_argument('--port', type=int, default=5004, help='RTP 端口')
+    parser.add_argument('--clock-port', type=int, default=5005, help='时钟同步端口')
+    parser.add_argument('--ttl', type=int, default=1, help='组播 TTL')
+    parser.add_argument('--frames', type=int, default=256, help='每包帧数')
+    parser.add_argument('--delay-ms', type=float, default=120, help='初始播放延迟')
+    parser.add_argument('--min-delay-ms', type=float, default=60, help='最小播放延迟')
+    parser.add_argument('--max-delay-ms', type=float, default=300, help='最大播放延迟 (需小于接收端抖动缓冲)')
+    parser.add_argument('--loop', action='store_true', help='循环播放')
+    parser.add_argument('--duration', type=float, default=0, help='运行秒数后退出并输出偏差统计 (0 为不限)')
+    args = parser.parse_args()
+
+    pcm = load_wav(args.wav)
+    frame_bytes = CHANNELS * 2
+    packet_bytes = args.frames * frame_bytes
+    if packet_bytes + 24 > 1472:
+        sys.exit('每包帧数过大，超出以太网 MTU')
+
+    devices = DeviceTable()
+    ClockServer(args.clock_port, devices).start()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
+    sock.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_TTL, args.ttl)
+    dest = (args.group, args.port)
+
+    ssrc = int.from_bytes(struct.pack('>d', time.time())[-4:], 'big')
+    delay_us = args.delay_ms * 1000
+    start_us = now_us() + 50000
+    last_adjust_us = start_us
+    last_status = time.monotonic()
+    begin = time.monotonic()
+    seq = 0
+    ts = 0
+    pos = 0
+
+    print('发送 %s 到 %s:%d (SSRC %08x)' % (args.wav, args.group, args.port, ssrc))
+    try:
+        while True:
+            if pos + packet_bytes > len(pcm):
+                if not args.loop:
+                    break
+                pos = 0
+            payload = pcm[pos:pos + packet_bytes]
+            pos += packet_bytes
+
+            # 按单调时钟定时发送，出声时刻 = 发送时刻 + 播放延迟
+            send_us = start_us + ts * 1000000 // SAMPLE_RATE
+            wait = send_us - now_us()
+            if wait > 0:
+                time.sleep(wait / 1e6)
+
+            # 播放延迟缓慢向目标移动
+            now = now_us()
+            step = (now - last_adjust_us) * DELAY_SLEW_US_PER_S / 1000000
+            last_adjust_us = now
+            target = target_delay_us(devices, args)
+            if target > delay_us:
+                delay_us = min(target, delay_us + step)
+            else:
+                delay_us = max(target, delay_us - step)
+
+            sock.sendto(build_packet(seq, ts, ssrc, int(send_us + delay_us), payload), dest)
+            seq += 1
+            ts += args.frames
+
+            if time.monotonic() - last_status >= 2.0:
+                last_status = time.monotonic()
+                print_status(devices, delay_us)
+            if args.duration > 0 and time.monotonic() - begin >= args.duration:
+                break
+    except KeyboardInterrupt:
+        pass
+
+    print_summary(devices)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,303 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+音频管道限速测试服务器 (Linux)
+
+以受控的速率和停顿提供 WAV 文件，模拟不稳定的网络，检查音频管道 (audio_pipeline.c) 的
+预缓冲、水位暂停和欠载恢复。设备每次请求测试音频时依次使用下一个场景，播放结束后
+读取设备的 /api/pipeline 遥测，对比欠载次数和写入/播放字节数是否符合预期。
+
+场景 (速率以 WAV 的实时码率为 1.0):
+    steady   1.25 倍速率，不停顿                   预期 0 次欠载
+    jitter   1.5 倍速率，每 2 秒停顿 300ms         预期 0 次欠载 (停顿短于缓冲时长)
+    starve   1.25 倍速率，第 4 秒停顿 3 秒         预期恰好 1 次欠载，之后重新预缓冲继续播放
+    slow     0.8 倍速率，不停顿                    预期至少 1 次欠载 (网络慢于播放)
+
+设备端准备:
+    1. main/main.c 中 CURRENT_PLAY_MODE 改为 PLAY_MODE_NETWORK
+    2. main/include/wifi_audio.h 中 WIFI_AUDIO_TEST_URL 改为 "http://<本机IP>:8000/test.wav"
+    设备每 30 秒请求一次测试音频，全部场景约需 3 分钟。
+
+用法:
+    python3 tools/throttled_server.py --device 192.168.1.60
+    python3 tools/throttled_server.py --device 192.168.1.60 --scenarios starve,slow --seconds 20
+    python3 tools/throttled_server.py --wav music.wav --rate 1.1 --stall-every 5 --stall-ms 800
+    python3 tools/throttled_server.py --self-test     # 不连接设备，本机请求一次，检查限速是否准确
+"""
+
+import argparse
+import http.client
+import http.server
+import io
+import json
+import math
+import struct
+import sys
+import threading
+import time
+import wave
+
+SCENARIOS = {
+    # 名称: (速率倍数, 停顿间隔秒, 停顿毫秒, 只停顿一次的时刻秒, 欠载次数下限, 欠载次数上限)
+    'steady': (1.25, 0, 0, None, 0, 0),
+    'jitter': (1.5, 2.0, 300, None, 0, 0),
+    'starve': (1.25, 0, 3000, 4.0, 1, 1),
+    'slow':   (0.8, 0, 0, None, 1, None),
+}
+
+CHUNK = 1024
+
+
+def make_tone_wav(seconds, rate=44100, channels=2, freq=440.0):
+    """生成 16 位 PCM 正弦波 WAV (-12 dBFS)"""
+    frames = int(seconds * rate)
+    amp = int(32767 * 0.25)
+    buf = io.BytesIO()
+    with wave.open(buf, 'wb') as w:
+        w.setnchannels(channels)
+        w.setsampwidth(2)
+        w.setframerate(rate)
+        one = [struct.pack('<h', int(amp * math.sin(2 * math.pi * freq * i / rate))) * channels
+               for i in range(rate)]
+        data = b''.join(one)
+        full, rest = divmod(frames, rate)
+        w.writeframes(data * full + data[:rest * 2 * channels])
+    return buf.getvalue()
+
+
+def wav_info(data):
+    """返回 (每秒字节数, PCM 数据字节数)"""
+    with wave.open(io.BytesIO(data), 'rb') as w:
+        byte_rate = w.getframerate() * w.getnchannels() * w.getsampwidth()
+        return byte_rate, w.getnframes() * w.getnchannels() * w.getsampwidth()
+
+
+class Throttle:
+    """按速率发送，并在指定时刻插入停顿"""
+
+    def __init__(self, byte_rate, speed, stall_every, stall_ms, stall_once_at):
+        self.rate = byte_rate * speed
+        self.stall_every = stall_every
+        self.stall_s = stall_ms / 1000.0
+        self.stall_once_at = stall_once_at
+
+    def send(self, wfile, data):
+        start = time.monotonic()
+        stalled = 0.0               # 已经插入的停顿时间
+        next_stall = self.stall_every if self.stall_every > 0 else None
+        once = self.stall_once_at
+        sent = 0
+        while sent < len(data):
+            elapsed = sent / self.rate + stalled
+            if next_stall is not None and elapsed >= next_stall:
+                time.sleep(self.stall_s)
+                stalled += self.stall_s
+                next_stall += self.stall_every
+            if once is not None and elapsed >= once:
+                time.sleep(self.stall_s)
+                stalled += self.stall_s
+                once = None
+            due = start + sent / self.rate + stalled
+            delay = due - time.monotonic()
+            if delay > 0:
+                time.sleep(delay)
+            n = min(CHUNK, len(data) - sent)
+            wfile.write(data[sent:sent + n])
+            sent += n
+        wfile.flush()
+        return time.monotonic() - start
+
+
+class Server(http.server.ThreadingHTTPServer):
+    daemon_threads = True
+
+    def __init__(self, addr, wav, plan):
+        super().__init__(addr, Handler)
+        self.wav = wav
+        self.byte_rate, self.pcm_bytes = wav_info(wav)
+        self.plan = plan                # [(名称, 参数), ...]
+        self.next = 0
+        self.lock = threading.Lock()
+        self.served = threading.Condition(self.lock)
+        self.log = []                   # (名称, 发送耗时)
+
+
+class Handler(http.server.BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'
+
+    def do_GET(self):
+        srv = self.server
+        with srv.lock:
+            if srv.next >= len(srv.plan):
+                self.send_error(404, 'all scenarios done')
+                return
+            name, params = srv.plan[srv.next]
+            srv.next += 1
+        speed, every, stall_ms, once, _, _ = params
+
+        print('[%s] %s: %.2fx, 停顿 %s' % (self.client_address[0], name, speed,
+              ('每 %.1fs %dms' % (every, stall_ms)) if every else
+              ('第 %.1fs %dms' % (once, stall_ms)) if once is not None else '无'))
+        sys.stdout.flush()
+
+        # 不带 ETag：设备不会缓存到 Flash，每次都经过网络
+        self.send_response(200)
+        self.send_header('Content-Type', 'audio/wav')
+        self.send_header('Content-Length', str(len(srv.wav)))
+        self.send_header('Cache-Control', 'no-store')
+        self.end_headers()
+        try:
+            took = Throttle(srv.byte_rate, speed, every, stall_ms, once).send(self.wfile, srv.wav)
+        except OSError as e:
+            print('  发送中断: %s' % e)
+            took = None
+        with srv.lock:
+            srv.log.append((name, took))
+            srv.served.notify_all()
+
+    def log_message(self, fmt, *args):
+        pass
+
+
+def fetch_pipeline(host, timeout=3.0):
+    conn = http.client.HTTPConnection(host, 80, timeout=timeout)
+    try:
+        conn.request('GET', '/api/pipeline')
+        resp = conn.getresponse()
+        body = resp.read()
+        if resp.status != 200:
+            raise http.client.HTTPException('HTTP %d' % resp.status)
+        return json.loads(body)
+    finally:
+        conn.close()
+
+
+def watch_playback(args, srv, name, params, done_count):
+    """等待一次请求发送完毕、设备播放结束，返回是否符合预期"""
+    with srv.lock:
+        while len(srv.log) < done_count:
+            srv.served.wait(1.0)
+        took = srv.log[-1][1]
+
+    # 发送完毕后设备还要播放缓冲中的数据 (最多约 1.5 秒)
+    stats = None
+    deadline = time.monotonic() + 30
+    while time.monotonic() < deadline:
+        try:
+            stats = fetch_pipeline(args.device)
+        except (OSError, ValueError, http.client.HTTPException) as e:
+            print('  读取 /api/pipeline 失败: %s' % e)
+            time.sleep(1)
+            continue
+        if stats['state'] == 'idle':
+            break
+        time.sleep(0.2)
+    if stats is None or stats['state'] != 'idle':
+        print('  %s: 设备没有回到 idle 状态' % name)
+        return False
+
+    lo, hi = params[4], params[5]
+    under = stats['underruns']
+    ok_under = under >= lo and (hi is None or under <= hi)
+    ok_bytes = stats['bytes_written'] == srv.pcm_bytes and stats['bytes_played'] == stats['bytes_written']
+    ok = took is not None and ok_under and ok_bytes
+    print('  %s: 发送 %.1fs, 欠载 %d (预期 %s), 写入 %d / 播放 %d / PCM %d 字节, '
+          '最低缓冲 %d 字节, 暂停 %d 次, 首样本 %.0f ms  %s' % (
+              name, took or 0, under, ('%d' % lo) if lo == hi else ('>=%d' % lo) if hi is None else '%d-%d' % (lo, hi),
+              stats['bytes_written'], stats['bytes_played'], srv.pcm_bytes,
+              stats['min_fill_bytes'], stats['producer_pauses'], stats['start_us'] / 1000.0,
+              'PASS' if ok else 'FAIL'))
+    sys.stdout.flush()
+    return ok
+
+
+def self_test(srv, port):
+    """本机请求一次，检查实际速率和停顿"""
+    name, params = srv.plan[0]
+    speed, every, stall_ms, once, _, _ = params
+    expect = srv.byte_rate * speed
+    conn = http.client.HTTPConnection('127.0.0.1', port, timeout=30)
+    start = time.monotonic()
+    conn.request('GET', '/test.wav')
+    resp = conn.getresponse()
+    got = 0
+    gaps = []
+    last = start
+    while True:
+        chunk = resp.read(CHUNK)
+        if not chunk:
+            break
+        now = time.monotonic()
+        if now - last > 0.1:
+            gaps.append(now - last)
+        last = now
+        got += len(chunk)
+    took = time.monotonic() - start
+    conn.close()
+    stall_total = sum(gaps)
+    rate = got / (took - stall_total) if took > stall_total else 0
+    print('self-test %s: %d 字节, %.2fs, 停顿 %d 次共 %.2fs, 速率 %.0f B/s (设定 %.0f B/s, 误差 %+.1f%%)' % (
+        name, got, took, len(gaps), stall_total, rate, expect, (rate / expect - 1) * 100))
+    return got == len(srv.wav) and abs(rate / expect - 1) < 0.05
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Throttled WAV server for the audio pipeline')
+    parser.add_argument('--port', type=int, default=8000)
+    parser.add_argument('--device', help='设备 IP，用于读取 /api/pipeline 并判断结果')
+    parser.add_argument('--wav', help='WAV 文件 (默认生成 44.1kHz 立体声 440Hz 正弦波)')
+    parser.add_argument('--seconds', type=float, default=12.0, help='生成的测试音频时长 (秒)')
+    parser.add_argument('--scenarios', default=','.join(SCENARIOS), help='依次使用的场景，逗号分隔')
+    parser.add_argument('--rate', type=float, help='自定义场景：速率倍数 (替代 --scenarios)')
+    parser.add_argument('--stall-every', type=float, default=0, help='自定义场景：停顿间隔 (秒)')
+    parser.add_argument('--stall-ms', type=int, default=0, help='自定义场景：停顿时长 (毫秒)')
+    parser.add_argument('--self-test', action='store_true', help='本机请求第一个场景，检查限速')
+    args = parser.parse_args()
+
+    if args.wav:
+        with open(args.wav, 'rb') as f:
+            wav = f.read()
+    else:
+        wav = make_tone_wav(args.seconds)
+
+    if args.rate is not None:
+        plan = [('custom', (args.rate, args.stall_every, args.stall_ms, None, 0, None))]
+    else:
+        names = [n.strip() for n in args.scenarios.split(',') if n.strip()]
+        unknown = [n for n in names if n not in SCENARIOS]
+        if unknown:
+            parser.error('未知场景: %s' % ', '.join(unknown))
+        plan = [(n, SCENARIOS[n]) for n in names]
+
+    srv = Server(('', args.port), wav, plan)
+    print('%d 字节 WAV (%d B/s), 端口 %d, 场景: %s' % (
+        len(wav), srv.byte_rate, args.port, ', '.join(n for n, _ in plan)))
+    threading.Thread(target=srv.serve_forever, daemon=True).start()
+
+    if args.self_test:
+        ok = self_test(srv, args.port)
+        srv.shutdown()
+        return 0 if ok else 1
+
+    if not args.device:
+        print('未指定 --device，只提供数据，不检查结果 (Ctrl+C 退出)')
+        try:
+            while True:
+                time.sleep(1)
+        except KeyboardInterrupt:
+            return 0
+
+    passed = 0
+    try:
+        for i, (name, params) in enumerate(plan):
+            if watch_playback(args, srv, name, params, i + 1):
+                passed += 1
+    except KeyboardInterrupt:
+        pass
+    srv.shutdown()
+    print('%d/%d 场景通过' % (passed, len(plan)))
+    return 0 if passed == len(plan) else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
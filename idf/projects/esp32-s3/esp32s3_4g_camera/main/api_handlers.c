@@ -2,6 +2,7 @@
 #include "include/camera_driver.h"
 #include "include/ml307r_driver.h"
 #include "include/image_processor.h"
+#include "include/async_worker.h"
 #include "esp_log.h"
 #include "esp_system.h"
 #include "esp_heap_caps.h"
@@ -98,6 +99,8 @@ esp_err_t api_handlers_register(httpd_handle_t server)
 esp_err_t api_status_handler(httpd_req_t *req)
 {
     char response[512];
+    async_worker_stats_t worker_stats;
+    async_worker_get_stats(&worker_stats);
     
     snprintf(response, sizeof(response),
         "{"
@@ -105,13 +108,19 @@ esp_err_t api_status_handler(httpd_req_t *req)
         "\"network_connected\":%s,"
         "\"signal_strength\":%d,"
         "\"free_heap\":%lu,"
-        "\"ml307r_state\":%d"
+        "\"ml307r_state\":%d,"
+        "\"stream_workers_busy\":%u,"
+        "\"stream_workers_total\":%u,"
+        "\"stream_rejected\":%lu"
         "}",
         camera_driver_is_ready() ? "true" : "false",
         ml307r_is_ready() ? "true" : "false",
         ml307r_get_signal_strength(),
         esp_get_free_heap_size(),
-        ml307r_get_state()
+        ml307r_get_state(),
+        worker_stats.busy_workers,
+        worker_stats.total_workers,
+        (unsigned long)worker_stats.rejected
     );
 
     httpd_resp_set_type(req, "application/json");
@@ -173,8 +182,13 @@ esp_err_t api_camera_config_handler(httpd_req_t *req)
 }
 
 // 摄像头流API处理器 (MJPEG流)
+// 长连接，转交工作池执行，避免阻塞HTTP服务器任务
 esp_err_t api_camera_stream_handler(httpd_req_t *req)
 {
+    if (!async_worker_is_worker_task()) {
+        return async_worker_submit(req, api_camera_stream_handler);
+    }
+
     ESP_LOGI(TAG, "Starting camera stream...");
 
     if (!camera_driver_is_ready()) {
@@ -189,7 +203,7 @@ esp_err_t api_camera_stream_handler(httpd_req_t *req)
 
     // 流式传输
     esp_err_t ret = ESP_OK;
-    while (true) {
+    while (!async_worker_should_stop()) {
         camera_fb_t *fb = camera_driver_capture();
         if (fb == NULL) {
             ESP_LOGE(TAG, "Camera capture failed");
@@ -215,6 +229,7 @@ esp_err_t api_camera_stream_handler(httpd_req_t *req)
         camera_driver_release_frame(fb);
         
         if (ret != ESP_OK) {
+            // 客户端断开或发送超时
             break;
         }
 
@@ -230,8 +245,13 @@ esp_err_t api_camera_stream_handler(httpd_req_t *req)
 }
 
 // 摄像头抓拍API处理器
+// 整帧JPEG下载在慢速链路上耗时较长，同样转交工作池执行
 esp_err_t api_camera_capture_handler(httpd_req_t *req)
 {
+    if (!async_worker_is_worker_task()) {
+        return async_worker_submit(req, api_camera_capture_handler);
+    }
+
     if (!camera_driver_is_ready()) {
         httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Camera not ready");
         return ESP_FAIL;
@@ -0,0 +1,257 @@
+#include "include/async_worker.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "lwip/sockets.h"
+#include "esp_log.h"
+#include <string.h>
+
+static const char *TAG = "ASYNC_WORKER";
+
+// 等待工作任务退出的最长时间 (需大于发送超时，保证卡在发送中的任务也能退出)
+#define ASYNC_WORKER_STOP_TIMEOUT_MS  (ASYNC_WORKER_SEND_TIMEOUT_MS + 2000)
+
+// 队列中的任务
+typedef struct {
+    httpd_req_t *req;                  // httpd_req_async_handler_begin 复制出的请求
+    async_worker_handler_t handler;    // 处理函数
+} async_job_t;
+
+// 全局变量
+static QueueHandle_t job_queue = NULL;
+static SemaphoreHandle_t worker_ready = NULL;   // 计数信号量：空闲工作任务数
+static SemaphoreHandle_t worker_exited = NULL;  // 计数信号量：已退出的工作任务数
+static TaskHandle_t worker_tasks[ASYNC_WORKER_COUNT] = {0};
+static volatile bool stopping = false;
+static bool running = false;
+
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint8_t busy_workers = 0;
+static uint32_t completed_count = 0;
+static uint32_t rejected_count = 0;
+
+// 为单个连接设置发送超时，避免慢客户端长期占用工作任务
+static void async_worker_set_send_timeout(httpd_req_t *req)
+{
+    int sockfd = httpd_req_to_sockfd(req);
+    if (sockfd < 0) {
+        return;
+    }
+
+    struct timeval tv = {
+        .tv_sec = ASYNC_WORKER_SEND_TIMEOUT_MS / 1000,
+        .tv_usec = (ASYNC_WORKER_SEND_TIMEOUT_MS % 1000) * 1000,
+    };
+    if (setsockopt(sockfd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)) != 0) {
+        ESP_LOGW(TAG, "Failed to set send timeout on socket %d", sockfd);
+    }
+}
+
+// 工作任务
+static void async_worker_task(void *pvParameters)
+{
+    int index = (int)(intptr_t)pvParameters;
+    ESP_LOGI(TAG, "Worker %d started", index);
+
+    while (!stopping) {
+        async_job_t job;
+        if (xQueueReceive(job_queue, &job, pdMS_TO_TICKS(500)) != pdTRUE) {
+            continue;
+        }
+
+        portENTER_CRITICAL(&stats_lock);
+        busy_workers++;
+        portEXIT_CRITICAL(&stats_lock);
+
+        async_worker_set_send_timeout(job.req);
+
+        // 处理函数在客户端断开 (发送失败) 或工作池停止时返回
+        esp_err_t ret = job.handler(job.req);
+        if (ret != ESP_OK) {
+            ESP_LOGD(TAG, "Worker %d: handler for %s ended: %s", index, job.req->uri, esp_err_to_name(ret));
+        }
+
+        // 释放请求副本，连接交还给HTTP服务器
+        httpd_req_async_handler_complete(job.req);
+
+        portENTER_CRITICAL(&stats_lock);
+        busy_workers--;
+        completed_count++;
+        portEXIT_CRITICAL(&stats_lock);
+
+        xSemaphoreGive(worker_ready);
+    }
+
+    ESP_LOGI(TAG, "Worker %d stopped", index);
+    xSemaphoreGive(worker_exited);
+    vTaskDelete(NULL);
+}
+
+// 启动工作池
+esp_err_t async_worker_start(void)
+{
+    if (running) {
+        return ESP_OK;
+    }
+
+    job_queue = xQueueCreate(ASYNC_WORKER_COUNT, sizeof(async_job_t));
+    worker_ready = xSemaphoreCreateCounting(ASYNC_WORKER_COUNT, ASYNC_WORKER_COUNT);
+    worker_exited = xSemaphoreCreateCounting(ASYNC_WORKER_COUNT, 0);
+    if (job_queue == NULL || worker_ready == NULL || worker_exited == NULL) {
+        ESP_LOGE(TAG, "Failed to create worker queue/semaphores");
+        goto err;
+    }
+
+    stopping = false;
+    for (int i = 0; i < ASYNC_WORKER_COUNT; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "http_worker_%d", i);
+        BaseType_t ok = xTaskCreatePinnedToCore(async_worker_task, name, ASYNC_WORKER_STACK_SIZE,
+                                                (void *)(intptr_t)i, ASYNC_WORKER_PRIORITY,
+                                                &worker_tasks[i], ASYNC_WORKER_CORE_ID);
+        if (ok != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create worker %d", i);
+            // 已创建的工作任务由停止流程回收
+            for (int j = i; j < ASYNC_WORKER_COUNT; j++) {
+                worker_tasks[j] = NULL;
+                xSemaphoreGive(worker_exited);
+            }
+            running = true;
+            async_worker_stop();
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    running = true;
+    ESP_LOGI(TAG, "✅ %d async workers started", ASYNC_WORKER_COUNT);
+    return ESP_OK;
+
+err:
+    if (job_queue) vQueueDelete(job_queue);
+    if (worker_ready) vSemaphoreDelete(worker_ready);
+    if (worker_exited) vSemaphoreDelete(worker_exited);
+    job_queue = NULL;
+    worker_ready = NULL;
+    worker_exited = NULL;
+    return ESP_ERR_NO_MEM;
+}
+
+// 停止工作池
+esp_err_t async_worker_stop(void)
+{
+    if (!running) {
+        return ESP_OK;
+    }
+
+    ESP_LOGI(TAG, "Stopping async workers...");
+    stopping = true;
+
+    esp_err_t ret = ESP_OK;
+    for (int i = 0; i < ASYNC_WORKER_COUNT; i++) {
+        if (xSemaphoreTake(worker_exited, pdMS_TO_TICKS(ASYNC_WORKER_STOP_TIMEOUT_MS)) != pdTRUE) {
+            ESP_LOGE(TAG, "Timed out waiting for workers to exit");
+            ret = ESP_ERR_TIMEOUT;
+            break;
+        }
+    }
+
+    if (ret != ESP_OK) {
+        // 仍有工作任务在运行，保留资源避免其访问已释放的对象
+        return ret;
+    }
+
+    // 队列中尚未处理的请求直接结束
+    async_job_t job;
+    while (xQueueReceive(job_queue, &job, 0) == pdTRUE) {
+        httpd_req_async_handler_complete(job.req);
+    }
+
+    vQueueDelete(job_queue);
+    vSemaphoreDelete(worker_ready);
+    vSemaphoreDelete(worker_exited);
+    job_queue = NULL;
+    worker_ready = NULL;
+    worker_exited = NULL;
+    memset(worker_tasks, 0, sizeof(worker_tasks));
+
+    running = false;
+    ESP_LOGI(TAG, "Async workers stopped");
+    return ESP_OK;
+}
+
+// 将请求转交给工作池
+esp_err_t async_worker_submit(httpd_req_t *req, async_worker_handler_t handler)
+{
+    if (req == NULL || handler == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // 工作池已满或未运行：立即回复 503，不阻塞服务器任务
+    if (!running || stopping || xSemaphoreTake(worker_ready, 0) != pdTRUE) {
+        portENTER_CRITICAL(&stats_lock);
+        rejected_count++;
+        portEXIT_CRITICAL(&stats_lock);
+
+        ESP_LOGW(TAG, "No free worker for %s", req->uri);
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_set_hdr(req, "Retry-After", "5");
+        return httpd_resp_send(req, "Too many active streams", HTTPD_RESP_USE_STRLEN);
+    }
+
+    httpd_req_t *copy = NULL;
+    esp_err_t ret = httpd_req_async_handler_begin(req, &copy);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to begin async request: %s", esp_err_to_name(ret));
+        xSemaphoreGive(worker_ready);
+        return ret;
+    }
+
+    async_job_t job = {
+        .req = copy,
+        .handler = handler,
+    };
+
+    // 已持有空闲工作任务名额，队列一定有空位
+    if (xQueueSend(job_queue, &job, 0) != pdTRUE) {
+        ESP_LOGE(TAG, "Worker queue full");
+        httpd_req_async_handler_complete(copy);
+        xSemaphoreGive(worker_ready);
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+// 判断当前是否运行在工作任务中
+bool async_worker_is_worker_task(void)
+{
+    TaskHandle_t current = xTaskGetCurrentTaskHandle();
+    for (int i = 0; i < ASYNC_WORKER_COUNT; i++) {
+        if (worker_tasks[i] == current) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 处理函数是否应当退出
+bool async_worker_should_stop(void)
+{
+    return stopping;
+}
+
+// 获取工作池统计信息
+void async_worker_get_stats(async_worker_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+
+    portENTER_CRITICAL(&stats_lock);
+    stats->busy_workers = busy_workers;
+    stats->total_workers = running ? ASYNC_WORKER_COUNT : 0;
+    stats->completed = completed_count;
+    stats->rejected = rejected_count;
+    portEXIT_CRITICAL(&stats_lock);
+}
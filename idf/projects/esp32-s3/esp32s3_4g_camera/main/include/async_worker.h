@@ -0,0 +1,76 @@
+#ifndef ASYNC_WORKER_H
+#define ASYNC_WORKER_H
+
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// 工作池配置
+#define ASYNC_WORKER_COUNT            3       // 长连接工作任务数量 (同时在线的视频流上限)
+#define ASYNC_WORKER_STACK_SIZE       4096    // 工作任务栈大小
+#define ASYNC_WORKER_PRIORITY         4       // 低于HTTP服务器任务，保证短请求优先
+#define ASYNC_WORKER_CORE_ID          1       // 与HTTP服务器同核
+#define ASYNC_WORKER_SEND_TIMEOUT_MS  3000    // 单连接发送超时，客户端卡住时尽快释放工作任务
+
+// 长连接请求处理函数 (在工作任务中执行)
+typedef esp_err_t (*async_worker_handler_t)(httpd_req_t *req);
+
+// 工作池统计
+typedef struct {
+    uint8_t  busy_workers;     // 正在处理长连接的工作任务数
+    uint8_t  total_workers;    // 工作任务总数
+    uint32_t completed;        // 已完成的长连接请求数
+    uint32_t rejected;         // 因工作池已满被拒绝的请求数
+} async_worker_stats_t;
+
+/**
+ * @brief 启动长连接工作池
+ *
+ * @return ESP_OK 成功, 其他值表示失败
+ */
+esp_err_t async_worker_start(void);
+
+/**
+ * @brief 停止长连接工作池
+ *
+ * 通知正在运行的处理函数尽快退出，并等待所有工作任务结束
+ *
+ * @return ESP_OK 成功, ESP_ERR_TIMEOUT 等待超时
+ */
+esp_err_t async_worker_stop(void);
+
+/**
+ * @brief 将请求转交给工作池处理
+ *
+ * 在HTTP服务器任务中调用，内部使用 httpd_req_async_handler_begin 复制请求，
+ * 服务器任务随即返回继续处理其他请求。工作池已满时直接返回 503。
+ *
+ * @param req 原始请求
+ * @param handler 在工作任务中执行的处理函数
+ * @return ESP_OK 已转交或已回复 503, 其他值表示失败
+ */
+esp_err_t async_worker_submit(httpd_req_t *req, async_worker_handler_t handler);
+
+/**
+ * @brief 判断当前是否运行在工作任务中
+ *
+ * @return true 在工作任务中, false 在其他任务中
+ */
+bool async_worker_is_worker_task(void);
+
+/**
+ * @brief 长连接处理函数是否应当退出 (工作池正在停止)
+ *
+ * @return true 应当退出, false 继续
+ */
+bool async_worker_should_stop(void);
+
+/**
+ * @brief 获取工作池统计信息
+ *
+ * @param stats 输出统计信息
+ */
+void async_worker_get_stats(async_worker_stats_t *stats);
+
+#endif // ASYNC_WORKER_H
@@ -1,5 +1,6 @@
 #include "include/web_server.h"
 #include "include/api_handlers.h"
+#include "include/async_worker.h"
 #include "esp_log.h"
 #include "esp_http_server.h"
 #include <string.h>
@@ -137,10 +138,20 @@ esp_err_t web_server_start(void)
     config.core_id = 1;  // 使用核心1
     config.task_priority = 5;
     config.lru_purge_enable = true;
+    // 每个工作任务占用一个长连接，另外保留给页面和状态查询的连接
+    config.max_open_sockets = ASYNC_WORKER_COUNT + 4;
 
-    esp_err_t ret = httpd_start(&server, &config);
+    // 长连接工作池需先于服务器启动
+    esp_err_t ret = async_worker_start();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start async workers: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ret = httpd_start(&server, &config);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to start HTTP server: %s", esp_err_to_name(ret));
+        async_worker_stop();
         return ret;
     }
 
@@ -158,6 +169,7 @@ esp_err_t web_server_start(void)
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to register API handlers");
         httpd_stop(server);
+        async_worker_stop();
         return ret;
     }
 
@@ -176,7 +188,14 @@ esp_err_t web_server_stop(void)
 
     ESP_LOGI(TAG, "Stopping web server...");
 
-    esp_err_t ret = httpd_stop(server);
+    // 先结束所有长连接，再停止服务器
+    esp_err_t ret = async_worker_stop();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to stop async workers: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    ret = httpd_stop(server);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to stop HTTP server: %s", esp_err_to_name(ret));
         return ret;
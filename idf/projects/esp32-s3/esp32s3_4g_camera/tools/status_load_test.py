@@ -0,0 +1,211 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+状态接口负载测试 (Linux)
+
+依次打开 0、1、2 ... N 路 MJPEG 视频流 (/api/camera/stream)，每一档在视频流持续接收的同时
+反复请求 /api/status，输出状态接口的响应延迟 (p50 / p95 / p99 / 最大) 和失败次数，
+以及各路视频流的帧率和吞吐量。视频流超过工作池上限 (ASYNC_WORKER_COUNT) 时设备返回 503，
+单独计数。
+
+用法:
+    python3 tools/status_load_test.py                         # 设备热点默认地址 192.168.4.1
+    python3 tools/status_load_test.py --host 192.168.1.50 --max-streams 4 --duration 20
+    python3 tools/status_load_test.py --csv result.csv        # 同时保存每档的统计
+"""
+
+import argparse
+import csv
+import http.client
+import json
+import sys
+import threading
+import time
+
+STATUS_PATH = '/api/status'
+STREAM_PATH = '/api/camera/stream'
+
+
+def percentile(values, p):
+    """p 分位数 (最近秩)"""
+    if not values:
+        return 0.0
+    ordered = sorted(values)
+    rank = max(0, min(len(ordered) - 1, int(round(p / 100.0 * len(ordered) + 0.5)) - 1))
+    return ordered[rank]
+
+
+class StreamClient(threading.Thread):
+    """一路视频流：持续读取数据，统计 JPEG 帧数和字节数"""
+
+    def __init__(self, host, port, timeout):
+        super().__init__(daemon=True)
+        self.host = host
+        self.port = port
+        self.timeout = timeout
+        self.stop_event = threading.Event()
+        self.status = None          # HTTP 状态码
+        self.error = None
+        self.frames = 0
+        self.bytes = 0
+        self.started = threading.Event()
+
+    def run(self):
+        conn = http.client.HTTPConnection(self.host, self.port, timeout=self.timeout)
+        try:
+            conn.request('GET', STREAM_PATH)
+            resp = conn.getresponse()
+            self.status = resp.status
+            self.started.set()
+            if resp.status != 200:
+                resp.read()
+                return
+            tail = b''
+            while not self.stop_event.is_set():
+                chunk = resp.read1(16384) if hasattr(resp, 'read1') else resp.read(4096)
+                if not chunk:
+                    self.error = 'closed by device'
+                    break
+                self.bytes += len(chunk)
+                # 每帧以 JPEG 起始标记 FFD8 开头 (跨块时保留上一块末尾一个字节)
+                data = tail + chunk
+                self.frames += data.count(b'\xff\xd8')
+                tail = chunk[-1:]
+        except (OSError, http.client.HTTPException) as e:
+            self.error = str(e)
+        finally:
+            self.started.set()
+            conn.close()
+
+    def stop(self):
+        self.stop_event.set()
+
+
+def fetch_status(host, port, timeout):
+    """请求一次状态接口，返回 (延迟秒, 解析后的 JSON)"""
+    conn = http.client.HTTPConnection(host, port, timeout=timeout)
+    try:
+        start = time.monotonic()
+        conn.request('GET', STATUS_PATH)
+        resp = conn.getresponse()
+        body = resp.read()
+        latency = time.monotonic() - start
+        if resp.status != 200:
+            raise http.client.HTTPException('HTTP %d' % resp.status)
+        return latency, json.loads(body)
+    finally:
+        conn.close()
+
+
+def wait_workers_idle(args):
+    """等待设备释放上一档的视频流工作任务 (设备在下一次发送失败时才发现客户端已断开)"""
+    end = time.monotonic() + args.timeout * 2
+    while time.monotonic() < end:
+        try:
+            _, status = fetch_status(args.host, args.port, args.timeout)
+            if status.get('stream_workers_busy', 0) == 0:
+                return True
+        except (OSError, ValueError, http.client.HTTPException):
+            pass
+        time.sleep(0.2)
+    return False
+
+
+def run_level(args, streams):
+    """打开 streams 路视频流，测量 duration 秒内状态接口的延迟"""
+    clients = [StreamClient(args.host, args.port, args.timeout) for _ in range(streams)]
+    for c in clients:
+        c.start()
+        c.started.wait(args.timeout)
+    time.sleep(args.warmup)
+
+    latencies = []
+    failures = 0
+    workers_busy = None
+    frames_before = [c.frames for c in clients]
+    bytes_before = [c.bytes for c in clients]
+    t0 = time.monotonic()
+    end = t0 + args.duration
+    while time.monotonic() < end:
+        try:
+            latency, status = fetch_status(args.host, args.port, args.timeout)
+            latencies.append(latency)
+            workers_busy = status.get('stream_workers_busy', workers_busy)
+        except (OSError, ValueError, http.client.HTTPException):
+            failures += 1
+        time.sleep(args.interval)
+    elapsed = time.monotonic() - t0
+
+    active = [c for c in clients if c.status == 200 and c.error is None]
+    fps = sum(c.frames - f for c, f in zip(clients, frames_before)) / elapsed
+    kbps = sum(c.bytes - b for c, b in zip(clients, bytes_before)) * 8 / 1000.0 / elapsed
+    rejected = sum(1 for c in clients if c.status == 503)
+    errors = sum(1 for c in clients if c.error is not None and c.status != 503)
+
+    for c in clients:
+        c.stop()
+    for c in clients:
+        c.join(args.timeout)
+
+    ms = [v * 1000.0 for v in latencies]
+    return {
+        'streams': streams,
+        'active': len(active),
+        'rejected': rejected,
+        'stream_errors': errors,
+        'workers_busy': workers_busy if workers_busy is not None else -1,
+        'requests': len(latencies),
+        'failures': failures,
+        'p50_ms': percentile(ms, 50),
+        'p95_ms': percentile(ms, 95),
+        'p99_ms': percentile(ms, 99),
+        'max_ms': max(ms) if ms else 0.0,
+        'stream_fps': fps,
+        'stream_kbps': kbps,
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description='/api/status latency under concurrent MJPEG streams')
+    parser.add_argument('--host', default='192.168.4.1')
+    parser.add_argument('--port', type=int, default=80)
+    parser.add_argument('--max-streams', type=int, default=4, help='最多同时打开的视频流 (默认 4)')
+    parser.add_argument('--duration', type=float, default=10.0, help='每档测量时间 (秒)')
+    parser.add_argument('--interval', type=float, default=0.1, help='两次状态请求的间隔 (秒)')
+    parser.add_argument('--warmup', type=float, default=1.0, help='打开视频流后等待的时间 (秒)')
+    parser.add_argument('--timeout', type=float, default=5.0, help='单次请求超时 (秒)')
+    parser.add_argument('--csv', help='把每档结果写入 CSV 文件')
+    args = parser.parse_args()
+
+    try:
+        fetch_status(args.host, args.port, args.timeout)
+    except (OSError, ValueError, http.client.HTTPException) as e:
+        print('无法访问 http://%s:%d%s: %s' % (args.host, args.port, STATUS_PATH, e), file=sys.stderr)
+        return 1
+
+    print('%-8s %6s %8s %8s %6s %9s %9s %9s %9s %8s %9s' % (
+        'streams', 'active', 'rejected', 'requests', 'fail',
+        'p50_ms', 'p95_ms', 'p99_ms', 'max_ms', 'fps', 'kbit/s'))
+    results = []
+    for n in range(args.max_streams + 1):
+        if not wait_workers_idle(args):
+            print('  上一档的视频流工作任务仍未释放', file=sys.stderr)
+        r = run_level(args, n)
+        results.append(r)
+        print('%-8d %6d %8d %8d %6d %9.1f %9.1f %9.1f %9.1f %8.1f %9.0f' % (
+            r['streams'], r['active'], r['rejected'], r['requests'], r['failures'],
+            r['p50_ms'], r['p95_ms'], r['p99_ms'], r['max_ms'], r['stream_fps'], r['stream_kbps']))
+        sys.stdout.flush()
+        if r['stream_errors']:
+            print('  %d 路视频流异常断开' % r['stream_errors'])
+
+    if args.csv:
+        with open(args.csv, 'w', newline='') as f:
+            writer = csv.DictWriter(f, fieldnames=list(results[0].keys()))
+            writer.writeheader()
+            writer.writerows(results)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -3,6 +3,7 @@
 #include "wifi_manager.h"
 #include "esp_log.h"
 #include "cJSON.h"
+#include "json_writer_httpd.h"
 #include <string.h>
 #include "esp_system.h"
 #include "esp_chip_info.h"
@@ -50,24 +51,34 @@ static esp_err_t send_error_response(httpd_req_t *req, int code, const char *mes
     return ret;
 }
 
+// 辅助函数：开始流式JSON响应 (状态类接口使用，不分配内存)
+static void begin_json_stream(httpd_req_t *req, json_writer_t *w, char *buf, size_t size)
+{
+    set_cors_headers(req);
+    json_writer_httpd_begin(w, req, buf, size);
+}
+
 esp_err_t api_status_handler(httpd_req_t *req)
 {
     ESP_LOGI(TAG, "API: /api/status");
 
-    cJSON *json = cJSON_CreateObject();
-    cJSON *system_info = cJSON_CreateObject();
-    cJSON *ml307r_info = cJSON_CreateObject();
-    cJSON *wifi_info = cJSON_CreateObject();
+    char buf[512];
+    json_writer_t w;
+    begin_json_stream(req, &w, buf, sizeof(buf));
+    json_writer_begin_object(&w, NULL);
+    json_writer_bool(&w, "success", true);
 
     // 系统信息
     esp_chip_info_t chip_info;
     esp_chip_info(&chip_info);
     
-    cJSON_AddStringToObject(system_info, "chip_model", "ESP32-S3");
-    cJSON_AddNumberToObject(system_info, "chip_cores", chip_info.cores);
-    cJSON_AddNumberToObject(system_info, "chip_revision", chip_info.revision);
-    cJSON_AddNumberToObject(system_info, "free_heap", esp_get_free_heap_size());
-    cJSON_AddNumberToObject(system_info, "uptime", esp_timer_get_time() / 1000000);
+    json_writer_begin_object(&w, "system");
+    json_writer_string(&w, "chip_model", "ESP32-S3");
+    json_writer_uint(&w, "chip_cores", chip_info.cores);
+    json_writer_uint(&w, "chip_revision", chip_info.revision);
+    json_writer_uint(&w, "free_heap", esp_get_free_heap_size());
+    json_writer_int(&w, "uptime", esp_timer_get_time() / 1000000);
+    json_writer_end_object(&w);
 
     // ML307R状态
     ml307r_state_t ml307r_state = ml307r_get_state();
@@ -81,9 +92,11 @@ esp_err_t api_status_handler(httpd_req_t *req)
         case ML307R_STATE_ERROR: state_str = "error"; break;
     }
     
-    cJSON_AddStringToObject(ml307r_info, "state", state_str);
-    cJSON_AddBoolToObject(ml307r_info, "ready", ml307r_is_ready());
-    cJSON_AddNumberToObject(ml307r_info, "signal_strength", ml307r_get_signal_strength());
+    json_writer_begin_object(&w, "ml307r");
+    json_writer_string(&w, "state", state_str);
+    json_writer_bool(&w, "ready", ml307r_is_ready());
+    json_writer_int(&w, "signal_strength", ml307r_get_signal_strength());
+    json_writer_end_object(&w);
 
     // WiFi状态
     wifi_state_t wifi_state = wifi_manager_get_state();
@@ -96,26 +109,20 @@ esp_err_t api_status_handler(httpd_req_t *req)
         case WIFI_STATE_ERROR: wifi_state_str = "error"; break;
     }
     
-    cJSON_AddStringToObject(wifi_info, "state", wifi_state_str);
-    cJSON_AddBoolToObject(wifi_info, "connected", wifi_manager_is_connected());
+    json_writer_begin_object(&w, "wifi");
+    json_writer_string(&w, "state", wifi_state_str);
+    json_writer_bool(&w, "connected", wifi_manager_is_connected());
 
     wifi_info_t wifi_details;
     if (wifi_manager_get_info(&wifi_details) == ESP_OK) {
-        cJSON_AddStringToObject(wifi_info, "ssid", wifi_details.ssid);
-        cJSON_AddStringToObject(wifi_info, "ip_address", wifi_details.ip_address);
-        cJSON_AddNumberToObject(wifi_info, "rssi", wifi_details.rssi);
+        json_writer_string(&w, "ssid", wifi_details.ssid);
+        json_writer_string(&w, "ip_address", wifi_details.ip_address);
+        json_writer_int(&w, "rssi", wifi_details.rssi);
     }
+    json_writer_end_object(&w);
 
-    // 组装响应
-    cJSON_AddBoolToObject(json, "success", true);
-    cJSON_AddItemToObject(json, "system", system_info);
-    cJSON_AddItemToObject(json, "ml307r", ml307r_info);
-    cJSON_AddItemToObject(json, "wifi", wifi_info);
-
-    esp_err_t ret = send_json_response(req, json);
-    cJSON_Delete(json);
-
-    return ret;
+    json_writer_end_object(&w);
+    return json_writer_httpd_end(&w);
 }
 
 esp_err_t api_network_info_handler(httpd_req_t *req)
@@ -125,24 +132,25 @@ esp_err_t api_network_info_handler(httpd_req_t *req)
     ml307r_network_info_t network_info;
     esp_err_t ret = ml307r_get_network_info(&network_info);
     
-    cJSON *json = cJSON_CreateObject();
+    char buf[256];
+    json_writer_t w;
+    begin_json_stream(req, &w, buf, sizeof(buf));
+    json_writer_begin_object(&w, NULL);
     
     if (ret == ESP_OK) {
-        cJSON_AddBoolToObject(json, "success", true);
-        cJSON_AddStringToObject(json, "operator", network_info.operator_name);
-        cJSON_AddNumberToObject(json, "signal_strength", network_info.signal_strength);
-        cJSON_AddStringToObject(json, "network_type", network_info.network_type);
-        cJSON_AddStringToObject(json, "ip_address", network_info.ip_address);
-        cJSON_AddBoolToObject(json, "connected", network_info.is_connected);
+        json_writer_bool(&w, "success", true);
+        json_writer_string(&w, "operator", network_info.operator_name);
+        json_writer_int(&w, "signal_strength", network_info.signal_strength);
+        json_writer_string(&w, "network_type", network_info.network_type);
+        json_writer_string(&w, "ip_address", network_info.ip_address);
+        json_writer_bool(&w, "connected", network_info.is_connected);
     } else {
-        cJSON_AddBoolToObject(json, "success", false);
-        cJSON_AddStringToObject(json, "error", "Failed to get network info");
+        json_writer_bool(&w, "success", false);
+        json_writer_string(&w, "error", "Failed to get network info");
     }
 
-    ret = send_json_response(req, json);
-    cJSON_Delete(json);
-
-    return ret;
+    json_writer_end_object(&w);
+    return json_writer_httpd_end(&w);
 }
 
 esp_err_t api_hotspot_control_handler(httpd_req_t *req)
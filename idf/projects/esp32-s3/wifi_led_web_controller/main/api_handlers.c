@@ -7,6 +7,7 @@
 #include "esp_http_server.h"
 #include "esp_system.h"
 #include "cJSON.h"
+#include "json_writer_httpd.h"
 #include "wifi_manager.h"
 #include "led_controller.h"
 #include "web_files.h"
@@ -41,43 +42,36 @@ esp_err_t api_root_handler(httpd_req_t *req)
 /* 状态API处理器 */
 esp_err_t api_status_handler(httpd_req_t *req)
 {
+    char buf[256];
+    json_writer_t w;
+
     set_cors_headers(req);
-    
-    cJSON *root = cJSON_CreateObject();
-    if (root == NULL) {
-        httpd_resp_send_500(req);
-        return ESP_FAIL;
-    }
+    json_writer_httpd_begin(&w, req, buf, sizeof(buf));
+    json_writer_begin_object(&w, NULL);
     
     // WiFi状态
-    cJSON *wifi = cJSON_CreateObject();
-    cJSON_AddItemToObject(root, "wifi", wifi);
-    cJSON_AddItemToObject(wifi, "connected", cJSON_CreateBool(wifi_is_connected()));
-    cJSON_AddItemToObject(wifi, "ap_mode", cJSON_CreateBool(wifi_is_ap_mode()));
-    cJSON_AddItemToObject(wifi, "ip", cJSON_CreateString(wifi_get_ip_string()));
+    json_writer_begin_object(&w, "wifi");
+    json_writer_bool(&w, "connected", wifi_is_connected());
+    json_writer_bool(&w, "ap_mode", wifi_is_ap_mode());
+    json_writer_string(&w, "ip", wifi_get_ip_string());
+    json_writer_end_object(&w);
     
     // LED状态
-    cJSON *led = cJSON_CreateObject();
-    cJSON_AddItemToObject(root, "led", led);
     rgb_color_t color = led_get_current_color();
-    cJSON_AddItemToObject(led, "power", cJSON_CreateBool(led_get_power_state()));
-    cJSON_AddItemToObject(led, "r", cJSON_CreateNumber(color.r));
-    cJSON_AddItemToObject(led, "g", cJSON_CreateNumber(color.g));
-    cJSON_AddItemToObject(led, "b", cJSON_CreateNumber(color.b));
-    cJSON_AddItemToObject(led, "brightness", cJSON_CreateNumber(color.brightness));
+    json_writer_begin_object(&w, "led");
+    json_writer_bool(&w, "power", led_get_power_state());
+    json_writer_uint(&w, "r", color.r);
+    json_writer_uint(&w, "g", color.g);
+    json_writer_uint(&w, "b", color.b);
+    json_writer_uint(&w, "brightness", color.brightness);
+    json_writer_end_object(&w);
     
     // 系统状态
-    cJSON_AddItemToObject(root, "uptime", cJSON_CreateNumber(esp_timer_get_time() / 1000000));
-    cJSON_AddItemToObject(root, "free_heap", cJSON_CreateNumber(esp_get_free_heap_size()));
-    
-    char *json_string = cJSON_Print(root);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json_string, strlen(json_string));
+    json_writer_int(&w, "uptime", esp_timer_get_time() / 1000000);
+    json_writer_uint(&w, "free_heap", esp_get_free_heap_size());
     
-    free(json_string);
-    cJSON_Delete(root);
-    
-    return ESP_OK;
+    json_writer_end_object(&w);
+    return json_writer_httpd_end(&w);
 }
 
 /* LED颜色API处理器 */